@@ -150,6 +150,18 @@
  */
 #define CH_CFG_USE_REGISTRY                 TRUE
 
+/**
+ * @brief   Threads registry names index size.
+ * @details If greater than zero then the registry also keeps the threads
+ *          in a hash table indexed by name and @p chRegFindThreadByName()
+ *          does not need to scan the whole registry. The value is the
+ *          number of hash buckets and must be a power of two.
+ *
+ * @note    The default is @p 0.
+ * @note    Requires @p CH_CFG_USE_REGISTRY.
+ */
+#define CH_CFG_REGISTRY_HASH_SIZE           0
+
 /**
  * @brief   Threads synchronization APIs.
  * @details If enabled then the @p chThdWait() function is included in
@@ -159,6 +171,26 @@
  */
 #define CH_CFG_USE_WAITEXIT                 TRUE
 
+/**
+ * @brief   EDF scheduling class.
+ * @details If enabled then the threads running at the priority level
+ *          @p CH_CFG_EDF_PRIO can be scheduled by earliest deadline.
+ *
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_EDF                      FALSE
+
+/**
+ * @brief   Priority level reserved to the EDF scheduling class.
+ * @details The EDF threads run at this priority level, threads with
+ *          higher priority preempt them and threads with lower priority
+ *          run in the remaining time.
+ *
+ * @note    The default is @p NORMALPRIO + 1.
+ * @note    Requires @p CH_CFG_USE_EDF.
+ */
+#define CH_CFG_EDF_PRIO                     (NORMALPRIO + 1)
+
 /**
  * @brief   Semaphores APIs.
  * @details If enabled then the Semaphores APIs are included in the kernel.
@@ -216,6 +248,26 @@
  */
 #define CH_CFG_USE_CONDVARS_TIMEOUT         TRUE
 
+/**
+ * @brief   Reader-writer locks APIs.
+ * @details If enabled then the reader-writer locks APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MUTEXES.
+ */
+#define CH_CFG_USE_RWLOCKS                  FALSE
+
+/**
+ * @brief   Reader-writer locks nesting.
+ * @details Maximum number of reader-writer locks that a thread can hold
+ *          at the same time.
+ *
+ * @note    The default is 2.
+ * @note    Requires @p CH_CFG_USE_RWLOCKS.
+ */
+#define CH_CFG_RWLOCKS_NESTING              2
+
 /**
  * @brief   Events Flags APIs.
  * @details If enabled then the event flags APIs are included in the kernel.
@@ -264,6 +316,25 @@
  */
 #define CH_CFG_USE_MAILBOXES                TRUE
 
+/**
+ * @brief   Sequence locks APIs.
+ * @details If enabled then the sequence locks APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_SEQLOCKS                 FALSE
+
+/**
+ * @brief   Sequence locks objects size limit.
+ * @details Maximum size in bytes of the objects copied under a sequence
+ *          lock by @p chSeqReadObjectX() and @p chSeqWriteObjectI().
+ *
+ * @note    The default is 32.
+ * @note    Requires @p CH_CFG_USE_SEQLOCKS.
+ */
+#define CH_CFG_SEQLOCKS_MAX_SIZE            32
+
 /**
  * @brief   I/O Queues APIs.
  * @details If enabled then the I/O queues APIs are included in the kernel.
@@ -313,6 +384,52 @@
  */
 #define CH_CFG_USE_DYNAMIC                  TRUE
 
+/**
+ * @brief   Work queues APIs.
+ * @details If enabled then the work queues APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_WORKQUEUES               FALSE
+
+/**
+ * @brief   Number of workers of the system work queue.
+ * @details The workers are started by @p chSysInit(), zero means that
+ *          there is no system work queue.
+ *
+ * @note    The default is @p 1.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#define CH_CFG_WORKQ_WORKERS                1
+
+/**
+ * @brief   Stack size of the system work queue workers.
+ *
+ * @note    The default is @p 256.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#define CH_CFG_WORKQ_WA_SIZE                256
+
+/**
+ * @brief   Priority of the system work queue workers.
+ *
+ * @note    The default is @p HIGHPRIO-1.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#define CH_CFG_WORKQ_PRIO                   (HIGHPRIO - 1)
+
+/**
+ * @brief   Cooperative tasks APIs.
+ * @details If enabled then the stackless cooperative tasks APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_EVENTS.
+ * @note    Requires @p CH_CFG_USE_EVENTS_TIMEOUT.
+ */
+#define CH_CFG_USE_CTASKS                   FALSE
+
 /** @} */
 
 /*===========================================================================*/
@@ -406,6 +523,17 @@
  */
 #define CH_DBG_THREADS_PROFILING            FALSE
 
+/**
+ * @brief   Debug option, incremental integrity checks.
+ * @details If enabled then the @p chSysIntegrityStep() function is included
+ *          in the kernel, the kernel data structures can be checked a few
+ *          nodes at time from the idle hook or from a low priority thread.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_REGISTRY.
+ */
+#define CH_DBG_ENABLE_INTEGRITY_STEPS       FALSE
+
 /** @} */
 
 /*===========================================================================*/
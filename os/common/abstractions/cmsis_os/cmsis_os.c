@@ -66,12 +66,6 @@ static void timer_cb(void const *arg) {
 
   osTimerId timer_id = (osTimerId)arg;
   timer_id->ptimer(timer_id->argument);
-  if (timer_id->type == osTimerPeriodic) {
-    chSysLockFromISR();
-    chVTDoSetI(&timer_id->vt, MS2ST(timer_id->millisec),
-               (vtfunc_t)timer_cb, timer_id);
-    chSysUnlockFromISR();
-  }
 }
 
 /*===========================================================================*/
@@ -225,8 +219,13 @@ osStatus osTimerStart(osTimerId timer_id, uint32_t millisec) {
   if ((millisec == 0) || (millisec == osWaitForever))
     return osErrorValue;
 
-  timer_id->millisec = millisec;
-  chVTSet(&timer_id->vt, MS2ST(millisec), (vtfunc_t)timer_cb, timer_id);
+  if (timer_id->type == osTimerPeriodic) {
+    chVTSetContinuous(&timer_id->vt, MS2ST(millisec),
+                      (vtfunc_t)timer_cb, timer_id);
+  }
+  else {
+    chVTSet(&timer_id->vt, MS2ST(millisec), (vtfunc_t)timer_cb, timer_id);
+  }
 
   return osOK;
 }
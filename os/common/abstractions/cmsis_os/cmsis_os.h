@@ -197,7 +197,6 @@ typedef struct os_timer_cb {
   os_timer_type             type;
   os_ptimer                 ptimer;
   void                      *argument;
-  uint32_t                  millisec;
 } *osTimerId;
 
 /**
@@ -66,6 +66,19 @@
 #error "NASA OSAL requires CH_CFG_USE_HEAP"
 #endif
 
+/**
+ * @brief   Number of buckets of the objects names indexes.
+ * @note    It must be a power of two.
+ */
+#if !defined(OSAL_NAME_HASH_SIZE) || defined(__DOXYGEN__)
+#define OSAL_NAME_HASH_SIZE 16
+#endif
+
+#if (OSAL_NAME_HASH_SIZE < 1) ||                                            \
+    ((OSAL_NAME_HASH_SIZE & (OSAL_NAME_HASH_SIZE - 1)) != 0)
+#error "OSAL_NAME_HASH_SIZE must be a power of two"
+#endif
+
 /*===========================================================================*/
 /* Module local definitions.                                                 */
 /*===========================================================================*/
@@ -92,12 +105,35 @@
  */
 typedef void (*funcptr_t)(void);
 
+/**
+ * @brief   Type of an object name.
+ */
+typedef struct osal_name osal_name_t;
+
+/**
+ * @brief   Structure representing an object name.
+ */
+struct osal_name {
+  osal_name_t           *next;      /**< @brief Next name in the bucket.    */
+  uint32                hash;       /**< @brief Name hash.                  */
+  char                  name[OS_MAX_API_NAME];
+};
+
+/**
+ * @brief   Type of an objects names index.
+ * @details The names of the objects in use are linked in a hash table, the
+ *          names are stored in an array parallel to the objects array.
+ */
+typedef struct {
+  osal_name_t           *buckets[OSAL_NAME_HASH_SIZE];
+  osal_name_t           *names;     /**< @brief Array of the names.         */
+} osal_index_t;
+
 /**
  * @brief   Type of OSAL timer.
  */
 typedef struct {
   uint32                is_free;
-  char                  name[OS_MAX_API_NAME];
   OS_TimerCallback_t    callback_ptr;
   uint32                start_time;
   uint32                interval_time;
@@ -109,7 +145,6 @@ typedef struct {
  */
 typedef struct {
   uint32                is_free;
-  char                  name[OS_MAX_API_NAME];
   semaphore_t           free_msgs;
   memory_pool_t         messages;
   mailbox_t             mb;
@@ -145,6 +180,16 @@ typedef struct {
   binary_semaphore_t    binary_semaphores[OS_MAX_BIN_SEMAPHORES];
   semaphore_t           count_semaphores[OS_MAX_COUNT_SEMAPHORES];
   mutex_t               mutexes[OS_MAX_MUTEXES];
+  osal_index_t          timers_index;
+  osal_index_t          queues_index;
+  osal_index_t          binary_semaphores_index;
+  osal_index_t          count_semaphores_index;
+  osal_index_t          mutexes_index;
+  osal_name_t           timers_names[OS_MAX_TIMERS];
+  osal_name_t           queues_names[OS_MAX_QUEUES];
+  osal_name_t           binary_semaphores_names[OS_MAX_BIN_SEMAPHORES];
+  osal_name_t           count_semaphores_names[OS_MAX_COUNT_SEMAPHORES];
+  osal_name_t           mutexes_names[OS_MAX_MUTEXES];
 } osal_t;
 
 /*===========================================================================*/
@@ -179,65 +224,121 @@ static void systime_update(void *p) {
 static void timer_handler(void *p) {
   osal_timer_t *otp = (osal_timer_t *)p;
 
-  /* Real callback.*/
+  /* Real callback, the timer is already re-armed if an interval is
+     defined.*/
   otp->callback_ptr((uint32)p);
+}
 
-  /* Timer restart if an interval is defined.*/
-  if (otp->interval_time != 0) {
-    chSysLockFromISR();
-    chVTSetI(&otp->vt, US2ST(otp->interval_time), timer_handler, p);
-    chSysUnlockFromISR();
+/**
+ * @brief   Computes the hash of an object name.
+ * @note    The FNV-1a hash function is used, only the significant part of
+ *          the name is considered.
+ */
+static uint32 name_hash(const char *name) {
+  uint32 hash = 2166136261U;
+  unsigned i;
+
+  for (i = 0; (i < OS_MAX_API_NAME - 1) && (name[i] != '\0'); i++) {
+    hash = (hash ^ (uint32)(uint8)name[i]) * 16777619U;
   }
+
+  return hash;
 }
 
 /**
- * @brief   Finds a queue by name.
+ * @brief   Initializes an objects names index.
  */
-uint32 queue_find(const char *queue_name) {
-  osal_queue_t *oqp;
+static void index_init(osal_index_t *oip, osal_name_t *names) {
+  unsigned i;
 
-  /* Searching the queue in the table.*/
-  for (oqp = &osal.queues[0]; oqp < &osal.queues[OS_MAX_QUEUES]; oqp++) {
-    /* Entering a reentrant critical zone.*/
-    syssts_t sts = chSysGetStatusAndLockX();
+  for (i = 0; i < OSAL_NAME_HASH_SIZE; i++) {
+    oip->buckets[i] = NULL;
+  }
+  oip->names = names;
+}
+
+/**
+ * @brief   Adds an object name to an index.
+ * @note    Must be invoked from within a critical zone.
+ */
+static void index_insert(osal_index_t *oip, size_t n, const char *name) {
+  osal_name_t *onp = &oip->names[n];
+  osal_name_t **bpp;
+
+  strncpy(onp->name, name, OS_MAX_API_NAME - 1);
+  onp->name[OS_MAX_API_NAME - 1] = '\0';
+  onp->hash = name_hash(name);
+  bpp = &oip->buckets[onp->hash & (OSAL_NAME_HASH_SIZE - 1)];
+  onp->next = *bpp;
+  *bpp = onp;
+}
 
-    if (!oqp->is_free &&
-        (strncmp(oqp->name, queue_name, OS_MAX_API_NAME - 1) == 0)) {
-      /* Leaving the critical zone.*/
-      chSysRestoreStatusX(sts);
-      return (uint32)oqp;
+/**
+ * @brief   Removes an object name from an index.
+ * @note    Must be invoked from within a critical zone.
+ */
+static void index_remove(osal_index_t *oip, size_t n) {
+  osal_name_t *onp = &oip->names[n];
+  osal_name_t **bpp;
+
+  bpp = &oip->buckets[onp->hash & (OSAL_NAME_HASH_SIZE - 1)];
+  while (*bpp != NULL) {
+    if (*bpp == onp) {
+      *bpp = onp->next;
+      return;
     }
+    bpp = &(*bpp)->next;
+  }
+}
 
-    /* Leaving the critical zone.*/
-    chSysRestoreStatusX(sts);
+/**
+ * @brief   Finds an object by name in an index.
+ * @note    This function can be safely called from timer callbacks or ISRs.
+ *
+ * @return                      The object index or -1 if not found.
+ */
+static int32 index_find(osal_index_t *oip, const char *name) {
+  uint32 hash = name_hash(name);
+  osal_name_t *onp;
+  int32 n = -1;
+
+  /* Entering a reentrant critical zone.*/
+  syssts_t sts = chSysGetStatusAndLockX();
+
+  /* Scanning the bucket, the hash is compared first in order to skip most
+     of the string comparisons.*/
+  onp = oip->buckets[hash & (OSAL_NAME_HASH_SIZE - 1)];
+  while (onp != NULL) {
+    if ((onp->hash == hash) &&
+        (strncmp(onp->name, name, OS_MAX_API_NAME - 1) == 0)) {
+      n = (int32)(onp - oip->names);
+      break;
+    }
+    onp = onp->next;
   }
 
-  return 0;
+  /* Leaving the critical zone.*/
+  chSysRestoreStatusX(sts);
+
+  return n;
 }
 
 /**
- * @brief   Finds a timer by name.
+ * @brief   Finds a queue by name.
  */
-uint32 timer_find(const char *timer_name) {
-  osal_timer_t *otp;
-
-  /* Searching the queue in the table.*/
-  for (otp = &osal.timers[0]; otp < &osal.timers[OS_MAX_TIMERS]; otp++) {
-    /* Entering a reentrant critical zone.*/
-    syssts_t sts = chSysGetStatusAndLockX();
+uint32 queue_find(const char *queue_name) {
+  int32 n = index_find(&osal.queues_index, queue_name);
 
-    if (!otp->is_free &&
-        (strncmp(otp->name, timer_name, OS_MAX_API_NAME - 1) == 0)) {
-      /* Leaving the critical zone.*/
-      chSysRestoreStatusX(sts);
-      return (uint32)otp;
-    }
+  return n < 0 ? 0 : (uint32)&osal.queues[n];
+}
 
-    /* Leaving the critical zone.*/
-    chSysRestoreStatusX(sts);
-  }
+/**
+ * @brief   Finds a timer by name.
+ */
+uint32 timer_find(const char *timer_name) {
+  int32 n = index_find(&osal.timers_index, timer_name);
 
-  return 0;
+  return n < 0 ? 0 : (uint32)&osal.timers[n];
 }
 
 /*===========================================================================*/
@@ -270,6 +371,13 @@ int32 OS_API_Init(void) {
   chVTObjectInit(&osal.vt);
   chVTSet(&osal.vt, MS2ST(1), systime_update, (void *)MS2ST(1));
 
+  /* Names indexes initialization.*/
+  index_init(&osal.timers_index, &osal.timers_names[0]);
+  index_init(&osal.queues_index, &osal.queues_names[0]);
+  index_init(&osal.binary_semaphores_index, &osal.binary_semaphores_names[0]);
+  index_init(&osal.count_semaphores_index, &osal.count_semaphores_names[0]);
+  index_init(&osal.mutexes_index, &osal.mutexes_names[0]);
+
   /* Timers pool initialization.*/
   chPoolObjectInit(&osal.timers_pool,
                    sizeof (osal_timer_t),
@@ -480,12 +588,17 @@ int32 OS_TimerCreate(uint32 *timer_id, const char *timer_name,
     return OS_ERR_NO_FREE_IDS;
   }
 
-  strncpy(otp->name, timer_name, OS_MAX_API_NAME - 1);
   chVTObjectInit(&otp->vt);
   otp->start_time    = 0;
   otp->interval_time = 0;
   otp->callback_ptr  = callback_ptr;
-  otp->is_free       = 0;   /* Note, last.*/
+
+  /* Note, last, the timer becomes visible by name.*/
+  chSysLock();
+  otp->is_free       = 0;
+  index_insert(&osal.timers_index, (size_t)(otp - &osal.timers[0]),
+               timer_name);
+  chSysUnlock();
 
   *timer_id = (uint32)otp;
   *clock_accuracy = (uint32)(1000000 / CH_CFG_ST_FREQUENCY);
@@ -515,6 +628,7 @@ int32 OS_TimerDelete(uint32 timer_id) {
 
   /* Marking as no more free, will be overwritten by the pool pointer.*/
   otp->is_free = 1;
+  index_remove(&osal.timers_index, (size_t)(otp - &osal.timers[0]));
 
   /* Resetting the timer.*/
   chVTResetI(&otp->vt);
@@ -561,6 +675,7 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time) {
     otp->start_time    = start_time;
     otp->interval_time = interval_time;
     chVTSetI(&otp->vt, US2ST(start_time), timer_handler, (void *)timer_id);
+    chVTSetReloadIntervalX(&otp->vt, US2ST(interval_time));
   }
 
   /* Leaving the critical zone.*/
@@ -635,7 +750,9 @@ int32 OS_TimerGetInfo(uint32 timer_id, OS_timer_prop_t *timer_prop) {
     return OS_ERR_INVALID_ID;
   }
 
-  strncpy(timer_prop->name, otp->name, OS_MAX_API_NAME - 1);
+  strncpy(timer_prop->name,
+          osal.timers_names[otp - &osal.timers[0]].name,
+          OS_MAX_API_NAME - 1);
   timer_prop->creator       = (uint32)0;
   timer_prop->start_time    = otp->start_time;
   timer_prop->interval_time = otp->interval_time;
@@ -720,14 +837,19 @@ int32 OS_QueueCreate(uint32 *queue_id, const char *queue_name,
   }
 
   /* Initializing object static parts.*/
-  strncpy(oqp->name, queue_name, OS_MAX_API_NAME - 1);
   chMBObjectInit(&oqp->mb, oqp->q_buffer, (size_t)queue_depth);
   chSemObjectInit(&oqp->free_msgs, (cnt_t)queue_depth);
   chPoolObjectInit(&oqp->messages, msgsize, NULL);
   chPoolLoadArray(&oqp->messages, oqp->mb_buffer, (size_t)queue_depth);
   oqp->depth   = queue_depth;
   oqp->size    = data_size;
-  oqp->is_free = 0;   /* Note, last.*/
+
+  /* Note, last, the queue becomes visible by name.*/
+  chSysLock();
+  oqp->is_free = 0;
+  index_insert(&osal.queues_index, (size_t)(oqp - &osal.queues[0]),
+               queue_name);
+  chSysUnlock();
   *queue_id = (uint32)oqp;
 
   return OS_SUCCESS;
@@ -757,6 +879,7 @@ int32 OS_QueueDelete(uint32 queue_id) {
 
   /* Marking as no more free, will be overwritten by the pool pointer.*/
   oqp->is_free = 1;
+  index_remove(&osal.queues_index, (size_t)(oqp - &osal.queues[0]));
 
   /* Pointers to areas to be freed.*/
   q_buffer  = oqp->q_buffer;
@@ -975,7 +1098,9 @@ int32 OS_QueueGetInfo (uint32 queue_id, OS_queue_prop_t *queue_prop) {
     return OS_ERR_INVALID_ID;
   }
 
-  strncpy(queue_prop->name, oqp->name, OS_MAX_API_NAME - 1);
+  strncpy(queue_prop->name,
+          osal.queues_names[oqp - &osal.queues[0]].name,
+          OS_MAX_API_NAME - 1);
   queue_prop->creator = (uint32)0;
 
   /* Leaving the critical zone.*/
@@ -1020,14 +1145,24 @@ int32 OS_BinSemCreate(uint32 *sem_id, const char *sem_name,
     return OS_INVALID_INT_NUM;
   }
 
+  /* Checking if the name is already taken.*/
+  if (index_find(&osal.binary_semaphores_index, sem_name) >= 0) {
+    return OS_ERR_NAME_TAKEN;
+  }
+
   /* Getting object.*/
   bsp = chPoolAlloc(&osal.binary_semaphores_pool);
   if (bsp == NULL) {
     return OS_ERR_NO_FREE_IDS;
   }
 
-  /* Semaphore is initialized.*/
+  /* Semaphore is initialized and becomes visible by name.*/
+  chSysLock();
   chBSemObjectInit(bsp, sem_initial_value == 0 ? true : false);
+  index_insert(&osal.binary_semaphores_index,
+               (size_t)(bsp - &osal.binary_semaphores[0]),
+               sem_name);
+  chSysUnlock();
 
   *sem_id = (uint32)bsp;
 
@@ -1057,6 +1192,8 @@ int32 OS_BinSemDelete(uint32 sem_id) {
   chBSemResetI(bsp, true);
 
   /* Flagging it as unused and returning it to the pool.*/
+  index_remove(&osal.binary_semaphores_index,
+               (size_t)(bsp - &osal.binary_semaphores[0]));
   bsp->sem.queue.prev = NULL;
   chPoolFreeI(&osal.binary_semaphores_pool, (void *)bsp);
 
@@ -1219,7 +1356,6 @@ int32 OS_BinSemTimedWait(uint32 sem_id, uint32 msecs) {
 
 /**
  * @brief   Retrieves a binary semaphore id by name.
- * @note    It is not currently implemented.
  *
  * @param[out] sem_id           pointer to a binary semaphore id variable
  * @param[in] sem_name          the binary semaphore name
@@ -1228,6 +1364,7 @@ int32 OS_BinSemTimedWait(uint32 sem_id, uint32 msecs) {
  * @api
  */
 int32 OS_BinSemGetIdByName(uint32 *sem_id, const char *sem_name) {
+  int32 n;
 
   /* NULL pointer checks.*/
   if ((sem_id == NULL) || (sem_name == NULL)) {
@@ -1239,7 +1376,14 @@ int32 OS_BinSemGetIdByName(uint32 *sem_id, const char *sem_name) {
     return OS_ERR_NAME_TOO_LONG;
   }
 
-  return OS_ERR_NOT_IMPLEMENTED;
+  /* Searching the semaphore.*/
+  n = index_find(&osal.binary_semaphores_index, sem_name);
+  if (n >= 0) {
+    *sem_id = (uint32)&osal.binary_semaphores[n];
+    return OS_SUCCESS;
+  }
+
+  return OS_ERR_NAME_NOT_FOUND;
 }
 
 /**
@@ -1318,14 +1462,24 @@ int32 OS_CountSemCreate(uint32 *sem_id, const char *sem_name,
     return OS_INVALID_INT_NUM;
   }
 
+  /* Checking if the name is already taken.*/
+  if (index_find(&osal.count_semaphores_index, sem_name) >= 0) {
+    return OS_ERR_NAME_TAKEN;
+  }
+
   /* Getting object.*/
   sp = chPoolAlloc(&osal.count_semaphores_pool);
   if (sp == NULL) {
     return OS_ERR_NO_FREE_IDS;
   }
 
-  /* Semaphore is initialized.*/
+  /* Semaphore is initialized and becomes visible by name.*/
+  chSysLock();
   chSemObjectInit(sp, (cnt_t)sem_initial_value);
+  index_insert(&osal.count_semaphores_index,
+               (size_t)(sp - &osal.count_semaphores[0]),
+               sem_name);
+  chSysUnlock();
 
   *sem_id = (uint32)sp;
 
@@ -1355,6 +1509,8 @@ int32 OS_CountSemDelete(uint32 sem_id) {
   chSemResetI(sp, 0);
 
   /* Flagging it as unused and returning it to the pool.*/
+  index_remove(&osal.count_semaphores_index,
+               (size_t)(sp - &osal.count_semaphores[0]));
   sp->queue.prev = NULL;
   chPoolFreeI(&osal.count_semaphores_pool, (void *)sp);
 
@@ -1476,7 +1632,6 @@ int32 OS_CountSemTimedWait(uint32 sem_id, uint32 msecs) {
 
 /**
  * @brief   Retrieves a counter semaphore id by name.
- * @note    It is not currently implemented.
  *
  * @param[out] sem_id           pointer to a counter semaphore id variable
  * @param[in] sem_name          the counter semaphore name
@@ -1485,6 +1640,7 @@ int32 OS_CountSemTimedWait(uint32 sem_id, uint32 msecs) {
  * @api
  */
 int32 OS_CountSemGetIdByName(uint32 *sem_id, const char *sem_name) {
+  int32 n;
 
   /* NULL pointer checks.*/
   if ((sem_id == NULL) || (sem_name == NULL)) {
@@ -1496,7 +1652,14 @@ int32 OS_CountSemGetIdByName(uint32 *sem_id, const char *sem_name) {
     return OS_ERR_NAME_TOO_LONG;
   }
 
-  return OS_ERR_NOT_IMPLEMENTED;
+  /* Searching the semaphore.*/
+  n = index_find(&osal.count_semaphores_index, sem_name);
+  if (n >= 0) {
+    *sem_id = (uint32)&osal.count_semaphores[n];
+    return OS_SUCCESS;
+  }
+
+  return OS_ERR_NAME_NOT_FOUND;
 }
 
 /**
@@ -1568,14 +1731,23 @@ int32 OS_MutSemCreate(uint32 *sem_id, const char *sem_name, uint32 options) {
     return OS_ERR_NAME_TOO_LONG;
   }
 
+  /* Checking if the name is already taken.*/
+  if (index_find(&osal.mutexes_index, sem_name) >= 0) {
+    return OS_ERR_NAME_TAKEN;
+  }
+
   /* Getting object.*/
   mp = chPoolAlloc(&osal.mutexes_pool);
   if (mp == NULL) {
     return OS_ERR_NO_FREE_IDS;
   }
 
-  /* Semaphore is initialized.*/
+  /* Mutex is initialized and becomes visible by name.*/
+  chSysLock();
   chMtxObjectInit(mp);
+  index_insert(&osal.mutexes_index, (size_t)(mp - &osal.mutexes[0]),
+               sem_name);
+  chSysUnlock();
 
   *sem_id = (uint32)mp;
 
@@ -1605,6 +1777,7 @@ int32 OS_MutSemDelete(uint32 sem_id) {
   chMtxUnlockAllS();
 
   /* Flagging it as unused and returning it to the pool.*/
+  index_remove(&osal.mutexes_index, (size_t)(mp - &osal.mutexes[0]));
   mp->queue.prev = NULL;
   chPoolFreeI(&osal.mutexes_pool, (void *)mp);
 
@@ -1683,7 +1856,6 @@ int32 OS_MutSemTake(uint32 sem_id) {
 
 /**
  * @brief   Retrieves a mutex id by name.
- * @note    It is not currently implemented.
  *
  * @param[out] sem_id           pointer to a mutex id variable
  * @param[in] sem_name          the mutex name
@@ -1692,6 +1864,7 @@ int32 OS_MutSemTake(uint32 sem_id) {
  * @api
  */
 int32 OS_MutSemGetIdByName(uint32 *sem_id, const char *sem_name) {
+  int32 n;
 
   /* NULL pointer checks.*/
   if ((sem_id == NULL) || (sem_name == NULL)) {
@@ -1703,7 +1876,14 @@ int32 OS_MutSemGetIdByName(uint32 *sem_id, const char *sem_name) {
     return OS_ERR_NAME_TOO_LONG;
   }
 
-  return OS_ERR_NOT_IMPLEMENTED;
+  /* Searching the mutex.*/
+  n = index_find(&osal.mutexes_index, sem_name);
+  if (n >= 0) {
+    *sem_id = (uint32)&osal.mutexes[n];
+    return OS_SUCCESS;
+  }
+
+  return OS_ERR_NAME_NOT_FOUND;
 }
 
 /**
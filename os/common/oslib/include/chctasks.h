@@ -0,0 +1,428 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chctasks.h
+ * @brief   Cooperative tasks macros and structures.
+ *
+ * @addtogroup ctasks
+ * @{
+ */
+
+#ifndef CHCTASKS_H
+#define CHCTASKS_H
+
+#if (CH_CFG_USE_CTASKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Task states
+ * @{
+ */
+#define CT_READY            (ctstate_t)0    /**< @brief Ready to run.       */
+#define CT_WAITING          (ctstate_t)1    /**< @brief Waiting.            */
+#define CT_EXITED           (ctstate_t)2    /**< @brief Terminated.         */
+/** @} */
+
+/**
+ * @brief   Event flag reserved for waking up the scheduler thread.
+ */
+#define CT_EVENT_KICK                                                       \
+  ((eventmask_t)1 << ((sizeof (eventmask_t) * 8U) - 1U))
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_USE_EVENTS == FALSE
+#error "CH_CFG_USE_CTASKS requires CH_CFG_USE_EVENTS"
+#endif
+
+#if CH_CFG_USE_EVENTS_TIMEOUT == FALSE
+#error "CH_CFG_USE_CTASKS requires CH_CFG_USE_EVENTS_TIMEOUT"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a task state.
+ */
+typedef uint8_t ctstate_t;
+
+/**
+ * @brief   Type of a cooperative task structure.
+ */
+typedef struct ch_ctask ctask_t;
+
+/**
+ * @brief   Type of a cooperative tasks scheduler structure.
+ */
+typedef struct ch_ctask_scheduler ctask_scheduler_t;
+
+/**
+ * @brief   Task function.
+ * @details The function is invoked by the scheduler each time the task
+ *          is given the chance to run, the function body must be enclosed
+ *          between @p CT_BEGIN() and @p CT_END().
+ */
+typedef ctstate_t (*ctfunc_t)(ctask_t *ctp);
+
+/**
+ * @brief   Structure representing a cooperative task.
+ */
+struct ch_ctask {
+  ctask_t               *next;      /**< @brief Next task in the scheduler
+                                                list.                       */
+  ctask_scheduler_t     *sched;     /**< @brief Scheduler running the
+                                                task.                       */
+  ctfunc_t              func;       /**< @brief Task function.              */
+  void                  *arg;       /**< @brief Task function argument.     */
+  systime_t             time;       /**< @brief Start time of the current
+                                                wait.                       */
+  systime_t             timeout;    /**< @brief Timeout of the current
+                                                wait.                       */
+  msg_t                 msg;        /**< @brief Result of the last wait.    */
+  uint16_t              lc;         /**< @brief Resume point.               */
+  ctstate_t             state;      /**< @brief Task state.                 */
+  bool                  poll;       /**< @brief The current wait condition
+                                                must be polled.             */
+};
+
+/**
+ * @brief   Structure representing a cooperative tasks scheduler.
+ */
+struct ch_ctask_scheduler {
+  ctask_t               *tasks;     /**< @brief Tasks in execution order.   */
+  ctask_t               *started;   /**< @brief Tasks started and not yet
+                                                merged in the tasks list, in
+                                                reverse order.              */
+  thread_t              *thread;    /**< @brief Thread running the
+                                                scheduler.                  */
+  eventmask_t           events;     /**< @brief Events received and not yet
+                                                taken by a task.            */
+  systime_t             poll;       /**< @brief Polling interval of the
+                                                tasks waiting on conditions,
+                                                semaphores and mailboxes.   */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Task body macros
+ * @note    The task local variables are not preserved across the macros
+ *          that can suspend the task, the task state must be kept in a
+ *          structure pointed by the task argument.
+ * @note    A task body cannot contain @p switch statements enclosing a
+ *          suspending macro.
+ * @{
+ */
+/**
+ * @brief   Task body start.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ */
+#define CT_BEGIN(ctp)                                                       \
+  switch ((ctp)->lc) {                                                      \
+  case 0U:
+
+/**
+ * @brief   Task body end, the task terminates when the end is reached.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ */
+#define CT_END(ctp)                                                         \
+  default:                                                                  \
+    break;                                                                  \
+  }                                                                         \
+  (ctp)->lc = 0U;                                                           \
+  return CT_EXITED
+
+/**
+ * @brief   Terminates the task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ */
+#define CT_EXIT(ctp)                                                        \
+  do {                                                                      \
+    (ctp)->lc = 0U;                                                         \
+    return CT_EXITED;                                                       \
+  } while (false)
+
+/**
+ * @brief   Yields to the other tasks.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ */
+#define CT_YIELD(ctp)                                                       \
+  do {                                                                      \
+    (ctp)->lc = (uint16_t)__LINE__;                                         \
+    return CT_READY;                                                        \
+  case __LINE__:                                                            \
+    ;                                                                       \
+  } while (false)
+
+/**
+ * @brief   Waits for a condition to become true or for a timeout.
+ * @details The condition is evaluated each time the task is scheduled,
+ *          the wait result is stored in the @p msg field of the task:
+ *          @p MSG_OK if the condition became true, @p MSG_TIMEOUT if the
+ *          timeout expired.
+ * @note    The condition can set the @p msg field of the task in order
+ *          to report a different wait result.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] cond      the condition
+ * @param[in] timeout   the number of ticks before the wait times out, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE no timeout.
+ *                      - @a TIME_IMMEDIATE the condition is evaluated
+ *                        only once.
+ *                      .
+ */
+#define CT_WAIT_UNTIL_TIMEOUT(ctp, cond, timeout)                           \
+  _CT_WAIT(ctp, cond, timeout, true)
+
+/**
+ * @brief   Waits for a condition to become true.
+ * @details The condition is evaluated each time the task is scheduled.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] cond      the condition
+ */
+#define CT_WAIT_UNTIL(ctp, cond)                                            \
+  _CT_WAIT(ctp, cond, TIME_INFINITE, true)
+
+/**
+ * @brief   Suspends the task for the specified time.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] time      the delay in system ticks
+ */
+#define CT_SLEEP(ctp, time)                                                 \
+  _CT_WAIT(ctp, false, time, false)
+
+#if (CH_CFG_USE_SEMAPHORES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Waits on a semaphore.
+ * @details The wait result is stored in the @p msg field of the task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] sp        pointer to a @p semaphore_t structure
+ * @param[in] timeout   the number of ticks before the wait times out
+ */
+#define CT_SEM_WAIT_TIMEOUT(ctp, sp, timeout)                               \
+  _CT_WAIT(ctp, chSemWaitTimeout(sp, TIME_IMMEDIATE) == MSG_OK,             \
+           timeout, true)
+#endif
+
+#if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Waits for any of the specified events.
+ * @details The events are the ones signaled to the scheduler thread, the
+ *          events taken by a task are cleared. The wait result is stored in
+ *          the @p msg field of the task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] mask      mask of the events to wait for
+ * @param[out] eventsp  pointer to the variable receiving the events taken
+ * @param[in] timeout   the number of ticks before the wait times out
+ */
+#define CT_EVT_WAIT_ANY_TIMEOUT(ctp, mask, eventsp, timeout)                \
+  _CT_WAIT(ctp, (*(eventsp) = _ct_take_events(ctp, mask)) != (eventmask_t)0,\
+           timeout, false)
+#endif
+
+#if (CH_CFG_USE_MAILBOXES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Fetches a message from a mailbox.
+ * @details The wait result is stored in the @p msg field of the task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to the variable receiving the message
+ * @param[in] timeout   the number of ticks before the wait times out
+ */
+#define CT_MB_FETCH_TIMEOUT(ctp, mbp, msgp, timeout)                        \
+  _CT_WAIT(ctp, ((ctp)->msg = chMBFetch(mbp, msgp, TIME_IMMEDIATE)) !=      \
+                MSG_TIMEOUT, timeout, true)
+
+/**
+ * @brief   Posts a message into a mailbox.
+ * @details The wait result is stored in the @p msg field of the task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] m         the message to be posted
+ * @param[in] timeout   the number of ticks before the wait times out
+ */
+#define CT_MB_POST_TIMEOUT(ctp, mbp, m, timeout)                            \
+  _CT_WAIT(ctp, ((ctp)->msg = chMBPost(mbp, m, TIME_IMMEDIATE)) !=          \
+                MSG_TIMEOUT, timeout, true)
+#endif
+/** @} */
+
+/**
+ * @brief   Generic wait.
+ * @details The resume point is placed at the end of the loop body so that
+ *          no statement falls through into it, a resumed task evaluates
+ *          the condition again in the loop test.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] cond      the condition
+ * @param[in] tmo       the number of ticks before the wait times out
+ * @param[in] pll       the condition must be polled
+ *
+ * @notapi
+ */
+#define _CT_WAIT(ctp, cond, tmo, pll)                                       \
+  do {                                                                      \
+    _ct_wait_start(ctp, tmo, pll);                                          \
+    (ctp)->lc = (uint16_t)__LINE__;                                         \
+    while (!(cond)) {                                                       \
+      if (!_ct_is_timed_out(ctp)) {                                         \
+        return CT_WAITING;                                                  \
+      }                                                                     \
+      (ctp)->msg = MSG_TIMEOUT;                                             \
+      break;                                                                \
+  case __LINE__:                                                            \
+      ;                                                                     \
+    }                                                                       \
+  } while (false)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chCTObjectInit(ctask_scheduler_t *ctsp, systime_t poll);
+  void chCTStart(ctask_scheduler_t *ctsp, ctask_t *ctp,
+                 ctfunc_t func, void *arg);
+  void chCTStartI(ctask_scheduler_t *ctsp, ctask_t *ctp,
+                  ctfunc_t func, void *arg);
+  void chCTRun(ctask_scheduler_t *ctsp);
+  void chCTKickI(ctask_scheduler_t *ctsp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts a wait.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] timeout   the number of ticks before the wait times out
+ * @param[in] poll      the wait condition must be polled
+ *
+ * @notapi
+ */
+static inline void _ct_wait_start(ctask_t *ctp, systime_t timeout,
+                                  bool poll) {
+
+  ctp->time    = chVTGetSystemTimeX();
+  ctp->timeout = timeout;
+  ctp->msg     = MSG_OK;
+  ctp->poll    = poll;
+}
+
+/**
+ * @brief   Verifies if the current wait timed out.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @return              The timeout status.
+ *
+ * @notapi
+ */
+static inline bool _ct_is_timed_out(ctask_t *ctp) {
+
+  if (ctp->timeout == TIME_INFINITE) {
+    return false;
+  }
+
+  return !chVTIsSystemTimeWithinX(ctp->time, ctp->time + ctp->timeout);
+}
+
+/**
+ * @brief   Takes events received by the scheduler.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @param[in] mask      mask of the events to be taken
+ * @return              The events taken.
+ *
+ * @notapi
+ */
+static inline eventmask_t _ct_take_events(ctask_t *ctp, eventmask_t mask) {
+  eventmask_t m = ctp->sched->events & mask;
+
+  ctp->sched->events &= ~m;
+
+  return m;
+}
+
+/**
+ * @brief   Returns the state of a task.
+ *
+ * @param[in] ctp       pointer to the @p ctask_t structure
+ * @return              The task state.
+ *
+ * @xclass
+ */
+static inline ctstate_t chCTGetStateX(ctask_t *ctp) {
+
+  return ctp->state;
+}
+
+/**
+ * @brief   Wakes up the scheduler thread.
+ * @details The tasks are scheduled again without waiting for the polling
+ *          interval, this is useful after signaling a semaphore or posting
+ *          a message that a task is waiting for.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ *
+ * @api
+ */
+static inline void chCTKick(ctask_scheduler_t *ctsp) {
+
+  chSysLock();
+  chCTKickI(ctsp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+#endif /* CH_CFG_USE_CTASKS == TRUE */
+
+#endif /* CHCTASKS_H */
+
+/** @} */
@@ -0,0 +1,288 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chseqlock.h
+ * @brief   Sequence locks structures and macros.
+ *
+ * @addtogroup seqlocks
+ * @details Sequence locks related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A sequence lock protects data written from interrupt handlers,
+ *          or from I-Locked state, and read from threads without entering
+ *          a critical zone.<br>
+ *          The writer increases a sequence counter before and after
+ *          updating the data, the counter is odd while an update is in
+ *          progress. A reader samples the counter, copies the data then
+ *          samples the counter again, if the counter changed or was odd
+ *          then the copy could be torn and the read is retried.<br>
+ *          Readers never disable interrupts so reading the data does not
+ *          add to the system latency, the cost is a possible retry when
+ *          an update happens during the copy.
+ *          <h2>Constraints</h2>
+ *          - Writers are serialized by the kernel lock, the write
+ *            functions are I-class.
+ *          - A reader must not preempt a writer, reading from an ISR is
+ *            only allowed if no writer runs at lower priority.
+ *          - The data must be copied through the lock using
+ *            @p chSeqReadObjectX() and @p chSeqWriteObjectI(), or through
+ *            @p volatile accesses, so that the compiler does not move the
+ *            data accesses outside the counter accesses.
+ *          .
+ *          In order to use the sequence locks APIs the
+ *          @p CH_CFG_USE_SEQLOCKS option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#ifndef CHSEQLOCK_H
+#define CHSEQLOCK_H
+
+#if (CH_CFG_USE_SEQLOCKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_SEQLOCKS_MAX_SIZE < 1
+#error "invalid CH_CFG_SEQLOCKS_MAX_SIZE value"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Sequence lock structure.
+ */
+typedef struct {
+  volatile ucnt_t       seq;        /**< @brief Sequence counter, odd while
+                                                an update is in progress.   */
+} seqlock_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static sequence lock initializer.
+ * @details This macro should be used when statically initializing a
+ *          sequence lock that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the sequence lock variable
+ */
+#define _SEQLOCK_DATA(name) {(ucnt_t)0}
+
+/**
+ * @brief   Static sequence lock initializer.
+ * @details Statically initialized sequence locks require no explicit
+ *          initialization using @p chSeqObjectInit().
+ *
+ * @param[in] name      the name of the sequence lock variable
+ */
+#define SEQLOCK_DECL(name) seqlock_t name = _SEQLOCK_DATA(name)
+
+/**
+ * @brief   Reads an object protected by a sequence lock.
+ * @details Typed variant of @p chSeqReadObjectX(), the size is taken from
+ *          the object type and the two pointers must point to the same
+ *          type.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @param[in] objp      pointer to the shared object
+ * @param[out] dstp     pointer to the local copy
+ *
+ * @xclass
+ */
+#define chSeqReadX(slp, objp, dstp)                                         \
+  chSeqReadObjectX(slp, (objp), (dstp),                                     \
+                   sizeof (*(dstp)) + (0U * sizeof ((objp) == (dstp))))
+
+/**
+ * @brief   Writes an object protected by a sequence lock.
+ * @details Typed variant of @p chSeqWriteObjectI(), the size is taken from
+ *          the object type and the two pointers must point to the same
+ *          type.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @param[out] objp     pointer to the shared object
+ * @param[in] srcp      pointer to the new object value
+ *
+ * @iclass
+ */
+#define chSeqWriteI(slp, objp, srcp)                                        \
+  chSeqWriteObjectI(slp, (objp), (srcp),                                    \
+                    sizeof (*(objp)) + (0U * sizeof ((objp) == (srcp))))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a sequence lock.
+ *
+ * @param[out] slp      pointer to a @p seqlock_t structure
+ *
+ * @init
+ */
+static inline void chSeqObjectInit(seqlock_t *slp) {
+
+  chDbgCheck(slp != NULL);
+
+  slp->seq = (ucnt_t)0;
+}
+
+/**
+ * @brief   Starts an update of the protected data.
+ * @note    The data must be written using @p volatile accesses.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ *
+ * @iclass
+ */
+static inline void chSeqWriteBeginI(seqlock_t *slp) {
+
+  chDbgCheckClassI();
+  chDbgAssert((slp->seq & (ucnt_t)1) == (ucnt_t)0, "update in progress");
+
+  slp->seq++;
+}
+
+/**
+ * @brief   Ends an update of the protected data.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ *
+ * @iclass
+ */
+static inline void chSeqWriteEndI(seqlock_t *slp) {
+
+  chDbgCheckClassI();
+  chDbgAssert((slp->seq & (ucnt_t)1) == (ucnt_t)1, "no update in progress");
+
+  slp->seq++;
+}
+
+/**
+ * @brief   Starts a read of the protected data.
+ * @note    The data must be read using @p volatile accesses.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @return              The sequence value to be passed to
+ *                      @p chSeqReadRetryX().
+ *
+ * @xclass
+ */
+static inline ucnt_t chSeqReadBeginX(seqlock_t *slp) {
+
+  return slp->seq;
+}
+
+/**
+ * @brief   Verifies a read of the protected data.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @param[in] seq       value returned by @p chSeqReadBeginX()
+ * @return              The read status.
+ * @retval false        if the data read is consistent.
+ * @retval true         if the data could be torn and the read must be
+ *                      repeated.
+ *
+ * @xclass
+ */
+static inline bool chSeqReadRetryX(seqlock_t *slp, ucnt_t seq) {
+
+  return (bool)(((seq & (ucnt_t)1) != (ucnt_t)0) || (slp->seq != seq));
+}
+
+/**
+ * @brief   Reads an object protected by a sequence lock.
+ * @details The object is copied until a consistent copy is obtained.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @param[in] objp      pointer to the shared object
+ * @param[out] dstp     pointer to the local copy
+ * @param[in] size      size of the object, it cannot exceed
+ *                      @p CH_CFG_SEQLOCKS_MAX_SIZE
+ *
+ * @xclass
+ */
+static inline void chSeqReadObjectX(seqlock_t *slp, const void *objp,
+                                    void *dstp, size_t size) {
+  ucnt_t seq;
+
+  chDbgCheck((slp != NULL) && (objp != NULL) && (dstp != NULL) &&
+             (size <= (size_t)CH_CFG_SEQLOCKS_MAX_SIZE));
+
+  do {
+    const volatile uint8_t *sp = (const volatile uint8_t *)objp;
+    volatile uint8_t *dp = (volatile uint8_t *)dstp;
+    size_t n = size;
+
+    seq = chSeqReadBeginX(slp);
+    while (n > (size_t)0) {
+      *dp++ = *sp++;
+      n--;
+    }
+  } while (chSeqReadRetryX(slp, seq));
+}
+
+/**
+ * @brief   Writes an object protected by a sequence lock.
+ *
+ * @param[in] slp       pointer to a @p seqlock_t structure
+ * @param[out] objp     pointer to the shared object
+ * @param[in] srcp      pointer to the new object value
+ * @param[in] size      size of the object, it cannot exceed
+ *                      @p CH_CFG_SEQLOCKS_MAX_SIZE
+ *
+ * @iclass
+ */
+static inline void chSeqWriteObjectI(seqlock_t *slp, void *objp,
+                                     const void *srcp, size_t size) {
+  volatile uint8_t *dp = (volatile uint8_t *)objp;
+  const uint8_t *sp = (const uint8_t *)srcp;
+
+  chDbgCheck((slp != NULL) && (objp != NULL) && (srcp != NULL) &&
+             (size <= (size_t)CH_CFG_SEQLOCKS_MAX_SIZE));
+
+  chSeqWriteBeginI(slp);
+  while (size > (size_t)0) {
+    *dp++ = *sp++;
+    size--;
+  }
+  chSeqWriteEndI(slp);
+}
+
+#endif /* CH_CFG_USE_SEQLOCKS == TRUE */
+
+#endif /* CHSEQLOCK_H */
+
+/** @} */
@@ -0,0 +1,244 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chworkq.h
+ * @brief   Work queues macros and structures.
+ *
+ * @addtogroup workqueues
+ * @{
+ */
+
+#ifndef CHWORKQ_H
+#define CHWORKQ_H
+
+#if (CH_CFG_USE_WORKQUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_WORKQ_WORKERS < 0
+#error "invalid CH_CFG_WORKQ_WORKERS value"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a work item structure.
+ */
+typedef struct ch_work_item work_item_t;
+
+/**
+ * @brief   Type of a work queue structure.
+ */
+typedef struct ch_work_queue work_queue_t;
+
+/**
+ * @brief   Work item function.
+ */
+typedef void (*wifunc_t)(void *p);
+
+/**
+ * @brief   Structure representing a work item.
+ */
+struct ch_work_item {
+  work_item_t           *next;      /**< @brief Next item in the queue.     */
+  wifunc_t              func;       /**< @brief Work function.              */
+  void                  *par;       /**< @brief Work function parameter.    */
+  tprio_t               prio;       /**< @brief Item priority, items with
+                                                higher priority are served
+                                                first.                      */
+  work_queue_t          *wqp;       /**< @brief Queue the item is pending
+                                                on or @p NULL.              */
+#if (CH_DBG_STATISTICS == TRUE) || defined(__DOXYGEN__)
+  rtcnt_t               time;       /**< @brief Realtime counter value at
+                                                insertion in the queue.     */
+#endif
+};
+
+/**
+ * @brief   Structure representing a delayed work item.
+ */
+typedef struct {
+  work_item_t           item;       /**< @brief Work item.                  */
+  virtual_timer_t       vt;         /**< @brief Delay timer.                */
+} delayed_work_t;
+
+#if (CH_DBG_STATISTICS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a work queue statistics structure.
+ */
+typedef struct {
+  ucnt_t                n_submitted;/**< @brief Number of items inserted in
+                                                the queue.                  */
+  ucnt_t                n_executed; /**< @brief Number of items executed.   */
+  cnt_t                 max_depth;  /**< @brief Maximum number of pending
+                                                items.                      */
+  time_measurement_t    latency;    /**< @brief Measurement of the time
+                                                between the insertion of an
+                                                item and its execution.     */
+} work_queue_stats_t;
+#endif
+
+/**
+ * @brief   Structure representing a work queue.
+ */
+struct ch_work_queue {
+  work_item_t           *head;      /**< @brief Pending items in priority
+                                                order.                      */
+  cnt_t                 depth;      /**< @brief Number of pending items.    */
+  threads_queue_t       workers;    /**< @brief Idle workers.               */
+#if (CH_DBG_STATISTICS == TRUE) || defined(__DOXYGEN__)
+  work_queue_stats_t    stats;      /**< @brief Queue statistics.           */
+#endif
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static work item initializer.
+ * @details This macro should be used when statically initializing a
+ *          work item that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the work item variable
+ * @param[in] func      the work function
+ * @param[in] par       the work function parameter
+ * @param[in] prio      the item priority
+ */
+#define _WORK_ITEM_DATA(name, func, par, prio) {                            \
+  NULL,                                                                     \
+  (func),                                                                   \
+  (par),                                                                    \
+  (prio),                                                                   \
+  NULL                                                                      \
+}
+
+/**
+ * @brief   Static work item initializer.
+ * @details Statically initialized work items require no explicit
+ *          initialization using @p chWQItemObjectInit().
+ *
+ * @param[in] name      the name of the work item variable
+ * @param[in] func      the work function
+ * @param[in] par       the work function parameter
+ * @param[in] prio      the item priority
+ */
+#define WORK_ITEM_DECL(name, func, par, prio)                               \
+  work_item_t name = _WORK_ITEM_DATA(name, func, par, prio)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if (CH_CFG_WORKQ_WORKERS > 0) && !defined(__DOXYGEN__)
+extern work_queue_t ch_workq;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _workq_init(void);
+  void chWQObjectInit(work_queue_t *wqp);
+  thread_t *chWQCreateWorker(work_queue_t *wqp, void *wsp, size_t size,
+                             tprio_t prio);
+  void chWQItemObjectInit(work_item_t *wip, wifunc_t func, void *par,
+                          tprio_t prio);
+  void chWQDelayedObjectInit(delayed_work_t *dwp, wifunc_t func, void *par,
+                             tprio_t prio);
+  bool chWQSubmit(work_queue_t *wqp, work_item_t *wip);
+  bool chWQSubmitI(work_queue_t *wqp, work_item_t *wip);
+  bool chWQSubmitDelayed(work_queue_t *wqp, delayed_work_t *dwp,
+                         systime_t delay);
+  bool chWQSubmitDelayedI(work_queue_t *wqp, delayed_work_t *dwp,
+                          systime_t delay);
+  bool chWQCancel(work_item_t *wip);
+  bool chWQCancelI(work_item_t *wip);
+  bool chWQCancelDelayed(delayed_work_t *dwp);
+  bool chWQCancelDelayedI(delayed_work_t *dwp);
+  void chWQReset(work_queue_t *wqp);
+  void chWQResetI(work_queue_t *wqp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the number of items pending in a work queue.
+ * @note    Delayed items are counted only after their delay expired.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ * @return              The number of pending items.
+ *
+ * @iclass
+ */
+static inline cnt_t chWQGetDepthI(work_queue_t *wqp) {
+
+  chDbgCheckClassI();
+
+#if CH_CFG_WORKQ_WORKERS > 0
+  if (wqp == NULL) {
+    wqp = &ch_workq;
+  }
+#endif
+
+  chDbgCheck(wqp != NULL);
+
+  return wqp->depth;
+}
+
+/**
+ * @brief   Returns @p true if a work item is pending.
+ * @details An item is pending from its submission until a worker starts
+ *          executing it, delayed items are pending also while their delay
+ *          is running.
+ *
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The item state.
+ *
+ * @iclass
+ */
+static inline bool chWQIsPendingI(work_item_t *wip) {
+
+  chDbgCheckClassI();
+
+  return (bool)(wip->wqp != NULL);
+}
+
+#endif /* CH_CFG_USE_WORKQUEUES == TRUE */
+
+#endif /* CHWORKQ_H */
+
+/** @} */
@@ -0,0 +1,284 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chctasks.c
+ * @brief   Cooperative tasks code.
+ *
+ * @addtogroup ctasks
+ * @details Stackless cooperative tasks multiplexed on a single thread.
+ *          <h2>Operation mode</h2>
+ *          A cooperative task is a function that is invoked repeatedly by
+ *          a scheduler running in a normal thread. The task resumes from
+ *          the point where it suspended itself, the resume point is
+ *          recorded in the task structure by the task body macros so a
+ *          task requires no stack of its own, just a @p ctask_t
+ *          structure.<br>
+ *          Tasks suspend themselves by yielding or by waiting on
+ *          conditions, timeouts, semaphores, events and mailboxes using
+ *          the @p CT_ macros. The scheduler gives each task the chance to
+ *          run in a round-robin fashion, when no task is ready the
+ *          scheduler thread sleeps until an event is signaled to it, the
+ *          nearest timeout expires or the polling interval elapses.<br>
+ *          Events are received by the scheduler thread and are taken by
+ *          the tasks waiting for them, those waits do not require polling.
+ *          Waits on conditions, semaphores and mailboxes are polled, the
+ *          polling interval is specified when initializing the scheduler
+ *          and can be shortened by invoking @p chCTKick() after making
+ *          the awaited resource available.
+ * @pre     In order to use the cooperative tasks APIs the
+ *          @p CH_CFG_USE_CTASKS option must be enabled in @p chconf.h.
+ * @note    Compatible with RT only.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_CTASKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Appends the started tasks to the tasks list.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ *
+ * @notapi
+ */
+static void ct_merge(ctask_scheduler_t *ctsp) {
+  ctask_t *ctp, *list, **pp;
+
+  chSysLock();
+  ctp = ctsp->started;
+  ctsp->started = NULL;
+  chSysUnlock();
+
+  /* The started tasks are in reverse order.*/
+  list = NULL;
+  while (ctp != NULL) {
+    ctask_t *next = ctp->next;
+
+    ctp->next = list;
+    list = ctp;
+    ctp = next;
+  }
+
+  pp = &ctsp->tasks;
+  while (*pp != NULL) {
+    pp = &(*pp)->next;
+  }
+  *pp = list;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p ctask_scheduler_t object.
+ *
+ * @param[out] ctsp     pointer to the @p ctask_scheduler_t structure
+ * @param[in] poll      polling interval of the tasks waiting on conditions,
+ *                      semaphores and mailboxes, @p TIME_INFINITE means
+ *                      that the tasks are only scheduled when an event is
+ *                      signaled to the scheduler thread or a timeout
+ *                      expires
+ *
+ * @init
+ */
+void chCTObjectInit(ctask_scheduler_t *ctsp, systime_t poll) {
+
+  chDbgCheck((ctsp != NULL) && (poll != TIME_IMMEDIATE));
+
+  ctsp->tasks   = NULL;
+  ctsp->started = NULL;
+  ctsp->thread  = NULL;
+  ctsp->events  = (eventmask_t)0;
+  ctsp->poll    = poll;
+}
+
+/**
+ * @brief   Starts a task.
+ * @details The task is added to the scheduler and runs for the first time
+ *          in the next scheduling round.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ * @param[out] ctp      pointer to the @p ctask_t structure
+ * @param[in] func      the task function
+ * @param[in] arg       the task function argument, the task can access
+ *                      it through the @p arg field
+ *
+ * @api
+ */
+void chCTStart(ctask_scheduler_t *ctsp, ctask_t *ctp,
+               ctfunc_t func, void *arg) {
+
+  chSysLock();
+  chCTStartI(ctsp, ctp, func, arg);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Starts a task.
+ * @details The task is added to the scheduler and runs for the first time
+ *          in the next scheduling round.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ * @param[out] ctp      pointer to the @p ctask_t structure
+ * @param[in] func      the task function
+ * @param[in] arg       the task function argument, the task can access
+ *                      it through the @p arg field
+ *
+ * @iclass
+ */
+void chCTStartI(ctask_scheduler_t *ctsp, ctask_t *ctp,
+                ctfunc_t func, void *arg) {
+
+  chDbgCheckClassI();
+  chDbgCheck((ctsp != NULL) && (ctp != NULL) && (func != NULL));
+
+  ctp->sched   = ctsp;
+  ctp->func    = func;
+  ctp->arg     = arg;
+  ctp->timeout = TIME_INFINITE;
+  ctp->msg     = MSG_OK;
+  ctp->lc      = 0U;
+  ctp->state   = CT_READY;
+  ctp->poll    = false;
+  ctp->next    = ctsp->started;
+  ctsp->started = ctp;
+  chCTKickI(ctsp);
+}
+
+/**
+ * @brief   Runs the tasks scheduler.
+ * @details The tasks are scheduled in the calling thread, the function
+ *          returns when a termination request is sent to the thread
+ *          using @p chThdTerminate() followed by @p chCTKick(), the
+ *          tasks still running are left in their current state.
+ * @note    The events signaled to the calling thread are delivered to
+ *          the tasks, the event @p CT_EVENT_KICK is reserved.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ *
+ * @api
+ */
+void chCTRun(ctask_scheduler_t *ctsp) {
+
+  chDbgCheck(ctsp != NULL);
+
+  chSysLock();
+  ctsp->thread = chThdGetSelfX();
+  chSysUnlock();
+
+  while (!chThdShouldTerminateX()) {
+    ctask_t *ctp, **pp;
+    systime_t delay;
+    bool ready = false;
+
+    /* Pending kicks are satisfied by this round, kicks arriving while the
+       tasks run cause another round.*/
+    ctsp->events |= chEvtGetAndClearEvents(ALL_EVENTS) & ~CT_EVENT_KICK;
+    if (ctsp->started != NULL) {
+      ct_merge(ctsp);
+    }
+
+    /* Giving each task the chance to run and computing the time until the
+       next timeout or poll.*/
+    delay = TIME_INFINITE;
+    pp = &ctsp->tasks;
+    while ((ctp = *pp) != NULL) {
+      ctp->state = ctp->func(ctp);
+      if (ctp->state == CT_EXITED) {
+        *pp = ctp->next;
+        continue;
+      }
+      if (ctp->state == CT_READY) {
+        ready = true;
+      }
+      else {
+        if (ctp->poll && (ctsp->poll < delay)) {
+          delay = ctsp->poll;
+        }
+        if (ctp->timeout != TIME_INFINITE) {
+          systime_t end = ctp->time + ctp->timeout;
+          systime_t left = (systime_t)0;
+
+          if (chVTIsSystemTimeWithinX(ctp->time, end)) {
+            left = end - chVTGetSystemTimeX();
+          }
+          if (left < delay) {
+            delay = left;
+          }
+        }
+      }
+      pp = &ctp->next;
+    }
+
+    /* If no task is ready then sleeping until something happens, the
+       received events are taken in the next round.*/
+    if (!ready) {
+      ctsp->events |= chEvtWaitAnyTimeout(ALL_EVENTS, delay) &
+                      ~CT_EVENT_KICK;
+    }
+  }
+
+  chSysLock();
+  ctsp->thread = NULL;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Wakes up the scheduler thread.
+ * @details The tasks are scheduled again without waiting for the polling
+ *          interval, this is useful after signaling a semaphore or posting
+ *          a message that a task is waiting for.
+ *
+ * @param[in] ctsp      pointer to the @p ctask_scheduler_t structure
+ *
+ * @iclass
+ */
+void chCTKickI(ctask_scheduler_t *ctsp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(ctsp != NULL);
+
+  if (ctsp->thread != NULL) {
+    chEvtSignalI(ctsp->thread, CT_EVENT_KICK);
+  }
+}
+
+#endif /* CH_CFG_USE_CTASKS == TRUE */
+
+/** @} */
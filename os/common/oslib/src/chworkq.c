@@ -0,0 +1,619 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chworkq.c
+ * @brief   Work queues code.
+ *
+ * @addtogroup workqueues
+ * @details Deferred execution of functions by a pool of worker threads.
+ *          <h2>Operation mode</h2>
+ *          A work item is a function and its parameter. Work items are
+ *          submitted to a work queue from threads, ISRs or virtual timers
+ *          callbacks and are executed in thread context by one of the
+ *          worker threads serving the queue.<br>
+ *          Operations defined for work queues:
+ *          - <b>Submit</b>: The item is inserted in the queue in priority
+ *            order, items with equal priority are served in FIFO order.
+ *            An item already pending is not inserted again.
+ *          - <b>Submit Delayed</b>: The item is inserted in the queue after
+ *            a delay, the delay is handled by a virtual timer embedded in
+ *            the item.
+ *          - <b>Cancel</b>: A pending item is removed from the queue.
+ *          - <b>Reset</b>: All the pending items are removed from the
+ *            queue.
+ *          .
+ *          An item is no more pending when a worker starts executing it,
+ *          the item can be submitted again from its own function.<br>
+ *          The item priority only decides the serving order, the work
+ *          functions run at the priority of the worker threads. Work
+ *          functions are allowed to block but a blocked function keeps
+ *          its worker busy, the number of workers must account for this.
+ *          <br>
+ *          The system work queue @p ch_workq is served by
+ *          @p CH_CFG_WORKQ_WORKERS threads started by @p chSysInit(),
+ *          more queues can be created and served by worker threads
+ *          created using @p chWQCreateWorker().
+ * @pre     In order to use the work queues APIs the
+ *          @p CH_CFG_USE_WORKQUEUES option must be enabled in
+ *          @p chconf.h.
+ * @note    Compatible with RT only.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_WORKQUEUES == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+#if (CH_CFG_WORKQ_WORKERS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   System work queue.
+ */
+work_queue_t ch_workq;
+#endif
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+#if (CH_CFG_WORKQ_WORKERS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Working areas of the system work queue workers.
+ */
+static THD_WORKING_AREA(ch_workq_wa[CH_CFG_WORKQ_WORKERS],
+                        CH_CFG_WORKQ_WA_SIZE);
+#endif
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Inserts an item in a work queue.
+ * @details The item is inserted after the items with the same or higher
+ *          priority and an idle worker, if any, is made ready.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure
+ * @param[in] wip       pointer to a @p work_item_t structure
+ *
+ * @notapi
+ */
+static void wq_insert(work_queue_t *wqp, work_item_t *wip) {
+  work_item_t **pp = &wqp->head;
+
+  while ((*pp != NULL) && ((*pp)->prio >= wip->prio)) {
+    pp = &(*pp)->next;
+  }
+  wip->next = *pp;
+  *pp = wip;
+  wqp->depth++;
+
+#if CH_DBG_STATISTICS == TRUE
+  wip->time = chSysGetRealtimeCounterX();
+  wqp->stats.n_submitted++;
+  if (wqp->depth > wqp->stats.max_depth) {
+    wqp->stats.max_depth = wqp->depth;
+  }
+#endif
+
+  chThdDequeueNextI(&wqp->workers, MSG_OK);
+}
+
+/**
+ * @brief   Removes an item from a work queue.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The operation status.
+ * @retval false        if the item was not in the queue.
+ * @retval true         if the item has been removed.
+ *
+ * @notapi
+ */
+static bool wq_remove(work_queue_t *wqp, work_item_t *wip) {
+  work_item_t **pp = &wqp->head;
+
+  while (*pp != NULL) {
+    if (*pp == wip) {
+      *pp = wip->next;
+      wqp->depth--;
+      wip->wqp = NULL;
+      return true;
+    }
+    pp = &(*pp)->next;
+  }
+
+  return false;
+}
+
+/**
+ * @brief   Delayed work timer callback.
+ *
+ * @param[in] p         pointer to the @p work_item_t structure
+ *
+ * @notapi
+ */
+static void wq_delay_cb(void *p) {
+  work_item_t *wip = (work_item_t *)p;
+
+  chSysLockFromISR();
+  wq_insert(wip->wqp, wip);
+  chSysUnlockFromISR();
+}
+
+/**
+ * @brief   Worker thread function.
+ *
+ * @param[in] p         pointer to the served @p work_queue_t structure
+ */
+static THD_FUNCTION(wq_worker, p) {
+  work_queue_t *wqp = (work_queue_t *)p;
+
+  chSysLock();
+  while (!chThdShouldTerminateX()) {
+    work_item_t *wip = wqp->head;
+    wifunc_t func;
+    void *par;
+
+    if (wip == NULL) {
+      (void) chThdEnqueueTimeoutS(&wqp->workers, TIME_INFINITE);
+      continue;
+    }
+
+    /* The item is no more pending once removed from the queue, its
+       function could submit it again.*/
+    wqp->head = wip->next;
+    wqp->depth--;
+    wip->wqp = NULL;
+    func = wip->func;
+    par  = wip->par;
+
+#if CH_DBG_STATISTICS == TRUE
+    {
+      time_measurement_t *tmp = &wqp->stats.latency;
+
+      wqp->stats.n_executed++;
+      tmp->n++;
+      tmp->last = chSysGetRealtimeCounterX() - wip->time;
+      tmp->cumulative += (rttime_t)tmp->last;
+      if (tmp->last > tmp->worst) {
+        tmp->worst = tmp->last;
+      }
+      if (tmp->last < tmp->best) {
+        tmp->best = tmp->last;
+      }
+    }
+#endif
+
+    chSysUnlock();
+    func(par);
+    chSysLock();
+  }
+  chSysUnlock();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the system work queue and starts its workers.
+ *
+ * @notapi
+ */
+void _workq_init(void) {
+#if CH_CFG_WORKQ_WORKERS > 0
+  unsigned i;
+
+  chWQObjectInit(&ch_workq);
+  for (i = 0U; i < (unsigned)CH_CFG_WORKQ_WORKERS; i++) {
+    (void) chWQCreateWorker(&ch_workq, ch_workq_wa[i], sizeof ch_workq_wa[i],
+                            CH_CFG_WORKQ_PRIO);
+  }
+#endif
+}
+
+/**
+ * @brief   Initializes a @p work_queue_t object.
+ * @note    The queue has no workers after initialization.
+ *
+ * @param[out] wqp      pointer to a @p work_queue_t structure
+ *
+ * @init
+ */
+void chWQObjectInit(work_queue_t *wqp) {
+
+  chDbgCheck(wqp != NULL);
+
+  wqp->head  = NULL;
+  wqp->depth = (cnt_t)0;
+  chThdQueueObjectInit(&wqp->workers);
+#if CH_DBG_STATISTICS == TRUE
+  wqp->stats.n_submitted = (ucnt_t)0;
+  wqp->stats.n_executed  = (ucnt_t)0;
+  wqp->stats.max_depth   = (cnt_t)0;
+  chTMObjectInit(&wqp->stats.latency);
+#endif
+}
+
+/**
+ * @brief   Creates a worker thread serving a work queue.
+ * @details The worker terminates when a termination request is sent to it
+ *          using @p chThdTerminate(), an idle worker notices the request
+ *          after @p chWQReset() is invoked on its queue.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure
+ * @param[out] wsp      pointer to a working area dedicated to the thread
+ *                      stack
+ * @param[in] size      size of the working area
+ * @param[in] prio      the priority level for the worker
+ * @return              The pointer to the @p thread_t structure allocated
+ *                      for the worker into the working space area.
+ *
+ * @api
+ */
+thread_t *chWQCreateWorker(work_queue_t *wqp, void *wsp, size_t size,
+                           tprio_t prio) {
+  thread_descriptor_t td = {
+    "worker",
+    (stkalign_t *)wsp,
+    (stkalign_t *)((uint8_t *)wsp + size),
+    prio,
+    wq_worker,
+    (void *)wqp
+  };
+
+  chDbgCheck(wqp != NULL);
+
+  return chThdCreate(&td);
+}
+
+/**
+ * @brief   Initializes a @p work_item_t object.
+ *
+ * @param[out] wip      pointer to a @p work_item_t structure
+ * @param[in] func      the work function
+ * @param[in] par       the work function parameter
+ * @param[in] prio      the item priority
+ *
+ * @init
+ */
+void chWQItemObjectInit(work_item_t *wip, wifunc_t func, void *par,
+                        tprio_t prio) {
+
+  chDbgCheck((wip != NULL) && (func != NULL));
+
+  wip->next = NULL;
+  wip->func = func;
+  wip->par  = par;
+  wip->prio = prio;
+  wip->wqp  = NULL;
+}
+
+/**
+ * @brief   Initializes a @p delayed_work_t object.
+ *
+ * @param[out] dwp      pointer to a @p delayed_work_t structure
+ * @param[in] func      the work function
+ * @param[in] par       the work function parameter
+ * @param[in] prio      the item priority
+ *
+ * @init
+ */
+void chWQDelayedObjectInit(delayed_work_t *dwp, wifunc_t func, void *par,
+                           tprio_t prio) {
+
+  chDbgCheck(dwp != NULL);
+
+  chWQItemObjectInit(&dwp->item, func, par, prio);
+  chVTObjectInit(&dwp->vt);
+}
+
+/**
+ * @brief   Submits a work item.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The operation status.
+ * @retval false        if the item was already pending.
+ * @retval true         if the item has been queued.
+ *
+ * @api
+ */
+bool chWQSubmit(work_queue_t *wqp, work_item_t *wip) {
+  bool b;
+
+  chSysLock();
+  b = chWQSubmitI(wqp, wip);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Submits a work item.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The operation status.
+ * @retval false        if the item was already pending.
+ * @retval true         if the item has been queued.
+ *
+ * @iclass
+ */
+bool chWQSubmitI(work_queue_t *wqp, work_item_t *wip) {
+
+  chDbgCheckClassI();
+
+#if CH_CFG_WORKQ_WORKERS > 0
+  if (wqp == NULL) {
+    wqp = &ch_workq;
+  }
+#endif
+
+  chDbgCheck((wqp != NULL) && (wip != NULL));
+
+  if (wip->wqp != NULL) {
+    return false;
+  }
+
+  wip->wqp = wqp;
+  wq_insert(wqp, wip);
+
+  return true;
+}
+
+/**
+ * @brief   Submits a delayed work item.
+ * @details The item is inserted in the queue when the delay expires.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ * @param[in] dwp       pointer to a @p delayed_work_t structure
+ * @param[in] delay     the delay in system ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE the item is queued immediately.
+ *                      .
+ * @return              The operation status.
+ * @retval false        if the item was already pending.
+ * @retval true         if the item has been scheduled.
+ *
+ * @api
+ */
+bool chWQSubmitDelayed(work_queue_t *wqp, delayed_work_t *dwp,
+                       systime_t delay) {
+  bool b;
+
+  chSysLock();
+  b = chWQSubmitDelayedI(wqp, dwp, delay);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Submits a delayed work item.
+ * @details The item is inserted in the queue when the delay expires.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ * @param[in] dwp       pointer to a @p delayed_work_t structure
+ * @param[in] delay     the delay in system ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE the item is queued immediately.
+ *                      .
+ * @return              The operation status.
+ * @retval false        if the item was already pending.
+ * @retval true         if the item has been scheduled.
+ *
+ * @iclass
+ */
+bool chWQSubmitDelayedI(work_queue_t *wqp, delayed_work_t *dwp,
+                        systime_t delay) {
+
+  chDbgCheckClassI();
+  chDbgCheck(dwp != NULL);
+
+  if (delay == TIME_IMMEDIATE) {
+    return chWQSubmitI(wqp, &dwp->item);
+  }
+
+#if CH_CFG_WORKQ_WORKERS > 0
+  if (wqp == NULL) {
+    wqp = &ch_workq;
+  }
+#endif
+
+  chDbgCheck(wqp != NULL);
+
+  if (dwp->item.wqp != NULL) {
+    return false;
+  }
+
+  dwp->item.wqp = wqp;
+  chVTDoSetI(&dwp->vt, delay, wq_delay_cb, (void *)&dwp->item);
+
+  return true;
+}
+
+/**
+ * @brief   Cancels a pending work item.
+ * @note    An item already taken by a worker cannot be canceled, its
+ *          function is executed anyway.
+ *
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The operation status.
+ * @retval false        if the item was not pending.
+ * @retval true         if the item has been removed from its queue.
+ *
+ * @api
+ */
+bool chWQCancel(work_item_t *wip) {
+  bool b;
+
+  chSysLock();
+  b = chWQCancelI(wip);
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Cancels a pending work item.
+ * @note    An item already taken by a worker cannot be canceled, its
+ *          function is executed anyway.
+ *
+ * @param[in] wip       pointer to a @p work_item_t structure
+ * @return              The operation status.
+ * @retval false        if the item was not pending.
+ * @retval true         if the item has been removed from its queue.
+ *
+ * @iclass
+ */
+bool chWQCancelI(work_item_t *wip) {
+
+  chDbgCheckClassI();
+  chDbgCheck(wip != NULL);
+
+  if (wip->wqp == NULL) {
+    return false;
+  }
+
+  return wq_remove(wip->wqp, wip);
+}
+
+/**
+ * @brief   Cancels a pending delayed work item.
+ * @details The item is canceled both if its delay is still running and if
+ *          it is already in the queue.
+ *
+ * @param[in] dwp       pointer to a @p delayed_work_t structure
+ * @return              The operation status.
+ * @retval false        if the item was not pending.
+ * @retval true         if the item has been canceled.
+ *
+ * @api
+ */
+bool chWQCancelDelayed(delayed_work_t *dwp) {
+  bool b;
+
+  chSysLock();
+  b = chWQCancelDelayedI(dwp);
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Cancels a pending delayed work item.
+ * @details The item is canceled both if its delay is still running and if
+ *          it is already in the queue.
+ *
+ * @param[in] dwp       pointer to a @p delayed_work_t structure
+ * @return              The operation status.
+ * @retval false        if the item was not pending.
+ * @retval true         if the item has been canceled.
+ *
+ * @iclass
+ */
+bool chWQCancelDelayedI(delayed_work_t *dwp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(dwp != NULL);
+
+  if (chVTIsArmedI(&dwp->vt)) {
+    chVTDoResetI(&dwp->vt);
+    dwp->item.wqp = NULL;
+    return true;
+  }
+
+  return chWQCancelI(&dwp->item);
+}
+
+/**
+ * @brief   Resets a work queue.
+ * @details All the pending items are removed from the queue and the idle
+ *          workers are woken up in order to check for termination
+ *          requests.
+ * @note    Delayed items whose delay is still running are not affected.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ *
+ * @api
+ */
+void chWQReset(work_queue_t *wqp) {
+
+  chSysLock();
+  chWQResetI(wqp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Resets a work queue.
+ * @details All the pending items are removed from the queue and the idle
+ *          workers are woken up in order to check for termination
+ *          requests.
+ * @note    Delayed items whose delay is still running are not affected.
+ *
+ * @param[in] wqp       pointer to a @p work_queue_t structure or @p NULL
+ *                      for the system work queue
+ *
+ * @iclass
+ */
+void chWQResetI(work_queue_t *wqp) {
+
+  chDbgCheckClassI();
+
+#if CH_CFG_WORKQ_WORKERS > 0
+  if (wqp == NULL) {
+    wqp = &ch_workq;
+  }
+#endif
+
+  chDbgCheck(wqp != NULL);
+
+  while (wqp->head != NULL) {
+    wqp->head->wqp = NULL;
+    wqp->head = wqp->head->next;
+  }
+  wqp->depth = (cnt_t)0;
+  chThdDequeueAllI(&wqp->workers, MSG_RESET);
+}
+
+#endif /* CH_CFG_USE_WORKQUEUES == TRUE */
+
+/** @} */
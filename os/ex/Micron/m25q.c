@@ -46,6 +46,31 @@
 #define CMD_SECTOR_ERASE                    M25Q_CMD_SECTOR_ERASE
 #endif
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+#define SUSPEND_ERASE_ATTR                  FLASH_ATTR_SUSPEND_ERASE_CAPABLE
+#else
+#define SUSPEND_ERASE_ATTR                  0
+#endif
+
+/* SFDP read dummy cycles, fixed regardless of the bus mode.*/
+#define SFDP_DUMMY_CYCLES                   8U
+
+/* SFDP little endian double word.*/
+#define SFDP_DWORD(p)                       ((uint32_t)(p)[0] |             \
+                                             ((uint32_t)(p)[1] << 8U) |     \
+                                             ((uint32_t)(p)[2] << 16U) |    \
+                                             ((uint32_t)(p)[3] << 24U))
+
+/* Conversions between system ticks and microseconds, truncating.*/
+#define TICKS2US(t)                                                         \
+  ((uint32_t)(((uint64_t)(t) * 1000000U) / (uint64_t)OSAL_ST_FREQUENCY))
+#define US2TICKS(us)                                                        \
+  ((systime_t)(((uint64_t)(us) * (uint64_t)OSAL_ST_FREQUENCY) / 1000000U))
+
+/* Operations shorter than this number of system ticks are not measured,
+   the tick resolution would make the measure meaningless.*/
+#define MEASURE_MIN_TICKS                   8U
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -64,6 +89,8 @@ static flash_error_t m25q_start_erase_sector(void *instance,
                                              flash_sector_t sector);
 static flash_error_t m25q_query_erase(void *instance, uint32_t *msec);
 static flash_error_t m25q_verify_erase(void *instance, flash_sector_t sector);
+static flash_error_t m25q_suspend_erase(void *instance);
+static flash_error_t m25q_resume_erase(void *instance);
 static flash_error_t m25q_read_sfdp(void *instance, flash_offset_t offset,
                                     size_t n, uint8_t *rp);
 
@@ -74,6 +101,7 @@ static const struct M25QDriverVMT m25q_vmt = {
   m25q_get_descriptor, m25q_read, m25q_program,
   m25q_start_erase_all, m25q_start_erase_sector,
   m25q_query_erase, m25q_verify_erase,
+  m25q_suspend_erase, m25q_resume_erase,
   m25q_read_sfdp
 };
 
@@ -82,7 +110,7 @@ static const struct M25QDriverVMT m25q_vmt = {
  */
 static flash_descriptor_t m25q_descriptor = {
   .attributes       = FLASH_ATTR_ERASED_IS_ONE | FLASH_ATTR_REWRITABLE |
-                      FLASH_ATTR_SUSPEND_ERASE_CAPABLE,
+                      SUSPEND_ERASE_ATTR,
   .page_size        = 256U,
   .sectors_count    = 0U,           /* It is overwritten.*/
   .sectors          = NULL,
@@ -286,17 +314,154 @@ void m25q_reset_memory(M25QDriver *devp) {
 }
 #endif /* JESD216_BUS_MODE != JESD216_BUS_MODE_SPI */
 
-static flash_error_t m25q_poll_status(M25QDriver *devp) {
+static void m25q_sfdp_receive(M25QDriver *devp, flash_offset_t offset,
+                              size_t n, uint8_t *rp) {
+
+#if JESD216_BUS_MODE != JESD216_BUS_MODE_SPI
+  jesd216_cmd_addr_dummy_receive(devp->config->busp,
+                                 M25Q_CMD_READ_DISCOVERY_PARAMETER,
+                                 offset, SFDP_DUMMY_CYCLES, n, rp);
+#else
+  /* In SPI mode the dummy cycles are received as a byte and discarded.*/
+  while (n > 0U) {
+    uint8_t buf[17];
+    size_t chunk = n > 16U ? 16U : n;
+
+    jesd216_cmd_addr_receive(devp->config->busp,
+                             M25Q_CMD_READ_DISCOVERY_PARAMETER,
+                             offset, chunk + 1U, buf);
+    memcpy(rp, &buf[1], chunk);
+
+    offset += chunk;
+    rp     += chunk;
+    n      -= chunk;
+  }
+#endif
+}
+
+static void m25q_sfdp_timings(M25QDriver *devp) {
+  static const uint32_t erase_units[4] = {1000U, 16000U, 128000U, 1000000U};
+  uint8_t buf[16];
+  flash_offset_t bfpt;
+  uint32_t dw;
+  unsigned i;
+
+  /* Defaults for devices not reporting the timings.*/
+  devp->program_time = (uint32_t)M25Q_PROGRAM_TIME;
+  devp->erase_time   = (uint32_t)M25Q_ERASE_TIME * 1000U;
+
+  /* SFDP header and first parameter header, the typical times are in the
+     basic flash parameters table DWORDs 10 and 11, JESD216A or later.*/
+  m25q_sfdp_receive(devp, 0U, 16U, buf);
+  if ((memcmp(buf, "SFDP", 4) != 0) || (buf[8] != 0x00U) || (buf[11] < 11U)) {
+    return;
+  }
+  bfpt = (flash_offset_t)buf[12] | ((flash_offset_t)buf[13] << 8U) |
+         ((flash_offset_t)buf[14] << 16U);
+
+  /* DWORDs from 8 to 11, erase types and typical times.*/
+  m25q_sfdp_receive(devp, bfpt + 28U, 16U, buf);
+
+  /* Page program time in 8 or 64 microseconds units.*/
+  dw = SFDP_DWORD(&buf[12]);
+  devp->program_time = (((dw >> 8U) & 0x1FU) + 1U) *
+                       ((dw & (1U << 13U)) != 0U ? 64U : 8U);
+
+  /* Erase time of the erase type matching the sector size.*/
+  dw = SFDP_DWORD(&buf[8]);
+  for (i = 0U; i < 4U; i++) {
+    uint8_t size = buf[i * 2U];
+
+    if ((size != 0U) && (size < 32U) && ((1UL << size) == SECTOR_SIZE)) {
+      uint32_t t = dw >> (4U + (i * 7U));
+
+      devp->erase_time = ((t & 0x1FU) + 1U) * erase_units[(t >> 5U) & 3U];
+      break;
+    }
+  }
+}
+
+static void m25q_update_time(uint32_t *timep, systime_t busy,
+                             systime_t done) {
+  uint32_t lower, upper;
+
+  if (done < (systime_t)MEASURE_MIN_TICKS) {
+    return;
+  }
+
+  /* The operation completed after the last busy status and before the
+     ready status.*/
+  lower = TICKS2US(busy);
+  upper = TICKS2US(done);
+
+  /* Longer times are averaged in. Shorter times are only upper bounds
+     because the completion could have happened earlier, the estimate is
+     lowered gradually but not below the last busy status.*/
+  if (lower >= *timep) {
+    *timep += (upper - *timep) / 8U;
+  }
+  else if (upper <= *timep) {
+    uint32_t t = *timep - (*timep / 16U);
+
+    *timep = t > lower ? t : lower;
+  }
+}
+
+static uint32_t m25q_erase_hint(M25QDriver *devp) {
+  uint32_t elapsed = TICKS2US(osalOsGetSystemTimeX() - devp->erase_start);
+  uint32_t us;
+
+  /* The remaining expected time, a fraction of the expected time when it
+     has already been exceeded.*/
+  if (elapsed < devp->erase_expected) {
+    us = devp->erase_expected - elapsed;
+  }
+  else {
+    us = devp->erase_expected / 64U;
+  }
+
+  return us >= 2000U ? us / 1000U : 1U;
+}
+
+static flash_error_t m25q_poll_status(M25QDriver *devp, uint32_t *timep) {
+  systime_t start = osalOsGetSystemTimeX();
+  systime_t busy = (systime_t)0;
+  systime_t ticks;
   uint8_t sts;
 
-  do {
+  /* Sleeping for most of the expected time, operations shorter than a
+     system tick are not slept at all.*/
+  ticks = US2TICKS(*timep - (*timep / 4U));
+  if (ticks > (systime_t)0) {
+    osalThreadSleep(ticks);
+  }
+
+  /* Read status command.*/
+  jesd216_cmd_receive(devp->config->busp, M25Q_CMD_READ_FLAG_STATUS_REGISTER,
+                      1, &sts);
+  if ((sts & M25Q_FLAGS_PROGRAM_ERASE) == 0U) {
+#if JESD216_HAS_AUTOPOLL == TRUE
+    /* The remaining time is polled by the hardware, the CPU is released
+       and the completion time is known within a system tick.*/
+    jesd216_cmd_poll(devp->config->busp, M25Q_CMD_READ_FLAG_STATUS_REGISTER,
+                     M25Q_FLAGS_PROGRAM_ERASE, M25Q_FLAGS_PROGRAM_ERASE);
+    jesd216_cmd_receive(devp->config->busp,
+                        M25Q_CMD_READ_FLAG_STATUS_REGISTER, 1, &sts);
+    busy = (systime_t)(osalOsGetSystemTimeX() - start - (systime_t)1);
+#else
+    do {
+      busy = (systime_t)(osalOsGetSystemTimeX() - start);
 #if M25Q_NICE_WAITING == TRUE
-    osalThreadSleepMilliseconds(1);
+      osalThreadSleep((systime_t)1);
 #endif
-    /* Read status command.*/
-    jesd216_cmd_receive(devp->config->busp, M25Q_CMD_READ_FLAG_STATUS_REGISTER,
-                        1, &sts);
-  } while ((sts & M25Q_FLAGS_PROGRAM_ERASE) == 0U);
+      jesd216_cmd_receive(devp->config->busp,
+                          M25Q_CMD_READ_FLAG_STATUS_REGISTER, 1, &sts);
+    } while ((sts & M25Q_FLAGS_PROGRAM_ERASE) == 0U);
+#endif
+  }
+
+  /* Expected time updated with the measured one.*/
+  m25q_update_time(timep, busy, (systime_t)(osalOsGetSystemTimeX() - start));
 
   /* Checking for errors.*/
   if ((sts & M25Q_FLAGS_ALL_ERRORS) != 0U) {
@@ -310,6 +475,105 @@ static flash_error_t m25q_poll_status(M25QDriver *devp) {
   return FLASH_NO_ERROR;
 }
 
+#if (M25Q_USE_ERASE_SUSPEND == TRUE) || defined(__DOXYGEN__)
+static bool m25q_erase_overlaps(M25QDriver *devp,
+                                flash_offset_t offset, size_t n) {
+
+  /* A bulk erase overlaps everything.*/
+  if (devp->erase_size == 0U) {
+    return true;
+  }
+
+  return (bool)(((size_t)offset < (size_t)devp->erase_offset +
+                                  (size_t)devp->erase_size) &&
+                ((size_t)devp->erase_offset < (size_t)offset + n));
+}
+
+static void m25q_erase_resume(M25QDriver *devp) {
+
+  /* Resume command.*/
+  jesd216_cmd(devp->config->busp, M25Q_CMD_PROGRAM_ERASE_RESUME);
+
+  devp->resumed = osalOsGetSystemTimeX();
+}
+
+static flash_error_t m25q_erase_suspend(M25QDriver *devp, bool *suspendedp) {
+  systime_t start, now;
+  uint8_t sts;
+
+  *suspendedp = false;
+
+  /* Bulk erase cannot be suspended.*/
+  if (devp->erase_size == 0U) {
+    return FLASH_BUSY_ERASING;
+  }
+
+#if M25Q_ERASE_MAX_SUSPENDS > 0
+  /* Suspensions limit for a single erase operation.*/
+  if (devp->suspends >= (uint32_t)M25Q_ERASE_MAX_SUSPENDS) {
+    return FLASH_BUSY_ERASING;
+  }
+#endif
+
+#if M25Q_ERASE_MIN_RUN_TIME > 0
+  {
+    /* The erase runs for a minimum time since the start or the last
+       resume, this guarantees forward progress.*/
+    systime_t elapsed = (systime_t)(osalOsGetSystemTimeX() - devp->resumed);
+    if (elapsed < OSAL_MS2ST(M25Q_ERASE_MIN_RUN_TIME)) {
+
+      /* The bus is not held during the wait, other devices on the same
+         bus can be accessed meanwhile.*/
+      jesd216_bus_release(devp->config->busp);
+      osalThreadSleep((systime_t)(OSAL_MS2ST(M25Q_ERASE_MIN_RUN_TIME) -
+                                  elapsed));
+      jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
+
+      /* The erase could have been finished or suspended by another
+         thread during the wait.*/
+      if (devp->state != FLASH_ERASE) {
+        return FLASH_NO_ERROR;
+      }
+    }
+  }
+#endif
+
+  /* Suspend command.*/
+  jesd216_cmd(devp->config->busp, M25Q_CMD_PROGRAM_ERASE_SUSPEND);
+
+  /* Waiting for the suspend latency, it is in the order of microseconds
+     so no nice waiting here. The wait is bounded by the maximum latency
+     plus one system tick.*/
+  start = osalOsGetSystemTimeX();
+  do {
+    now = osalOsGetSystemTimeX();
+    jesd216_cmd_receive(devp->config->busp, M25Q_CMD_READ_FLAG_STATUS_REGISTER,
+                        1, &sts);
+    if (((sts & M25Q_FLAGS_PROGRAM_ERASE) == 0U) &&
+        !osalOsIsTimeWithinX(now, start,
+                             start + OSAL_US2ST(M25Q_ERASE_SUSPEND_LATENCY) +
+                             (systime_t)1)) {
+
+      /* The device did not respond in time, the suspend is withdrawn so
+         that the erase is not left suspended.*/
+      m25q_erase_resume(devp);
+
+      return FLASH_ERROR_HW_FAILURE;
+    }
+  } while ((sts & M25Q_FLAGS_PROGRAM_ERASE) == 0U);
+
+  /* The erase could have been finished before the suspend command, in
+     that case there is nothing to resume.*/
+  if ((sts & M25Q_FLAGS_ERASE_SUSPEND) != 0U) {
+    devp->suspends++;
+    devp->erase_timed = false;
+    *suspendedp = true;
+  }
+
+  return FLASH_NO_ERROR;
+}
+#endif /* M25Q_USE_ERASE_SUSPEND == TRUE */
+
 static const flash_descriptor_t *m25q_get_descriptor(void *instance) {
   M25QDriver *devp = (M25QDriver *)instance;
 
@@ -323,21 +587,47 @@ static const flash_descriptor_t *m25q_get_descriptor(void *instance) {
 static flash_error_t m25q_read(void *instance, flash_offset_t offset,
                                size_t n, uint8_t *rp) {
   M25QDriver *devp = (M25QDriver *)instance;
+  flash_state_t state;
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  bool suspended = false;
+#endif
 
   osalDbgCheck((instance != NULL) && (rp != NULL) && (n > 0U));
   osalDbgCheck((size_t)offset + n <= (size_t)m25q_descriptor.sectors_count *
                                      (size_t)m25q_descriptor.sectors_size);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* The area being erased cannot be read until the erase is finished.*/
+  if ((devp->state != FLASH_READY) && m25q_erase_overlaps(devp, offset, n)) {
+    return FLASH_BUSY_ERASING;
+  }
+#else
   if (devp->state == FLASH_ERASE) {
     return FLASH_BUSY_ERASING;
   }
+#endif
 
   /* Bus acquired.*/
   jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
 
-  /* FLASH_READY state while the operation is performed.*/
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* An erase in progress is suspended for the duration of the read.*/
+  if (devp->state == FLASH_ERASE) {
+    flash_error_t err = m25q_erase_suspend(devp, &suspended);
+    if (err != FLASH_NO_ERROR) {
+
+      /* Bus released.*/
+      jesd216_bus_release(devp->config->busp);
+
+      return err;
+    }
+  }
+#endif
+
+  /* FLASH_READ state while the operation is performed.*/
+  state = devp->state;
   devp->state = FLASH_READ;
 
 #if JESD216_BUS_MODE != JESD216_BUS_MODE_SPI
@@ -350,8 +640,15 @@ static flash_error_t m25q_read(void *instance, flash_offset_t offset,
                            offset, n, rp);
 #endif
 
-  /* Ready state again.*/
-  devp->state = FLASH_READY;
+  /* Previous state again.*/
+  devp->state = state;
+
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* Resuming the erase suspended by this operation.*/
+  if (suspended) {
+    m25q_erase_resume(devp);
+  }
+#endif
 
   /* Bus released.*/
   jesd216_bus_release(devp->config->busp);
@@ -362,26 +659,52 @@ static flash_error_t m25q_read(void *instance, flash_offset_t offset,
 static flash_error_t m25q_program(void *instance, flash_offset_t offset,
                                   size_t n, const uint8_t *pp) {
   M25QDriver *devp = (M25QDriver *)instance;
+  flash_state_t state;
+  flash_error_t err = FLASH_NO_ERROR;
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  bool suspended = false;
+#endif
 
   osalDbgCheck((instance != NULL) && (pp != NULL) && (n > 0U));
   osalDbgCheck((size_t)offset + n <= (size_t)m25q_descriptor.sectors_count *
                                      (size_t)m25q_descriptor.sectors_size);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* The area being erased cannot be programmed.*/
+  if ((devp->state != FLASH_READY) && m25q_erase_overlaps(devp, offset, n)) {
+    return FLASH_BUSY_ERASING;
+  }
+#else
   if (devp->state == FLASH_ERASE) {
     return FLASH_BUSY_ERASING;
   }
+#endif
 
   /* Bus acquired.*/
   jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* An erase in progress is suspended for the duration of the program.*/
+  if (devp->state == FLASH_ERASE) {
+    err = m25q_erase_suspend(devp, &suspended);
+    if (err != FLASH_NO_ERROR) {
+
+      /* Bus released.*/
+      jesd216_bus_release(devp->config->busp);
+
+      return err;
+    }
+  }
+#endif
+
   /* FLASH_PGM state while the operation is performed.*/
+  state = devp->state;
   devp->state = FLASH_PGM;
 
   /* Data is programmed page by page.*/
   while (n > 0U) {
-    flash_error_t err;
 
     /* Data size that can be written in a single program page operation.*/
     size_t chunk = (size_t)(((offset | PAGE_MASK) + 1U) - offset);
@@ -397,13 +720,9 @@ static flash_error_t m25q_program(void *instance, flash_offset_t offset,
                           chunk, pp);
 
     /* Wait for status and check errors.*/
-    err = m25q_poll_status(devp);
+    err = m25q_poll_status(devp, &devp->program_time);
     if (err != FLASH_NO_ERROR) {
-
-      /* Bus released.*/
-      jesd216_bus_release(devp->config->busp);
-
-      return err;
+      break;
     }
 
     /* Next page.*/
@@ -412,23 +731,30 @@ static flash_error_t m25q_program(void *instance, flash_offset_t offset,
     n      -= chunk;
   }
 
-  /* Ready state again.*/
-  devp->state = FLASH_READY;
+  /* Previous state again.*/
+  devp->state = state;
+
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* Resuming the erase suspended by this operation.*/
+  if (suspended) {
+    m25q_erase_resume(devp);
+  }
+#endif
 
   /* Bus released.*/
   jesd216_bus_release(devp->config->busp);
 
-  return FLASH_NO_ERROR;
+  return err;
 }
 
 static flash_error_t m25q_start_erase_all(void *instance) {
   M25QDriver *devp = (M25QDriver *)instance;
 
   osalDbgCheck(instance != NULL);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
-  if (devp->state == FLASH_ERASE) {
+  if (devp->state != FLASH_READY) {
     return FLASH_BUSY_ERASING;
   }
 
@@ -438,12 +764,24 @@ static flash_error_t m25q_start_erase_all(void *instance) {
   /* FLASH_ERASE state while the operation is performed.*/
   devp->state = FLASH_ERASE;
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* A bulk erase cannot be suspended.*/
+  devp->erase_offset = 0U;
+  devp->erase_size   = 0U;
+#endif
+
   /* Enabling write operation.*/
   jesd216_cmd(devp->config->busp, M25Q_CMD_WRITE_ENABLE);
 
   /* Bulk erase command.*/
   jesd216_cmd(devp->config->busp, M25Q_CMD_BULK_ERASE);
 
+  /* Expected time, bulk erases are not measured.*/
+  devp->erase_start    = osalOsGetSystemTimeX();
+  devp->erase_busy     = (systime_t)0;
+  devp->erase_expected = devp->erase_time * m25q_descriptor.sectors_count;
+  devp->erase_timed    = false;
+
   /* Bus released.*/
   jesd216_bus_release(devp->config->busp);
 
@@ -457,10 +795,10 @@ static flash_error_t m25q_start_erase_sector(void *instance,
 
   osalDbgCheck(instance != NULL);
   osalDbgCheck(sector < m25q_descriptor.sectors_count);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
-  if (devp->state == FLASH_ERASE) {
+  if (devp->state != FLASH_READY) {
     return FLASH_BUSY_ERASING;
   }
 
@@ -470,11 +808,25 @@ static flash_error_t m25q_start_erase_sector(void *instance,
   /* FLASH_ERASE state while the operation is performed.*/
   devp->state = FLASH_ERASE;
 
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* Erased area and suspensions accounting.*/
+  devp->erase_offset = offset;
+  devp->erase_size   = SECTOR_SIZE;
+  devp->suspends     = 0U;
+  devp->resumed      = osalOsGetSystemTimeX();
+#endif
+
   /* Enabling write operation.*/
   jesd216_cmd(devp->config->busp, M25Q_CMD_WRITE_ENABLE);
 
   /* Sector erase command.*/
-  jesd216_cmd_addr(devp->config->busp, M25Q_CMD_SECTOR_ERASE, offset);
+  jesd216_cmd_addr(devp->config->busp, CMD_SECTOR_ERASE, offset);
+
+  /* Expected time.*/
+  devp->erase_start    = osalOsGetSystemTimeX();
+  devp->erase_busy     = (systime_t)0;
+  devp->erase_expected = devp->erase_time;
+  devp->erase_timed    = true;
 
   /* Bus released.*/
   jesd216_bus_release(devp->config->busp);
@@ -491,10 +843,10 @@ static flash_error_t m25q_verify_erase(void *instance,
 
   osalDbgCheck(instance != NULL);
   osalDbgCheck(sector < m25q_descriptor.sectors_count);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
-  if (devp->state == FLASH_ERASE) {
+  if (devp->state != FLASH_READY) {
     return FLASH_BUSY_ERASING;
   }
 
@@ -551,11 +903,11 @@ static flash_error_t m25q_query_erase(void *instance, uint32_t *msec) {
   uint8_t sts;
 
   osalDbgCheck(instance != NULL);
-  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE),
-                "invalid state");
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
 
   /* If there is an erase in progress then the device must be checked.*/
-  if (devp->state == FLASH_ERASE) {
+  if ((devp->state == FLASH_ERASE) || (devp->state == FLASH_SUSPENDED)) {
 
     /* Bus acquired.*/
     jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
@@ -572,10 +924,13 @@ static flash_error_t m25q_query_erase(void *instance, uint32_t *msec) {
       /* Bus released.*/
       jesd216_bus_release(devp->config->busp);
 
-      /* Recommended time before polling again, this is a simplified
-         implementation.*/
+      /* Time of the last busy status, the erase completes later.*/
+      devp->erase_busy = (systime_t)(osalOsGetSystemTimeX() -
+                                     devp->erase_start);
+
+      /* Recommended time before polling again.*/
       if (msec != NULL) {
-        *msec = 1U;
+        *msec = m25q_erase_hint(devp);
       }
 
       return FLASH_BUSY_ERASING;
@@ -584,12 +939,21 @@ static flash_error_t m25q_query_erase(void *instance, uint32_t *msec) {
     /* The device is ready to accept commands.*/
     devp->state = FLASH_READY;
 
+    /* Expected time updated with the measured one.*/
+    if (devp->erase_timed) {
+      m25q_update_time(&devp->erase_time, devp->erase_busy,
+                       (systime_t)(osalOsGetSystemTimeX() - devp->erase_start));
+    }
+
     /* Checking for errors.*/
     if ((sts & M25Q_FLAGS_ALL_ERRORS) != 0U) {
 
       /* Clearing status register.*/
       jesd216_cmd(devp->config->busp, M25Q_CMD_CLEAR_FLAG_STATUS_REGISTER);
 
+      /* Bus released.*/
+      jesd216_bus_release(devp->config->busp);
+
       /* Erase operation failed.*/
       return FLASH_ERROR_ERASE;
     }
@@ -601,13 +965,97 @@ static flash_error_t m25q_query_erase(void *instance, uint32_t *msec) {
   return FLASH_NO_ERROR;
 }
 
+static flash_error_t m25q_suspend_erase(void *instance) {
+  M25QDriver *devp = (M25QDriver *)instance;
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  flash_error_t err;
+  bool suspended;
+#endif
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
+
+  if (devp->state != FLASH_ERASE) {
+    return FLASH_NO_ERROR;
+  }
+
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  /* Bus acquired.*/
+  jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
+
+  err = m25q_erase_suspend(devp, &suspended);
+
+  /* Bus released.*/
+  jesd216_bus_release(devp->config->busp);
+
+  if (err != FLASH_NO_ERROR) {
+    return err;
+  }
+
+  /* If the erase finished before the suspend command then its outcome is
+     returned.*/
+  if (!suspended) {
+    return m25q_query_erase(instance, NULL);
+  }
+
+  devp->state = FLASH_SUSPENDED;
+
+  return FLASH_NO_ERROR;
+#else
+  return FLASH_BUSY_ERASING;
+#endif
+}
+
+static flash_error_t m25q_resume_erase(void *instance) {
+  M25QDriver *devp = (M25QDriver *)instance;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
+
+#if M25Q_USE_ERASE_SUSPEND == TRUE
+  if (devp->state == FLASH_SUSPENDED) {
+
+    /* Bus acquired.*/
+    jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
+
+    m25q_erase_resume(devp);
+    devp->state = FLASH_ERASE;
+
+    /* Bus released.*/
+    jesd216_bus_release(devp->config->busp);
+  }
+#endif
+
+  return FLASH_NO_ERROR;
+}
+
 static flash_error_t m25q_read_sfdp(void *instance, flash_offset_t offset,
                                     size_t n, uint8_t *rp) {
+  M25QDriver *devp = (M25QDriver *)instance;
+
+  osalDbgCheck((instance != NULL) && (rp != NULL) && (n > 0U));
+  osalDbgAssert((devp->state == FLASH_READY) || (devp->state == FLASH_ERASE) ||
+                (devp->state == FLASH_SUSPENDED), "invalid state");
+
+  if (devp->state != FLASH_READY) {
+    return FLASH_BUSY_ERASING;
+  }
+
+  /* Bus acquired.*/
+  jesd216_bus_acquire(devp->config->busp, devp->config->buscfg);
+
+  /* FLASH_READ state while the operation is performed.*/
+  devp->state = FLASH_READ;
 
-  (void)instance;
-  (void)rp;
-  (void)offset;
-  (void)n;
+  m25q_sfdp_receive(devp, offset, n, rp);
+
+  /* Ready state again.*/
+  devp->state = FLASH_READY;
+
+  /* Bus released.*/
+  jesd216_bus_release(devp->config->busp);
 
   return FLASH_NO_ERROR;
 }
@@ -716,6 +1164,9 @@ void m25qStart(M25QDriver *devp, const M25QConfig *config) {
     }
 #endif
 
+    /* Initial estimates of the operation times.*/
+    m25q_sfdp_timings(devp);
+
     /* Driver in ready state.*/
     devp->state = FLASH_READY;
 
@@ -147,6 +147,9 @@
  * @details If enabled this options inserts delays into the flash waiting
  *          routines releasing some extra CPU time for threads with lower
  *          priority, this may slow down the driver a bit however.
+ * @note    Program operations always sleep for most of their expected
+ *          time, this option affects the polling of the remaining part
+ *          when the hardware status polling is not available.
  */
 #if !defined(M25Q_NICE_WAITING) || defined(__DOXYGEN__)
 #define M25Q_NICE_WAITING                   TRUE
@@ -159,6 +162,31 @@
 #define M25Q_USE_SUB_SECTORS                FALSE
 #endif
 
+/**
+ * @brief   Typical page program time in microseconds.
+ * @details This is the initial estimate of the page program time when the
+ *          device does not report it in its SFDP tables, the estimate is
+ *          then refined with the measured times.
+ */
+#if !defined(M25Q_PROGRAM_TIME) || defined(__DOXYGEN__)
+#define M25Q_PROGRAM_TIME                   500
+#endif
+
+/**
+ * @brief   Typical sector erase time in milliseconds.
+ * @details This is the initial estimate of the sector erase time when the
+ *          device does not report it in its SFDP tables, the estimate is
+ *          then refined with the measured times.
+ * @note    The default depends on the @p M25Q_USE_SUB_SECTORS setting.
+ */
+#if !defined(M25Q_ERASE_TIME) || defined(__DOXYGEN__)
+#if (M25Q_USE_SUB_SECTORS == TRUE) && !defined(__DOXYGEN__)
+#define M25Q_ERASE_TIME                     250
+#else
+#define M25Q_ERASE_TIME                     700
+#endif
+#endif
+
 /**
  * @brief   Supported JEDEC manufacturer identifiers.
  */
@@ -183,6 +211,48 @@
 #if !defined(M25Q_COMPARE_BUFFER_SIZE) || defined(__DOXYGEN__)
 #define M25Q_COMPARE_BUFFER_SIZE            32
 #endif
+
+/**
+ * @brief   Erase suspend support.
+ * @details If enabled then reads and programs issued while a sector erase
+ *          is in progress transparently suspend the erase, perform the
+ *          operation and resume the erase.
+ */
+#if !defined(M25Q_USE_ERASE_SUSPEND) || defined(__DOXYGEN__)
+#define M25Q_USE_ERASE_SUSPEND              FALSE
+#endif
+
+/**
+ * @brief   Maximum erase suspend latency in microseconds.
+ * @details Time from the suspend command to the device becoming ready,
+ *          the driver reports @p FLASH_ERROR_HW_FAILURE if the device is
+ *          still busy after this time.
+ * @note    The default is the datasheet maximum.
+ */
+#if !defined(M25Q_ERASE_SUSPEND_LATENCY) || defined(__DOXYGEN__)
+#define M25Q_ERASE_SUSPEND_LATENCY          30
+#endif
+
+/**
+ * @brief   Minimum erase run time between suspensions in milliseconds.
+ * @details A suspension requested earlier than this time after the erase
+ *          start or the last resume waits for the remaining time, this
+ *          guarantees forward progress to erase operations under frequent
+ *          reads.
+ */
+#if !defined(M25Q_ERASE_MIN_RUN_TIME) || defined(__DOXYGEN__)
+#define M25Q_ERASE_MIN_RUN_TIME             1
+#endif
+
+/**
+ * @brief   Maximum number of suspensions of a single erase operation.
+ * @details When the limit is reached operations return
+ *          @p FLASH_BUSY_ERASING until the erase is finished, zero means
+ *          no limit.
+ */
+#if !defined(M25Q_ERASE_MAX_SUSPENDS) || defined(__DOXYGEN__)
+#define M25Q_ERASE_MAX_SUSPENDS             0
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -197,6 +267,26 @@
 #error "invalid M25Q_COMPARE_BUFFER_SIZE value"
 #endif
 
+#if M25Q_ERASE_MIN_RUN_TIME < 0
+#error "invalid M25Q_ERASE_MIN_RUN_TIME value"
+#endif
+
+#if M25Q_ERASE_SUSPEND_LATENCY < 1
+#error "invalid M25Q_ERASE_SUSPEND_LATENCY value"
+#endif
+
+#if M25Q_PROGRAM_TIME < 1
+#error "invalid M25Q_PROGRAM_TIME value"
+#endif
+
+#if M25Q_ERASE_TIME < 1
+#error "invalid M25Q_ERASE_TIME value"
+#endif
+
+#if M25Q_ERASE_MAX_SUSPENDS < 0
+#error "invalid M25Q_ERASE_MAX_SUSPENDS value"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -242,6 +332,54 @@ typedef struct {
    * @brief   Device ID and unique ID.
    */
   uint8_t                       device_id[20];
+  /**
+   * @brief   Expected page program time in microseconds.
+   * @details Initialized from the SFDP tables or @p M25Q_PROGRAM_TIME then
+   *          updated with the measured program times.
+   */
+  uint32_t                      program_time;
+  /**
+   * @brief   Expected sector erase time in microseconds.
+   * @details Initialized from the SFDP tables or @p M25Q_ERASE_TIME then
+   *          updated with the measured erase times.
+   */
+  uint32_t                      erase_time;
+  /**
+   * @brief   Expected duration of the erase in progress in microseconds.
+   */
+  uint32_t                      erase_expected;
+  /**
+   * @brief   Start time of the erase in progress.
+   */
+  systime_t                     erase_start;
+  /**
+   * @brief   Time since the erase start of the last busy status.
+   */
+  systime_t                     erase_busy;
+  /**
+   * @brief   The erase in progress is measured.
+   * @note    Bulk erases and suspended erases are not measured.
+   */
+  bool                          erase_timed;
+#if (M25Q_USE_ERASE_SUSPEND == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Offset of the area being erased.
+   */
+  flash_offset_t                erase_offset;
+  /**
+   * @brief   Size of the area being erased.
+   * @note    Zero for a bulk erase, it cannot be suspended.
+   */
+  uint32_t                      erase_size;
+  /**
+   * @brief   Number of suspensions of the current erase operation.
+   */
+  uint32_t                      suspends;
+  /**
+   * @brief   Time of the erase start or of the last resume.
+   */
+  systime_t                     resumed;
+#endif
 } M25QDriver;
 
 /*===========================================================================*/
@@ -1,8 +1,10 @@
 # List of all the m25Q device files.
-M25QSRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_flash.c \
-           $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_jesd216_flash.c \
+M25QSRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_jesd216_flash.c \
            $(CHIBIOS)/os/ex/Micron/m25q.c
 
 # Required include directories
 M25QINC := $(CHIBIOS)/os/hal/lib/peripherals/flash \
-           $(CHIBIOS)/os/ex/Micron
\ No newline at end of file
+           $(CHIBIOS)/os/ex/Micron
+
+# Simulated device, simulator platforms only.
+M25QSIMSRC := $(CHIBIOS)/os/ex/Micron/m25q_sim.c
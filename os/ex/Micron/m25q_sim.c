@@ -0,0 +1,447 @@
+/*
+    ChibiOS - Copyright (C) 2016 Giovanni Di Sirio
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    m25q_sim.c
+ * @brief   Simulated Micron serial flash device code.
+ * @details The simulated device decodes the commands issued by the M25Q
+ *          driver through the simulated QSPI driver and reproduces the
+ *          device timings. Program and erase operations keep the device
+ *          busy for the configured times, erase operations can be
+ *          suspended and resumed. The typical times are also reported in
+ *          the SFDP basic flash parameters table.
+ *
+ * @addtogroup M25Q_SIM
+ * @ingroup EX_MICRON
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "m25q_sim.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define PAGE_SIZE                           256U
+#define PAGE_MASK                           (PAGE_SIZE - 1U)
+#define SUBSECTOR_SIZE                      0x00001000U
+#define SECTOR_SIZE                         0x00010000U
+
+/* SFDP header, one parameter header and the basic flash parameters
+   table.*/
+#define SFDP_SIZE                           (16U + (16U * 4U))
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static void m25qsim_update(M25QSimDevice *simp) {
+  systime_t now = osalOsGetSystemTimeX();
+
+  /* Simulated time advances with the system time.*/
+  simp->time += ((uint64_t)(systime_t)(now - simp->last) * 1000000U) /
+                (uint64_t)OSAL_ST_FREQUENCY;
+  simp->last = now;
+
+  if (simp->programming && (simp->time >= simp->program_end)) {
+    simp->programming = false;
+  }
+
+  /* The memory array is erased when the operation is finished, before
+     that the area content is undefined.*/
+  if (simp->erasing && !simp->suspended && (simp->time >= simp->erase_end)) {
+    memset(simp->config->storage + simp->erase_offset, 0xFF,
+           (size_t)simp->erase_size);
+    simp->erasing = false;
+    simp->erases++;
+  }
+}
+
+static bool m25qsim_is_busy(M25QSimDevice *simp) {
+
+  return (bool)(simp->programming ||
+                (simp->erasing && !simp->suspended) ||
+                (simp->suspended && (simp->time < simp->suspend_end)));
+}
+
+static bool m25qsim_is_erase_suspended(M25QSimDevice *simp,
+                                       uint32_t offset, size_t n) {
+
+  return (bool)(simp->erasing && simp->suspended &&
+                ((size_t)offset < (size_t)simp->erase_offset +
+                                  (size_t)simp->erase_size) &&
+                ((size_t)simp->erase_offset < (size_t)offset + n));
+}
+
+static uint32_t m25qsim_sfdp_time(uint32_t time,
+                                  const uint32_t *units, unsigned nunits) {
+  uint32_t count;
+  unsigned u;
+
+  /* Smallest unit able to represent the time in a 5 bits count, the time
+     is rounded up.*/
+  for (u = 0U; u < nunits - 1U; u++) {
+    if (((time + units[u] - 1U) / units[u]) <= 32U) {
+      break;
+    }
+  }
+  count = (time + units[u] - 1U) / units[u];
+  if (count < 1U) {
+    count = 1U;
+  }
+  if (count > 32U) {
+    count = 32U;
+  }
+
+  return (count - 1U) | ((uint32_t)u << 5U);
+}
+
+static void m25qsim_sfdp(M25QSimDevice *simp, uint32_t offset,
+                         size_t n, uint8_t *rxbuf) {
+  static const uint32_t program_units[2] = {8U, 64U};
+  static const uint32_t erase_units[4] = {1000U, 16000U, 128000U, 1000000U};
+  static const uint32_t bulk_units[4] = {16000U, 256000U, 4000000U,
+                                         64000000U};
+  static const uint8_t headers[16] = {
+    'S', 'F', 'D', 'P', 0x06U, 0x01U, 0x00U, 0xFFU,
+    0x00U, 0x06U, 0x01U, 16U, 0x10U, 0x00U, 0x00U, 0xFFU
+  };
+  const M25QSimConfig *cfg = simp->config;
+  uint8_t sfdp[SFDP_SIZE];
+  uint32_t dw[16];
+  unsigned i;
+
+  /* Basic flash parameters table, only the DWORDs describing the density,
+     the erase types and the typical times are meaningful.*/
+  for (i = 0U; i < 16U; i++) {
+    dw[i] = 0xFFFFFFFFU;
+  }
+  dw[0]  = 0xFFF320E5U;
+  dw[1]  = (cfg->size * 8U) - 1U;
+  dw[7]  = 0xD810200CU;
+  dw[8]  = 0x00000000U;
+  dw[9]  = 0x00000001U |
+           (m25qsim_sfdp_time(cfg->subsector_erase_time, erase_units, 4U) <<
+            4U) |
+           (m25qsim_sfdp_time(cfg->sector_erase_time, erase_units, 4U) <<
+            11U);
+  dw[10] = 0x00000081U |
+           (m25qsim_sfdp_time(cfg->page_program_time, program_units, 2U) <<
+            8U) |
+           (m25qsim_sfdp_time(cfg->bulk_erase_time, bulk_units, 4U) << 24U);
+
+  memcpy(sfdp, headers, sizeof headers);
+  for (i = 0U; i < 16U; i++) {
+    sfdp[16U + (i * 4U) + 0U] = (uint8_t)(dw[i] >> 0U);
+    sfdp[16U + (i * 4U) + 1U] = (uint8_t)(dw[i] >> 8U);
+    sfdp[16U + (i * 4U) + 2U] = (uint8_t)(dw[i] >> 16U);
+    sfdp[16U + (i * 4U) + 3U] = (uint8_t)(dw[i] >> 24U);
+  }
+
+  /* Undefined locations read as an idle bus.*/
+  while (n > 0U) {
+    *rxbuf++ = offset < SFDP_SIZE ? sfdp[offset] : 0xFFU;
+    offset++;
+    n--;
+  }
+}
+
+static void m25qsim_read(M25QSimDevice *simp, uint32_t offset,
+                         size_t n, uint8_t *rxbuf) {
+  uint32_t mask = simp->config->size - 1U;
+
+  /* Data in the area being erased is undefined.*/
+  if (m25qsim_is_erase_suspended(simp, offset, n)) {
+    simp->violations++;
+  }
+
+  while (n > 0U) {
+    *rxbuf++ = simp->config->storage[offset & mask];
+    offset++;
+    n--;
+  }
+}
+
+static void m25qsim_program(M25QSimDevice *simp, uint32_t offset,
+                            size_t n, const uint8_t *txbuf) {
+  uint32_t page = offset & ~PAGE_MASK;
+
+  simp->programs++;
+
+  /* The area being erased cannot be programmed.*/
+  if (m25qsim_is_erase_suspended(simp, page, PAGE_SIZE)) {
+    simp->errors |= M25Q_FLAGS_PROGRAM_ERROR;
+    simp->violations++;
+    return;
+  }
+
+  /* Bits can only go from one to zero, the address wraps within the
+     page.*/
+  while (n > 0U) {
+    simp->config->storage[page | (offset & PAGE_MASK)] &= *txbuf++;
+    offset++;
+    n--;
+  }
+
+  simp->programming = true;
+  simp->program_end = simp->time + simp->config->page_program_time;
+}
+
+static void m25qsim_erase(M25QSimDevice *simp, uint32_t offset,
+                          uint32_t size, uint32_t time) {
+
+  simp->erasing      = true;
+  simp->suspended    = false;
+  simp->erase_offset = offset & ~(size - 1U);
+  simp->erase_size   = size;
+  simp->erase_end    = simp->time + time;
+}
+
+static void m25qsim_suspend(M25QSimDevice *simp) {
+  uint64_t end = simp->time + simp->config->suspend_latency;
+
+  /* Bulk erase cannot be suspended, an erase finishing within the
+     latency time is not suspended.*/
+  if (!simp->erasing || simp->suspended ||
+      (simp->erase_size == simp->config->size) ||
+      (simp->erase_end <= end)) {
+    return;
+  }
+
+  simp->suspended   = true;
+  simp->suspend_end = end;
+  simp->erase_left  = simp->erase_end - end;
+  simp->suspends++;
+}
+
+static void m25qsim_resume(M25QSimDevice *simp) {
+  uint64_t start;
+
+  if (!simp->suspended) {
+    return;
+  }
+
+  /* Each resume adds some erase time, erases suspended too often do not
+     progress.*/
+  start = simp->time > simp->suspend_end ? simp->time : simp->suspend_end;
+  simp->suspended = false;
+  simp->erase_end = start + simp->erase_left + simp->config->resume_penalty;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an instance.
+ *
+ * @param[out] simp     pointer to the @p M25QSimDevice object
+ *
+ * @init
+ */
+void m25qsimObjectInit(M25QSimDevice *simp) {
+
+  osalDbgCheck(simp != NULL);
+
+  memset(simp, 0, sizeof (M25QSimDevice));
+}
+
+/**
+ * @brief   Powers up the simulated device.
+ * @note    The memory array content is preserved.
+ *
+ * @param[in] simp      pointer to the @p M25QSimDevice object
+ * @param[in] config    pointer to the configuration
+ *
+ * @api
+ */
+void m25qsimStart(M25QSimDevice *simp, const M25QSimConfig *config) {
+
+  osalDbgCheck((simp != NULL) && (config != NULL));
+  osalDbgCheck((config->storage != NULL) && (config->size >= SECTOR_SIZE) &&
+               ((config->size & (config->size - 1U)) == 0U));
+
+  m25qsimObjectInit(simp);
+  simp->config = config;
+  simp->last   = osalOsGetSystemTimeX();
+}
+
+/**
+ * @brief   Performs a bus transaction on the simulated device.
+ * @details This function is meant to be invoked by the exchange function
+ *          of the simulated QSPI driver.
+ *
+ * @param[in] simp      pointer to the @p M25QSimDevice object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] n         number of bytes in the data phase
+ * @param[in] txbuf     transmit buffer or @p NULL
+ * @param[out] rxbuf    receive buffer or @p NULL
+ *
+ * @notapi
+ */
+void m25qsimExchange(M25QSimDevice *simp, const qspi_command_t *cmdp,
+                     size_t n, const uint8_t *txbuf, uint8_t *rxbuf) {
+  uint8_t cmd = (uint8_t)(cmdp->cfg & QSPI_CFG_CMD_MASK);
+  uint32_t offset = cmdp->addr & (simp->config->size - 1U);
+  bool reset_enabled = simp->reset_enabled;
+
+  osalDbgCheck(simp->config != NULL);
+
+  m25qsim_update(simp);
+
+  /* Received data defaults to an idle bus.*/
+  if (rxbuf != NULL) {
+    memset(rxbuf, 0xFF, n);
+  }
+
+  /* Transactions without command phase are XIP reads, not simulated.*/
+  if ((cmdp->cfg & QSPI_CFG_CMD_MODE_MASK) == QSPI_CFG_CMD_MODE_NONE) {
+    return;
+  }
+
+  simp->reset_enabled = false;
+
+  /* Commands accepted while the device is busy.*/
+  switch (cmd) {
+  case M25Q_CMD_READ_STATUS_REGISTER:
+    if (rxbuf != NULL) {
+      rxbuf[0] = (uint8_t)((m25qsim_is_busy(simp) ? 0x01U : 0x00U) |
+                           (simp->wel ? 0x02U : 0x00U));
+    }
+    return;
+  case M25Q_CMD_READ_FLAG_STATUS_REGISTER:
+    if (rxbuf != NULL) {
+      rxbuf[0] = simp->errors;
+      if (!m25qsim_is_busy(simp)) {
+        rxbuf[0] |= M25Q_FLAGS_PROGRAM_ERASE;
+      }
+      if (simp->suspended) {
+        rxbuf[0] |= M25Q_FLAGS_ERASE_SUSPEND;
+      }
+    }
+    return;
+  case M25Q_CMD_PROGRAM_ERASE_SUSPEND:
+    m25qsim_suspend(simp);
+    return;
+  default:
+    break;
+  }
+
+  if (m25qsim_is_busy(simp)) {
+    simp->violations++;
+    return;
+  }
+
+  switch (cmd) {
+  case M25Q_CMD_RESET_ENABLE:
+    simp->reset_enabled = true;
+    break;
+  case M25Q_CMD_RESET_MEMORY:
+    if (reset_enabled) {
+      simp->wel       = false;
+      simp->errors    = 0U;
+      simp->erasing   = false;
+      simp->suspended = false;
+    }
+    break;
+  case M25Q_CMD_READ_ID:
+  case M25Q_CMD_MULTIPLE_IO_READ_ID:
+    if ((rxbuf != NULL) && (n >= 3U)) {
+      uint32_t size;
+
+      memset(rxbuf, 0x00, n);
+      rxbuf[0] = 0x20U;
+      rxbuf[1] = 0xBAU;
+      for (size = 1U; (1U << size) < simp->config->size; size++) {
+      }
+      rxbuf[2] = (uint8_t)size;
+    }
+    break;
+  case M25Q_CMD_READ:
+  case M25Q_CMD_FAST_READ:
+    if (rxbuf != NULL) {
+      m25qsim_read(simp, offset, n, rxbuf);
+    }
+    break;
+  case M25Q_CMD_READ_DISCOVERY_PARAMETER:
+    if (rxbuf != NULL) {
+      m25qsim_sfdp(simp, cmdp->addr, n, rxbuf);
+    }
+    break;
+  case M25Q_CMD_WRITE_ENABLE:
+    simp->wel = true;
+    break;
+  case M25Q_CMD_WRITE_DISABLE:
+    simp->wel = false;
+    break;
+  case M25Q_CMD_CLEAR_FLAG_STATUS_REGISTER:
+    simp->errors = 0U;
+    break;
+  case M25Q_CMD_PROGRAM_ERASE_RESUME:
+    m25qsim_resume(simp);
+    break;
+  case M25Q_CMD_PAGE_PROGRAM:
+  case M25Q_CMD_SUBSECTOR_ERASE:
+  case M25Q_CMD_SECTOR_ERASE:
+  case M25Q_CMD_BULK_ERASE:
+    /* Modify commands require the write enable latch, no erase is
+       accepted while another one is suspended.*/
+    if (!simp->wel || ((cmd != M25Q_CMD_PAGE_PROGRAM) && simp->suspended)) {
+      simp->violations++;
+      break;
+    }
+    simp->wel = false;
+    if (cmd == M25Q_CMD_PAGE_PROGRAM) {
+      if (txbuf != NULL) {
+        m25qsim_program(simp, offset, n, txbuf);
+      }
+    }
+    else if (cmd == M25Q_CMD_SUBSECTOR_ERASE) {
+      m25qsim_erase(simp, offset, SUBSECTOR_SIZE,
+                    simp->config->subsector_erase_time);
+    }
+    else if (cmd == M25Q_CMD_SECTOR_ERASE) {
+      m25qsim_erase(simp, offset, SECTOR_SIZE,
+                    simp->config->sector_erase_time);
+    }
+    else {
+      m25qsim_erase(simp, 0U, simp->config->size,
+                    simp->config->bulk_erase_time);
+    }
+    break;
+  default:
+    /* Configuration registers writes only clear the write enable latch,
+       reads return an idle bus.*/
+    simp->wel = false;
+    break;
+  }
+}
+
+/** @} */
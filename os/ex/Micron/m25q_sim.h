@@ -0,0 +1,211 @@
+/*
+    ChibiOS - Copyright (C) 2016 Giovanni Di Sirio
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    m25q_sim.h
+ * @brief   Simulated Micron serial flash device header.
+ *
+ * @addtogroup M25Q_SIM
+ * @ingroup EX_MICRON
+ * @{
+ */
+
+#ifndef M25Q_SIM_H
+#define M25Q_SIM_H
+
+#include "m25q.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Typical device timings in microseconds
+ * @{
+ */
+#define M25QSIM_TIME_PAGE_PROGRAM           500U
+#define M25QSIM_TIME_SUBSECTOR_ERASE        250000U
+#define M25QSIM_TIME_SECTOR_ERASE           700000U
+#define M25QSIM_TIME_BULK_ERASE             170000000U
+#define M25QSIM_TIME_SUSPEND_LATENCY        30U
+#define M25QSIM_TIME_RESUME_PENALTY         100U
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if JESD216_BUS_MODE == JESD216_BUS_MODE_SPI
+#error "the simulated device requires a QSPI bus mode"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a simulated device configuration structure.
+ * @note    Times are expressed in microseconds, the simulated time advances
+ *          with the system time.
+ */
+typedef struct {
+  /**
+   * @brief   Memory array.
+   */
+  uint8_t                       *storage;
+  /**
+   * @brief   Memory array size, a power of two not lower than 64kB.
+   */
+  uint32_t                      size;
+  /**
+   * @brief   Page program time.
+   */
+  uint32_t                      page_program_time;
+  /**
+   * @brief   4kB sub-sector erase time.
+   */
+  uint32_t                      subsector_erase_time;
+  /**
+   * @brief   64kB sector erase time.
+   */
+  uint32_t                      sector_erase_time;
+  /**
+   * @brief   Bulk erase time.
+   */
+  uint32_t                      bulk_erase_time;
+  /**
+   * @brief   Erase suspend latency.
+   */
+  uint32_t                      suspend_latency;
+  /**
+   * @brief   Erase time added by each resume.
+   */
+  uint32_t                      resume_penalty;
+} M25QSimConfig;
+
+/**
+ * @brief   Type of a simulated device.
+ */
+typedef struct {
+  /**
+   * @brief   Current configuration data.
+   */
+  const M25QSimConfig           *config;
+  /**
+   * @brief   System time of the last update.
+   */
+  systime_t                     last;
+  /**
+   * @brief   Simulated time in microseconds.
+   */
+  uint64_t                      time;
+  /**
+   * @brief   Write enable latch.
+   */
+  bool                          wel;
+  /**
+   * @brief   Reset enabled by the previous command.
+   */
+  bool                          reset_enabled;
+  /**
+   * @brief   Error flags in the flags status register.
+   */
+  uint8_t                       errors;
+  /**
+   * @brief   Program operation in progress.
+   */
+  bool                          programming;
+  /**
+   * @brief   End time of the program operation.
+   */
+  uint64_t                      program_end;
+  /**
+   * @brief   Erase operation in progress.
+   */
+  bool                          erasing;
+  /**
+   * @brief   Erase operation suspended.
+   */
+  bool                          suspended;
+  /**
+   * @brief   Offset of the area being erased.
+   */
+  uint32_t                      erase_offset;
+  /**
+   * @brief   Size of the area being erased.
+   */
+  uint32_t                      erase_size;
+  /**
+   * @brief   End time of the erase operation.
+   */
+  uint64_t                      erase_end;
+  /**
+   * @brief   Erase time left when suspended.
+   */
+  uint64_t                      erase_left;
+  /**
+   * @brief   End time of the suspend latency.
+   */
+  uint64_t                      suspend_end;
+  /**
+   * @brief   Number of page program commands.
+   */
+  uint32_t                      programs;
+  /**
+   * @brief   Number of completed erase operations.
+   */
+  uint32_t                      erases;
+  /**
+   * @brief   Number of erase suspensions.
+   */
+  uint32_t                      suspends;
+  /**
+   * @brief   Number of protocol violations.
+   * @details Commands ignored by the device or accessing data in an
+   *          undefined state.
+   */
+  uint32_t                      violations;
+} M25QSimDevice;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void m25qsimObjectInit(M25QSimDevice *simp);
+  void m25qsimStart(M25QSimDevice *simp, const M25QSimConfig *config);
+  void m25qsimExchange(M25QSimDevice *simp, const qspi_command_t *cmdp,
+                       size_t n, const uint8_t *txbuf, uint8_t *rxbuf);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M25Q_SIM_H */
+
+/** @} */
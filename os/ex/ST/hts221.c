@@ -411,17 +411,20 @@ static msg_t thermo_reset_sensitivity(void *ip) {
 
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  sens_get_axes_number, sens_read_raw, sens_read_cooked
+  sens_get_axes_number, sens_read_raw, sens_read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseHygrometerVMT vmt_basehygrometer = {
   hygro_get_axes_number, hygro_read_raw, hygro_read_cooked,
+  NULL, NULL,
   hygro_set_bias, hygro_reset_bias,
   hygro_set_sensitivity, hygro_reset_sensitivity
 };
 
 static const struct BaseThermometerVMT vmt_basethermometer = {
   thermo_get_axes_number, thermo_read_raw, thermo_read_cooked,
+  NULL, NULL,
   thermo_set_bias, thermo_reset_bias,
   thermo_set_sensitivity, thermo_reset_sensitivity
 };
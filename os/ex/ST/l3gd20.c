@@ -41,6 +41,13 @@
 /*===========================================================================*/
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
+
+/**
+ * @brief   Sample periods in microseconds indexed by output data rate.
+ */
+static const uint32_t odr_periods[] = {
+  10526U, 5263U, 2632U, 1316U
+};
 
 /*===========================================================================*/
 /* Driver local functions.                                                   */
@@ -147,6 +154,121 @@ static msg_t read_cooked(void *ip, float axes[]) {
   return msg;
 }
 
+static msg_t set_fifo(void *ip, size_t watermark) {
+  uint8_t cr;
+
+  osalDbgCheck(ip != NULL);
+
+  osalDbgAssert((((L3GD20Driver *)ip)->state == L3GD20_READY),
+                "set_fifo(), invalid state");
+
+  if(watermark >= L3GD20_FIFO_DEPTH) {
+    return MSG_RESET;
+  }
+
+#if L3GD20_USE_SPI
+#if L3GD20_SHARED_SPI
+  spiAcquireBus(((L3GD20Driver *)ip)->config->spip);
+  spiStart(((L3GD20Driver *)ip)->config->spip,
+           ((L3GD20Driver *)ip)->config->spicfg);
+#endif /* L3GD20_SHARED_SPI */
+  /* Going through the bypass mode flushes the FIFO content.*/
+  cr = L3GD20_FIFO_CTRL_REG_BYPASS;
+  l3gd20SPIWriteRegister(((L3GD20Driver *)ip)->config->spip,
+                         L3GD20_AD_FIFO_CTRL_REG, 1, &cr);
+  l3gd20SPIReadRegister(((L3GD20Driver *)ip)->config->spip,
+                        L3GD20_AD_CTRL_REG5, 1, &cr);
+  cr &= ~L3GD20_CTRL_REG5_FIFO_EN;
+  if(watermark != SENSOR_FIFO_DISABLED) {
+    cr |= L3GD20_CTRL_REG5_FIFO_EN;
+  }
+  l3gd20SPIWriteRegister(((L3GD20Driver *)ip)->config->spip,
+                         L3GD20_AD_CTRL_REG5, 1, &cr);
+  if(watermark != SENSOR_FIFO_DISABLED) {
+    cr = L3GD20_FIFO_CTRL_REG_STREAM | (uint8_t)watermark;
+    l3gd20SPIWriteRegister(((L3GD20Driver *)ip)->config->spip,
+                           L3GD20_AD_FIFO_CTRL_REG, 1, &cr);
+  }
+#if L3GD20_SHARED_SPI
+  spiReleaseBus(((L3GD20Driver *)ip)->config->spip);
+#endif /* L3GD20_SHARED_SPI */
+#endif /* L3GD20_USE_SPI */
+
+  ((L3GD20Driver *)ip)->fifowm = watermark;
+  return MSG_OK;
+}
+
+static msg_t read_raw_batch(void *ip, int32_t axes[], systime_t stamps[],
+                            size_t n, size_t *np) {
+  uint8_t buff[L3GD20_FIFO_DEPTH * L3GD20_NUMBER_OF_AXES * 2], src;
+  size_t i, level, cnt;
+  uint32_t period;
+  systime_t now;
+  int16_t tmp;
+
+  osalDbgCheck((ip != NULL) && (axes != NULL) && (np != NULL));
+
+  osalDbgAssert((((L3GD20Driver *)ip)->state == L3GD20_READY),
+                "read_raw_batch(), invalid state");
+  osalDbgAssert((((L3GD20Driver *)ip)->fifowm != SENSOR_FIFO_DISABLED),
+                "read_raw_batch(), FIFO disabled");
+
+  src = L3GD20_FIFO_SRC_REG_EMPTY;
+  cnt = 0U;
+
+#if L3GD20_USE_SPI
+  osalDbgAssert((((L3GD20Driver *)ip)->config->spip->state == SPI_READY),
+                "read_raw_batch(), channel not ready");
+
+#if L3GD20_SHARED_SPI
+  spiAcquireBus(((L3GD20Driver *)ip)->config->spip);
+  spiStart(((L3GD20Driver *)ip)->config->spip,
+           ((L3GD20Driver *)ip)->config->spicfg);
+#endif /* L3GD20_SHARED_SPI */
+  l3gd20SPIReadRegister(((L3GD20Driver *)ip)->config->spip,
+                        L3GD20_AD_FIFO_SRC_REG, 1, &src);
+  if((src & L3GD20_FIFO_SRC_REG_EMPTY) == 0U) {
+    if((src & L3GD20_FIFO_SRC_REG_OVRN) != 0U) {
+      cnt = L3GD20_FIFO_DEPTH;
+    }
+    else {
+      cnt = src & L3GD20_FIFO_SRC_REG_FSS_MASK;
+    }
+  }
+  level = cnt;
+  if(cnt > n) {
+    cnt = n;
+  }
+
+  /* With the FIFO enabled the output registers address rolls back to
+     OUT_X_L after OUT_Z_H, a single burst pops all the samples.*/
+  if(cnt > 0U) {
+    l3gd20SPIReadRegister(((L3GD20Driver *)ip)->config->spip,
+                          L3GD20_AD_OUT_X_L,
+                          cnt * L3GD20_NUMBER_OF_AXES * 2, buff);
+  }
+#if L3GD20_SHARED_SPI
+  spiReleaseBus(((L3GD20Driver *)ip)->config->spip);
+#endif /* L3GD20_SHARED_SPI */
+#else
+  level = 0U;
+#endif /* L3GD20_USE_SPI */
+  now = osalOsGetSystemTimeX();
+
+  for(i = 0; i < cnt * L3GD20_NUMBER_OF_AXES; i++) {
+    tmp = buff[2*i] + (buff[2*i+1] << 8);
+    axes[i] = (int32_t)tmp;
+  }
+  if(stamps != NULL) {
+    period = odr_periods[((L3GD20Driver *)ip)->config->outputdatarate >> 6];
+    for(i = 0; i < cnt; i++) {
+      stamps[i] = SENSOR_FIFO_STAMP(now, level - 1U - i, period);
+    }
+  }
+  *np = cnt;
+  return MSG_OK;
+}
+
 static msg_t sample_bias(void *ip) {
   uint32_t i, j;
   int32_t raw[L3GD20_NUMBER_OF_AXES];
@@ -305,17 +427,20 @@ static msg_t set_full_scale(void *ip, l3gd20_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  get_axes_number, read_raw, read_cooked
+  get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch
 };
 
 static const struct BaseGyroscopeVMT vmt_basegyroscope = {
   get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch,
   sample_bias, set_bias, reset_bias,
   set_sensivity, reset_sensivity
 };
 
 static const struct L3GD20VMT vmt_l3gd20 = {
   get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch,
   sample_bias, set_bias, reset_bias,
   set_sensivity, reset_sensivity,
   set_full_scale
@@ -340,6 +465,7 @@ void l3gd20ObjectInit(L3GD20Driver *devp) {
   devp->config = NULL;
   for(i = 0; i < L3GD20_NUMBER_OF_AXES; i++)
     devp->bias[i] = 0.0f;
+  devp->fifowm = SENSOR_FIFO_DISABLED;
   devp->state  = L3GD20_STOP;
 }
 
@@ -388,7 +514,8 @@ void l3gd20Start(L3GD20Driver *devp, const L3GD20Config *config) {
 #endif
   }
   
-  /* Control register 5 configuration block.*/
+  /* Control register 5 configuration block, the FIFO is left disabled.*/
+  devp->fifowm = SENSOR_FIFO_DISABLED;
   {
     
 #if L3GD20_USE_ADVANCED || defined(__DOXYGEN__)
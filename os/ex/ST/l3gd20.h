@@ -42,7 +42,7 @@
 /**
  * @brief   L3GD20 driver version string.
  */
-#define EX_L3GD20_VERSION           "1.0.4"
+#define EX_L3GD20_VERSION           "1.1.0"
 
 /**
  * @brief   L3GD20 driver version major number.
@@ -52,12 +52,12 @@
 /**
  * @brief   L3GD20 driver version minor number.
  */
-#define EX_L3GD20_MINOR             0
+#define EX_L3GD20_MINOR             1
 
 /**
  * @brief   L3GD20 driver version patch number.
  */
-#define EX_L3GD20_PATCH             4
+#define EX_L3GD20_PATCH             0
 /** @} */
 
 /**
@@ -66,6 +66,7 @@
  * @{
  */
 #define L3GD20_NUMBER_OF_AXES       3U
+#define L3GD20_FIFO_DEPTH           32U
 
 #define L3GD20_250DPS               250.0f
 #define L3GD20_500DPS               500.0f
@@ -189,6 +190,29 @@
 #define L3GD20_CTRL_REG5_FIFO_EN    (1 << 6)    /**< FIFO enable            */
 #define L3GD20_CTRL_REG5_BOOT       (1 << 7)    /**< Reboot memory content  */
 /** @} */
+
+/**
+ * @name    L3GD20_FIFO_CTRL_REG register bits definitions
+ * @{
+ */
+#define L3GD20_FIFO_CTRL_REG_MASK   0xFF        /**< L3GD20_FIFO_CTRL mask  */
+#define L3GD20_FIFO_CTRL_REG_WTM_MASK 0x1F      /**< Watermark field mask   */
+#define L3GD20_FIFO_CTRL_REG_FM_MASK 0xE0       /**< FIFO mode field mask   */
+#define L3GD20_FIFO_CTRL_REG_BYPASS (0 << 5)    /**< Bypass mode            */
+#define L3GD20_FIFO_CTRL_REG_FIFO   (1 << 5)    /**< FIFO mode              */
+#define L3GD20_FIFO_CTRL_REG_STREAM (2 << 5)    /**< Stream mode            */
+/** @} */
+
+/**
+ * @name    L3GD20_FIFO_SRC_REG register bits definitions
+ * @{
+ */
+#define L3GD20_FIFO_SRC_REG_MASK    0xFF        /**< L3GD20_FIFO_SRC mask   */
+#define L3GD20_FIFO_SRC_REG_FSS_MASK 0x1F       /**< Stored samples mask    */
+#define L3GD20_FIFO_SRC_REG_EMPTY   (1 << 5)    /**< FIFO empty             */
+#define L3GD20_FIFO_SRC_REG_OVRN    (1 << 6)    /**< FIFO overrun           */
+#define L3GD20_FIFO_SRC_REG_WTM     (1 << 7)    /**< Watermark reached      */
+/** @} */
 
 /**
  * @name    L3GD20_INT1_CFG register bits definitions
@@ -509,7 +533,9 @@ struct L3GD20VMT {
   /* Current Bias data.*/                                                   \
   float                     bias[L3GD20_NUMBER_OF_AXES];                    \
   /* Current full scale value.*/                                            \
-  float                     fullscale;
+  float                     fullscale;                                      \
+  /* Current FIFO watermark or SENSOR_FIFO_DISABLED.*/                      \
+  size_t                    fifowm;
 
 /**
  * @extends BaseGyroscope
@@ -266,16 +266,19 @@ static msg_t set_full_scale(void *ip, lis302dl_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  get_axes_number, read_raw, read_cooked
+  get_axes_number, read_raw, read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseAccelerometerVMT vmt_baseaccelerometer = {
   get_axes_number, read_raw, read_cooked,
+  NULL, NULL,
   set_bias, reset_bias, set_sensivity, reset_sensivity 
 };
 
 static const struct LIS302DLVMT vmt_lis302dl = {
   get_axes_number, read_raw, read_cooked,
+  NULL, NULL,
   set_bias, reset_bias, set_sensivity, reset_sensivity,
   set_full_scale
 };
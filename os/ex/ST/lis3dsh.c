@@ -42,6 +42,13 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Sample periods in microseconds indexed by output data rate.
+ */
+static const uint32_t odr_periods[] = {
+  0U, 320000U, 160000U, 80000U, 40000U, 20000U, 10000U, 2500U, 1250U, 625U
+};
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
@@ -149,6 +156,121 @@ static msg_t read_cooked(void *ip, float axes[]) {
   return msg;
 }
 
+static msg_t set_fifo(void *ip, size_t watermark) {
+  uint8_t cr;
+
+  osalDbgCheck(ip != NULL);
+
+  osalDbgAssert((((LIS3DSHDriver *)ip)->state == LIS3DSH_READY),
+                "set_fifo(), invalid state");
+
+  if(watermark >= LIS3DSH_FIFO_DEPTH) {
+    return MSG_RESET;
+  }
+
+#if LIS3DSH_USE_SPI
+#if LIS3DSH_SHARED_SPI
+  spiAcquireBus(((LIS3DSHDriver *)ip)->config->spip);
+  spiStart(((LIS3DSHDriver *)ip)->config->spip,
+           ((LIS3DSHDriver *)ip)->config->spicfg);
+#endif /* LIS3DSH_SHARED_SPI */
+  /* Going through the bypass mode flushes the FIFO content.*/
+  cr = LIS3DSH_FIFO_CTRL_BYPASS;
+  lis3dshSPIWriteRegister(((LIS3DSHDriver *)ip)->config->spip,
+                          LIS3DSH_AD_FIFO_CTRL, 1, &cr);
+  lis3dshSPIReadRegister(((LIS3DSHDriver *)ip)->config->spip,
+                         LIS3DSH_AD_CTRL_REG6, 1, &cr);
+  cr &= ~(LIS3DSH_CTRL_REG6_FIFO_EN | LIS3DSH_CTRL_REG6_WTM_EN);
+  if(watermark != SENSOR_FIFO_DISABLED) {
+    cr |= LIS3DSH_CTRL_REG6_FIFO_EN | LIS3DSH_CTRL_REG6_WTM_EN;
+  }
+  lis3dshSPIWriteRegister(((LIS3DSHDriver *)ip)->config->spip,
+                          LIS3DSH_AD_CTRL_REG6, 1, &cr);
+  if(watermark != SENSOR_FIFO_DISABLED) {
+    cr = LIS3DSH_FIFO_CTRL_STREAM | (uint8_t)watermark;
+    lis3dshSPIWriteRegister(((LIS3DSHDriver *)ip)->config->spip,
+                            LIS3DSH_AD_FIFO_CTRL, 1, &cr);
+  }
+#if LIS3DSH_SHARED_SPI
+  spiReleaseBus(((LIS3DSHDriver *)ip)->config->spip);
+#endif /* LIS3DSH_SHARED_SPI */
+#endif /* LIS3DSH_USE_SPI */
+
+  ((LIS3DSHDriver *)ip)->fifowm = watermark;
+  return MSG_OK;
+}
+
+static msg_t read_raw_batch(void *ip, int32_t axes[], systime_t stamps[],
+                            size_t n, size_t *np) {
+  uint8_t buff[LIS3DSH_FIFO_DEPTH * LIS3DSH_NUMBER_OF_AXES * 2], src;
+  size_t i, level, cnt;
+  uint32_t period;
+  systime_t now;
+  int16_t tmp;
+
+  osalDbgCheck((ip != NULL) && (axes != NULL) && (np != NULL));
+
+  osalDbgAssert((((LIS3DSHDriver *)ip)->state == LIS3DSH_READY),
+                "read_raw_batch(), invalid state");
+  osalDbgAssert((((LIS3DSHDriver *)ip)->fifowm != SENSOR_FIFO_DISABLED),
+                "read_raw_batch(), FIFO disabled");
+
+  src = LIS3DSH_FIFO_SRC_EMPTY;
+  cnt = 0U;
+
+#if LIS3DSH_USE_SPI
+  osalDbgAssert((((LIS3DSHDriver *)ip)->config->spip->state == SPI_READY),
+                "read_raw_batch(), channel not ready");
+
+#if LIS3DSH_SHARED_SPI
+  spiAcquireBus(((LIS3DSHDriver *)ip)->config->spip);
+  spiStart(((LIS3DSHDriver *)ip)->config->spip,
+           ((LIS3DSHDriver *)ip)->config->spicfg);
+#endif /* LIS3DSH_SHARED_SPI */
+  lis3dshSPIReadRegister(((LIS3DSHDriver *)ip)->config->spip,
+                         LIS3DSH_AD_FIFO_SRC, 1, &src);
+  if((src & LIS3DSH_FIFO_SRC_EMPTY) == 0U) {
+    if((src & LIS3DSH_FIFO_SRC_OVRN) != 0U) {
+      cnt = LIS3DSH_FIFO_DEPTH;
+    }
+    else {
+      cnt = src & LIS3DSH_FIFO_SRC_FSS_MASK;
+    }
+  }
+  level = cnt;
+  if(cnt > n) {
+    cnt = n;
+  }
+
+  /* With the FIFO enabled the output registers address rolls back to
+     OUT_X_L after OUT_Z_H, a single burst pops all the samples.*/
+  if(cnt > 0U) {
+    lis3dshSPIReadRegister(((LIS3DSHDriver *)ip)->config->spip,
+                           LIS3DSH_AD_OUT_X_L,
+                           cnt * LIS3DSH_NUMBER_OF_AXES * 2, buff);
+  }
+#if LIS3DSH_SHARED_SPI
+  spiReleaseBus(((LIS3DSHDriver *)ip)->config->spip);
+#endif /* LIS3DSH_SHARED_SPI */
+#else
+  level = 0U;
+#endif /* LIS3DSH_USE_SPI */
+  now = osalOsGetSystemTimeX();
+
+  for(i = 0; i < cnt * LIS3DSH_NUMBER_OF_AXES; i++) {
+    tmp = buff[2*i] + (buff[2*i+1] << 8);
+    axes[i] = (int32_t)tmp;
+  }
+  if(stamps != NULL) {
+    period = odr_periods[((LIS3DSHDriver *)ip)->config->outputdatarate >> 4];
+    for(i = 0; i < cnt; i++) {
+      stamps[i] = SENSOR_FIFO_STAMP(now, level - 1U - i, period);
+    }
+  }
+  *np = cnt;
+  return MSG_OK;
+}
+
 static msg_t set_bias(void *ip, float *bp) {
   uint32_t i;
   
@@ -288,16 +410,19 @@ static msg_t set_full_scale(void *ip, lis3dsh_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  get_axes_number, read_raw, read_cooked
+  get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch
 };
 
 static const struct BaseAccelerometerVMT vmt_baseaccelerometer = {
   get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch,
   set_bias, reset_bias, set_sensivity, reset_sensivity 
 };
 
 static const struct LIS3DSHVMT vmt_lis3dsh = {
   get_axes_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch,
   set_bias, reset_bias, set_sensivity, reset_sensivity,
   set_full_scale
 };
@@ -321,6 +446,7 @@ void lis3dshObjectInit(LIS3DSHDriver *devp) {
   devp->config = NULL;
   for(i = 0; i < LIS3DSH_NUMBER_OF_AXES; i++)
     devp->bias[i] = 0.0f;
+  devp->fifowm = SENSOR_FIFO_DISABLED;
   devp->state  = LIS3DSH_STOP;
 }
 
@@ -386,7 +512,8 @@ void lis3dshStart(LIS3DSHDriver *devp, const LIS3DSHConfig *config) {
 #endif /* LIS3DSH_SHARED_SPI */
 #endif /* LIS3DSH_USE_SPI */
 
-  /* Control register 6 configuration block.*/
+  /* Control register 6 configuration block, the FIFO is left disabled.*/
+  devp->fifowm = SENSOR_FIFO_DISABLED;
   {
     cr = LIS3DSH_CTRL_REG6_ADD_INC;
 #if LIS3DSH_USE_ADVANCED || defined(__DOXYGEN__)
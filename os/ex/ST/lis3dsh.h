@@ -43,7 +43,7 @@
 /**
  * @brief   LIS3DSH driver version string.
  */
-#define EX_LIS3DSH_VERSION          "1.0.2"
+#define EX_LIS3DSH_VERSION          "1.1.0"
 
 /**
  * @brief   LIS3DSH driver version major number.
@@ -53,12 +53,12 @@
 /**
  * @brief   LIS3DSH driver version minor number.
  */
-#define EX_LIS3DSH_MINOR            0
+#define EX_LIS3DSH_MINOR            1
 
 /**
  * @brief   LIS3DSH driver version patch number.
  */
-#define EX_LIS3DSH_PATCH            2
+#define EX_LIS3DSH_PATCH            0
 /** @} */
 
 /**
@@ -67,6 +67,7 @@
  * @{
  */
 #define LIS3DSH_NUMBER_OF_AXES      3U
+#define LIS3DSH_FIFO_DEPTH          32U
 
 #define LIS3DSH_2G                  2.0f
 #define LIS3DSH_4G                  4.0f
@@ -281,6 +282,29 @@
 #define LIS3DSH_CTRL_REG6_BOOT     (1 << 7)    /**< Force reboot             */
 /** @} */
 
+/**
+ * @name    LIS3DSH_FIFO_CTRL register bits definitions
+ * @{
+ */
+#define LIS3DSH_FIFO_CTRL_MASK     0xFF        /**< LIS3DSH_FIFO_CTRL mask   */
+#define LIS3DSH_FIFO_CTRL_WTMP_MASK 0x1F       /**< Watermark field mask     */
+#define LIS3DSH_FIFO_CTRL_FMODE_MASK 0xE0      /**< FIFO mode field mask     */
+#define LIS3DSH_FIFO_CTRL_BYPASS   (0 << 5)    /**< Bypass mode              */
+#define LIS3DSH_FIFO_CTRL_FIFO     (1 << 5)    /**< FIFO mode                */
+#define LIS3DSH_FIFO_CTRL_STREAM   (2 << 5)    /**< Stream mode              */
+/** @} */
+
+/**
+ * @name    LIS3DSH_FIFO_SRC register bits definitions
+ * @{
+ */
+#define LIS3DSH_FIFO_SRC_MASK      0xFF        /**< LIS3DSH_FIFO_SRC mask    */
+#define LIS3DSH_FIFO_SRC_FSS_MASK  0x1F        /**< Stored samples mask      */
+#define LIS3DSH_FIFO_SRC_EMPTY     (1 << 5)    /**< FIFO empty               */
+#define LIS3DSH_FIFO_SRC_OVRN      (1 << 6)    /**< FIFO overrun             */
+#define LIS3DSH_FIFO_SRC_WTM       (1 << 7)    /**< Watermark reached        */
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -498,7 +522,9 @@ struct LIS3DSHVMT {
   /* Bias data.*/                                                           \
   int32_t                   bias[LIS3DSH_NUMBER_OF_AXES];                   \
   /* Current full scale value.*/                                            \
-  float                     fullscale;
+  float                     fullscale;                                      \
+  /* Current FIFO watermark or SENSOR_FIFO_DISABLED.*/                      \
+  size_t                    fifowm;
 
 /**
  * @extends BaseAccelerometer
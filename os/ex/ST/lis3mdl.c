@@ -298,16 +298,19 @@ static msg_t set_full_scale(void *ip, lis3mdl_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  get_axes_number, read_raw, read_cooked
+  get_axes_number, read_raw, read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseCompassVMT vmt_basecompass = {
   get_axes_number, read_raw, read_cooked,
+  NULL, NULL,
   set_bias, reset_bias, set_sensivity, reset_sensivity
 };
 
 static const struct LIS3MDLVMT vmt_lis3mdl = {
   get_axes_number, read_raw, read_cooked,
+  NULL, NULL,
   set_bias, reset_bias, set_sensivity, reset_sensivity,
   set_full_scale
 };
@@ -197,11 +197,13 @@ static msg_t reset_sensivity(void *ip) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  get_axes_number, read_raw, read_cooked
+  get_axes_number, read_raw, read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseBarometerVMT vmt_basebarometer = {
   get_axes_number, read_raw, read_cooked,
+  NULL, NULL,
   set_bias, reset_bias, set_sensivity, reset_sensivity
 };
 
@@ -605,27 +605,32 @@ static msg_t comp_set_full_scale(void *ip, lsm303dlhc_comp_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  sens_get_axes_number, sens_read_raw, sens_read_cooked
+  sens_get_axes_number, sens_read_raw, sens_read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseCompassVMT vmt_basecompass = {
   comp_get_axes_number, comp_read_raw, comp_read_cooked,
+  NULL, NULL,
   comp_set_bias, comp_reset_bias, comp_set_sensivity, comp_reset_sensivity
 };
 
 static const struct BaseAccelerometerVMT vmt_baseaccelerometer = {
   acc_get_axes_number, acc_read_raw, acc_read_cooked,
+  NULL, NULL,
   acc_set_bias, acc_reset_bias, acc_set_sensivity, acc_reset_sensivity
 };
 
 static const struct LSM303DLHCACCVMT vmt_lsm303dlhcacc = {
   acc_get_axes_number, acc_read_raw, acc_read_cooked,
+  NULL, NULL,
   acc_set_bias, acc_reset_bias, acc_set_sensivity, acc_reset_sensivity,
   acc_set_full_scale
 };
 
 static const struct LSM303DLHCCOMPVMT vmt_lsm303dlhccomp = {
   comp_get_axes_number, comp_read_raw, comp_read_cooked,
+  NULL, NULL,
   comp_set_bias, comp_reset_bias, comp_set_sensivity, comp_reset_sensivity,
   comp_set_full_scale
 };
@@ -42,6 +42,22 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Accelerometer sample periods in microseconds indexed by ODR.
+ * @note    The last ODR value is reserved, no period is known for it.
+ */
+static const uint32_t acc_odr_periods[8] = {
+  0U, 100000U, 20000U, 8403U, 4202U, 2101U, 1050U, 0U
+};
+
+/**
+ * @brief   Gyroscope sample periods in microseconds indexed by ODR.
+ * @note    The last ODR value is reserved, no period is known for it.
+ */
+static const uint32_t gyro_odr_periods[8] = {
+  0U, 67114U, 16807U, 8403U, 4202U, 2101U, 1050U, 0U
+};
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
@@ -253,6 +269,171 @@ static msg_t sens_read_cooked(void *ip, float axes[]) {
   return msg;
 }
 
+/*
+ * The FIFO is shared by the two subsystems, it is filled at the gyroscope
+ * output data rate when the gyroscope is enabled. A batch read pops the
+ * FIFO slots, the samples of the other subsystem in those slots are lost.
+ */
+static msg_t set_fifo(void *ip, size_t watermark) {
+  uint8_t cr[2];
+  msg_t msg = MSG_OK;
+
+  osalDbgCheck(ip != NULL);
+
+  osalDbgAssert((((LSM6DS0Driver *)ip)->state == LSM6DS0_READY),
+                "set_fifo(), invalid state");
+
+  if(watermark >= LSM6DS0_FIFO_DEPTH) {
+    return MSG_RESET;
+  }
+
+#if LSM6DS0_USE_I2C
+#if LSM6DS0_SHARED_I2C
+  i2cAcquireBus(((LSM6DS0Driver *)ip)->config->i2cp);
+  i2cStart(((LSM6DS0Driver *)ip)->config->i2cp,
+           ((LSM6DS0Driver *)ip)->config->i2ccfg);
+#endif /* LSM6DS0_SHARED_I2C */
+  /* Going through the bypass mode flushes the FIFO content.*/
+  cr[0] = LSM6DS0_AD_FIFO_CTRL;
+  cr[1] = LSM6DS0_FIFO_CTRL_BYPASS;
+  msg = lsm6ds0I2CWriteRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                                ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                                cr, 1);
+  if(msg == MSG_OK) {
+    msg = lsm6ds0I2CReadRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                                 ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                                 LSM6DS0_AD_CTRL_REG9, &cr[1], 1);
+  }
+  if(msg == MSG_OK) {
+    cr[0] = LSM6DS0_AD_CTRL_REG9;
+    cr[1] &= ~LSM6DS0_CTRL_REG9_FIFO_EN;
+    if(watermark != SENSOR_FIFO_DISABLED) {
+      cr[1] |= LSM6DS0_CTRL_REG9_FIFO_EN;
+    }
+    msg = lsm6ds0I2CWriteRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                                  ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                                  cr, 1);
+  }
+  if((msg == MSG_OK) && (watermark != SENSOR_FIFO_DISABLED)) {
+    cr[0] = LSM6DS0_AD_FIFO_CTRL;
+    cr[1] = LSM6DS0_FIFO_CTRL_CONTINUOUS | (uint8_t)watermark;
+    msg = lsm6ds0I2CWriteRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                                  ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                                  cr, 1);
+  }
+#if LSM6DS0_SHARED_I2C
+  i2cReleaseBus(((LSM6DS0Driver *)ip)->config->i2cp);
+#endif /* LSM6DS0_SHARED_I2C */
+#endif /* LSM6DS0_USE_I2C */
+
+  if(msg == MSG_OK) {
+    ((LSM6DS0Driver *)ip)->fifowm = watermark;
+  }
+  return msg;
+}
+
+/*
+ * Reads up to n samples from the FIFO starting from the output registers
+ * at the specified address, the address rolls back after the Z axis high
+ * byte while the FIFO is enabled so a single burst pops all the samples.
+ */
+static msg_t read_raw_batch(void *ip, uint8_t reg, uint32_t period,
+                            int32_t axes[], systime_t stamps[],
+                            size_t n, size_t *np) {
+  uint8_t buff[LSM6DS0_FIFO_DEPTH * 3 * 2], src;
+  size_t i, level, cnt;
+  systime_t now;
+  int16_t tmp;
+  msg_t msg = MSG_OK;
+
+  osalDbgAssert((((LSM6DS0Driver *)ip)->state == LSM6DS0_READY),
+                "read_raw_batch(), invalid state");
+  osalDbgAssert((((LSM6DS0Driver *)ip)->fifowm != SENSOR_FIFO_DISABLED),
+                "read_raw_batch(), FIFO disabled");
+
+  src = 0U;
+  cnt = 0U;
+
+#if LSM6DS0_USE_I2C
+  osalDbgAssert((((LSM6DS0Driver *)ip)->config->i2cp->state == I2C_READY),
+                "read_raw_batch(), channel not ready");
+#if LSM6DS0_SHARED_I2C
+  i2cAcquireBus(((LSM6DS0Driver *)ip)->config->i2cp);
+  i2cStart(((LSM6DS0Driver *)ip)->config->i2cp,
+           ((LSM6DS0Driver *)ip)->config->i2ccfg);
+#endif /* LSM6DS0_SHARED_I2C */
+  msg = lsm6ds0I2CReadRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                               ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                               LSM6DS0_AD_FIFO_SRC, &src, 1);
+  cnt = src & LSM6DS0_FIFO_SRC_FSS_MASK;
+  level = cnt;
+  if(cnt > n) {
+    cnt = n;
+  }
+  if((msg == MSG_OK) && (cnt > 0U)) {
+    msg = lsm6ds0I2CReadRegister(((LSM6DS0Driver *)ip)->config->i2cp,
+                                 ((LSM6DS0Driver *)ip)->config->slaveaddress,
+                                 reg, buff, cnt * 3 * 2);
+  }
+#if LSM6DS0_SHARED_I2C
+  i2cReleaseBus(((LSM6DS0Driver *)ip)->config->i2cp);
+#endif /* LSM6DS0_SHARED_I2C */
+#else
+  (void)reg;
+  level = 0U;
+#endif /* LSM6DS0_USE_I2C */
+  now = osalOsGetSystemTimeX();
+
+  if(msg != MSG_OK) {
+    *np = 0U;
+    return msg;
+  }
+  for(i = 0; i < cnt * 3; i++) {
+    tmp = buff[2*i] + (buff[2*i+1] << 8);
+    axes[i] = (int32_t)tmp;
+  }
+  if(stamps != NULL) {
+    for(i = 0; i < cnt; i++) {
+      stamps[i] = SENSOR_FIFO_STAMP(now, level - 1U - i, period);
+    }
+  }
+  *np = cnt;
+  return MSG_OK;
+}
+
+static msg_t acc_read_raw_batch(void *ip, int32_t axes[], systime_t stamps[],
+                                size_t n, size_t *np) {
+  uint32_t period;
+
+  osalDbgCheck(((ip != NULL) && (axes != NULL) && (np != NULL)) &&
+               (((LSM6DS0Driver *)ip)->config->acccfg != NULL));
+
+  /* With the gyroscope enabled the accelerometer runs at its rate.*/
+  if(((LSM6DS0Driver *)ip)->config->gyrocfg != NULL) {
+    period = gyro_odr_periods[
+               (((LSM6DS0Driver *)ip)->config->gyrocfg->outdatarate >> 5) & 7];
+  }
+  else {
+    period = acc_odr_periods[
+               (((LSM6DS0Driver *)ip)->config->acccfg->outdatarate >> 5) & 7];
+  }
+  return read_raw_batch(ip, LSM6DS0_AD_OUT_X_L_XL, period,
+                        axes, stamps, n, np);
+}
+
+static msg_t gyro_read_raw_batch(void *ip, int32_t axes[], systime_t stamps[],
+                                 size_t n, size_t *np) {
+  uint32_t period;
+
+  osalDbgCheck(((ip != NULL) && (axes != NULL) && (np != NULL)) &&
+               (((LSM6DS0Driver *)ip)->config->gyrocfg != NULL));
+
+  period = gyro_odr_periods[
+             (((LSM6DS0Driver *)ip)->config->gyrocfg->outdatarate >> 5) & 7];
+  return read_raw_batch(ip, LSM6DS0_AD_OUT_X_L_G, period,
+                        axes, stamps, n, np);
+}
+
 static msg_t gyro_sample_bias(void *ip) {
   uint32_t i, j;
   int32_t raw[LSM6DS0_GYRO_NUMBER_OF_AXES];
@@ -555,28 +736,33 @@ static msg_t gyro_set_full_scale(void *ip, lsm6ds0_gyro_fs_t fs) {
 }
 
 static const struct BaseSensorVMT vmt_basesensor = {
-  sens_get_axes_number, sens_read_raw, sens_read_cooked
+  sens_get_axes_number, sens_read_raw, sens_read_cooked,
+  NULL, NULL
 };
 
 static const struct BaseGyroscopeVMT vmt_basegyroscope = {
   gyro_get_axes_number, gyro_read_raw, gyro_read_cooked,
+  set_fifo, gyro_read_raw_batch,
   gyro_sample_bias, gyro_set_bias, gyro_reset_bias,
   gyro_set_sensivity, gyro_reset_sensivity
 };
 
 static const struct BaseAccelerometerVMT vmt_baseaccelerometer = {
   acc_get_axes_number, acc_read_raw, acc_read_cooked,
+  set_fifo, acc_read_raw_batch,
   acc_set_bias, acc_reset_bias, acc_set_sensivity, acc_reset_sensivity
 };
 
 static const struct LSM6DS0ACCVMT vmt_lsm6ds0acc = {
   acc_get_axes_number, acc_read_raw, acc_read_cooked,
+  set_fifo, acc_read_raw_batch,
   acc_set_bias, acc_reset_bias, acc_set_sensivity, acc_reset_sensivity,
   acc_set_full_scale
 };
 
 static const struct LSM6DS0GYROVMT vmt_lsm6ds0gyro = {
   gyro_get_axes_number, gyro_read_raw, gyro_read_cooked,
+  set_fifo, gyro_read_raw_batch,
   gyro_sample_bias, gyro_set_bias, gyro_reset_bias,
   gyro_set_sensivity, gyro_reset_sensivity, gyro_set_full_scale
 };
@@ -604,6 +790,7 @@ void lsm6ds0ObjectInit(LSM6DS0Driver *devp) {
     devp->accbias[i] = 0.0f;
   for(i = 0; i < LSM6DS0_GYRO_NUMBER_OF_AXES; i++)
     devp->gyrobias[i] = 0.0f;
+  devp->fifowm = SENSOR_FIFO_DISABLED;
   devp->state  = LSM6DS0_STOP;
 }
 
@@ -732,10 +919,11 @@ void lsm6ds0Start(LSM6DS0Driver *devp, const LSM6DS0Config *config) {
 #endif /* LSM6DS0_USE_I2C */
 
     cr[0] = LSM6DS0_AD_CTRL_REG9;
-    /* Control register 9 configuration block.*/
+    /* Control register 9 configuration block, the FIFO is left disabled.*/
     {
         cr[1] = 0;
     }
+    devp->fifowm = SENSOR_FIFO_DISABLED;
 #if LSM6DS0_USE_I2C
 #if LSM6DS0_SHARED_I2C
     i2cAcquireBus((devp)->config->i2cp);
@@ -43,7 +43,7 @@
 /**
  * @brief   LSM6DS0 driver version string.
  */
-#define EX_LSM6DS0_VERSION          "1.0.3"
+#define EX_LSM6DS0_VERSION          "1.1.0"
 
 /**
  * @brief   LSM6DS0 driver version major number.
@@ -53,12 +53,12 @@
 /**
  * @brief   LSM6DS0 driver version minor number.
  */
-#define EX_LSM6DS0_MINOR            0
+#define EX_LSM6DS0_MINOR            1
 
 /**
  * @brief   LSM6DS0 driver version patch number.
  */
-#define EX_LSM6DS0_PATCH            3
+#define EX_LSM6DS0_PATCH            0
 /** @} */
 
 /**
@@ -95,6 +95,12 @@
 #define LSM6DS0_GYRO_SENS_2000DPS           0.07000f
 /** @} */
 
+/**
+ * @brief   LSM6DS0 FIFO depth in samples.
+ * @note    The FIFO is shared by the accelerometer and gyroscope subsystems.
+ */
+#define LSM6DS0_FIFO_DEPTH                  32U
+
 /**
  * @name   LSM6DS0 communication interfaces related bit masks
  * @{
@@ -290,6 +296,26 @@
 
 /** @} */
 
+/**
+ * @name    LSM6DS0_AD_FIFO_CTRL register bits definitions
+ * @{
+ */
+#define LSM6DS0_FIFO_CTRL_FTH_MASK          0x1F
+#define LSM6DS0_FIFO_CTRL_FMODE_MASK        0xE0
+#define LSM6DS0_FIFO_CTRL_BYPASS            (0 << 5)
+#define LSM6DS0_FIFO_CTRL_FIFO              (1 << 5)
+#define LSM6DS0_FIFO_CTRL_CONTINUOUS        (6 << 5)
+/** @} */
+
+/**
+ * @name    LSM6DS0_AD_FIFO_SRC register bits definitions
+ * @{
+ */
+#define LSM6DS0_FIFO_SRC_FSS_MASK           0x3F
+#define LSM6DS0_FIFO_SRC_OVRN               (1 << 6)
+#define LSM6DS0_FIFO_SRC_FTH                (1 << 7)
+/** @} */
+
 //TODO: ADD more LSM6DS0 register bits definitions
 
 /*===========================================================================*/
@@ -736,7 +762,9 @@ struct LSM6DS0GYROVMT {
   /* Bias data.*/                                                           \
   float                     gyrobias[LSM6DS0_GYRO_NUMBER_OF_AXES];          \
   /* Current gyroscope full scale value.*/                                  \
-  float                     gyrofullscale;
+  float                     gyrofullscale;                                  \
+  /* Current FIFO watermark or SENSOR_FIFO_DISABLED.*/                      \
+  size_t                    fifowm;
   
 /**
  * @brief LSM6DS0 6-axis accelerometer/gyroscope class.
@@ -34,6 +34,9 @@
  * @{
  */
 
+#include <string.h>
+#include <stddef.h>
+
 #include "hal.h"
 
 #include "mfs.h"
@@ -42,6 +45,31 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+/**
+ * @brief   Records alignment.
+ */
+#define MFS_ALIGN_SIZE      8U
+
+/**
+ * @brief   Space taken in a bank by a record of the specified size.
+ */
+#define MFS_RECORD_SIZE(n)                                                  \
+  ((((uint32_t)sizeof (mfs_data_header_t) + (uint32_t)(n)) +                \
+    (MFS_ALIGN_SIZE - 1U)) & ~(MFS_ALIGN_SIZE - 1U))
+
+/**
+ * @brief   Offset of the first record in a bank.
+ */
+#define MFS_FIRST_OFFSET                                                    \
+  ((((uint32_t)sizeof (mfs_bank_header_t)) + (MFS_ALIGN_SIZE - 1U)) &       \
+   ~(MFS_ALIGN_SIZE - 1U))
+
+/**
+ * @brief   The storage is mounted, a transaction can be open.
+ */
+#define MFS_IS_MOUNTED(devp)                                                \
+  (((devp)->state == MFS_MOUNTED) || ((devp)->state == MFS_TRANSACTION))
+
 #define PAIR(a, b) (((unsigned)(a) << 2U) | (unsigned)(b))
 
 /**
@@ -112,15 +140,803 @@ uint16_t crc16(uint16_t crc, const uint8_t *data, size_t n) {
   return crc;
 }
 
+/**
+ * @brief   Flash read.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] offset    flash offset
+ * @param[in] n         number of bytes to be read
+ * @param[out] rp       pointer to the data buffer
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_flash_read(MFSDriver *devp, flash_offset_t offset,
+                                  size_t n, uint8_t *rp) {
+  flash_error_t ferr;
+
+  ferr = flashRead(devp->config->flashp, offset, n, rp);
+  if (ferr != FLASH_NO_ERROR) {
+    return MFS_ERR_FLASH_FAILURE;
+  }
+
+  return MFS_NO_ERROR;
+}
+
 /**
  * @brief   Flash write.
  * @note    If the option @p MFS_CFG_WRITE_VERIFY is enabled then the flash
  *          is also read back for verification.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] offset    flash offset
- * @param[in] n         number of bytes to be read
- * @param[out] rp       pointer to the data buffer
+ * @param[in] offset    flash offset
+ * @param[in] n         number of bytes to be written
+ * @param[in] wp        pointer to the data buffer
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_flash_write(MFSDriver *devp,
+                                   flash_offset_t offset,
+                                   size_t n,
+                                   const uint8_t *wp) {
+  flash_error_t ferr;
+
+  ferr = flashProgram(devp->config->flashp, offset, n, wp);
+  if (ferr != FLASH_NO_ERROR) {
+    return MFS_ERR_FLASH_FAILURE;
+  }
+
+#if MFS_CFG_WRITE_VERIFY == TRUE
+  while (n > 0U) {
+    uint8_t buf[MFS_CFG_BUFFER_SIZE];
+    size_t chunk = n > sizeof (buf) ? sizeof (buf) : n;
+
+    RET_ON_ERROR(mfs_flash_read(devp, offset, chunk, buf));
+    if (memcmp(buf, wp, chunk) != 0) {
+      return MFS_ERR_FLASH_FAILURE;
+    }
+    offset += (flash_offset_t)chunk;
+    wp     += chunk;
+    n      -= chunk;
+  }
+#endif
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Flash copy.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] doffset   destination flash offset
+ * @param[in] soffset   source flash offset
+ * @param[in] n         number of bytes to be copied
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_flash_copy(MFSDriver *devp,
+                                  flash_offset_t doffset,
+                                  flash_offset_t soffset,
+                                  uint32_t n) {
+
+  while (n > 0U) {
+    uint8_t buf[MFS_CFG_BUFFER_SIZE];
+    uint32_t chunk = n > sizeof (buf) ? (uint32_t)sizeof (buf) : n;
+
+    RET_ON_ERROR(mfs_flash_read(devp, soffset, chunk, buf));
+    RET_ON_ERROR(mfs_flash_write(devp, doffset, chunk, buf));
+    soffset += chunk;
+    doffset += chunk;
+    n       -= chunk;
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Returns the sectors range of a bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      the bank identifier
+ * @param[out] endp     sector following the bank
+ * @return              The first sector of the bank.
+ *
+ * @notapi
+ */
+static flash_sector_t mfs_bank_sectors(MFSDriver *devp, mfs_bank_t bank,
+                                       flash_sector_t *endp) {
+
+  if (bank == MFS_BANK_0) {
+    *endp = devp->config->bank0_start + devp->config->bank0_sectors;
+    return devp->config->bank0_start;
+  }
+  *endp = devp->config->bank1_start + devp->config->bank1_sectors;
+  return devp->config->bank1_start;
+}
+
+/**
+ * @brief   Returns the offset of a bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      the bank identifier
+ * @return              The flash offset of the bank.
+ *
+ * @notapi
+ */
+static flash_offset_t mfs_bank_offset(MFSDriver *devp, mfs_bank_t bank) {
+  flash_sector_t end;
+
+  return flashGetSectorOffset(devp->config->flashp,
+                              mfs_bank_sectors(devp, bank, &end));
+}
+
+/**
+ * @brief   Erases a sector.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] sector    sector to be erased
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_sector_erase(MFSDriver *devp, flash_sector_t sector) {
+  flash_error_t ferr;
+
+  ferr = flashStartEraseSector(devp->config->flashp, sector);
+  if (ferr != FLASH_NO_ERROR) {
+    return MFS_ERR_FLASH_FAILURE;
+  }
+  ferr = flashWaitErase(devp->config->flashp);
+  if (ferr != FLASH_NO_ERROR) {
+    return MFS_ERR_FLASH_FAILURE;
+  }
+  ferr = flashVerifyErase(devp->config->flashp, sector);
+  if (ferr != FLASH_NO_ERROR) {
+    return MFS_ERR_FLASH_FAILURE;
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Erases and verifies all sectors belonging to a bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      bank to be erased
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_bank_erase(MFSDriver *devp, mfs_bank_t bank) {
+  flash_sector_t sector, end;
+
+  sector = mfs_bank_sectors(devp, bank, &end);
+  while (sector < end) {
+    RET_ON_ERROR(mfs_sector_erase(devp, sector));
+    sector++;
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Writes the validation header in a bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      bank to be validated
+ * @param[in] cnt       value for the flash usage counter
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_bank_set_header(MFSDriver *devp,
+                                       mfs_bank_t bank,
+                                       uint32_t cnt) {
+  mfs_bank_header_t header;
+
+  memset(&header, 0xFF, sizeof (mfs_bank_header_t));
+  header.magic1  = MFS_BANK_MAGIC_1;
+  header.magic2  = MFS_BANK_MAGIC_2;
+  header.counter = cnt;
+  header.next    = MFS_FIRST_OFFSET;
+  header.crc     = crc16(0xFFFFU,
+                         (const uint8_t *)&header,
+                         offsetof(mfs_bank_header_t, crc));
+
+  return mfs_flash_write(devp,
+                         mfs_bank_offset(devp, bank),
+                         sizeof (mfs_bank_header_t),
+                         (const uint8_t *)&header);
+}
+
+/**
+ * @brief   Reads and validates a record header.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] offset    record offset
+ * @param[in] limit     end of the bank
+ * @param[out] hdrp     pointer to the record header
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the header is valid.
+ * @retval MFS_ERR_NOT_FOUND if the header is erased.
+ * @retval MFS_ERR_INV_SIZE if the header is not valid.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_record_get_header(MFSDriver *devp,
+                                         flash_offset_t offset,
+                                         flash_offset_t limit,
+                                         mfs_data_header_t *hdrp) {
+  const uint8_t *p = (const uint8_t *)hdrp;
+  size_t i;
+
+  if (limit - offset < sizeof (mfs_data_header_t)) {
+    return MFS_ERR_NOT_FOUND;
+  }
+  RET_ON_ERROR(mfs_flash_read(devp, offset, sizeof (mfs_data_header_t),
+                              (uint8_t *)hdrp));
+
+  for (i = 0U; i < sizeof (mfs_data_header_t); i++) {
+    if (p[i] != (uint8_t)0xFF) {
+      break;
+    }
+  }
+  if (i >= sizeof (mfs_data_header_t)) {
+    return MFS_ERR_NOT_FOUND;
+  }
+
+  if ((hdrp->magic != MFS_HEADER_MAGIC) ||
+      ((uint32_t)hdrp->id >= (uint32_t)MFS_CFG_MAX_RECORDS) ||
+      (hdrp->size > (uint32_t)(limit - offset)) ||
+      (MFS_RECORD_SIZE(hdrp->size) > (uint32_t)(limit - offset))) {
+    return MFS_ERR_INV_SIZE;
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Verifies the CRC of a record.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] offset    record offset
+ * @param[in] hdrp      pointer to the record header
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the CRC is valid.
+ * @retval MFS_ERR_CRC  if the CRC is not valid.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_record_check(MFSDriver *devp,
+                                    flash_offset_t offset,
+                                    const mfs_data_header_t *hdrp) {
+  uint32_t n = hdrp->size;
+  uint16_t crc = 0xFFFFU;
+
+  offset += sizeof (mfs_data_header_t);
+  while (n > 0U) {
+    uint8_t buf[MFS_CFG_BUFFER_SIZE];
+    uint32_t chunk = n > sizeof (buf) ? (uint32_t)sizeof (buf) : n;
+
+    RET_ON_ERROR(mfs_flash_read(devp, offset, chunk, buf));
+    crc = crc16(crc, buf, chunk);
+    offset += chunk;
+    n      -= chunk;
+  }
+
+  return crc == hdrp->crc ? MFS_NO_ERROR : MFS_ERR_CRC;
+}
+
+/**
+ * @brief   Writes a record.
+ * @note    The header is written first, an interrupted write leaves a
+ *          record with a wrong CRC.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] offset    record offset
+ * @param[in] id        record numeric identifier
+ * @param[in] n         size of data, zero for an erase marker
+ * @param[in] buffer    pointer to the record data
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_record_write(MFSDriver *devp,
+                                    flash_offset_t offset,
+                                    uint32_t id,
+                                    uint32_t n,
+                                    const uint8_t *buffer) {
+  mfs_data_header_t header;
+
+  header.magic = MFS_HEADER_MAGIC;
+  header.crc   = crc16(0xFFFFU, buffer, n);
+  header.id    = (uint16_t)id;
+  header.flags = MFS_FLAGS_NONE;
+  header.size  = n;
+
+  RET_ON_ERROR(mfs_flash_write(devp, offset, sizeof (mfs_data_header_t),
+                               (const uint8_t *)&header));
+  if (n > 0U) {
+    RET_ON_ERROR(mfs_flash_write(devp,
+                                 offset + sizeof (mfs_data_header_t),
+                                 n, buffer));
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Copies a record.
+ * @note    The copy is a stand-alone record even if the original has been
+ *          written by a transaction.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] doffset   destination offset
+ * @param[in] soffset   source record offset
+ * @param[in] hdrp      pointer to the source record header
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_record_copy(MFSDriver *devp,
+                                   flash_offset_t doffset,
+                                   flash_offset_t soffset,
+                                   const mfs_data_header_t *hdrp) {
+  mfs_data_header_t header = *hdrp;
+
+  header.flags = MFS_FLAGS_NONE;
+  RET_ON_ERROR(mfs_flash_write(devp, doffset, sizeof (mfs_data_header_t),
+                               (const uint8_t *)&header));
+
+  return mfs_flash_copy(devp,
+                        doffset + sizeof (mfs_data_header_t),
+                        soffset + sizeof (mfs_data_header_t),
+                        header.size);
+}
+
+/**
+ * @brief   Scans the records of a bank.
+ * @details The offsets of the most recent valid instance of each record
+ *          are stored in the specified array, erased records have zero
+ *          offset.<br>
+ *          Records written by a transaction are only considered if the
+ *          transaction commit marker follows them, the marker CRC covers
+ *          the headers of all the records in the transaction.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      the bank identifier
+ * @param[out] instances array of record offsets
+ * @param[out] nextp    offset following the last record
+ * @param[out] partialp the bank contains damaged records
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_bank_scan(MFSDriver *devp,
+                                 mfs_bank_t bank,
+                                 flash_offset_t *instances,
+                                 flash_offset_t *nextp,
+                                 bool *partialp) {
+  flash_offset_t offset, limit, tx_offset;
+  mfs_data_header_t header;
+  uint16_t tx_crc;
+  bool tx_valid;
+  unsigned i;
+
+  for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+    instances[i] = 0U;
+  }
+  *partialp = false;
+  tx_offset = 0U;
+  tx_crc    = 0xFFFFU;
+  tx_valid  = true;
+
+  offset = mfs_bank_offset(devp, bank) + MFS_FIRST_OFFSET;
+  limit  = mfs_bank_offset(devp, bank) + devp->banks_size;
+  while (true) {
+    mfs_error_t err;
+
+    err = mfs_record_get_header(devp, offset, limit, &header);
+    if (err == MFS_ERR_NOT_FOUND) {
+      break;
+    }
+    if (err == MFS_ERR_INV_SIZE) {
+      /* Unreadable header, the following records are lost.*/
+      *partialp = true;
+      break;
+    }
+    RET_ON_ERROR(err);
+
+    if (header.flags == MFS_FLAGS_COMMIT) {
+      if ((tx_offset != 0U) && tx_valid && (header.crc == tx_crc)) {
+        /* Committed transaction, its records become visible.*/
+        while (tx_offset < offset) {
+          RET_ON_ERROR(mfs_flash_read(devp, tx_offset,
+                                      sizeof (mfs_data_header_t),
+                                      (uint8_t *)&header));
+          instances[header.id] = header.size > 0U ? tx_offset : 0U;
+          tx_offset += MFS_RECORD_SIZE(header.size);
+        }
+      }
+      else {
+        *partialp = true;
+      }
+      tx_offset = 0U;
+      tx_crc    = 0xFFFFU;
+      tx_valid  = true;
+      offset   += MFS_RECORD_SIZE(0U);
+      continue;
+    }
+
+    if ((tx_offset != 0U) && (header.flags != MFS_FLAGS_TRANSACTION)) {
+      /* Transaction not committed.*/
+      *partialp = true;
+      tx_offset = 0U;
+      tx_crc    = 0xFFFFU;
+      tx_valid  = true;
+    }
+
+    err = mfs_record_check(devp, offset, &header);
+    if (err == MFS_ERR_CRC) {
+      *partialp = true;
+      tx_valid  = false;
+    }
+    else if (err != MFS_NO_ERROR) {
+      return err;
+    }
+    else if (header.flags != MFS_FLAGS_TRANSACTION) {
+      instances[header.id] = header.size > 0U ? offset : 0U;
+    }
+
+    /* Transaction records are accounted when the commit marker is
+       found.*/
+    if (header.flags == MFS_FLAGS_TRANSACTION) {
+      if (tx_offset == 0U) {
+        tx_offset = offset;
+      }
+      tx_crc = crc16(tx_crc, (const uint8_t *)&header,
+                     sizeof (mfs_data_header_t));
+    }
+    offset += MFS_RECORD_SIZE(header.size);
+  }
+  if (tx_offset != 0U) {
+    /* Transaction not committed.*/
+    *partialp = true;
+  }
+  *nextp = offset;
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Computes the space used by the live records.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] instances array of record offsets
+ * @param[out] usedp    used space including the bank header
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_used_space(MFSDriver *devp,
+                                  const flash_offset_t *instances,
+                                  uint32_t *usedp) {
+  mfs_data_header_t header;
+  unsigned i;
+
+  *usedp = MFS_FIRST_OFFSET;
+  for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+    if (instances[i] != 0U) {
+      RET_ON_ERROR(mfs_flash_read(devp, instances[i],
+                                  sizeof (mfs_data_header_t),
+                                  (uint8_t *)&header));
+      *usedp += MFS_RECORD_SIZE(header.size);
+    }
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Copies all records from a bank to another.
+ * @pre     The destination bank must be erased.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] sbank     source bank
+ * @param[in] dbank     destination bank
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_bank_copy(MFSDriver *devp,
+                                 mfs_bank_t sbank,
+                                 mfs_bank_t dbank) {
+  flash_offset_t doffset, next;
+  mfs_data_header_t header;
+  bool partial;
+  unsigned i;
+
+  RET_ON_ERROR(mfs_bank_scan(devp, sbank, devp->instances, &next, &partial));
+
+  doffset = mfs_bank_offset(devp, dbank) + MFS_FIRST_OFFSET;
+  for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+    if (devp->instances[i] != 0U) {
+      RET_ON_ERROR(mfs_flash_read(devp, devp->instances[i],
+                                  sizeof (mfs_data_header_t),
+                                  (uint8_t *)&header));
+      RET_ON_ERROR(mfs_record_copy(devp, doffset, devp->instances[i],
+                                   &header));
+      doffset += MFS_RECORD_SIZE(header.size);
+    }
+  }
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Selects a bank as current.
+ * @note    The other bank is assumed erased.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank      bank to be mounted
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_bank_mount(MFSDriver *devp, mfs_bank_t bank) {
+  mfs_bank_header_t header;
+  bool partial;
+
+  RET_ON_ERROR(mfs_flash_read(devp, mfs_bank_offset(devp, bank),
+                              sizeof (mfs_bank_header_t),
+                              (uint8_t *)&header));
+  RET_ON_ERROR(mfs_bank_scan(devp, bank, devp->instances,
+                             &devp->next_offset, &partial));
+  RET_ON_ERROR(mfs_used_space(devp, devp->instances, &devp->used_space));
+
+  devp->current_bank = bank;
+  devp->counter      = header.counter;
+  devp->gc_state     = MFS_GC_IDLE;
+
+  return MFS_NO_ERROR;
+}
+
+/**
+ * @brief   Determines the state of a flash bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[in] bank          the bank identifier
+ * @param[out] cntp         bank counter value, only valid if the bank is not
+ *                          in the @p MFS_BANK_GARBAGE or @p MFS_BANK_ERASED
+ *                          states.
+ *
+ * @return                  The bank state.
+ * @retval MFS_BANK_ERASED  if the bank is fully erased.
+ * @retval MFS_BANK_OK      if the bank contains valid data.
+ * @retval MFS_BANK_PARTIAL if the bank contains errors but the data is still
+ *                          readable.
+ * @retval MFS_BANK_GARBAGE if the bank contains unreadable garbage.
+ */
+static mfs_bank_state_t mfs_get_bank_state(MFSDriver *devp,
+                                           mfs_bank_t bank,
+                                           uint32_t *cntp) {
+  mfs_bank_header_t header;
+  flash_offset_t next;
+  bool partial;
+
+  if (mfs_flash_read(devp, mfs_bank_offset(devp, bank),
+                     sizeof (mfs_bank_header_t),
+                     (uint8_t *)&header) != MFS_NO_ERROR) {
+    return MFS_BANK_GARBAGE;
+  }
+
+  if ((header.magic1 != MFS_BANK_MAGIC_1) ||
+      (header.magic2 != MFS_BANK_MAGIC_2) ||
+      (header.crc != crc16(0xFFFFU, (const uint8_t *)&header,
+                           offsetof(mfs_bank_header_t, crc)))) {
+    flash_sector_t sector, end;
+
+    /* Not a valid bank, it could be erased.*/
+    sector = mfs_bank_sectors(devp, bank, &end);
+    while (sector < end) {
+      if (flashVerifyErase(devp->config->flashp, sector) != FLASH_NO_ERROR) {
+        return MFS_BANK_GARBAGE;
+      }
+      sector++;
+    }
+    return MFS_BANK_ERASED;
+  }
+
+  *cntp = header.counter;
+
+  /* The instances array is used as scratch area, it is rebuilt when the
+     bank is mounted.*/
+  if (mfs_bank_scan(devp, bank, devp->instances,
+                    &next, &partial) != MFS_NO_ERROR) {
+    return MFS_BANK_GARBAGE;
+  }
+
+  return partial ? MFS_BANK_PARTIAL : MFS_BANK_OK;
+}
+
+
+/**
+ * @brief   Returns the free space in the current bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The free space.
+ *
+ * @notapi
+ */
+static uint32_t mfs_free_space(MFSDriver *devp) {
+
+  return devp->banks_size -
+         (uint32_t)(devp->next_offset -
+                    mfs_bank_offset(devp, devp->current_bank));
+}
+
+/**
+ * @brief   Returns the space taken by obsolete records in the current bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The reclaimable space.
+ *
+ * @notapi
+ */
+static uint32_t mfs_reclaimable_space(MFSDriver *devp) {
+
+  return (uint32_t)(devp->next_offset -
+                    mfs_bank_offset(devp, devp->current_bank)) -
+         devp->used_space;
+}
+
+/**
+ * @brief   Checks if there is work for the background compaction.
+ * @details A compaction is started when the free space falls under the
+ *          threshold and the compaction would bring it back above.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The compaction has work to do.
+ *
+ * @notapi
+ */
+static bool mfs_gc_pending(MFSDriver *devp) {
+  uint32_t free;
+
+  if (devp->gc_state != MFS_GC_IDLE) {
+    return true;
+  }
+
+  free = mfs_free_space(devp);
+  return (devp->config->gc_threshold > 0U) &&
+         (free < devp->config->gc_threshold) &&
+         (free + mfs_reclaimable_space(devp) >= devp->config->gc_threshold);
+}
+
+/**
+ * @brief   Copies the next record changed since it was examined.
+ * @details When all records are copied the spare bank is validated and
+ *          becomes the current bank, the old bank then has to be erased.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_gc_copy_step(MFSDriver *devp) {
+  mfs_bank_t spare = devp->current_bank == MFS_BANK_0 ? MFS_BANK_1 :
+                                                        MFS_BANK_0;
+  flash_offset_t limit = mfs_bank_offset(devp, spare) + devp->banks_size;
+  mfs_data_header_t header;
+  unsigned i;
+
+  for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+    uint32_t id = devp->gc_id;
+    uint32_t size;
+
+    devp->gc_id = (devp->gc_id + 1U) % (uint32_t)MFS_CFG_MAX_RECORDS;
+    if (devp->instances[id] == devp->gc_sources[id]) {
+      continue;
+    }
+
+    /* A record erased after being copied needs an erase marker, else
+       the current instance is copied.*/
+    header.size = 0U;
+    if (devp->instances[id] != 0U) {
+      RET_ON_ERROR(mfs_flash_read(devp, devp->instances[id],
+                                  sizeof (mfs_data_header_t),
+                                  (uint8_t *)&header));
+    }
+    size = MFS_RECORD_SIZE(header.size);
+
+    /* Records rewritten during the compaction can fill the spare bank,
+       restarting in that case.*/
+    if (size > (uint32_t)(limit - devp->gc_next_offset)) {
+      devp->gc_state  = MFS_GC_ERASING;
+      devp->gc_sector = 0U;
+      return MFS_NO_ERROR;
+    }
+
+    if (devp->instances[id] != 0U) {
+      RET_ON_ERROR(mfs_record_copy(devp, devp->gc_next_offset,
+                                   devp->instances[id], &header));
+      devp->gc_instances[id] = devp->gc_next_offset;
+    }
+    else {
+      RET_ON_ERROR(mfs_record_write(devp, devp->gc_next_offset,
+                                    id, 0U, NULL));
+      devp->gc_instances[id] = 0U;
+    }
+    devp->gc_sources[id]  = devp->instances[id];
+    devp->gc_next_offset += size;
+
+    return MFS_NO_ERROR;
+  }
+
+  /* All records copied, the spare bank becomes the current one.*/
+  RET_ON_ERROR(mfs_bank_set_header(devp, spare, devp->counter + 1U));
+  devp->current_bank = spare;
+  devp->counter++;
+  devp->next_offset  = devp->gc_next_offset;
+  memcpy(devp->instances, devp->gc_instances, sizeof (devp->instances));
+  devp->gc_state     = MFS_GC_ERASING;
+  devp->gc_sector    = 0U;
+  devp->gc_count++;
+
+  return mfs_used_space(devp, devp->instances, &devp->used_space);
+}
+
+/**
+ * @brief   Performs a compaction step.
+ * @details A step starts a compaction, erases one sector of the spare bank
+ *          or copies one record into the spare bank.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
  * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
@@ -128,25 +944,51 @@ uint16_t crc16(uint16_t crc, const uint8_t *data, size_t n) {
  *
  * @notapi
  */
-static mfs_error_t mfs_flash_write(MFSDriver *devp,
-                                   flash_offset_t offset,
-                                   size_t n, const
-                                   uint8_t *p) {
-  flash_error_t ferr;
+static mfs_error_t mfs_gc_step(MFSDriver *devp) {
+  mfs_bank_t spare = devp->current_bank == MFS_BANK_0 ? MFS_BANK_1 :
+                                                        MFS_BANK_0;
+  flash_sector_t sector, end;
+  unsigned i;
 
-  ferr = flashProgram(devp->config->flashp, offset, n, p);
-  if (ferr != FLASH_NO_ERROR) {
-    return MFS_ERR_FLASH_FAILURE;
+  switch (devp->gc_state) {
+  case MFS_GC_IDLE:
+    /* Starting a compaction, the spare bank is erased.*/
+    for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+      devp->gc_sources[i]   = 0U;
+      devp->gc_instances[i] = 0U;
+    }
+    devp->gc_id          = 0U;
+    devp->gc_next_offset = mfs_bank_offset(devp, spare) + MFS_FIRST_OFFSET;
+    devp->gc_state       = MFS_GC_COPYING;
+    return MFS_NO_ERROR;
+
+  case MFS_GC_ERASING:
+    /* Erasing the spare bank one sector at time.*/
+    sector = mfs_bank_sectors(devp, spare, &end) + devp->gc_sector;
+    RET_ON_ERROR(mfs_sector_erase(devp, sector));
+    devp->gc_sector++;
+    if (sector + 1U >= end) {
+      devp->gc_state = MFS_GC_IDLE;
+    }
+    return MFS_NO_ERROR;
+
+  case MFS_GC_COPYING:
+    return mfs_gc_copy_step(devp);
+
+  default:
+    break;
   }
 
-  return MFS_NO_ERROR;
+  return MFS_ERR_INTERNAL;
 }
 
 /**
- * @brief   Erases and verifies all sectors belonging to a bank.
+ * @brief   Performs a whole compaction.
+ * @details An ongoing compaction is completed, else a new one is performed.
+ *          The old bank is erased immediately only if there is no
+ *          background compaction.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] bank      bank to be erased
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
  * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
@@ -154,148 +996,172 @@ static mfs_error_t mfs_flash_write(MFSDriver *devp,
  *
  * @notapi
  */
-static mfs_error_t mfs_bank_erase(MFSDriver *devp, mfs_bank_t bank) {
-  flash_sector_t sector, end;
+static mfs_error_t mfs_gc_complete(MFSDriver *devp) {
+  uint32_t count = devp->gc_count;
 
-  if (bank == MFS_BANK_0) {
-    sector = devp->config->bank0_start;
-    end    = devp->config->bank0_start + devp->config->bank0_sectors;
-  }
-  else {
-    sector = devp->config->bank1_start;
-    end    = devp->config->bank1_start + devp->config->bank1_sectors;
+  while (devp->gc_count == count) {
+    RET_ON_ERROR(mfs_gc_step(devp));
   }
 
-  while (sector < end) {
-    flash_error_t ferr;
-
-    ferr = flashStartEraseSector(devp->config->flashp, sector);
-    if (ferr != FLASH_NO_ERROR) {
-      return MFS_ERR_FLASH_FAILURE;
-    }
-    ferr = flashWaitErase(devp->config->flashp);
-    if (ferr != FLASH_NO_ERROR) {
-      return MFS_ERR_FLASH_FAILURE;
-    }
-    ferr = flashVerifyErase(devp->config->flashp, sector);
-    if (ferr != FLASH_NO_ERROR) {
-      return MFS_ERR_FLASH_FAILURE;
+  if (devp->config->gc_threshold == 0U) {
+    while (devp->gc_state == MFS_GC_ERASING) {
+      RET_ON_ERROR(mfs_gc_step(devp));
     }
-
-    sector++;
   }
 
   return MFS_NO_ERROR;
 }
 
 /**
- * @brief   Writes the validation header in a bank.
+ * @brief   Makes room for a record in the current bank.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] bank      bank to be validated
- * @param[in] cnt       value for the flash usage counter
+ * @param[in] size      space required by the record
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_WARN_GC  if the operation has been completed but a
+ *                      compaction has been performed.
+ * @retval MFS_ERR_OUT_OF_MEM if there is not enough space.
  * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
  *                      failures.
  *
  * @notapi
  */
-static mfs_error_t mfs_bank_set_header(MFSDriver *devp,
-                                       mfs_bank_t bank,
-                                       uint32_t cnt) {
-  flash_sector_t sector;
-  mfs_bank_header_t header;
+static mfs_error_t mfs_make_room(MFSDriver *devp, uint32_t size) {
+  unsigned i;
 
-  if (bank == MFS_BANK_0) {
-    sector = devp->config->bank0_start;
-  }
-  else {
-    sector = devp->config->bank1_start;
+  /* A compaction started in background can leave some waste in the
+     new bank, a second one leaves only the live records.*/
+  for (i = 0U; i < 2U; i++) {
+    if (mfs_free_space(devp) >= size) {
+      return i == 0U ? MFS_NO_ERROR : MFS_WARN_GC;
+    }
+    RET_ON_ERROR(mfs_gc_complete(devp));
   }
 
-  header.magic1  = MFS_BANK_MAGIC_1;
-  header.magic1  = MFS_BANK_MAGIC_1;
-  header.counter = cnt;
-  header.next    = sizeof (mfs_bank_header_t);
-  header.crc     = crc16(0xFFFFU,
-                         (const uint8_t *)&header,
-                         sizeof (flash_sector_t) - sizeof (uint16_t));
-
-  return mfs_flash_write(devp,
-                         flashGetSectorOffset(devp->config->flashp, sector),
-                         sizeof (mfs_bank_header_t),
-                         (const uint8_t *)&header);
+  return mfs_free_space(devp) >= size ? MFS_WARN_GC : MFS_ERR_OUT_OF_MEM;
 }
 
 /**
- * @brief   Copies all records from a bank to another.
+ * @brief   Wakes up the background compaction if there is work to do.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] sbank     source bank
- * @param[in] dbank     destination bank
- * @return              The operation status.
- * @retval MFS_NO_ERROR if the operation has been successfully completed.
- * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
- *                      failures.
  *
  * @notapi
  */
-static mfs_error_t mfs_bank_copy(MFSDriver *devp,
-                                 mfs_bank_t sbank,
-                                 mfs_bank_t dbank) {
-
-  (void)devp;
-  (void)sbank;
-  (void)dbank;
+static void mfs_gc_signal(MFSDriver *devp) {
 
-  return MFS_NO_ERROR;
+  osalSysLock();
+  if (mfs_gc_pending(devp)) {
+    osalThreadDequeueNextI(&devp->gc_queue, MSG_OK);
+    osalOsRescheduleS();
+  }
+  osalSysUnlock();
 }
 
+#if (MFS_CFG_TRANSACTION_SIZE > 0) || defined(__DOXYGEN__)
 /**
- * @brief   Selects a bank as current.
+ * @brief   Stages a record in the transaction buffer.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] bank      bank to be erased
+ * @param[in] id        record numeric identifier
+ * @param[in] n         size of data, zero for an erase marker
+ * @param[in] buffer    pointer to the record data
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_OUT_OF_MEM if the transaction buffer is full.
  *
  * @notapi
  */
-static mfs_error_t mfs_bank_mount(MFSDriver *devp, mfs_bank_t bank) {
+static mfs_error_t mfs_tx_stage(MFSDriver *devp, uint32_t id,
+                                uint32_t n, const uint8_t *buffer) {
+  mfs_data_header_t header;
+  uint8_t *p;
+
+  if (MFS_RECORD_SIZE(n) > (uint32_t)MFS_CFG_TRANSACTION_SIZE -
+                           devp->tx_size) {
+    return MFS_ERR_OUT_OF_MEM;
+  }
 
-  (void)devp;
-  (void)bank;
+  header.magic = MFS_HEADER_MAGIC;
+  header.crc   = crc16(0xFFFFU, buffer, n);
+  header.id    = (uint16_t)id;
+  header.flags = MFS_FLAGS_TRANSACTION;
+  header.size  = n;
+
+  p = &devp->tx_buffer[devp->tx_size];
+  memset(p, 0xFF, MFS_RECORD_SIZE(n));
+  memcpy(p, &header, sizeof (mfs_data_header_t));
+  if (n > 0U) {
+    memcpy(p + sizeof (mfs_data_header_t), buffer, n);
+  }
+  devp->tx_size += MFS_RECORD_SIZE(n);
 
   return MFS_NO_ERROR;
 }
 
 /**
- * @brief   Determines the state of a flash bank.
+ * @brief   Checks if a record exists taking the staged records in account.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
- * @param[in] bank          the bank identifier
- * @param[out] cntp         bank counter value, only valid if the bank is not
- *                          in the @p MFS_BANK_GARBAGE or @p MFS_BANK_ERASED
- *                          states.
+ * @param[in] id        record numeric identifier
+ * @return              The record exists.
  *
- * @return                  The bank state.
- * @retval MFS_BANK_ERASED  if the bank is fully erased.
- * @retval MFS_BANK_OK      if the bank contains valid data.
- * @retval MFS_BANK_PARTIAL if the bank contains errors but the data is still
- *                          readable.
- * @retval MFS_BANK_GARBAGE if the bank contains unreadable garbage.
+ * @notapi
  */
-static mfs_bank_state_t mfs_get_bank_state(MFSDriver *devp,
-                                           mfs_bank_t bank,
-                                           uint32_t *cntp) {
+static bool mfs_tx_exists(MFSDriver *devp, uint32_t id) {
+  mfs_data_header_t header;
+  uint32_t offset;
+  bool exists;
+
+  exists = devp->instances[id] != 0U;
+  for (offset = 0U; offset < devp->tx_size;
+       offset += MFS_RECORD_SIZE(header.size)) {
+    memcpy(&header, &devp->tx_buffer[offset], sizeof (mfs_data_header_t));
+    if ((uint32_t)header.id == id) {
+      exists = header.size > 0U;
+    }
+  }
+
+  return exists;
+}
 
-  (void)devp;
-  (void)bank;
-  (void)cntp;
+/**
+ * @brief   Makes the records of a written transaction visible.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @notapi
+ */
+static mfs_error_t mfs_tx_apply(MFSDriver *devp) {
+  mfs_data_header_t header, old;
+  uint32_t offset;
+
+  for (offset = 0U; offset < devp->tx_size;
+       offset += MFS_RECORD_SIZE(header.size)) {
+    memcpy(&header, &devp->tx_buffer[offset], sizeof (mfs_data_header_t));
+    if (devp->instances[header.id] != 0U) {
+      RET_ON_ERROR(mfs_flash_read(devp, devp->instances[header.id],
+                                  sizeof (mfs_data_header_t),
+                                  (uint8_t *)&old));
+      devp->used_space -= MFS_RECORD_SIZE(old.size);
+    }
+    if (header.size > 0U) {
+      devp->instances[header.id] = devp->next_offset + offset;
+      devp->used_space += MFS_RECORD_SIZE(header.size);
+    }
+    else {
+      devp->instances[header.id] = 0U;
+    }
+  }
 
-  return MFS_BANK_OK;
+  return MFS_NO_ERROR;
 }
+#endif /* MFS_CFG_TRANSACTION_SIZE > 0 */
 
 /**
  * @brief   Performs a flash partition mount attempt.
@@ -464,7 +1330,7 @@ static mfs_error_t mfs_try_mount(MFSDriver *devp) {
     /* Bank zero is unreadable, bank one has problems.*/
     RET_ON_ERROR(mfs_bank_erase(devp, MFS_BANK_0));
     RET_ON_ERROR(mfs_bank_copy(devp, MFS_BANK_1, MFS_BANK_0));
-    RET_ON_ERROR(mfs_bank_set_header(devp, MFS_BANK_0, cnt0 + 1));
+    RET_ON_ERROR(mfs_bank_set_header(devp, MFS_BANK_0, cnt1 + 1));
     RET_ON_ERROR(mfs_bank_erase(devp, MFS_BANK_1));
     RET_ON_ERROR(mfs_bank_mount(devp, MFS_BANK_0));
     return MFS_WARN_REPAIR;
@@ -500,8 +1366,12 @@ void mfsObjectInit(MFSDriver *devp) {
 
   osalDbgCheck(devp != NULL);
 
-  devp->state = MFS_STOP;
-  devp->config = NULL;
+  devp->state    = MFS_STOP;
+  devp->config   = NULL;
+  devp->gc_state = MFS_GC_IDLE;
+  devp->gc_count = 0U;
+  osalThreadQueueObjectInit(&devp->gc_queue);
+  osalMutexObjectInit(&devp->mutex);
 }
 
 /**
@@ -518,11 +1388,25 @@ void mfsStart(MFSDriver *devp, const MFSConfig *config) {
   osalDbgAssert(devp->state != MFS_UNINIT, "invalid state");
 
   if (devp->state == MFS_STOP) {
+    flash_sector_t sector;
+    uint32_t size1;
+
+    devp->config     = config;
+    devp->banks_size = 0U;
+    size1            = 0U;
+    for (sector = 0U; sector < config->bank0_sectors; sector++) {
+      devp->banks_size += flashGetSectorSize(config->flashp,
+                                             config->bank0_start + sector);
+    }
+    for (sector = 0U; sector < config->bank1_sectors; sector++) {
+      size1 += flashGetSectorSize(config->flashp,
+                                  config->bank1_start + sector);
+    }
+    osalDbgAssert(devp->banks_size == size1, "banks size mismatch");
 
-    devp->config = config;
     devp->state  = MFS_READY;
   }
-} 
+}
 
 /**
  * @brief   Deactivates a MFS driver.
@@ -560,24 +1444,50 @@ void mfsStop(MFSDriver *devp) {
 mfs_error_t mfsMount(MFSDriver *devp) {
   unsigned i;
 
+  osalDbgCheck(devp != NULL);
+  osalDbgAssert((devp->state == MFS_READY) || (devp->state == MFS_MOUNTED),
+                "invalid state");
+
+  osalMutexLock(&devp->mutex);
+  devp->state = MFS_READY;
+
   /* Attempting to mount the managed partition.*/
   for (i = 0; i < MFS_CFG_MAX_REPAIR_ATTEMPTS; i++) {
     mfs_error_t err;
 
     err = mfs_try_mount(devp);
-    if (!MFS_IS_ERROR(err))
+    if (!MFS_IS_ERROR(err)) {
+      devp->state = MFS_MOUNTED;
+      osalMutexUnlock(&devp->mutex);
+      mfs_gc_signal(devp);
       return err;
+    }
   }
 
+  osalMutexUnlock(&devp->mutex);
   return MFS_ERR_FLASH_FAILURE;
 }
 
 /**
  * @brief   Unmounts a manage flash storage.
+ * @details A background compaction in progress is abandoned, it is
+ *          restarted after the next mount.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ *
+ * @api
  */
 mfs_error_t mfsUnmount(MFSDriver *devp) {
 
-  (void)devp;
+  osalDbgCheck(devp != NULL);
+
+  osalMutexLock(&devp->mutex);
+  if (MFS_IS_MOUNTED(devp)) {
+    devp->state = MFS_READY;
+  }
+  osalMutexUnlock(&devp->mutex);
 
   return MFS_NO_ERROR;
 }
@@ -594,22 +1504,62 @@ mfs_error_t mfsUnmount(MFSDriver *devp) {
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
  * @retval MFS_ERR_NOT_FOUND if the specified id does not exists.
  * @retval MFS_ERR_CRC  if retrieved data has a CRC error.
+ * @retval MFS_ERR_INV_SIZE if the buffer is smaller than the record.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
  *
  * @api
  */
 mfs_error_t mfsReadRecord(MFSDriver *devp, uint32_t id,
                           uint32_t *np, uint8_t *buffer) {
+  mfs_data_header_t header;
+  flash_offset_t offset;
+  mfs_error_t err;
+
+  osalDbgCheck((devp != NULL) && (id < (uint32_t)MFS_CFG_MAX_RECORDS) &&
+               (np != NULL) && (buffer != NULL));
+  osalDbgAssert(MFS_IS_MOUNTED(devp), "invalid state");
+
+  osalMutexLock(&devp->mutex);
+
+  offset = devp->instances[id];
+  if (offset == 0U) {
+    osalMutexUnlock(&devp->mutex);
+    return MFS_ERR_NOT_FOUND;
+  }
+
+  err = mfs_flash_read(devp, offset, sizeof (mfs_data_header_t),
+                       (uint8_t *)&header);
+  if (err == MFS_NO_ERROR) {
+    if (header.size > *np) {
+      err = MFS_ERR_INV_SIZE;
+    }
+    else {
+      err = mfs_flash_read(devp, offset + sizeof (mfs_data_header_t),
+                           header.size, buffer);
+    }
+  }
+  osalMutexUnlock(&devp->mutex);
 
-  (void)devp;
-  (void)id;
-  (void)np;
-  (void)buffer;
+  if (err != MFS_NO_ERROR) {
+    return err;
+  }
+  if (crc16(0xFFFFU, buffer, header.size) != header.crc) {
+    return MFS_ERR_CRC;
+  }
+  *np = header.size;
 
   return MFS_NO_ERROR;
 }
 
 /**
  * @brief   Creates or updates a data record.
+ * @note    If there is not enough free space in the current bank then a
+ *          compaction is performed, in background compaction mode this
+ *          only happens if the compaction does not keep up with the
+ *          writes.
+ * @note    Within a transaction the record is only staged, it is written
+ *          on commit.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
  * @param[in] id        record numeric identifier
@@ -617,6 +1567,11 @@ mfs_error_t mfsReadRecord(MFSDriver *devp, uint32_t id,
  * @param[in] buffer    pointer to a buffer for record data
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_WARN_GC  if the operation has been completed but a
+ *                      compaction has been performed.
+ * @retval MFS_ERR_INV_SIZE if the record is larger than a bank.
+ * @retval MFS_ERR_OUT_OF_MEM if there is not enough space or the
+ *                      transaction buffer is full.
  * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
  *                      failures.
  *
@@ -624,33 +1579,346 @@ mfs_error_t mfsReadRecord(MFSDriver *devp, uint32_t id,
  */
 mfs_error_t mfsWriteRecord(MFSDriver *devp, uint32_t id,
                            uint32_t n, const uint8_t *buffer) {
+  mfs_data_header_t header;
+  mfs_error_t err, warn;
+  uint32_t size, old;
 
-  (void)devp;
-  (void)id;
-  (void)n;
-  (void)buffer;
+  osalDbgCheck((devp != NULL) && (id < (uint32_t)MFS_CFG_MAX_RECORDS) &&
+               (n > 0U) && (buffer != NULL));
+  osalDbgAssert(MFS_IS_MOUNTED(devp), "invalid state");
 
-  return MFS_NO_ERROR;
+  /* Room for an erase marker is always kept.*/
+  if (n > devp->banks_size - MFS_FIRST_OFFSET - (2U * MFS_RECORD_SIZE(0))) {
+    return MFS_ERR_INV_SIZE;
+  }
+  size = MFS_RECORD_SIZE(n);
+
+  osalMutexLock(&devp->mutex);
+
+#if MFS_CFG_TRANSACTION_SIZE > 0
+  if (devp->state == MFS_TRANSACTION) {
+    err = mfs_tx_stage(devp, id, n, buffer);
+    osalMutexUnlock(&devp->mutex);
+    return err;
+  }
+#endif
+
+  old = 0U;
+  if (devp->instances[id] != 0U) {
+    err = mfs_flash_read(devp, devp->instances[id],
+                         sizeof (mfs_data_header_t), (uint8_t *)&header);
+    if (err != MFS_NO_ERROR) {
+      osalMutexUnlock(&devp->mutex);
+      return err;
+    }
+    old = MFS_RECORD_SIZE(header.size);
+  }
+
+  /* The old instance is obsoleted only after the new one has been
+     written, both must fit in a bank.*/
+  if (devp->used_space + size > devp->banks_size - MFS_RECORD_SIZE(0)) {
+    osalMutexUnlock(&devp->mutex);
+    return MFS_ERR_OUT_OF_MEM;
+  }
+
+  warn = mfs_make_room(devp, size);
+  if (MFS_IS_ERROR(warn)) {
+    osalMutexUnlock(&devp->mutex);
+    return warn;
+  }
+
+  err = mfs_record_write(devp, devp->next_offset, id, n, buffer);
+  if (err == MFS_NO_ERROR) {
+    devp->instances[id] = devp->next_offset;
+    devp->next_offset  += size;
+    devp->used_space    = devp->used_space - old + size;
+  }
+  osalMutexUnlock(&devp->mutex);
+
+  mfs_gc_signal(devp);
+
+  return err != MFS_NO_ERROR ? err : warn;
 }
 
 /**
  * @brief   Erases a data record.
+ * @note    Within a transaction the erase is only staged, it is written
+ *          on commit.
  *
  * @param[in] devp      pointer to the @p MFSDriver object
  * @param[in] id        record numeric identifier
  * @return              The operation status.
  * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_WARN_GC  if the operation has been completed but a
+ *                      compaction has been performed.
+ * @retval MFS_ERR_NOT_FOUND if the specified id does not exists.
+ * @retval MFS_ERR_OUT_OF_MEM if the transaction buffer is full.
  * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
  *                      failures.
  *
  * @api
  */
 mfs_error_t mfsEraseRecord(MFSDriver *devp, uint32_t id) {
+  mfs_data_header_t header;
+  mfs_error_t err, warn;
 
-  (void)devp;
-  (void)id;
+  osalDbgCheck((devp != NULL) && (id < (uint32_t)MFS_CFG_MAX_RECORDS));
+  osalDbgAssert(MFS_IS_MOUNTED(devp), "invalid state");
 
-  return MFS_NO_ERROR;
+  osalMutexLock(&devp->mutex);
+
+#if MFS_CFG_TRANSACTION_SIZE > 0
+  if (devp->state == MFS_TRANSACTION) {
+    err = mfs_tx_exists(devp, id) ? mfs_tx_stage(devp, id, 0U, NULL) :
+                                    MFS_ERR_NOT_FOUND;
+    osalMutexUnlock(&devp->mutex);
+    return err;
+  }
+#endif
+
+  if (devp->instances[id] == 0U) {
+    osalMutexUnlock(&devp->mutex);
+    return MFS_ERR_NOT_FOUND;
+  }
+
+  warn = mfs_make_room(devp, MFS_RECORD_SIZE(0));
+  if (MFS_IS_ERROR(warn)) {
+    osalMutexUnlock(&devp->mutex);
+    return warn;
+  }
+
+  err = mfs_flash_read(devp, devp->instances[id],
+                       sizeof (mfs_data_header_t), (uint8_t *)&header);
+  if (err == MFS_NO_ERROR) {
+    err = mfs_record_write(devp, devp->next_offset, id, 0U, NULL);
+  }
+  if (err == MFS_NO_ERROR) {
+    devp->instances[id] = 0U;
+    devp->next_offset  += MFS_RECORD_SIZE(0);
+    devp->used_space   -= MFS_RECORD_SIZE(header.size);
+  }
+  osalMutexUnlock(&devp->mutex);
+
+  mfs_gc_signal(devp);
+
+  return err != MFS_NO_ERROR ? err : warn;
+}
+
+/**
+ * @brief   Performs a background compaction step.
+ * @details Waits until there is compaction work then performs a step, the
+ *          mutual exclusion is released between steps so the clients are
+ *          delayed at most by a record copy or a sector erase.<br>
+ *          A compaction is started when the free space in the current bank
+ *          falls under the configured threshold, the spare bank is erased
+ *          one sector at time after each compaction.
+ * @note    This function is meant to be called in a loop by a dedicated
+ *          thread with lower priority than the clients.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @api
+ */
+mfs_error_t mfsServeCompaction(MFSDriver *devp) {
+  mfs_error_t err;
+
+  osalDbgCheck(devp != NULL);
+
+  osalSysLock();
+  while (!MFS_IS_MOUNTED(devp) || !mfs_gc_pending(devp)) {
+    (void) osalThreadEnqueueTimeoutS(&devp->gc_queue, TIME_INFINITE);
+  }
+  osalSysUnlock();
+
+  err = MFS_NO_ERROR;
+  osalMutexLock(&devp->mutex);
+  if (MFS_IS_MOUNTED(devp) && mfs_gc_pending(devp)) {
+    err = mfs_gc_step(devp);
+  }
+  osalMutexUnlock(&devp->mutex);
+
+  return err;
+}
+
+/**
+ * @brief   Returns the compaction status.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @param[out] gsp      pointer to the @p mfs_gc_status_t structure
+ *
+ * @api
+ */
+void mfsGetCompactionStatus(MFSDriver *devp, mfs_gc_status_t *gsp) {
+  mfs_data_header_t header;
+  flash_sector_t start, end;
+  mfs_bank_t spare;
+  unsigned i;
+
+  osalDbgCheck((devp != NULL) && (gsp != NULL));
+  osalDbgAssert(MFS_IS_MOUNTED(devp), "invalid state");
+
+  osalMutexLock(&devp->mutex);
+
+  gsp->state       = devp->gc_state;
+  gsp->free        = mfs_free_space(devp);
+  gsp->reclaimable = mfs_reclaimable_space(devp);
+  gsp->done        = 0U;
+  gsp->total       = 0U;
+  spare = devp->current_bank == MFS_BANK_0 ? MFS_BANK_1 : MFS_BANK_0;
+  if (devp->gc_state == MFS_GC_ERASING) {
+    start      = mfs_bank_sectors(devp, spare, &end);
+    gsp->done  = (uint32_t)devp->gc_sector;
+    gsp->total = (uint32_t)(end - start);
+  }
+  else if (devp->gc_state == MFS_GC_COPYING) {
+    gsp->done  = (uint32_t)(devp->gc_next_offset -
+                            mfs_bank_offset(devp, spare)) - MFS_FIRST_OFFSET;
+    gsp->total = gsp->done;
+    for (i = 0U; i < MFS_CFG_MAX_RECORDS; i++) {
+      if ((devp->instances[i] != devp->gc_sources[i]) &&
+          (devp->instances[i] != 0U) &&
+          (mfs_flash_read(devp, devp->instances[i],
+                          sizeof (mfs_data_header_t),
+                          (uint8_t *)&header) == MFS_NO_ERROR)) {
+        gsp->total += MFS_RECORD_SIZE(header.size);
+      }
+    }
+  }
+
+  osalMutexUnlock(&devp->mutex);
+}
+
+#if (MFS_CFG_TRANSACTION_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Starts a transaction.
+ * @details The following writes and erases are staged in RAM until the
+ *          transaction is committed, the staged records are then written
+ *          as a contiguous batch followed by a commit marker. After a
+ *          power loss either all or none of the records in the
+ *          transaction are found.
+ * @note    Reads return the committed records, staged records are not
+ *          visible until commit.
+ * @note    There is a single transaction per storage, writes from other
+ *          threads while a transaction is open become part of it.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ *
+ * @api
+ */
+void mfsStartTransaction(MFSDriver *devp) {
+
+  osalDbgCheck(devp != NULL);
+  osalDbgAssert(devp->state == MFS_MOUNTED, "invalid state");
+
+  osalMutexLock(&devp->mutex);
+  devp->tx_size = 0U;
+  devp->state   = MFS_TRANSACTION;
+  osalMutexUnlock(&devp->mutex);
+}
+
+/**
+ * @brief   Commits a transaction.
+ * @details The staged records are written with a single program operation
+ *          followed by the commit marker.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ * @return              The operation status.
+ * @retval MFS_NO_ERROR if the operation has been successfully completed.
+ * @retval MFS_WARN_GC  if the operation has been completed but a
+ *                      compaction has been performed.
+ * @retval MFS_ERR_OUT_OF_MEM if there is not enough space, the transaction
+ *                      is discarded.
+ * @retval MFS_ERR_FLASH_FAILURE if the flash memory is unusable because HW
+ *                      failures.
+ *
+ * @api
+ */
+mfs_error_t mfsCommitTransaction(MFSDriver *devp) {
+  mfs_data_header_t header, marker;
+  mfs_error_t err, warn;
+  uint32_t offset;
+
+  osalDbgCheck(devp != NULL);
+  osalDbgAssert(devp->state == MFS_TRANSACTION, "invalid state");
+
+  osalMutexLock(&devp->mutex);
+  devp->state = MFS_MOUNTED;
+
+  if (devp->tx_size == 0U) {
+    osalMutexUnlock(&devp->mutex);
+    return MFS_NO_ERROR;
+  }
+
+  /* The old instances are obsoleted only after the commit.*/
+  if (devp->used_space + devp->tx_size + MFS_RECORD_SIZE(0U) >
+      devp->banks_size - MFS_RECORD_SIZE(0U)) {
+    devp->tx_size = 0U;
+    osalMutexUnlock(&devp->mutex);
+    return MFS_ERR_OUT_OF_MEM;
+  }
+
+  warn = mfs_make_room(devp, devp->tx_size + MFS_RECORD_SIZE(0U));
+  if (MFS_IS_ERROR(warn)) {
+    devp->tx_size = 0U;
+    osalMutexUnlock(&devp->mutex);
+    return warn;
+  }
+
+  /* The commit marker CRC covers the headers of the staged records.*/
+  marker.magic = MFS_HEADER_MAGIC;
+  marker.crc   = 0xFFFFU;
+  marker.id    = 0U;
+  marker.flags = MFS_FLAGS_COMMIT;
+  marker.size  = 0U;
+  for (offset = 0U; offset < devp->tx_size;
+       offset += MFS_RECORD_SIZE(header.size)) {
+    memcpy(&header, &devp->tx_buffer[offset], sizeof (mfs_data_header_t));
+    marker.crc = crc16(marker.crc, (const uint8_t *)&header,
+                       sizeof (mfs_data_header_t));
+  }
+
+  err = mfs_flash_write(devp, devp->next_offset,
+                        devp->tx_size, devp->tx_buffer);
+  if (err == MFS_NO_ERROR) {
+    err = mfs_flash_write(devp, devp->next_offset + devp->tx_size,
+                          sizeof (mfs_data_header_t),
+                          (const uint8_t *)&marker);
+  }
+  if (err == MFS_NO_ERROR) {
+    err = mfs_tx_apply(devp);
+  }
+  if (err == MFS_NO_ERROR) {
+    devp->next_offset += devp->tx_size + MFS_RECORD_SIZE(0U);
+  }
+  devp->tx_size = 0U;
+  osalMutexUnlock(&devp->mutex);
+
+  mfs_gc_signal(devp);
+
+  return err != MFS_NO_ERROR ? err : warn;
+}
+
+/**
+ * @brief   Discards a transaction.
+ *
+ * @param[in] devp      pointer to the @p MFSDriver object
+ *
+ * @api
+ */
+void mfsRollbackTransaction(MFSDriver *devp) {
+
+  osalDbgCheck(devp != NULL);
+  osalDbgAssert(devp->state == MFS_TRANSACTION, "invalid state");
+
+  osalMutexLock(&devp->mutex);
+  devp->tx_size = 0U;
+  devp->state   = MFS_MOUNTED;
+  osalMutexUnlock(&devp->mutex);
 }
+#endif /* MFS_CFG_TRANSACTION_SIZE > 0 */
 
 /** @} */
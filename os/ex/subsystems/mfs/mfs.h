@@ -37,6 +37,15 @@
 #define MFS_BANK_MAGIC_2                    0xF0339CC5U
 #define MFS_HEADER_MAGIC                    0x5FAEU
 
+/**
+ * @name    Record flags
+ * @{
+ */
+#define MFS_FLAGS_NONE                      0xFFFFU
+#define MFS_FLAGS_TRANSACTION               0xFFFEU
+#define MFS_FLAGS_COMMIT                    0xFFFCU
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -66,6 +75,25 @@
 #if !defined(MFS_CFG_WRITE_VERIFY) || defined(__DOXYGEN__)
 #define MFS_CFG_WRITE_VERIFY                TRUE
 #endif
+
+/**
+ * @brief   Size of the buffer used for copy and verify operations.
+ * @note    The buffer is allocated on the stack.
+ */
+#if !defined(MFS_CFG_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define MFS_CFG_BUFFER_SIZE                 32
+#endif
+
+/**
+ * @brief   Size of the transactions staging buffer.
+ * @details Records written within a transaction are staged in this buffer
+ *          including their headers, the space taken by a record is its
+ *          size plus 12 bytes rounded up to a multiple of 8.
+ * @note    Zero disables the transactions API.
+ */
+#if !defined(MFS_CFG_TRANSACTION_SIZE) || defined(__DOXYGEN__)
+#define MFS_CFG_TRANSACTION_SIZE            256
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -80,6 +108,14 @@
 #error "invalid MFS_MAX_REPAIR_ATTEMPTS value"
 #endif
 
+#if (MFS_CFG_BUFFER_SIZE < 16) || ((MFS_CFG_BUFFER_SIZE % 4) != 0)
+#error "invalid MFS_CFG_BUFFER_SIZE value"
+#endif
+
+#if (MFS_CFG_TRANSACTION_SIZE < 0) || ((MFS_CFG_TRANSACTION_SIZE % 8) != 0)
+#error "invalid MFS_CFG_TRANSACTION_SIZE value"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -100,7 +136,8 @@ typedef enum {
   MFS_STOP = 1,
   MFS_READY = 2,
   MFS_MOUNTED = 3,
-  MFS_ACTIVE = 4
+  MFS_ACTIVE = 4,
+  MFS_TRANSACTION = 5
 } mfs_state_t;
 
 /**
@@ -115,7 +152,9 @@ typedef enum {
   MFS_ERR_NOT_FOUND = -1,
   MFS_ERR_CRC = -2,
   MFS_ERR_FLASH_FAILURE = -3,
-  MFS_ERR_INTERNAL = -4
+  MFS_ERR_INTERNAL = -4,
+  MFS_ERR_INV_SIZE = -5,
+  MFS_ERR_OUT_OF_MEM = -6
 } mfs_error_t;
 
 /**
@@ -128,6 +167,42 @@ typedef enum {
   MFS_BANK_GARBAGE = 3
 } mfs_bank_state_t;
 
+/**
+ * @brief   Type of a compaction state.
+ */
+typedef enum {
+  MFS_GC_IDLE = 0,
+  MFS_GC_ERASING = 1,
+  MFS_GC_COPYING = 2
+} mfs_gc_state_t;
+
+/**
+ * @brief   Type of a compaction status.
+ */
+typedef struct {
+  /**
+   * @brief   Compaction state.
+   */
+  mfs_gc_state_t            state;
+  /**
+   * @brief   Free space in the current bank.
+   */
+  uint32_t                  free;
+  /**
+   * @brief   Space taken by obsolete records in the current bank.
+   */
+  uint32_t                  reclaimable;
+  /**
+   * @brief   Erased sectors or copied bytes in the current phase.
+   */
+  uint32_t                  done;
+  /**
+   * @brief   Sectors to be erased or bytes to be copied in the current
+   *          phase.
+   */
+  uint32_t                  total;
+} mfs_gc_status_t;
+
 /**
  * @brief   Type of a bank header.
  * @note    The header resides in the first 16 bytes of a bank extending
@@ -209,6 +284,12 @@ typedef struct {
    * #brief   Number of sectors for bank 1.
    */
   flash_sector_t            bank1_sectors;
+  /**
+   * @brief   Free space starting the background compaction.
+   * @note    If zero then the compaction is only performed when the
+   *          current bank is full.
+   */
+  uint32_t                  gc_threshold;
 } MFSConfig;
 
 /**
@@ -241,11 +322,63 @@ typedef struct {
    * @brief   Used space in the current bank without considering erased records.
    */
   uint32_t                  used_space;
+  /**
+   * @brief   Usage counter of the current bank.
+   */
+  uint32_t                  counter;
   /**
    * @brief   Offsets of the most recent instance of the records.
    * @note    Zero means that ther is not a record with that id.
    */
   flash_offset_t            instances[MFS_CFG_MAX_RECORDS];
+  /**
+   * @brief   Compaction state.
+   */
+  mfs_gc_state_t            gc_state;
+  /**
+   * @brief   Next sector to be erased in the spare bank.
+   */
+  flash_sector_t            gc_sector;
+  /**
+   * @brief   Next record to be examined for copy.
+   */
+  uint32_t                  gc_id;
+  /**
+   * @brief   Next free position in the spare bank.
+   */
+  flash_offset_t            gc_next_offset;
+  /**
+   * @brief   Instances copied into the spare bank, their offsets in the
+   *          current bank.
+   */
+  flash_offset_t            gc_sources[MFS_CFG_MAX_RECORDS];
+  /**
+   * @brief   Offsets of the copies in the spare bank.
+   */
+  flash_offset_t            gc_instances[MFS_CFG_MAX_RECORDS];
+  /**
+   * @brief   Number of completed compactions.
+   */
+  uint32_t                  gc_count;
+  /**
+   * @brief   Compaction thread waiting for work.
+   */
+  threads_queue_t           gc_queue;
+  /**
+   * @brief   Mutual exclusion between the clients and the compaction.
+   */
+  mutex_t                   mutex;
+#if (MFS_CFG_TRANSACTION_SIZE > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief   Bytes staged in the transaction buffer.
+   */
+  uint32_t                  tx_size;
+  /**
+   * @brief   Transaction staging buffer.
+   * @note    The records are staged in their flash format.
+   */
+  uint8_t                   tx_buffer[MFS_CFG_TRANSACTION_SIZE];
+#endif
 } MFSDriver;
 
 /*===========================================================================*/
@@ -277,6 +410,13 @@ extern "C" {
   mfs_error_t mfsWriteRecord(MFSDriver *devp, uint32_t id,
                              uint32_t n, const uint8_t *buffer);
   mfs_error_t mfsEraseRecord(MFSDriver *devp, uint32_t id);
+  mfs_error_t mfsServeCompaction(MFSDriver *devp);
+  void mfsGetCompactionStatus(MFSDriver *devp, mfs_gc_status_t *gsp);
+#if MFS_CFG_TRANSACTION_SIZE > 0
+  void mfsStartTransaction(MFSDriver *devp);
+  mfs_error_t mfsCommitTransaction(MFSDriver *devp);
+  void mfsRollbackTransaction(MFSDriver *devp);
+#endif
 #ifdef __cplusplus
 }
 #endif
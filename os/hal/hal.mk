@@ -9,7 +9,8 @@ HALSRC := $(CHIBIOS)/os/hal/src/hal.c \
           $(CHIBIOS)/os/hal/src/hal_queues.c \
           $(CHIBIOS)/os/hal/src/hal_mmcsd.c
 ifneq ($(findstring HAL_USE_ADC TRUE,$(HALCONF)),)
-HALSRC += $(CHIBIOS)/os/hal/src/hal_adc.c
+HALSRC += $(CHIBIOS)/os/hal/src/hal_adc.c \
+          $(CHIBIOS)/os/hal/src/hal_adc_stream.c
 endif
 ifneq ($(findstring HAL_USE_CAN TRUE,$(HALCONF)),)
 HALSRC += $(CHIBIOS)/os/hal/src/hal_can.c
@@ -63,7 +64,8 @@ ifneq ($(findstring HAL_USE_SPI TRUE,$(HALCONF)),)
 HALSRC += $(CHIBIOS)/os/hal/src/hal_spi.c
 endif
 ifneq ($(findstring HAL_USE_UART TRUE,$(HALCONF)),)
-HALSRC += $(CHIBIOS)/os/hal/src/hal_uart.c
+HALSRC += $(CHIBIOS)/os/hal/src/hal_uart.c \
+          $(CHIBIOS)/os/hal/src/hal_uart_framer.c
 endif
 ifneq ($(findstring HAL_USE_USB TRUE,$(HALCONF)),)
 HALSRC += $(CHIBIOS)/os/hal/src/hal_usb.c
@@ -77,6 +79,7 @@ HALSRC = $(CHIBIOS)/os/hal/src/hal.c \
          $(CHIBIOS)/os/hal/src/hal_queues.c \
          $(CHIBIOS)/os/hal/src/hal_mmcsd.c \
          $(CHIBIOS)/os/hal/src/hal_adc.c \
+         $(CHIBIOS)/os/hal/src/hal_adc_stream.c \
          $(CHIBIOS)/os/hal/src/hal_can.c \
          $(CHIBIOS)/os/hal/src/hal_dac.c \
          $(CHIBIOS)/os/hal/src/hal_ext.c \
@@ -96,6 +99,7 @@ HALSRC = $(CHIBIOS)/os/hal/src/hal.c \
          $(CHIBIOS)/os/hal/src/hal_spi.c \
          $(CHIBIOS)/os/hal/src/hal_st.c \
          $(CHIBIOS)/os/hal/src/hal_uart.c \
+         $(CHIBIOS)/os/hal/src/hal_uart_framer.c \
          $(CHIBIOS)/os/hal/src/hal_usb.c \
          $(CHIBIOS)/os/hal/src/hal_wdg.c
 endif
@@ -123,6 +123,7 @@
 /* Normal drivers.*/
 #include "hal_pal.h"
 #include "hal_adc.h"
+#include "hal_adc_stream.h"
 #include "hal_can.h"
 #include "hal_dac.h"
 #include "hal_ext.h"
@@ -138,6 +139,7 @@
 #include "hal_sdc.h"
 #include "hal_spi.h"
 #include "hal_uart.h"
+#include "hal_uart_framer.h"
 #include "hal_usb.h"
 #include "hal_wdg.h"
 
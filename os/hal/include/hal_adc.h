@@ -54,6 +54,14 @@
 #if !defined(ADC_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
 #define ADC_USE_MUTUAL_EXCLUSION    TRUE
 #endif
+
+/**
+ * @brief   Enables the zero-copy streaming layer.
+ * @note    Disabling this option saves both code and data space.
+ */
+#if !defined(ADC_USE_STREAMING) || defined(__DOXYGEN__)
+#define ADC_USE_STREAMING           FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
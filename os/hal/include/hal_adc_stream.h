@@ -0,0 +1,221 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_adc_stream.h
+ * @brief   ADC streaming layer macros and structures.
+ *
+ * @addtogroup ADC_STREAM
+ * @{
+ */
+
+#ifndef HAL_ADC_STREAM_H
+#define HAL_ADC_STREAM_H
+
+#if ((HAL_USE_ADC == TRUE) && (ADC_USE_STREAMING == TRUE)) ||               \
+    defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of blocks in the stream ring.
+ * @note    A circular ADC conversion notifies the half and full buffer
+ *          events so the DMA buffer is seen as a ring of two blocks.
+ */
+#define ADC_STREAM_BLOCKS           2U
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Stream state machine possible states.
+ */
+typedef enum {
+  ADCS_UNINIT = 0,                  /**< Not initialized.                   */
+  ADCS_STOP = 1,                    /**< Stopped.                           */
+  ADCS_ACTIVE = 2                   /**< Streaming.                         */
+} adcsstate_t;
+
+/**
+ * @brief   Type of a block sequence number.
+ * @note    Sequence numbers wrap around, comparisons must be performed
+ *          using unsigned differences.
+ */
+typedef uint32_t adcsseq_t;
+
+/**
+ * @brief   Type of an ADC stream object.
+ */
+typedef struct adc_stream adc_stream_t;
+
+/**
+ * @brief   Structure of an ADC stream.
+ */
+struct adc_stream {
+  /**
+   * @brief   Private copy of the conversion group.
+   * @note    It must be the first field, the stream callbacks find their
+   *          stream object through the driver @p grpp field.
+   */
+  ADCConversionGroup        grp;
+  /**
+   * @brief   Stream state.
+   */
+  adcsstate_t               state;
+  /**
+   * @brief   Associated ADC driver or @p NULL.
+   */
+  ADCDriver                 *adcp;
+  /**
+   * @brief   DMA buffer base.
+   */
+  adcsample_t               *samples;
+  /**
+   * @brief   Number of rows in a block.
+   */
+  size_t                    rows;
+  /**
+   * @brief   Number of samples in a block.
+   */
+  size_t                    bsize;
+  /**
+   * @brief   Number of completed blocks since initialization.
+   * @note    This is also the sequence number of the block currently
+   *          being filled by the DMA.
+   */
+  volatile adcsseq_t        wseq;
+  /**
+   * @brief   Sequence number of the first block of the current run.
+   */
+  adcsseq_t                 bseq;
+  /**
+   * @brief   Number of errors reported by the driver.
+   */
+  uint32_t                  errors;
+  /**
+   * @brief   Readers waiting for a block.
+   */
+  threads_queue_t           waiting;
+  /**
+   * @brief   Application block callback or @p NULL.
+   */
+  adccallback_t             end_cb;
+  /**
+   * @brief   Application error callback or @p NULL.
+   */
+  adcerrorcallback_t        error_cb;
+};
+
+/**
+ * @brief   Structure of a stream reader.
+ * @details Each reader has its own cursor into the stream so several
+ *          readers can consume the same blocks independently.
+ */
+typedef struct {
+  /**
+   * @brief   Associated stream.
+   */
+  adc_stream_t              *asp;
+  /**
+   * @brief   Sequence number of the next block to be acquired.
+   */
+  adcsseq_t                 seq;
+  /**
+   * @brief   Number of blocks lost because of overruns.
+   */
+  uint32_t                  overruns;
+} adc_stream_reader_t;
+
+/**
+ * @brief   Descriptor of an acquired block.
+ */
+typedef struct {
+  /**
+   * @brief   Pointer to the block samples inside the DMA buffer.
+   */
+  adcsample_t               *samples;
+  /**
+   * @brief   Number of rows in the block.
+   */
+  size_t                    n;
+  /**
+   * @brief   Block sequence number.
+   */
+  adcsseq_t                 seq;
+} adc_stream_block_t;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the number of completed blocks.
+ *
+ * @param[in] asp       pointer to the @p adc_stream_t object
+ * @return              The sequence number of the block being filled.
+ *
+ * @xclass
+ */
+#define adcsGetSequenceX(asp) ((asp)->wseq)
+
+/**
+ * @brief   Returns the number of blocks lost by a reader.
+ *
+ * @param[in] asrp      pointer to the @p adc_stream_reader_t object
+ * @return              The number of overrun blocks.
+ *
+ * @xclass
+ */
+#define adcsGetOverrunsX(asrp) ((asrp)->overruns)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void adcsObjectInit(adc_stream_t *asp);
+  void adcsStart(adc_stream_t *asp, ADCDriver *adcp,
+                 const ADCConversionGroup *grpp,
+                 adcsample_t *samples, size_t depth);
+  void adcsStop(adc_stream_t *asp);
+  void adcsReaderObjectInit(adc_stream_reader_t *asrp, adc_stream_t *asp);
+  msg_t adcsAcquireBlockTimeout(adc_stream_reader_t *asrp,
+                                adc_stream_block_t *bp,
+                                systime_t timeout);
+  bool adcsReleaseBlock(adc_stream_reader_t *asrp,
+                        const adc_stream_block_t *bp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_ADC == TRUE) && (ADC_USE_STREAMING == TRUE) */
+
+#endif /* HAL_ADC_STREAM_H */
+
+/** @} */
@@ -134,6 +134,12 @@ typedef struct {
 #error "low level does not define QSPI_SUPPORTS_MEMMAP"
 #endif
 
+/* Low level drivers predating the status polling capability do not
+   support it.*/
+#if !defined(QSPI_SUPPORTS_AUTOPOLL)
+#define QSPI_SUPPORTS_AUTOPOLL              FALSE
+#endif
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -227,6 +233,30 @@ typedef struct {
 #define qspiUnmapFlashI(qspip)                                              \
   qspi_lld_unmap_flash(qspip)
 #endif /* QSPI_SUPPORTS_MEMMAP == TRUE */
+
+#if (QSPI_SUPPORTS_AUTOPOLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Polls a status byte until it matches.
+ * @details This asynchronous function starts an automatic polling operation,
+ *          the command is repeated by the hardware until the received
+ *          status byte masked by @p mask is equal to @p match.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @iclass
+ */
+#define qspiStartAutoPollI(qspip, cmdp, mask, match) {                      \
+  osalDbgAssert(((cmdp)->cfg & QSPI_CFG_DATA_MODE_MASK) !=                  \
+                QSPI_CFG_DATA_MODE_NONE,                                    \
+                "data mode required");                                      \
+  (qspip)->state = QSPI_ACTIVE;                                             \
+  qspi_lld_autopoll(qspip, cmdp, mask, match);                              \
+}
+#endif /* QSPI_SUPPORTS_AUTOPOLL == TRUE */
 /** @} */
 
 /**
@@ -306,6 +336,14 @@ void qspiMapFlash(QSPIDriver *qspip,
                   uint8_t **addrp);
 void qspiUnmapFlash(QSPIDriver *qspip);
 #endif
+#if QSPI_SUPPORTS_AUTOPOLL == TRUE
+  void qspiStartAutoPoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                         uint8_t mask, uint8_t match);
+#if QSPI_USE_WAIT == TRUE
+  void qspiAutoPoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                    uint8_t mask, uint8_t match);
+#endif
+#endif
 #if QSPI_USE_MUTUAL_EXCLUSION == TRUE
   void qspiAcquireBus(QSPIDriver *qspip);
   void qspiReleaseBus(QSPIDriver *qspip);
@@ -66,6 +66,14 @@
 #if !defined(UART_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
 #define UART_USE_MUTUAL_EXCLUSION           FALSE
 #endif
+
+/**
+ * @brief   Enables the framed receive layer.
+ * @note    Disabling this option saves both code and data space.
+ */
+#if !defined(UART_USE_FRAMING) || defined(__DOXYGEN__)
+#define UART_USE_FRAMING                    FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -105,6 +113,16 @@ typedef enum {
 
 #include "hal_uart_lld.h"
 
+/**
+ * @brief   Receiver timeout support.
+ * @details Low level drivers invoking the @p timeout_cb configuration
+ *          callback on idle line or receiver timeout define this macro
+ *          as @p TRUE.
+ */
+#if !defined(UART_SUPPORTS_TIMEOUT) || defined(__DOXYGEN__)
+#define UART_SUPPORTS_TIMEOUT               FALSE
+#endif
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
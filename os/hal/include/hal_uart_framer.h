@@ -0,0 +1,194 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_uart_framer.h
+ * @brief   UART framed receive layer macros and structures.
+ *
+ * @addtogroup UART_FRAMER
+ * @{
+ */
+
+#ifndef HAL_UART_FRAMER_H
+#define HAL_UART_FRAMER_H
+
+#if ((HAL_USE_UART == TRUE) && (UART_USE_FRAMING == TRUE)) ||               \
+    defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Framing modes
+ * @{
+ */
+/**
+ * @brief   Frames are terminated by an idle line or receiver timeout.
+ */
+#define UART_FRAMER_IDLE            1U
+/**
+ * @brief   Frames are terminated by a delimiter byte.
+ * @note    The delimiter is not part of the delivered frame, empty frames
+ *          are silently dropped.
+ */
+#define UART_FRAMER_DELIMITER       2U
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Framer state machine possible states.
+ */
+typedef enum {
+  UFR_UNINIT = 0,                   /**< Not initialized.                   */
+  UFR_STOP = 1,                     /**< Stopped.                           */
+  UFR_READY = 2,                    /**< Receiving frames.                  */
+  UFR_STALLED = 3                   /**< No free buffers, not receiving.    */
+} ufrstate_t;
+
+/**
+ * @brief   Framer configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Framing mode, a combination of @p UART_FRAMER_IDLE and
+   *          @p UART_FRAMER_DELIMITER.
+   */
+  uint32_t                  mode;
+  /**
+   * @brief   Frames delimiter byte.
+   */
+  uint8_t                   delimiter;
+} uart_framer_config_t;
+
+/**
+ * @brief   Structure of an UART framer.
+ */
+typedef struct {
+  /**
+   * @brief   Private copy of the driver configuration.
+   * @note    It must be the first field, the framer callbacks find their
+   *          framer object through the driver @p config field.
+   */
+  UARTConfig                config;
+  /**
+   * @brief   Framer state.
+   */
+  ufrstate_t                state;
+  /**
+   * @brief   Associated UART driver or @p NULL.
+   */
+  UARTDriver                *uartp;
+  /**
+   * @brief   Current framer configuration.
+   */
+  const uart_framer_config_t *frcfg;
+  /**
+   * @brief   Maximum frame size.
+   */
+  size_t                    size;
+  /**
+   * @brief   Queue of received frames.
+   */
+  input_buffers_queue_t     ibq;
+  /**
+   * @brief   Buffer being filled or @p NULL.
+   */
+  uint8_t                   *rxbuf;
+  /**
+   * @brief   Bytes already received and scanned in the current buffer.
+   */
+  size_t                    rxn;
+  /**
+   * @brief   Current frame is being discarded.
+   */
+  bool                      discard;
+  /**
+   * @brief   Number of delivered frames.
+   */
+  uint32_t                  frames;
+  /**
+   * @brief   Number of frames lost because no buffer was available.
+   */
+  uint32_t                  overruns;
+  /**
+   * @brief   Number of frames lost because larger than the maximum size.
+   */
+  uint32_t                  overflows;
+  /**
+   * @brief   Application receive error callback or @p NULL.
+   */
+  uartecb_t                 rxerr_cb;
+} uart_framer_t;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Computes the size of a frame buffer.
+ * @details Buffers have at least a spare byte after the maximum frame size
+ *          so that a frame filling the buffer is recognized as too large,
+ *          the size is rounded up in order to keep the buffers aligned.
+ *
+ * @param[in] size      maximum frame size
+ */
+#define UFR_BUFFER_SIZE(size)                                               \
+  ((((size_t)(size) + sizeof (size_t)) / sizeof (size_t)) * sizeof (size_t))
+
+/**
+ * @brief   Computes the size of the buffers area of a framer.
+ *
+ * @param[in] n         number of frame buffers
+ * @param[in] size      maximum frame size
+ */
+#define UFR_BUFFERS_SIZE(n, size) BQ_BUFFER_SIZE(n, UFR_BUFFER_SIZE(size))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void ufrObjectInit(uart_framer_t *ufp, uint8_t *bp, size_t size, size_t n);
+  void ufrStart(uart_framer_t *ufp, UARTDriver *uartp,
+                const UARTConfig *config, const uart_framer_config_t *frcfg);
+  void ufrStop(uart_framer_t *ufp);
+  void ufrIdleI(uart_framer_t *ufp);
+  msg_t ufrGetFrameTimeout(uart_framer_t *ufp, uint8_t **fpp, size_t *np,
+                           systime_t timeout);
+  void ufrReleaseFrame(uart_framer_t *ufp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_UART == TRUE) && (UART_USE_FRAMING == TRUE) */
+
+#endif /* HAL_UART_FRAMER_H */
+
+/** @} */
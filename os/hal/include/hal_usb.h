@@ -242,6 +242,16 @@
 #define USB_USE_WAIT                        FALSE
 #endif
 
+/**
+ * @brief   Enables the transfers queues APIs.
+ * @details If enabled, transfers can be queued on endpoints and the next
+ *          queued transfer is started as soon as the previous completes,
+ *          before any callback is invoked.
+ */
+#if !defined(USB_USE_QUEUES) || defined(__DOXYGEN__)
+#define USB_USE_QUEUES                      FALSE
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -367,6 +377,51 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
                                                     uint8_t dindex,
                                                     uint16_t lang);
 
+/**
+ * @brief   Type of a queued transfer descriptor.
+ */
+typedef struct usb_xfer usbxfer_t;
+
+/**
+ * @brief   Type of a queued transfer completion callback.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object triggering the
+ *                      callback
+ * @param[in] ep        endpoint number
+ * @param[in] xp        pointer to the completed transfer descriptor
+ */
+typedef void (*usbxfercb_t)(USBDriver *usbp, usbep_t ep, usbxfer_t *xp);
+
+/**
+ * @brief   Structure of a queued transfer descriptor.
+ */
+struct usb_xfer {
+  /**
+   * @brief   Next queued transfer.
+   */
+  usbxfer_t                     *next;
+  /**
+   * @brief   Transfer buffer, it is only read by IN transfers.
+   */
+  uint8_t                       *buf;
+  /**
+   * @brief   Transfer size.
+   */
+  size_t                        n;
+  /**
+   * @brief   Transferred bytes, valid on completion.
+   */
+  size_t                        size;
+  /**
+   * @brief   Completion callback or @p NULL.
+   */
+  usbxfercb_t                   cb;
+  /**
+   * @brief   Parameter available to the transfer owner.
+   */
+  void                          *param;
+};
+
 #include "hal_usb_lld.h"
 
 /*===========================================================================*/
@@ -536,6 +591,34 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
   (usbp)->epc[ep]->setup_cb(usbp, ep);                                      \
 }
 
+/**
+ * @brief   Common ISR code, IN endpoint queue processing.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+#define _usb_isr_process_in_queue(usbp, ep) _usb_xfer_in_done(usbp, ep)
+#else
+#define _usb_isr_process_in_queue(usbp, ep)
+#endif
+
+/**
+ * @brief   Common ISR code, OUT endpoint queue processing.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+#define _usb_isr_process_out_queue(usbp, ep) _usb_xfer_out_done(usbp, ep)
+#else
+#define _usb_isr_process_out_queue(usbp, ep)
+#endif
+
 /**
  * @brief   Common ISR code, IN endpoint callback.
  *
@@ -547,6 +630,7 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
 #if (USB_USE_WAIT == TRUE) || defined(__DOXYGEN__)
 #define _usb_isr_invoke_in_cb(usbp, ep) {                                   \
   (usbp)->transmitting &= ~(1 << (ep));                                     \
+  _usb_isr_process_in_queue(usbp, ep);                                      \
   if ((usbp)->epc[ep]->in_cb != NULL) {                                     \
     (usbp)->epc[ep]->in_cb(usbp, ep);                                       \
   }                                                                         \
@@ -557,6 +641,7 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
 #else
 #define _usb_isr_invoke_in_cb(usbp, ep) {                                   \
   (usbp)->transmitting &= ~(1 << (ep));                                     \
+  _usb_isr_process_in_queue(usbp, ep);                                      \
   if ((usbp)->epc[ep]->in_cb != NULL) {                                     \
     (usbp)->epc[ep]->in_cb(usbp, ep);                                       \
   }                                                                         \
@@ -574,6 +659,7 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
 #if (USB_USE_WAIT == TRUE) || defined(__DOXYGEN__)
 #define _usb_isr_invoke_out_cb(usbp, ep) {                                  \
   (usbp)->receiving &= ~(1 << (ep));                                        \
+  _usb_isr_process_out_queue(usbp, ep);                                     \
   if ((usbp)->epc[ep]->out_cb != NULL) {                                    \
     (usbp)->epc[ep]->out_cb(usbp, ep);                                      \
   }                                                                         \
@@ -585,6 +671,7 @@ typedef const USBDescriptor * (*usbgetdescriptor_t)(USBDriver *usbp,
 #else
 #define _usb_isr_invoke_out_cb(usbp, ep) {                                  \
   (usbp)->receiving &= ~(1 << (ep));                                        \
+  _usb_isr_process_out_queue(usbp, ep);                                     \
   if ((usbp)->epc[ep]->out_cb != NULL) {                                    \
     (usbp)->epc[ep]->out_cb(usbp, ep);                                      \
   }                                                                         \
@@ -611,6 +698,10 @@ extern "C" {
                         uint8_t *buf, size_t n);
   void usbStartTransmitI(USBDriver *usbp, usbep_t ep,
                          const uint8_t *buf, size_t n);
+#if USB_USE_QUEUES == TRUE
+  void usbQueueReceiveI(USBDriver *usbp, usbep_t ep, usbxfer_t *xp);
+  void usbQueueTransmitI(USBDriver *usbp, usbep_t ep, usbxfer_t *xp);
+#endif
 #if USB_USE_WAIT == TRUE
   msg_t usbReceive(USBDriver *usbp, usbep_t ep, uint8_t *buf, size_t n);
   msg_t usbTransmit(USBDriver *usbp, usbep_t ep, const uint8_t *buf, size_t n);
@@ -623,6 +714,10 @@ extern "C" {
   void _usb_ep0setup(USBDriver *usbp, usbep_t ep);
   void _usb_ep0in(USBDriver *usbp, usbep_t ep);
   void _usb_ep0out(USBDriver *usbp, usbep_t ep);
+#if USB_USE_QUEUES == TRUE
+  void _usb_xfer_in_done(USBDriver *usbp, usbep_t ep);
+  void _usb_xfer_out_done(USBDriver *usbp, usbep_t ep);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,743 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blkcache.c
+ * @brief   Block devices cache code.
+ *
+ * @addtogroup block_cache
+ * @details The block cache is a @p BaseBlockDevice implementation caching
+ *          another block device. Cached blocks are kept in a set of lines
+ *          replaced with a LRU policy, writes are deferred until a line is
+ *          replaced or the cache is synchronized.<br>
+ *          If a transfer buffer is configured then:
+ *          - Sequential reads are detected and served through a read-ahead
+ *            window loaded with a single multi-block read.
+ *          - Adjacent dirty lines are written together using multi-block
+ *            writes.
+ *          .
+ *          Transfers larger than half the cache lines bypass the cache in
+ *          order to not evict the frequently accessed blocks.
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "blkcache.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static bool bc_is_inserted(void *instance);
+static bool bc_is_protected(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct BlockCacheVMT vmt = {
+  bc_is_inserted,
+  bc_is_protected,
+  (bool (*)(void *))bcConnect,
+  (bool (*)(void *))bcDisconnect,
+  (bool (*)(void *, uint32_t, uint8_t *, uint32_t))bcRead,
+  (bool (*)(void *, uint32_t, const uint8_t *, uint32_t))bcWrite,
+  (bool (*)(void *))bcSync,
+  (bool (*)(void *, BlockDeviceInfo *))bcGetInfo
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static bool bc_is_inserted(void *instance) {
+
+  return blkIsInserted(((BlockCache *)instance)->config->bdp);
+}
+
+static bool bc_is_protected(void *instance) {
+
+  return blkIsWriteProtected(((BlockCache *)instance)->config->bdp);
+}
+
+/**
+ * @brief   Returns the data area of a cache line.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] lp        pointer to the cache line descriptor
+ * @return              Pointer to the line data.
+ *
+ * @notapi
+ */
+static uint8_t *bc_line_data(BlockCache *bcp, blkc_line_t *lp) {
+
+  return bcp->config->buffer +
+         ((size_t)(lp - bcp->config->lines) * bcp->config->blk_size);
+}
+
+/**
+ * @brief   Searches a block in the cache lines.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @return              The line containing the block.
+ * @retval NULL         if the block is not cached.
+ *
+ * @notapi
+ */
+static blkc_line_t *bc_find(BlockCache *bcp, uint32_t blk) {
+  blkc_line_t *lp = bcp->config->lines;
+  blkc_line_t *end = lp + bcp->config->lines_num;
+
+  while (lp < end) {
+    if (lp->blk == blk) {
+      return lp;
+    }
+    lp++;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Searches a block in the read-ahead window.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @return              Pointer to the block data in the window.
+ * @retval NULL         if the block is not in the window.
+ *
+ * @notapi
+ */
+static uint8_t *bc_window_find(BlockCache *bcp, uint32_t blk) {
+
+  if ((uint32_t)(blk - bcp->ra_start) < bcp->ra_num) {
+    return bcp->config->tbuffer +
+           ((size_t)(blk - bcp->ra_start) * bcp->config->blk_size);
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Marks a line as the most recently used.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] lp        pointer to the cache line descriptor
+ *
+ * @notapi
+ */
+static void bc_touch(BlockCache *bcp, blkc_line_t *lp) {
+
+  lp->stamp = bcp->stamp++;
+}
+
+/**
+ * @brief   Writes a dirty line to the device.
+ * @details Dirty lines caching the adjacent blocks are gathered in the
+ *          transfer buffer and written using a single operation, the
+ *          read-ahead window is lost in the process.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] lp        pointer to the dirty cache line descriptor
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed, the lines are still dirty.
+ *
+ * @notapi
+ */
+static bool bc_flush(BlockCache *bcp, blkc_line_t *lp) {
+  const BlockCacheConfig *cfg = bcp->config;
+  blkc_line_t *p;
+  uint32_t first = lp->blk;
+  uint32_t i, n = 1U;
+
+  /* Extending the run over the adjacent dirty lines, backward first.*/
+  if (cfg->tbuffer != NULL) {
+    while ((n < cfg->tblocks) && (first > 0U) &&
+           ((p = bc_find(bcp, first - 1U)) != NULL) && p->dirty) {
+      first--;
+      n++;
+    }
+    while ((n < cfg->tblocks) &&
+           ((p = bc_find(bcp, first + n)) != NULL) && p->dirty) {
+      n++;
+    }
+  }
+
+  if (n == 1U) {
+    /* Single block, written directly from the line.*/
+    if (blkWrite(cfg->bdp, lp->blk, bc_line_data(bcp, lp), 1U)) {
+      return HAL_FAILED;
+    }
+    bcp->dev_writes++;
+    lp->dirty = false;
+    return HAL_SUCCESS;
+  }
+
+  /* Gathering the lines in the transfer buffer.*/
+  bcp->ra_num = 0U;
+  for (i = 0U; i < n; i++) {
+    memcpy(cfg->tbuffer + ((size_t)i * cfg->blk_size),
+           bc_line_data(bcp, bc_find(bcp, first + i)),
+           cfg->blk_size);
+  }
+  if (blkWrite(cfg->bdp, first, cfg->tbuffer, n)) {
+    return HAL_FAILED;
+  }
+  bcp->dev_writes++;
+  for (i = 0U; i < n; i++) {
+    bc_find(bcp, first + i)->dirty = false;
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Assigns a line to a block.
+ * @details A free line is used if available, else the least recently used
+ *          line is replaced, writing it to the device if dirty.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @return              The assigned line, its content is undefined.
+ * @retval NULL         if the replaced line could not be written.
+ *
+ * @notapi
+ */
+static blkc_line_t *bc_alloc(BlockCache *bcp, uint32_t blk) {
+  blkc_line_t *lp = bcp->config->lines;
+  blkc_line_t *end = lp + bcp->config->lines_num;
+  blkc_line_t *victim = lp;
+
+  while (lp < end) {
+    if (lp->blk == BLKC_NO_BLOCK) {
+      victim = lp;
+      break;
+    }
+    if ((uint32_t)(bcp->stamp - lp->stamp) >
+        (uint32_t)(bcp->stamp - victim->stamp)) {
+      victim = lp;
+    }
+    lp++;
+  }
+
+  if (victim->dirty) {
+    if (bc_flush(bcp, victim)) {
+      return NULL;
+    }
+  }
+
+  victim->blk = blk;
+  bc_touch(bcp, victim);
+  return victim;
+}
+
+/**
+ * @brief   Updates the read-ahead window copy of a block.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @param[in] bp        pointer to the new block data
+ *
+ * @notapi
+ */
+static void bc_window_update(BlockCache *bcp, uint32_t blk,
+                             const uint8_t *bp) {
+  uint8_t *wp = bc_window_find(bcp, blk);
+
+  if (wp != NULL) {
+    memcpy(wp, bp, bcp->config->blk_size);
+  }
+}
+
+/**
+ * @brief   Loads the read-ahead window.
+ * @details Blocks cached in dirty lines are newer than the device content
+ *          so they are copied over the loaded data.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       first block of the window
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @notapi
+ */
+static bool bc_window_load(BlockCache *bcp, uint32_t blk) {
+  const BlockCacheConfig *cfg = bcp->config;
+  blkc_line_t *lp;
+  uint32_t n = cfg->tblocks;
+
+  if (n > bcp->blk_num - blk) {
+    n = bcp->blk_num - blk;
+  }
+
+  bcp->ra_num = 0U;
+  if (blkRead(cfg->bdp, blk, cfg->tbuffer, n)) {
+    return HAL_FAILED;
+  }
+  bcp->dev_reads++;
+  bcp->ra_start = blk;
+  bcp->ra_num   = n;
+
+  for (lp = cfg->lines; lp < cfg->lines + cfg->lines_num; lp++) {
+    if (lp->dirty) {
+      bc_window_update(bcp, lp->blk, bc_line_data(bcp, lp));
+    }
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Drops the whole cache content.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @notapi
+ */
+static void bc_invalidate(BlockCache *bcp) {
+  blkc_line_t *lp;
+
+  for (lp = bcp->config->lines;
+       lp < bcp->config->lines + bcp->config->lines_num;
+       lp++) {
+    lp->blk   = BLKC_NO_BLOCK;
+    lp->stamp = 0U;
+    lp->dirty = false;
+  }
+  bcp->stamp  = 0U;
+  bcp->next   = BLKC_NO_BLOCK;
+  bcp->ra_num = 0U;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Block cache object initialization.
+ *
+ * @param[out] bcp      pointer to the @p BlockCache object
+ *
+ * @init
+ */
+void bcObjectInit(BlockCache *bcp) {
+
+  bcp->vmt        = &vmt;
+  bcp->state      = BLK_STOP;
+  bcp->config     = NULL;
+  bcp->blk_num    = 0U;
+  bcp->hits       = 0U;
+  bcp->misses     = 0U;
+  bcp->dev_reads  = 0U;
+  bcp->dev_writes = 0U;
+}
+
+/**
+ * @brief   Configures and activates the block cache.
+ * @pre     The cached device must have been started.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] config    pointer to the @p BlockCacheConfig object
+ *
+ * @api
+ */
+void bcStart(BlockCache *bcp, const BlockCacheConfig *config) {
+
+  osalDbgCheck((bcp != NULL) && (config != NULL) &&
+               (config->bdp != NULL) && (config->blk_size > 0U) &&
+               (config->lines_num > 0U) && (config->lines != NULL) &&
+               (config->buffer != NULL) &&
+               ((config->tbuffer == NULL) || (config->tblocks > 0U)));
+  osalDbgAssert((bcp->state == BLK_STOP) || (bcp->state == BLK_ACTIVE),
+                "invalid state");
+
+  bcp->config = config;
+  bc_invalidate(bcp);
+  bcp->state  = BLK_ACTIVE;
+}
+
+/**
+ * @brief   Deactivates the block cache.
+ * @pre     The cache must be disconnected, dirty lines are lost otherwise.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @api
+ */
+void bcStop(BlockCache *bcp) {
+
+  osalDbgCheck(bcp != NULL);
+  osalDbgAssert((bcp->state == BLK_STOP) || (bcp->state == BLK_ACTIVE),
+                "invalid state");
+
+  bcp->config = NULL;
+  bcp->state  = BLK_STOP;
+}
+
+/**
+ * @brief   Connects the cached device.
+ * @details The cached device is connected if not already connected, the
+ *          cache starts empty.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed or block size mismatch.
+ *
+ * @api
+ */
+bool bcConnect(BlockCache *bcp) {
+  BlockDeviceInfo bdi;
+
+  osalDbgCheck(bcp != NULL);
+  osalDbgAssert((bcp->state == BLK_ACTIVE) || (bcp->state == BLK_READY),
+                "invalid state");
+
+  if (bcp->state == BLK_READY) {
+    return HAL_SUCCESS;
+  }
+
+  bcp->state = BLK_CONNECTING;
+
+  if ((blkGetDriverState(bcp->config->bdp) != BLK_READY) &&
+      blkConnect(bcp->config->bdp)) {
+    bcp->state = BLK_ACTIVE;
+    return HAL_FAILED;
+  }
+
+  if (blkGetInfo(bcp->config->bdp, &bdi) ||
+      (bdi.blk_size != bcp->config->blk_size)) {
+    bcp->state = BLK_ACTIVE;
+    return HAL_FAILED;
+  }
+
+  bcp->blk_num = bdi.blk_num;
+  bc_invalidate(bcp);
+  bcp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Disconnects the cached device.
+ * @details The dirty lines are written to the device before disconnecting
+ *          it, the cache is emptied.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed, data may have been lost.
+ *
+ * @api
+ */
+bool bcDisconnect(BlockCache *bcp) {
+  bool result;
+
+  osalDbgCheck(bcp != NULL);
+  osalDbgAssert((bcp->state == BLK_ACTIVE) || (bcp->state == BLK_READY),
+                "invalid state");
+
+  if (bcp->state == BLK_ACTIVE) {
+    return HAL_SUCCESS;
+  }
+
+  result = bcSync(bcp);
+
+  bcp->state = BLK_DISCONNECTING;
+  if (blkDisconnect(bcp->config->bdp)) {
+    result = HAL_FAILED;
+  }
+  bc_invalidate(bcp);
+  bcp->state = BLK_ACTIVE;
+
+  return result;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ * @pre     The cache must be in the @p BLK_READY state after a successful
+ *          bcConnect() invocation.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] startblk  first block to read
+ * @param[out] buffer   pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool bcRead(BlockCache *bcp, uint32_t startblk,
+            uint8_t *buffer, uint32_t n) {
+  const BlockCacheConfig *cfg;
+  bool sequential;
+
+  osalDbgCheck((bcp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(bcp->state == BLK_READY, "invalid state");
+
+  cfg = bcp->config;
+  if ((startblk >= bcp->blk_num) || (n > bcp->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  /* Read operation in progress.*/
+  bcp->state = BLK_READING;
+
+  sequential = (bool)(startblk == bcp->next);
+  bcp->next  = startblk + n;
+
+  while (n > 0U) {
+    blkc_line_t *lp;
+    uint8_t *wp;
+    uint32_t i, run;
+
+    /* Cached blocks first, dirty lines are newer than anything else.*/
+    lp = bc_find(bcp, startblk);
+    if (lp != NULL) {
+      memcpy(buffer, bc_line_data(bcp, lp), cfg->blk_size);
+      bc_touch(bcp, lp);
+      bcp->hits++;
+      buffer += cfg->blk_size;
+      startblk++;
+      n--;
+      continue;
+    }
+
+    wp = bc_window_find(bcp, startblk);
+    if (wp != NULL) {
+      memcpy(buffer, wp, cfg->blk_size);
+      bcp->hits++;
+      buffer += cfg->blk_size;
+      startblk++;
+      n--;
+      continue;
+    }
+
+    /* Run of missing blocks.*/
+    run = 1U;
+    while ((run < n) &&
+           (bc_find(bcp, startblk + run) == NULL) &&
+           (bc_window_find(bcp, startblk + run) == NULL)) {
+      run++;
+    }
+    bcp->misses += run;
+
+    if (sequential && (cfg->tbuffer != NULL) && (run < cfg->tblocks)) {
+      /* Sequential access, the missing blocks and the following ones are
+         loaded in the read-ahead window.*/
+      if (bc_window_load(bcp, startblk)) {
+        bcp->state = BLK_READY;
+        return HAL_FAILED;
+      }
+      memcpy(buffer, cfg->tbuffer, (size_t)run * cfg->blk_size);
+    }
+    else {
+      /* Random access, the missing blocks are read directly in the
+         caller buffer then small runs are cached.*/
+      if (blkRead(cfg->bdp, startblk, buffer, run)) {
+        bcp->state = BLK_READY;
+        return HAL_FAILED;
+      }
+      bcp->dev_reads++;
+
+      if (run <= cfg->lines_num / 2U) {
+        for (i = 0U; i < run; i++) {
+          lp = bc_alloc(bcp, startblk + i);
+          if (lp == NULL) {
+            /* Replacement failed, the dirty line stays in the cache and
+               the error is reported on sync.*/
+            break;
+          }
+          memcpy(bc_line_data(bcp, lp),
+                 buffer + ((size_t)i * cfg->blk_size),
+                 cfg->blk_size);
+        }
+      }
+    }
+
+    buffer   += (size_t)run * cfg->blk_size;
+    startblk += run;
+    n        -= run;
+  }
+
+  /* Read operation finished.*/
+  bcp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ * @details Data is written in the cache lines and written to the device
+ *          later, large transfers are written directly to the device.
+ * @pre     The cache must be in the @p BLK_READY state after a successful
+ *          bcConnect() invocation.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] startblk  first block to write
+ * @param[in] buffer    pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool bcWrite(BlockCache *bcp, uint32_t startblk,
+             const uint8_t *buffer, uint32_t n) {
+  const BlockCacheConfig *cfg;
+  blkc_line_t *lp;
+  uint32_t i;
+
+  osalDbgCheck((bcp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(bcp->state == BLK_READY, "invalid state");
+
+  cfg = bcp->config;
+  if ((startblk >= bcp->blk_num) || (n > bcp->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  /* Write operation in progress.*/
+  bcp->state = BLK_WRITING;
+
+  if (n > cfg->lines_num / 2U) {
+    /* Large transfer, written through, cached copies are updated and are
+       now clean.*/
+    if (blkWrite(cfg->bdp, startblk, buffer, n)) {
+      bcp->state = BLK_READY;
+      return HAL_FAILED;
+    }
+    bcp->dev_writes++;
+
+    for (i = 0U; i < n; i++) {
+      const uint8_t *bp = buffer + ((size_t)i * cfg->blk_size);
+
+      lp = bc_find(bcp, startblk + i);
+      if (lp != NULL) {
+        memcpy(bc_line_data(bcp, lp), bp, cfg->blk_size);
+        lp->dirty = false;
+      }
+      bc_window_update(bcp, startblk + i, bp);
+    }
+  }
+  else {
+    for (i = 0U; i < n; i++) {
+      const uint8_t *bp = buffer + ((size_t)i * cfg->blk_size);
+
+      lp = bc_find(bcp, startblk + i);
+      if (lp == NULL) {
+        lp = bc_alloc(bcp, startblk + i);
+        if (lp == NULL) {
+          bcp->state = BLK_READY;
+          return HAL_FAILED;
+        }
+      }
+      else {
+        bc_touch(bcp, lp);
+      }
+      memcpy(bc_line_data(bcp, lp), bp, cfg->blk_size);
+      lp->dirty = true;
+      bc_window_update(bcp, startblk + i, bp);
+    }
+  }
+
+  /* Write operation finished.*/
+  bcp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes all the dirty lines to the device.
+ * @details Adjacent dirty lines are written using multi-block writes, the
+ *          cached device is then synchronized.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool bcSync(BlockCache *bcp) {
+  blkc_line_t *lp;
+  bool result = HAL_SUCCESS;
+
+  osalDbgCheck(bcp != NULL);
+
+  if (bcp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  /* Synchronization operation in progress.*/
+  bcp->state = BLK_SYNCING;
+
+  for (lp = bcp->config->lines;
+       lp < bcp->config->lines + bcp->config->lines_num;
+       lp++) {
+    if (lp->dirty && bc_flush(bcp, lp)) {
+      result = HAL_FAILED;
+    }
+  }
+
+  if (blkSync(bcp->config->bdp)) {
+    result = HAL_FAILED;
+  }
+
+  /* Synchronization operation finished.*/
+  bcp->state = BLK_READY;
+  return result;
+}
+
+/**
+ * @brief   Returns the media info.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[out] bdip     pointer to a @p BlockDeviceInfo structure
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool bcGetInfo(BlockCache *bcp, BlockDeviceInfo *bdip) {
+
+  osalDbgCheck((bcp != NULL) && (bdip != NULL));
+
+  if (bcp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  bdip->blk_num  = bcp->blk_num;
+  bdip->blk_size = bcp->config->blk_size;
+  return HAL_SUCCESS;
+}
+
+/** @} */
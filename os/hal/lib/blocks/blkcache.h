@@ -0,0 +1,192 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blkcache.h
+ * @brief   Block devices cache structures and macros.
+ *
+ * @addtogroup block_cache
+ * @{
+ */
+
+#ifndef BLKCACHE_H
+#define BLKCACHE_H
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Block number marking an unused cache line.
+ */
+#define BLKC_NO_BLOCK               0xFFFFFFFFU
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache line descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Cached block number or @p BLKC_NO_BLOCK.
+   */
+  uint32_t                  blk;
+  /**
+   * @brief   Time stamp of the last access, used for LRU replacement.
+   */
+  uint32_t                  stamp;
+  /**
+   * @brief   Line content has not yet been written to the device.
+   */
+  bool                      dirty;
+} blkc_line_t;
+
+/**
+ * @brief   Block cache configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Cached block device.
+   */
+  BaseBlockDevice           *bdp;
+  /**
+   * @brief   Block size of the cached device.
+   */
+  uint32_t                  blk_size;
+  /**
+   * @brief   Number of cache lines.
+   */
+  uint32_t                  lines_num;
+  /**
+   * @brief   Array of @p lines_num cache line descriptors.
+   */
+  blkc_line_t               *lines;
+  /**
+   * @brief   Cache lines data area, @p lines_num blocks.
+   */
+  uint8_t                   *buffer;
+  /**
+   * @brief   Transfer buffer or @p NULL.
+   * @details The transfer buffer holds the read-ahead window and is used
+   *          to gather adjacent dirty lines into multi-block writes.
+   */
+  uint8_t                   *tbuffer;
+  /**
+   * @brief   Size of the transfer buffer in blocks.
+   */
+  uint32_t                  tblocks;
+} BlockCacheConfig;
+
+/**
+ * @brief   @p BlockCache specific methods.
+ */
+#define _block_cache_methods                                                \
+  _base_block_device_methods
+
+/**
+ * @brief   @p BlockCache specific data.
+ */
+#define _block_cache_data                                                   \
+  _base_block_device_data                                                   \
+  /* Current configuration data.*/                                          \
+  const BlockCacheConfig    *config;                                        \
+  /* Number of blocks of the cached device.*/                               \
+  uint32_t                  blk_num;                                        \
+  /* Access time stamps counter.*/                                          \
+  uint32_t                  stamp;                                          \
+  /* Block following the last read request.*/                               \
+  uint32_t                  next;                                           \
+  /* First block in the read-ahead window.*/                                \
+  uint32_t                  ra_start;                                       \
+  /* Number of blocks in the read-ahead window.*/                           \
+  uint32_t                  ra_num;                                         \
+  /* Blocks served from the cache or from the read-ahead window.*/          \
+  uint32_t                  hits;                                           \
+  /* Blocks not found in the cache.*/                                       \
+  uint32_t                  misses;                                         \
+  /* Read operations performed on the device.*/                             \
+  uint32_t                  dev_reads;                                      \
+  /* Write operations performed on the device.*/                            \
+  uint32_t                  dev_writes;
+
+/**
+ * @brief   @p BlockCache virtual methods table.
+ */
+struct BlockCacheVMT {
+  _block_cache_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   Block cache object.
+ * @details A block cache is a block device caching another block device.
+ * @note    The cache is not protected against concurrent accesses, the
+ *          same as the underlying device drivers.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct BlockCacheVMT *vmt;
+  _block_cache_data
+} BlockCache;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Computes the size of a cache lines data area.
+ *
+ * @param[in] n         number of cache lines
+ * @param[in] size      block size
+ */
+#define BLKC_BUFFER_SIZE(n, size) ((size_t)(n) * (size_t)(size))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void bcObjectInit(BlockCache *bcp);
+  void bcStart(BlockCache *bcp, const BlockCacheConfig *config);
+  void bcStop(BlockCache *bcp);
+  bool bcConnect(BlockCache *bcp);
+  bool bcDisconnect(BlockCache *bcp);
+  bool bcRead(BlockCache *bcp, uint32_t startblk,
+              uint8_t *buffer, uint32_t n);
+  bool bcWrite(BlockCache *bcp, uint32_t startblk,
+               const uint8_t *buffer, uint32_t n);
+  bool bcSync(BlockCache *bcp);
+  bool bcGetInfo(BlockCache *bcp, BlockDeviceInfo *bdip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLKCACHE_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Block devices library files.
+BLOCKSSRC = $(CHIBIOS)/os/hal/lib/blocks/blkcache.c \
+            $(CHIBIOS)/os/hal/lib/blocks/ramdisk.c
+
+BLOCKSINC = $(CHIBIOS)/os/hal/lib/blocks
+
+# Host only block devices, simulator builds.
+BLOCKSHOSTSRC = $(CHIBIOS)/os/hal/lib/blocks/filedisk.c
@@ -0,0 +1,389 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    filedisk.c
+ * @brief   File disk code.
+ *
+ * @addtogroup file_disk
+ * @details A @p BaseBlockDevice implementation stored in a file of the
+ *          host, it allows to run and measure block devices clients on the
+ *          simulator platforms.
+ * @{
+ */
+
+/* Large files support on 32 bits Posix hosts, it must be enabled before
+   including any system header.*/
+#if !defined(_WIN32) && !defined(_FILE_OFFSET_BITS)
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+
+#include "hal.h"
+#include "filedisk.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @name    Image file positioning
+ * @note    Offsets are 64 bits wide, the @p long type used by @p fseek()
+ *          is 32 bits wide on Win32 and on 32 bits Posix hosts.
+ * @{
+ */
+#if defined(_WIN32) || defined(__DOXYGEN__)
+typedef long long fd_offset_t;
+#define fd_fseek(file, offset, whence) _fseeki64(file, offset, whence)
+#define fd_ftell(file) _ftelli64(file)
+#else
+typedef off_t fd_offset_t;
+#define fd_fseek(file, offset, whence) fseeko(file, offset, whence)
+#define fd_ftell(file) ftello(file)
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static bool fd_is_inserted(void *instance);
+static bool fd_is_protected(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct FileDiskVMT vmt = {
+  fd_is_inserted,
+  fd_is_protected,
+  (bool (*)(void *))fdConnect,
+  (bool (*)(void *))fdDisconnect,
+  (bool (*)(void *, uint32_t, uint8_t *, uint32_t))fdRead,
+  (bool (*)(void *, uint32_t, const uint8_t *, uint32_t))fdWrite,
+  (bool (*)(void *))fdSync,
+  (bool (*)(void *, BlockDeviceInfo *))fdGetInfo
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static bool fd_is_inserted(void *instance) {
+
+  (void)instance;
+
+  return true;
+}
+
+static bool fd_is_protected(void *instance) {
+
+  return ((FileDisk *)instance)->config->readonly;
+}
+
+/**
+ * @brief   Positions the image file on a block.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ * @param[in] startblk  block number
+ * @param[in] n         number of blocks to be transferred
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   out of range or seek error.
+ *
+ * @notapi
+ */
+static bool fd_seek(FileDisk *fdp, uint32_t startblk, uint32_t n) {
+
+  if ((startblk >= fdp->config->blk_num) ||
+      (n > fdp->config->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  return (bool)(fd_fseek(fdp->file,
+                         (fd_offset_t)startblk *
+                         (fd_offset_t)fdp->config->blk_size,
+                         SEEK_SET) != 0);
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   File disk object initialization.
+ *
+ * @param[out] fdp      pointer to the @p FileDisk object
+ *
+ * @init
+ */
+void fdObjectInit(FileDisk *fdp) {
+
+  fdp->vmt    = &vmt;
+  fdp->state  = BLK_STOP;
+  fdp->config = NULL;
+  fdp->file   = NULL;
+  fdp->reads  = 0U;
+  fdp->writes = 0U;
+}
+
+/**
+ * @brief   Configures and activates the file disk.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ * @param[in] config    pointer to the @p FileDiskConfig object
+ *
+ * @api
+ */
+void fdStart(FileDisk *fdp, const FileDiskConfig *config) {
+
+  osalDbgCheck((fdp != NULL) && (config != NULL) &&
+               (config->path != NULL) && (config->blk_size > 0U));
+  osalDbgAssert((fdp->state == BLK_STOP) || (fdp->state == BLK_ACTIVE),
+                "invalid state");
+
+  fdp->config = config;
+  fdp->state  = BLK_ACTIVE;
+}
+
+/**
+ * @brief   Deactivates the file disk.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ *
+ * @api
+ */
+void fdStop(FileDisk *fdp) {
+
+  osalDbgCheck(fdp != NULL);
+  osalDbgAssert((fdp->state == BLK_STOP) || (fdp->state == BLK_ACTIVE),
+                "invalid state");
+
+  fdp->config = NULL;
+  fdp->state  = BLK_STOP;
+}
+
+/**
+ * @brief   Connects the file disk.
+ * @details The image file is opened, it is created if not existing and
+ *          extended to the disk size if shorter.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   the image file could not be opened.
+ *
+ * @api
+ */
+bool fdConnect(FileDisk *fdp) {
+  fd_offset_t size;
+
+  osalDbgCheck(fdp != NULL);
+  osalDbgAssert((fdp->state == BLK_ACTIVE) || (fdp->state == BLK_READY),
+                "invalid state");
+
+  if (fdp->state == BLK_READY) {
+    return HAL_SUCCESS;
+  }
+
+  fdp->state = BLK_CONNECTING;
+
+  size = (fd_offset_t)fdp->config->blk_num *
+         (fd_offset_t)fdp->config->blk_size;
+  if (fdp->config->readonly) {
+    fdp->file = fopen(fdp->config->path, "rb");
+  }
+  else {
+    fdp->file = fopen(fdp->config->path, "r+b");
+    if (fdp->file == NULL) {
+      fdp->file = fopen(fdp->config->path, "w+b");
+    }
+  }
+  if (fdp->file == NULL) {
+    fdp->state = BLK_ACTIVE;
+    return HAL_FAILED;
+  }
+
+  /* Short images are extended with zeros.*/
+  if ((fd_fseek(fdp->file, (fd_offset_t)0, SEEK_END) != 0) ||
+      ((fd_ftell(fdp->file) < size) &&
+       (fdp->config->readonly ||
+        (fd_fseek(fdp->file, size - (fd_offset_t)1, SEEK_SET) != 0) ||
+        (fputc(0, fdp->file) == EOF)))) {
+    (void)fclose(fdp->file);
+    fdp->file  = NULL;
+    fdp->state = BLK_ACTIVE;
+    return HAL_FAILED;
+  }
+
+  fdp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Disconnects the file disk.
+ * @details The image file is closed.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool fdDisconnect(FileDisk *fdp) {
+  bool result;
+
+  osalDbgCheck(fdp != NULL);
+  osalDbgAssert((fdp->state == BLK_ACTIVE) || (fdp->state == BLK_READY),
+                "invalid state");
+
+  if (fdp->state == BLK_ACTIVE) {
+    return HAL_SUCCESS;
+  }
+
+  fdp->state = BLK_DISCONNECTING;
+  result = (bool)(fclose(fdp->file) != 0);
+  fdp->file  = NULL;
+  fdp->state = BLK_ACTIVE;
+
+  return result;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ * @param[in] startblk  first block to read
+ * @param[out] buffer   pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool fdRead(FileDisk *fdp, uint32_t startblk,
+            uint8_t *buffer, uint32_t n) {
+  bool result;
+
+  osalDbgCheck((fdp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(fdp->state == BLK_READY, "invalid state");
+
+  fdp->state = BLK_READING;
+  result = fd_seek(fdp, startblk, n) ||
+           (fread(buffer, fdp->config->blk_size, n, fdp->file) != n);
+  fdp->reads++;
+  fdp->state = BLK_READY;
+
+  return result;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ * @param[in] startblk  first block to write
+ * @param[in] buffer    pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool fdWrite(FileDisk *fdp, uint32_t startblk,
+             const uint8_t *buffer, uint32_t n) {
+  bool result;
+
+  osalDbgCheck((fdp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(fdp->state == BLK_READY, "invalid state");
+
+  if (fdp->config->readonly) {
+    return HAL_FAILED;
+  }
+
+  fdp->state = BLK_WRITING;
+  result = fd_seek(fdp, startblk, n) ||
+           (fwrite(buffer, fdp->config->blk_size, n, fdp->file) != n);
+  fdp->writes++;
+  fdp->state = BLK_READY;
+
+  return result;
+}
+
+/**
+ * @brief   Ensures write synchronization.
+ * @details The C library buffers are flushed to the host.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool fdSync(FileDisk *fdp) {
+  bool result;
+
+  osalDbgCheck(fdp != NULL);
+
+  if (fdp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  fdp->state = BLK_SYNCING;
+  result = (bool)(fflush(fdp->file) != 0);
+  fdp->state = BLK_READY;
+
+  return result;
+}
+
+/**
+ * @brief   Returns the media info.
+ *
+ * @param[in] fdp       pointer to the @p FileDisk object
+ * @param[out] bdip     pointer to a @p BlockDeviceInfo structure
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool fdGetInfo(FileDisk *fdp, BlockDeviceInfo *bdip) {
+
+  osalDbgCheck((fdp != NULL) && (bdip != NULL));
+
+  if (fdp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  bdip->blk_num  = fdp->config->blk_num;
+  bdip->blk_size = fdp->config->blk_size;
+  return HAL_SUCCESS;
+}
+
+/** @} */
@@ -0,0 +1,139 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    filedisk.h
+ * @brief   File disk structures and macros.
+ * @note    The file disk requires a hosted C library, it is meant for
+ *          the simulator platforms.
+ *
+ * @addtogroup file_disk
+ * @{
+ */
+
+#ifndef FILEDISK_H
+#define FILEDISK_H
+
+#include <stdio.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   File disk configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Path of the image file.
+   * @note    The file is created if not existing and extended to the disk
+   *          size if shorter.
+   */
+  const char                *path;
+  /**
+   * @brief   Block size in bytes.
+   */
+  uint32_t                  blk_size;
+  /**
+   * @brief   Total number of blocks.
+   */
+  uint32_t                  blk_num;
+  /**
+   * @brief   Write protection.
+   */
+  bool                      readonly;
+} FileDiskConfig;
+
+/**
+ * @brief   @p FileDisk specific methods.
+ */
+#define _file_disk_methods                                                  \
+  _base_block_device_methods
+
+/**
+ * @brief   @p FileDisk specific data.
+ */
+#define _file_disk_data                                                     \
+  _base_block_device_data                                                   \
+  /* Current configuration data.*/                                          \
+  const FileDiskConfig      *config;                                        \
+  /* Image file.*/                                                          \
+  FILE                      *file;                                          \
+  /* Number of read operations.*/                                           \
+  uint32_t                  reads;                                          \
+  /* Number of write operations.*/                                          \
+  uint32_t                  writes;
+
+/**
+ * @brief   @p FileDisk virtual methods table.
+ */
+struct FileDiskVMT {
+  _file_disk_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   File disk object.
+ * @details A block device stored in a file of the host file system.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct FileDiskVMT  *vmt;
+  _file_disk_data
+} FileDisk;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void fdObjectInit(FileDisk *fdp);
+  void fdStart(FileDisk *fdp, const FileDiskConfig *config);
+  void fdStop(FileDisk *fdp);
+  bool fdConnect(FileDisk *fdp);
+  bool fdDisconnect(FileDisk *fdp);
+  bool fdRead(FileDisk *fdp, uint32_t startblk,
+              uint8_t *buffer, uint32_t n);
+  bool fdWrite(FileDisk *fdp, uint32_t startblk,
+               const uint8_t *buffer, uint32_t n);
+  bool fdSync(FileDisk *fdp);
+  bool fdGetInfo(FileDisk *fdp, BlockDeviceInfo *bdip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILEDISK_H */
+
+/** @} */
@@ -0,0 +1,291 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ramdisk.c
+ * @brief   RAM disk code.
+ *
+ * @addtogroup ram_disk
+ * @details A @p BaseBlockDevice implementation over a memory area, it is
+ *          useful as temporary storage and as reference device when
+ *          measuring the performance of block device clients.
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "ramdisk.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static bool rd_is_inserted(void *instance);
+static bool rd_is_protected(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct RamDiskVMT vmt = {
+  rd_is_inserted,
+  rd_is_protected,
+  (bool (*)(void *))rdConnect,
+  (bool (*)(void *))rdDisconnect,
+  (bool (*)(void *, uint32_t, uint8_t *, uint32_t))rdRead,
+  (bool (*)(void *, uint32_t, const uint8_t *, uint32_t))rdWrite,
+  (bool (*)(void *))rdSync,
+  (bool (*)(void *, BlockDeviceInfo *))rdGetInfo
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static bool rd_is_inserted(void *instance) {
+
+  (void)instance;
+
+  return true;
+}
+
+static bool rd_is_protected(void *instance) {
+
+  return ((RamDisk *)instance)->config->readonly;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM disk object initialization.
+ *
+ * @param[out] rdp      pointer to the @p RamDisk object
+ *
+ * @init
+ */
+void rdObjectInit(RamDisk *rdp) {
+
+  rdp->vmt    = &vmt;
+  rdp->state  = BLK_STOP;
+  rdp->config = NULL;
+  rdp->reads  = 0U;
+  rdp->writes = 0U;
+}
+
+/**
+ * @brief   Configures and activates the RAM disk.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ * @param[in] config    pointer to the @p RamDiskConfig object
+ *
+ * @api
+ */
+void rdStart(RamDisk *rdp, const RamDiskConfig *config) {
+
+  osalDbgCheck((rdp != NULL) && (config != NULL) &&
+               (config->storage != NULL) && (config->blk_size > 0U));
+  osalDbgAssert((rdp->state == BLK_STOP) || (rdp->state == BLK_ACTIVE),
+                "invalid state");
+
+  rdp->config = config;
+  rdp->state  = BLK_ACTIVE;
+}
+
+/**
+ * @brief   Deactivates the RAM disk.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ *
+ * @api
+ */
+void rdStop(RamDisk *rdp) {
+
+  osalDbgCheck(rdp != NULL);
+  osalDbgAssert((rdp->state == BLK_STOP) || (rdp->state == BLK_ACTIVE),
+                "invalid state");
+
+  rdp->config = NULL;
+  rdp->state  = BLK_STOP;
+}
+
+/**
+ * @brief   Connects the RAM disk.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ *
+ * @api
+ */
+bool rdConnect(RamDisk *rdp) {
+
+  osalDbgCheck(rdp != NULL);
+  osalDbgAssert((rdp->state == BLK_ACTIVE) || (rdp->state == BLK_READY),
+                "invalid state");
+
+  rdp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Disconnects the RAM disk.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ *
+ * @api
+ */
+bool rdDisconnect(RamDisk *rdp) {
+
+  osalDbgCheck(rdp != NULL);
+  osalDbgAssert((rdp->state == BLK_ACTIVE) || (rdp->state == BLK_READY),
+                "invalid state");
+
+  rdp->state = BLK_ACTIVE;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ * @param[in] startblk  first block to read
+ * @param[out] buffer   pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool rdRead(RamDisk *rdp, uint32_t startblk,
+            uint8_t *buffer, uint32_t n) {
+
+  osalDbgCheck((rdp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(rdp->state == BLK_READY, "invalid state");
+
+  if ((startblk >= rdp->config->blk_num) ||
+      (n > rdp->config->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  rdp->state = BLK_READING;
+  memcpy(buffer,
+         rdp->config->storage + ((size_t)startblk * rdp->config->blk_size),
+         (size_t)n * rdp->config->blk_size);
+  rdp->reads++;
+  rdp->state = BLK_READY;
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ * @param[in] startblk  first block to write
+ * @param[in] buffer    pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool rdWrite(RamDisk *rdp, uint32_t startblk,
+             const uint8_t *buffer, uint32_t n) {
+
+  osalDbgCheck((rdp != NULL) && (buffer != NULL) && (n > 0U));
+  osalDbgAssert(rdp->state == BLK_READY, "invalid state");
+
+  if (rdp->config->readonly || (startblk >= rdp->config->blk_num) ||
+      (n > rdp->config->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  rdp->state = BLK_WRITING;
+  memcpy(rdp->config->storage + ((size_t)startblk * rdp->config->blk_size),
+         buffer,
+         (size_t)n * rdp->config->blk_size);
+  rdp->writes++;
+  rdp->state = BLK_READY;
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Ensures write synchronization.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool rdSync(RamDisk *rdp) {
+
+  osalDbgCheck(rdp != NULL);
+
+  if (rdp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Returns the media info.
+ *
+ * @param[in] rdp       pointer to the @p RamDisk object
+ * @param[out] bdip     pointer to a @p BlockDeviceInfo structure
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool rdGetInfo(RamDisk *rdp, BlockDeviceInfo *bdip) {
+
+  osalDbgCheck((rdp != NULL) && (bdip != NULL));
+
+  if (rdp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  bdip->blk_num  = rdp->config->blk_num;
+  bdip->blk_size = rdp->config->blk_size;
+  return HAL_SUCCESS;
+}
+
+/** @} */
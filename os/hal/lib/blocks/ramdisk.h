@@ -0,0 +1,130 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ramdisk.h
+ * @brief   RAM disk structures and macros.
+ *
+ * @addtogroup ram_disk
+ * @{
+ */
+
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM disk configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Disk storage area, @p blk_num blocks of @p blk_size bytes.
+   */
+  uint8_t                   *storage;
+  /**
+   * @brief   Block size in bytes.
+   */
+  uint32_t                  blk_size;
+  /**
+   * @brief   Total number of blocks.
+   */
+  uint32_t                  blk_num;
+  /**
+   * @brief   Write protection.
+   */
+  bool                      readonly;
+} RamDiskConfig;
+
+/**
+ * @brief   @p RamDisk specific methods.
+ */
+#define _ram_disk_methods                                                   \
+  _base_block_device_methods
+
+/**
+ * @brief   @p RamDisk specific data.
+ */
+#define _ram_disk_data                                                      \
+  _base_block_device_data                                                   \
+  /* Current configuration data.*/                                          \
+  const RamDiskConfig       *config;                                        \
+  /* Number of read operations.*/                                           \
+  uint32_t                  reads;                                          \
+  /* Number of write operations.*/                                          \
+  uint32_t                  writes;
+
+/**
+ * @brief   @p RamDisk virtual methods table.
+ */
+struct RamDiskVMT {
+  _ram_disk_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   RAM disk object.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct RamDiskVMT   *vmt;
+  _ram_disk_data
+} RamDisk;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void rdObjectInit(RamDisk *rdp);
+  void rdStart(RamDisk *rdp, const RamDiskConfig *config);
+  void rdStop(RamDisk *rdp);
+  bool rdConnect(RamDisk *rdp);
+  bool rdDisconnect(RamDisk *rdp);
+  bool rdRead(RamDisk *rdp, uint32_t startblk,
+              uint8_t *buffer, uint32_t n);
+  bool rdWrite(RamDisk *rdp, uint32_t startblk,
+               const uint8_t *buffer, uint32_t n);
+  bool rdSync(RamDisk *rdp);
+  bool rdGetInfo(RamDisk *rdp, BlockDeviceInfo *bdip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAMDISK_H */
+
+/** @} */
@@ -0,0 +1,14 @@
+# List of the device-independent flash files.
+FLASHSRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_flash.c
+
+# Required include directories
+FLASHINC := $(CHIBIOS)/os/hal/lib/peripherals/flash
+
+# Optional flash read cache.
+FLASHCACHESRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_flash_cache.c
+
+# Optional flash translation layer.
+FLASHFTLSRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_flash_ftl.c
+
+# RAM flash device.
+FLASHRAMSRC := $(CHIBIOS)/os/hal/lib/peripherals/flash/hal_flash_ram.c
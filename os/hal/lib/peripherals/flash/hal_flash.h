@@ -61,7 +61,8 @@ typedef enum {
   FLASH_READY = 2,
   FLASH_READ = 3,
   FLASH_PGM = 4,
-  FLASH_ERASE = 5
+  FLASH_ERASE = 5,
+  FLASH_SUSPENDED = 6
 } flash_state_t;
 
 /**
@@ -156,7 +157,11 @@ typedef struct {
                                       flash_sector_t sector);               \
   flash_error_t (*query_erase)(void *instance, uint32_t *wait_time);        \
   /* Verify erase single sector.*/                                          \
-  flash_error_t (*verify_erase)(void *instance, flash_sector_t sector);
+  flash_error_t (*verify_erase)(void *instance, flash_sector_t sector);     \
+  /* Suspend erase operation.*/                                             \
+  flash_error_t (*suspend_erase)(void *instance);                           \
+  /* Resume erase operation.*/                                              \
+  flash_error_t (*resume_erase)(void *instance);
 
 /**
  * @brief   @p BaseFlash specific methods with inherited ones.
@@ -218,6 +223,9 @@ typedef struct {
  * @retval FLASH_NO_ERROR if there is no erase operation in progress.
  * @retval FLASH_BUSY_ERASING if there is an erase operation in progress.
  * @retval FLASH_ERROR_READ if the read operation failed.
+ * @note    Devices with the @p FLASH_ATTR_SUSPEND_ERASE_CAPABLE attribute
+ *          can serve reads during an erase operation by transparently
+ *          suspending and resuming it.
  *
  * @api
  */
@@ -298,6 +306,37 @@ typedef struct {
  */
 #define flashVerifyErase(ip, sector)                                        \
   (ip)->vmt->verify_erase(ip, sector)
+
+/**
+ * @brief   Suspends the erase operation in progress.
+ * @details While the erase is suspended it is possible to read and program
+ *          locations outside the sectors being erased.
+ * @note    Only devices with the @p FLASH_ATTR_SUSPEND_ERASE_CAPABLE
+ *          attribute are able to suspend an erase operation.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if the erase has been suspended or there is no
+ *                      erase operation in progress.
+ * @retval FLASH_BUSY_ERASING if the erase operation cannot be suspended.
+ * @retval FLASH_ERROR_ERASE if the erase operation failed.
+ *
+ * @api
+ */
+#define flashSuspendErase(ip)                                               \
+  (ip)->vmt->suspend_erase(ip)
+
+/**
+ * @brief   Resumes a suspended erase operation.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if there is no error.
+ *
+ * @api
+ */
+#define flashResumeErase(ip)                                                \
+  (ip)->vmt->resume_erase(ip)
 /** @} */
 
 /*===========================================================================*/
@@ -0,0 +1,497 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_flash_cache.c
+ * @brief   Flash read cache code.
+ * @details The cache keeps line sized copies of the device content in LRU
+ *          replaced lines, reads of small records are so served without
+ *          issuing a device command each time.<br>
+ *          If a prefetch buffer is configured then sequential reads are
+ *          detected and the following lines are loaded with a single
+ *          device read.<br>
+ *          Reads larger than half the cache lines bypass the cache in
+ *          order to not evict the frequently accessed lines.<br>
+ *          Program and erase operations are passed to the device and
+ *          invalidate the affected lines, changes made to the device
+ *          without going through the cache require an explicit
+ *          invalidation.
+ *
+ * @addtogroup HAL_FLASH_CACHE
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "hal_flash_cache.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static const flash_descriptor_t *fc_get_descriptor(void *instance);
+static flash_error_t fc_program(void *instance, flash_offset_t offset,
+                                size_t n, const uint8_t *pp);
+static flash_error_t fc_start_erase_all(void *instance);
+static flash_error_t fc_start_erase_sector(void *instance,
+                                           flash_sector_t sector);
+static flash_error_t fc_query_erase(void *instance, uint32_t *msec);
+static flash_error_t fc_verify_erase(void *instance, flash_sector_t sector);
+static flash_error_t fc_suspend_erase(void *instance);
+static flash_error_t fc_resume_erase(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct FlashCacheVMT vmt = {
+  fc_get_descriptor,
+  (flash_error_t (*)(void *, flash_offset_t, size_t, uint8_t *))flashcRead,
+  fc_program,
+  fc_start_erase_all,
+  fc_start_erase_sector,
+  fc_query_erase,
+  fc_verify_erase,
+  fc_suspend_erase,
+  fc_resume_erase
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the data area of a cache line.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] lp        pointer to the cache line descriptor
+ * @return              Pointer to the line data.
+ *
+ * @notapi
+ */
+static uint8_t *fc_line_data(FlashCache *fcp, flashc_line_t *lp) {
+
+  return fcp->config->buffer +
+         ((size_t)(lp - fcp->config->lines) * fcp->config->line_size);
+}
+
+/**
+ * @brief   Searches a line in the cache.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    line offset
+ * @return              The cache line.
+ * @retval NULL         if the line is not cached.
+ *
+ * @notapi
+ */
+static flashc_line_t *fc_find(FlashCache *fcp, flash_offset_t offset) {
+  flashc_line_t *lp = fcp->config->lines;
+  flashc_line_t *end = lp + fcp->config->lines_num;
+
+  while (lp < end) {
+    if (lp->offset == offset) {
+      return lp;
+    }
+    lp++;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Searches a line in the prefetch window.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    line offset
+ * @return              Pointer to the line data in the window.
+ * @retval NULL         if the line is not in the window.
+ *
+ * @notapi
+ */
+static uint8_t *fc_window_find(FlashCache *fcp, flash_offset_t offset) {
+
+  if ((uint32_t)(offset - fcp->pf_start) < fcp->pf_size) {
+    return fcp->config->pbuffer + (offset - fcp->pf_start);
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Returns the size of a line, the last one can be truncated.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    line offset
+ * @return              The line size.
+ *
+ * @notapi
+ */
+static size_t fc_line_size(FlashCache *fcp, flash_offset_t offset) {
+
+  if (fcp->size - offset < fcp->config->line_size) {
+    return (size_t)(fcp->size - offset);
+  }
+  return (size_t)fcp->config->line_size;
+}
+
+/**
+ * @brief   Assigns a line to a flash offset.
+ * @details A free line is used if available, else the least recently used
+ *          line is replaced.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    line offset
+ * @return              The assigned line, its content is undefined.
+ *
+ * @notapi
+ */
+static flashc_line_t *fc_alloc(FlashCache *fcp, flash_offset_t offset) {
+  flashc_line_t *lp = fcp->config->lines;
+  flashc_line_t *end = lp + fcp->config->lines_num;
+  flashc_line_t *victim = lp;
+
+  while (lp < end) {
+    if (lp->offset == FLASHC_NO_LINE) {
+      victim = lp;
+      break;
+    }
+    if ((uint32_t)(fcp->stamp - lp->stamp) >
+        (uint32_t)(fcp->stamp - victim->stamp)) {
+      victim = lp;
+    }
+    lp++;
+  }
+
+  victim->offset = offset;
+  victim->stamp  = fcp->stamp++;
+  return victim;
+}
+
+/**
+ * @brief   Loads the prefetch window.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    first line of the window
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t fc_window_load(FlashCache *fcp, flash_offset_t offset) {
+  const FlashCacheConfig *cfg = fcp->config;
+  flash_error_t err;
+  size_t n = (size_t)cfg->plines * (size_t)cfg->line_size;
+
+  if (n > (size_t)(fcp->size - offset)) {
+    n = (size_t)(fcp->size - offset);
+  }
+
+  fcp->pf_size = 0U;
+  err = flashRead(cfg->flashp, offset, n, cfg->pbuffer);
+  fcp->dev_reads++;
+  if (err == FLASH_NO_ERROR) {
+    fcp->pf_start = offset;
+    fcp->pf_size  = (uint32_t)n;
+  }
+
+  return err;
+}
+
+/**
+ * @brief   Drops the whole cache content.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ *
+ * @notapi
+ */
+static void fc_reset(FlashCache *fcp) {
+  flashc_line_t *lp;
+
+  for (lp = fcp->config->lines;
+       lp < fcp->config->lines + fcp->config->lines_num;
+       lp++) {
+    lp->offset = FLASHC_NO_LINE;
+    lp->stamp  = 0U;
+  }
+  fcp->stamp   = 0U;
+  fcp->next    = FLASHC_NO_LINE;
+  fcp->pf_size = 0U;
+}
+
+static const flash_descriptor_t *fc_get_descriptor(void *instance) {
+
+  return flashGetDescriptor(((FlashCache *)instance)->config->flashp);
+}
+
+static flash_error_t fc_program(void *instance, flash_offset_t offset,
+                                size_t n, const uint8_t *pp) {
+  FlashCache *fcp = (FlashCache *)instance;
+
+  flashcInvalidate(fcp, offset, n);
+  return flashProgram(fcp->config->flashp, offset, n, pp);
+}
+
+static flash_error_t fc_start_erase_all(void *instance) {
+  FlashCache *fcp = (FlashCache *)instance;
+
+  fc_reset(fcp);
+  return flashStartEraseAll(fcp->config->flashp);
+}
+
+static flash_error_t fc_start_erase_sector(void *instance,
+                                           flash_sector_t sector) {
+  FlashCache *fcp = (FlashCache *)instance;
+  BaseFlash *flashp = fcp->config->flashp;
+
+  flashcInvalidate(fcp, flashGetSectorOffset(flashp, sector),
+                   (size_t)flashGetSectorSize(flashp, sector));
+  return flashStartEraseSector(flashp, sector);
+}
+
+static flash_error_t fc_query_erase(void *instance, uint32_t *msec) {
+
+  return flashQueryErase(((FlashCache *)instance)->config->flashp, msec);
+}
+
+static flash_error_t fc_verify_erase(void *instance, flash_sector_t sector) {
+
+  return flashVerifyErase(((FlashCache *)instance)->config->flashp, sector);
+}
+
+static flash_error_t fc_suspend_erase(void *instance) {
+
+  return flashSuspendErase(((FlashCache *)instance)->config->flashp);
+}
+
+static flash_error_t fc_resume_erase(void *instance) {
+
+  return flashResumeErase(((FlashCache *)instance)->config->flashp);
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Flash cache object initialization.
+ *
+ * @param[out] fcp      pointer to the @p FlashCache object
+ *
+ * @init
+ */
+void flashcObjectInit(FlashCache *fcp) {
+
+  fcp->vmt       = &vmt;
+  fcp->state     = FLASH_STOP;
+  fcp->config    = NULL;
+  fcp->size      = 0U;
+  fcp->hits      = 0U;
+  fcp->misses    = 0U;
+  fcp->dev_reads = 0U;
+}
+
+/**
+ * @brief   Configures and activates the flash cache.
+ * @pre     The cached device must have been started.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] config    pointer to the @p FlashCacheConfig object
+ *
+ * @api
+ */
+void flashcStart(FlashCache *fcp, const FlashCacheConfig *config) {
+  const flash_descriptor_t *descriptor;
+  flash_sector_t last;
+
+  osalDbgCheck((fcp != NULL) && (config != NULL) &&
+               (config->flashp != NULL) && (config->line_size > 0U) &&
+               ((config->line_size & (config->line_size - 1U)) == 0U) &&
+               (config->lines_num > 0U) && (config->lines != NULL) &&
+               (config->buffer != NULL) &&
+               ((config->pbuffer == NULL) || (config->plines > 0U)));
+  osalDbgAssert((fcp->state == FLASH_STOP) || (fcp->state == FLASH_READY),
+                "invalid state");
+
+  descriptor = flashGetDescriptor(config->flashp);
+  last = descriptor->sectors_count - 1U;
+
+  fcp->config = config;
+  fcp->size   = flashGetSectorOffset(config->flashp, last) +
+                flashGetSectorSize(config->flashp, last);
+  fc_reset(fcp);
+  fcp->state  = FLASH_READY;
+}
+
+/**
+ * @brief   Deactivates the flash cache.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ *
+ * @api
+ */
+void flashcStop(FlashCache *fcp) {
+
+  osalDbgCheck(fcp != NULL);
+  osalDbgAssert((fcp->state == FLASH_STOP) || (fcp->state == FLASH_READY),
+                "invalid state");
+
+  fcp->config = NULL;
+  fcp->state  = FLASH_STOP;
+}
+
+/**
+ * @brief   Invalidates the cached copies of a flash area.
+ * @note    Required only if the device content is changed without going
+ *          through the cache, for example using a memory mapping or
+ *          another driver.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    flash offset
+ * @param[in] n         size of the area
+ *
+ * @api
+ */
+void flashcInvalidate(FlashCache *fcp, flash_offset_t offset, size_t n) {
+  flash_offset_t start, end;
+  flashc_line_t *lp;
+
+  osalDbgCheck(fcp != NULL);
+  osalDbgAssert(fcp->state == FLASH_READY, "invalid state");
+
+  if ((n == 0U) || (offset >= fcp->size)) {
+    return;
+  }
+  if (n > (size_t)(fcp->size - offset)) {
+    n = (size_t)(fcp->size - offset);
+  }
+
+  start = offset & ~(fcp->config->line_size - 1U);
+  end   = offset + (flash_offset_t)n;
+  for (lp = fcp->config->lines;
+       lp < fcp->config->lines + fcp->config->lines_num;
+       lp++) {
+    if ((lp->offset != FLASHC_NO_LINE) &&
+        (lp->offset >= start) && (lp->offset < end)) {
+      lp->offset = FLASHC_NO_LINE;
+    }
+  }
+
+  if ((fcp->pf_size > 0U) && (fcp->pf_start < end) &&
+      (fcp->pf_start + fcp->pf_size > offset)) {
+    fcp->pf_size = 0U;
+  }
+}
+
+/**
+ * @brief   Read operation.
+ * @details Cached lines are served from memory, missing lines are read
+ *          from the device and cached.
+ * @note    Cached lines can be read while the device is erasing, the
+ *          missing ones are subject to the device erase handling.
+ *
+ * @param[in] fcp       pointer to the @p FlashCache object
+ * @param[in] offset    flash offset
+ * @param[in] n         number of bytes to be read
+ * @param[out] rp       pointer to the data buffer
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING if there is an erase operation in progress.
+ * @retval FLASH_ERROR_READ if the read operation failed.
+ *
+ * @api
+ */
+flash_error_t flashcRead(FlashCache *fcp, flash_offset_t offset,
+                         size_t n, uint8_t *rp) {
+  const FlashCacheConfig *cfg;
+  flash_error_t err;
+  bool sequential;
+
+  osalDbgCheck((fcp != NULL) && (rp != NULL) && (n > 0U));
+  osalDbgAssert(fcp->state == FLASH_READY, "invalid state");
+  osalDbgCheck((offset < fcp->size) && (n <= (size_t)(fcp->size - offset)));
+
+  cfg = fcp->config;
+  sequential = (bool)(offset == fcp->next);
+  fcp->next  = offset + (flash_offset_t)n;
+
+  /* Large reads go straight to the device.*/
+  if (n > ((size_t)cfg->lines_num / 2U) * (size_t)cfg->line_size) {
+    fcp->misses++;
+    fcp->dev_reads++;
+    return flashRead(cfg->flashp, offset, n, rp);
+  }
+
+  while (n > 0U) {
+    flash_offset_t line = offset & ~(cfg->line_size - 1U);
+    size_t pos = (size_t)(offset - line);
+    size_t chunk = (size_t)cfg->line_size - pos;
+    flashc_line_t *lp;
+    uint8_t *wp;
+
+    if (chunk > n) {
+      chunk = n;
+    }
+
+    lp = fc_find(fcp, line);
+    if (lp != NULL) {
+      lp->stamp = fcp->stamp++;
+      fcp->hits++;
+      memcpy(rp, fc_line_data(fcp, lp) + pos, chunk);
+    }
+    else if ((wp = fc_window_find(fcp, line)) != NULL) {
+      fcp->hits++;
+      memcpy(rp, wp + pos, chunk);
+    }
+    else if (sequential && (cfg->pbuffer != NULL)) {
+      /* Sequential access, the missing line and the following ones are
+         loaded in the prefetch window.*/
+      fcp->misses++;
+      err = fc_window_load(fcp, line);
+      if (err != FLASH_NO_ERROR) {
+        return err;
+      }
+      memcpy(rp, cfg->pbuffer + pos, chunk);
+    }
+    else {
+      /* Random access, the line is loaded in the cache.*/
+      fcp->misses++;
+      lp = fc_alloc(fcp, line);
+      err = flashRead(cfg->flashp, line, fc_line_size(fcp, line),
+                      fc_line_data(fcp, lp));
+      fcp->dev_reads++;
+      if (err != FLASH_NO_ERROR) {
+        lp->offset = FLASHC_NO_LINE;
+        return err;
+      }
+      memcpy(rp, fc_line_data(fcp, lp) + pos, chunk);
+    }
+
+    rp     += chunk;
+    offset += (flash_offset_t)chunk;
+    n      -= chunk;
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+/** @} */
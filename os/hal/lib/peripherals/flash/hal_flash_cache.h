@@ -0,0 +1,186 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_flash_cache.h
+ * @brief   Flash read cache structures and macros.
+ *
+ * @addtogroup HAL_FLASH_CACHE
+ * @{
+ */
+
+#ifndef HAL_FLASH_CACHE_H
+#define HAL_FLASH_CACHE_H
+
+#include "hal_flash.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Offset marking an unused cache line.
+ */
+#define FLASHC_NO_LINE              0xFFFFFFFFU
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache line descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Flash offset of the cached line or @p FLASHC_NO_LINE.
+   */
+  flash_offset_t            offset;
+  /**
+   * @brief   Time stamp of the last access, used for LRU replacement.
+   */
+  uint32_t                  stamp;
+} flashc_line_t;
+
+/**
+ * @brief   Flash cache configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Cached flash device.
+   */
+  BaseFlash                 *flashp;
+  /**
+   * @brief   Line size, a power of two, usually the device page size.
+   */
+  uint32_t                  line_size;
+  /**
+   * @brief   Number of cache lines.
+   */
+  uint32_t                  lines_num;
+  /**
+   * @brief   Array of @p lines_num cache line descriptors.
+   */
+  flashc_line_t             *lines;
+  /**
+   * @brief   Cache lines data area, @p lines_num lines.
+   */
+  uint8_t                   *buffer;
+  /**
+   * @brief   Prefetch buffer or @p NULL.
+   * @details The prefetch buffer holds the lines following a sequential
+   *          miss, loaded with a single device read.
+   */
+  uint8_t                   *pbuffer;
+  /**
+   * @brief   Size of the prefetch buffer in lines.
+   */
+  uint32_t                  plines;
+} FlashCacheConfig;
+
+/**
+ * @brief   @p FlashCache specific methods.
+ */
+#define _flash_cache_methods                                                \
+  _base_flash_methods
+
+/**
+ * @brief   @p FlashCache specific data.
+ */
+#define _flash_cache_data                                                   \
+  _base_flash_data                                                          \
+  /* Current configuration data.*/                                          \
+  const FlashCacheConfig    *config;                                        \
+  /* Size of the cached device.*/                                           \
+  flash_offset_t            size;                                           \
+  /* Access time stamps counter.*/                                          \
+  uint32_t                  stamp;                                          \
+  /* Offset following the last read request.*/                              \
+  flash_offset_t            next;                                           \
+  /* First line in the prefetch window.*/                                   \
+  flash_offset_t            pf_start;                                       \
+  /* Size of the prefetch window.*/                                         \
+  uint32_t                  pf_size;                                        \
+  /* Lines served from the cache or from the prefetch window.*/             \
+  uint32_t                  hits;                                           \
+  /* Lines not found in the cache.*/                                        \
+  uint32_t                  misses;                                         \
+  /* Read operations performed on the device.*/                             \
+  uint32_t                  dev_reads;
+
+/**
+ * @brief   @p FlashCache virtual methods table.
+ */
+struct FlashCacheVMT {
+  _flash_cache_methods
+};
+
+/**
+ * @extends BaseFlash
+ *
+ * @brief   Flash read cache object.
+ * @details A flash cache is a flash device caching the reads of another
+ *          flash device, program and erase operations are passed through
+ *          and invalidate the affected lines.
+ * @note    The cache is not protected against concurrent accesses, the
+ *          same as the underlying device drivers.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct FlashCacheVMT *vmt;
+  _flash_cache_data
+} FlashCache;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Computes the size of a cache lines data area.
+ *
+ * @param[in] n         number of cache lines
+ * @param[in] size      line size
+ */
+#define FLASHC_BUFFER_SIZE(n, size) ((size_t)(n) * (size_t)(size))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void flashcObjectInit(FlashCache *fcp);
+  void flashcStart(FlashCache *fcp, const FlashCacheConfig *config);
+  void flashcStop(FlashCache *fcp);
+  void flashcInvalidate(FlashCache *fcp, flash_offset_t offset, size_t n);
+  flash_error_t flashcRead(FlashCache *fcp, flash_offset_t offset,
+                           size_t n, uint8_t *rp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_FLASH_CACHE_H */
+
+/** @} */
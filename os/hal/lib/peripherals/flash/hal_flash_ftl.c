@@ -0,0 +1,1082 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_flash_ftl.c
+ * @brief   Flash translation layer code.
+ * @details The flash sectors are divided in block sized pages, each sector
+ *          starts with an header holding its erase count followed by a
+ *          table of tags, one for each page. A block write programs the
+ *          data in the next free page of the active sector then its tag,
+ *          the tag records the logical block number and a sequence number
+ *          identifying the most recent copy, a write interrupted before
+ *          the tag is programmed leaves the previous copy in place.<br>
+ *          The blocks map is rebuilt in RAM when connecting by scanning
+ *          the tags tables.<br>
+ *          Wear leveling is dynamic, new sectors are taken from the free
+ *          sectors with the lowest erase count. The garbage collection
+ *          reclaims the sector with the most obsolete pages copying its
+ *          valid pages into the active sector then erasing it, it is
+ *          performed in steps by a background thread calling
+ *          @p ftlServeGarbageCollection() when the free sectors fall to
+ *          the configured threshold, writers only collect when there is
+ *          no other way to get a free page.
+ *
+ * @addtogroup HAL_FLASH_FTL
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "hal_flash_ftl.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Sector header magic number.
+ */
+#define FTL_MAGIC                   0x314C5446U
+
+/**
+ * @brief   Tag check value.
+ */
+#define FTL_TAG_CHECK               0x5AA5C33CU
+
+/**
+ * @brief   Block number marking a page lost to an interrupted write.
+ */
+#define FTL_DEAD_BLOCK              0xFFFFFFFEU
+
+/**
+ * @brief   Sector state of sectors to be formatted, only used while
+ *          mounting.
+ */
+#define FTL_SECTOR_UNFORMATTED      3U
+
+/**
+ * @brief   Sector header.
+ */
+typedef struct {
+  uint32_t                  magic;
+  uint32_t                  erase_count;
+  uint32_t                  blk_size;
+  uint32_t                  pages;
+} ftl_header_t;
+
+/**
+ * @brief   Page tag.
+ */
+typedef struct {
+  uint32_t                  blk;
+  uint32_t                  seq;
+  uint32_t                  check;
+  uint32_t                  reserved;
+} ftl_tag_t;
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static bool ftl_is_inserted(void *instance);
+static bool ftl_is_protected(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct FlashFTLVMT vmt = {
+  ftl_is_inserted,
+  ftl_is_protected,
+  (bool (*)(void *))ftlConnect,
+  (bool (*)(void *))ftlDisconnect,
+  (bool (*)(void *, uint32_t, uint8_t *, uint32_t))ftlRead,
+  (bool (*)(void *, uint32_t, const uint8_t *, uint32_t))ftlWrite,
+  (bool (*)(void *))ftlSync,
+  (bool (*)(void *, BlockDeviceInfo *))ftlGetInfo
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static bool ftl_is_inserted(void *instance) {
+
+  (void)instance;
+
+  return true;
+}
+
+static bool ftl_is_protected(void *instance) {
+
+  (void)instance;
+
+  return false;
+}
+
+/**
+ * @brief   Checks if a memory area is in the erased state.
+ *
+ * @param[in] p         pointer to the memory area
+ * @param[in] n         size of the memory area
+ * @return              The area is erased.
+ *
+ * @notapi
+ */
+static bool ftl_is_erased(const uint8_t *p, size_t n) {
+
+  while (n > 0U) {
+    if (*p++ != (uint8_t)0xFF) {
+      return false;
+    }
+    n--;
+  }
+  return true;
+}
+
+/**
+ * @brief   Checks if a tag is valid.
+ *
+ * @param[in] tp        pointer to the tag
+ * @return              The tag is valid.
+ *
+ * @notapi
+ */
+static bool ftl_tag_is_valid(const ftl_tag_t *tp) {
+
+  return tp->check == (tp->blk ^ tp->seq ^ FTL_TAG_CHECK);
+}
+
+/**
+ * @brief   Returns the offset of a page tag.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] page      page number
+ * @return              The tag offset.
+ *
+ * @notapi
+ */
+static flash_offset_t ftl_tag_offset(FlashFTL *ftlp, uint32_t page) {
+
+  return flashGetSectorOffset(ftlp->config->flashp, page / ftlp->pages) +
+         FTL_HEADER_SIZE + ((page % ftlp->pages) * FTL_TAG_SIZE);
+}
+
+/**
+ * @brief   Returns the offset of a page data.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] page      page number
+ * @return              The data offset.
+ *
+ * @notapi
+ */
+static flash_offset_t ftl_data_offset(FlashFTL *ftlp, uint32_t page) {
+
+  return flashGetSectorOffset(ftlp->config->flashp, page / ftlp->pages) +
+         ftlp->data_offset + ((page % ftlp->pages) * ftlp->config->blk_size);
+}
+
+/**
+ * @brief   Reads a page tag.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] page      page number
+ * @param[out] tp       pointer to the tag
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_read_tag(FlashFTL *ftlp, uint32_t page,
+                                  ftl_tag_t *tp) {
+
+  return flashRead(ftlp->config->flashp, ftl_tag_offset(ftlp, page),
+                   sizeof (ftl_tag_t), (uint8_t *)tp);
+}
+
+/**
+ * @brief   Programs a page tag.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] page      page number
+ * @param[in] blk       block number
+ * @param[in] seq       sequence number
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_write_tag(FlashFTL *ftlp, uint32_t page,
+                                   uint32_t blk, uint32_t seq) {
+  ftl_tag_t tag;
+
+  tag.blk      = blk;
+  tag.seq      = seq;
+  tag.check    = blk ^ seq ^ FTL_TAG_CHECK;
+  tag.reserved = 0xFFFFFFFFU;
+
+  return flashProgram(ftlp->config->flashp, ftl_tag_offset(ftlp, page),
+                      sizeof (ftl_tag_t), (const uint8_t *)&tag);
+}
+
+/**
+ * @brief   Erases a sector and writes its header.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] sector    sector number
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_erase(FlashFTL *ftlp, flash_sector_t sector) {
+  ftl_sector_t *sp = &ftlp->config->sectors[sector];
+  ftl_header_t header;
+  flash_error_t err;
+
+  err = flashStartEraseSector(ftlp->config->flashp, sector);
+  if (err == FLASH_NO_ERROR) {
+    err = flashWaitErase(ftlp->config->flashp);
+  }
+  if (err != FLASH_NO_ERROR) {
+    return err;
+  }
+  ftlp->erases++;
+
+  sp->erase_count++;
+  sp->valid = 0U;
+  sp->used  = 0U;
+  sp->state = FTL_SECTOR_FREE;
+  ftlp->free_sectors++;
+
+  header.magic       = FTL_MAGIC;
+  header.erase_count = sp->erase_count;
+  header.blk_size    = ftlp->config->blk_size;
+  header.pages       = ftlp->pages;
+
+  return flashProgram(ftlp->config->flashp,
+                      flashGetSectorOffset(ftlp->config->flashp, sector),
+                      sizeof (ftl_header_t), (const uint8_t *)&header);
+}
+
+/**
+ * @brief   Makes sure the active sector has a free page.
+ * @details A new active sector is taken from the free sectors with the
+ *          lowest erase count.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] reserve   number of free sectors that cannot be taken
+ * @return              The operation status.
+ * @retval false        if there is a free page.
+ * @retval true         if the free sectors are exhausted.
+ *
+ * @notapi
+ */
+static bool ftl_alloc(FlashFTL *ftlp, uint32_t reserve) {
+  flash_sector_t sector, best;
+  ftl_sector_t *sectors = ftlp->config->sectors;
+
+  if (ftlp->active != FTL_NO_SECTOR) {
+    return false;
+  }
+
+  if (ftlp->free_sectors <= reserve) {
+    return true;
+  }
+
+  best = FTL_NO_SECTOR;
+  for (sector = 0U; sector < ftlp->sectors_count; sector++) {
+    if ((sectors[sector].state == FTL_SECTOR_FREE) &&
+        ((best == FTL_NO_SECTOR) ||
+         (sectors[sector].erase_count < sectors[best].erase_count))) {
+      best = sector;
+    }
+  }
+  osalDbgAssert(best != FTL_NO_SECTOR, "free sectors count mismatch");
+
+  sectors[best].state = FTL_SECTOR_ACTIVE;
+  ftlp->active = best;
+  ftlp->free_sectors--;
+
+  /* Waking up the garbage collection if the free sectors are getting
+     low.*/
+  if (ftlp->free_sectors <= ftlp->config->gc_threshold) {
+    osalSysLock();
+    ftlp->gc_request = true;
+    osalThreadDequeueNextI(&ftlp->gc_queue, MSG_OK);
+    osalSysUnlock();
+  }
+
+  return false;
+}
+
+/**
+ * @brief   Writes a block in the next free page of the active sector.
+ * @pre     The active sector must have a free page.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] blk       block number
+ * @param[in] bp        pointer to the block data
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_write_page(FlashFTL *ftlp, uint32_t blk,
+                                    const uint8_t *bp) {
+  ftl_sector_t *sectors = ftlp->config->sectors;
+  ftl_sector_t *sp = &sectors[ftlp->active];
+  uint32_t page, old;
+  flash_error_t err;
+
+  page = (ftlp->active * ftlp->pages) + (uint32_t)sp->used;
+
+  /* The page is consumed even if the operation fails.*/
+  sp->used++;
+  if ((uint32_t)sp->used >= ftlp->pages) {
+    sp->state = FTL_SECTOR_FULL;
+    ftlp->active = FTL_NO_SECTOR;
+  }
+
+  /* Data first, the tag commits the write.*/
+  err = flashProgram(ftlp->config->flashp, ftl_data_offset(ftlp, page),
+                     ftlp->config->blk_size, bp);
+  if (err == FLASH_NO_ERROR) {
+    err = ftl_write_tag(ftlp, page, blk, ftlp->seq);
+  }
+  if (err != FLASH_NO_ERROR) {
+    return err;
+  }
+  ftlp->seq++;
+  ftlp->page_writes++;
+
+  old = ftlp->config->map[blk];
+  if (old != FTL_NO_PAGE) {
+    sectors[old / ftlp->pages].valid--;
+  }
+  ftlp->config->map[blk] = page;
+  sp->valid++;
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Selects the sector to be collected.
+ * @details The sector with the most reclaimable pages is selected, the
+ *          least erased one among equals.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @return              The operation status.
+ * @retval false        if a sector has been selected.
+ * @retval true         if there is nothing to reclaim.
+ *
+ * @notapi
+ */
+static bool ftl_gc_select(FlashFTL *ftlp) {
+  ftl_sector_t *sectors = ftlp->config->sectors;
+  flash_sector_t sector, best;
+  uint32_t valid;
+
+  best  = FTL_NO_SECTOR;
+  valid = ftlp->pages;
+  for (sector = 0U; sector < ftlp->sectors_count; sector++) {
+    if ((sectors[sector].state == FTL_SECTOR_FULL) &&
+        (((uint32_t)sectors[sector].valid < valid) ||
+         (((uint32_t)sectors[sector].valid == valid) &&
+          (best != FTL_NO_SECTOR) &&
+          (sectors[sector].erase_count < sectors[best].erase_count)))) {
+      best  = sector;
+      valid = (uint32_t)sectors[sector].valid;
+    }
+  }
+
+  ftlp->gc_victim = best;
+  ftlp->gc_page   = 0U;
+
+  return best == FTL_NO_SECTOR;
+}
+
+/**
+ * @brief   Performs a garbage collection step.
+ * @details A step copies one valid page or, when no valid pages are left,
+ *          erases the sector being collected.
+ * @pre     A sector must have been selected.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_gc_step(FlashFTL *ftlp) {
+  flash_sector_t sector = ftlp->gc_victim;
+  ftl_sector_t *sp = &ftlp->config->sectors[sector];
+  flash_error_t err;
+  ftl_tag_t tag;
+
+  while ((sp->valid > 0U) && (ftlp->gc_page < (uint32_t)sp->used)) {
+    uint32_t page = (sector * ftlp->pages) + ftlp->gc_page;
+
+    ftlp->gc_page++;
+
+    err = ftl_read_tag(ftlp, page, &tag);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+
+    /* Copying the page if it is still the current copy of its block.*/
+    if (ftl_tag_is_valid(&tag) && (tag.blk < ftlp->config->blk_num) &&
+        (ftlp->config->map[tag.blk] == page)) {
+      err = flashRead(ftlp->config->flashp, ftl_data_offset(ftlp, page),
+                      ftlp->config->blk_size, ftlp->config->buffer);
+      if (err != FLASH_NO_ERROR) {
+        return err;
+      }
+      if (ftl_alloc(ftlp, 0U)) {
+        return FLASH_ERROR_PROGRAM;
+      }
+      ftlp->gc_copies++;
+      return ftl_write_page(ftlp, tag.blk, ftlp->config->buffer);
+    }
+  }
+
+  /* Nothing left to copy, reclaiming the sector.*/
+  ftlp->gc_victim = FTL_NO_SECTOR;
+  return ftl_erase(ftlp, sector);
+}
+
+/**
+ * @brief   Makes sure a client write can be performed.
+ * @details The garbage collection is performed in place of the background
+ *          thread if the free sectors are exhausted, the last free sector
+ *          is only used as garbage collection destination.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_make_room(FlashFTL *ftlp) {
+  flash_error_t err;
+
+  while (true) {
+    /* A collection using the last free sector must complete before the
+       clients can use the remaining pages.*/
+    if ((ftlp->gc_victim == FTL_NO_SECTOR) || (ftlp->free_sectors > 0U)) {
+      if (!ftl_alloc(ftlp, 1U)) {
+        return FLASH_NO_ERROR;
+      }
+      if ((ftlp->gc_victim == FTL_NO_SECTOR) && ftl_gc_select(ftlp)) {
+        return FLASH_ERROR_PROGRAM;
+      }
+    }
+    err = ftl_gc_step(ftlp);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+  }
+}
+
+/**
+ * @brief   Scans a sector rebuilding its part of the blocks map.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] sector    sector number
+ * @param[out] seqp     highest sequence number found in the sector
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_scan(FlashFTL *ftlp, flash_sector_t sector,
+                              uint32_t *seqp) {
+  ftl_sector_t *sectors = ftlp->config->sectors;
+  uint32_t *map = ftlp->config->map;
+  flash_error_t err;
+  ftl_tag_t tag, old;
+  uint32_t i, page;
+
+  *seqp = 0U;
+  for (i = 0U; i < ftlp->pages; i++) {
+    page = (sector * ftlp->pages) + i;
+    err = ftl_read_tag(ftlp, page, &tag);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if (ftl_is_erased((const uint8_t *)&tag, sizeof (ftl_tag_t))) {
+      break;
+    }
+    if (!ftl_tag_is_valid(&tag)) {
+      continue;
+    }
+    if (tag.seq >= *seqp) {
+      *seqp = tag.seq;
+    }
+    if (tag.seq >= ftlp->seq) {
+      ftlp->seq = tag.seq + 1U;
+    }
+    if (tag.blk >= ftlp->config->blk_num) {
+      continue;
+    }
+
+    /* The copy with the highest sequence number is the current one.*/
+    if (map[tag.blk] != FTL_NO_PAGE) {
+      err = ftl_read_tag(ftlp, map[tag.blk], &old);
+      if (err != FLASH_NO_ERROR) {
+        return err;
+      }
+      if (old.seq > tag.seq) {
+        continue;
+      }
+      sectors[map[tag.blk] / ftlp->pages].valid--;
+    }
+    map[tag.blk] = page;
+    sectors[sector].valid++;
+  }
+  sectors[sector].used = (uint16_t)i;
+
+  /* A write interrupted before its tag could have left the next page
+     partially programmed, such a page is marked as lost.*/
+  if (i < ftlp->pages) {
+    page = (sector * ftlp->pages) + i;
+    err = flashRead(ftlp->config->flashp, ftl_data_offset(ftlp, page),
+                    ftlp->config->blk_size, ftlp->config->buffer);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if (!ftl_is_erased(ftlp->config->buffer, ftlp->config->blk_size)) {
+      err = ftl_write_tag(ftlp, page, FTL_DEAD_BLOCK, 0U);
+      if (err != FLASH_NO_ERROR) {
+        return err;
+      }
+      sectors[sector].used++;
+    }
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Checks that the free pages of a sector are erased.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] sector    sector number
+ * @param[out] erasedp  the free pages are erased
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_check_erased(FlashFTL *ftlp, flash_sector_t sector,
+                                      bool *erasedp) {
+  flash_error_t err;
+  ftl_tag_t tag;
+  uint32_t page;
+
+  *erasedp = false;
+  for (page = (sector * ftlp->pages) + ftlp->config->sectors[sector].used;
+       page < (sector + 1U) * ftlp->pages;
+       page++) {
+    err = ftl_read_tag(ftlp, page, &tag);
+    if (err == FLASH_NO_ERROR) {
+      err = flashRead(ftlp->config->flashp, ftl_data_offset(ftlp, page),
+                      ftlp->config->blk_size, ftlp->config->buffer);
+    }
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if (!ftl_is_erased((const uint8_t *)&tag, sizeof (ftl_tag_t)) ||
+        !ftl_is_erased(ftlp->config->buffer, ftlp->config->blk_size)) {
+      return FLASH_NO_ERROR;
+    }
+  }
+  *erasedp = true;
+
+  return FLASH_NO_ERROR;
+}
+
+/**
+ * @brief   Mounts the flash content.
+ * @details Sectors not carrying a valid header are erased, free sectors
+ *          not fully erased are erased again.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @return              An error code.
+ *
+ * @notapi
+ */
+static flash_error_t ftl_mount(FlashFTL *ftlp) {
+  ftl_sector_t *sectors = ftlp->config->sectors;
+  BaseFlash *flashp = ftlp->config->flashp;
+  uint32_t i, known, total, seq, last;
+  flash_sector_t sector;
+  ftl_header_t header;
+  flash_error_t err;
+
+  for (i = 0U; i < ftlp->config->blk_num; i++) {
+    ftlp->config->map[i] = FTL_NO_PAGE;
+  }
+  ftlp->free_sectors = 0U;
+  ftlp->active       = FTL_NO_SECTOR;
+  ftlp->seq          = 0U;
+  ftlp->gc_victim    = FTL_NO_SECTOR;
+  ftlp->gc_request   = false;
+  ftlp->gc_error     = FLASH_NO_ERROR;
+
+  /* Scanning the formatted sectors.*/
+  known = 0U;
+  total = 0U;
+  last  = 0U;
+  for (sector = 0U; sector < ftlp->sectors_count; sector++) {
+    ftl_sector_t *sp = &sectors[sector];
+
+    sp->valid = 0U;
+    sp->used  = 0U;
+    err = flashRead(flashp, flashGetSectorOffset(flashp, sector),
+                    sizeof (ftl_header_t), (uint8_t *)&header);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if ((header.magic != FTL_MAGIC) ||
+        (header.blk_size != ftlp->config->blk_size) ||
+        (header.pages != ftlp->pages)) {
+      sp->state = FTL_SECTOR_UNFORMATTED;
+      continue;
+    }
+
+    sp->erase_count = header.erase_count;
+    known++;
+    total += header.erase_count;
+
+    err = ftl_scan(ftlp, sector, &seq);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if (sp->used == 0U) {
+      bool erased;
+
+      /* An erase interrupted after the header area could have left
+         programmed pages after the first erased tag.*/
+      err = ftl_check_erased(ftlp, sector, &erased);
+      if (err != FLASH_NO_ERROR) {
+        return err;
+      }
+      if (erased) {
+        sp->state = FTL_SECTOR_FREE;
+        ftlp->free_sectors++;
+      }
+      else {
+        err = ftl_erase(ftlp, sector);
+        if (err != FLASH_NO_ERROR) {
+          return err;
+        }
+      }
+    }
+    else {
+      sp->state = FTL_SECTOR_FULL;
+
+      /* Writing continues in the last written sector.*/
+      if (((uint32_t)sp->used < ftlp->pages) &&
+          ((ftlp->active == FTL_NO_SECTOR) || (seq >= last))) {
+        ftlp->active = sector;
+        last = seq;
+      }
+    }
+  }
+  if (ftlp->active != FTL_NO_SECTOR) {
+    bool erased;
+
+    /* The free area of a sector whose erase has been interrupted could
+       be not fully erased.*/
+    err = ftl_check_erased(ftlp, ftlp->active, &erased);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+    if (erased) {
+      sectors[ftlp->active].state = FTL_SECTOR_ACTIVE;
+    }
+    else {
+      ftlp->active = FTL_NO_SECTOR;
+    }
+  }
+
+  /* Formatting the other sectors, the erase counts lost with the header
+     are replaced by the average.*/
+  for (sector = 0U; sector < ftlp->sectors_count; sector++) {
+    ftl_sector_t *sp = &sectors[sector];
+
+    if (sp->state != FTL_SECTOR_UNFORMATTED) {
+      continue;
+    }
+    sp->erase_count = (known > 0U) ? (total / known) : 0U;
+    err = ftl_erase(ftlp, sector);
+    if (err != FLASH_NO_ERROR) {
+      return err;
+    }
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Flash translation layer object initialization.
+ *
+ * @param[out] ftlp     pointer to the @p FlashFTL object
+ *
+ * @init
+ */
+void ftlObjectInit(FlashFTL *ftlp) {
+
+  ftlp->vmt         = &vmt;
+  ftlp->state       = BLK_STOP;
+  ftlp->config      = NULL;
+  ftlp->gc_victim   = FTL_NO_SECTOR;
+  ftlp->gc_request  = false;
+  ftlp->gc_error    = FLASH_NO_ERROR;
+  ftlp->host_writes = 0U;
+  ftlp->page_writes = 0U;
+  ftlp->gc_copies   = 0U;
+  ftlp->erases      = 0U;
+  osalThreadQueueObjectInit(&ftlp->gc_queue);
+  osalMutexObjectInit(&ftlp->mutex);
+}
+
+/**
+ * @brief   Configures and activates the flash translation layer.
+ * @pre     The flash device must have been started.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] config    pointer to the @p FlashFTLConfig object
+ *
+ * @api
+ */
+void ftlStart(FlashFTL *ftlp, const FlashFTLConfig *config) {
+  const flash_descriptor_t *descriptor;
+
+  osalDbgCheck((ftlp != NULL) && (config != NULL) &&
+               (config->flashp != NULL) && (config->blk_size > 0U) &&
+               (config->map != NULL) && (config->sectors != NULL) &&
+               (config->buffer != NULL));
+  osalDbgAssert((ftlp->state == BLK_STOP) || (ftlp->state == BLK_ACTIVE),
+                "invalid state");
+
+  descriptor = flashGetDescriptor(config->flashp);
+  osalDbgAssert(descriptor->sectors == NULL, "uniform sectors required");
+
+  ftlp->config        = config;
+  ftlp->sectors_count = descriptor->sectors_count;
+  ftlp->sectors_size  = descriptor->sectors_size;
+  ftlp->pages         = FTL_SECTOR_PAGES(descriptor->sectors_size,
+                                         config->blk_size);
+  ftlp->data_offset   = FTL_HEADER_SIZE + (ftlp->pages * FTL_TAG_SIZE);
+  ftlp->state         = BLK_ACTIVE;
+
+  osalDbgAssert((ftlp->pages > 0U) && (ftlp->pages <= 0xFFFFU),
+                "invalid block size");
+  osalDbgAssert(config->blk_num <=
+                (ftlp->sectors_count - FTL_MIN_SPARE_SECTORS) * ftlp->pages,
+                "too many blocks");
+}
+
+/**
+ * @brief   Deactivates the flash translation layer.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ *
+ * @api
+ */
+void ftlStop(FlashFTL *ftlp) {
+
+  osalDbgCheck(ftlp != NULL);
+  osalDbgAssert((ftlp->state == BLK_STOP) || (ftlp->state == BLK_ACTIVE),
+                "invalid state");
+
+  ftlp->config = NULL;
+  ftlp->state  = BLK_STOP;
+}
+
+/**
+ * @brief   Connects the flash translation layer.
+ * @details The blocks map is rebuilt from the flash content, a device
+ *          without a valid format is formatted.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool ftlConnect(FlashFTL *ftlp) {
+  flash_error_t err;
+
+  osalDbgCheck(ftlp != NULL);
+  osalDbgAssert((ftlp->state == BLK_ACTIVE) || (ftlp->state == BLK_READY),
+                "invalid state");
+
+  if (ftlp->state == BLK_READY) {
+    return HAL_SUCCESS;
+  }
+
+  osalMutexLock(&ftlp->mutex);
+  ftlp->state = BLK_CONNECTING;
+  err = ftl_mount(ftlp);
+  if (err != FLASH_NO_ERROR) {
+    ftlp->state = BLK_ACTIVE;
+    osalMutexUnlock(&ftlp->mutex);
+    return HAL_FAILED;
+  }
+  osalSysLock();
+  ftlp->state = BLK_READY;
+  ftlp->gc_request = ftlp->free_sectors <= ftlp->config->gc_threshold;
+  osalThreadDequeueAllI(&ftlp->gc_queue, MSG_OK);
+  osalOsRescheduleS();
+  osalSysUnlock();
+  osalMutexUnlock(&ftlp->mutex);
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Disconnects the flash translation layer.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ *
+ * @api
+ */
+bool ftlDisconnect(FlashFTL *ftlp) {
+
+  osalDbgCheck(ftlp != NULL);
+  osalDbgAssert((ftlp->state == BLK_ACTIVE) || (ftlp->state == BLK_READY),
+                "invalid state");
+
+  osalMutexLock(&ftlp->mutex);
+  ftlp->state = BLK_ACTIVE;
+  osalMutexUnlock(&ftlp->mutex);
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ * @note    Blocks never written read as erased flash.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] startblk  first block to read
+ * @param[out] buffer   pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool ftlRead(FlashFTL *ftlp, uint32_t startblk,
+             uint8_t *buffer, uint32_t n) {
+  uint32_t blk_size, page;
+
+  osalDbgCheck((ftlp != NULL) && (buffer != NULL) && (n > 0U));
+
+  if ((ftlp->state != BLK_READY) ||
+      (startblk >= ftlp->config->blk_num) ||
+      (n > ftlp->config->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  blk_size = ftlp->config->blk_size;
+  osalMutexLock(&ftlp->mutex);
+  while (n > 0U) {
+    page = ftlp->config->map[startblk];
+    if (page == FTL_NO_PAGE) {
+      memset(buffer, 0xFF, blk_size);
+    }
+    else if (flashRead(ftlp->config->flashp, ftl_data_offset(ftlp, page),
+                       blk_size, buffer) != FLASH_NO_ERROR) {
+      osalMutexUnlock(&ftlp->mutex);
+      return HAL_FAILED;
+    }
+    buffer += blk_size;
+    startblk++;
+    n--;
+  }
+  osalMutexUnlock(&ftlp->mutex);
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ * @note    Each block is written atomically, a write interrupted by a
+ *          power loss leaves the previous block content.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[in] startblk  first block to write
+ * @param[in] buffer    pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool ftlWrite(FlashFTL *ftlp, uint32_t startblk,
+              const uint8_t *buffer, uint32_t n) {
+
+  osalDbgCheck((ftlp != NULL) && (buffer != NULL) && (n > 0U));
+
+  if ((ftlp->state != BLK_READY) ||
+      (startblk >= ftlp->config->blk_num) ||
+      (n > ftlp->config->blk_num - startblk)) {
+    return HAL_FAILED;
+  }
+
+  osalMutexLock(&ftlp->mutex);
+  while (n > 0U) {
+    if ((ftl_make_room(ftlp) != FLASH_NO_ERROR) ||
+        (ftl_write_page(ftlp, startblk, buffer) != FLASH_NO_ERROR)) {
+      osalMutexUnlock(&ftlp->mutex);
+      return HAL_FAILED;
+    }
+    ftlp->host_writes++;
+    buffer += ftlp->config->blk_size;
+    startblk++;
+    n--;
+  }
+  osalMutexUnlock(&ftlp->mutex);
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Ensures write synchronization.
+ * @note    Writes are not buffered, there is nothing to synchronize.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool ftlSync(FlashFTL *ftlp) {
+
+  osalDbgCheck(ftlp != NULL);
+
+  if (ftlp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Returns the media info.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @param[out] bdip     pointer to a @p BlockDeviceInfo structure
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  operation succeeded.
+ * @retval HAL_FAILED   operation failed.
+ *
+ * @api
+ */
+bool ftlGetInfo(FlashFTL *ftlp, BlockDeviceInfo *bdip) {
+
+  osalDbgCheck((ftlp != NULL) && (bdip != NULL));
+
+  if (ftlp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+
+  bdip->blk_num  = ftlp->config->blk_num;
+  bdip->blk_size = ftlp->config->blk_size;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Performs a background garbage collection step.
+ * @details Waits until the free sectors fall to the configured threshold
+ *          then performs a collection step, the mutual exclusion is
+ *          released between steps so the clients are delayed at most by
+ *          a page copy or a sector erase.<br>
+ *          A failed step stops the background collection until the next
+ *          connection, the error is returned once and kept in the
+ *          @p gc_error field. The clients still collect when there is no
+ *          other way to get a free page.
+ * @note    This function is meant to be called in a loop by a dedicated
+ *          thread with lower priority than the clients.
+ *
+ * @param[in] ftlp      pointer to the @p FlashFTL object
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if there is no error.
+ * @retval FLASH_ERROR_ERASE if the collection failed erasing a sector.
+ * @retval FLASH_ERROR_PROGRAM if the collection failed copying a page.
+ * @retval FLASH_ERROR_READ if the collection failed reading a page.
+ *
+ * @api
+ */
+flash_error_t ftlServeGarbageCollection(FlashFTL *ftlp) {
+  flash_error_t err = FLASH_NO_ERROR;
+
+  osalDbgCheck(ftlp != NULL);
+
+  osalSysLock();
+  while ((ftlp->state != BLK_READY) ||
+         (ftlp->gc_error != FLASH_NO_ERROR) ||
+         ((ftlp->gc_victim == FTL_NO_SECTOR) && !ftlp->gc_request)) {
+    (void) osalThreadEnqueueTimeoutS(&ftlp->gc_queue, TIME_INFINITE);
+  }
+  osalSysUnlock();
+
+  osalMutexLock(&ftlp->mutex);
+  if (ftlp->state == BLK_READY) {
+    if (ftlp->gc_victim == FTL_NO_SECTOR) {
+      ftlp->gc_request = false;
+      if ((ftlp->free_sectors > ftlp->config->gc_threshold) ||
+          ftl_gc_select(ftlp)) {
+        osalMutexUnlock(&ftlp->mutex);
+        return FLASH_NO_ERROR;
+      }
+    }
+    err = ftl_gc_step(ftlp);
+    if (err != FLASH_NO_ERROR) {
+      /* Retrying would fail again on a failed device.*/
+      ftlp->gc_request = false;
+      ftlp->gc_error   = err;
+    }
+    else if ((ftlp->gc_victim == FTL_NO_SECTOR) &&
+             (ftlp->free_sectors <= ftlp->config->gc_threshold)) {
+      /* Continuing until the free sectors are above the threshold.*/
+      ftlp->gc_request = true;
+    }
+  }
+  osalMutexUnlock(&ftlp->mutex);
+
+  return err;
+}
+
+/** @} */
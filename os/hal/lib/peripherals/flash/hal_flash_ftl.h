@@ -0,0 +1,249 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_flash_ftl.h
+ * @brief   Flash translation layer structures and macros.
+ *
+ * @addtogroup HAL_FLASH_FTL
+ * @{
+ */
+
+#ifndef HAL_FLASH_FTL_H
+#define HAL_FLASH_FTL_H
+
+#include "hal_flash.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Page number marking an unmapped block.
+ */
+#define FTL_NO_PAGE                 0xFFFFFFFFU
+
+/**
+ * @brief   Sector number marking no sector.
+ */
+#define FTL_NO_SECTOR               0xFFFFFFFFU
+
+/**
+ * @brief   Size of the sector header.
+ */
+#define FTL_HEADER_SIZE             16U
+
+/**
+ * @brief   Size of a page tag.
+ */
+#define FTL_TAG_SIZE                16U
+
+/**
+ * @brief   Minimum number of sectors not holding logical blocks.
+ * @details One sector is being written and one is kept erased as garbage
+ *          collection destination.
+ */
+#define FTL_MIN_SPARE_SECTORS       2U
+
+/**
+ * @name    Sector states
+ * @{
+ */
+#define FTL_SECTOR_FREE             0U
+#define FTL_SECTOR_ACTIVE           1U
+#define FTL_SECTOR_FULL             2U
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Sector descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Sector erase count.
+   */
+  uint32_t                  erase_count;
+  /**
+   * @brief   Number of pages holding the current copy of a block.
+   */
+  uint16_t                  valid;
+  /**
+   * @brief   Number of written pages.
+   */
+  uint16_t                  used;
+  /**
+   * @brief   Sector state.
+   */
+  uint8_t                   state;
+} ftl_sector_t;
+
+/**
+ * @brief   Flash translation layer configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Underlying flash device, uniform sectors are required.
+   */
+  BaseFlash                 *flashp;
+  /**
+   * @brief   Block size, a multiple of the device program granularity.
+   */
+  uint32_t                  blk_size;
+  /**
+   * @brief   Number of logical blocks.
+   * @note    At most @p FTL_MIN_SPARE_SECTORS less than the sectors
+   *          number times @p FTL_SECTOR_PAGES(), a larger spare area
+   *          lowers the garbage collection costs.
+   */
+  uint32_t                  blk_num;
+  /**
+   * @brief   Number of free sectors starting the background garbage
+   *          collection.
+   */
+  uint32_t                  gc_threshold;
+  /**
+   * @brief   Blocks map, @p blk_num elements.
+   */
+  uint32_t                  *map;
+  /**
+   * @brief   Array of sector descriptors, one for each device sector.
+   */
+  ftl_sector_t              *sectors;
+  /**
+   * @brief   Copy buffer, one block.
+   */
+  uint8_t                   *buffer;
+} FlashFTLConfig;
+
+/**
+ * @brief   @p FlashFTL specific methods.
+ */
+#define _flash_ftl_methods                                                  \
+  _base_block_device_methods
+
+/**
+ * @brief   @p FlashFTL specific data.
+ */
+#define _flash_ftl_data                                                     \
+  _base_block_device_data                                                   \
+  /* Current configuration data.*/                                          \
+  const FlashFTLConfig      *config;                                        \
+  /* Number of device sectors.*/                                            \
+  flash_sector_t            sectors_count;                                  \
+  /* Size of device sectors.*/                                              \
+  uint32_t                  sectors_size;                                   \
+  /* Pages in a sector.*/                                                   \
+  uint32_t                  pages;                                          \
+  /* Offset of the data area within a sector.*/                             \
+  uint32_t                  data_offset;                                    \
+  /* Number of free sectors.*/                                              \
+  uint32_t                  free_sectors;                                   \
+  /* Sector being written or @p FTL_NO_SECTOR.*/                            \
+  flash_sector_t            active;                                         \
+  /* Next write sequence number.*/                                          \
+  uint32_t                  seq;                                            \
+  /* Sector being collected or @p FTL_NO_SECTOR.*/                          \
+  flash_sector_t            gc_victim;                                      \
+  /* Next page to be examined in the sector being collected.*/              \
+  uint32_t                  gc_page;                                        \
+  /* Background garbage collection requested.*/                             \
+  bool                      gc_request;                                     \
+  /* Error stopping the background garbage collection.*/                    \
+  flash_error_t             gc_error;                                       \
+  /* Garbage collection thread waiting for work.*/                          \
+  threads_queue_t           gc_queue;                                       \
+  /* Mutual exclusion between the clients and the garbage collection.*/     \
+  mutex_t                   mutex;                                          \
+  /* Blocks written by the clients.*/                                       \
+  uint32_t                  host_writes;                                    \
+  /* Pages programmed, including the garbage collection copies.*/           \
+  uint32_t                  page_writes;                                    \
+  /* Pages copied by the garbage collection.*/                              \
+  uint32_t                  gc_copies;                                      \
+  /* Sectors erased.*/                                                      \
+  uint32_t                  erases;
+
+/**
+ * @brief   @p FlashFTL virtual methods table.
+ */
+struct FlashFTLVMT {
+  _flash_ftl_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   Flash translation layer object.
+ * @details A block device storing its blocks in a flash device, each
+ *          write goes to a new page and the sectors holding obsolete
+ *          copies are reclaimed by the garbage collection.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct FlashFTLVMT *vmt;
+  _flash_ftl_data
+} FlashFTL;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Computes the number of pages in a sector.
+ *
+ * @param[in] ssize     sector size
+ * @param[in] bsize     block size
+ */
+#define FTL_SECTOR_PAGES(ssize, bsize)                                      \
+  (((ssize) - FTL_HEADER_SIZE) / ((bsize) + FTL_TAG_SIZE))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void ftlObjectInit(FlashFTL *ftlp);
+  void ftlStart(FlashFTL *ftlp, const FlashFTLConfig *config);
+  void ftlStop(FlashFTL *ftlp);
+  bool ftlConnect(FlashFTL *ftlp);
+  bool ftlDisconnect(FlashFTL *ftlp);
+  bool ftlRead(FlashFTL *ftlp, uint32_t startblk,
+               uint8_t *buffer, uint32_t n);
+  bool ftlWrite(FlashFTL *ftlp, uint32_t startblk,
+                const uint8_t *buffer, uint32_t n);
+  bool ftlSync(FlashFTL *ftlp);
+  bool ftlGetInfo(FlashFTL *ftlp, BlockDeviceInfo *bdip);
+  flash_error_t ftlServeGarbageCollection(FlashFTL *ftlp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_FLASH_FTL_H */
+
+/** @} */
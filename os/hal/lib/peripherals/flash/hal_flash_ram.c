@@ -0,0 +1,445 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_flash_ram.c
+ * @brief   RAM flash device code.
+ * @details A @p BaseFlash implementation over a memory area, it follows
+ *          the NOR flash rules, programming can only clear bits and only
+ *          an erase sets them back. It is useful as reference device when
+ *          testing flash clients, the per sector erase counters allow to
+ *          evaluate their wear.<br>
+ *          A power loss can be simulated by injecting a failure, the
+ *          interrupted program or erase operation only affects a part of
+ *          its area and the device stops responding until it is
+ *          restarted. The affected part is the first half of the area
+ *          or, if a tear seed has been set, a pseudo-random sub-area.
+ *
+ * @addtogroup HAL_FLASH_RAM
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "hal_flash_ram.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static const flash_descriptor_t *rf_get_descriptor(void *instance);
+static flash_error_t rf_read(void *instance, flash_offset_t offset,
+                             size_t n, uint8_t *rp);
+static flash_error_t rf_program(void *instance, flash_offset_t offset,
+                                size_t n, const uint8_t *pp);
+static flash_error_t rf_start_erase_all(void *instance);
+static flash_error_t rf_start_erase_sector(void *instance,
+                                           flash_sector_t sector);
+static flash_error_t rf_query_erase(void *instance, uint32_t *msec);
+static flash_error_t rf_verify_erase(void *instance, flash_sector_t sector);
+static flash_error_t rf_suspend_erase(void *instance);
+static flash_error_t rf_resume_erase(void *instance);
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct RamFlashVMT vmt = {
+  rf_get_descriptor,
+  rf_read,
+  rf_program,
+  rf_start_erase_all,
+  rf_start_erase_sector,
+  rf_query_erase,
+  rf_verify_erase,
+  rf_suspend_erase,
+  rf_resume_erase
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Counts a program or erase operation for the fault injection.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @return              The operation has to be interrupted.
+ *
+ * @notapi
+ */
+static bool rf_fault(RamFlash *rfp) {
+
+  if (rfp->fault_countdown > 0U) {
+    rfp->fault_countdown--;
+    if (rfp->fault_countdown == 0U) {
+      rfp->failed = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief   Selects the part of an interrupted operation area.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in,out] np    area size, replaced by the affected part size
+ * @return              Offset of the affected part within the area.
+ *
+ * @notapi
+ */
+static size_t rf_tear(RamFlash *rfp, size_t *np) {
+  size_t start;
+
+  if (rfp->tear_seed == 0U) {
+    *np = *np / 2U;
+    return 0U;
+  }
+
+  /* Xorshift sequence, it never reaches zero.*/
+  rfp->tear_seed ^= rfp->tear_seed << 13;
+  rfp->tear_seed ^= rfp->tear_seed >> 17;
+  rfp->tear_seed ^= rfp->tear_seed << 5;
+  start = (size_t)rfp->tear_seed % *np;
+  rfp->tear_seed ^= rfp->tear_seed << 13;
+  rfp->tear_seed ^= rfp->tear_seed >> 17;
+  rfp->tear_seed ^= rfp->tear_seed << 5;
+  *np = (size_t)rfp->tear_seed % ((*np - start) + 1U);
+
+  return start;
+}
+
+/**
+ * @brief   Checks that an area is within the device.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] offset    flash offset
+ * @param[in] n         area size
+ * @return              The area is within the device.
+ *
+ * @notapi
+ */
+static bool rf_in_device(RamFlash *rfp, flash_offset_t offset, size_t n) {
+  size_t size = (size_t)rfp->config->sectors_count *
+                (size_t)rfp->config->sectors_size;
+
+  return ((size_t)offset <= size) && (n <= size - (size_t)offset);
+}
+
+static const flash_descriptor_t *rf_get_descriptor(void *instance) {
+
+  return &((RamFlash *)instance)->descriptor;
+}
+
+static flash_error_t rf_read(void *instance, flash_offset_t offset,
+                             size_t n, uint8_t *rp) {
+  RamFlash *rfp = (RamFlash *)instance;
+
+  osalDbgCheck((instance != NULL) && (rp != NULL) && (n > 0U));
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  if (rfp->failed || !rf_in_device(rfp, offset, n)) {
+    return FLASH_ERROR_READ;
+  }
+
+  memcpy(rp, rfp->config->storage + offset, n);
+  rfp->reads++;
+
+  return FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_program(void *instance, flash_offset_t offset,
+                                size_t n, const uint8_t *pp) {
+  RamFlash *rfp = (RamFlash *)instance;
+  uint8_t *p;
+
+  osalDbgCheck((instance != NULL) && (pp != NULL) && (n > 0U));
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  if (rfp->failed || !rf_in_device(rfp, offset, n)) {
+    return FLASH_ERROR_PROGRAM;
+  }
+
+  if (rf_fault(rfp)) {
+    size_t start = rf_tear(rfp, &n);
+
+    offset += (flash_offset_t)start;
+    pp     += start;
+  }
+
+  /* Programming can only clear bits.*/
+  p = rfp->config->storage + offset;
+  rfp->programs++;
+  rfp->programmed += (uint32_t)n;
+  while (n > 0U) {
+    *p++ &= *pp++;
+    n--;
+  }
+
+  return rfp->failed ? FLASH_ERROR_PROGRAM : FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_start_erase_all(void *instance) {
+  RamFlash *rfp = (RamFlash *)instance;
+  flash_sector_t sector;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  for (sector = 0U; sector < rfp->config->sectors_count; sector++) {
+    (void) rf_start_erase_sector(instance, sector);
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_start_erase_sector(void *instance,
+                                           flash_sector_t sector) {
+  RamFlash *rfp = (RamFlash *)instance;
+  size_t start, n;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  if (rfp->failed || (sector >= rfp->config->sectors_count)) {
+    return FLASH_ERROR_ERASE;
+  }
+
+  start = 0U;
+  n     = (size_t)rfp->config->sectors_size;
+  if (rf_fault(rfp)) {
+    start = rf_tear(rfp, &n);
+  }
+
+  memset(rfp->config->storage +
+         ((size_t)sector * (size_t)rfp->config->sectors_size) + start,
+         0xFF, n);
+  if (rfp->config->erase_counts != NULL) {
+    rfp->config->erase_counts[sector]++;
+  }
+  rfp->erases++;
+
+  return rfp->failed ? FLASH_ERROR_ERASE : FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_query_erase(void *instance, uint32_t *msec) {
+
+  (void)instance;
+
+  /* Erase operations complete immediately.*/
+  if (msec != NULL) {
+    *msec = 0U;
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_verify_erase(void *instance, flash_sector_t sector) {
+  RamFlash *rfp = (RamFlash *)instance;
+  const uint8_t *p, *end;
+
+  osalDbgCheck(instance != NULL);
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  if (rfp->failed || (sector >= rfp->config->sectors_count)) {
+    return FLASH_ERROR_VERIFY;
+  }
+
+  p   = rfp->config->storage +
+        ((size_t)sector * (size_t)rfp->config->sectors_size);
+  end = p + rfp->config->sectors_size;
+  while (p < end) {
+    if (*p++ != (uint8_t)0xFF) {
+      return FLASH_ERROR_VERIFY;
+    }
+  }
+
+  return FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_suspend_erase(void *instance) {
+
+  (void)instance;
+
+  return FLASH_NO_ERROR;
+}
+
+static flash_error_t rf_resume_erase(void *instance) {
+
+  (void)instance;
+
+  return FLASH_NO_ERROR;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM flash object initialization.
+ *
+ * @param[out] rfp      pointer to the @p RamFlash object
+ *
+ * @init
+ */
+void rflashObjectInit(RamFlash *rfp) {
+
+  rfp->vmt             = &vmt;
+  rfp->state           = FLASH_STOP;
+  rfp->config          = NULL;
+  rfp->reads           = 0U;
+  rfp->programs        = 0U;
+  rfp->programmed      = 0U;
+  rfp->erases          = 0U;
+  rfp->fault_countdown = 0U;
+  rfp->tear_seed       = 0U;
+  rfp->failed          = false;
+}
+
+/**
+ * @brief   Configures and activates the RAM flash.
+ * @note    The storage content is preserved, a new storage area must be
+ *          erased before use.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] config    pointer to the @p RamFlashConfig object
+ *
+ * @api
+ */
+void rflashStart(RamFlash *rfp, const RamFlashConfig *config) {
+
+  osalDbgCheck((rfp != NULL) && (config != NULL) &&
+               (config->storage != NULL) && (config->page_size > 0U) &&
+               (config->sectors_count > 0U) && (config->sectors_size > 0U));
+  osalDbgAssert((rfp->state == FLASH_STOP) || (rfp->state == FLASH_READY),
+                "invalid state");
+
+  rfp->config                   = config;
+  rfp->descriptor.attributes    = FLASH_ATTR_ERASED_IS_ONE |
+                                  FLASH_ATTR_REWRITABLE;
+  rfp->descriptor.page_size     = config->page_size;
+  rfp->descriptor.sectors_count = config->sectors_count;
+  rfp->descriptor.sectors       = NULL;
+  rfp->descriptor.sectors_size  = config->sectors_size;
+  rfp->descriptor.address       = 0U;
+  rfp->fault_countdown          = 0U;
+  rfp->failed                   = false;
+  rfp->state                    = FLASH_READY;
+}
+
+/**
+ * @brief   Deactivates the RAM flash.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ *
+ * @api
+ */
+void rflashStop(RamFlash *rfp) {
+
+  osalDbgCheck(rfp != NULL);
+  osalDbgAssert((rfp->state == FLASH_STOP) || (rfp->state == FLASH_READY),
+                "invalid state");
+
+  rfp->config = NULL;
+  rfp->state  = FLASH_STOP;
+}
+
+/**
+ * @brief   Injects a failure simulating a power loss.
+ * @details The specified program or erase operation is interrupted after
+ *          writing half of its area, after that all operations fail until
+ *          the device is restarted.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] ops       number of the program or erase operation to be
+ *                      interrupted, one is the next operation, zero
+ *                      disables the injection
+ *
+ * @api
+ */
+void rflashInjectFault(RamFlash *rfp, uint32_t ops) {
+
+  osalDbgCheck(rfp != NULL);
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+
+  rfp->fault_countdown = ops;
+}
+
+/**
+ * @brief   Selects the part affected by an interrupted operation.
+ * @details With a zero seed an interrupted operation affects the first
+ *          half of its area, else a pseudo-random sub-area, possibly
+ *          empty, is affected. The sequence is repeatable for a given
+ *          seed and it is kept across device restarts.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] seed      pseudo-random sequence seed or zero
+ *
+ * @api
+ */
+void rflashSetTearSeed(RamFlash *rfp, uint32_t seed) {
+
+  osalDbgCheck(rfp != NULL);
+
+  rfp->tear_seed = seed;
+}
+
+/**
+ * @brief   Returns the sectors erase statistics.
+ * @pre     The configuration must specify the erase counters array.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[out] minp     minimum erase count of a sector
+ * @param[out] maxp     maximum erase count of a sector
+ * @param[out] totalp   total of the erase counts
+ *
+ * @api
+ */
+void rflashGetEraseStats(RamFlash *rfp, uint32_t *minp, uint32_t *maxp,
+                         uint32_t *totalp) {
+  const uint32_t *ecp;
+  flash_sector_t sector;
+
+  osalDbgCheck((rfp != NULL) && (minp != NULL) && (maxp != NULL) &&
+               (totalp != NULL));
+  osalDbgAssert(rfp->state == FLASH_READY, "invalid state");
+  osalDbgAssert(rfp->config->erase_counts != NULL, "no erase counters");
+
+  ecp     = rfp->config->erase_counts;
+  *minp   = ecp[0];
+  *maxp   = ecp[0];
+  *totalp = 0U;
+  for (sector = 0U; sector < rfp->config->sectors_count; sector++) {
+    if (ecp[sector] < *minp) {
+      *minp = ecp[sector];
+    }
+    if (ecp[sector] > *maxp) {
+      *maxp = ecp[sector];
+    }
+    *totalp += ecp[sector];
+  }
+}
+
+/** @} */
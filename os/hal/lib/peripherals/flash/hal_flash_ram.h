@@ -0,0 +1,148 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_flash_ram.h
+ * @brief   RAM flash device structures and macros.
+ *
+ * @addtogroup HAL_FLASH_RAM
+ * @{
+ */
+
+#ifndef HAL_FLASH_RAM_H
+#define HAL_FLASH_RAM_H
+
+#include "hal_flash.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM flash configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Device storage, @p sectors_count sectors.
+   */
+  uint8_t                   *storage;
+  /**
+   * @brief   Size of write page.
+   */
+  uint32_t                  page_size;
+  /**
+   * @brief   Number of sectors in the device.
+   */
+  flash_sector_t            sectors_count;
+  /**
+   * @brief   Size of sectors.
+   */
+  uint32_t                  sectors_size;
+  /**
+   * @brief   Array of @p sectors_count erase counters or @p NULL.
+   * @note    The counters are not cleared on start, they keep counting
+   *          across device restarts.
+   */
+  uint32_t                  *erase_counts;
+} RamFlashConfig;
+
+/**
+ * @brief   @p RamFlash specific methods.
+ */
+#define _ram_flash_methods                                                  \
+  _base_flash_methods
+
+/**
+ * @brief   @p RamFlash specific data.
+ */
+#define _ram_flash_data                                                     \
+  _base_flash_data                                                          \
+  /* Current configuration data.*/                                          \
+  const RamFlashConfig      *config;                                        \
+  /* Device descriptor.*/                                                   \
+  flash_descriptor_t        descriptor;                                     \
+  /* Read operations.*/                                                     \
+  uint32_t                  reads;                                          \
+  /* Program operations.*/                                                  \
+  uint32_t                  programs;                                       \
+  /* Programmed bytes.*/                                                    \
+  uint32_t                  programmed;                                     \
+  /* Sector erase operations.*/                                             \
+  uint32_t                  erases;                                         \
+  /* Operations before the injected failure, zero if disabled.*/            \
+  uint32_t                  fault_countdown;                                \
+  /* Interrupted operations area selection, zero for the first half.*/      \
+  uint32_t                  tear_seed;                                      \
+  /* An injected failure happened, the device no more responds.*/           \
+  bool                      failed;
+
+/**
+ * @brief   @p RamFlash virtual methods table.
+ */
+struct RamFlashVMT {
+  _ram_flash_methods
+};
+
+/**
+ * @extends BaseFlash
+ *
+ * @brief   RAM flash object.
+ * @details A flash device over a memory area, programming can only clear
+ *          bits and erase operations complete immediately.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct RamFlashVMT *vmt;
+  _ram_flash_data
+} RamFlash;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void rflashObjectInit(RamFlash *rfp);
+  void rflashStart(RamFlash *rfp, const RamFlashConfig *config);
+  void rflashStop(RamFlash *rfp);
+  void rflashInjectFault(RamFlash *rfp, uint32_t ops);
+  void rflashSetTearSeed(RamFlash *rfp, uint32_t seed);
+  void rflashGetEraseStats(RamFlash *rfp, uint32_t *minp, uint32_t *maxp,
+                           uint32_t *totalp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_FLASH_RAM_H */
+
+/** @} */
@@ -22,6 +22,8 @@
  * @{
  */
 
+#include <string.h>
+
 #include "hal.h"
 
 #include "hal_jesd216_flash.h"
@@ -30,6 +32,38 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+#if (JESD216_USE_STREAMING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @name    Stream bus transactions
+ * @{
+ */
+#define STREAM_PHASE_WREN           0U
+#define STREAM_PHASE_PROGRAM        1U
+#define STREAM_PHASE_POLL           2U
+#define STREAM_PHASE_STATUS         3U
+#define STREAM_PHASE_CLEAR          4U
+/** @} */
+
+/**
+ * @name    Stream bus lines
+ * @{
+ */
+#if (JESD216_BUS_MODE == JESD216_BUS_MODE_QSPI1L) || defined(__DOXYGEN__)
+#define STREAM_CMD_MODE             QSPI_CFG_CMD_MODE_ONE_LINE
+#define STREAM_ADDR_MODE            QSPI_CFG_ADDR_MODE_ONE_LINE
+#define STREAM_DATA_MODE            QSPI_CFG_DATA_MODE_ONE_LINE
+#elif JESD216_BUS_MODE == JESD216_BUS_MODE_QSPI2L
+#define STREAM_CMD_MODE             QSPI_CFG_CMD_MODE_TWO_LINES
+#define STREAM_ADDR_MODE            QSPI_CFG_ADDR_MODE_TWO_LINES
+#define STREAM_DATA_MODE            QSPI_CFG_DATA_MODE_TWO_LINES
+#else
+#define STREAM_CMD_MODE             QSPI_CFG_CMD_MODE_FOUR_LINES
+#define STREAM_ADDR_MODE            QSPI_CFG_ADDR_MODE_FOUR_LINES
+#define STREAM_DATA_MODE            QSPI_CFG_DATA_MODE_FOUR_LINES
+#endif
+/** @} */
+#endif /* JESD216_USE_STREAMING == TRUE */
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -42,6 +76,221 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if (JESD216_USE_STREAMING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Gathers queued data into a page buffer.
+ * @details Data is appended as long as it is contiguous and within the
+ *          same device page, small contiguous requests are so merged into
+ *          a single page program.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] pgp       pointer to the page buffer, it must not be in use
+ *                      on the bus
+ *
+ * @notapi
+ */
+static void stream_prepare(jesd216_stream_t *jsp, jesd216_page_t *pgp) {
+  size_t page_size = jsp->config->page_size;
+
+  while (jsp->prep != NULL) {
+    jesd216_request_t *rqp = jsp->prep;
+    flash_offset_t offset = rqp->offset + (flash_offset_t)jsp->prep_n;
+    size_t room, n;
+
+    if (pgp->n == 0U) {
+      pgp->offset = offset;
+    }
+    else if (offset != pgp->offset + (flash_offset_t)pgp->n) {
+      /* Not contiguous, it will go in another page.*/
+      break;
+    }
+
+    /* Space left before the device page boundary.*/
+    room = page_size - ((size_t)offset & (page_size - 1U));
+    if (room == page_size) {
+      if (pgp->n > 0U) {
+        /* Already at the boundary of a non-empty page.*/
+        break;
+      }
+    }
+
+    n = rqp->n - jsp->prep_n;
+    if (n > room) {
+      n = room;
+    }
+    memcpy(pgp->buf + pgp->n, rqp->buf + jsp->prep_n, n);
+    pgp->n     += n;
+    jsp->prep_n += n;
+    pgp->last   = rqp;
+    pgp->ends   = (bool)(jsp->prep_n >= rqp->n);
+    if (pgp->ends) {
+      jsp->prep   = rqp->next;
+      jsp->prep_n = 0U;
+    }
+    if (n == room) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Starts programming the current page buffer.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ *
+ * @notapi
+ */
+static void stream_start_page(jesd216_stream_t *jsp) {
+
+  jsp->phase    = STREAM_PHASE_WREN;
+  jsp->cmd.cfg  = QSPI_CFG_CMD(JESD216_CMD_WRITE_ENABLE) | STREAM_CMD_MODE;
+  jsp->cmd.addr = 0U;
+  jsp->cmd.alt  = 0U;
+  qspiStartCommandI(jsp->config->busp, &jsp->cmd);
+}
+
+/**
+ * @brief   Completes the requests ending in the current page.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] err       outcome of the page program
+ *
+ * @notapi
+ */
+static void stream_page_done(jesd216_stream_t *jsp, flash_error_t err) {
+  jesd216_page_t *pgp = &jsp->pages[jsp->cur];
+  jesd216_request_t *rqp;
+  eventflags_t flags = 0U;
+
+  jsp->pages_programmed++;
+
+  /* The page data starts in the head request, marking the requests with
+     data in the failed page.*/
+  if (err != FLASH_NO_ERROR) {
+    jsp->err = err;
+    flags |= JESD216_STREAM_ERROR;
+    rqp = jsp->head;
+    while (true) {
+      rqp->err = err;
+      if (rqp == pgp->last) {
+        break;
+      }
+      rqp = rqp->next;
+    }
+  }
+
+  /* Dequeuing and notifying the completed requests, the page buffer is
+     still owned by the engine during the callbacks.*/
+  do {
+    rqp = jsp->head;
+    if ((rqp == pgp->last) && !pgp->ends) {
+      break;
+    }
+    jsp->head = rqp->next;
+    if (jsp->head == NULL) {
+      jsp->tail = NULL;
+    }
+    jsp->requests++;
+    flags |= JESD216_STREAM_COMPLETE;
+    if (rqp->cb != NULL) {
+      rqp->cb(jsp, rqp);
+    }
+  } while (rqp != pgp->last);
+
+  if (flags != 0U) {
+    osalEventBroadcastFlagsI(&jsp->event, flags);
+  }
+
+  /* Switching to the page prepared meanwhile, if any.*/
+  pgp->n   = 0U;
+  jsp->cur ^= 1U;
+  if (jsp->pages[jsp->cur].n == 0U) {
+    stream_prepare(jsp, &jsp->pages[jsp->cur]);
+  }
+  if (jsp->pages[jsp->cur].n > 0U) {
+    stream_start_page(jsp);
+    stream_prepare(jsp, &jsp->pages[jsp->cur ^ 1U]);
+  }
+  else {
+    jsp->state = JESD216_STREAM_READY;
+    osalThreadResumeI(&jsp->thread, MSG_OK);
+  }
+}
+
+/**
+ * @brief   Stream bus callback.
+ * @details Chains the bus transactions of the page programs.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ *
+ * @notapi
+ */
+static void stream_callback(QSPIDriver *qspip) {
+  /* The configuration is the first field of the stream object.*/
+  jesd216_stream_t *jsp = (jesd216_stream_t *)qspip->config;
+  const jesd216_stream_config_t *config = jsp->config;
+  jesd216_page_t *pgp = &jsp->pages[jsp->cur];
+
+  osalSysLockFromISR();
+
+  switch (jsp->phase) {
+  case STREAM_PHASE_WREN:
+    jsp->phase    = STREAM_PHASE_PROGRAM;
+    jsp->cmd.cfg  = QSPI_CFG_CMD(config->program_cmd & 0xFFU) |
+                    STREAM_CMD_MODE | STREAM_ADDR_MODE | STREAM_DATA_MODE;
+    if ((config->program_cmd & JESD216_CMD_EXTENDED_ADDRESSING) == 0U) {
+      jsp->cmd.cfg |= QSPI_CFG_ADDR_SIZE_24;
+    }
+    else {
+      jsp->cmd.cfg |= QSPI_CFG_ADDR_SIZE_32;
+    }
+    jsp->cmd.addr = pgp->offset;
+    qspiStartSendI(qspip, &jsp->cmd, pgp->n, pgp->buf);
+    break;
+  case STREAM_PHASE_PROGRAM:
+    /* The device is programming, the other page is gathered meanwhile.*/
+    jsp->phase    = STREAM_PHASE_POLL;
+    jsp->cmd.cfg  = QSPI_CFG_CMD(config->status_cmd) |
+                    STREAM_CMD_MODE | STREAM_DATA_MODE;
+    jsp->cmd.addr = 0U;
+    qspiStartAutoPollI(qspip, &jsp->cmd,
+                       config->ready_mask, config->ready_match);
+    stream_prepare(jsp, &jsp->pages[jsp->cur ^ 1U]);
+    break;
+  case STREAM_PHASE_POLL:
+    if (config->error_mask != 0U) {
+      jsp->phase = STREAM_PHASE_STATUS;
+      qspiStartReceiveI(qspip, &jsp->cmd, 1U, &jsp->status);
+    }
+    else {
+      stream_page_done(jsp, FLASH_NO_ERROR);
+    }
+    break;
+  case STREAM_PHASE_STATUS:
+    if ((jsp->status & config->error_mask) == 0U) {
+      stream_page_done(jsp, FLASH_NO_ERROR);
+    }
+    else if (config->clear_cmd != 0U) {
+      jsp->phase   = STREAM_PHASE_CLEAR;
+      jsp->cmd.cfg = QSPI_CFG_CMD(config->clear_cmd) | STREAM_CMD_MODE;
+      qspiStartCommandI(qspip, &jsp->cmd);
+    }
+    else {
+      stream_page_done(jsp, FLASH_ERROR_PROGRAM);
+    }
+    break;
+  case STREAM_PHASE_CLEAR:
+    stream_page_done(jsp, FLASH_ERROR_PROGRAM);
+    break;
+  default:
+    osalDbgAssert(false, "invalid phase");
+    break;
+  }
+
+  osalSysUnlockFromISR();
+}
+#endif /* JESD216_USE_STREAMING == TRUE */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -330,6 +579,30 @@ void jesd216_cmd_addr_dummy_receive(BUSDriver *busp,
 }
 #endif /* JESD216_BUS_MODE != JESD216_BUS_MODE_SPI */
 
+#if (JESD216_HAS_AUTOPOLL == TRUE) || defined(__DOXYGEN__)
+void jesd216_cmd_poll(BUSDriver *busp,
+                      uint32_t cmd,
+                      uint8_t mask,
+                      uint8_t match) {
+  qspi_command_t mode;
+
+  mode.cfg = QSPI_CFG_CMD(cmd) |
+#if JESD216_BUS_MODE == JESD216_BUS_MODE_QSPI1L
+             QSPI_CFG_CMD_MODE_ONE_LINE |
+             QSPI_CFG_DATA_MODE_ONE_LINE;
+#elif JESD216_BUS_MODE == JESD216_BUS_MODE_QSPI2L
+             QSPI_CFG_CMD_MODE_TWO_LINES |
+             QSPI_CFG_DATA_MODE_TWO_LINES;
+#else
+             QSPI_CFG_CMD_MODE_FOUR_LINES |
+             QSPI_CFG_DATA_MODE_FOUR_LINES;
+#endif
+  mode.addr = 0U;
+  mode.alt  = 0U;
+  qspiAutoPoll(busp, &mode, mask, match);
+}
+#endif /* JESD216_HAS_AUTOPOLL == TRUE */
+
 #if ((JESD216_BUS_MODE != JESD216_BUS_MODE_SPI) &&                          \
      (JESD216_SHARED_BUS == TRUE)) || defined(__DOXYGEN__)
 void jesd216_bus_acquire(BUSDriver *busp, const BUSConfig *config) {
@@ -365,4 +638,190 @@ void jesd216_bus_release(BUSDriver *busp) {
 #define jesd216_bus_release(busp)
 #endif
 
+#if (JESD216_USE_STREAMING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a program stream object.
+ *
+ * @param[out] jsp      pointer to the @p jesd216_stream_t object
+ *
+ * @init
+ */
+void jesd216StreamObjectInit(jesd216_stream_t *jsp) {
+
+  osalDbgCheck(jsp != NULL);
+
+  jsp->state            = JESD216_STREAM_STOP;
+  jsp->config           = NULL;
+  jsp->head             = NULL;
+  jsp->tail             = NULL;
+  jsp->prep             = NULL;
+  jsp->prep_n           = 0U;
+  jsp->pages[0].n       = 0U;
+  jsp->pages[1].n       = 0U;
+  jsp->cur              = 0U;
+  jsp->err              = FLASH_NO_ERROR;
+  jsp->thread           = NULL;
+  jsp->pages_programmed = 0U;
+  jsp->requests         = 0U;
+  osalEventObjectInit(&jsp->event);
+}
+
+/**
+ * @brief   Starts a program stream.
+ * @details The bus is acquired and reconfigured for the stream, the device
+ *          must be ready, no erase or suspended erase, and must not be
+ *          accessed through its driver until the stream is stopped.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] config    pointer to the stream configuration
+ *
+ * @api
+ */
+void jesd216StreamStart(jesd216_stream_t *jsp,
+                        const jesd216_stream_config_t *config) {
+
+  osalDbgCheck((jsp != NULL) && (config != NULL) &&
+               (config->busp != NULL) && (config->buscfg != NULL) &&
+               (config->buffer != NULL) && (config->page_size > 0U) &&
+               ((config->page_size & (config->page_size - 1U)) == 0U));
+  osalDbgAssert(jsp->state == JESD216_STREAM_STOP, "invalid state");
+
+#if JESD216_SHARED_BUS == TRUE
+  qspiAcquireBus(config->busp);
+#endif
+
+  jsp->config        = config;
+  jsp->buscfg        = *config->buscfg;
+  jsp->buscfg.end_cb = stream_callback;
+  jsp->pages[0].buf  = config->buffer;
+  jsp->pages[1].buf  = config->buffer + config->page_size;
+  jsp->cur           = 0U;
+  jsp->err           = FLASH_NO_ERROR;
+  qspiStart(config->busp, &jsp->buscfg);
+
+  jsp->state = JESD216_STREAM_READY;
+}
+
+/**
+ * @brief   Stops a program stream.
+ * @details The queued requests are completed first, then the original
+ *          bus configuration is restored and the bus released.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ *
+ * @api
+ */
+void jesd216StreamStop(jesd216_stream_t *jsp) {
+
+  osalDbgCheck(jsp != NULL);
+  osalDbgAssert((jsp->state == JESD216_STREAM_READY) ||
+                (jsp->state == JESD216_STREAM_ACTIVE), "invalid state");
+
+  (void)jesd216StreamWait(jsp);
+
+  qspiStart(jsp->config->busp, jsp->config->buscfg);
+#if JESD216_SHARED_BUS == TRUE
+  qspiReleaseBus(jsp->config->busp);
+#endif
+
+  jsp->state = JESD216_STREAM_STOP;
+}
+
+/**
+ * @brief   Queues a program request.
+ * @details The request is programmed after the previously queued ones, if
+ *          the stream is programming then the request data is gathered in
+ *          the free page buffer immediately.
+ * @note    The flash area must be erased, the request and its data must
+ *          not be modified until its completion.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] rqp       pointer to the request, the @p offset, @p buf,
+ *                      @p n and @p cb fields must be initialized
+ *
+ * @iclass
+ */
+void jesd216StreamProgramI(jesd216_stream_t *jsp, jesd216_request_t *rqp) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((jsp != NULL) && (rqp != NULL) &&
+               (rqp->buf != NULL) && (rqp->n > 0U));
+  osalDbgAssert((jsp->state == JESD216_STREAM_READY) ||
+                (jsp->state == JESD216_STREAM_ACTIVE), "invalid state");
+
+  rqp->next = NULL;
+  rqp->err  = FLASH_NO_ERROR;
+  if (jsp->tail == NULL) {
+    jsp->head = rqp;
+  }
+  else {
+    jsp->tail->next = rqp;
+  }
+  jsp->tail = rqp;
+  if (jsp->prep == NULL) {
+    jsp->prep   = rqp;
+    jsp->prep_n = 0U;
+  }
+
+  if (jsp->state == JESD216_STREAM_READY) {
+    jsp->state = JESD216_STREAM_ACTIVE;
+    stream_prepare(jsp, &jsp->pages[jsp->cur]);
+    stream_start_page(jsp);
+  }
+  else {
+    /* The page not on the bus can still grow.*/
+    stream_prepare(jsp, &jsp->pages[jsp->cur ^ 1U]);
+  }
+}
+
+/**
+ * @brief   Queues a program request.
+ * @details The request is programmed after the previously queued ones.
+ * @note    The flash area must be erased, the request and its data must
+ *          not be modified until its completion.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] rqp       pointer to the request, the @p offset, @p buf,
+ *                      @p n and @p cb fields must be initialized
+ *
+ * @api
+ */
+void jesd216StreamProgram(jesd216_stream_t *jsp, jesd216_request_t *rqp) {
+
+  osalSysLock();
+  jesd216StreamProgramI(jsp, rqp);
+  osalOsRescheduleS();
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Waits for all the queued requests to complete.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if all the requests since the previous call have
+ *                      been programmed.
+ * @retval FLASH_ERROR_PROGRAM if one or more pages failed, the failed
+ *                      requests have their @p err field set.
+ *
+ * @api
+ */
+flash_error_t jesd216StreamWait(jesd216_stream_t *jsp) {
+  flash_error_t err;
+
+  osalDbgCheck(jsp != NULL);
+
+  osalSysLock();
+  while (jsp->state == JESD216_STREAM_ACTIVE) {
+    osalDbgAssert(jsp->thread == NULL, "already waiting");
+    (void) osalThreadSuspendS(&jsp->thread);
+  }
+  err = jsp->err;
+  jsp->err = FLASH_NO_ERROR;
+  osalSysUnlock();
+
+  return err;
+}
+#endif /* JESD216_USE_STREAMING == TRUE */
+
 /** @} */
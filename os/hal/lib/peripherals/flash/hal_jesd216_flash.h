@@ -92,6 +92,18 @@
 #if !defined(JESD216_SHARED_BUS) || defined(__DOXYGEN__)
 #define JESD216_SHARED_BUS                  TRUE
 #endif
+
+/**
+ * @brief   Streaming program support.
+ * @details If set to @p TRUE the asynchronous program streams are
+ *          included, a stream programs queued requests page by page from
+ *          the QSPI interrupt, the next page is prepared while the current
+ *          one is being programmed.
+ * @note    Requires a QSPI bus mode with automatic status polling.
+ */
+#if !defined(JESD216_USE_STREAMING) || defined(__DOXYGEN__)
+#define JESD216_USE_STREAMING               FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -119,6 +131,21 @@
 #error "invalid JESD216_BUS_MODE selected"
 #endif
 
+/**
+ * @brief   Hardware status polling availability.
+ * @details Automatic status polling is available in QSPI bus modes when
+ *          the QSPI low level driver supports it.
+ */
+#if (JESD216_BUS_MODE != JESD216_BUS_MODE_SPI) || defined(__DOXYGEN__)
+#define JESD216_HAS_AUTOPOLL                QSPI_SUPPORTS_AUTOPOLL
+#else
+#define JESD216_HAS_AUTOPOLL                FALSE
+#endif
+
+#if (JESD216_USE_STREAMING == TRUE) && (JESD216_HAS_AUTOPOLL == FALSE)
+#error "JESD216_USE_STREAMING requires QSPI automatic status polling"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -175,6 +202,223 @@ typedef struct {
   _jesd216_flash_data
 } JESD215Flash;
 
+#if (JESD216_USE_STREAMING == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a program stream.
+ */
+typedef struct jesd216_stream jesd216_stream_t;
+
+/**
+ * @brief   Type of a program request.
+ */
+typedef struct jesd216_request jesd216_request_t;
+
+/**
+ * @brief   Type of a program request completion callback.
+ * @note    The callback is invoked from the bus interrupt context.
+ *
+ * @param[in] jsp       pointer to the @p jesd216_stream_t object
+ * @param[in] rqp       pointer to the completed request
+ */
+typedef void (*jesd216reqcb_t)(jesd216_stream_t *jsp, jesd216_request_t *rqp);
+
+/**
+ * @brief   Stream state machine possible states.
+ */
+typedef enum {
+  JESD216_STREAM_UNINIT = 0,        /**< Not initialized.                   */
+  JESD216_STREAM_STOP = 1,          /**< Stopped.                           */
+  JESD216_STREAM_READY = 2,         /**< Started, no pending requests.      */
+  JESD216_STREAM_ACTIVE = 3         /**< Programming.                       */
+} jesd216streamstate_t;
+
+/**
+ * @brief   Structure of a program request.
+ * @note    The request and its data buffer must not be modified until the
+ *          request is completed.
+ */
+struct jesd216_request {
+  /**
+   * @brief   Next queued request.
+   */
+  jesd216_request_t         *next;
+  /**
+   * @brief   Flash offset of the data.
+   */
+  flash_offset_t            offset;
+  /**
+   * @brief   Data to be programmed.
+   */
+  const uint8_t             *buf;
+  /**
+   * @brief   Data size, it can span any number of pages.
+   */
+  size_t                    n;
+  /**
+   * @brief   Completion callback or @p NULL.
+   */
+  jesd216reqcb_t            cb;
+  /**
+   * @brief   Request outcome, valid after completion.
+   */
+  flash_error_t             err;
+};
+
+/**
+ * @brief   Program stream configuration structure.
+ * @details The status fields describe how the device reports the end of a
+ *          page program, for example a generic device uses
+ *          @p JESD216_CMD_READ_STATUS_REGISTER with a ready mask of 0x01,
+ *          a ready match of 0x00 and no error bits.
+ */
+typedef struct {
+  /**
+   * @brief   Bus driver.
+   */
+  BUSDriver                 *busp;
+  /**
+   * @brief   Bus configuration, it is copied and the copy gets the stream
+   *          callback.
+   */
+  const BUSConfig           *buscfg;
+  /**
+   * @brief   Page program command, @p JESD216_CMD_EXTENDED_ADDRESSING can
+   *          be specified.
+   */
+  uint32_t                  program_cmd;
+  /**
+   * @brief   Device page size, a power of two.
+   */
+  size_t                    page_size;
+  /**
+   * @brief   Pages buffer, two pages.
+   */
+  uint8_t                   *buffer;
+  /**
+   * @brief   Status read command.
+   */
+  uint8_t                   status_cmd;
+  /**
+   * @brief   Status bits checked for the end of the program.
+   */
+  uint8_t                   ready_mask;
+  /**
+   * @brief   Value of the checked status bits when the device is ready.
+   */
+  uint8_t                   ready_match;
+  /**
+   * @brief   Status bits reporting a program error.
+   */
+  uint8_t                   error_mask;
+  /**
+   * @brief   Command clearing the error bits or zero if not required.
+   */
+  uint8_t                   clear_cmd;
+} jesd216_stream_config_t;
+
+/**
+ * @brief   Page buffer descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Page data.
+   */
+  uint8_t                   *buf;
+  /**
+   * @brief   Flash offset of the first byte.
+   */
+  flash_offset_t            offset;
+  /**
+   * @brief   Prepared bytes or zero if the buffer is free.
+   */
+  size_t                    n;
+  /**
+   * @brief   Last request with data in the page.
+   */
+  jesd216_request_t         *last;
+  /**
+   * @brief   The last request data ends in the page.
+   */
+  bool                      ends;
+} jesd216_page_t;
+
+/**
+ * @brief   Structure of a program stream.
+ */
+struct jesd216_stream {
+  /**
+   * @brief   Private copy of the bus configuration.
+   * @note    It must be the first field, the stream callback finds its
+   *          stream object through the bus driver @p config field.
+   */
+  BUSConfig                 buscfg;
+  /**
+   * @brief   Stream state.
+   */
+  jesd216streamstate_t      state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const jesd216_stream_config_t *config;
+  /**
+   * @brief   First queued request.
+   */
+  jesd216_request_t         *head;
+  /**
+   * @brief   Last queued request.
+   */
+  jesd216_request_t         *tail;
+  /**
+   * @brief   First request not yet completely prepared.
+   */
+  jesd216_request_t         *prep;
+  /**
+   * @brief   Bytes of the @p prep request already prepared.
+   */
+  size_t                    prep_n;
+  /**
+   * @brief   Page buffers.
+   */
+  jesd216_page_t            pages[2];
+  /**
+   * @brief   Index of the page buffer being programmed.
+   */
+  unsigned                  cur;
+  /**
+   * @brief   Current bus transaction.
+   */
+  unsigned                  phase;
+  /**
+   * @brief   Current bus command.
+   */
+  qspi_command_t            cmd;
+  /**
+   * @brief   Last status read.
+   */
+  uint8_t                   status;
+  /**
+   * @brief   Errors since the last @p jesd216StreamWait().
+   */
+  flash_error_t             err;
+  /**
+   * @brief   Thread waiting for the stream to become idle.
+   */
+  thread_reference_t        thread;
+  /**
+   * @brief   Requests completion event source.
+   */
+  event_source_t            event;
+  /**
+   * @brief   Number of programmed pages.
+   */
+  uint32_t                  pages_programmed;
+  /**
+   * @brief   Number of completed requests.
+   */
+  uint32_t                  requests;
+};
+#endif /* JESD216_USE_STREAMING == TRUE */
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -183,8 +427,39 @@ typedef struct {
  * @name    Macro Functions (BaseFlash)
  * @{
  */
+/**
+ * @brief   Reads the SFDP tables.
+ *
+ * @param[in] ip        pointer to a @p JESD215Flash or derived class
+ * @param[in] offset    SFDP offset
+ * @param[in] n         number of bytes to be read
+ * @param[out] rp       pointer to the data buffer
+ * @return              An error code.
+ * @retval FLASH_NO_ERROR if there is no erase operation in progress.
+ * @retval FLASH_BUSY_ERASING if there is an erase operation in progress.
+ * @retval FLASH_ERROR_READ if the read operation failed.
+ *
+ * @api
+ */
+#define jesd216FlashReadSFDP(ip, offset, n, rp)                             \
+  (ip)->vmt->read_sfdp(ip, offset, n, rp)
+/** @} */
+
+/**
+ * @name    Program stream events flags
+ * @{
+ */
+#define JESD216_STREAM_COMPLETE             (eventflags_t)1
+#define JESD216_STREAM_ERROR                (eventflags_t)2
 /** @} */
 
+/**
+ * @brief   Computes the size of a stream pages buffer.
+ *
+ * @param[in] page_size device page size
+ */
+#define JESD216_STREAM_BUFFER_SIZE(page_size) ((size_t)(page_size) * 2U)
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -209,10 +484,23 @@ extern "C" {
                                       flash_offset_t offset, uint8_t dummy,
                                       size_t n, uint8_t *p);
 #endif /* JESD216_BUS_MODE != JESD216_BUS_MODE_SPI */
+#if JESD216_HAS_AUTOPOLL == TRUE
+  void jesd216_cmd_poll(BUSDriver *busp, uint32_t cmd,
+                        uint8_t mask, uint8_t match);
+#endif /* JESD216_HAS_AUTOPOLL == TRUE */
 #if JESD216_SHARED_BUS == TRUE
   void jesd216_bus_acquire(BUSDriver *busp, const BUSConfig *config);
   void jesd216_bus_release(BUSDriver *busp);
 #endif
+#if JESD216_USE_STREAMING == TRUE
+  void jesd216StreamObjectInit(jesd216_stream_t *jsp);
+  void jesd216StreamStart(jesd216_stream_t *jsp,
+                          const jesd216_stream_config_t *config);
+  void jesd216StreamStop(jesd216_stream_t *jsp);
+  void jesd216StreamProgramI(jesd216_stream_t *jsp, jesd216_request_t *rqp);
+  void jesd216StreamProgram(jesd216_stream_t *jsp, jesd216_request_t *rqp);
+  flash_error_t jesd216StreamWait(jesd216_stream_t *jsp);
+#endif
 #ifdef __cplusplus
 }
 #endif
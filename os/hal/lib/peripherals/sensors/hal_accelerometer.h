@@ -135,6 +135,45 @@ typedef struct {
 #define accelerometerReadCooked(ip, dp)                                     \
         (ip)->vmt_baseaccelerometer->read_cooked(ip, dp)
 
+/**
+ * @brief   Accelerometer FIFO configuration.
+ *
+ * @param[in] ip        pointer to a @p BaseAccelerometer class.
+ * @param[in] wm        FIFO watermark in samples or
+ *                      @p SENSOR_FIFO_DISABLED.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO, the watermark exceeds
+ *                      its depth or one or more errors occurred.
+ *
+ * @api
+ */
+#define accelerometerSetFifo(ip, wm)                                        \
+        ((ip)->vmt_baseaccelerometer->set_fifo != NULL ?                    \
+         (ip)->vmt_baseaccelerometer->set_fifo(ip, wm) : MSG_RESET)
+
+/**
+ * @brief   Accelerometer read a batch of raw samples from the FIFO.
+ *
+ * @param[in] ip        pointer to a @p BaseAccelerometer class.
+ * @param[out] dp       pointer to a data array of @p n samples.
+ * @param[out] tp       pointer to an array of @p n time stamps or @p NULL.
+ * @param[in] n         maximum number of samples to be read.
+ * @param[out] np       pointer to the number of samples read.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO or one or more errors
+ *                      occurred.
+ *
+ * @api
+ */
+#define accelerometerReadRawBatch(ip, dp, tp, n, np)                        \
+        ((ip)->vmt_baseaccelerometer->read_raw_batch != NULL ?              \
+         (ip)->vmt_baseaccelerometer->read_raw_batch(ip, dp, tp, n, np) :   \
+         MSG_RESET)
+
 /**
  * @brief   Updates accelerometer bias data from received buffer.
  * @note    The bias buffer must have the same length of the
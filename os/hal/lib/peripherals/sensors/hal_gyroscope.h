@@ -138,6 +138,45 @@ typedef struct {
 #define gyroscopeReadCooked(ip, dp)                                         \
         (ip)->vmt_basegyroscope->read_cooked(ip, dp)
 
+/**
+ * @brief   Gyroscope FIFO configuration.
+ *
+ * @param[in] ip        pointer to a @p BaseGyroscope class.
+ * @param[in] wm        FIFO watermark in samples or
+ *                      @p SENSOR_FIFO_DISABLED.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO, the watermark exceeds
+ *                      its depth or one or more errors occurred.
+ *
+ * @api
+ */
+#define gyroscopeSetFifo(ip, wm)                                            \
+        ((ip)->vmt_basegyroscope->set_fifo != NULL ?                        \
+         (ip)->vmt_basegyroscope->set_fifo(ip, wm) : MSG_RESET)
+
+/**
+ * @brief   Gyroscope read a batch of raw samples from the FIFO.
+ *
+ * @param[in] ip        pointer to a @p BaseGyroscope class.
+ * @param[out] dp       pointer to a data array of @p n samples.
+ * @param[out] tp       pointer to an array of @p n time stamps or @p NULL.
+ * @param[in] n         maximum number of samples to be read.
+ * @param[out] np       pointer to the number of samples read.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO or one or more errors
+ *                      occurred.
+ *
+ * @api
+ */
+#define gyroscopeReadRawBatch(ip, dp, tp, n, np)                            \
+        ((ip)->vmt_basegyroscope->read_raw_batch != NULL ?                  \
+         (ip)->vmt_basegyroscope->read_raw_batch(ip, dp, tp, n, np) :       \
+         MSG_RESET)
+
 /**
  * @brief   Gyroscope bias sampling procedure.
  * @note    During this procedure gyroscope must be kept hold in the rest
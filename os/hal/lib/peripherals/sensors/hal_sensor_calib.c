@@ -0,0 +1,321 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_calib.c
+ * @brief   Sensors raw data conversion and calibration code.
+ * @details The conversion functions process arrays of samples, as read
+ *          from the sensors FIFOs, using plain loops over local copies of
+ *          the coefficients so that the compiler can keep them in
+ *          registers and vectorize the diagonal case.
+ *
+ * @addtogroup HAL_SENSOR_CALIB
+ * @{
+ */
+
+#include "hal.h"
+#include "hal_sensor_calib.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define COEFF_ONE           ((float)(1UL << SENSOR_CALIB_COEFF_BITS))
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static int64_t to_fixed(float x) {
+
+  return (int64_t)(x * COEFF_ONE + (x >= 0.0f ? 0.5f : -0.5f));
+}
+
+static void cook_diag3(const sensor_calib_t *scp, const int32_t raw[],
+                       float cooked[], size_t n) {
+  const float s0 = scp->matrix[0], s1 = scp->matrix[4], s2 = scp->matrix[8];
+  const float b0 = scp->bias[0], b1 = scp->bias[1], b2 = scp->bias[2];
+  size_t i;
+
+  for (i = 0U; i < n * 3U; i += 3U) {
+    cooked[i]      = (float)raw[i]      * s0 - b0;
+    cooked[i + 1U] = (float)raw[i + 1U] * s1 - b1;
+    cooked[i + 2U] = (float)raw[i + 2U] * s2 - b2;
+  }
+}
+
+static void cook_full3(const sensor_calib_t *scp, const int32_t raw[],
+                       float cooked[], size_t n) {
+  const float m00 = scp->matrix[0], m01 = scp->matrix[1], m02 = scp->matrix[2];
+  const float m10 = scp->matrix[3], m11 = scp->matrix[4], m12 = scp->matrix[5];
+  const float m20 = scp->matrix[6], m21 = scp->matrix[7], m22 = scp->matrix[8];
+  const float b0 = scp->bias[0], b1 = scp->bias[1], b2 = scp->bias[2];
+  size_t i;
+
+  for (i = 0U; i < n * 3U; i += 3U) {
+    float x = (float)raw[i], y = (float)raw[i + 1U], z = (float)raw[i + 2U];
+
+    cooked[i]      = m00 * x + m01 * y + m02 * z - b0;
+    cooked[i + 1U] = m10 * x + m11 * y + m12 * z - b1;
+    cooked[i + 2U] = m20 * x + m21 * y + m22 * z - b2;
+  }
+}
+
+static void cook_generic(const sensor_calib_t *scp, const int32_t raw[],
+                         float cooked[], size_t n) {
+  size_t axes = scp->axes;
+  size_t i, r, c;
+
+  for (i = 0U; i < n * axes; i += axes) {
+    for (r = 0U; r < axes; r++) {
+      float acc = -scp->bias[r];
+
+      for (c = 0U; c < axes; c++) {
+        acc += scp->matrix[(r * axes) + c] * (float)raw[i + c];
+      }
+      cooked[i + r] = acc;
+    }
+  }
+}
+
+/* The fixed point results are rounded to the output fractional bits.*/
+#define FIXED_OUT(acc, round, shift) ((int32_t)(((acc) + (round)) >> (shift)))
+
+static void cook_fixed_diag3(const sensor_calib_fixed_t *sfp,
+                             const int32_t raw[], int32_t cooked[], size_t n) {
+  const unsigned shift = SENSOR_CALIB_COEFF_BITS - sfp->frac_bits;
+  const int64_t round = shift > 0U ? (int64_t)1 << (shift - 1U) : 0;
+  const int32_t s0 = sfp->matrix[0], s1 = sfp->matrix[4], s2 = sfp->matrix[8];
+  const int64_t b0 = sfp->bias[0] - round, b1 = sfp->bias[1] - round;
+  const int64_t b2 = sfp->bias[2] - round;
+  size_t i;
+
+  for (i = 0U; i < n * 3U; i += 3U) {
+    cooked[i]      = FIXED_OUT((int64_t)s0 * raw[i],      -b0, shift);
+    cooked[i + 1U] = FIXED_OUT((int64_t)s1 * raw[i + 1U], -b1, shift);
+    cooked[i + 2U] = FIXED_OUT((int64_t)s2 * raw[i + 2U], -b2, shift);
+  }
+}
+
+static void cook_fixed_full3(const sensor_calib_fixed_t *sfp,
+                             const int32_t raw[], int32_t cooked[], size_t n) {
+  const unsigned shift = SENSOR_CALIB_COEFF_BITS - sfp->frac_bits;
+  const int64_t round = shift > 0U ? (int64_t)1 << (shift - 1U) : 0;
+  const int32_t *m = sfp->matrix;
+  const int64_t b0 = sfp->bias[0] - round, b1 = sfp->bias[1] - round;
+  const int64_t b2 = sfp->bias[2] - round;
+  size_t i;
+
+  for (i = 0U; i < n * 3U; i += 3U) {
+    int32_t x = raw[i], y = raw[i + 1U], z = raw[i + 2U];
+
+    cooked[i]      = FIXED_OUT((int64_t)m[0] * x + (int64_t)m[1] * y +
+                               (int64_t)m[2] * z, -b0, shift);
+    cooked[i + 1U] = FIXED_OUT((int64_t)m[3] * x + (int64_t)m[4] * y +
+                               (int64_t)m[5] * z, -b1, shift);
+    cooked[i + 2U] = FIXED_OUT((int64_t)m[6] * x + (int64_t)m[7] * y +
+                               (int64_t)m[8] * z, -b2, shift);
+  }
+}
+
+static void cook_fixed_generic(const sensor_calib_fixed_t *sfp,
+                               const int32_t raw[], int32_t cooked[],
+                               size_t n) {
+  const unsigned shift = SENSOR_CALIB_COEFF_BITS - sfp->frac_bits;
+  const int64_t round = shift > 0U ? (int64_t)1 << (shift - 1U) : 0;
+  size_t axes = sfp->axes;
+  size_t i, r, c;
+
+  for (i = 0U; i < n * axes; i += axes) {
+    int64_t acc[SENSOR_CALIB_MAX_AXES];
+
+    /* All the outputs are computed before writing, in place conversion
+       is allowed.*/
+    for (r = 0U; r < axes; r++) {
+      acc[r] = -sfp->bias[r];
+      for (c = 0U; c < axes; c++) {
+        acc[r] += (int64_t)sfp->matrix[(r * axes) + c] * raw[i + c];
+      }
+    }
+    for (r = 0U; r < axes; r++) {
+      cooked[i + r] = FIXED_OUT(acc[r], round, shift);
+    }
+  }
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a per-axis calibration.
+ *
+ * @param[out] scp          pointer to the @p sensor_calib_t object
+ * @param[in] axes          number of axes
+ * @param[in] sensitivity   array of per-axis sensitivities or @p NULL
+ *                          for unity sensitivity
+ * @param[in] bias          array of per-axis biases in cooked units or
+ *                          @p NULL for no bias
+ *
+ * @api
+ */
+void sensorCalibInit(sensor_calib_t *scp, size_t axes,
+                     const float sensitivity[], const float bias[]) {
+  size_t i;
+
+  osalDbgCheck((scp != NULL) && (axes > 0U) &&
+               (axes <= SENSOR_CALIB_MAX_AXES));
+
+  scp->axes     = axes;
+  scp->diagonal = true;
+  for (i = 0U; i < axes * axes; i++) {
+    scp->matrix[i] = 0.0f;
+  }
+  for (i = 0U; i < axes; i++) {
+    scp->matrix[(i * axes) + i] = sensitivity != NULL ? sensitivity[i] : 1.0f;
+    scp->bias[i] = bias != NULL ? bias[i] : 0.0f;
+  }
+}
+
+/**
+ * @brief   Sets a full calibration matrix.
+ * @details The matrix combines the per-axis sensitivities with the axes
+ *          misalignment and cross-axis sensitivity corrections.
+ *
+ * @param[in,out] scp       pointer to an initialized @p sensor_calib_t
+ * @param[in] matrix        row major matrix of @p axes by @p axes elements
+ * @param[in] bias          array of per-axis biases in cooked units or
+ *                          @p NULL for no bias
+ *
+ * @api
+ */
+void sensorCalibSetMatrix(sensor_calib_t *scp, const float matrix[],
+                          const float bias[]) {
+  size_t i, axes;
+
+  osalDbgCheck((scp != NULL) && (matrix != NULL));
+
+  axes = scp->axes;
+  scp->diagonal = true;
+  for (i = 0U; i < axes * axes; i++) {
+    scp->matrix[i] = matrix[i];
+    if (((i % (axes + 1U)) != 0U) && (matrix[i] != 0.0f)) {
+      scp->diagonal = false;
+    }
+  }
+  for (i = 0U; i < axes; i++) {
+    scp->bias[i] = bias != NULL ? bias[i] : 0.0f;
+  }
+}
+
+/**
+ * @brief   Derives a fixed point calibration.
+ * @note    The output range is limited by the 32 bits result, the
+ *          coefficients must not exceed the range allowed by
+ *          @p SENSOR_CALIB_COEFF_BITS.
+ *
+ * @param[in] scp           pointer to the @p sensor_calib_t object
+ * @param[out] sfp          pointer to the @p sensor_calib_fixed_t object
+ * @param[in] frac_bits     fractional bits of the output, not greater than
+ *                          @p SENSOR_CALIB_COEFF_BITS
+ *
+ * @api
+ */
+void sensorCalibToFixed(const sensor_calib_t *scp,
+                        sensor_calib_fixed_t *sfp, unsigned frac_bits) {
+  size_t i;
+
+  osalDbgCheck((scp != NULL) && (sfp != NULL) &&
+               (frac_bits <= SENSOR_CALIB_COEFF_BITS));
+
+  sfp->axes      = scp->axes;
+  sfp->diagonal  = scp->diagonal;
+  sfp->frac_bits = frac_bits;
+  for (i = 0U; i < scp->axes * scp->axes; i++) {
+    sfp->matrix[i] = (int32_t)to_fixed(scp->matrix[i]);
+  }
+  for (i = 0U; i < scp->axes; i++) {
+    sfp->bias[i] = to_fixed(scp->bias[i]);
+  }
+}
+
+/**
+ * @brief   Converts an array of raw samples to cooked values.
+ *
+ * @param[in] scp           pointer to the @p sensor_calib_t object
+ * @param[in] raw           array of @p n raw samples
+ * @param[out] cooked       array of @p n cooked samples
+ * @param[in] n             number of samples
+ *
+ * @api
+ */
+void sensorCalibCook(const sensor_calib_t *scp, const int32_t raw[],
+                     float cooked[], size_t n) {
+
+  osalDbgCheck((scp != NULL) && (raw != NULL) && (cooked != NULL));
+
+  if (scp->axes == 3U) {
+    if (scp->diagonal) {
+      cook_diag3(scp, raw, cooked, n);
+    }
+    else {
+      cook_full3(scp, raw, cooked, n);
+    }
+  }
+  else {
+    cook_generic(scp, raw, cooked, n);
+  }
+}
+
+/**
+ * @brief   Converts an array of raw samples to fixed point cooked values.
+ *
+ * @param[in] sfp           pointer to the @p sensor_calib_fixed_t object
+ * @param[in] raw           array of @p n raw samples
+ * @param[out] cooked       array of @p n fixed point cooked samples, it
+ *                          can be the same memory area of @p raw
+ * @param[in] n             number of samples
+ *
+ * @api
+ */
+void sensorCalibCookFixed(const sensor_calib_fixed_t *sfp,
+                          const int32_t raw[], int32_t cooked[], size_t n) {
+
+  osalDbgCheck((sfp != NULL) && (raw != NULL) && (cooked != NULL));
+
+  if (sfp->axes == 3U) {
+    if (sfp->diagonal) {
+      cook_fixed_diag3(sfp, raw, cooked, n);
+    }
+    else {
+      cook_fixed_full3(sfp, raw, cooked, n);
+    }
+  }
+  else {
+    cook_fixed_generic(sfp, raw, cooked, n);
+  }
+}
+
+/** @} */
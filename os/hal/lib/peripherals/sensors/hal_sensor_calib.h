@@ -0,0 +1,150 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_calib.h
+ * @brief   Sensors raw data conversion and calibration header.
+ *
+ * @addtogroup HAL_SENSOR_CALIB
+ * @{
+ */
+
+#ifndef HAL_SENSOR_CALIB_H
+#define HAL_SENSOR_CALIB_H
+
+#include "hal_sensors.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum number of axes of a calibration.
+ */
+#define SENSOR_CALIB_MAX_AXES               3U
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Fractional bits of the fixed point calibration coefficients.
+ */
+#if !defined(SENSOR_CALIB_COEFF_BITS) || defined(__DOXYGEN__)
+#define SENSOR_CALIB_COEFF_BITS             16U
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (SENSOR_CALIB_COEFF_BITS < 1U) || (SENSOR_CALIB_COEFF_BITS > 30U)
+#error "invalid SENSOR_CALIB_COEFF_BITS value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Floating point calibration.
+ * @details Cooked data is computed as <tt>matrix * raw - bias</tt>, the
+ *          per-axis sensitivity and bias of the EX drivers are the special
+ *          case of a diagonal matrix.
+ */
+typedef struct {
+  /**
+   * @brief   Number of axes.
+   */
+  size_t                    axes;
+  /**
+   * @brief   The matrix is diagonal.
+   */
+  bool                      diagonal;
+  /**
+   * @brief   Calibration matrix, row major.
+   */
+  float                     matrix[SENSOR_CALIB_MAX_AXES *
+                                   SENSOR_CALIB_MAX_AXES];
+  /**
+   * @brief   Bias in cooked units.
+   */
+  float                     bias[SENSOR_CALIB_MAX_AXES];
+} sensor_calib_t;
+
+/**
+ * @brief   Fixed point calibration.
+ * @details The coefficients have @p SENSOR_CALIB_COEFF_BITS fractional
+ *          bits, the output has @p frac_bits fractional bits.
+ */
+typedef struct {
+  /**
+   * @brief   Number of axes.
+   */
+  size_t                    axes;
+  /**
+   * @brief   The matrix is diagonal.
+   */
+  bool                      diagonal;
+  /**
+   * @brief   Fractional bits of the output.
+   */
+  unsigned                  frac_bits;
+  /**
+   * @brief   Calibration matrix, row major.
+   */
+  int32_t                   matrix[SENSOR_CALIB_MAX_AXES *
+                                   SENSOR_CALIB_MAX_AXES];
+  /**
+   * @brief   Bias.
+   */
+  int64_t                   bias[SENSOR_CALIB_MAX_AXES];
+} sensor_calib_fixed_t;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sensorCalibInit(sensor_calib_t *scp, size_t axes,
+                       const float sensitivity[], const float bias[]);
+  void sensorCalibSetMatrix(sensor_calib_t *scp, const float matrix[],
+                            const float bias[]);
+  void sensorCalibToFixed(const sensor_calib_t *scp,
+                          sensor_calib_fixed_t *sfp, unsigned frac_bits);
+  void sensorCalibCook(const sensor_calib_t *scp, const int32_t raw[],
+                       float cooked[], size_t n);
+  void sensorCalibCookFixed(const sensor_calib_fixed_t *sfp,
+                            const int32_t raw[], int32_t cooked[], size_t n);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_SENSOR_CALIB_H */
+
+/** @} */
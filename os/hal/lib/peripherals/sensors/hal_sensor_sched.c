@@ -0,0 +1,361 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_sched.c
+ * @brief   Sensors sampling scheduler code.
+ * @details The scheduler samples a set of sensors at their own rates from
+ *          a single thread. Sensors due within the alignment window are
+ *          sampled in the same wakeup and sensors sharing a bus are read
+ *          within a single bus acquisition. The time stamped samples are
+ *          published into a ring buffer read by any number of subscribers.
+ *
+ * @addtogroup HAL_SENSOR_SCHED
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "hal_sensor_sched.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Checks if a sensor sampling is due.
+ *
+ * @param[in] sep       pointer to the @p sensor_sched_entry_t object
+ * @param[in] limit     time limit
+ * @return              The sampling is due before the time limit.
+ *
+ * @notapi
+ */
+static bool ssched_is_due(sensor_sched_entry_t *sep, systime_t limit) {
+
+  /* The sampling time is never before the last sampling.*/
+  return osalOsIsTimeWithinX(sep->due, sep->last, limit + (systime_t)1);
+}
+
+/**
+ * @brief   Publishes a sample into the ring buffer.
+ *
+ * @param[in] ssp       pointer to the @p sensor_sched_t object
+ * @param[in] sp        pointer to the sample
+ *
+ * @notapi
+ */
+static void ssched_publish(sensor_sched_t *ssp, const sensor_sample_t *sp) {
+
+  osalSysLock();
+  ssp->ring[ssp->wr & (uint32_t)(ssp->size - 1U)] = *sp;
+  ssp->wr++;
+  osalThreadDequeueAllI(&ssp->waiting, MSG_OK);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Samples a sensor and computes its next sampling time.
+ *
+ * @param[in] ssp       pointer to the @p sensor_sched_t object
+ * @param[in] sep       pointer to the @p sensor_sched_entry_t object
+ * @param[in] now       current system time
+ *
+ * @notapi
+ */
+static void ssched_sample(sensor_sched_t *ssp, sensor_sched_entry_t *sep,
+                          systime_t now) {
+  sensor_sample_t sample;
+
+  sample.source = sep;
+  if (!sep->batch) {
+    if (sensorReadRaw(sep->sensor, sample.data) == MSG_OK) {
+      sample.stamp = osalOsGetSystemTimeX();
+      ssched_publish(ssp, &sample);
+      sep->samples++;
+    }
+    else {
+      sep->errors++;
+    }
+  }
+  else {
+    int32_t buf[SENSOR_SCHED_BATCH_SIZE * SENSOR_SCHED_MAX_CHANNELS];
+    systime_t stamps[SENSOR_SCHED_BATCH_SIZE];
+    size_t i, n;
+
+    /* Draining the FIFO, the samples keep their own time stamps.*/
+    do {
+      if (sensorReadRawBatch(sep->sensor, buf, stamps,
+                             SENSOR_SCHED_BATCH_SIZE, &n) != MSG_OK) {
+        sep->errors++;
+        break;
+      }
+      for (i = 0U; i < n; i++) {
+        sample.stamp = stamps[i];
+        memcpy(sample.data, &buf[i * sep->channels],
+               sep->channels * sizeof (int32_t));
+        ssched_publish(ssp, &sample);
+      }
+      sep->samples += (uint32_t)n;
+    } while (n == SENSOR_SCHED_BATCH_SIZE);
+  }
+
+  /* Next sampling time, the periods already elapsed are skipped. A sensor
+     sampled in advance within the alignment window keeps the current time
+     as reference, the reference must never be in the future.*/
+  if (osalOsIsTimeWithinX(now, sep->last, sep->due)) {
+    sep->last = now;
+  }
+  else {
+    sep->last = sep->due;
+  }
+  sep->due += sep->period;
+  while (ssched_is_due(sep, now)) {
+    sep->due += sep->period;
+    sep->skipped++;
+  }
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a sensors scheduler.
+ *
+ * @param[out] ssp      pointer to the @p sensor_sched_t object
+ * @param[in] ring      samples ring buffer
+ * @param[in] size      number of samples in the ring buffer, a power of two
+ * @param[in] window    alignment window
+ *
+ * @init
+ */
+void sschedObjectInit(sensor_sched_t *ssp, sensor_sample_t *ring,
+                      size_t size, systime_t window) {
+
+  osalDbgCheck((ssp != NULL) && (ring != NULL) && (size > 0U) &&
+               ((size & (size - 1U)) == 0U));
+
+  ssp->entries      = NULL;
+  ssp->ring         = ring;
+  ssp->size         = size;
+  ssp->wr           = 0U;
+  ssp->window       = window;
+  ssp->wakeups      = 0U;
+  ssp->acquisitions = 0U;
+  osalThreadQueueObjectInit(&ssp->waiting);
+}
+
+/**
+ * @brief   Adds a sensor to the scheduler.
+ * @details The first sampling happens on the next scheduler round, the
+ *          sensors added together are sampled in phase.
+ * @note    In batch mode the sensor FIFO must have been enabled, the
+ *          period should be shorter than the time required to fill it.
+ *
+ * @param[in] ssp       pointer to the @p sensor_sched_t object
+ * @param[out] sep      pointer to the @p sensor_sched_entry_t object
+ * @param[in] sensor    pointer to the sensor
+ * @param[in] bus       pointer to the sensor bus descriptor or @p NULL
+ * @param[in] period    sampling period or FIFO draining period
+ * @param[in] batch     drain the sensor FIFO instead of reading a sample
+ *
+ * @api
+ */
+void sschedAddSensor(sensor_sched_t *ssp, sensor_sched_entry_t *sep,
+                     BaseSensor *sensor, const sensor_sched_bus_t *bus,
+                     systime_t period, bool batch) {
+  sensor_sched_entry_t **pp;
+
+  osalDbgCheck((ssp != NULL) && (sep != NULL) && (sensor != NULL) &&
+               (period > (systime_t)0));
+
+  sep->next     = NULL;
+  sep->sensor   = sensor;
+  sep->bus      = bus;
+  sep->period   = period;
+  sep->due      = osalOsGetSystemTimeX();
+  sep->last     = sep->due;
+  sep->channels = sensorGetChannelNumber(sensor);
+  sep->batch    = batch;
+  sep->pending  = false;
+  sep->samples  = 0U;
+  sep->skipped  = 0U;
+  sep->errors   = 0U;
+
+  osalDbgAssert(sep->channels <= SENSOR_SCHED_MAX_CHANNELS,
+                "too many channels");
+
+  /* Appended to the list, the sensors are read in registration order.*/
+  pp = &ssp->entries;
+  while (*pp != NULL) {
+    pp = &(*pp)->next;
+  }
+  *pp = sep;
+}
+
+/**
+ * @brief   Performs a scheduler round.
+ * @details Waits for the earliest sampling time then samples all the
+ *          sensors due within the alignment window, one bus acquisition
+ *          for each bus involved. The subscribers are rescheduled once at
+ *          the end of the round.
+ * @note    This function is meant to be called in a loop by a dedicated
+ *          thread.
+ *
+ * @param[in] ssp       pointer to the @p sensor_sched_t object
+ *
+ * @api
+ */
+void sschedServe(sensor_sched_t *ssp) {
+  sensor_sched_entry_t *sep, *bep;
+  const sensor_sched_bus_t *bus;
+  systime_t now, delay;
+
+  osalDbgCheck(ssp != NULL);
+  osalDbgAssert(ssp->entries != NULL, "no sensors");
+
+  /* Waiting for the earliest sampling time.*/
+  now = osalOsGetSystemTimeX();
+  delay = (systime_t)-1;
+  for (sep = ssp->entries; sep != NULL; sep = sep->next) {
+    if (ssched_is_due(sep, now)) {
+      delay = (systime_t)0;
+      break;
+    }
+    if ((systime_t)(sep->due - now) < delay) {
+      delay = (systime_t)(sep->due - now);
+    }
+  }
+  if (delay > (systime_t)0) {
+    osalThreadSleep(delay);
+    now = osalOsGetSystemTimeX();
+  }
+  ssp->wakeups++;
+
+  /* Sensors due within the alignment window.*/
+  for (sep = ssp->entries; sep != NULL; sep = sep->next) {
+    sep->pending = ssched_is_due(sep, now + ssp->window);
+  }
+
+  /* Sampling grouped by bus.*/
+  for (sep = ssp->entries; sep != NULL; sep = sep->next) {
+    if (!sep->pending) {
+      continue;
+    }
+    bus = sep->bus;
+    if ((bus != NULL) && (bus->acquire != NULL)) {
+      bus->acquire(bus->arg);
+    }
+    ssp->acquisitions++;
+    for (bep = sep; bep != NULL; bep = bep->next) {
+      if (bep->pending && (bep->bus == bus)) {
+        bep->pending = false;
+        ssched_sample(ssp, bep, now);
+      }
+    }
+    if ((bus != NULL) && (bus->release != NULL)) {
+      bus->release(bus->arg);
+    }
+  }
+
+  osalSysLock();
+  osalOsRescheduleS();
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Subscribes to the published samples.
+ * @details The subscriber receives the samples published after this call.
+ *
+ * @param[in] ssp       pointer to the @p sensor_sched_t object
+ * @param[out] subp     pointer to the @p sensor_sched_sub_t object
+ *
+ * @api
+ */
+void sschedSubscribe(sensor_sched_t *ssp, sensor_sched_sub_t *subp) {
+
+  osalDbgCheck((ssp != NULL) && (subp != NULL));
+
+  osalSysLock();
+  subp->ssp  = ssp;
+  subp->rd   = ssp->wr;
+  subp->lost = 0U;
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Gets the next published sample.
+ * @details Samples overwritten in the ring buffer before being read are
+ *          skipped and counted as lost.
+ *
+ * @param[in] subp      pointer to the @p sensor_sched_sub_t object
+ * @param[out] sp       pointer to the @p sensor_sample_t object
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a sample has been read.
+ * @retval MSG_TIMEOUT  if no sample has been published within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t sschedGetSampleTimeout(sensor_sched_sub_t *subp, sensor_sample_t *sp,
+                             systime_t timeout) {
+  sensor_sched_t *ssp;
+  msg_t msg;
+
+  osalDbgCheck((subp != NULL) && (sp != NULL));
+
+  ssp = subp->ssp;
+
+  osalSysLock();
+  while (subp->rd == ssp->wr) {
+    msg = osalThreadEnqueueTimeoutS(&ssp->waiting, timeout);
+    if (msg != MSG_OK) {
+      osalSysUnlock();
+      return msg;
+    }
+  }
+  if ((uint32_t)(ssp->wr - subp->rd) > (uint32_t)ssp->size) {
+    subp->lost += (uint32_t)(ssp->wr - subp->rd) - (uint32_t)ssp->size;
+    subp->rd    = ssp->wr - (uint32_t)ssp->size;
+  }
+  *sp = ssp->ring[subp->rd & (uint32_t)(ssp->size - 1U)];
+  subp->rd++;
+  osalSysUnlock();
+
+  return MSG_OK;
+}
+
+/** @} */
@@ -0,0 +1,254 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_sched.h
+ * @brief   Sensors sampling scheduler header.
+ *
+ * @addtogroup HAL_SENSOR_SCHED
+ * @{
+ */
+
+#ifndef HAL_SENSOR_SCHED_H
+#define HAL_SENSOR_SCHED_H
+
+#include "hal_sensors.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Maximum number of channels of a scheduled sensor.
+ */
+#if !defined(SENSOR_SCHED_MAX_CHANNELS) || defined(__DOXYGEN__)
+#define SENSOR_SCHED_MAX_CHANNELS           6U
+#endif
+
+/**
+ * @brief   Number of samples read from a FIFO in a single burst.
+ * @note    The burst buffer is allocated on the scheduler thread stack.
+ */
+#if !defined(SENSOR_SCHED_BATCH_SIZE) || defined(__DOXYGEN__)
+#define SENSOR_SCHED_BATCH_SIZE             8U
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if SENSOR_SCHED_MAX_CHANNELS < 1U
+#error "invalid SENSOR_SCHED_MAX_CHANNELS value"
+#endif
+
+#if SENSOR_SCHED_BATCH_SIZE < 1U
+#error "invalid SENSOR_SCHED_BATCH_SIZE value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Sensors bus descriptor.
+ * @details The scheduler acquires the bus once for all the sensors on it
+ *          that are due at the same time.
+ * @note    The callbacks usually lock the bus mutex, the drivers of the
+ *          sensors on the bus must then be built without their own bus
+ *          sharing option, the HAL bus mutexes are not recursive.
+ */
+typedef struct {
+  /**
+   * @brief   Bus acquire callback or @p NULL.
+   */
+  void                      (*acquire)(void *arg);
+  /**
+   * @brief   Bus release callback or @p NULL.
+   */
+  void                      (*release)(void *arg);
+  /**
+   * @brief   Callbacks argument.
+   */
+  void                      *arg;
+} sensor_sched_bus_t;
+
+/**
+ * @brief   Scheduled sensor.
+ */
+typedef struct sensor_sched_entry {
+  /**
+   * @brief   Next scheduled sensor.
+   */
+  struct sensor_sched_entry *next;
+  /**
+   * @brief   Sampled sensor.
+   */
+  BaseSensor                *sensor;
+  /**
+   * @brief   Bus of the sensor.
+   */
+  const sensor_sched_bus_t  *bus;
+  /**
+   * @brief   Sampling period or FIFO draining period.
+   */
+  systime_t                 period;
+  /**
+   * @brief   Next sampling time.
+   */
+  systime_t                 due;
+  /**
+   * @brief   Time of the last sampling.
+   */
+  systime_t                 last;
+  /**
+   * @brief   Number of channels of the sensor.
+   */
+  size_t                    channels;
+  /**
+   * @brief   The sensor FIFO is drained instead of reading a sample.
+   */
+  bool                      batch;
+  /**
+   * @brief   Sampling is due in the current round.
+   */
+  bool                      pending;
+  /**
+   * @brief   Number of published samples.
+   */
+  uint32_t                  samples;
+  /**
+   * @brief   Number of sampling periods skipped because late.
+   */
+  uint32_t                  skipped;
+  /**
+   * @brief   Number of failed reads.
+   */
+  uint32_t                  errors;
+} sensor_sched_entry_t;
+
+/**
+ * @brief   Time stamped sample.
+ */
+typedef struct {
+  /**
+   * @brief   Sensor producing the sample.
+   */
+  const sensor_sched_entry_t *source;
+  /**
+   * @brief   Sample time.
+   */
+  systime_t                 stamp;
+  /**
+   * @brief   Raw sample data.
+   */
+  int32_t                   data[SENSOR_SCHED_MAX_CHANNELS];
+} sensor_sample_t;
+
+/**
+ * @brief   Sensors scheduler.
+ */
+typedef struct {
+  /**
+   * @brief   List of the scheduled sensors.
+   */
+  sensor_sched_entry_t      *entries;
+  /**
+   * @brief   Samples ring buffer.
+   */
+  sensor_sample_t           *ring;
+  /**
+   * @brief   Number of samples in the ring buffer.
+   */
+  size_t                    size;
+  /**
+   * @brief   Number of samples published since the initialization.
+   */
+  uint32_t                  wr;
+  /**
+   * @brief   Subscribers waiting for samples.
+   */
+  threads_queue_t           waiting;
+  /**
+   * @brief   Alignment window.
+   * @details Sensors due within the window are sampled together with the
+   *          ones already due, saving a wakeup.
+   */
+  systime_t                 window;
+  /**
+   * @brief   Number of scheduler wakeups.
+   */
+  uint32_t                  wakeups;
+  /**
+   * @brief   Number of bus acquisitions.
+   */
+  uint32_t                  acquisitions;
+} sensor_sched_t;
+
+/**
+ * @brief   Samples subscriber.
+ */
+typedef struct {
+  /**
+   * @brief   Associated scheduler.
+   */
+  sensor_sched_t            *ssp;
+  /**
+   * @brief   Number of the next sample to be read.
+   */
+  uint32_t                  rd;
+  /**
+   * @brief   Number of samples overwritten before being read.
+   */
+  uint32_t                  lost;
+} sensor_sched_sub_t;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sschedObjectInit(sensor_sched_t *ssp, sensor_sample_t *ring,
+                        size_t size, systime_t window);
+  void sschedAddSensor(sensor_sched_t *ssp, sensor_sched_entry_t *sep,
+                       BaseSensor *sensor, const sensor_sched_bus_t *bus,
+                       systime_t period, bool batch);
+  void sschedServe(sensor_sched_t *ssp);
+  void sschedSubscribe(sensor_sched_t *ssp, sensor_sched_sub_t *subp);
+  msg_t sschedGetSampleTimeout(sensor_sched_sub_t *subp, sensor_sample_t *sp,
+                               systime_t timeout);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_SENSOR_SCHED_H */
+
+/** @} */
@@ -0,0 +1,247 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_sim.c
+ * @brief   Simulated sensor code.
+ * @details The simulated sensor reproduces the timing of a sensor with a
+ *          fixed output data rate and an optional FIFO, it is meant for
+ *          exercising the @p BaseSensor interface on simulator builds.
+ *
+ * @addtogroup HAL_SENSOR_SIM
+ * @{
+ */
+
+#include "hal.h"
+#include "hal_sensor_sim.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint32_t sensorsim_update(SensorSim *ssp) {
+  systime_t now = osalOsGetSystemTimeX();
+
+  /* Simulated time advances with the system time.*/
+  ssp->time += ((uint64_t)(systime_t)(now - ssp->last) * 1000000U) /
+               (uint64_t)OSAL_ST_FREQUENCY;
+  ssp->last = now;
+
+  /* Number of samples produced since the start.*/
+  return (uint32_t)(ssp->time / ssp->config->period);
+}
+
+static void sensorsim_sample(SensorSim *ssp, uint32_t sample,
+                             int32_t axes[]) {
+  size_t ch;
+
+  for (ch = 0U; ch < ssp->config->channels; ch++) {
+    if (ssp->config->source != NULL) {
+      axes[ch] = ssp->config->source(ssp, ch, sample);
+    }
+    else {
+      axes[ch] = (int32_t)(sample + (uint32_t)ch);
+    }
+  }
+}
+
+static size_t get_channels_number(void *ip) {
+
+  osalDbgCheck(ip != NULL);
+
+  return ((SensorSim *)ip)->config->channels;
+}
+
+static msg_t read_raw(void *ip, int32_t axes[]) {
+  SensorSim *ssp = (SensorSim *)ip;
+  uint32_t produced;
+
+  osalDbgCheck((ip != NULL) && (axes != NULL));
+  osalDbgAssert(ssp->state == SENSORSIM_READY, "invalid state");
+
+  /* The output registers hold the last sample, the first one until it
+     has been produced.*/
+  produced = sensorsim_update(ssp);
+  sensorsim_sample(ssp, produced > 0U ? produced - 1U : 0U, axes);
+  ssp->transactions++;
+
+  return MSG_OK;
+}
+
+static msg_t read_cooked(void *ip, float axes[]) {
+  SensorSim *ssp = (SensorSim *)ip;
+  int32_t raw[SENSORSIM_MAX_CHANNELS];
+  size_t ch;
+  msg_t msg;
+
+  osalDbgCheck((ip != NULL) && (axes != NULL));
+
+  msg = read_raw(ip, raw);
+  for (ch = 0U; ch < ssp->config->channels; ch++) {
+    axes[ch] = (float)raw[ch] * ssp->config->sensitivity;
+  }
+
+  return msg;
+}
+
+static msg_t set_fifo(void *ip, size_t watermark) {
+  SensorSim *ssp = (SensorSim *)ip;
+
+  osalDbgCheck(ip != NULL);
+  osalDbgAssert(ssp->state == SENSORSIM_READY, "invalid state");
+
+  if (watermark >= ssp->config->fifo_depth) {
+    return MSG_RESET;
+  }
+
+  /* Enabling or disabling flushes the FIFO content.*/
+  ssp->consumed = sensorsim_update(ssp);
+  ssp->fifowm   = watermark;
+  ssp->transactions++;
+
+  return MSG_OK;
+}
+
+static msg_t read_raw_batch(void *ip, int32_t axes[], systime_t stamps[],
+                            size_t n, size_t *np) {
+  SensorSim *ssp = (SensorSim *)ip;
+  uint32_t produced;
+  size_t i, level, cnt;
+
+  osalDbgCheck((ip != NULL) && (axes != NULL) && (np != NULL));
+  osalDbgAssert(ssp->state == SENSORSIM_READY, "invalid state");
+  osalDbgAssert(ssp->fifowm != SENSOR_FIFO_DISABLED, "FIFO disabled");
+
+  /* Samples not read in time are overwritten by the newer ones.*/
+  produced = sensorsim_update(ssp);
+  level = (size_t)(produced - ssp->consumed);
+  if (level > ssp->config->fifo_depth) {
+    ssp->overruns += (uint32_t)(level - ssp->config->fifo_depth);
+    ssp->consumed  = produced - (uint32_t)ssp->config->fifo_depth;
+    level = ssp->config->fifo_depth;
+  }
+
+  /* FIFO status read.*/
+  ssp->transactions++;
+
+  cnt = level < n ? level : n;
+  if (cnt > 0U) {
+    /* Data burst.*/
+    ssp->transactions++;
+    for (i = 0U; i < cnt; i++) {
+      sensorsim_sample(ssp, ssp->consumed + (uint32_t)i,
+                       &axes[i * ssp->config->channels]);
+      if (stamps != NULL) {
+        stamps[i] = SENSOR_FIFO_STAMP(ssp->last, level - 1U - i,
+                                      ssp->config->period);
+      }
+    }
+    ssp->consumed += (uint32_t)cnt;
+  }
+  *np = cnt;
+
+  return MSG_OK;
+}
+
+static const struct BaseSensorVMT vmt_basesensor = {
+  get_channels_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch
+};
+
+static const struct SensorSimVMT vmt_sensorsim = {
+  get_channels_number, read_raw, read_cooked,
+  set_fifo, read_raw_batch
+};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an instance.
+ *
+ * @param[out] ssp      pointer to the @p SensorSim object
+ *
+ * @init
+ */
+void sensorsimObjectInit(SensorSim *ssp) {
+
+  ssp->vmt_basesensor = &vmt_basesensor;
+  ssp->vmt_sensorsim  = &vmt_sensorsim;
+  ssp->config         = NULL;
+  ssp->fifowm         = SENSOR_FIFO_DISABLED;
+  ssp->state          = SENSORSIM_STOP;
+}
+
+/**
+ * @brief   Configures and activates the simulated sensor.
+ * @details The sensor starts producing samples, the FIFO is disabled and
+ *          the counters are cleared.
+ *
+ * @param[in] ssp       pointer to the @p SensorSim object
+ * @param[in] config    pointer to the @p SensorSimConfig object
+ *
+ * @api
+ */
+void sensorsimStart(SensorSim *ssp, const SensorSimConfig *config) {
+
+  osalDbgCheck((ssp != NULL) && (config != NULL) &&
+               (config->channels > 0U) &&
+               (config->channels <= SENSORSIM_MAX_CHANNELS) &&
+               (config->period > 0U));
+  osalDbgAssert((ssp->state == SENSORSIM_STOP) ||
+                (ssp->state == SENSORSIM_READY), "invalid state");
+
+  ssp->config       = config;
+  ssp->last         = osalOsGetSystemTimeX();
+  ssp->time         = 0U;
+  ssp->consumed     = 0U;
+  ssp->fifowm       = SENSOR_FIFO_DISABLED;
+  ssp->transactions = 0U;
+  ssp->overruns     = 0U;
+  ssp->state        = SENSORSIM_READY;
+}
+
+/**
+ * @brief   Deactivates the simulated sensor.
+ *
+ * @param[in] ssp       pointer to the @p SensorSim object
+ *
+ * @api
+ */
+void sensorsimStop(SensorSim *ssp) {
+
+  osalDbgCheck(ssp != NULL);
+  osalDbgAssert((ssp->state == SENSORSIM_STOP) ||
+                (ssp->state == SENSORSIM_READY), "invalid state");
+
+  ssp->state = SENSORSIM_STOP;
+}
+
+/** @} */
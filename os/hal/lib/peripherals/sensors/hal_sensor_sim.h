@@ -0,0 +1,184 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    hal_sensor_sim.h
+ * @brief   Simulated sensor header.
+ *
+ * @addtogroup HAL_SENSOR_SIM
+ * @{
+ */
+
+#ifndef HAL_SENSOR_SIM_H
+#define HAL_SENSOR_SIM_H
+
+#include "hal_sensors.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Maximum number of channels of a simulated sensor.
+ */
+#if !defined(SENSORSIM_MAX_CHANNELS) || defined(__DOXYGEN__)
+#define SENSORSIM_MAX_CHANNELS              8U
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Driver state machine possible states.
+ */
+typedef enum {
+  SENSORSIM_UNINIT = 0,             /**< Not initialized.                   */
+  SENSORSIM_STOP = 1,               /**< Stopped.                           */
+  SENSORSIM_READY = 2               /**< Ready.                             */
+} sensorsim_state_t;
+
+/**
+ * @brief   Type of a simulated sensor.
+ */
+typedef struct SensorSim SensorSim;
+
+/**
+ * @brief   Samples source callback type.
+ *
+ * @param[in] ssp       pointer to the @p SensorSim object
+ * @param[in] ch        channel number
+ * @param[in] sample    sample number, counted from the sensor start
+ * @return              The raw channel value.
+ */
+typedef int32_t (*sensorsimsrc_t)(SensorSim *ssp, size_t ch, uint32_t sample);
+
+/**
+ * @brief   Simulated sensor configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Number of channels.
+   */
+  size_t                    channels;
+  /**
+   * @brief   Output data period in microseconds.
+   */
+  uint32_t                  period;
+  /**
+   * @brief   FIFO depth in samples, zero if the sensor has no FIFO.
+   */
+  size_t                    fifo_depth;
+  /**
+   * @brief   Raw to cooked data scale factor.
+   */
+  float                     sensitivity;
+  /**
+   * @brief   Samples source or @p NULL.
+   * @details If @p NULL the channel raw value is the sample number plus
+   *          the channel number.
+   */
+  sensorsimsrc_t            source;
+} SensorSimConfig;
+
+/**
+ * @brief   @p SensorSim specific methods.
+ */
+#define _sensor_sim_methods                                                 \
+  _base_sensor_methods
+
+/**
+ * @brief   @p SensorSim virtual methods table.
+ */
+struct SensorSimVMT {
+  _sensor_sim_methods
+};
+
+/**
+ * @brief   @p SensorSim specific data.
+ */
+#define _sensor_sim_data                                                    \
+  _base_sensor_data                                                         \
+  /* Driver state.*/                                                        \
+  sensorsim_state_t         state;                                          \
+  /* Current configuration data.*/                                          \
+  const SensorSimConfig     *config;                                        \
+  /* System time of the last update.*/                                      \
+  systime_t                 last;                                           \
+  /* Time since the sensor start in microseconds.*/                         \
+  uint64_t                  time;                                           \
+  /* Number of the oldest sample in the FIFO.*/                             \
+  uint32_t                  consumed;                                       \
+  /* Current FIFO watermark or SENSOR_FIFO_DISABLED.*/                      \
+  size_t                    fifowm;                                         \
+  /* Number of simulated bus transactions.*/                                \
+  uint32_t                  transactions;                                   \
+  /* Number of samples lost because of FIFO overruns.*/                     \
+  uint32_t                  overruns;
+
+/**
+ * @extends BaseSensor
+ *
+ * @brief   Simulated sensor class.
+ * @details The sensor produces a sample every period, a sample is
+ *          available one period after the previous one. Each read
+ *          operation accounts for the bus transactions a real device
+ *          would require: one for a single sample read and two, the FIFO
+ *          status and the data burst, for a batch read.
+ */
+struct SensorSim {
+  /** @brief BaseSensor Virtual Methods Table. */
+  const struct BaseSensorVMT *vmt_basesensor;
+  /** @brief SensorSim Virtual Methods Table. */
+  const struct SensorSimVMT *vmt_sensorsim;
+  _sensor_sim_data
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sensorsimObjectInit(SensorSim *ssp);
+  void sensorsimStart(SensorSim *ssp, const SensorSimConfig *config);
+  void sensorsimStop(SensorSim *ssp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_SENSOR_SIM_H */
+
+/** @} */
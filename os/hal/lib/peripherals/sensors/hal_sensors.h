@@ -29,6 +29,11 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Watermark value disabling the sensor FIFO.
+ */
+#define SENSOR_FIFO_DISABLED        0U
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -50,7 +55,12 @@
   /* Reads the sensor raw data.*/                                           \
   msg_t (*read_raw)(void *instance, int32_t axes[]);                        \
   /* Reads the sensor returning normalized data.*/                          \
-  msg_t (*read_cooked)(void *instance, float axes[]);
+  msg_t (*read_cooked)(void *instance, float axes[]);                       \
+  /* Configures the sensor FIFO, NULL if there is no FIFO.*/                \
+  msg_t (*set_fifo)(void *instance, size_t watermark);                      \
+  /* Reads a batch of raw samples from the FIFO, NULL if there is no FIFO.*/\
+  msg_t (*read_raw_batch)(void *instance, int32_t axes[], systime_t stamps[],\
+                          size_t n, size_t *np);
 
 /**
  * @brief   BaseSensor specific methods with inherited ones.
@@ -128,8 +138,69 @@ typedef struct {
  * @api
  */
 #define sensorReadCooked(ip, dp) (ip)->vmt_basesensor->read_cooked(ip, dp)
+
+/**
+ * @brief   Sensors FIFO configuration.
+ * @details The FIFO collects samples at the sensor output data rate, the
+ *          watermark is the FIFO level raising the sensor watermark
+ *          interrupt, if any.
+ *
+ * @param[in] ip        pointer to a @p BaseSensor or derived class.
+ * @param[in] wm        FIFO watermark in samples or
+ *                      @p SENSOR_FIFO_DISABLED.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO, the watermark exceeds
+ *                      its depth or one or more errors occurred.
+ *
+ * @api
+ */
+#define sensorSetFifo(ip, wm)                                               \
+  ((ip)->vmt_basesensor->set_fifo != NULL ?                                 \
+   (ip)->vmt_basesensor->set_fifo(ip, wm) : MSG_RESET)
+
+/**
+ * @brief   Sensors read a batch of raw samples.
+ * @details The samples buffered in the sensor FIFO are read in a single
+ *          bus transfer, oldest first. Each sample takes as many array
+ *          elements as the sensor channels.
+ * @pre     The FIFO must have been enabled using @p sensorSetFifo().
+ *
+ * @param[in] ip        pointer to a @p BaseSensor or derived class.
+ * @param[out] dp       pointer to a data array of @p n samples.
+ * @param[out] tp       pointer to an array of @p n sample time stamps,
+ *                      estimated from the output data rate, or @p NULL.
+ * @param[in] n         maximum number of samples to be read.
+ * @param[out] np       pointer to the number of samples read.
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       if the function succeeded.
+ * @retval MSG_RESET    if the sensor has no FIFO or one or more errors
+ *                      occurred.
+ *
+ * @api
+ */
+#define sensorReadRawBatch(ip, dp, tp, n, np)                               \
+  ((ip)->vmt_basesensor->read_raw_batch != NULL ?                           \
+   (ip)->vmt_basesensor->read_raw_batch(ip, dp, tp, n, np) : MSG_RESET)
 /** @} */
 
+/**
+ * @brief   Estimated time stamp of a sample read from a FIFO.
+ *
+ * @param[in] now       system time of the FIFO read
+ * @param[in] age       number of samples acquired after the sample
+ * @param[in] period    sample period in microseconds
+ * @return              The system time of the sample acquisition.
+ *
+ * @notapi
+ */
+#define SENSOR_FIFO_STAMP(now, age, period)                                 \
+  ((systime_t)((now) - (systime_t)(((uint64_t)(age) * (uint64_t)(period) * \
+                                    (uint64_t)OSAL_ST_FREQUENCY) /          \
+                                   1000000U)))
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
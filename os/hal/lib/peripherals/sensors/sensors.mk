@@ -0,0 +1,8 @@
+# Sensors interfaces and raw data conversion.
+SENSORSSRC = $(CHIBIOS)/os/hal/lib/peripherals/sensors/hal_sensor_calib.c \
+             $(CHIBIOS)/os/hal/lib/peripherals/sensors/hal_sensor_sched.c
+
+SENSORSINC = $(CHIBIOS)/os/hal/lib/peripherals/sensors
+
+# Simulated sensor, simulator builds.
+SENSORSSIMSRC = $(CHIBIOS)/os/hal/lib/peripherals/sensors/hal_sensor_sim.c
@@ -80,6 +80,16 @@ static void qspi_lld_serve_interrupt(QSPIDriver *qspip) {
   /* Stop everything.*/
   dmaStreamDisable(qspip->dma);
 
+  /* End of an automatic polling operation, the last status read is
+     flushed and the peripheral goes back to indirect mode.*/
+  if ((qspip->qspi->CR & QUADSPI_CR_SMIE) != 0U) {
+    qspip->qspi->CR |= QUADSPI_CR_ABORT;
+    while ((qspip->qspi->CR & QUADSPI_CR_ABORT) != 0U) {
+    }
+    qspip->qspi->CR = (qspip->qspi->CR & ~(QUADSPI_CR_SMIE | QUADSPI_CR_APMS)) |
+                      QUADSPI_CR_TCIE | QUADSPI_CR_DMAEN;
+  }
+
   /* Portable QSPI ISR code defined in the high level driver, note, it is
      a macro.*/
   _qspi_isr_code(qspip);
@@ -344,6 +354,39 @@ void qspi_lld_unmap_flash(QSPIDriver *qspip) {
 }
 #endif /* QSPI_SUPPORTS_MEMMAP == TRUE */
 
+#if (QSPI_SUPPORTS_AUTOPOLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Polls a status byte until it matches.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @notapi
+ */
+void qspi_lld_autopoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                       uint8_t mask, uint8_t match) {
+
+  /* The status match interrupt replaces the transfer complete one, the
+     DMA is not involved and the polling stops on the first match.*/
+  qspip->qspi->CR = (qspip->qspi->CR & ~(QUADSPI_CR_TCIE | QUADSPI_CR_DMAEN)) |
+                    QUADSPI_CR_SMIE | QUADSPI_CR_APMS;
+
+  /* Single status byte.*/
+  qspip->qspi->PSMKR = (uint32_t)mask;
+  qspip->qspi->PSMAR = (uint32_t)match;
+  qspip->qspi->PIR   = STM32_QSPI_AUTOPOLL_INTERVAL;
+  qspip->qspi->DLR   = 0U;
+  qspip->qspi->ABR   = cmdp->alt;
+  qspip->qspi->CCR   = cmdp->cfg | QUADSPI_CCR_FMODE_1;
+  if ((cmdp->cfg & QSPI_CFG_ADDR_MODE_MASK) != QSPI_CFG_ADDR_MODE_NONE) {
+    qspip->qspi->AR  = cmdp->addr;
+  }
+}
+#endif /* QSPI_SUPPORTS_AUTOPOLL == TRUE */
+
 #endif /* HAL_USE_QSPI */
 
 /** @} */
@@ -36,6 +36,7 @@
  * @{
  */
 #define QSPI_SUPPORTS_MEMMAP                TRUE
+#define QSPI_SUPPORTS_AUTOPOLL              TRUE
 /** @} */
 
 /**
@@ -114,6 +115,13 @@
 #if !defined(STM32_USE_STM32_D1_WORKAROUND) || defined(__DOXYGEN__)
 #define STM32_USE_STM32_D1_WORKAROUND       TRUE
 #endif
+
+/**
+ * @brief   Automatic polling interval in QUADSPI clock cycles.
+ */
+#if !defined(STM32_QSPI_AUTOPOLL_INTERVAL) || defined(__DOXYGEN__)
+#define STM32_QSPI_AUTOPOLL_INTERVAL        16
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -148,6 +156,11 @@
 #error "STM32_QSPI_QUADSPI1_PRESCALER_VALUE not within 1..256"
 #endif
 
+#if (STM32_QSPI_AUTOPOLL_INTERVAL < 1) ||                                   \
+    (STM32_QSPI_AUTOPOLL_INTERVAL > 65535)
+#error "STM32_QSPI_AUTOPOLL_INTERVAL not within 1..65535"
+#endif
+
 /* The following checks are only required when there is a DMA able to
    reassign streams to different channels.*/
 #if STM32_ADVANCED_DMA
@@ -270,6 +283,10 @@ extern "C" {
                           uint8_t **addrp);
   void qspi_lld_unmap_flash(QSPIDriver *qspip);
 #endif
+#if QSPI_SUPPORTS_AUTOPOLL == TRUE
+  void qspi_lld_autopoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                         uint8_t mask, uint8_t match);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,11 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   The driver invokes @p timeout_cb on idle line or receiver timeout.
+ */
+#define UART_SUPPORTS_TIMEOUT               TRUE
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
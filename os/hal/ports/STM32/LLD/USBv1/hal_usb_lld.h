@@ -173,6 +173,12 @@ typedef struct {
    * @brief   Waiting thread.
    */
   thread_reference_t            thread;
+#endif
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Queued transfers, the first one is in progress.
+   */
+  usbxfer_t                     *xqueue;
 #endif
   /* End of the mandatory fields.*/
   /**
@@ -202,6 +208,12 @@ typedef struct {
    * @brief   Waiting thread.
    */
   thread_reference_t            thread;
+#endif
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Queued transfers, the first one is in progress.
+   */
+  usbxfer_t                     *xqueue;
 #endif
   /* End of the mandatory fields.*/
   /**
@@ -0,0 +1,213 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/hal_adc_lld.c
+ * @brief   Simulator ADC subsystem low level driver source.
+ * @details The simulated converter fills the samples buffer as a DMA would
+ *          do, a batch of rows is converted on each system tick according
+ *          to the conversion group rate. Half and full buffer events are
+ *          raised from the simulated interrupt context.
+ *
+ * @addtogroup SIM_ADC
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_ADC == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   ADC1 driver identifier.
+ */
+#if (USE_SIM_ADC1 == TRUE) || defined(__DOXYGEN__)
+ADCDriver ADCD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Converts the rows due since the last batch.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @return              The interrupt simulation result.
+ * @retval false        if nothing has been converted.
+ * @retval true         if one or more rows have been converted.
+ *
+ * @notapi
+ */
+static bool adc_lld_serve(ADCDriver *adcp) {
+  systime_t now;
+  size_t n;
+
+  if (adcp->state != ADC_ACTIVE) {
+    return false;
+  }
+
+  now = osalOsGetSystemTimeX();
+  if (now == adcp->last) {
+    return false;
+  }
+
+  /* Rows due since the last batch, a converter late for more than a whole
+     buffer just skips the lost rows.*/
+  n = (size_t)(now - adcp->last) * (size_t)adcp->grpp->rate;
+  if (n > adcp->depth) {
+    n = adcp->depth;
+  }
+  adcp->last = now;
+
+  while ((n > 0U) && (adcp->state == ADC_ACTIVE)) {
+    adc_channels_num_t ch;
+    adcsample_t *p = adcp->samples + (adcp->pos * adcp->grpp->num_channels);
+
+    for (ch = 0U; ch < adcp->grpp->num_channels; ch++) {
+      if ((adcp->config != NULL) && (adcp->config->source != NULL)) {
+        *p++ = adcp->config->source(adcp, ch, adcp->rows);
+      }
+      else {
+        *p++ = (adcsample_t)(adcp->rows + (uint32_t)ch);
+      }
+    }
+    adcp->rows++;
+    adcp->pos++;
+    n--;
+
+    if (adcp->pos >= adcp->depth) {
+      adcp->pos = 0U;
+      _adc_isr_full_code(adcp);
+    }
+    else if (adcp->grpp->circular && (adcp->pos == (adcp->depth / 2U))) {
+      _adc_isr_half_code(adcp);
+    }
+  }
+
+  return true;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level ADC driver initialization.
+ *
+ * @notapi
+ */
+void adc_lld_init(void) {
+
+#if USE_SIM_ADC1 == TRUE
+  /* Driver initialization.*/
+  adcObjectInit(&ADCD1);
+#endif
+}
+
+/**
+ * @brief   Configures and activates the ADC peripheral.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_start(ADCDriver *adcp) {
+
+  if (adcp->state == ADC_STOP) {
+    adcp->pos  = 0U;
+    adcp->rows = 0U;
+  }
+}
+
+/**
+ * @brief   Deactivates the ADC peripheral.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_stop(ADCDriver *adcp) {
+
+  (void)adcp;
+}
+
+/**
+ * @brief   Starts an ADC conversion.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_start_conversion(ADCDriver *adcp) {
+
+  adcp->pos  = 0U;
+  adcp->last = osalOsGetSystemTimeX();
+}
+
+/**
+ * @brief   Stops an ongoing conversion.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_stop_conversion(ADCDriver *adcp) {
+
+  (void)adcp;
+}
+
+/**
+ * @brief   ADC interrupt simulation.
+ *
+ * @return              The interrupt simulation result.
+ * @retval false        if no interrupt has been served.
+ * @retval true         if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool adc_lld_interrupt_pending(void) {
+  bool b = false;
+
+  OSAL_IRQ_PROLOGUE();
+
+#if USE_SIM_ADC1 == TRUE
+  b = adc_lld_serve(&ADCD1) || b;
+#endif
+
+  OSAL_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_ADC == TRUE */
+
+/** @} */
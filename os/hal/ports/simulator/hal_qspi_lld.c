@@ -0,0 +1,273 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/hal_qspi_lld.c
+ * @brief   Simulator QSPI subsystem low level driver source.
+ * @details Bus transactions are delivered to a simulated device through
+ *          the exchange function in the driver configuration, the
+ *          transaction is performed and completed in the next interrupt
+ *          simulation.
+ *
+ * @addtogroup SIM_QSPI
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_QSPI == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief QSPID1 driver identifier.*/
+#if (USE_SIM_QSPI1 == TRUE) || defined(__DOXYGEN__)
+QSPIDriver QSPID1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Queues a transaction.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] n         number of bytes in the data phase
+ * @param[in] txbuf     transmit buffer or @p NULL
+ * @param[out] rxbuf    receive buffer or @p NULL
+ *
+ * @notapi
+ */
+static void qspi_lld_queue(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                           size_t n, const uint8_t *txbuf, uint8_t *rxbuf) {
+
+  osalDbgAssert(!qspip->pending, "transaction pending");
+
+  qspip->cmd      = *cmdp;
+  qspip->n        = n;
+  qspip->txbuf    = txbuf;
+  qspip->rxbuf    = rxbuf;
+  qspip->autopoll = false;
+  qspip->pending  = true;
+}
+
+/**
+ * @brief   Performs the pending transaction.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @return              The interrupt simulation result.
+ * @retval false        if there was no pending transaction.
+ * @retval true         if a transaction has been performed.
+ *
+ * @notapi
+ */
+static bool qspi_lld_serve(QSPIDriver *qspip) {
+
+  if (!qspip->pending) {
+    return false;
+  }
+
+  if (qspip->autopoll) {
+    systime_t now = osalOsGetSystemTimeX();
+
+    /* Automatic polling reads the status once per system tick, the
+       simulated devices do not change state more often than that.*/
+    if (now == qspip->polled) {
+      return false;
+    }
+    qspip->polled = now;
+    qspip->polls++;
+    qspip->transactions++;
+    if (qspip->config->exchange != NULL) {
+      qspip->config->exchange(qspip, &qspip->cmd,
+                              1U, NULL, &qspip->status);
+    }
+    if ((qspip->status & qspip->mask) != qspip->match) {
+      return true;
+    }
+    qspip->pending = false;
+    _qspi_isr_code(qspip);
+
+    return true;
+  }
+
+  qspip->pending = false;
+  qspip->transactions++;
+  if (qspip->config->exchange != NULL) {
+    qspip->config->exchange(qspip, &qspip->cmd,
+                            qspip->n, qspip->txbuf, qspip->rxbuf);
+  }
+
+  _qspi_isr_code(qspip);
+
+  return true;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level QSPI driver initialization.
+ *
+ * @notapi
+ */
+void qspi_lld_init(void) {
+
+#if USE_SIM_QSPI1 == TRUE
+  qspiObjectInit(&QSPID1);
+  QSPID1.pending = false;
+  QSPID1.transactions = 0U;
+  QSPID1.polls = 0U;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the QSPI peripheral.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ *
+ * @notapi
+ */
+void qspi_lld_start(QSPIDriver *qspip) {
+
+  if (qspip->state == QSPI_STOP) {
+    qspip->pending = false;
+  }
+}
+
+/**
+ * @brief   Deactivates the QSPI peripheral.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ *
+ * @notapi
+ */
+void qspi_lld_stop(QSPIDriver *qspip) {
+
+  qspip->pending = false;
+}
+
+/**
+ * @brief   Sends a command without data phase.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ *
+ * @notapi
+ */
+void qspi_lld_command(QSPIDriver *qspip, const qspi_command_t *cmdp) {
+
+  qspi_lld_queue(qspip, cmdp, 0U, NULL, NULL);
+}
+
+/**
+ * @brief   Sends a command with data over the QSPI bus.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] n         number of bytes to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @notapi
+ */
+void qspi_lld_send(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                   size_t n, const uint8_t *txbuf) {
+
+  qspi_lld_queue(qspip, cmdp, n, txbuf, NULL);
+}
+
+/**
+ * @brief   Sends a command then receives data over the QSPI bus.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] n         number of bytes to send
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void qspi_lld_receive(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                      size_t n, uint8_t *rxbuf) {
+
+  qspi_lld_queue(qspip, cmdp, n, NULL, rxbuf);
+}
+
+/**
+ * @brief   Polls a status byte until it matches.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @notapi
+ */
+void qspi_lld_autopoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                       uint8_t mask, uint8_t match) {
+
+  qspi_lld_queue(qspip, cmdp, 1U, NULL, &qspip->status);
+  qspip->autopoll = true;
+  qspip->mask     = mask;
+  qspip->match    = match;
+  qspip->polled   = (systime_t)(osalOsGetSystemTimeX() - (systime_t)1);
+}
+
+/**
+ * @brief   QSPI interrupt simulation.
+ *
+ * @return              The interrupt simulation result.
+ * @retval false        if no interrupt has been served.
+ * @retval true         if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool qspi_lld_interrupt_pending(void) {
+  bool b = false;
+
+  OSAL_IRQ_PROLOGUE();
+
+#if USE_SIM_QSPI1 == TRUE
+  b = qspi_lld_serve(&QSPID1) || b;
+#endif
+
+  OSAL_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_QSPI */
+
+/** @} */
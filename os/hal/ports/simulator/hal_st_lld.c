@@ -34,6 +34,21 @@
 /* Driver exported variables.                                                */
 /*===========================================================================*/
 
+/**
+ * @brief   Simulated free running counter.
+ */
+systime_t st_lld_counter;
+
+/**
+ * @brief   Simulated compare register.
+ */
+systime_t st_lld_alarm;
+
+/**
+ * @brief   Simulated compare interrupt enable.
+ */
+bool st_lld_alarm_active;
+
 /*===========================================================================*/
 /* Driver local types.                                                       */
 /*===========================================================================*/
@@ -60,6 +75,27 @@
  * @notapi
  */
 void st_lld_init(void) {
+
+  st_lld_counter = (systime_t)0;
+  st_lld_alarm = (systime_t)0;
+  st_lld_alarm_active = false;
+}
+
+/**
+ * @brief   Advances the simulated counter by one tick.
+ * @note    Invoked by the interrupts simulation on each timer period.
+ *
+ * @return              The alarm status.
+ * @retval false        if the alarm interrupt is not triggered.
+ * @retval true         if the counter matched an active alarm.
+ *
+ * @notapi
+ */
+bool st_lld_increase_counter(void) {
+
+  st_lld_counter++;
+
+  return st_lld_alarm_active && (st_lld_counter == st_lld_alarm);
 }
 
 #endif /* OSAL_ST_MODE != OSAL_ST_MODE_NONE */
@@ -51,10 +51,17 @@
 /* External declarations.                                                    */
 /*===========================================================================*/
 
+#if !defined(__DOXYGEN__)
+extern systime_t st_lld_counter;
+extern systime_t st_lld_alarm;
+extern bool st_lld_alarm_active;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
   void st_lld_init(void);
+  bool st_lld_increase_counter(void);
 #ifdef __cplusplus
 }
 #endif
@@ -72,7 +79,7 @@ extern "C" {
  */
 static inline systime_t st_lld_get_counter(void) {
 
-  return (systime_t)0;
+  return st_lld_counter;
 }
 
 /**
@@ -86,7 +93,8 @@ static inline systime_t st_lld_get_counter(void) {
  */
 static inline void st_lld_start_alarm(systime_t time) {
 
-  (void)time;
+  st_lld_alarm = time;
+  st_lld_alarm_active = true;
 }
 
 /**
@@ -96,6 +104,7 @@ static inline void st_lld_start_alarm(systime_t time) {
  */
 static inline void st_lld_stop_alarm(void) {
 
+  st_lld_alarm_active = false;
 }
 
 /**
@@ -107,7 +116,7 @@ static inline void st_lld_stop_alarm(void) {
  */
 static inline void st_lld_set_alarm(systime_t time) {
 
-  (void)time;
+  st_lld_alarm = time;
 }
 
 /**
@@ -119,7 +128,7 @@ static inline void st_lld_set_alarm(systime_t time) {
  */
 static inline systime_t st_lld_get_alarm(void) {
 
-  return (systime_t)0;
+  return st_lld_alarm;
 }
 
 /**
@@ -133,7 +142,7 @@ static inline systime_t st_lld_get_alarm(void) {
  */
 static inline bool st_lld_is_alarm_active(void) {
 
-  return false;
+  return st_lld_alarm_active;
 }
 
 #endif /* HAL_ST_LLD_H */
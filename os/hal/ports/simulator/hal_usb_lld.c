@@ -0,0 +1,615 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simulator/hal_usb_lld.c
+ * @brief   Simulator USB subsystem low level driver source.
+ * @details The simulated controller moves packets between the endpoints
+ *          and a simulated host represented by the callbacks in the driver
+ *          configuration. A frame is served on each system tick, in each
+ *          frame up to @p packets packets are transferred on each endpoint.
+ *          <br>
+ *          Endpoints are modeled as single buffered, when a transfer
+ *          completes the endpoint is idle until the next frame. Endpoints
+ *          having queued transfers are modeled as double buffered, the
+ *          next transfer continues in the same frame.
+ *
+ * @addtogroup SIM_USB
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+
+#if (HAL_USE_USB == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   USB1 driver identifier.
+ */
+#if (USE_SIM_USB1 == TRUE) || defined(__DOXYGEN__)
+USBDriver USBD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   EP0 state.
+ * @note    It is an union because IN and OUT endpoints are never used at the
+ *          same time for EP0.
+ */
+static union {
+  /**
+   * @brief   IN EP0 state.
+   */
+  USBInEndpointState in;
+  /**
+   * @brief   OUT EP0 state.
+   */
+  USBOutEndpointState out;
+} ep0_state;
+
+/**
+ * @brief   EP0 initialization structure.
+ */
+static const USBEndpointConfig ep0config = {
+  USB_EP_MODE_TYPE_CTRL,
+  _usb_ep0setup,
+  _usb_ep0in,
+  _usb_ep0out,
+  0x40,
+  0x40,
+  &ep0_state.in,
+  &ep0_state.out
+};
+
+/**
+ * @brief   Host requests pending on the simulated bus.
+ */
+static struct {
+  /**
+   * @brief   Bus reset requested.
+   */
+  bool                  reset;
+  /**
+   * @brief   Setup packet sent.
+   */
+  bool                  setup;
+  /**
+   * @brief   Setup packet data.
+   */
+  uint8_t               packet[8];
+} host_requests;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Tells if an endpoint continues in the same frame.
+ * @details An endpoint continues if the next transfer was already queued
+ *          when the current one completes.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] in        @p true for the IN endpoint
+ * @return              The endpoint buffering.
+ *
+ * @notapi
+ */
+static bool usb_lld_is_double_buffered(USBDriver *usbp, usbep_t ep, bool in) {
+
+#if USB_USE_QUEUES == TRUE
+  if (ep > 0U) {
+    usbxfer_t *xp;
+
+    if (in) {
+      xp = usbp->epc[ep]->in_state->xqueue;
+    }
+    else {
+      xp = usbp->epc[ep]->out_state->xqueue;
+    }
+    return (bool)((xp != NULL) && (xp->next != NULL));
+  }
+#else
+  (void)usbp;
+  (void)ep;
+  (void)in;
+#endif
+
+  return false;
+}
+
+/**
+ * @brief   Serves an IN endpoint for a frame.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+static void usb_lld_serve_in(USBDriver *usbp, usbep_t ep) {
+  uint32_t budget = usbp->config->packets;
+
+  while ((budget > 0U) && usbGetTransmitStatusI(usbp, ep) &&
+         ((usbp->in_stalled & (1U << ep)) == 0U)) {
+    const USBEndpointConfig *epcp = usbp->epc[ep];
+    USBInEndpointState *isp = epcp->in_state;
+    size_t n = isp->txsize - isp->txcnt;
+
+    if (n > epcp->in_maxsize) {
+      n = epcp->in_maxsize;
+    }
+    if (usbp->config->in_packet != NULL) {
+      usbp->config->in_packet(usbp, ep, isp->txbuf + isp->txcnt, n);
+    }
+    isp->txcnt += n;
+    budget--;
+
+    if (isp->txcnt >= isp->txsize) {
+      bool next = usb_lld_is_double_buffered(usbp, ep, true);
+
+      _usb_isr_invoke_in_cb(usbp, ep);
+      if (!next) {
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Serves an OUT endpoint for a frame.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+static void usb_lld_serve_out(USBDriver *usbp, usbep_t ep) {
+  uint8_t packet[USB_SIM_MAX_PACKET_SIZE];
+  uint32_t budget = usbp->config->packets;
+
+  while ((budget > 0U) && usbGetReceiveStatusI(usbp, ep) &&
+         ((usbp->out_stalled & (1U << ep)) == 0U)) {
+    const USBEndpointConfig *epcp = usbp->epc[ep];
+    USBOutEndpointState *osp = epcp->out_state;
+    size_t n = epcp->out_maxsize;
+
+    if ((usbp->config->out_packet == NULL) ||
+        !usbp->config->out_packet(usbp, ep, packet, &n)) {
+      /* NAK.*/
+      break;
+    }
+    budget--;
+
+    /* Excess data is discarded as a real controller would do.*/
+    if (n > osp->rxsize - osp->rxcnt) {
+      memcpy(osp->rxbuf + osp->rxcnt, packet, osp->rxsize - osp->rxcnt);
+      osp->rxcnt = osp->rxsize;
+    }
+    else {
+      if (n > 0U) {
+        memcpy(osp->rxbuf + osp->rxcnt, packet, n);
+      }
+      osp->rxcnt += n;
+    }
+
+    /* A short packet or a full buffer terminates the transfer.*/
+    if ((n < epcp->out_maxsize) || (osp->rxcnt >= osp->rxsize)) {
+      bool next = usb_lld_is_double_buffered(usbp, ep, false);
+
+      _usb_isr_invoke_out_cb(usbp, ep);
+      if (!next) {
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Serves the simulated bus.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The interrupt simulation result.
+ * @retval false        if nothing has been served.
+ * @retval true         if a bus event or a frame has been served.
+ *
+ * @notapi
+ */
+static bool usb_lld_serve(USBDriver *usbp) {
+  systime_t now;
+  usbep_t ep;
+
+  if (usbp->state == USB_STOP) {
+    return false;
+  }
+
+  if (host_requests.reset) {
+    host_requests.reset = false;
+    _usb_reset(usbp);
+    return true;
+  }
+
+  if (host_requests.setup && (usbp->epc[0] != NULL)) {
+    host_requests.setup = false;
+    memcpy(usbp->setup_packet, host_requests.packet, 8);
+    _usb_isr_invoke_setup_cb(usbp, 0);
+    return true;
+  }
+
+  now = osalOsGetSystemTimeX();
+  if (now == usbp->last) {
+    return false;
+  }
+  usbp->last = now;
+  usbp->frame = (uint16_t)((usbp->frame + 1U) & 0x7FFU);
+
+  if (usbp->state == USB_ACTIVE) {
+    _usb_isr_invoke_sof_cb(usbp);
+  }
+
+  for (ep = 0U; ep <= (usbep_t)USB_MAX_ENDPOINTS; ep++) {
+    if (usbp->epc[ep] != NULL) {
+      usb_lld_serve_in(usbp, ep);
+    }
+    if (usbp->epc[ep] != NULL) {
+      usb_lld_serve_out(usbp, ep);
+    }
+  }
+
+  return true;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers and threads.                                    */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level USB driver initialization.
+ *
+ * @notapi
+ */
+void usb_lld_init(void) {
+
+#if USE_SIM_USB1 == TRUE
+  /* Driver initialization.*/
+  usbObjectInit(&USBD1);
+#endif
+}
+
+/**
+ * @brief   Configures and activates the USB peripheral.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_start(USBDriver *usbp) {
+
+  osalDbgCheck(usbp->config->packets > 0U);
+
+  if (usbp->state == USB_STOP) {
+    usbp->in_stalled  = 0U;
+    usbp->out_stalled = 0U;
+    usbp->frame       = 0U;
+    usbp->last        = osalOsGetSystemTimeX();
+    host_requests.reset = false;
+    host_requests.setup = false;
+  }
+}
+
+/**
+ * @brief   Deactivates the USB peripheral.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_stop(USBDriver *usbp) {
+
+  (void)usbp;
+}
+
+/**
+ * @brief   USB low level reset routine.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_reset(USBDriver *usbp) {
+
+  usbp->in_stalled  = 0U;
+  usbp->out_stalled = 0U;
+
+  /* EP0 initialization.*/
+  usbp->epc[0] = &ep0config;
+  usb_lld_init_endpoint(usbp, 0);
+}
+
+/**
+ * @brief   Sets the USB address.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_set_address(USBDriver *usbp) {
+
+  (void)usbp;
+}
+
+/**
+ * @brief   Enables an endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_init_endpoint(USBDriver *usbp, usbep_t ep) {
+
+  osalDbgAssert((usbp->epc[ep]->in_maxsize <= USB_SIM_MAX_PACKET_SIZE) &&
+                (usbp->epc[ep]->out_maxsize <= USB_SIM_MAX_PACKET_SIZE),
+                "packet size not supported");
+
+  usbp->in_stalled  &= (uint16_t)~(1U << ep);
+  usbp->out_stalled &= (uint16_t)~(1U << ep);
+}
+
+/**
+ * @brief   Disables all the active endpoints except the endpoint zero.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_disable_endpoints(USBDriver *usbp) {
+
+  usbp->in_stalled  &= 1U;
+  usbp->out_stalled &= 1U;
+}
+
+/**
+ * @brief   Returns the status of an OUT endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The endpoint status.
+ * @retval EP_STATUS_DISABLED The endpoint is not active.
+ * @retval EP_STATUS_STALLED  The endpoint is stalled.
+ * @retval EP_STATUS_ACTIVE   The endpoint is active.
+ *
+ * @notapi
+ */
+usbepstatus_t usb_lld_get_status_out(USBDriver *usbp, usbep_t ep) {
+
+  if ((usbp->epc[ep] == NULL) || (usbp->epc[ep]->out_state == NULL)) {
+    return EP_STATUS_DISABLED;
+  }
+  if ((usbp->out_stalled & (1U << ep)) != 0U) {
+    return EP_STATUS_STALLED;
+  }
+  return EP_STATUS_ACTIVE;
+}
+
+/**
+ * @brief   Returns the status of an IN endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The endpoint status.
+ * @retval EP_STATUS_DISABLED The endpoint is not active.
+ * @retval EP_STATUS_STALLED  The endpoint is stalled.
+ * @retval EP_STATUS_ACTIVE   The endpoint is active.
+ *
+ * @notapi
+ */
+usbepstatus_t usb_lld_get_status_in(USBDriver *usbp, usbep_t ep) {
+
+  if ((usbp->epc[ep] == NULL) || (usbp->epc[ep]->in_state == NULL)) {
+    return EP_STATUS_DISABLED;
+  }
+  if ((usbp->in_stalled & (1U << ep)) != 0U) {
+    return EP_STATUS_STALLED;
+  }
+  return EP_STATUS_ACTIVE;
+}
+
+/**
+ * @brief   Reads a setup packet from the dedicated packet buffer.
+ * @details This function must be invoked in the context of the @p setup_cb
+ *          callback in order to read the received setup packet.
+ * @pre     In order to use this function the endpoint must have been
+ *          initialized as a control endpoint.
+ * @post    The endpoint is ready to accept another packet.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[out] buf      buffer where to copy the packet data
+ *
+ * @notapi
+ */
+void usb_lld_read_setup(USBDriver *usbp, usbep_t ep, uint8_t *buf) {
+
+  (void)ep;
+
+  /* A setup packet clears the EP0 stall condition.*/
+  usbp->in_stalled  &= (uint16_t)~1U;
+  usbp->out_stalled &= (uint16_t)~1U;
+  memcpy(buf, usbp->setup_packet, 8);
+}
+
+/**
+ * @brief   Starts a receive operation on an OUT endpoint.
+ * @note    Packets are moved when the next frame is served.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_start_out(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Starts a transmit operation on an IN endpoint.
+ * @note    Packets are moved when the next frame is served.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_start_in(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Brings an OUT endpoint in the stalled state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_stall_out(USBDriver *usbp, usbep_t ep) {
+
+  usbp->out_stalled |= (uint16_t)(1U << ep);
+}
+
+/**
+ * @brief   Brings an IN endpoint in the stalled state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_stall_in(USBDriver *usbp, usbep_t ep) {
+
+  usbp->in_stalled |= (uint16_t)(1U << ep);
+}
+
+/**
+ * @brief   Brings an OUT endpoint in the active state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_clear_out(USBDriver *usbp, usbep_t ep) {
+
+  usbp->out_stalled &= (uint16_t)~(1U << ep);
+}
+
+/**
+ * @brief   Brings an IN endpoint in the active state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_clear_in(USBDriver *usbp, usbep_t ep) {
+
+  usbp->in_stalled &= (uint16_t)~(1U << ep);
+}
+
+/**
+ * @brief   Simulated host bus reset.
+ * @details The reset is processed by the next interrupt simulation.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @api
+ */
+void usb_lld_sim_reset(USBDriver *usbp) {
+
+  (void)usbp;
+
+  osalSysLock();
+  host_requests.reset = true;
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Simulated host setup packet.
+ * @details The packet is processed by the next interrupt simulation, the
+ *          data and status stages go through the host packets callbacks
+ *          on the endpoint zero.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] setup     pointer to the 8 bytes setup packet
+ *
+ * @api
+ */
+void usb_lld_sim_setup(USBDriver *usbp, const uint8_t *setup) {
+
+  (void)usbp;
+
+  osalSysLock();
+  memcpy(host_requests.packet, setup, 8);
+  host_requests.setup = true;
+  osalSysUnlock();
+}
+
+/**
+ * @brief   USB interrupt simulation.
+ *
+ * @return              The interrupt simulation result.
+ * @retval false        if no interrupt has been served.
+ * @retval true         if an interrupt has been served.
+ *
+ * @notapi
+ */
+bool usb_lld_interrupt_pending(void) {
+  bool b = false;
+
+  OSAL_IRQ_PROLOGUE();
+
+#if USE_SIM_USB1 == TRUE
+  b = usb_lld_serve(&USBD1) || b;
+#endif
+
+  OSAL_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_USB == TRUE */
+
+/** @} */
@@ -81,10 +81,49 @@ void _sim_check_for_interrupts(void) {
   }
 #endif
 
+#if HAL_USE_ADC
+  if (adc_lld_interrupt_pending()) {
+    _dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    _dbg_check_unlock();
+    return;
+  }
+#endif
+
+#if HAL_USE_QSPI
+  /* No return here, a device polled continuously through the QSPI must
+     not starve the system tick.*/
+  if (qspi_lld_interrupt_pending()) {
+    _dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    _dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_USB
+  if (usb_lld_interrupt_pending()) {
+    _dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    _dbg_check_unlock();
+    return;
+  }
+#endif
+
   gettimeofday(&tv, NULL);
   if (timercmp(&tv, &nextcnt, >=)) {
     timeradd(&nextcnt, &tick, &nextcnt);
 
+#if OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+    /* In free running mode the interrupt is only triggered by an alarm
+       match.*/
+    if (!st_lld_increase_counter()) {
+      return;
+    }
+#endif
+
     CH_IRQ_PROLOGUE();
 
     chSysLockFromISR();
@@ -2,8 +2,11 @@
 PLATFORMSRC = ${CHIBIOS}/os/hal/ports/simulator/win32/hal_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/win32/hal_serial_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/console.c \
+              ${CHIBIOS}/os/hal/ports/simulator/hal_adc_lld.c \
               ${CHIBIOS}/os/hal/ports/simulator/hal_pal_lld.c \
-              ${CHIBIOS}/os/hal/ports/simulator/hal_st_lld.c
+              ${CHIBIOS}/os/hal/ports/simulator/hal_qspi_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/hal_st_lld.c \
+              ${CHIBIOS}/os/hal/ports/simulator/hal_usb_lld.c
 
 # Required include directories
 PLATFORMINC = ${CHIBIOS}/os/hal/ports/simulator/win32 \
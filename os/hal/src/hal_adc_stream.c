@@ -0,0 +1,348 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_adc_stream.c
+ * @brief   ADC streaming layer code.
+ *
+ * @addtogroup ADC_STREAM
+ * @details The streaming layer runs an ADC circular conversion and exposes
+ *          the DMA buffer as a ring of blocks, each block is one half of
+ *          the buffer. Readers acquire completed blocks, process samples
+ *          in place and then release the blocks, no copy is involved.<br>
+ *          Blocks are identified by a monotonic sequence number, each
+ *          reader has its own cursor so any number of readers can consume
+ *          the same stream at different paces.<br>
+ *          The DMA cannot be held back so a block is valid only until the
+ *          converter wraps over it, a reader falling behind skips the lost
+ *          blocks on acquire and is notified on release if the block has
+ *          been overwritten while being processed.
+ * @{
+ */
+
+#include "hal.h"
+
+#if ((HAL_USE_ADC == TRUE) && (ADC_USE_STREAMING == TRUE)) ||               \
+    defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Verifies if a block is still present in the DMA buffer.
+ *
+ * @param[in] asp       pointer to the @p adc_stream_t object
+ * @param[in] w         snapshot of the stream write sequence
+ * @param[in] seq       sequence number of the block
+ * @return              The block state.
+ * @retval false        if the block has been overwritten or belongs to
+ *                      a previous run of the stream.
+ * @retval true         if the block is intact.
+ *
+ * @notapi
+ */
+static bool adcs_is_block_valid(adc_stream_t *asp,
+                                adcsseq_t w,
+                                adcsseq_t seq) {
+
+  return ((adcsseq_t)(w - seq) < ADC_STREAM_BLOCKS) &&
+         ((adcsseq_t)(w - seq) <= (adcsseq_t)(w - asp->bseq));
+}
+
+/**
+ * @brief   Stream block callback.
+ * @details Publishes the block just filled by the DMA then invokes the
+ *          application callback, if any.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] buffer    pointer to the block samples
+ * @param[in] n         number of rows in the block
+ */
+static void adcs_end_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+  adc_stream_t *asp = (adc_stream_t *)adcp->grpp;
+
+  osalDbgAssert(buffer == asp->samples +
+                          (((asp->wseq - asp->bseq) % ADC_STREAM_BLOCKS) *
+                           asp->bsize),
+                "out of sequence");
+
+  osalSysLockFromISR();
+  asp->wseq++;
+  osalThreadDequeueAllI(&asp->waiting, MSG_OK);
+  osalSysUnlockFromISR();
+
+  if (asp->end_cb != NULL) {
+    asp->end_cb(adcp, buffer, n);
+  }
+}
+
+/**
+ * @brief   Stream error callback.
+ * @details The driver already stopped the conversion, the stream is moved
+ *          in the stopped state and waiting readers are released.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] err       ADC error code
+ */
+static void adcs_error_cb(ADCDriver *adcp, adcerror_t err) {
+  adc_stream_t *asp = (adc_stream_t *)adcp->grpp;
+
+  osalSysLockFromISR();
+  asp->errors++;
+  asp->state = ADCS_STOP;
+  osalThreadDequeueAllI(&asp->waiting, MSG_RESET);
+  osalSysUnlockFromISR();
+
+  if (asp->error_cb != NULL) {
+    asp->error_cb(adcp, err);
+  }
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an ADC stream object.
+ *
+ * @param[out] asp      pointer to the @p adc_stream_t object
+ *
+ * @init
+ */
+void adcsObjectInit(adc_stream_t *asp) {
+
+  asp->state    = ADCS_STOP;
+  asp->adcp     = NULL;
+  asp->samples  = NULL;
+  asp->rows     = 0U;
+  asp->bsize    = 0U;
+  asp->wseq     = (adcsseq_t)0;
+  asp->bseq     = (adcsseq_t)0;
+  asp->errors   = 0U;
+  asp->end_cb   = NULL;
+  asp->error_cb = NULL;
+  osalThreadQueueObjectInit(&asp->waiting);
+}
+
+/**
+ * @brief   Starts streaming.
+ * @details A circular conversion is started on the specified driver using
+ *          a private copy of the conversion group, the group callbacks are
+ *          invoked after the stream processing of the related events.
+ * @pre     The ADC driver must have been started and no other conversion
+ *          must be running on it.
+ * @note    Blocks of a previous run not yet acquired by a reader are
+ *          silently discarded.
+ *
+ * @param[in] asp       pointer to the @p adc_stream_t object
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] grpp      pointer to a @p ADCConversionGroup object, the
+ *                      @p circular setting is ignored
+ * @param[out] samples  pointer to the DMA buffer
+ * @param[in] depth     buffer depth (matrix rows number), it must be an even
+ *                      number, each block is made of <tt>depth / 2</tt> rows
+ *
+ * @api
+ */
+void adcsStart(adc_stream_t *asp, ADCDriver *adcp,
+               const ADCConversionGroup *grpp,
+               adcsample_t *samples, size_t depth) {
+
+  osalDbgCheck((asp != NULL) && (adcp != NULL) && (grpp != NULL) &&
+               (samples != NULL) && (depth >= 2U) && ((depth & 1U) == 0U));
+
+  osalSysLock();
+  osalDbgAssert(asp->state == ADCS_STOP, "invalid state");
+
+  asp->grp          = *grpp;
+  asp->grp.circular = true;
+  asp->grp.end_cb   = adcs_end_cb;
+  asp->grp.error_cb = adcs_error_cb;
+  asp->end_cb       = grpp->end_cb;
+  asp->error_cb     = grpp->error_cb;
+  asp->adcp         = adcp;
+  asp->samples      = samples;
+  asp->rows         = depth / 2U;
+  asp->bsize        = asp->rows * (size_t)grpp->num_channels;
+  asp->bseq         = asp->wseq;
+  asp->state        = ADCS_ACTIVE;
+  adcStartConversionI(adcp, &asp->grp, samples, depth);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Stops streaming.
+ * @details The conversion is stopped and the readers waiting for a block
+ *          are released with a @p MSG_RESET message. Blocks already
+ *          completed are still available to readers.
+ *
+ * @param[in] asp       pointer to the @p adc_stream_t object
+ *
+ * @api
+ */
+void adcsStop(adc_stream_t *asp) {
+
+  osalDbgCheck(asp != NULL);
+
+  osalSysLock();
+  osalDbgAssert((asp->state == ADCS_STOP) || (asp->state == ADCS_ACTIVE),
+                "invalid state");
+  if (asp->state == ADCS_ACTIVE) {
+    adcStopConversionI(asp->adcp);
+    asp->state = ADCS_STOP;
+    osalThreadDequeueAllI(&asp->waiting, MSG_RESET);
+    osalOsRescheduleS();
+  }
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Initializes a stream reader.
+ * @details The reader cursor is positioned on the block currently being
+ *          filled, blocks already completed are not seen by the reader.
+ *
+ * @param[out] asrp     pointer to the @p adc_stream_reader_t object
+ * @param[in] asp       pointer to the @p adc_stream_t object
+ *
+ * @init
+ */
+void adcsReaderObjectInit(adc_stream_reader_t *asrp, adc_stream_t *asp) {
+
+  asrp->asp      = asp;
+  asrp->seq      = asp->wseq;
+  asrp->overruns = 0U;
+}
+
+/**
+ * @brief   Acquires the next block for a reader.
+ * @details If the next block is already available then no lock is taken,
+ *          else the reader waits for the block completion. If the reader
+ *          fell behind the converter then the lost blocks are skipped and
+ *          accounted as overruns.
+ * @post    The block must be released using @p adcsReleaseBlock() after
+ *          processing.
+ *
+ * @param[in] asrp      pointer to the @p adc_stream_reader_t object
+ * @param[out] bp       pointer to the descriptor of the acquired block
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a block has been acquired.
+ * @retval MSG_TIMEOUT  if the specified time expired.
+ * @retval MSG_RESET    if the stream has been stopped.
+ *
+ * @api
+ */
+msg_t adcsAcquireBlockTimeout(adc_stream_reader_t *asrp,
+                              adc_stream_block_t *bp,
+                              systime_t timeout) {
+  adc_stream_t *asp;
+  adcsseq_t w;
+
+  osalDbgCheck((asrp != NULL) && (bp != NULL));
+
+  asp = asrp->asp;
+
+  /* Fast path, the write sequence is a single word so it can be sampled
+     without locking.*/
+  w = asp->wseq;
+  if (w == asrp->seq) {
+    osalSysLock();
+    w = asp->wseq;
+    while (w == asrp->seq) {
+      msg_t msg;
+
+      if (asp->state != ADCS_ACTIVE) {
+        osalSysUnlock();
+        return MSG_RESET;
+      }
+      msg = osalThreadEnqueueTimeoutS(&asp->waiting, timeout);
+      if (msg != MSG_OK) {
+        osalSysUnlock();
+        return msg;
+      }
+      w = asp->wseq;
+    }
+    osalSysUnlock();
+  }
+
+  /* Blocks belonging to a previous run are discarded, blocks already
+     overwritten by the DMA are accounted as overruns.*/
+  if ((adcsseq_t)(w - asrp->seq) > (adcsseq_t)(w - asp->bseq)) {
+    asrp->seq = asp->bseq;
+  }
+  if ((adcsseq_t)(w - asrp->seq) >= ADC_STREAM_BLOCKS) {
+    adcsseq_t oldest = w - (ADC_STREAM_BLOCKS - 1U);
+
+    asrp->overruns += (uint32_t)(oldest - asrp->seq);
+    asrp->seq = oldest;
+  }
+
+  bp->seq     = asrp->seq;
+  bp->n       = asp->rows;
+  bp->samples = asp->samples +
+                (((bp->seq - asp->bseq) % ADC_STREAM_BLOCKS) * asp->bsize);
+  asrp->seq++;
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Releases a block.
+ * @details Verifies that the block has not been overwritten while it was
+ *          being processed.
+ *
+ * @param[in] asrp      pointer to the @p adc_stream_reader_t object
+ * @param[in] bp        pointer to the descriptor of the released block
+ * @return              The block integrity.
+ * @retval HAL_SUCCESS  if the block content was intact.
+ * @retval HAL_FAILED   if the converter wrapped over the block before its
+ *                      release, the overrun is accounted to the reader.
+ *
+ * @api
+ */
+bool adcsReleaseBlock(adc_stream_reader_t *asrp,
+                      const adc_stream_block_t *bp) {
+
+  osalDbgCheck((asrp != NULL) && (bp != NULL));
+
+  if (adcs_is_block_valid(asrp->asp, asrp->asp->wseq, bp->seq)) {
+    return HAL_SUCCESS;
+  }
+
+  asrp->overruns++;
+  return HAL_FAILED;
+}
+
+#endif /* (HAL_USE_ADC == TRUE) && (ADC_USE_STREAMING == TRUE) */
+
+/** @} */
@@ -351,6 +351,72 @@ void qspiUnmapFlash(QSPIDriver *qspip) {
 }
 #endif /* QSPI_SUPPORTS_MEMMAP == TRUE */
 
+#if (QSPI_SUPPORTS_AUTOPOLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Polls a status byte until it matches.
+ * @details The command is repeated by the hardware until the received
+ *          status byte masked by @p mask is equal to @p match, the CPU is
+ *          not involved while polling.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @api
+ */
+void qspiStartAutoPoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                       uint8_t mask, uint8_t match) {
+
+  osalDbgCheck((qspip != NULL) && (cmdp != NULL));
+
+  osalSysLock();
+
+  osalDbgAssert(qspip->state == QSPI_READY, "not ready");
+
+  qspiStartAutoPollI(qspip, cmdp, mask, match);
+
+  osalSysUnlock();
+}
+
+#if (QSPI_USE_WAIT == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Polls a status byte until it matches.
+ * @details The command is repeated by the hardware until the received
+ *          status byte masked by @p mask is equal to @p match, the
+ *          invoking thread is suspended meanwhile.
+ * @pre     In order to use this function the option @p QSPI_USE_WAIT must be
+ *          enabled.
+ * @pre     In order to use this function the driver must have been configured
+ *          without callbacks (@p end_cb = @p NULL).
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @api
+ */
+void qspiAutoPoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                  uint8_t mask, uint8_t match) {
+
+  osalDbgCheck((qspip != NULL) && (cmdp != NULL));
+  osalDbgCheck((cmdp->cfg & QSPI_CFG_DATA_MODE_MASK) != QSPI_CFG_DATA_MODE_NONE);
+
+  osalSysLock();
+
+  osalDbgAssert(qspip->state == QSPI_READY, "not ready");
+  osalDbgAssert(qspip->config->end_cb == NULL, "has callback");
+
+  qspiStartAutoPollI(qspip, cmdp, mask, match);
+  (void) osalThreadSuspendS(&qspip->thread);
+
+  osalSysUnlock();
+}
+#endif /* QSPI_USE_WAIT == TRUE */
+#endif /* QSPI_SUPPORTS_AUTOPOLL == TRUE */
+
 #if (QSPI_USE_MUTUAL_EXCLUSION == TRUE) || defined(__DOXYGEN__)
 /**
  * @brief   Gains exclusive access to the QSPI bus.
@@ -0,0 +1,434 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_uart_framer.c
+ * @brief   UART framed receive layer code.
+ *
+ * @addtogroup UART_FRAMER
+ * @details The framer keeps the UART receiver continuously active, data is
+ *          received by DMA directly into the buffers of an input buffers
+ *          queue, each buffer holds exactly one frame. Frames are closed
+ *          by an idle line condition and/or by a delimiter byte, complete
+ *          frames are posted in the queue and consumed in place by the
+ *          application.<br>
+ *          Received data is only inspected on idle and buffer-full events
+ *          so there is no per-character interrupt load.
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+
+#if ((HAL_USE_UART == TRUE) && (UART_USE_FRAMING == TRUE)) ||               \
+    defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the data area of a frame buffer.
+ */
+#define ufr_buffer_size(ufp) ((ufp)->ibq.bsize - sizeof (size_t))
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Restarts reception after the data already in the buffer.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ *
+ * @notapi
+ */
+static void ufr_start_receive(uart_framer_t *ufp) {
+
+  uartStartReceiveI(ufp->uartp, ufr_buffer_size(ufp) - ufp->rxn,
+                    ufp->rxbuf + ufp->rxn);
+}
+
+/**
+ * @brief   Closes the current frame.
+ * @details The frame is posted in the queue and a new buffer is fetched, if
+ *          there are no free buffers the framer goes in stalled state.
+ *          Frames being discarded, frames exceeding the maximum size and
+ *          empty frames are dropped and the current buffer is reused.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ * @param[in] n         size of the frame
+ *
+ * @notapi
+ */
+static void ufr_close_frame(uart_framer_t *ufp, size_t n) {
+
+  if (ufp->discard) {
+    ufp->discard = false;
+    return;
+  }
+
+  if (n > ufp->size) {
+    ufp->overflows++;
+    return;
+  }
+
+  if (n > 0U) {
+    ibqPostFullBufferI(&ufp->ibq, n);
+    ufp->frames++;
+    ufp->rxbuf = ibqGetEmptyBufferI(&ufp->ibq);
+    if (ufp->rxbuf == NULL) {
+      ufp->state = UFR_STALLED;
+    }
+  }
+}
+
+/**
+ * @brief   Scans the received data for delimiters.
+ * @details Frames terminated by a delimiter are closed, the bytes following
+ *          the delimiter are moved at the beginning of the next buffer.
+ * @post    The field @p rxn contains the number of bytes of the frame
+ *          still open.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ * @param[in] n         number of valid bytes in the current buffer
+ *
+ * @notapi
+ */
+static void ufr_scan(uart_framer_t *ufp, size_t n) {
+  size_t i = ufp->rxn;
+
+  if ((ufp->frcfg->mode & UART_FRAMER_DELIMITER) != 0U) {
+    while (i < n) {
+      if (ufp->rxbuf[i] == ufp->frcfg->delimiter) {
+        uint8_t *p = ufp->rxbuf;
+
+        ufr_close_frame(ufp, i);
+        n = n - i - 1U;
+        if (ufp->rxbuf == NULL) {
+          /* Stalled, the data following the delimiter is lost.*/
+          n = 0U;
+          break;
+        }
+        (void) memmove(ufp->rxbuf, p + i + 1U, n);
+        i = 0U;
+      }
+      else {
+        i++;
+      }
+    }
+  }
+
+  ufp->rxn = n;
+}
+
+/**
+ * @brief   Checks the frame being received for overflow.
+ * @details A frame exceeding the maximum size is discarded up to its end.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ *
+ * @notapi
+ */
+static void ufr_check_overflow(uart_framer_t *ufp) {
+
+  if (ufp->rxn > ufp->size) {
+    if (!ufp->discard) {
+      ufp->overflows++;
+      ufp->discard = true;
+    }
+    ufp->rxn = 0U;
+  }
+}
+
+/**
+ * @brief   Buffer full callback.
+ * @details If the buffer does not contain a delimiter then the frame is
+ *          too large, it is discarded up to its end.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ */
+static void ufr_rxend_cb(UARTDriver *uartp) {
+  uart_framer_t *ufp = (uart_framer_t *)uartp->config;
+
+  osalSysLockFromISR();
+  ufr_scan(ufp, ufr_buffer_size(ufp));
+  if (ufp->rxbuf != NULL) {
+    ufr_check_overflow(ufp);
+    ufr_start_receive(ufp);
+  }
+  osalSysUnlockFromISR();
+}
+
+/**
+ * @brief   Receive error callback.
+ * @details The frame being received is discarded.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @param[in] e         receive error mask
+ */
+static void ufr_rxerr_cb(UARTDriver *uartp, uartflags_t e) {
+  uart_framer_t *ufp = (uart_framer_t *)uartp->config;
+
+  osalSysLockFromISR();
+  ufp->discard = true;
+  osalSysUnlockFromISR();
+
+  if (ufp->rxerr_cb != NULL) {
+    ufp->rxerr_cb(uartp, e);
+  }
+}
+
+#if (UART_SUPPORTS_TIMEOUT == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Receiver idle or timeout callback.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ */
+static void ufr_timeout_cb(UARTDriver *uartp) {
+
+  osalSysLockFromISR();
+  ufrIdleI((uart_framer_t *)uartp->config);
+  osalSysUnlockFromISR();
+}
+#endif
+
+/**
+ * @brief   Buffer released notification.
+ * @details A stalled framer restarts reception, the frame possibly being
+ *          received meanwhile is incomplete so it is discarded.
+ *
+ * @param[in] bqp       pointer to the @p io_buffers_queue_t object
+ */
+static void ufr_notify(io_buffers_queue_t *bqp) {
+  uart_framer_t *ufp = (uart_framer_t *)bqGetLinkX(bqp);
+
+  if (ufp->state == UFR_STALLED) {
+    ufp->rxbuf   = ibqGetEmptyBufferI(bqp);
+    ufp->rxn     = 0U;
+    ufp->discard = true;
+    ufp->overruns++;
+    ufp->state   = UFR_READY;
+    ufr_start_receive(ufp);
+  }
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an UART framer object.
+ *
+ * @param[out] ufp      pointer to the @p uart_framer_t object
+ * @param[in] bp        pointer to a memory area allocated for buffers, its
+ *                      size must be <tt>UFR_BUFFERS_SIZE(n, size)</tt>
+ * @param[in] size      maximum frame size
+ * @param[in] n         number of frame buffers
+ *
+ * @init
+ */
+void ufrObjectInit(uart_framer_t *ufp, uint8_t *bp, size_t size, size_t n) {
+
+  ufp->state     = UFR_STOP;
+  ufp->uartp     = NULL;
+  ufp->frcfg     = NULL;
+  ufp->rxbuf     = NULL;
+  ufp->rxn       = 0U;
+  ufp->discard   = false;
+  ufp->frames    = 0U;
+  ufp->overruns  = 0U;
+  ufp->overflows = 0U;
+  ufp->rxerr_cb  = NULL;
+  ufp->size      = size;
+  ibqObjectInit(&ufp->ibq, true, bp, UFR_BUFFER_SIZE(size), n,
+                ufr_notify, (void *)ufp);
+}
+
+/**
+ * @brief   Starts the UART driver in framed receive mode.
+ * @details The driver is started using a private copy of the specified
+ *          configuration, the receive callbacks are owned by the framer,
+ *          the receive error callback is invoked after the framer
+ *          processing.
+ * @note    The framer only supports data sizes up to 8 bits.
+ * @note    On low level drivers not supporting the receiver timeout the
+ *          idle condition must be signaled using @p ufrIdleI().
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @param[in] config    pointer to the @p UARTConfig object
+ * @param[in] frcfg     pointer to the @p uart_framer_config_t object
+ *
+ * @api
+ */
+void ufrStart(uart_framer_t *ufp, UARTDriver *uartp,
+              const UARTConfig *config, const uart_framer_config_t *frcfg) {
+
+  osalDbgCheck((ufp != NULL) && (uartp != NULL) &&
+               (config != NULL) && (frcfg != NULL) &&
+               ((frcfg->mode & (UART_FRAMER_IDLE | UART_FRAMER_DELIMITER)) != 0U));
+  osalDbgAssert(ufp->state == UFR_STOP, "invalid state");
+
+  ufp->config           = *config;
+  ufp->config.rxend_cb  = ufr_rxend_cb;
+  ufp->config.rxchar_cb = NULL;
+  ufp->config.rxerr_cb  = ufr_rxerr_cb;
+#if UART_SUPPORTS_TIMEOUT == TRUE
+  ufp->config.timeout_cb = ufr_timeout_cb;
+#endif
+  ufp->rxerr_cb         = config->rxerr_cb;
+  ufp->uartp            = uartp;
+  ufp->frcfg            = frcfg;
+
+  uartStart(uartp, &ufp->config);
+
+  osalSysLock();
+  ibqResetI(&ufp->ibq);
+  bqResumeX(&ufp->ibq);
+  ufp->rxbuf   = ibqGetEmptyBufferI(&ufp->ibq);
+  ufp->rxn     = 0U;
+  ufp->discard = false;
+  ufp->state   = UFR_READY;
+  ufr_start_receive(ufp);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Stops the framer and the associated UART driver.
+ * @details Threads waiting for a frame are released with a @p MSG_RESET
+ *          message, frames already in the queue are lost.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ *
+ * @api
+ */
+void ufrStop(uart_framer_t *ufp) {
+
+  osalDbgCheck(ufp != NULL);
+
+  osalSysLock();
+  osalDbgAssert(ufp->state != UFR_UNINIT, "invalid state");
+  if (ufp->state != UFR_STOP) {
+    (void) uartStopReceiveI(ufp->uartp);
+    ufp->state = UFR_STOP;
+    ufp->rxbuf = NULL;
+    bqSuspendI(&ufp->ibq);
+    osalOsRescheduleS();
+  }
+  osalSysUnlock();
+
+  uartStop(ufp->uartp);
+}
+
+/**
+ * @brief   Signals an idle line condition.
+ * @details Received data is processed and, in @p UART_FRAMER_IDLE mode, the
+ *          current frame is closed. This function is invoked from the
+ *          receiver timeout callback on drivers supporting it, else it can
+ *          be invoked by the application, for example from a timer
+ *          measuring the gap between characters.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ *
+ * @iclass
+ */
+void ufrIdleI(uart_framer_t *ufp) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck(ufp != NULL);
+
+  if (ufp->state == UFR_READY) {
+    size_t n = ufr_buffer_size(ufp) - uartStopReceiveI(ufp->uartp);
+
+    ufr_scan(ufp, n);
+    if (ufp->rxbuf != NULL) {
+      /* The buffer could have been filled before the buffer full
+         callback has been served.*/
+      ufr_check_overflow(ufp);
+      if ((ufp->frcfg->mode & UART_FRAMER_IDLE) != 0U) {
+        ufr_close_frame(ufp, ufp->rxn);
+        ufp->rxn = 0U;
+      }
+    }
+    if (ufp->rxbuf != NULL) {
+      ufr_start_receive(ufp);
+    }
+  }
+}
+
+/**
+ * @brief   Gets the next received frame.
+ * @note    The function always returns the same frame if called repeatedly.
+ * @post    The frame must be released using @p ufrReleaseFrame() after
+ *          processing.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ * @param[out] fpp      pointer to a variable receiving the frame address
+ * @param[out] np       pointer to a variable receiving the frame size
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if a frame has been acquired.
+ * @retval MSG_TIMEOUT  if the specified time expired.
+ * @retval MSG_RESET    if the framer has been stopped.
+ *
+ * @api
+ */
+msg_t ufrGetFrameTimeout(uart_framer_t *ufp, uint8_t **fpp, size_t *np,
+                         systime_t timeout) {
+  msg_t msg;
+
+  osalDbgCheck((ufp != NULL) && (fpp != NULL) && (np != NULL));
+
+  msg = ibqGetFullBufferTimeout(&ufp->ibq, timeout);
+  if (msg == MSG_OK) {
+    *fpp = ufp->ibq.ptr;
+    *np  = (size_t)(ufp->ibq.top - ufp->ibq.ptr);
+  }
+
+  return msg;
+}
+
+/**
+ * @brief   Releases the current frame buffer.
+ *
+ * @param[in] ufp       pointer to the @p uart_framer_t object
+ *
+ * @api
+ */
+void ufrReleaseFrame(uart_framer_t *ufp) {
+
+  osalDbgCheck(ufp != NULL);
+
+  ibqReleaseEmptyBuffer(&ufp->ibq);
+}
+
+#endif /* (HAL_USE_UART == TRUE) && (UART_USE_FRAMING == TRUE) */
+
+/** @} */
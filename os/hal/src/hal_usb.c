@@ -511,6 +511,98 @@ void usbStartTransmitI(USBDriver *usbp, usbep_t ep,
   usb_lld_start_in(usbp, ep);
 }
 
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Queues a receive transfer on an OUT endpoint.
+ * @details The transfer is started immediately if the endpoint queue is
+ *          empty, else it is started as soon as the previous transfers
+ *          complete. Completions are notified in queuing order.
+ * @pre     The endpoint must not be used with @p usbStartReceiveI() while
+ *          transfers are queued.
+ * @note    Queued transfers are discarded on USB reset or when the
+ *          endpoints are disabled, the application is notified by the
+ *          USB events.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] xp        pointer to the transfer descriptor, it must not be
+ *                      modified until its completion
+ *
+ * @iclass
+ */
+void usbQueueReceiveI(USBDriver *usbp, usbep_t ep, usbxfer_t *xp) {
+  USBOutEndpointState *osp;
+
+  osalDbgCheckClassI();
+  osalDbgCheck((usbp != NULL) && (ep <= (usbep_t)USB_MAX_ENDPOINTS) &&
+               (xp != NULL));
+
+  /*lint -save -e661 [18.1] pclint is confused by the check on ep.*/
+  osp = usbp->epc[ep]->out_state;
+  /*lint -restore*/
+  xp->next = NULL;
+  xp->size = 0;
+
+  if (osp->xqueue == NULL) {
+    osp->xqueue = xp;
+    usbStartReceiveI(usbp, ep, xp->buf, xp->n);
+  }
+  else {
+    usbxfer_t *p = osp->xqueue;
+
+    while (p->next != NULL) {
+      p = p->next;
+    }
+    p->next = xp;
+  }
+}
+
+/**
+ * @brief   Queues a transmit transfer on an IN endpoint.
+ * @details The transfer is started immediately if the endpoint queue is
+ *          empty, else it is started as soon as the previous transfers
+ *          complete. Completions are notified in queuing order.
+ * @pre     The endpoint must not be used with @p usbStartTransmitI() while
+ *          transfers are queued.
+ * @note    Queued transfers are discarded on USB reset or when the
+ *          endpoints are disabled, the application is notified by the
+ *          USB events.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] xp        pointer to the transfer descriptor, it must not be
+ *                      modified until its completion
+ *
+ * @iclass
+ */
+void usbQueueTransmitI(USBDriver *usbp, usbep_t ep, usbxfer_t *xp) {
+  USBInEndpointState *isp;
+
+  osalDbgCheckClassI();
+  osalDbgCheck((usbp != NULL) && (ep <= (usbep_t)USB_MAX_ENDPOINTS) &&
+               (xp != NULL));
+
+  /*lint -save -e661 [18.1] pclint is confused by the check on ep.*/
+  isp = usbp->epc[ep]->in_state;
+  /*lint -restore*/
+  xp->next = NULL;
+  xp->size = 0;
+
+  if (isp->xqueue == NULL) {
+    isp->xqueue = xp;
+    usbStartTransmitI(usbp, ep, xp->buf, xp->n);
+  }
+  else {
+    usbxfer_t *p = isp->xqueue;
+
+    while (p->next != NULL) {
+      p = p->next;
+    }
+    p->next = xp;
+  }
+}
+#endif /* USB_USE_QUEUES == TRUE */
+
 #if (USB_USE_WAIT == TRUE) || defined(__DOXYGEN__)
 /**
  * @brief   Performs a receive transaction on an OUT endpoint.
@@ -962,6 +1054,74 @@ void _usb_ep0out(USBDriver *usbp, usbep_t ep) {
   }
 }
 
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Queued IN transfer completion.
+ * @details The next queued transfer is started before notifying the
+ *          completed one, this way the endpoint is re-armed without
+ *          waiting for the callbacks processing.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void _usb_xfer_in_done(USBDriver *usbp, usbep_t ep) {
+  USBInEndpointState *isp = usbp->epc[ep]->in_state;
+  usbxfer_t *xp = isp->xqueue;
+
+  if (xp == NULL) {
+    return;
+  }
+
+  xp->size = isp->txsize;
+
+  osalSysLockFromISR();
+  isp->xqueue = xp->next;
+  if (isp->xqueue != NULL) {
+    usbStartTransmitI(usbp, ep, isp->xqueue->buf, isp->xqueue->n);
+  }
+  osalSysUnlockFromISR();
+
+  if (xp->cb != NULL) {
+    xp->cb(usbp, ep, xp);
+  }
+}
+
+/**
+ * @brief   Queued OUT transfer completion.
+ * @details The next queued transfer is started before notifying the
+ *          completed one, this way the endpoint is re-armed without
+ *          waiting for the callbacks processing.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void _usb_xfer_out_done(USBDriver *usbp, usbep_t ep) {
+  USBOutEndpointState *osp = usbp->epc[ep]->out_state;
+  usbxfer_t *xp = osp->xqueue;
+
+  if (xp == NULL) {
+    return;
+  }
+
+  xp->size = usbGetReceiveTransactionSizeX(usbp, ep);
+
+  osalSysLockFromISR();
+  osp->xqueue = xp->next;
+  if (osp->xqueue != NULL) {
+    usbStartReceiveI(usbp, ep, osp->xqueue->buf, osp->xqueue->n);
+  }
+  osalSysUnlockFromISR();
+
+  if (xp->cb != NULL) {
+    xp->cb(usbp, ep, xp);
+  }
+}
+#endif /* USB_USE_QUEUES == TRUE */
+
 #endif /* HAL_USE_USB == TRUE */
 
 /** @} */
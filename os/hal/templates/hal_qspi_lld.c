@@ -203,6 +203,28 @@ void qspi_lld_unmap_flash(QSPIDriver *qspip) {
 }
 #endif /* QSPI_SUPPORTS_MEMMAP == TRUE */
 
+#if (QSPI_SUPPORTS_AUTOPOLL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Polls a status byte until it matches.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] qspip     pointer to the @p QSPIDriver object
+ * @param[in] cmdp      pointer to the command descriptor
+ * @param[in] mask      mask of the status bits to be checked
+ * @param[in] match     expected value of the masked status bits
+ *
+ * @notapi
+ */
+void qspi_lld_autopoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                       uint8_t mask, uint8_t match) {
+
+  (void)qspip;
+  (void)cmdp;
+  (void)mask;
+  (void)match;
+}
+#endif /* QSPI_SUPPORTS_AUTOPOLL == TRUE */
+
 #endif /* HAL_USE_QSPI */
 
 /** @} */
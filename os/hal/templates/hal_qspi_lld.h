@@ -36,6 +36,7 @@
  * @{
  */
 #define QSPI_SUPPORTS_MEMMAP                TRUE
+#define QSPI_SUPPORTS_AUTOPOLL              TRUE
 /** @} */
 
 /*===========================================================================*/
@@ -147,6 +148,10 @@ extern "C" {
                           uint8_t **addrp);
   void qspi_lld_unmap_flash(QSPIDriver *qspip);
 #endif
+#if QSPI_SUPPORTS_AUTOPOLL == TRUE
+  void qspi_lld_autopoll(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                         uint8_t mask, uint8_t match);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -98,6 +98,12 @@ typedef struct {
    * @brief   Waiting thread.
    */
   thread_reference_t            thread;
+#endif
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Queued transfers, the first one is in progress.
+   */
+  usbxfer_t                     *xqueue;
 #endif
     /* End of the mandatory fields.*/
 } USBInEndpointState;
@@ -123,6 +129,12 @@ typedef struct {
    * @brief   Waiting thread.
    */
   thread_reference_t            thread;
+#endif
+#if (USB_USE_QUEUES == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Queued transfers, the first one is in progress.
+   */
+  usbxfer_t                     *xqueue;
 #endif
   /* End of the mandatory fields.*/
 } USBOutEndpointState;
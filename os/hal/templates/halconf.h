@@ -203,6 +203,14 @@
 #if !defined(ADC_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
 #define ADC_USE_MUTUAL_EXCLUSION    TRUE
 #endif
+
+/**
+ * @brief   Enables the zero-copy streaming layer.
+ * @note    Disabling this option saves both code and data space.
+ */
+#if !defined(ADC_USE_STREAMING) || defined(__DOXYGEN__)
+#define ADC_USE_STREAMING           FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -413,6 +421,14 @@
 #if !defined(UART_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
 #define UART_USE_MUTUAL_EXCLUSION   TRUE
 #endif
+
+/**
+ * @brief   Enables the framed receive layer.
+ * @note    Disabling this option saves both code and data space.
+ */
+#if !defined(UART_USE_FRAMING) || defined(__DOXYGEN__)
+#define UART_USE_FRAMING            FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -429,6 +445,13 @@
 #if !defined(USB_USE_WAIT) || defined(__DOXYGEN__)
 #define USB_USE_WAIT                TRUE
 #endif
+
+/**
+ * @brief   Enables the transfers queues APIs.
+ */
+#if !defined(USB_USE_QUEUES) || defined(__DOXYGEN__)
+#define USB_USE_QUEUES              FALSE
+#endif
 /** @} */
 
 #endif /* HALCONF_H */
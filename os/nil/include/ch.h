@@ -221,6 +221,29 @@
 #define CH_CFG_USE_MAILBOXES                TRUE
 #endif
 
+/**
+ * @brief   Sequence locks APIs.
+ * @details If enabled then the sequence locks APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ */
+#if !defined(CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+#define CH_CFG_USE_SEQLOCKS                 TRUE
+#endif
+
+/**
+ * @brief   Sequence locks objects size limit.
+ * @details Maximum size in bytes of the objects copied under a sequence
+ *          lock by @p chSeqReadObjectX() and @p chSeqWriteObjectI().
+ *
+ * @note    The default is 32.
+ * @note    Requires @p CH_CFG_USE_SEQLOCKS.
+ */
+#if !defined(CH_CFG_SEQLOCKS_MAX_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_SEQLOCKS_MAX_SIZE            32
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -1432,6 +1455,7 @@ extern "C" {
 #include "chmemcore.h"
 #include "chmempools.h"
 #include "chheap.h"
+#include "chseqlock.h"
 
 #endif /* CH_H */
 
@@ -87,6 +87,7 @@
 #include "chsys.h"
 #include "chvt.h"
 #include "chthreads.h"
+#include "chedf.h"
 
 /* Optional subsystems headers.*/
 #include "chregistry.h"
@@ -94,12 +95,16 @@
 #include "chbsem.h"
 #include "chmtx.h"
 #include "chcond.h"
+#include "chrwlock.h"
 #include "chevents.h"
 #include "chmsg.h"
 #include "chmboxes.h"
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
+#include "chseqlock.h"
+#include "chworkq.h"
+#include "chctasks.h"
 #include "chdynamic.h"
 
 #if !defined(_CHIBIOS_RT_CONF_)
@@ -37,6 +37,59 @@
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+/* Configuration file checks.*/
+#if !defined(CH_CFG_USE_RWLOCKS)
+#error "CH_CFG_USE_RWLOCKS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_RWLOCKS_NESTING)
+#error "CH_CFG_RWLOCKS_NESTING not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_SEQLOCKS)
+#error "CH_CFG_USE_SEQLOCKS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_SEQLOCKS_MAX_SIZE)
+#error "CH_CFG_SEQLOCKS_MAX_SIZE not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_WORKQUEUES)
+#error "CH_CFG_USE_WORKQUEUES not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_WORKQ_WORKERS)
+#error "CH_CFG_WORKQ_WORKERS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_WORKQ_WA_SIZE)
+#error "CH_CFG_WORKQ_WA_SIZE not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_WORKQ_PRIO)
+#error "CH_CFG_WORKQ_PRIO not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_CTASKS)
+#error "CH_CFG_USE_CTASKS not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_USE_EDF)
+#error "CH_CFG_USE_EDF not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_EDF_PRIO)
+#error "CH_CFG_EDF_PRIO not defined in chconf.h"
+#endif
+
+#if !defined(CH_CFG_REGISTRY_HASH_SIZE)
+#error "CH_CFG_REGISTRY_HASH_SIZE not defined in chconf.h"
+#endif
+
+#if !defined(CH_DBG_ENABLE_INTEGRITY_STEPS)
+#error "CH_DBG_ENABLE_INTEGRITY_STEPS not defined in chconf.h"
+#endif
+
 #if CH_CUSTOMER_LIC_RT == FALSE
 #error "ChibiOS/RT not licensed"
 #endif
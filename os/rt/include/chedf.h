@@ -0,0 +1,127 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chedf.h
+ * @brief   EDF scheduling class macros and structures.
+ *
+ * @addtogroup edf
+ * @{
+ */
+
+#ifndef CHEDF_H
+#define CHEDF_H
+
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Load value representing the whole CPU time.
+ */
+#define EDF_FULL_LOAD       ((edf_load_t)0x10000U)
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of the EDF parameters of a thread.
+ * @note    All the values are expressed in system ticks and cannot exceed
+ *          half of the system time range.
+ */
+typedef struct {
+  systime_t             period;     /**< @brief Activation period.          */
+  systime_t             deadline;   /**< @brief Deadline relative to the
+                                                activation.                 */
+  systime_t             budget;     /**< @brief Worst case execution time
+                                                of a job.                   */
+} edf_params_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _edf_init(void);
+  void _edf_leave(thread_t *tp);
+  edf_load_t chEDFComputeLoadX(const edf_params_t *pp);
+  bool chEDFIsSchedulableX(const edf_params_t *pp, unsigned n);
+  edf_load_t chEDFGetLoadX(void);
+  ucnt_t chEDFGetMissesX(void);
+  bool chEDFEnterI(thread_t *tp, const edf_params_t *pp);
+  bool chEDFEnter(const edf_params_t *pp);
+  void chEDFLeave(void);
+  bool chEDFWaitNextPeriod(void);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns @p true if a thread is part of the EDF class.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The thread class.
+ *
+ * @xclass
+ */
+static inline bool chEDFIsThreadX(thread_t *tp) {
+
+  return (bool)(tp->edf.period > (systime_t)0);
+}
+
+/**
+ * @brief   Returns the absolute deadline of the current job of a thread.
+ * @pre     The thread must be part of the EDF class.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The deadline as system time.
+ *
+ * @xclass
+ */
+static inline systime_t chEDFGetDeadlineX(thread_t *tp) {
+
+  return tp->edf.absdeadline;
+}
+
+#endif /* CH_CFG_USE_EDF == TRUE */
+
+#endif /* CHEDF_H */
+
+/** @} */
@@ -104,10 +104,12 @@ extern "C" {
   void chMtxLockS(mutex_t *mp);
   bool chMtxTryLock(mutex_t *mp);
   bool chMtxTryLockS(mutex_t *mp);
+  bool chMtxAcquireI(mutex_t *mp, thread_t *tp);
   void chMtxUnlock(mutex_t *mp);
   void chMtxUnlockS(mutex_t *mp);
   void chMtxUnlockAll(void);
   void chMtxUnlockAllS(void);
+  void _mtx_boost(thread_t *tp, tprio_t prio);
 #ifdef __cplusplus
 }
 #endif
@@ -42,6 +42,11 @@
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (CH_CFG_REGISTRY_HASH_SIZE < 0) ||                                      \
+    ((CH_CFG_REGISTRY_HASH_SIZE & (CH_CFG_REGISTRY_HASH_SIZE - 1)) != 0)
+#error "CH_CFG_REGISTRY_HASH_SIZE must be zero or a power of two"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -74,6 +79,27 @@ typedef struct {
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+#if (CH_CFG_REGISTRY_HASH_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Removes a thread from the registry names index.
+ * @note    This macro is not meant for use in application code.
+ *
+ * @param[in] tp        thread to remove from the index
+ */
+#define REG_HASH_REMOVE(tp) _reg_hash_remove(tp)
+
+/**
+ * @brief   Adds a thread to the registry names index.
+ * @note    This macro is not meant for use in application code.
+ *
+ * @param[in] tp        thread to add to the index
+ */
+#define REG_HASH_INSERT(tp) _reg_hash_insert(tp)
+#else
+#define REG_HASH_REMOVE(tp)
+#define REG_HASH_INSERT(tp)
+#endif
+
 /**
  * @brief   Removes a thread from the registry list.
  * @note    This macro is not meant for use in application code.
@@ -83,6 +109,8 @@ typedef struct {
 #define REG_REMOVE(tp) {                                                    \
   (tp)->older->newer = (tp)->newer;                                         \
   (tp)->newer->older = (tp)->older;                                         \
+  REG_HASH_REMOVE(tp);                                                      \
+  _integrity_thread_removed(tp);                                            \
 }
 
 /**
@@ -96,6 +124,7 @@ typedef struct {
   (tp)->older = ch.rlist.older;                                           \
   (tp)->older->newer = (tp);                                                \
   ch.rlist.older = (tp);                                                  \
+  REG_HASH_INSERT(tp);                                                      \
 }
 
 /*===========================================================================*/
@@ -111,6 +140,11 @@ extern "C" {
   thread_t *chRegFindThreadByName(const char *name);
   thread_t *chRegFindThreadByPointer(thread_t *tp);
   thread_t *chRegFindThreadByWorkingArea(stkalign_t *wa);
+#if CH_CFG_REGISTRY_HASH_SIZE > 0
+  void _reg_hash_insert(thread_t *tp);
+  void _reg_hash_remove(thread_t *tp);
+  void _reg_hash_rename(thread_t *tp, const char *name);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -133,7 +167,11 @@ extern "C" {
 static inline void chRegSetThreadName(const char *name) {
 
 #if CH_CFG_USE_REGISTRY == TRUE
+#if CH_CFG_REGISTRY_HASH_SIZE > 0
+  _reg_hash_rename(ch.rlist.current, name);
+#else
   ch.rlist.current->name = name;
+#endif
 #else
   (void)name;
 #endif
@@ -173,7 +211,11 @@ static inline const char *chRegGetThreadNameX(thread_t *tp) {
 static inline void chRegSetThreadNameX(thread_t *tp, const char *name) {
 
 #if CH_CFG_USE_REGISTRY == TRUE
+#if CH_CFG_REGISTRY_HASH_SIZE > 0
+  _reg_hash_rename(tp, name);
+#else
   tp->name = name;
+#endif
 #else
   (void)tp;
   (void)name;
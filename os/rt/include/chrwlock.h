@@ -0,0 +1,172 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrwlock.h
+ * @brief   Reader-Writer Locks macros and structures.
+ *
+ * @addtogroup rwlocks
+ * @{
+ */
+
+#ifndef CHRWLOCK_H
+#define CHRWLOCK_H
+
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_USE_MUTEXES == FALSE
+#error "CH_CFG_USE_RWLOCKS requires CH_CFG_USE_MUTEXES"
+#endif
+
+#if CH_CFG_RWLOCKS_NESTING < 1
+#error "invalid CH_CFG_RWLOCKS_NESTING value"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a reader-writer lock structure.
+ */
+typedef struct ch_rwlock rwlock_t;
+
+/**
+ * @brief   Reader-writer lock structure.
+ */
+struct ch_rwlock {
+  threads_queue_t       queue;      /**< @brief Queue of the threads sleeping
+                                                on this lock, both readers
+                                                and writers.                */
+  rwlock_hold_t         *holders;   /**< @brief List of the hold records of
+                                                the threads holding the
+                                                lock.                       */
+  cnt_t                 cnt;        /**< @brief Number of readers holding
+                                                the lock, zero if the lock
+                                                is free, -1 if it is held
+                                                by a writer.                */
+  cnt_t                 writers;    /**< @brief Number of writers waiting
+                                                for the lock.               */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static reader-writer lock initializer.
+ * @details This macro should be used when statically initializing a
+ *          reader-writer lock that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the reader-writer lock variable
+ */
+#define _RWLOCK_DATA(name) {_THREADS_QUEUE_DATA(name.queue), NULL,         \
+                            (cnt_t)0, (cnt_t)0}
+
+/**
+ * @brief   Static reader-writer lock initializer.
+ * @details Statically initialized reader-writer locks require no explicit
+ *          initialization using @p chRWLockObjectInit().
+ *
+ * @param[in] name      the name of the reader-writer lock variable
+ */
+#define RWLOCK_DECL(name) rwlock_t name = _RWLOCK_DATA(name)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRWLockObjectInit(rwlock_t *rwlp);
+  msg_t chRWLockReadLock(rwlock_t *rwlp);
+  msg_t chRWLockReadLockS(rwlock_t *rwlp);
+  msg_t chRWLockReadLockTimeout(rwlock_t *rwlp, systime_t timeout);
+  msg_t chRWLockReadLockTimeoutS(rwlock_t *rwlp, systime_t timeout);
+  bool chRWLockTryReadLock(rwlock_t *rwlp);
+  bool chRWLockTryReadLockS(rwlock_t *rwlp);
+  void chRWLockReadUnlock(rwlock_t *rwlp);
+  void chRWLockReadUnlockS(rwlock_t *rwlp);
+  msg_t chRWLockWriteLock(rwlock_t *rwlp);
+  msg_t chRWLockWriteLockS(rwlock_t *rwlp);
+  msg_t chRWLockWriteLockTimeout(rwlock_t *rwlp, systime_t timeout);
+  msg_t chRWLockWriteLockTimeoutS(rwlock_t *rwlp, systime_t timeout);
+  bool chRWLockTryWriteLock(rwlock_t *rwlp);
+  bool chRWLockTryWriteLockS(rwlock_t *rwlp);
+  void chRWLockWriteUnlock(rwlock_t *rwlp);
+  void chRWLockWriteUnlockS(rwlock_t *rwlp);
+  void _rwl_boost(rwlock_t *rwlp, tprio_t prio);
+  tprio_t _rwl_inherited_prio(thread_t *tp, tprio_t prio);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the number of readers holding the lock.
+ *
+ * @param[in] rwlp      pointer to a @p rwlock_t structure
+ * @return              The number of readers, zero if the lock is free or
+ *                      held by a writer.
+ *
+ * @iclass
+ */
+static inline cnt_t chRWLockGetReadersI(rwlock_t *rwlp) {
+
+  chDbgCheckClassI();
+
+  return rwlp->cnt > (cnt_t)0 ? rwlp->cnt : (cnt_t)0;
+}
+
+/**
+ * @brief   Returns @p true if the lock is held by a writer.
+ *
+ * @param[in] rwlp      pointer to a @p rwlock_t structure
+ * @return              The write lock status.
+ *
+ * @iclass
+ */
+static inline bool chRWLockIsWriteLockedI(rwlock_t *rwlp) {
+
+  chDbgCheckClassI();
+
+  return (bool)(rwlp->cnt < (cnt_t)0);
+}
+
+#endif /* CH_CFG_USE_RWLOCKS == TRUE */
+
+#endif /* CHRWLOCK_H */
+
+/** @} */
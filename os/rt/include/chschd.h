@@ -79,6 +79,8 @@
 #define CH_STATE_WTMSG      (tstate_t)14     /**< @brief Waiting for a
                                                   message.                  */
 #define CH_STATE_FINAL      (tstate_t)15     /**< @brief Thread terminated. */
+#define CH_STATE_WTRWLOCK   (tstate_t)16     /**< @brief On a reader-writer
+                                                  lock.                     */
 
 /**
  * @brief   Thread states as array of strings.
@@ -88,7 +90,7 @@
 #define CH_STATE_NAMES                                                     \
   "READY", "CURRENT", "WTSTART", "SUSPENDED", "QUEUED", "WTSEM", "WTMTX",  \
   "WTCOND", "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ",        \
-  "SNDMSG", "WTMSG", "FINAL"
+  "SNDMSG", "WTMSG", "FINAL", "WTRWLOCK"
 /** @} */
 
 /**
@@ -104,6 +106,12 @@
                                                  from a Memory Pool.        */
 #define CH_FLAG_TERMINATE   (tmode_t)4U     /**< @brief Termination requested
                                                  flag.                      */
+#define CH_FLAG_CVRESET     (tmode_t)8U     /**< @brief Released from a
+                                                 condition variable by a
+                                                 broadcast.                 */
+#define CH_FLAG_RWWRITE     (tmode_t)16U    /**< @brief Waiting for the
+                                                 write lock of a
+                                                 reader-writer lock.        */
 /** @} */
 
 /*===========================================================================*/
@@ -145,6 +153,46 @@ struct ch_threads_queue {
   thread_t              *prev;      /**< @brief Previous in the queue.      */
 };
 
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Reader-writer lock hold record.
+ * @details Links a thread to a reader-writer lock it holds, the records of
+ *          all the threads holding the same lock are chained in a list.
+ */
+struct ch_rwlock_hold {
+  rwlock_hold_t         *next;      /**< @brief Next record on the same
+                                                lock.                       */
+  thread_t              *owner;     /**< @brief Thread owning the record.   */
+  struct ch_rwlock      *rwlp;      /**< @brief Held lock or @p NULL if the
+                                                record is unused.           */
+};
+#endif
+
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   EDF state of a thread.
+ */
+struct ch_edf_thread {
+  systime_t             period;     /**< @brief Activation period, zero if
+                                                the thread is not in the EDF
+                                                class.                      */
+  systime_t             deadline;   /**< @brief Relative deadline.          */
+  systime_t             budget;     /**< @brief Worst case execution time
+                                                of a job.                   */
+  systime_t             release;    /**< @brief Release time of the current
+                                                job.                        */
+  systime_t             absdeadline;/**< @brief Absolute deadline of the
+                                                current job.                */
+  edf_load_t            load;       /**< @brief Load admitted for the
+                                                thread.                     */
+  tprio_t               prio;       /**< @brief Priority before entering the
+                                                EDF class.                  */
+  ucnt_t                jobs;       /**< @brief Completed jobs.             */
+  ucnt_t                misses;     /**< @brief Jobs completed after their
+                                                deadline.                   */
+};
+#endif
+
 /**
  * @brief   Structure representing a thread.
  * @note    Not all the listed fields are always needed, by switching off some
@@ -166,6 +214,17 @@ struct ch_thread {
    */
   const char            *name;
 #endif
+#if ((CH_CFG_USE_REGISTRY == TRUE) && (CH_CFG_REGISTRY_HASH_SIZE > 0)) ||  \
+    defined(__DOXYGEN__)
+  /**
+   * @brief   Next thread in the same registry names index bucket.
+   */
+  thread_t              *namenext;
+  /**
+   * @brief   Hash of the thread name.
+   */
+  uint32_t              namehash;
+#endif
 #if (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE) ||  \
     defined(__DOXYGEN__)
   /**
@@ -260,6 +319,15 @@ struct ch_thread {
      */
     struct ch_mutex     *wtmtxp;
 #endif
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+    /**
+     * @brief   Pointer to a generic reader-writer lock object.
+     * @note    This field is used to get a pointer to a synchronization
+     *          object and is valid when the thread is in
+     *          @p CH_STATE_WTRWLOCK state.
+     */
+    struct ch_rwlock    *wtrwlp;
+#endif
 #if (CH_CFG_USE_EVENTS == TRUE) || defined(__DOXYGEN__)
     /**
      * @brief   Enabled events mask.
@@ -298,6 +366,18 @@ struct ch_thread {
    */
   tprio_t               realprio;
 #endif
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Records of the reader-writer locks held by this thread.
+   */
+  rwlock_hold_t         rwholds[CH_CFG_RWLOCKS_NESTING];
+#endif
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   EDF scheduling state.
+   */
+  edf_thread_t          edf;
+#endif
 #if ((CH_CFG_USE_DYNAMIC == TRUE) && (CH_CFG_USE_MEMPOOLS == TRUE)) ||      \
     defined(__DOXYGEN__)
   /**
@@ -330,6 +410,14 @@ struct ch_virtual_timer {
                                                 pointer.                    */
   void                  *par;       /**< @brief Timer callback function
                                                 parameter.                  */
+  systime_t             reload;     /**< @brief Reload interval, zero for
+                                                one-shot timers.            */
+  ucnt_t                overruns;   /**< @brief Expirations missed by a
+                                                continuous timer.           */
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+  systime_t             slack;      /**< @brief Acceptable expiration
+                                                delay.                      */
+#endif
 };
 
 /**
@@ -353,6 +441,8 @@ struct ch_virtual_timers_list {
    */
   systime_t             lasttime;   /**< @brief System time of the last
                                                 tick event.                 */
+  systime_t             alarm;      /**< @brief System time of the
+                                                programmed alarm.           */
 #endif
 };
 
@@ -372,6 +462,12 @@ struct ch_ready_list {
   /* End of the fields shared with the thread_t structure.*/
   thread_t              *current;   /**< @brief The currently running
                                                 thread.                     */
+#if ((CH_CFG_USE_REGISTRY == TRUE) && (CH_CFG_REGISTRY_HASH_SIZE > 0)) ||  \
+    defined(__DOXYGEN__)
+  thread_t              *names[CH_CFG_REGISTRY_HASH_SIZE];
+                                    /**< @brief Registry names index
+                                                buckets.                    */
+#endif
 };
 
 /**
@@ -404,6 +500,36 @@ struct ch_system_debug {
 #endif
 };
 
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Incremental integrity checker data structure.
+ */
+struct ch_system_integrity {
+  /**
+   * @brief   Current phase of the check pass.
+   */
+  unsigned              phase;
+  /**
+   * @brief   Next thread to be checked.
+   */
+  thread_t              *thread;
+  /**
+   * @brief   Next virtual timer to be checked.
+   */
+  virtual_timer_t       *timer;
+  /**
+   * @brief   Number of completed check passes.
+   */
+  ucnt_t                passes;
+#if (CH_CFG_USE_TM == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Time spent in the critical zone by @p chSysIntegrityStep().
+   */
+  time_measurement_t    tm;
+#endif
+};
+#endif
+
 /**
  * @brief   System data structure.
  * @note    This structure contain all the data areas used by the OS except
@@ -438,6 +564,12 @@ struct ch_system {
    */
   kernel_stats_t        kernel_stats;
 #endif
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Incremental integrity checker state.
+   */
+  system_integrity_t    integrity;
+#endif
 };
 
 /*===========================================================================*/
@@ -477,6 +609,8 @@ extern "C" {
   thread_t *chSchReadyAheadI(thread_t *tp);
   void chSchGoSleepS(tstate_t newstate);
   msg_t chSchGoSleepTimeoutS(tstate_t newstate, systime_t time);
+  msg_t chSchGoSleepTimeoutWithSlackS(tstate_t newstate, systime_t time,
+                                      systime_t slack);
   void chSchWakeupS(thread_t *ntp, msg_t msg);
   void chSchRescheduleS(void);
   bool chSchIsPreemptionRequired(void);
@@ -641,6 +775,61 @@ static inline thread_t *queue_dequeue(thread_t *tp) {
 }
 #endif /* CH_CFG_OPTIMIZE_SPEED == TRUE */
 
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Compares the deadlines of two threads at the EDF priority level.
+ * @note    Threads running at the EDF priority level without being part of
+ *          the EDF class are considered to have the earliest deadline.
+ *
+ * @param[in] tp1       pointer to the first thread
+ * @param[in] tp2       pointer to the second thread
+ * @return              The comparison result.
+ * @retval true         if the deadline of @p tp1 is strictly earlier than
+ *                      the deadline of @p tp2.
+ * @retval false        otherwise.
+ *
+ * @notapi
+ */
+static inline bool edf_is_earlier(const thread_t *tp1, const thread_t *tp2) {
+
+  if (tp2->edf.period == (systime_t)0) {
+    return false;
+  }
+  if (tp1->edf.period == (systime_t)0) {
+    return true;
+  }
+
+  /* Deadlines are compared as a signed difference in order to handle the
+     system time wrap around.*/
+  return (bool)((systime_t)(tp1->edf.absdeadline - tp2->edf.absdeadline) >
+                (systime_t)(((systime_t)-1) / 2U));
+}
+#endif
+
+/**
+ * @brief   Determines if a thread must run before another thread.
+ * @details Threads are ordered by priority, threads at the EDF priority
+ *          level are ordered by deadline if the EDF class is enabled.
+ *
+ * @param[in] tp1       pointer to the first thread
+ * @param[in] tp2       pointer to the second thread
+ * @return              The comparison result.
+ * @retval true         if @p tp1 must run before @p tp2.
+ * @retval false        otherwise.
+ *
+ * @notapi
+ */
+static inline bool sch_is_ahead(const thread_t *tp1, const thread_t *tp2) {
+
+#if CH_CFG_USE_EDF == TRUE
+  if ((tp1->prio == CH_CFG_EDF_PRIO) && (tp2->prio == CH_CFG_EDF_PRIO)) {
+    return edf_is_earlier(tp1, tp2);
+  }
+#endif
+
+  return (bool)(tp1->prio > tp2->prio);
+}
+
 /**
  * @brief   Determines if the current thread must reschedule.
  * @details This function returns @p true if there is a ready thread with
@@ -656,7 +845,7 @@ static inline bool chSchIsRescRequiredI(void) {
 
   chDbgCheckClassI();
 
-  return firstprio(&ch.rlist.queue) > currp->prio;
+  return sch_is_ahead(ch.rlist.queue.next, currp);
 }
 
 /**
@@ -674,7 +863,7 @@ static inline bool chSchCanYieldS(void) {
 
   chDbgCheckClassS();
 
-  return firstprio(&ch.rlist.queue) >= currp->prio;
+  return !sch_is_ahead(currp, ch.rlist.queue.next);
 }
 
 /**
@@ -701,22 +890,21 @@ static inline void chSchDoYieldS(void) {
  * @special
  */
 static inline void chSchPreemption(void) {
-  tprio_t p1 = firstprio(&ch.rlist.queue);
-  tprio_t p2 = currp->prio;
+  thread_t *ntp = ch.rlist.queue.next;
 
 #if CH_CFG_TIME_QUANTUM > 0
   if (currp->preempt > (tslices_t)0) {
-    if (p1 > p2) {
+    if (sch_is_ahead(ntp, currp)) {
       chSchDoRescheduleAhead();
     }
   }
   else {
-    if (p1 >= p2) {
+    if (!sch_is_ahead(currp, ntp)) {
       chSchDoRescheduleBehind();
     }
   }
 #else /* CH_CFG_TIME_QUANTUM == 0 */
-  if (p1 > p2) {
+  if (sch_is_ahead(ntp, currp)) {
     chSchDoRescheduleAhead();
   }
 #endif /* CH_CFG_TIME_QUANTUM == 0 */
@@ -60,6 +60,13 @@ typedef struct {
                                                 critical zones duration.    */
   time_measurement_t    m_crit_isr; /**< @brief Measurement of ISRs critical
                                                 zones duration.             */
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+  ucnt_t                n_vtalarms; /**< @brief Number of virtual timers
+                                                alarms.                     */
+  ucnt_t                n_vtsaved;  /**< @brief Number of alarms saved by
+                                                serving more deadlines
+                                                with a single alarm.        */
+#endif
 } kernel_stats_t;
 
 /*===========================================================================*/
@@ -80,6 +87,10 @@ extern "C" {
   void _stats_stop_measure_crit_thd(void);
   void _stats_start_measure_crit_isr(void);
   void _stats_stop_measure_crit_isr(void);
+#if CH_CFG_ST_TIMEDELTA > 0
+  void _stats_increase_vt_alarms(void);
+  void _stats_increase_vt_saved(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -97,6 +108,8 @@ extern "C" {
 #define _stats_stop_measure_crit_thd()
 #define _stats_start_measure_crit_isr()
 #define _stats_stop_measure_crit_isr()
+#define _stats_increase_vt_alarms()
+#define _stats_increase_vt_saved()
 
 #endif /* CH_DBG_STATISTICS == FALSE */
 
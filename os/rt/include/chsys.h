@@ -44,6 +44,14 @@
 #define CH_INTEGRITY_PORT                   8U
 /** @} */
 
+/**
+ * @brief   Size of the stack canary at the base of the working areas.
+ * @details The canary is filled with @p CH_DBG_STACK_FILL_VALUE when a
+ *          thread is created and is verified by the incremental integrity
+ *          checker.
+ */
+#define CH_INTEGRITY_CANARY_SIZE            sizeof (stkalign_t)
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -72,6 +80,10 @@
 #error "CH_CFG_SYSTEM_HALT_HOOK not defined in chconf.h"
 #endif
 
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) && (CH_CFG_USE_REGISTRY == FALSE)
+#error "CH_DBG_ENABLE_INTEGRITY_STEPS requires CH_CFG_USE_REGISTRY"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -80,6 +92,37 @@
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Moves the integrity checker away from a thread leaving the
+ *          registry.
+ * @note    This macro is not meant for use in application code.
+ *
+ * @param[in] tp        thread being removed from the registry
+ */
+#define _integrity_thread_removed(tp) {                                     \
+  if (ch.integrity.thread == (tp)) {                                        \
+    ch.integrity.thread = (tp)->newer;                                      \
+  }                                                                         \
+}
+
+/**
+ * @brief   Moves the integrity checker away from a timer leaving the
+ *          virtual timers list.
+ * @note    This macro is not meant for use in application code.
+ *
+ * @param[in] vtp       timer being removed from the list
+ */
+#define _integrity_timer_removed(vtp) {                                     \
+  if (ch.integrity.timer == (vtp)) {                                        \
+    ch.integrity.timer = (vtp)->next;                                       \
+  }                                                                         \
+}
+#else
+#define _integrity_thread_removed(tp)
+#define _integrity_timer_removed(vtp)
+#endif
+
 /**
  * @name    ISRs abstraction macros
  */
@@ -305,6 +348,10 @@ extern "C" {
   void chSysInit(void);
   void chSysHalt(const char *reason);
   bool chSysIntegrityCheckI(unsigned testmask);
+#if CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE
+  bool chSysIntegrityStepI(unsigned n);
+  bool chSysIntegrityStep(unsigned n);
+#endif
   void chSysTimerHandlerI(void);
   syssts_t chSysGetStatusAndLockX(void);
   void chSysRestoreStatusX(syssts_t sts);
@@ -86,6 +86,21 @@ typedef struct ch_threads_queue threads_queue_t;
  */
 typedef struct ch_ready_list ready_list_t;
 
+/**
+ * @brief   Type of a reader-writer lock hold record.
+ */
+typedef struct ch_rwlock_hold rwlock_hold_t;
+
+/**
+ * @brief   Type of an EDF load value.
+ */
+typedef uint32_t edf_load_t;
+
+/**
+ * @brief   Type of the EDF state of a thread.
+ */
+typedef struct ch_edf_thread edf_thread_t;
+
 /**
  * @brief   Type of a Virtual Timer callback function.
  */
@@ -106,6 +121,11 @@ typedef struct ch_virtual_timers_list  virtual_timers_list_t;
  */
 typedef struct ch_system_debug system_debug_t;
 
+/**
+ * @brief   Type of an incremental integrity checker structure.
+ */
+typedef struct ch_system_integrity system_integrity_t;
+
 /**
  * @brief   Type of system data structure.
  */
@@ -233,7 +233,7 @@ typedef struct {
 extern "C" {
 #endif
    thread_t *_thread_init(thread_t *tp, const char *name, tprio_t prio);
-#if CH_DBG_FILL_THREADS == TRUE
+#if (CH_DBG_FILL_THREADS == TRUE) || (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE)
   void _thread_memfill(uint8_t *startp, uint8_t *endp, uint8_t v);
 #endif
   thread_t *chThdCreateSuspendedI(const thread_descriptor_t *tdp);
@@ -263,6 +263,7 @@ extern "C" {
   void chThdDequeueNextI(threads_queue_t *tqp, msg_t msg);
   void chThdDequeueAllI(threads_queue_t *tqp, msg_t msg);
   void chThdSleep(systime_t time);
+  void chThdSleepWithSlack(systime_t time, systime_t slack);
   void chThdSleepUntil(systime_t time);
   systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next);
   void chThdYield(void);
@@ -394,6 +395,30 @@ static inline void chThdSleepS(systime_t time) {
   (void) chSchGoSleepTimeoutS(CH_STATE_SLEEPING, time);
 }
 
+/**
+ * @brief   Suspends the invoking thread for the specified time with slack.
+ * @details The wakeup can be delayed up to @p slack ticks in order to be
+ *          served together with other timers, this reduces the number of
+ *          wakeups in tick-less mode.
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[in] time      the delay in system ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE the thread enters an infinite sleep
+ *                        state.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable wakeup delay in system ticks
+ *
+ * @sclass
+ */
+static inline void chThdSleepWithSlackS(systime_t time, systime_t slack) {
+
+  chDbgCheck(time != TIME_IMMEDIATE);
+
+  (void) chSchGoSleepTimeoutWithSlackS(CH_STATE_SLEEPING, time, slack);
+}
+
 /**
  * @brief   Initializes a threads queue object.
  *
@@ -213,8 +213,16 @@
 extern "C" {
 #endif
   void _vt_init(void);
+  void _vt_rearm(virtual_timer_t *vtp, systime_t now);
+#if CH_CFG_ST_TIMEDELTA > 0
+  void _vt_set_alarm(systime_t now);
+#endif
   void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                   vtfunc_t vtfunc, void *par);
+  void chVTDoSetWithSlackI(virtual_timer_t *vtp, systime_t delay,
+                           systime_t slack, vtfunc_t vtfunc, void *par);
+  void chVTDoSetContinuousI(virtual_timer_t *vtp, systime_t delay,
+                            vtfunc_t vtfunc, void *par);
   void chVTDoResetI(virtual_timer_t *vtp);
 #ifdef __cplusplus
 }
@@ -654,6 +662,181 @@ static inline void chVTSet(virtual_timer_t *vtp, systime_t delay,
   chSysUnlock();
 }
 
+/**
+ * @brief   Enables a virtual timer with slack.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable expiration delay in ticks, timers
+ *                      expiring within the slack are served by the same
+ *                      alarm
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+static inline void chVTSetWithSlackI(virtual_timer_t *vtp, systime_t delay,
+                                     systime_t slack,
+                                     vtfunc_t vtfunc, void *par) {
+
+  chVTResetI(vtp);
+  chVTDoSetWithSlackI(vtp, delay, slack, vtfunc, par);
+}
+
+/**
+ * @brief   Enables a virtual timer with slack.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable expiration delay in ticks, timers
+ *                      expiring within the slack are served by the same
+ *                      alarm
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @api
+ */
+static inline void chVTSetWithSlack(virtual_timer_t *vtp, systime_t delay,
+                                    systime_t slack,
+                                    vtfunc_t vtfunc, void *par) {
+
+  chSysLock();
+  chVTSetWithSlackI(vtp, delay, slack, vtfunc, par);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Enables a continuous virtual timer.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the timer period in ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. The timer stays armed
+ *                      after invoking the callback.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+static inline void chVTSetContinuousI(virtual_timer_t *vtp, systime_t delay,
+                                      vtfunc_t vtfunc, void *par) {
+
+  chVTResetI(vtp);
+  chVTDoSetContinuousI(vtp, delay, vtfunc, par);
+}
+
+/**
+ * @brief   Enables a continuous virtual timer.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the timer period in ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. The timer stays armed
+ *                      after invoking the callback.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @api
+ */
+static inline void chVTSetContinuous(virtual_timer_t *vtp, systime_t delay,
+                                     vtfunc_t vtfunc, void *par) {
+
+  chSysLock();
+  chVTSetContinuousI(vtp, delay, vtfunc, par);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns the reload interval of a virtual timer.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @return              The reload interval, zero for one-shot timers.
+ *
+ * @xclass
+ */
+static inline systime_t chVTGetReloadIntervalX(virtual_timer_t *vtp) {
+
+  return vtp->reload;
+}
+
+/**
+ * @brief   Changes the reload interval of an armed virtual timer.
+ * @details The new interval is used starting from the next expiration, a
+ *          zero interval makes the timer one-shot.
+ * @note    The timer is re-armed before invoking its callback, changing
+ *          the interval from within the callback affects the expiration
+ *          following the already scheduled one.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] reload    the new reload interval
+ *
+ * @xclass
+ */
+static inline void chVTSetReloadIntervalX(virtual_timer_t *vtp,
+                                          systime_t reload) {
+
+  vtp->reload = reload;
+}
+
+/**
+ * @brief   Returns the number of expirations missed by a continuous timer.
+ * @details Expirations are missed when the timers processing is delayed
+ *          for longer than the timer period, the missed deadlines are
+ *          skipped and the period phase is preserved.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @return              The number of missed expirations since the timer
+ *                      has been armed.
+ *
+ * @xclass
+ */
+static inline ucnt_t chVTGetOverrunsX(virtual_timer_t *vtp) {
+
+  return vtp->overruns;
+}
+
 /**
  * @brief   Virtual timers ticker.
  * @note    The system lock is released before entering the callback and
@@ -678,9 +861,17 @@ static inline void chVTDoTickI(void) {
 
       vtp = ch.vtlist.next;
       fn = vtp->func;
-      vtp->func = NULL;
       vtp->next->prev = (virtual_timer_t *)&ch.vtlist;
       ch.vtlist.next = vtp->next;
+      _integrity_timer_removed(vtp);
+
+      /* Continuous timers are re-armed, the others are disabled.*/
+      if (vtp->reload > (systime_t)0) {
+        _vt_rearm(vtp, ch.vtlist.systime);
+      }
+      else {
+        vtp->func = NULL;
+      }
       chSysUnlockFromISR();
       fn(vtp->par);
       chSysLockFromISR();
@@ -688,7 +879,10 @@ static inline void chVTDoTickI(void) {
   }
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
   virtual_timer_t *vtp;
-  systime_t now, delta;
+  systime_t now;
+  bool served = false;
+
+  _stats_increase_vt_alarms();
 
   /* First timer to be processed.*/
   vtp = ch.vtlist.next;
@@ -701,17 +895,33 @@ static inline void chVTDoTickI(void) {
   while (vtp->delta <= (systime_t)(now - ch.vtlist.lasttime)) {
     vtfunc_t fn;
 
+    /* A timer with a deadline different from the previous one would have
+       required an alarm of its own.*/
+    if (served && (vtp->delta > (systime_t)0)) {
+      _stats_increase_vt_saved();
+    }
+    served = true;
+
     /* The "last time" becomes this timer's expiration time.*/
     ch.vtlist.lasttime += vtp->delta;
 
     vtp->next->prev = (virtual_timer_t *)&ch.vtlist;
     ch.vtlist.next = vtp->next;
+    _integrity_timer_removed(vtp);
     fn = vtp->func;
-    vtp->func = NULL;
 
-    /* if the list becomes empty then the timer is stopped.*/
-    if (ch.vtlist.next == (virtual_timer_t *)&ch.vtlist) {
-      port_timer_stop_alarm();
+    /* Continuous timers are re-armed relative to their deadline, the
+       others are disabled.*/
+    if (vtp->reload > (systime_t)0) {
+      _vt_rearm(vtp, now);
+    }
+    else {
+      vtp->func = NULL;
+
+      /* if the list becomes empty then the timer is stopped.*/
+      if (ch.vtlist.next == (virtual_timer_t *)&ch.vtlist) {
+        port_timer_stop_alarm();
+      }
     }
 
     /* Leaving the system critical zone in order to execute the callback
@@ -738,14 +948,10 @@ static inline void chVTDoTickI(void) {
   }
 
   /* Recalculating the next alarm time.*/
-  delta = ch.vtlist.lasttime + vtp->delta - now;
-  if (delta < (systime_t)CH_CFG_ST_TIMEDELTA) {
-    delta = (systime_t)CH_CFG_ST_TIMEDELTA;
-  }
-  port_timer_set_alarm(now + delta);
+  _vt_set_alarm(now);
 
   chDbgAssert((chVTGetSystemTimeX() - ch.vtlist.lasttime) <=
-              (now + delta - ch.vtlist.lasttime),
+              (ch.vtlist.alarm - ch.vtlist.lasttime),
               "exceeding delta");
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
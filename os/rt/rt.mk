@@ -9,6 +9,9 @@ KERNSRC := $(CHIBIOS)/os/rt/src/chsys.c \
            $(CHIBIOS)/os/rt/src/chvt.c \
            $(CHIBIOS)/os/rt/src/chschd.c \
            $(CHIBIOS)/os/rt/src/chthreads.c
+ifneq ($(findstring CH_CFG_USE_EDF TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/rt/src/chedf.c
+endif
 ifneq ($(findstring CH_CFG_USE_TM TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chtm.c
 endif
@@ -27,6 +30,9 @@ endif
 ifneq ($(findstring CH_CFG_USE_CONDVARS TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chcond.c
 endif
+ifneq ($(findstring CH_CFG_USE_RWLOCKS TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/rt/src/chrwlock.c
+endif
 ifneq ($(findstring CH_CFG_USE_EVENTS TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/rt/src/chevents.c
 endif
@@ -48,6 +54,12 @@ endif
 ifneq ($(findstring CH_CFG_USE_MEMPOOLS TRUE,$(CHCONF)),)
 KERNSRC += $(CHIBIOS)/os/common/oslib/src/chmempools.c
 endif
+ifneq ($(findstring CH_CFG_USE_WORKQUEUES TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/common/oslib/src/chworkq.c
+endif
+ifneq ($(findstring CH_CFG_USE_CTASKS TRUE,$(CHCONF)),)
+KERNSRC += $(CHIBIOS)/os/common/oslib/src/chctasks.c
+endif
 else
 KERNSRC := $(CHIBIOS)/os/rt/src/chsys.c \
            $(CHIBIOS)/os/rt/src/chdebug.c \
@@ -55,19 +67,23 @@ KERNSRC := $(CHIBIOS)/os/rt/src/chsys.c \
            $(CHIBIOS)/os/rt/src/chvt.c \
            $(CHIBIOS)/os/rt/src/chschd.c \
            $(CHIBIOS)/os/rt/src/chthreads.c \
+           $(CHIBIOS)/os/rt/src/chedf.c \
            $(CHIBIOS)/os/rt/src/chtm.c \
            $(CHIBIOS)/os/rt/src/chstats.c \
            $(CHIBIOS)/os/rt/src/chregistry.c \
            $(CHIBIOS)/os/rt/src/chsem.c \
            $(CHIBIOS)/os/rt/src/chmtx.c \
            $(CHIBIOS)/os/rt/src/chcond.c \
+           $(CHIBIOS)/os/rt/src/chrwlock.c \
            $(CHIBIOS)/os/rt/src/chevents.c \
            $(CHIBIOS)/os/rt/src/chmsg.c \
            $(CHIBIOS)/os/rt/src/chdynamic.c \
            $(CHIBIOS)/os/common/oslib/src/chmboxes.c \
            $(CHIBIOS)/os/common/oslib/src/chmemcore.c \
            $(CHIBIOS)/os/common/oslib/src/chheap.c \
-           $(CHIBIOS)/os/common/oslib/src/chmempools.c
+           $(CHIBIOS)/os/common/oslib/src/chmempools.c \
+           $(CHIBIOS)/os/common/oslib/src/chworkq.c \
+           $(CHIBIOS)/os/common/oslib/src/chctasks.c
 endif
 
 # Required include directories
@@ -31,7 +31,12 @@
  *          <h2>Operation mode</h2>
  *          The condition variable is a synchronization object meant to be
  *          used inside a zone protected by a mutex. Mutexes and condition
- *          variables together can implement a Monitor construct.
+ *          variables together can implement a Monitor construct.<br>
+ *          Signaled threads do not contend for the mutex after waking up,
+ *          the mutex is reacquired on their behalf by the signaling
+ *          operation and, if it is owned, the threads are moved directly
+ *          on the mutex queue. This way a broadcast only makes ready the
+ *          first thread able to proceed.
  * @pre     In order to use the condition variable APIs the @p CH_CFG_USE_CONDVARS
  *          option must be enabled in @p chconf.h.
  * @{
@@ -61,6 +66,31 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Releases the first thread waiting on a condition variable.
+ * @details The mutex released by the waiting thread is reacquired on its
+ *          behalf, if the mutex is owned by another thread then the waiting
+ *          thread is moved directly on the mutex queue instead of being made
+ *          ready ("wait morphing"). This avoids the context switches of
+ *          threads that would immediately sleep again on the mutex.
+ *
+ * @param[in] cp        pointer to the @p condition_variable_t structure
+ * @param[in] msg       the wakeup message
+ */
+static void cond_release(condition_variable_t *cp, msg_t msg) {
+  thread_t *tp = queue_fifo_remove(&cp->queue);
+
+  /* The wakeup message does not survive the sleep on the mutex, the
+     broadcast case is marked in the thread flags.*/
+  if (msg == MSG_RESET) {
+    tp->flags |= CH_FLAG_CVRESET;
+  }
+  if (chMtxAcquireI(cp->mtxp, tp)) {
+    tp->u.rdymsg = msg;
+    (void) chSchReadyI(tp);
+  }
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -77,6 +107,7 @@ void chCondObjectInit(condition_variable_t *cp) {
   chDbgCheck(cp != NULL);
 
   queue_init(&cp->queue);
+  cp->mtxp = NULL;
 }
 
 /**
@@ -91,9 +122,8 @@ void chCondSignal(condition_variable_t *cp) {
   chDbgCheck(cp != NULL);
 
   chSysLock();
-  if (queue_notempty(&cp->queue)) {
-    chSchWakeupS(queue_fifo_remove(&cp->queue), MSG_OK);
-  }
+  chCondSignalI(cp);
+  chSchRescheduleS();
   chSysUnlock();
 }
 
@@ -114,9 +144,7 @@ void chCondSignalI(condition_variable_t *cp) {
   chDbgCheck(cp != NULL);
 
   if (queue_notempty(&cp->queue)) {
-    thread_t *tp = queue_fifo_remove(&cp->queue);
-    tp->u.rdymsg = MSG_OK;
-    (void) chSchReadyI(tp);
+    cond_release(cp, MSG_OK);
   }
 }
 
@@ -151,11 +179,12 @@ void chCondBroadcastI(condition_variable_t *cp) {
   chDbgCheckClassI();
   chDbgCheck(cp != NULL);
 
-  /* Empties the condition variable queue and inserts all the threads into the
-     ready list in FIFO order. The wakeup message is set to @p MSG_RESET in
-     order to make a chCondBroadcast() detectable from a chCondSignal().*/
+  /* Empties the condition variable queue moving all the threads on the
+     mutex queue in FIFO order, only the first thread can be made ready.
+     The wakeup message is set to @p MSG_RESET in order to make a
+     chCondBroadcast() detectable from a chCondSignal().*/
   while (queue_notempty(&cp->queue)) {
-    chSchReadyI(queue_fifo_remove(&cp->queue))->u.rdymsg = MSG_RESET;
+    cond_release(cp, MSG_RESET);
   }
 }
 
@@ -165,6 +194,8 @@ void chCondBroadcastI(condition_variable_t *cp) {
  *          variable, and finally acquires the mutex again. All the sequence
  *          is performed atomically.
  * @pre     The invoking thread <b>must</b> have at least one owned mutex.
+ * @pre     All the threads waiting on a condition variable must release
+ *          the same mutex.
  *
  * @param[in] cp        pointer to the @p condition_variable_t structure
  * @return              A message specifying how the invoking thread has been
@@ -191,6 +222,8 @@ msg_t chCondWait(condition_variable_t *cp) {
  *          variable, and finally acquires the mutex again. All the sequence
  *          is performed atomically.
  * @pre     The invoking thread <b>must</b> have at least one owned mutex.
+ * @pre     All the threads waiting on a condition variable must release
+ *          the same mutex.
  *
  * @param[in] cp        pointer to the @p condition_variable_t structure
  * @return              A message specifying how the invoking thread has been
@@ -213,15 +246,20 @@ msg_t chCondWaitS(condition_variable_t *cp) {
 
   /* Getting "current" mutex and releasing it.*/
   mp = chMtxGetNextMutexS();
+  chDbgAssert(queue_isempty(&cp->queue) || (cp->mtxp == mp),
+              "different mutex");
   chMtxUnlockS(mp);
 
-  /* Start waiting on the condition variable, on exit the mutex is taken
-     again.*/
+  /* Start waiting on the condition variable, on exit the mutex has already
+     been taken again by the signaling thread.*/
+  cp->mtxp = mp;
   ctp->u.wtobjp = cp;
   queue_prio_insert(ctp, &cp->queue);
   chSchGoSleepS(CH_STATE_WTCOND);
-  msg = ctp->u.rdymsg;
-  chMtxLockS(mp);
+  chDbgAssert(mp->owner == ctp, "not owner");
+
+  msg = ((ctp->flags & CH_FLAG_CVRESET) != (tmode_t)0) ? MSG_RESET : MSG_OK;
+  ctp->flags &= (tmode_t)~CH_FLAG_CVRESET;
 
   return msg;
 }
@@ -233,6 +271,8 @@ msg_t chCondWaitS(condition_variable_t *cp) {
  *          variable, and finally acquires the mutex again. All the sequence
  *          is performed atomically.
  * @pre     The invoking thread <b>must</b> have at least one owned mutex.
+ * @pre     All the threads waiting on a condition variable must release
+ *          the same mutex.
  * @pre     The configuration option @p CH_CFG_USE_CONDVARS_TIMEOUT must be enabled
  *          in order to use this function.
  * @post    Exiting the function because a timeout does not re-acquire the
@@ -271,6 +311,8 @@ msg_t chCondWaitTimeout(condition_variable_t *cp, systime_t time) {
  *          variable, and finally acquires the mutex again. All the sequence
  *          is performed atomically.
  * @pre     The invoking thread <b>must</b> have at least one owned mutex.
+ * @pre     All the threads waiting on a condition variable must release
+ *          the same mutex.
  * @pre     The configuration option @p CH_CFG_USE_CONDVARS_TIMEOUT must be enabled
  *          in order to use this function.
  * @post    Exiting the function because a timeout does not re-acquire the
@@ -294,24 +336,31 @@ msg_t chCondWaitTimeout(condition_variable_t *cp, systime_t time) {
  * @sclass
  */
 msg_t chCondWaitTimeoutS(condition_variable_t *cp, systime_t time) {
+  thread_t *ctp = currp;
   mutex_t *mp;
   msg_t msg;
 
   chDbgCheckClassS();
   chDbgCheck((cp != NULL) && (time != TIME_IMMEDIATE));
-  chDbgAssert(currp->mtxlist != NULL, "not owning a mutex");
+  chDbgAssert(ctp->mtxlist != NULL, "not owning a mutex");
 
   /* Getting "current" mutex and releasing it.*/
   mp = chMtxGetNextMutexS();
+  chDbgAssert(queue_isempty(&cp->queue) || (cp->mtxp == mp),
+              "different mutex");
   chMtxUnlockS(mp);
 
-  /* Start waiting on the condition variable, on exit the mutex is taken
-     again.*/
-  currp->u.wtobjp = cp;
-  queue_prio_insert(currp, &cp->queue);
+  /* Start waiting on the condition variable, on exit the mutex has already
+     been taken again by the signaling thread.*/
+  cp->mtxp = mp;
+  ctp->u.wtobjp = cp;
+  queue_prio_insert(ctp, &cp->queue);
   msg = chSchGoSleepTimeoutS(CH_STATE_WTCOND, time);
   if (msg != MSG_TIMEOUT) {
-    chMtxLockS(mp);
+    chDbgAssert(mp->owner == ctp, "not owner");
+
+    msg = ((ctp->flags & CH_FLAG_CVRESET) != (tmode_t)0) ? MSG_RESET : MSG_OK;
+    ctp->flags &= (tmode_t)~CH_FLAG_CVRESET;
   }
 
   return msg;
@@ -0,0 +1,381 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chedf.c
+ * @brief   EDF scheduling class code.
+ *
+ * @addtogroup edf
+ * @details Earliest Deadline First scheduling of periodic threads.
+ *          <h2>Operation mode</h2>
+ *          The priority level @p CH_CFG_EDF_PRIO is reserved to the EDF
+ *          class, threads entering the class are moved to that level and
+ *          are ordered in the ready list by the absolute deadline of their
+ *          current job instead of FIFO. Threads with higher priority
+ *          preempt the EDF threads, threads with lower priority run when no
+ *          EDF thread is ready.<br>
+ *          Each thread in the class executes a job per period, a job is
+ *          released at the start of the period and must complete within
+ *          the relative deadline. A thread signals the completion of its
+ *          job by invoking @p chEDFWaitNextPeriod(), jobs completed after
+ *          their deadline are counted as misses.<br>
+ *          A thread is admitted in the class only if the total load of the
+ *          EDF threads stays within the CPU capacity, the load of a thread
+ *          is its budget divided by the smaller of its deadline and
+ *          period. The test is exact for deadlines equal to or greater than
+ *          the periods and sufficient otherwise, the time used by threads
+ *          with priority higher than @p CH_CFG_EDF_PRIO is not accounted
+ *          and must be subtracted by the application.
+ *          <h2>Constraints</h2>
+ *          - EDF threads must not change their priority and must not own
+ *            mutexes when entering or leaving the class.
+ *          - Threads with priority @p CH_CFG_EDF_PRIO that are not part of
+ *            the class are scheduled ahead of the EDF threads, this happens
+ *            to threads inheriting the priority of an EDF thread through a
+ *            mutex.
+ *          - Threads waiting on semaphores, mutexes or other objects with
+ *            priority ordering are not ordered by deadline.
+ *          .
+ * @pre     In order to use the EDF APIs the @p CH_CFG_USE_EDF option must
+ *          be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_EDF == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum value of the EDF time parameters.
+ */
+#define EDF_MAX_TIME        ((systime_t)(((systime_t)-1) / 2U))
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Total load of the threads in the EDF class.
+ */
+static edf_load_t edf_load;
+
+/**
+ * @brief   Total number of deadline misses.
+ */
+static ucnt_t edf_misses;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the EDF scheduling class.
+ *
+ * @notapi
+ */
+void _edf_init(void) {
+
+  /* The ready list header priority must never match the EDF level.*/
+  chDbgAssert((CH_CFG_EDF_PRIO > IDLEPRIO) && (CH_CFG_EDF_PRIO <= HIGHPRIO),
+              "invalid CH_CFG_EDF_PRIO");
+
+  edf_load   = (edf_load_t)0;
+  edf_misses = (ucnt_t)0;
+}
+
+/**
+ * @brief   Removes a thread from the EDF class.
+ * @details The thread load is released and the thread priority is restored
+ *          to the value it had before entering the class.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+void _edf_leave(thread_t *tp) {
+
+  edf_load -= tp->edf.load;
+  tp->edf.period = (systime_t)0;
+  tp->prio = tp->edf.prio;
+#if CH_CFG_USE_MUTEXES == TRUE
+  tp->realprio = tp->edf.prio;
+#endif
+}
+
+/**
+ * @brief   Computes the load of a thread.
+ * @details The load is the budget divided by the smaller of the deadline
+ *          and the period, rounded up.
+ *
+ * @param[in] pp        pointer to the EDF parameters
+ * @return              The load, @p EDF_FULL_LOAD represents the whole
+ *                      CPU time.
+ *
+ * @xclass
+ */
+edf_load_t chEDFComputeLoadX(const edf_params_t *pp) {
+  systime_t span;
+
+  chDbgCheck(pp != NULL);
+
+  span = (pp->deadline < pp->period) ? pp->deadline : pp->period;
+
+  chDbgCheck((span > (systime_t)0) && (pp->budget <= span));
+
+  return (edf_load_t)((((uint64_t)pp->budget * (uint64_t)EDF_FULL_LOAD) +
+                       (uint64_t)span - 1U) / (uint64_t)span);
+}
+
+/**
+ * @brief   Verifies the schedulability of a set of threads.
+ * @details The set is schedulable if the sum of the loads of the threads
+ *          does not exceed the CPU capacity.
+ * @note    The test is exact if the deadlines are equal to or greater than
+ *          the periods, it is sufficient otherwise.
+ *
+ * @param[in] pp        pointer to an array of EDF parameters
+ * @param[in] n         number of elements in the array
+ * @return              The test result.
+ * @retval true         if the set is schedulable.
+ * @retval false        if the set could miss deadlines.
+ *
+ * @xclass
+ */
+bool chEDFIsSchedulableX(const edf_params_t *pp, unsigned n) {
+  edf_load_t load = (edf_load_t)0;
+
+  chDbgCheck((pp != NULL) || (n == 0U));
+
+  while (n > 0U) {
+    edf_load_t l = chEDFComputeLoadX(pp);
+
+    if (l > (EDF_FULL_LOAD - load)) {
+      return false;
+    }
+    load += l;
+    pp++;
+    n--;
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Returns the total load of the threads in the EDF class.
+ *
+ * @return              The load, @p EDF_FULL_LOAD represents the whole
+ *                      CPU time.
+ *
+ * @xclass
+ */
+edf_load_t chEDFGetLoadX(void) {
+
+  return edf_load;
+}
+
+/**
+ * @brief   Returns the total number of deadline misses.
+ *
+ * @return              The number of jobs completed after their deadline.
+ *
+ * @xclass
+ */
+ucnt_t chEDFGetMissesX(void) {
+
+  return edf_misses;
+}
+
+/**
+ * @brief   Adds a thread to the EDF class.
+ * @details The thread is admitted only if the total load stays within the
+ *          CPU capacity, in that case the thread is moved to the priority
+ *          level @p CH_CFG_EDF_PRIO and its first job is released at the
+ *          current system time.
+ * @pre     The thread must be the current thread or a thread created using
+ *          @p chThdCreateSuspendedI() and not yet started.
+ * @pre     The thread must not own mutexes.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] pp        pointer to the EDF parameters
+ * @return              The admission result.
+ * @retval true         if the thread has been admitted.
+ * @retval false        if the thread would overload the CPU.
+ *
+ * @iclass
+ */
+bool chEDFEnterI(thread_t *tp, const edf_params_t *pp) {
+  edf_load_t load;
+
+  chDbgCheckClassI();
+  chDbgCheck((tp != NULL) && (pp != NULL) &&
+             (pp->period > (systime_t)0) && (pp->period <= EDF_MAX_TIME) &&
+             (pp->deadline > (systime_t)0) && (pp->deadline <= EDF_MAX_TIME));
+  chDbgAssert((tp == currp) || (tp->state == CH_STATE_WTSTART),
+              "invalid state");
+  chDbgAssert(tp->edf.period == (systime_t)0, "already in EDF class");
+#if CH_CFG_USE_MUTEXES == TRUE
+  chDbgAssert(tp->mtxlist == NULL, "owns mutexes");
+#endif
+
+  /* Admission control.*/
+  load = chEDFComputeLoadX(pp);
+  if (load > (EDF_FULL_LOAD - edf_load)) {
+    return false;
+  }
+  edf_load += load;
+
+  /* The first job is released now.*/
+  tp->edf.period      = pp->period;
+  tp->edf.deadline    = pp->deadline;
+  tp->edf.budget      = pp->budget;
+  tp->edf.release     = chVTGetSystemTimeX();
+  tp->edf.absdeadline = tp->edf.release + pp->deadline;
+  tp->edf.load        = load;
+  tp->edf.jobs        = (ucnt_t)0;
+  tp->edf.misses      = (ucnt_t)0;
+
+  /* Moving the thread to the EDF priority level.*/
+#if CH_CFG_USE_MUTEXES == TRUE
+  tp->edf.prio = tp->realprio;
+  tp->realprio = CH_CFG_EDF_PRIO;
+#else
+  tp->edf.prio = tp->prio;
+#endif
+  tp->prio = CH_CFG_EDF_PRIO;
+
+  return true;
+}
+
+/**
+ * @brief   Adds the current thread to the EDF class.
+ * @details The thread is admitted only if the total load stays within the
+ *          CPU capacity, in that case the thread is moved to the priority
+ *          level @p CH_CFG_EDF_PRIO and its first job is released at the
+ *          current system time.
+ * @pre     The thread must not own mutexes.
+ *
+ * @param[in] pp        pointer to the EDF parameters
+ * @return              The admission result.
+ * @retval true         if the thread has been admitted.
+ * @retval false        if the thread would overload the CPU.
+ *
+ * @api
+ */
+bool chEDFEnter(const edf_params_t *pp) {
+  bool admitted;
+
+  chSysLock();
+  admitted = chEDFEnterI(currp, pp);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return admitted;
+}
+
+/**
+ * @brief   Removes the current thread from the EDF class.
+ * @details The thread load is released and the thread priority is restored
+ *          to the value it had before entering the class.
+ * @note    Threads terminating while in the EDF class are removed from the
+ *          class automatically.
+ * @pre     The thread must not own mutexes.
+ *
+ * @api
+ */
+void chEDFLeave(void) {
+
+  chSysLock();
+  chDbgAssert(currp->edf.period > (systime_t)0, "not in EDF class");
+#if CH_CFG_USE_MUTEXES == TRUE
+  chDbgAssert(currp->mtxlist == NULL, "owns mutexes");
+#endif
+  _edf_leave(currp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Completes the current job and waits for the next period.
+ * @details The next job is released one period after the current one and
+ *          its deadline is updated. If the next release time already
+ *          passed then the thread continues without sleeping, activations
+ *          are never skipped.
+ *
+ * @return              The deadline status of the completed job.
+ * @retval false        if the job completed within its deadline.
+ * @retval true         if the job missed its deadline.
+ *
+ * @api
+ */
+bool chEDFWaitNextPeriod(void) {
+  thread_t *tp = currp;
+  systime_t now;
+  bool missed;
+
+  chSysLock();
+  chDbgAssert(tp->edf.period > (systime_t)0, "not in EDF class");
+
+  /* Deadline check of the completed job.*/
+  now = chVTGetSystemTimeX();
+  missed = !chVTIsTimeWithinX(now, tp->edf.release, tp->edf.absdeadline);
+  tp->edf.jobs++;
+  if (missed) {
+    tp->edf.misses++;
+    edf_misses++;
+  }
+
+  /* Releasing the next job, the new deadline must be set before sleeping
+     because it determines the position in the ready list on wakeup.*/
+  tp->edf.release     += tp->edf.period;
+  tp->edf.absdeadline  = tp->edf.release + tp->edf.deadline;
+  if (chVTIsTimeWithinX(now, tp->edf.release - tp->edf.period,
+                        tp->edf.release)) {
+    (void) chSchGoSleepTimeoutS(CH_STATE_SLEEPING, tp->edf.release - now);
+  }
+  else {
+    /* Overrun, the thread continues with the later deadline so threads
+       with earlier deadlines can now preempt it.*/
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+
+  return missed;
+}
+
+#endif /* CH_CFG_USE_EDF == TRUE */
+
+/** @} */
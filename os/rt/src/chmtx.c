@@ -93,6 +93,76 @@
 /* Module exported functions.                                                */
 /*===========================================================================*/
 
+/**
+ * @brief   Priority inheritance protocol.
+ * @details Explores the thread-mutex dependencies boosting the priority of
+ *          all the affected threads to equal the priority of the thread
+ *          requesting the mutex.
+ *
+ * @param[in] tp        pointer to the mutex owner thread
+ * @param[in] prio      priority of the requesting thread
+ *
+ * @notapi
+ */
+void _mtx_boost(thread_t *tp, tprio_t prio) {
+
+  /* Does the requesting thread have higher priority than the mutex
+     owning thread? */
+  while (tp->prio < prio) {
+    /* Make priority of thread tp match the requesting thread's priority.*/
+    tp->prio = prio;
+
+    /* The following states need priority queues reordering.*/
+    switch (tp->state) {
+    case CH_STATE_WTMTX:
+      /* Re-enqueues the mutex owner with its new priority.*/
+      queue_prio_insert(queue_dequeue(tp), &tp->u.wtmtxp->queue);
+      tp = tp->u.wtmtxp->owner;
+      /*lint -e{9042} [16.1] Continues the while.*/
+      continue;
+#if CH_CFG_USE_RWLOCKS == TRUE
+    case CH_STATE_WTRWLOCK:
+      /* Re-enqueues tp with its new priority on the lock queue then all
+         the lock holders inherit the same priority.*/
+      queue_prio_insert(queue_dequeue(tp), &tp->u.wtrwlp->queue);
+      _rwl_boost(tp->u.wtrwlp, prio);
+      break;
+#endif
+#if (CH_CFG_USE_CONDVARS == TRUE) ||                                        \
+    ((CH_CFG_USE_SEMAPHORES == TRUE) &&                                     \
+     (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)) ||                           \
+    ((CH_CFG_USE_MESSAGES == TRUE) &&                                       \
+     (CH_CFG_USE_MESSAGES_PRIORITY == TRUE))
+#if CH_CFG_USE_CONDVARS == TRUE
+    case CH_STATE_WTCOND:
+#endif
+#if (CH_CFG_USE_SEMAPHORES == TRUE) &&                                      \
+    (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)
+    case CH_STATE_WTSEM:
+#endif
+#if (CH_CFG_USE_MESSAGES == TRUE) && (CH_CFG_USE_MESSAGES_PRIORITY == TRUE)
+    case CH_STATE_SNDMSGQ:
+#endif
+      /* Re-enqueues tp with its new priority on the queue.*/
+      queue_prio_insert(queue_dequeue(tp), &tp->u.wtmtxp->queue);
+      break;
+#endif
+    case CH_STATE_READY:
+#if CH_DBG_ENABLE_ASSERTS == TRUE
+      /* Prevents an assertion in chSchReadyI().*/
+      tp->state = CH_STATE_CURRENT;
+#endif
+      /* Re-enqueues tp with its new priority on the ready list.*/
+      (void) chSchReadyI(queue_dequeue(tp));
+      break;
+    default:
+      /* Nothing to do for other states.*/
+      break;
+    }
+    break;
+  }
+}
+
 /**
  * @brief   Initializes s @p mutex_t structure.
  *
@@ -155,58 +225,9 @@ void chMtxLockS(mutex_t *mp) {
     }
     else {
 #endif
-      /* Priority inheritance protocol; explores the thread-mutex dependencies
-         boosting the priority of all the affected threads to equal the
-         priority of the running thread requesting the mutex.*/
-      thread_t *tp = mp->owner;
-
-      /* Does the running thread have higher priority than the mutex
-         owning thread? */
-      while (tp->prio < ctp->prio) {
-        /* Make priority of thread tp match the running thread's priority.*/
-        tp->prio = ctp->prio;
-
-        /* The following states need priority queues reordering.*/
-        switch (tp->state) {
-        case CH_STATE_WTMTX:
-          /* Re-enqueues the mutex owner with its new priority.*/
-          queue_prio_insert(queue_dequeue(tp), &tp->u.wtmtxp->queue);
-          tp = tp->u.wtmtxp->owner;
-          /*lint -e{9042} [16.1] Continues the while.*/
-          continue;
-#if (CH_CFG_USE_CONDVARS == TRUE) ||                                        \
-    ((CH_CFG_USE_SEMAPHORES == TRUE) &&                                     \
-     (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)) ||                           \
-    ((CH_CFG_USE_MESSAGES == TRUE) &&                                       \
-     (CH_CFG_USE_MESSAGES_PRIORITY == TRUE))
-#if CH_CFG_USE_CONDVARS == TRUE
-        case CH_STATE_WTCOND:
-#endif
-#if (CH_CFG_USE_SEMAPHORES == TRUE) &&                                      \
-    (CH_CFG_USE_SEMAPHORES_PRIORITY == TRUE)
-        case CH_STATE_WTSEM:
-#endif
-#if (CH_CFG_USE_MESSAGES == TRUE) && (CH_CFG_USE_MESSAGES_PRIORITY == TRUE)
-        case CH_STATE_SNDMSGQ:
-#endif
-          /* Re-enqueues tp with its new priority on the queue.*/
-          queue_prio_insert(queue_dequeue(tp), &tp->u.wtmtxp->queue);
-          break;
-#endif
-        case CH_STATE_READY:
-#if CH_DBG_ENABLE_ASSERTS == TRUE
-          /* Prevents an assertion in chSchReadyI().*/
-          tp->state = CH_STATE_CURRENT;
-#endif
-          /* Re-enqueues tp with its new priority on the ready list.*/
-          (void) chSchReadyI(queue_dequeue(tp));
-          break;
-        default:
-          /* Nothing to do for other states.*/
-          break;
-        }
-        break;
-      }
+      /* Priority inheritance protocol, the mutex owner gains the priority
+         of the running thread requesting the mutex.*/
+      _mtx_boost(mp->owner, ctp->prio);
 
       /* Sleep on the mutex.*/
       queue_prio_insert(ctp, &mp->queue);
@@ -308,6 +329,65 @@ bool chMtxTryLockS(mutex_t *mp) {
   return true;
 }
 
+/**
+ * @brief   Locks a mutex on behalf of a sleeping thread.
+ * @details If the mutex is not owned then it is assigned to the specified
+ *          thread, else the thread is queued on the mutex, in state
+ *          @p CH_STATE_WTMTX, as if it invoked @p chMtxLockS(). In the
+ *          latter case the thread is made ready by the unlock operation
+ *          that makes it owner of the mutex.
+ * @note    This function allows synchronization objects to move their
+ *          waiting threads directly on a mutex queue without making them
+ *          ready, this is used by the condition variables.
+ * @pre     The thread must have been removed from any queue and must not
+ *          be in the ready list.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] mp        pointer to the @p mutex_t structure
+ * @param[in] tp        pointer to the sleeping thread
+ * @return              The operation status.
+ * @retval true         if the mutex has been assigned to the thread, the
+ *                      thread must be made ready by the caller.
+ * @retval false        if the thread has been queued on the mutex.
+ *
+ * @iclass
+ */
+bool chMtxAcquireI(mutex_t *mp, thread_t *tp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((mp != NULL) && (tp != NULL));
+
+  if (mp->owner != NULL) {
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+
+    chDbgAssert(mp->cnt >= (cnt_t)1, "counter is not positive");
+
+    if (mp->owner == tp) {
+      mp->cnt++;
+      return true;
+    }
+#endif
+    /* Priority inheritance protocol then the thread is queued on the
+       mutex as if it called chMtxLockS().*/
+    _mtx_boost(mp->owner, tp->prio);
+    queue_prio_insert(tp, &mp->queue);
+    tp->u.wtmtxp = mp;
+    tp->state = CH_STATE_WTMTX;
+    return false;
+  }
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+
+  chDbgAssert(mp->cnt == (cnt_t)0, "counter is not zero");
+
+  mp->cnt++;
+#endif
+  mp->owner = tp;
+  mp->next = tp->mtxlist;
+  tp->mtxlist = mp;
+  return true;
+}
+
 /**
  * @brief   Unlocks the specified mutex.
  * @note    Mutexes must be unlocked in reverse lock order. Violating this
@@ -361,6 +441,9 @@ void chMtxUnlock(mutex_t *mp) {
         }
         lmp = lmp->next;
       }
+#if CH_CFG_USE_RWLOCKS == TRUE
+      newprio = _rwl_inherited_prio(ctp, newprio);
+#endif
 
       /* Assigns to the current thread the highest priority among all the
          waiting threads.*/
@@ -447,6 +530,9 @@ void chMtxUnlockS(mutex_t *mp) {
         }
         lmp = lmp->next;
       }
+#if CH_CFG_USE_RWLOCKS == TRUE
+      newprio = _rwl_inherited_prio(ctp, newprio);
+#endif
 
       /* Assigns to the current thread the highest priority among all the
          waiting threads.*/
@@ -507,7 +593,11 @@ void chMtxUnlockAllS(void) {
       mp->owner = NULL;
     }
   }
+#if CH_CFG_USE_RWLOCKS == TRUE
+  ctp->prio = _rwl_inherited_prio(ctp, ctp->realprio);
+#else
   ctp->prio = ctp->realprio;
+#endif
 }
 
 /**
@@ -546,7 +636,11 @@ void chMtxUnlockAll(void) {
         mp->owner = NULL;
       }
     } while (ctp->mtxlist != NULL);
+#if CH_CFG_USE_RWLOCKS == TRUE
+    ctp->prio = _rwl_inherited_prio(ctp, ctp->realprio);
+#else
     ctp->prio = ctp->realprio;
+#endif
     chSchRescheduleS();
   }
   chSysUnlock();
@@ -39,7 +39,11 @@
  *          Another possible use is for centralized threads memory management,
  *          terminating threads can pulse an event source and an event handler
  *          can perform a scansion of the registry in order to recover the
- *          memory.
+ *          memory.<br>
+ *          If @p CH_CFG_REGISTRY_HASH_SIZE is greater than zero then the
+ *          threads are also kept in a hash table indexed by name, the table
+ *          is updated on threads creation, removal and renaming, lookups by
+ *          name only scan the threads in a single bucket.
  * @pre     In order to use the threads registry the @p CH_CFG_USE_REGISTRY
  *          option must be enabled in @p chconf.h.
  * @{
@@ -73,6 +77,39 @@
   ((size_t)((char *)&((st *)0)->m - (char *)0))                             \
   /*lint -restore*/
 
+#if (CH_CFG_REGISTRY_HASH_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Computes the hash of a thread name.
+ * @note    The FNV-1a hash function is used.
+ *
+ * @param[in] name      the thread name or @p NULL
+ * @return              The name hash.
+ */
+static uint32_t reg_hash(const char *name) {
+  uint32_t hash = 2166136261U;
+
+  if (name != NULL) {
+    while (*name != '\0') {
+      hash = (hash ^ (uint32_t)(uint8_t)*name) * 16777619U;
+      name++;
+    }
+  }
+
+  return hash;
+}
+
+/**
+ * @brief   Returns the names index bucket of a hash.
+ *
+ * @param[in] hash      the name hash
+ * @return              A pointer to the bucket head.
+ */
+static inline thread_t **reg_bucket(uint32_t hash) {
+
+  return &ch.rlist.names[hash & ((uint32_t)CH_CFG_REGISTRY_HASH_SIZE - 1U)];
+}
+#endif
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -193,6 +230,28 @@ thread_t *chRegNextThread(thread_t *tp) {
  */
 thread_t *chRegFindThreadByName(const char *name) {
   thread_t *ctp;
+#if CH_CFG_REGISTRY_HASH_SIZE > 0
+  uint32_t hash = reg_hash(name);
+
+  /* Scanning the names index bucket, the hash is compared first in order
+     to skip most of the string comparisons.*/
+  chSysLock();
+  ctp = *reg_bucket(hash);
+  while (ctp != NULL) {
+    if ((ctp->namehash == hash) && (ctp->name != NULL) &&
+        (strcmp(ctp->name, name) == 0)) {
+#if CH_CFG_USE_DYNAMIC == TRUE
+      chDbgAssert(ctp->refs < (trefs_t)255, "too many references");
+      ctp->refs++;
+#endif
+      break;
+    }
+    ctp = ctp->namenext;
+  }
+  chSysUnlock();
+
+  return ctp;
+#else
 
   /* Scanning registry.*/
   ctp = chRegFirstThread();
@@ -204,6 +263,7 @@ thread_t *chRegFindThreadByName(const char *name) {
   } while (ctp != NULL);
 
   return NULL;
+#endif
 }
 
 /**
@@ -263,6 +323,76 @@ thread_t *chRegFindThreadByWorkingArea(stkalign_t *wa) {
 }
 #endif
 
+#if (CH_CFG_REGISTRY_HASH_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a thread to the registry names index.
+ * @details The thread is appended to its bucket so, among threads with
+ *          the same name, lookups return the oldest one.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+void _reg_hash_insert(thread_t *tp) {
+  thread_t **tpp;
+
+  tp->namehash = reg_hash(tp->name);
+  tp->namenext = NULL;
+  tpp = reg_bucket(tp->namehash);
+  while (*tpp != NULL) {
+    tpp = &(*tpp)->namenext;
+  }
+  *tpp = tp;
+}
+
+/**
+ * @brief   Removes a thread from the registry names index.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+void _reg_hash_remove(thread_t *tp) {
+  thread_t **tpp;
+
+  tpp = reg_bucket(tp->namehash);
+  while (*tpp != NULL) {
+    if (*tpp == tp) {
+      *tpp = tp->namenext;
+      return;
+    }
+    tpp = &(*tpp)->namenext;
+  }
+}
+
+/**
+ * @brief   Changes the name of a thread updating the names index.
+ * @note    Threads already removed from the registry are not added back
+ *          to the index.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] name      thread name as a zero terminated string
+ *
+ * @xclass
+ */
+void _reg_hash_rename(thread_t *tp, const char *name) {
+  thread_t **tpp;
+  syssts_t sts;
+
+  sts = chSysGetStatusAndLockX();
+  tpp = reg_bucket(tp->namehash);
+  while ((*tpp != NULL) && (*tpp != tp)) {
+    tpp = &(*tpp)->namenext;
+  }
+  tp->name = name;
+  if (*tpp != NULL) {
+    *tpp = tp->namenext;
+    _reg_hash_insert(tp);
+  }
+  chSysRestoreStatusX(sts);
+}
+#endif /* CH_CFG_REGISTRY_HASH_SIZE > 0 */
+
 #endif /* CH_CFG_USE_REGISTRY == TRUE */
 
 /** @} */
@@ -0,0 +1,743 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrwlock.c
+ * @brief   Reader-Writer Locks code.
+ *
+ * @addtogroup rwlocks
+ * @details Reader-writer locks related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A reader-writer lock is a threads synchronization object that
+ *          can be in three distinct states:
+ *          - Free.
+ *          - Held by one or more readers.
+ *          - Held by a single writer.
+ *          .
+ *          Operations defined for reader-writer locks:
+ *          - <b>Read Lock</b>: The lock is taken in shared mode if it is
+ *            free or held by readers and there are no writers waiting for
+ *            it, else the thread is queued.
+ *          - <b>Write Lock</b>: The lock is taken in exclusive mode if it
+ *            is free, else the thread is queued.
+ *          - <b>Unlock</b>: The lock is released, when it becomes free the
+ *            threads at the head of the queue are made owners of the lock,
+ *            either a single writer or all the readers preceding the first
+ *            queued writer.
+ *          .
+ *          Waiting threads are queued by priority, readers and writers
+ *          together. Writers are preferred: a reader cannot join a lock
+ *          held by other readers while a writer is waiting, this prevents
+ *          writers starvation.
+ *
+ *          <h2>The priority inversion problem</h2>
+ *          Reader-writer locks implement priority inheritance the same
+ *          way mutexes do, when a thread is queued on a lock all the
+ *          threads holding the lock, and the threads those are waiting
+ *          for, gain the priority of the waiting thread. Because multiple
+ *          readers can hold a lock, each thread keeps a small array of
+ *          hold records, sized by @p CH_CFG_RWLOCKS_NESTING, linking it to
+ *          the locks it holds.<br>
+ *          The inherited priority is returned when the lock is released
+ *          and when a waiting thread leaves the queue on timeout, the
+ *          priority of the holders is then recalculated from the threads
+ *          still waiting.
+ *          <h2>Constraints</h2>
+ *          - A thread cannot take again a lock it already holds, in either
+ *            mode.
+ *          - A thread can hold at most @p CH_CFG_RWLOCKS_NESTING locks at
+ *            the same time.
+ *          - Locks must be released before the thread terminates.
+ *          .
+ * @pre     In order to use the reader-writer lock APIs the
+ *          @p CH_CFG_USE_RWLOCKS option must be enabled in @p chconf.h.
+ * @post    Enabling reader-writer locks requires
+ *          3 * @p CH_CFG_RWLOCKS_NESTING pointers of extra space in the
+ *          @p thread_t structure.
+ * @{
+ */
+
+#include "ch.h"
+
+#if (CH_CFG_USE_RWLOCKS == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Finds the hold record of a thread on a lock.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] rwlp      pointer to the lock or @p NULL for a free record
+ * @return              The hold record or @p NULL if not found.
+ */
+static rwlock_hold_t *rwl_find(thread_t *tp, rwlock_t *rwlp) {
+  unsigned i;
+
+  for (i = 0U; i < (unsigned)CH_CFG_RWLOCKS_NESTING; i++) {
+    if (tp->rwholds[i].rwlp == rwlp) {
+      return &tp->rwholds[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Makes a thread an holder of the lock.
+ *
+ * @param[in] rwlp      pointer to the lock
+ * @param[in] tp        pointer to the thread
+ */
+static void rwl_hold(rwlock_t *rwlp, thread_t *tp) {
+  rwlock_hold_t *hp = rwl_find(tp, NULL);
+
+  chDbgAssert(hp != NULL, "too many locks held");
+
+  hp->rwlp = rwlp;
+  hp->next = rwlp->holders;
+  rwlp->holders = hp;
+}
+
+/**
+ * @brief   Removes a thread from the holders of the lock.
+ *
+ * @param[in] rwlp      pointer to the lock
+ * @param[in] tp        pointer to the thread
+ */
+static void rwl_release(rwlock_t *rwlp, thread_t *tp) {
+  rwlock_hold_t **hpp = &rwlp->holders;
+
+  while (*hpp != NULL) {
+    rwlock_hold_t *hp = *hpp;
+
+    if (hp->owner == tp) {
+      *hpp = hp->next;
+      hp->rwlp = NULL;
+      return;
+    }
+    hpp = &hp->next;
+  }
+
+  chDbgAssert(false, "not holder");
+}
+
+/**
+ * @brief   Assigns the lock to the threads at the head of its queue.
+ * @details Either the first writer or all the readers preceding the first
+ *          writer are made holders of the lock and readied. The new
+ *          holders inherit the priority of the threads still waiting.
+ *
+ * @param[in] rwlp      pointer to the lock
+ * @return              The operation status.
+ * @retval true         if at least one thread has been readied.
+ * @retval false        if no thread has been readied.
+ */
+static bool rwl_grant(rwlock_t *rwlp) {
+  bool granted = false;
+
+  while (queue_notempty(&rwlp->queue) && (rwlp->cnt >= (cnt_t)0)) {
+    thread_t *tp = rwlp->queue.next;
+
+    if ((tp->flags & CH_FLAG_RWWRITE) != (tmode_t)0) {
+      if (rwlp->cnt > (cnt_t)0) {
+        break;
+      }
+      tp->flags &= (tmode_t)~CH_FLAG_RWWRITE;
+      rwlp->writers--;
+      rwlp->cnt = (cnt_t)-1;
+    }
+    else {
+      rwlp->cnt++;
+    }
+    rwl_hold(rwlp, queue_fifo_remove(&rwlp->queue));
+    tp->u.rdymsg = MSG_OK;
+    (void) chSchReadyI(tp);
+    granted = true;
+  }
+
+  if (granted && queue_notempty(&rwlp->queue)) {
+    _rwl_boost(rwlp, rwlp->queue.next->prio);
+  }
+
+  return granted;
+}
+
+/**
+ * @brief   Calculates the priority a thread is entitled to.
+ * @details The priority is the highest among the thread base priority and
+ *          the priorities of the threads waiting on the owned mutexes and
+ *          on the held reader-writer locks.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The thread priority.
+ */
+static tprio_t rwl_get_prio(thread_t *tp) {
+  tprio_t newprio = tp->realprio;
+  mutex_t *mp = tp->mtxlist;
+
+  while (mp != NULL) {
+    if (queue_notempty(&mp->queue) && (mp->queue.next->prio > newprio)) {
+      newprio = mp->queue.next->prio;
+    }
+    mp = mp->next;
+  }
+
+  return _rwl_inherited_prio(tp, newprio);
+}
+
+/**
+ * @brief   Recalculates the priority of the current thread after a release.
+ *
+ * @param[in] ctp       pointer to the current thread
+ */
+static void rwl_restore_prio(thread_t *ctp) {
+
+  ctp->prio = rwl_get_prio(ctp);
+}
+
+/**
+ * @brief   Recalculates the priority of the lock holders.
+ * @details Called when a thread leaves the lock queue without taking the
+ *          lock, the holders lose the priority inherited from it. Holders
+ *          in priority ordered queues are enqueued again.
+ *
+ * @param[in] rwlp      pointer to the lock
+ */
+static void rwl_unboost(rwlock_t *rwlp) {
+  rwlock_hold_t *hp = rwlp->holders;
+
+  while (hp != NULL) {
+    thread_t *tp = hp->owner;
+    tprio_t newprio = rwl_get_prio(tp);
+
+    if (newprio < tp->prio) {
+      tp->prio = newprio;
+
+      /* The following states need priority queues reordering.*/
+      switch (tp->state) {
+      case CH_STATE_READY:
+#if CH_DBG_ENABLE_ASSERTS == TRUE
+        /* Prevents an assertion in chSchReadyI().*/
+        tp->state = CH_STATE_CURRENT;
+#endif
+        (void) chSchReadyI(queue_dequeue(tp));
+        break;
+      case CH_STATE_WTMTX:
+        queue_prio_insert(queue_dequeue(tp), &tp->u.wtmtxp->queue);
+        break;
+      case CH_STATE_WTRWLOCK:
+        queue_prio_insert(queue_dequeue(tp), &tp->u.wtrwlp->queue);
+        break;
+      default:
+        /* Nothing to do for other states.*/
+        break;
+      }
+    }
+    hp = hp->next;
+  }
+}
+
+/**
+ * @brief   Waits for the lock to be assigned.
+ *
+ * @param[in] rwlp      pointer to the lock
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      @a TIME_IMMEDIATE is not allowed
+ * @return              The wakeup message.
+ */
+static msg_t rwl_wait(rwlock_t *rwlp, systime_t timeout) {
+  thread_t *ctp = currp;
+  msg_t msg;
+
+  chDbgAssert(rwl_find(ctp, NULL) != NULL, "too many locks held");
+
+  /* Priority inheritance protocol, all the lock holders gain the priority
+     of the running thread.*/
+  _rwl_boost(rwlp, ctp->prio);
+
+  /* Sleep on the lock, the thread releasing it makes this thread an
+     holder before waking it up.*/
+  queue_prio_insert(ctp, &rwlp->queue);
+  ctp->u.wtrwlp = rwlp;
+  msg = chSchGoSleepTimeoutS(CH_STATE_WTRWLOCK, timeout);
+
+  if (msg != MSG_OK) {
+    bool granted = false;
+
+    /* A writer leaving the queue could unblock the readers queued behind
+       it.*/
+    if ((ctp->flags & CH_FLAG_RWWRITE) != (tmode_t)0) {
+      ctp->flags &= (tmode_t)~CH_FLAG_RWWRITE;
+      rwlp->writers--;
+      if (rwlp->writers == (cnt_t)0) {
+        granted = rwl_grant(rwlp);
+      }
+    }
+
+    /* The holders no longer inherit the priority of this thread.*/
+    rwl_unboost(rwlp);
+    if (granted) {
+      chSchRescheduleS();
+    }
+  }
+
+  return msg;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p rwlock_t structure.
+ *
+ * @param[out] rwlp     pointer to a @p rwlock_t structure
+ *
+ * @init
+ */
+void chRWLockObjectInit(rwlock_t *rwlp) {
+
+  chDbgCheck(rwlp != NULL);
+
+  queue_init(&rwlp->queue);
+  rwlp->holders = NULL;
+  rwlp->cnt     = (cnt_t)0;
+  rwlp->writers = (cnt_t)0;
+}
+
+/**
+ * @brief   Takes the lock in shared mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ *
+ * @api
+ */
+msg_t chRWLockReadLock(rwlock_t *rwlp) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockReadLockTimeoutS(rwlp, TIME_INFINITE);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Takes the lock in shared mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ *
+ * @sclass
+ */
+msg_t chRWLockReadLockS(rwlock_t *rwlp) {
+
+  return chRWLockReadLockTimeoutS(rwlp, TIME_INFINITE);
+}
+
+/**
+ * @brief   Takes the lock in shared mode with timeout specification.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ * @retval MSG_TIMEOUT  if the lock has not been taken within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+msg_t chRWLockReadLockTimeout(rwlock_t *rwlp, systime_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockReadLockTimeoutS(rwlp, timeout);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Takes the lock in shared mode with timeout specification.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ * @retval MSG_TIMEOUT  if the lock has not been taken within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+msg_t chRWLockReadLockTimeoutS(rwlock_t *rwlp, systime_t timeout) {
+
+  chDbgCheckClassS();
+  chDbgCheck(rwlp != NULL);
+  chDbgAssert(rwl_find(currp, rwlp) == NULL, "already holder");
+
+  /* Readers join the lock unless a writer holds it or is waiting for it.*/
+  if ((rwlp->cnt >= (cnt_t)0) && (rwlp->writers == (cnt_t)0)) {
+    rwlp->cnt++;
+    rwl_hold(rwlp, currp);
+    return MSG_OK;
+  }
+
+  if (TIME_IMMEDIATE == timeout) {
+    return MSG_TIMEOUT;
+  }
+
+  return rwl_wait(rwlp, timeout);
+}
+
+/**
+ * @brief   Tries to take the lock in shared mode.
+ * @details This function attempts to take the lock, if this is not
+ *          immediately possible then the function exits without waiting.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              The operation status.
+ * @retval true         if the lock has been successfully taken
+ * @retval false        if the lock attempt failed.
+ *
+ * @api
+ */
+bool chRWLockTryReadLock(rwlock_t *rwlp) {
+  bool b;
+
+  chSysLock();
+  b = chRWLockTryReadLockS(rwlp);
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Tries to take the lock in shared mode.
+ * @details This function attempts to take the lock, if this is not
+ *          immediately possible then the function exits without waiting.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              The operation status.
+ * @retval true         if the lock has been successfully taken
+ * @retval false        if the lock attempt failed.
+ *
+ * @sclass
+ */
+bool chRWLockTryReadLockS(rwlock_t *rwlp) {
+
+  return (bool)(chRWLockReadLockTimeoutS(rwlp, TIME_IMMEDIATE) == MSG_OK);
+}
+
+/**
+ * @brief   Releases a lock taken in shared mode.
+ * @pre     The invoking thread <b>must</b> hold the lock in shared mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ *
+ * @api
+ */
+void chRWLockReadUnlock(rwlock_t *rwlp) {
+
+  chSysLock();
+  chRWLockReadUnlockS(rwlp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases a lock taken in shared mode.
+ * @pre     The invoking thread <b>must</b> hold the lock in shared mode.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ *
+ * @sclass
+ */
+void chRWLockReadUnlockS(rwlock_t *rwlp) {
+  thread_t *ctp = currp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwlp != NULL);
+  chDbgAssert(rwlp->cnt > (cnt_t)0, "not read locked");
+
+  rwl_release(rwlp, ctp);
+  if (--rwlp->cnt == (cnt_t)0) {
+    (void) rwl_grant(rwlp);
+  }
+  rwl_restore_prio(ctp);
+}
+
+/**
+ * @brief   Takes the lock in exclusive mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ *
+ * @api
+ */
+msg_t chRWLockWriteLock(rwlock_t *rwlp) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockWriteLockTimeoutS(rwlp, TIME_INFINITE);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Takes the lock in exclusive mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ *
+ * @sclass
+ */
+msg_t chRWLockWriteLockS(rwlock_t *rwlp) {
+
+  return chRWLockWriteLockTimeoutS(rwlp, TIME_INFINITE);
+}
+
+/**
+ * @brief   Takes the lock in exclusive mode with timeout specification.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ * @retval MSG_TIMEOUT  if the lock has not been taken within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+msg_t chRWLockWriteLockTimeout(rwlock_t *rwlp, systime_t timeout) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockWriteLockTimeoutS(rwlp, timeout);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Takes the lock in exclusive mode with timeout specification.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from the lock.
+ * @retval MSG_OK       if the lock has been taken.
+ * @retval MSG_TIMEOUT  if the lock has not been taken within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+msg_t chRWLockWriteLockTimeoutS(rwlock_t *rwlp, systime_t timeout) {
+
+  chDbgCheckClassS();
+  chDbgCheck(rwlp != NULL);
+  chDbgAssert(rwl_find(currp, rwlp) == NULL, "already holder");
+
+  if (rwlp->cnt == (cnt_t)0) {
+    rwlp->cnt = (cnt_t)-1;
+    rwl_hold(rwlp, currp);
+    return MSG_OK;
+  }
+
+  if (TIME_IMMEDIATE == timeout) {
+    return MSG_TIMEOUT;
+  }
+
+  /* From now on new readers are queued behind this writer.*/
+  currp->flags |= CH_FLAG_RWWRITE;
+  rwlp->writers++;
+
+  return rwl_wait(rwlp, timeout);
+}
+
+/**
+ * @brief   Tries to take the lock in exclusive mode.
+ * @details This function attempts to take the lock, if this is not
+ *          immediately possible then the function exits without waiting.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              The operation status.
+ * @retval true         if the lock has been successfully taken
+ * @retval false        if the lock attempt failed.
+ *
+ * @api
+ */
+bool chRWLockTryWriteLock(rwlock_t *rwlp) {
+  bool b;
+
+  chSysLock();
+  b = chRWLockTryWriteLockS(rwlp);
+  chSysUnlock();
+
+  return b;
+}
+
+/**
+ * @brief   Tries to take the lock in exclusive mode.
+ * @details This function attempts to take the lock, if this is not
+ *          immediately possible then the function exits without waiting.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @return              The operation status.
+ * @retval true         if the lock has been successfully taken
+ * @retval false        if the lock attempt failed.
+ *
+ * @sclass
+ */
+bool chRWLockTryWriteLockS(rwlock_t *rwlp) {
+
+  return (bool)(chRWLockWriteLockTimeoutS(rwlp, TIME_IMMEDIATE) == MSG_OK);
+}
+
+/**
+ * @brief   Releases a lock taken in exclusive mode.
+ * @pre     The invoking thread <b>must</b> hold the lock in exclusive mode.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ *
+ * @api
+ */
+void chRWLockWriteUnlock(rwlock_t *rwlp) {
+
+  chSysLock();
+  chRWLockWriteUnlockS(rwlp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases a lock taken in exclusive mode.
+ * @pre     The invoking thread <b>must</b> hold the lock in exclusive mode.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ *
+ * @sclass
+ */
+void chRWLockWriteUnlockS(rwlock_t *rwlp) {
+  thread_t *ctp = currp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwlp != NULL);
+  chDbgAssert(rwlp->cnt == (cnt_t)-1, "not write locked");
+
+  rwl_release(rwlp, ctp);
+  rwlp->cnt = (cnt_t)0;
+  (void) rwl_grant(rwlp);
+  rwl_restore_prio(ctp);
+}
+
+/**
+ * @brief   Boosts the priority of all the lock holders.
+ * @note    Part of the priority inheritance protocol, the function is
+ *          mutually recursive with @p _mtx_boost() in order to follow
+ *          holders waiting on other locks.
+ *
+ * @param[in] rwlp      pointer to the @p rwlock_t structure
+ * @param[in] prio      priority of the requesting thread
+ *
+ * @notapi
+ */
+void _rwl_boost(rwlock_t *rwlp, tprio_t prio) {
+  rwlock_hold_t *hp = rwlp->holders;
+
+  while (hp != NULL) {
+    _mtx_boost(hp->owner, prio);
+    hp = hp->next;
+  }
+}
+
+/**
+ * @brief   Priority inherited through the held reader-writer locks.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] prio      priority inherited from other sources
+ * @return              The highest among @p prio and the priorities of the
+ *                      threads waiting on the locks held by @p tp.
+ *
+ * @notapi
+ */
+tprio_t _rwl_inherited_prio(thread_t *tp, tprio_t prio) {
+  unsigned i;
+
+  for (i = 0U; i < (unsigned)CH_CFG_RWLOCKS_NESTING; i++) {
+    rwlock_t *rwlp = tp->rwholds[i].rwlp;
+
+    if ((rwlp != NULL) && queue_notempty(&rwlp->queue) &&
+        (rwlp->queue.next->prio > prio)) {
+      prio = rwlp->queue.next->prio;
+    }
+  }
+
+  return prio;
+}
+
+#endif /* CH_CFG_USE_RWLOCKS == TRUE */
+
+/** @} */
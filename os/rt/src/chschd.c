@@ -63,12 +63,20 @@ ch_system_t ch;
  * @notapi
  */
 void _scheduler_init(void) {
+#if (CH_CFG_USE_REGISTRY == TRUE) && (CH_CFG_REGISTRY_HASH_SIZE > 0)
+  unsigned i;
+#endif
 
   queue_init(&ch.rlist.queue);
   ch.rlist.prio = NOPRIO;
 #if CH_CFG_USE_REGISTRY == TRUE
   ch.rlist.newer = (thread_t *)&ch.rlist;
   ch.rlist.older = (thread_t *)&ch.rlist;
+#if CH_CFG_REGISTRY_HASH_SIZE > 0
+  for (i = 0U; i < (unsigned)CH_CFG_REGISTRY_HASH_SIZE; i++) {
+    ch.rlist.names[i] = NULL;
+  }
+#endif
 #endif
 }
 
@@ -202,7 +210,8 @@ thread_t *list_remove(threads_list_t *tlp) {
 /**
  * @brief   Inserts a thread in the Ready List placing it behind its peers.
  * @details The thread is positioned behind all threads with higher or equal
- *          priority.
+ *          priority, threads in the EDF class are positioned behind the
+ *          peers with earlier or equal deadline.
  * @pre     The thread must not be already inserted in any list through its
  *          @p next and @p prev or list corruption would occur.
  * @post    This function does not reschedule so a call to a rescheduling
@@ -226,9 +235,20 @@ thread_t *chSchReadyI(thread_t *tp) {
 
   tp->state = CH_STATE_READY;
   cp = (thread_t *)&ch.rlist.queue;
-  do {
-    cp = cp->queue.next;
-  } while (cp->prio >= tp->prio);
+#if CH_CFG_USE_EDF == TRUE
+  if (tp->prio == CH_CFG_EDF_PRIO) {
+    do {
+      cp = cp->queue.next;
+    } while ((cp->prio > tp->prio) ||
+             ((cp->prio == tp->prio) && !edf_is_earlier(tp, cp)));
+  }
+  else
+#endif
+  {
+    do {
+      cp = cp->queue.next;
+    } while (cp->prio >= tp->prio);
+  }
   /* Insertion on prev.*/
   tp->queue.next             = cp;
   tp->queue.prev             = cp->queue.prev;
@@ -241,7 +261,8 @@ thread_t *chSchReadyI(thread_t *tp) {
 /**
  * @brief   Inserts a thread in the Ready List placing it ahead its peers.
  * @details The thread is positioned ahead all threads with higher or equal
- *          priority.
+ *          priority, threads in the EDF class are positioned ahead of the
+ *          peers with later or equal deadline.
  * @pre     The thread must not be already inserted in any list through its
  *          @p next and @p prev or list corruption would occur.
  * @post    This function does not reschedule so a call to a rescheduling
@@ -265,9 +286,20 @@ thread_t *chSchReadyAheadI(thread_t *tp) {
 
   tp->state = CH_STATE_READY;
   cp = (thread_t *)&ch.rlist.queue;
-  do {
-    cp = cp->queue.next;
-  } while (cp->prio > tp->prio);
+#if CH_CFG_USE_EDF == TRUE
+  if (tp->prio == CH_CFG_EDF_PRIO) {
+    do {
+      cp = cp->queue.next;
+    } while ((cp->prio > tp->prio) ||
+             ((cp->prio == tp->prio) && edf_is_earlier(cp, tp)));
+  }
+  else
+#endif
+  {
+    do {
+      cp = cp->queue.next;
+    } while (cp->prio > tp->prio);
+  }
   /* Insertion on prev.*/
   tp->queue.next             = cp;
   tp->queue.prev             = cp->queue.prev;
@@ -329,6 +361,14 @@ static void wakeup(void *p) {
   case CH_STATE_SUSPENDED:
     *tp->u.wttrp = NULL;
     break;
+#if (CH_CFG_USE_CONDVARS == TRUE) && (CH_CFG_USE_CONDVARS_TIMEOUT == TRUE)
+  case CH_STATE_WTMTX:
+    /* Handling the special case where the thread has been signaled by a
+       condition variable and moved on the queue of the mutex to be
+       reacquired, the timeout no more applies.*/
+    chSysUnlockFromISR();
+    return;
+#endif
 #if CH_CFG_USE_SEMAPHORES == TRUE
   case CH_STATE_WTSEM:
     chSemFastSignalI(tp->u.wtsemp);
@@ -336,6 +376,9 @@ static void wakeup(void *p) {
 #endif
 #if (CH_CFG_USE_CONDVARS == TRUE) && (CH_CFG_USE_CONDVARS_TIMEOUT == TRUE)
   case CH_STATE_WTCOND:
+#endif
+#if CH_CFG_USE_RWLOCKS == TRUE
+  case CH_STATE_WTRWLOCK:
 #endif
   case CH_STATE_QUEUED:
     /* States requiring dequeuing.*/
@@ -373,12 +416,42 @@ static void wakeup(void *p) {
  */
 msg_t chSchGoSleepTimeoutS(tstate_t newstate, systime_t time) {
 
+  return chSchGoSleepTimeoutWithSlackS(newstate, time, (systime_t)0);
+}
+
+/**
+ * @brief   Puts the current thread to sleep into the specified state with
+ *          timeout and slack specification.
+ * @details The thread goes into a sleeping state, if it is not awakened
+ *          explicitly within the specified timeout then it is forcibly
+ *          awakened with a @p MSG_TIMEOUT low level message. The timeout
+ *          can be delayed up to @p slack ticks in order to be served
+ *          together with other timers.
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[in] newstate  the new thread state
+ * @param[in] time      the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE the thread enters an infinite sleep
+ *                        state, this is equivalent to invoking
+ *                        @p chSchGoSleepS() but, of course, less efficient.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable timeout delay in ticks
+ * @return              The wakeup message.
+ * @retval MSG_TIMEOUT  if a timeout occurs.
+ *
+ * @sclass
+ */
+msg_t chSchGoSleepTimeoutWithSlackS(tstate_t newstate, systime_t time,
+                                    systime_t slack) {
+
   chDbgCheckClassS();
 
   if (TIME_INFINITE != time) {
     virtual_timer_t vt;
 
-    chVTDoSetI(&vt, time, wakeup, currp);
+    chVTDoSetWithSlackI(&vt, time, slack, wakeup, currp);
     chSchGoSleepS(newstate);
     if (chVTIsArmedI(&vt)) {
       chVTDoResetI(&vt);
@@ -414,7 +487,7 @@ void chSchWakeupS(thread_t *ntp, msg_t msg) {
   chDbgCheckClassS();
 
   chDbgAssert((ch.rlist.queue.next == (thread_t *)&ch.rlist.queue) ||
-              (ch.rlist.current->prio >= ch.rlist.queue.next->prio),
+              !sch_is_ahead(ch.rlist.queue.next, ch.rlist.current),
               "priority order violation");
 
   /* Storing the message to be retrieved by the target thread when it will
@@ -425,7 +498,7 @@ void chSchWakeupS(thread_t *ntp, msg_t msg) {
      one then it is just inserted in the ready list else it made
      running immediately and the invoking thread goes in the ready
      list instead.*/
-  if (ntp->prio <= otp->prio) {
+  if (!sch_is_ahead(ntp, otp)) {
     (void) chSchReadyI(ntp);
   }
   else {
@@ -475,19 +548,19 @@ void chSchRescheduleS(void) {
  * @special
  */
 bool chSchIsPreemptionRequired(void) {
-  tprio_t p1 = firstprio(&ch.rlist.queue);
-  tprio_t p2 = currp->prio;
+  thread_t *ntp = ch.rlist.queue.next;
 
 #if CH_CFG_TIME_QUANTUM > 0
   /* If the running thread has not reached its time quantum, reschedule only
      if the first thread on the ready queue has a higher priority.
      Otherwise, if the running thread has used up its time quantum, reschedule
      if the first thread on the ready queue has equal or higher priority.*/
-  return (currp->preempt > (tslices_t)0) ? (p1 > p2) : (p1 >= p2);
+  return (currp->preempt > (tslices_t)0) ? sch_is_ahead(ntp, currp) :
+                                           !sch_is_ahead(currp, ntp);
 #else
   /* If the round robin preemption feature is not enabled then performs a
      simpler comparison.*/
-  return p1 > p2;
+  return sch_is_ahead(ntp, currp);
 #endif
 }
 
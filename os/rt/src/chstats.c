@@ -65,6 +65,10 @@ void _stats_init(void) {
   ch.kernel_stats.n_ctxswc = (ucnt_t)0;
   chTMObjectInit(&ch.kernel_stats.m_crit_thd);
   chTMObjectInit(&ch.kernel_stats.m_crit_isr);
+#if CH_CFG_ST_TIMEDELTA > 0
+  ch.kernel_stats.n_vtalarms = (ucnt_t)0;
+  ch.kernel_stats.n_vtsaved = (ucnt_t)0;
+#endif
 }
 
 /**
@@ -121,6 +125,24 @@ void _stats_stop_measure_crit_isr(void) {
   chTMStopMeasurementX(&ch.kernel_stats.m_crit_isr);
 }
 
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Increases the virtual timers alarms counter.
+ */
+void _stats_increase_vt_alarms(void) {
+
+  ch.kernel_stats.n_vtalarms++;
+}
+
+/**
+ * @brief   Increases the saved virtual timers alarms counter.
+ */
+void _stats_increase_vt_saved(void) {
+
+  ch.kernel_stats.n_vtsaved++;
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+
 #endif /* CH_DBG_STATISTICS == TRUE */
 
 /** @} */
@@ -35,6 +35,19 @@
 
 #include "ch.h"
 
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @name    Incremental integrity checker phases
+ * @{
+ */
+#define INTEGRITY_START                     0U
+#define INTEGRITY_THREADS                   1U
+#define INTEGRITY_TIMERS                    2U
+/** @} */
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
@@ -83,6 +96,149 @@ static void _idle_thread(void *p) {
 }
 #endif /* CH_CFG_NO_IDLE_THREAD == FALSE */
 
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Checks the links of a thread inserted in a threads queue.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The test result.
+ * @retval false        The test succeeded.
+ * @retval true         Test failed.
+ */
+static bool integrity_queue_links(thread_t *tp) {
+
+  return (tp->queue.next->queue.prev != tp) ||
+         (tp->queue.prev->queue.next != tp);
+}
+
+/**
+ * @brief   Checks a single thread and the objects it is related to.
+ * @details The queue the thread is inserted in, the mutexes it owns and
+ *          the canary at the base of its working area are verified.
+ * @note    Semaphore queues and mutex lists are only walked within the
+ *          remaining nodes budget, longer structures are only checked for
+ *          local consistency.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in,out] np    pointer to the remaining nodes budget, it is
+ *                      decreased by the number of additional nodes visited
+ * @return              The test result.
+ * @retval false        The test succeeded.
+ * @retval true         Test failed.
+ */
+static bool integrity_check_thread(thread_t *tp, unsigned *np) {
+
+#if (CH_CFG_USE_SEMAPHORES == FALSE) && (CH_CFG_USE_MUTEXES == FALSE)
+  (void)np;
+#endif
+
+  /* Registry links.*/
+  if ((tp->newer->older != tp) || (tp->older->newer != tp)) {
+    return true;
+  }
+
+  switch (tp->state) {
+  case CH_STATE_CURRENT:
+    if (tp != currp) {
+      return true;
+    }
+    break;
+  case CH_STATE_READY:
+    /* The ready list is ordered by decreasing priority, the list header
+       has the lowest possible priority.*/
+    if (integrity_queue_links(tp) || (tp->queue.next->prio > tp->prio)) {
+      return true;
+    }
+    if ((tp->queue.prev != (thread_t *)&ch.rlist.queue) &&
+        (tp->queue.prev->prio < tp->prio)) {
+      return true;
+    }
+    break;
+#if CH_CFG_USE_SEMAPHORES == TRUE
+  case CH_STATE_WTSEM:
+    {
+      semaphore_t *sp = tp->u.wtsemp;
+
+      if (integrity_queue_links(tp) || (sp->cnt >= (cnt_t)0)) {
+        return true;
+      }
+
+      /* The number of waiting threads must match the negated counter, the
+         queue is walked when its first thread is checked.*/
+      if ((tp == sp->queue.next) && ((unsigned)-sp->cnt <= *np)) {
+        thread_t *wtp = tp;
+        cnt_t n = sp->cnt;
+
+        while (n < (cnt_t)0) {
+          if (wtp == (thread_t *)&sp->queue) {
+            return true;
+          }
+          wtp = wtp->queue.next;
+          n++;
+        }
+        if (wtp != (thread_t *)&sp->queue) {
+          return true;
+        }
+        *np -= (unsigned)-sp->cnt;
+      }
+    }
+    break;
+#endif
+#if CH_CFG_USE_MUTEXES == TRUE
+  case CH_STATE_WTMTX:
+    if (integrity_queue_links(tp) || (tp->u.wtmtxp->owner == NULL)) {
+      return true;
+    }
+    break;
+#endif
+  default:
+    break;
+  }
+
+#if CH_CFG_USE_MUTEXES == TRUE
+  {
+    mutex_t *mp = tp->mtxlist;
+
+    /* Priority inheritance can only raise the priority.*/
+    if (tp->prio < tp->realprio) {
+      return true;
+    }
+
+    /* Owned mutexes.*/
+    while ((mp != NULL) && (*np > 0U)) {
+      if (mp->owner != tp) {
+        return true;
+      }
+#if CH_CFG_USE_MUTEXES_RECURSIVE == TRUE
+      if (mp->cnt <= (cnt_t)0) {
+        return true;
+      }
+#endif
+      mp = mp->next;
+      (*np)--;
+    }
+  }
+#endif
+
+#if (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE)
+  /* Stack canary, the main thread does not have one and the working area
+     of a terminated thread could have been reused.*/
+  if ((tp != &ch.mainthread) && (tp->state != CH_STATE_FINAL)) {
+    uint8_t *p = (uint8_t *)tp->wabase;
+    unsigned i;
+
+    for (i = 0U; i < CH_INTEGRITY_CANARY_SIZE; i++) {
+      if (p[i] != (uint8_t)CH_DBG_STACK_FILL_VALUE) {
+        return true;
+      }
+    }
+  }
+#endif
+
+  return false;
+}
+#endif /* CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -119,6 +275,18 @@ void chSysInit(void) {
 #if CH_DBG_STATISTICS == TRUE
   _stats_init();
 #endif
+#if CH_CFG_USE_EDF == TRUE
+  _edf_init();
+#endif
+#if CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE
+  ch.integrity.phase  = INTEGRITY_START;
+  ch.integrity.thread = NULL;
+  ch.integrity.timer  = NULL;
+  ch.integrity.passes = (ucnt_t)0;
+#if CH_CFG_USE_TM == TRUE
+  chTMObjectInit(&ch.integrity.tm);
+#endif
+#endif
 
 #if CH_CFG_NO_IDLE_THREAD == FALSE
   /* Now this instructions flow becomes the main thread.*/
@@ -175,6 +343,11 @@ void chSysInit(void) {
     (void) chThdCreate(&idle_descriptor);
   }
 #endif
+
+#if CH_CFG_USE_WORKQUEUES == TRUE
+  /* System work queue workers.*/
+  _workq_init();
+#endif
 }
 
 /**
@@ -321,6 +494,130 @@ bool chSysIntegrityCheckI(unsigned testmask) {
   return false;
 }
 
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Incremental system integrity check.
+ * @details Performs part of an integrity check pass on the kernel data
+ *          structures, the check resumes where the previous invocation
+ *          left it. A pass checks the ready list, registry and timers list
+ *          headers then each registered thread, including its queue links,
+ *          semaphore counters, owned mutexes and stack canary, and finally
+ *          each armed virtual timer.
+ * @note    Threads and timers created during a pass are checked in the
+ *          next one. Objects removed during a pass are skipped.
+ * @note    The number of completed passes is available in
+ *          @p ch.integrity.passes.
+ *
+ * @param[in] n         maximum number of nodes to be checked, it must be
+ *                      greater than zero
+ * @return              The test result.
+ * @retval false        The test succeeded.
+ * @retval true         Test failed, the failing node is checked again by
+ *                      the next invocation.
+ *
+ * @iclass
+ */
+bool chSysIntegrityStepI(unsigned n) {
+  system_integrity_t *sip = &ch.integrity;
+
+  chDbgCheckClassI();
+  chDbgCheck(n > 0U);
+
+  while (n > 0U) {
+    switch (sip->phase) {
+    case INTEGRITY_START:
+      /* Lists headers.*/
+      if ((ch.rlist.queue.next->queue.prev != (thread_t *)&ch.rlist.queue) ||
+          (ch.rlist.queue.prev->queue.next != (thread_t *)&ch.rlist.queue) ||
+          (ch.rlist.newer->older != (thread_t *)&ch.rlist) ||
+          (ch.rlist.older->newer != (thread_t *)&ch.rlist) ||
+          (ch.vtlist.next->prev != (virtual_timer_t *)&ch.vtlist) ||
+          (ch.vtlist.prev->next != (virtual_timer_t *)&ch.vtlist) ||
+          (ch.vtlist.delta != (systime_t)-1) ||
+          (currp->state != CH_STATE_CURRENT)) {
+        return true;
+      }
+#if defined(PORT_INTEGRITY_CHECK)
+      PORT_INTEGRITY_CHECK();
+#endif
+      sip->thread = ch.rlist.newer;
+      sip->phase  = INTEGRITY_THREADS;
+      n--;
+      break;
+    case INTEGRITY_THREADS:
+      if (sip->thread == (thread_t *)&ch.rlist) {
+        sip->timer = ch.vtlist.next;
+        sip->phase = INTEGRITY_TIMERS;
+      }
+      else {
+        n--;
+        if (integrity_check_thread(sip->thread, &n)) {
+          return true;
+        }
+        sip->thread = sip->thread->newer;
+      }
+      break;
+    case INTEGRITY_TIMERS:
+      if (sip->timer == (virtual_timer_t *)&ch.vtlist) {
+        sip->passes++;
+        sip->phase = INTEGRITY_START;
+      }
+      else {
+        virtual_timer_t *vtp = sip->timer;
+
+        n--;
+        if ((vtp->next->prev != vtp) || (vtp->prev->next != vtp) ||
+            (vtp->func == NULL)) {
+          return true;
+        }
+        sip->timer = vtp->next;
+      }
+      break;
+    default:
+      chDbgAssert(false, "invalid phase");
+      break;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief   Incremental system integrity check.
+ * @details Performs part of an integrity check pass on the kernel data
+ *          structures, see @p chSysIntegrityStepI(). The critical zone
+ *          is limited to the specified number of nodes so the function
+ *          can be invoked from the idle hook or from a low priority thread
+ *          without affecting the system latency.
+ * @note    If @p CH_CFG_USE_TM is enabled then the time spent in the
+ *          critical zone is measured in @p ch.integrity.tm, the
+ *          @p worst field holds the longest critical zone.
+ *
+ * @param[in] n         maximum number of nodes to be checked, it must be
+ *                      greater than zero
+ * @return              The test result.
+ * @retval false        The test succeeded.
+ * @retval true         Test failed.
+ *
+ * @api
+ */
+bool chSysIntegrityStep(unsigned n) {
+  bool result;
+
+  chSysLock();
+#if CH_CFG_USE_TM == TRUE
+  chTMStartMeasurementX(&ch.integrity.tm);
+#endif
+  result = chSysIntegrityStepI(n);
+#if CH_CFG_USE_TM == TRUE
+  chTMStopMeasurementX(&ch.integrity.tm);
+#endif
+  chSysUnlock();
+
+  return result;
+}
+#endif /* CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE */
+
 /**
  * @brief   Handles time ticks for round robin preemption and timer increments.
  * @details Decrements the remaining time quantum of the running thread
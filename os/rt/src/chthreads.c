@@ -86,6 +86,9 @@
  * @notapi
  */
 thread_t *_thread_init(thread_t *tp, const char *name, tprio_t prio) {
+#if CH_CFG_USE_RWLOCKS == TRUE
+  unsigned i;
+#endif
 
   tp->prio      = prio;
   tp->state     = CH_STATE_WTSTART;
@@ -97,9 +100,18 @@ thread_t *_thread_init(thread_t *tp, const char *name, tprio_t prio) {
   tp->realprio  = prio;
   tp->mtxlist   = NULL;
 #endif
+#if CH_CFG_USE_RWLOCKS == TRUE
+  for (i = 0U; i < (unsigned)CH_CFG_RWLOCKS_NESTING; i++) {
+    tp->rwholds[i].owner = tp;
+    tp->rwholds[i].rwlp  = NULL;
+  }
+#endif
 #if CH_CFG_USE_EVENTS == TRUE
   tp->epending  = (eventmask_t)0;
 #endif
+#if CH_CFG_USE_EDF == TRUE
+  tp->edf.period = (systime_t)0;
+#endif
 #if CH_DBG_THREADS_PROFILING == TRUE
   tp->time      = (systime_t)0;
 #endif
@@ -123,7 +135,8 @@ thread_t *_thread_init(thread_t *tp, const char *name, tprio_t prio) {
   return tp;
 }
 
-#if (CH_DBG_FILL_THREADS == TRUE) || defined(__DOXYGEN__)
+#if (CH_DBG_FILL_THREADS == TRUE) ||                                        \
+    (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) || defined(__DOXYGEN__)
 /**
  * @brief   Memory fill utility.
  *
@@ -139,7 +152,8 @@ void _thread_memfill(uint8_t *startp, uint8_t *endp, uint8_t v) {
     *startp++ = v;
   }
 }
-#endif /* CH_DBG_FILL_THREADS */
+#endif /* (CH_DBG_FILL_THREADS == TRUE) ||
+          (CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE) */
 
 /**
  * @brief   Creates a new thread into a static memory area.
@@ -186,6 +200,13 @@ thread_t *chThdCreateSuspendedI(const thread_descriptor_t *tdp) {
   tp->wabase = tdp->wbase;
 #endif
 
+#if CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE
+  /* Stack canary.*/
+  _thread_memfill((uint8_t *)tdp->wbase,
+                  (uint8_t *)tdp->wbase + CH_INTEGRITY_CANARY_SIZE,
+                  CH_DBG_STACK_FILL_VALUE);
+#endif
+
   /* Setting up the port-dependent part of the working area.*/
   PORT_SETUP_CONTEXT(tp, tdp->wbase, tp, tdp->funcp, tdp->arg);
 
@@ -353,6 +374,13 @@ thread_t *chThdCreateStatic(void *wsp, size_t size,
   tp->wabase = (stkalign_t *)wsp;
 #endif
 
+#if CH_DBG_ENABLE_INTEGRITY_STEPS == TRUE
+  /* Stack canary.*/
+  _thread_memfill((uint8_t *)wsp,
+                  (uint8_t *)wsp + CH_INTEGRITY_CANARY_SIZE,
+                  CH_DBG_STACK_FILL_VALUE);
+#endif
+
   /* Setting up the port-dependent part of the working area.*/
   PORT_SETUP_CONTEXT(tp, wsp, tp, pf, arg);
 
@@ -505,6 +533,13 @@ void chThdExitS(msg_t msg) {
   /* Exit handler hook.*/
   CH_CFG_THREAD_EXIT_HOOK(tp);
 
+#if CH_CFG_USE_EDF == TRUE
+  /* Releasing the thread load, waiting threads can reuse it.*/
+  if (tp->edf.period > (systime_t)0) {
+    _edf_leave(tp);
+  }
+#endif
+
 #if CH_CFG_USE_WAITEXIT == TRUE
   /* Waking up any waiting thread.*/
   while (list_notempty(&tp->waiting)) {
@@ -599,6 +634,9 @@ tprio_t chThdSetPriority(tprio_t newprio) {
   chDbgCheck(newprio <= HIGHPRIO);
 
   chSysLock();
+#if CH_CFG_USE_EDF == TRUE
+  chDbgAssert(currp->edf.period == (systime_t)0, "EDF thread");
+#endif
 #if CH_CFG_USE_MUTEXES == TRUE
   oldprio = currp->realprio;
   if ((currp->prio == currp->realprio) || (newprio > currp->prio)) {
@@ -653,6 +691,30 @@ void chThdSleep(systime_t time) {
   chSysUnlock();
 }
 
+/**
+ * @brief   Suspends the invoking thread for the specified time with slack.
+ * @details The wakeup can be delayed up to @p slack ticks in order to be
+ *          served together with other timers, this reduces the number of
+ *          wakeups in tick-less mode.
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[in] time      the delay in system ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE the thread enters an infinite sleep
+ *                        state.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable wakeup delay in system ticks
+ *
+ * @api
+ */
+void chThdSleepWithSlack(systime_t time, systime_t slack) {
+
+  chSysLock();
+  chThdSleepWithSlackS(time, slack);
+  chSysUnlock();
+}
+
 /**
  * @brief   Suspends the invoking thread until the system time arrives to the
  *          specified value.
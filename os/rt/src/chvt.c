@@ -48,10 +48,131 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Latest acceptable expiration of a timer.
+ * @note    A slack exceeding the numeric range is ignored.
+ *
+ * @param[in] delta     timer deadline relative to the delta list base time
+ * @param[in] slack     timer slack
+ * @return              The end of the timer expiration window relative
+ *                      to the delta list base time.
+ */
+static systime_t vt_window(systime_t delta, systime_t slack) {
+  systime_t limit = delta + slack;
+
+  if (limit < delta) {
+    return delta;
+  }
+
+  return limit;
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
 
+/**
+ * @brief   Re-arms a continuous virtual timer.
+ * @details The timer is inserted again in the delta list relative to the
+ *          deadline just expired, this way the period does not accumulate
+ *          drift. Deadlines already in the past are skipped and counted
+ *          as overruns.
+ * @note    Internal use only, invoked by @p chVTDoTickI() when the delta
+ *          list base time is the deadline of the expired timer.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] now       the current system time
+ *
+ * @notapi
+ */
+void _vt_rearm(virtual_timer_t *vtp, systime_t now) {
+  virtual_timer_t *p;
+  systime_t delta = vtp->reload;
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  {
+    systime_t elapsed = now - ch.vtlist.lasttime;
+
+    /* Late processing, the deadlines that are already in the past are
+       skipped.*/
+    if (elapsed > delta) {
+      systime_t missed = (elapsed - (systime_t)1) / delta;
+
+      vtp->overruns += (ucnt_t)missed;
+      delta += missed * delta;
+    }
+  }
+#else /* CH_CFG_ST_TIMEDELTA == 0 */
+  (void)now;
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+
+  /* The delta list is scanned in order to find the correct position for
+     this timer, the list base time is the previous deadline.*/
+  p = ch.vtlist.next;
+  while (p->delta < delta) {
+    delta -= p->delta;
+    p = p->next;
+  }
+
+  /* The timer is inserted in the delta list.*/
+  vtp->next = p;
+  vtp->prev = vtp->next->prev;
+  vtp->prev->next = vtp;
+  p->prev = vtp;
+  vtp->delta = delta;
+
+  /* Special case when the timer is in last position in the list, the
+     value in the header must be restored.*/
+  p->delta -= delta;
+  ch.vtlist.delta = (systime_t)-1;
+}
+
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Programs the alarm for the timers on top of the delta list.
+ * @details The alarm is delayed as much as allowed by the slack of the
+ *          timers having a deadline before it, all those timers are then
+ *          served by a single alarm.
+ * @pre     The delta list must not be empty and its first timer must not
+ *          be already expired.
+ * @note    Internal use only.
+ *
+ * @param[in] now       the current system time
+ *
+ * @notapi
+ */
+void _vt_set_alarm(systime_t now) {
+  virtual_timer_t *vtp = ch.vtlist.next;
+  systime_t deadline, limit, delta;
+
+  /* The alarm is the earliest end of the expiration windows of the timers
+     falling before it. Without slack the scan stops on the second timer,
+     the header delta is greater than any window and stops it anyway.*/
+  deadline = vtp->delta;
+  limit = vt_window(deadline, vtp->slack);
+  vtp = vtp->next;
+  while (vtp->delta < (systime_t)(limit - deadline)) {
+    deadline += vtp->delta;
+    delta = vt_window(deadline, vtp->slack);
+    if (delta < limit) {
+      limit = delta;
+    }
+    vtp = vtp->next;
+  }
+
+  /* Making sure to not schedule an event closer than CH_CFG_ST_TIMEDELTA
+     ticks from now.*/
+  delta = ch.vtlist.lasttime + limit - now;
+  if (delta < (systime_t)CH_CFG_ST_TIMEDELTA) {
+    delta = (systime_t)CH_CFG_ST_TIMEDELTA;
+  }
+  ch.vtlist.alarm = now + delta;
+  port_timer_set_alarm(ch.vtlist.alarm);
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+
 /**
  * @brief   Virtual Timers initialization.
  * @note    Internal use only.
@@ -67,6 +188,7 @@ void _vt_init(void) {
   ch.vtlist.systime = (systime_t)0;
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
   ch.vtlist.lasttime = (systime_t)0;
+  ch.vtlist.alarm = (systime_t)0;
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
 
@@ -94,6 +216,39 @@ void _vt_init(void) {
  */
 void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                 vtfunc_t vtfunc, void *par) {
+
+  chVTDoSetWithSlackI(vtp, delay, (systime_t)0, vtfunc, par);
+}
+
+/**
+ * @brief   Enables a virtual timer with slack.
+ * @details The timer is enabled and programmed to trigger after the delay
+ *          specified as parameter. The expiration can be delayed up to
+ *          @p slack ticks in order to serve it with the same alarm of
+ *          other timers, this reduces the number of wakeups in tick-less
+ *          mode.
+ * @pre     The timer must not be already armed before calling this function.
+ * @note    The callback function is invoked from interrupt context.
+ * @note    The slack is ignored when the kernel is in periodic tick mode.
+ *
+ * @param[out] vtp      the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] slack     the acceptable expiration delay in ticks
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+void chVTDoSetWithSlackI(virtual_timer_t *vtp, systime_t delay,
+                         systime_t slack, vtfunc_t vtfunc, void *par) {
   virtual_timer_t *p;
   systime_t delta;
 
@@ -102,8 +257,11 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
 
   vtp->par = par;
   vtp->func = vtfunc;
+  vtp->reload = (systime_t)0;
+  vtp->overruns = (ucnt_t)0;
 
 #if CH_CFG_ST_TIMEDELTA > 0
+  vtp->slack = slack;
   {
     systime_t now = chVTGetSystemTimeX();
 
@@ -125,8 +283,10 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
       vtp->prev = (virtual_timer_t *)&ch.vtlist;
       vtp->delta = delay;
 
-      /* Being the first element in the list the alarm timer is started.*/
-      port_timer_start_alarm(ch.vtlist.lasttime + delay);
+      /* Being the first element in the list the alarm timer is started,
+         as late as the timer slack allows.*/
+      ch.vtlist.alarm = now + vt_window(delay, slack);
+      port_timer_start_alarm(ch.vtlist.alarm);
 
       return;
     }
@@ -145,13 +305,20 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
       delta -= p->delta;
       p = p->next;
     }
-    else if (delta < p->delta) {
-     /* A small delay that will become the first element in the delta list
-        and next deadline.*/
-      port_timer_set_alarm(ch.vtlist.lasttime + delta);
+    else if (delta < (systime_t)(ch.vtlist.alarm - ch.vtlist.lasttime)) {
+      /* The timer expires before the programmed alarm, the alarm is
+         anticipated unless the timer slack covers it.*/
+      systime_t limit = vt_window(delta, slack);
+
+      if (limit < (systime_t)(ch.vtlist.alarm - ch.vtlist.lasttime)) {
+        ch.vtlist.alarm = ch.vtlist.lasttime + limit;
+        port_timer_set_alarm(ch.vtlist.alarm);
+      }
     }
   }
 #else /* CH_CFG_ST_TIMEDELTA == 0 */
+  (void)slack;
+
   /* Delta is initially equal to the specified delay.*/
   delta = delay;
 
@@ -179,6 +346,40 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
   ch.vtlist.delta = (systime_t)-1;
 }
 
+/**
+ * @brief   Enables a continuous virtual timer.
+ * @details The timer is enabled and programmed to trigger periodically
+ *          with the interval specified as parameter. Each expiration is
+ *          scheduled relative to the previous deadline so the period does
+ *          not accumulate drift, expirations missed because late timers
+ *          processing are counted as overruns.
+ * @pre     The timer must not be already armed before calling this function.
+ * @note    The callback function is invoked from interrupt context.
+ * @note    The timer is re-armed before invoking the callback, the timer
+ *          can be stopped from within its callback using
+ *          @p chVTDoResetI().
+ *
+ * @param[out] vtp      the @p virtual_timer_t structure pointer
+ * @param[in] delay     the timer period in ticks, the special values are
+ *                      handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. The timer stays armed
+ *                      after invoking the callback.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+void chVTDoSetContinuousI(virtual_timer_t *vtp, systime_t delay,
+                          vtfunc_t vtfunc, void *par) {
+
+  chVTDoSetI(vtp, delay, vtfunc, par);
+  vtp->reload = delay;
+}
+
 /**
  * @brief   Disables a Virtual Timer.
  * @pre     The timer must be in armed state before calling this function.
@@ -202,12 +403,13 @@ void chVTDoResetI(virtual_timer_t *vtp) {
   vtp->prev->next = vtp->next;
   vtp->next->prev = vtp->prev;
   vtp->func = NULL;
+  _integrity_timer_removed(vtp);
 
   /* The above code changes the value in the header when the removed element
      is the last of the list, restoring it.*/
   ch.vtlist.delta = (systime_t)-1;
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
-  systime_t nowdelta, delta;
+  systime_t now;
 
   /* If the timer is not the first of the list then it is simply unlinked
      else the operation is more complex.*/
@@ -216,6 +418,7 @@ void chVTDoResetI(virtual_timer_t *vtp) {
     vtp->prev->next = vtp->next;
     vtp->next->prev = vtp->prev;
     vtp->func = NULL;
+    _integrity_timer_removed(vtp);
 
     /* Adding delta to the next element, if it is not the last one.*/
     if (&ch.vtlist != (virtual_timers_list_t *)vtp->next)
@@ -228,6 +431,7 @@ void chVTDoResetI(virtual_timer_t *vtp) {
   ch.vtlist.next = vtp->next;
   ch.vtlist.next->prev = (virtual_timer_t *)&ch.vtlist;
   vtp->func = NULL;
+  _integrity_timer_removed(vtp);
 
   /* If the list become empty then the alarm timer is stopped and done.*/
   if (&ch.vtlist == (virtual_timers_list_t *)ch.vtlist.next) {
@@ -245,25 +449,15 @@ void chVTDoResetI(virtual_timer_t *vtp) {
     return;
   }*/
 
-  /* Distance in ticks between the last alarm event and current time.*/
-  nowdelta = chVTGetSystemTimeX() - ch.vtlist.lasttime;
-
   /* If the current time surpassed the time of the next element in list
-     then the event interrupt is already pending, just return.*/
-  if (nowdelta >= ch.vtlist.next->delta) {
+     then the programmed alarm will serve it, just return.*/
+  now = chVTGetSystemTimeX();
+  if ((systime_t)(now - ch.vtlist.lasttime) >= ch.vtlist.next->delta) {
     return;
   }
 
-  /* Distance from the next scheduled event and now.*/
-  delta = ch.vtlist.next->delta - nowdelta;
-
-  /* Making sure to not schedule an event closer than CH_CFG_ST_TIMEDELTA
-     ticks from now.*/
-  if (delta < (systime_t)CH_CFG_ST_TIMEDELTA) {
-    delta = (systime_t)CH_CFG_ST_TIMEDELTA;
-  }
-
-  port_timer_set_alarm(ch.vtlist.lasttime + nowdelta + delta);
+  /* The alarm is moved according to the new first timer.*/
+  _vt_set_alarm(now);
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
 
@@ -498,6 +498,75 @@ namespace chibios_rt {
   }
 #endif /* CH_CFG_USE_CONDVARS_TIMEOUT */
 #endif /* CH_CFG_USE_CONDVARS */
+#if CH_CFG_USE_RWLOCKS
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  RWLock::RWLock(void) {
+
+    chRWLockObjectInit(&rwlock);
+  }
+
+  msg_t RWLock::readLock(void) {
+
+    return chRWLockReadLock(&rwlock);
+  }
+
+  msg_t RWLock::readLockS(void) {
+
+    return chRWLockReadLockS(&rwlock);
+  }
+
+  msg_t RWLock::readLock(systime_t time) {
+
+    return chRWLockReadLockTimeout(&rwlock, time);
+  }
+
+  bool RWLock::tryReadLock(void) {
+
+    return chRWLockTryReadLock(&rwlock);
+  }
+
+  void RWLock::readUnlock(void) {
+
+    chRWLockReadUnlock(&rwlock);
+  }
+
+  void RWLock::readUnlockS(void) {
+
+    chRWLockReadUnlockS(&rwlock);
+  }
+
+  msg_t RWLock::writeLock(void) {
+
+    return chRWLockWriteLock(&rwlock);
+  }
+
+  msg_t RWLock::writeLockS(void) {
+
+    return chRWLockWriteLockS(&rwlock);
+  }
+
+  msg_t RWLock::writeLock(systime_t time) {
+
+    return chRWLockWriteLockTimeout(&rwlock, time);
+  }
+
+  bool RWLock::tryWriteLock(void) {
+
+    return chRWLockTryWriteLock(&rwlock);
+  }
+
+  void RWLock::writeUnlock(void) {
+
+    chRWLockWriteUnlock(&rwlock);
+  }
+
+  void RWLock::writeUnlockS(void) {
+
+    chRWLockWriteUnlockS(&rwlock);
+  }
+#endif /* CH_CFG_USE_RWLOCKS */
 #endif /* CH_CFG_USE_MUTEXES */
 
 #if CH_CFG_USE_EVENTS
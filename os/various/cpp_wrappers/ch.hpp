@@ -1470,6 +1470,163 @@ namespace chibios_rt {
 #endif /* CH_CFG_USE_CONDVARS_TIMEOUT */
   };
 #endif /* CH_CFG_USE_CONDVARS */
+#if CH_CFG_USE_RWLOCKS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a reader-writer lock.
+   */
+  class RWLock {
+  public:
+    /**
+     * @brief   Embedded @p ::rwlock_t structure.
+     */
+    ::rwlock_t rwlock;
+
+    /**
+     * @brief   RWLock object constructor.
+     * @details The embedded @p ::rwlock_t structure is initialized.
+     *
+     * @init
+     */
+    RWLock(void);
+
+    /**
+     * @brief   Takes the lock in shared mode.
+     *
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     *
+     * @api
+     */
+    msg_t readLock(void);
+
+    /**
+     * @brief   Takes the lock in shared mode.
+     *
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     *
+     * @sclass
+     */
+    msg_t readLockS(void);
+
+    /**
+     * @brief   Takes the lock in shared mode with timeout specification.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     * @retval MSG_TIMEOUT  if the lock has not been taken within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    msg_t readLock(systime_t time);
+
+    /**
+     * @brief   Tries to take the lock in shared mode.
+     *
+     * @return              The operation status.
+     * @retval true         if the lock has been successfully taken
+     * @retval false        if the lock attempt failed.
+     *
+     * @api
+     */
+    bool tryReadLock(void);
+
+    /**
+     * @brief   Releases a lock taken in shared mode.
+     *
+     * @api
+     */
+    void readUnlock(void);
+
+    /**
+     * @brief   Releases a lock taken in shared mode.
+     * @post    This function does not reschedule so a call to a rescheduling
+     *          function must be performed before unlocking the kernel.
+     *
+     * @sclass
+     */
+    void readUnlockS(void);
+
+    /**
+     * @brief   Takes the lock in exclusive mode.
+     *
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     *
+     * @api
+     */
+    msg_t writeLock(void);
+
+    /**
+     * @brief   Takes the lock in exclusive mode.
+     *
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     *
+     * @sclass
+     */
+    msg_t writeLockS(void);
+
+    /**
+     * @brief   Takes the lock in exclusive mode with timeout specification.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              A message specifying how the invoking thread has
+     *                      been released from the lock.
+     * @retval MSG_OK       if the lock has been taken.
+     * @retval MSG_TIMEOUT  if the lock has not been taken within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    msg_t writeLock(systime_t time);
+
+    /**
+     * @brief   Tries to take the lock in exclusive mode.
+     *
+     * @return              The operation status.
+     * @retval true         if the lock has been successfully taken
+     * @retval false        if the lock attempt failed.
+     *
+     * @api
+     */
+    bool tryWriteLock(void);
+
+    /**
+     * @brief   Releases a lock taken in exclusive mode.
+     *
+     * @api
+     */
+    void writeUnlock(void);
+
+    /**
+     * @brief   Releases a lock taken in exclusive mode.
+     * @post    This function does not reschedule so a call to a rescheduling
+     *          function must be performed before unlocking the kernel.
+     *
+     * @sclass
+     */
+    void writeUnlockS(void);
+  };
+#endif /* CH_CFG_USE_RWLOCKS */
 #endif /* CH_CFG_USE_MUTEXES */
 
 #if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
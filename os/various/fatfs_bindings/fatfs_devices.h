@@ -0,0 +1,98 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    fatfs_devices.h
+ * @brief   FatFs block devices bindings macros and structures.
+ *
+ * @addtogroup FATFS_DEVICES
+ * @{
+ */
+
+#ifndef FATFS_DEVICES_H
+#define FATFS_DEVICES_H
+
+#include "ff.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of physical drives.
+ */
+#if !defined(FATFS_DRIVES) || defined(__DOXYGEN__)
+#define FATFS_DRIVES                        _VOLUMES
+#endif
+
+/**
+ * @brief   Buffers alignment required by the block devices.
+ * @details Transfers on buffers not aligned to this boundary are performed
+ *          through a bounce buffer.
+ */
+#if !defined(FATFS_BUFFERS_ALIGNMENT) || defined(__DOXYGEN__)
+#define FATFS_BUFFERS_ALIGNMENT             4U
+#endif
+
+/**
+ * @brief   Size of the bounce buffer of each drive in sectors.
+ * @note    If set to zero then unaligned buffers are passed to the block
+ *          devices unchanged.
+ */
+#if !defined(FATFS_BOUNCE_SECTORS) || defined(__DOXYGEN__)
+#define FATFS_BOUNCE_SECTORS                1U
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (FATFS_DRIVES < 1) || (FATFS_DRIVES > 255)
+#error "invalid FATFS_DRIVES value"
+#endif
+
+#if (FATFS_BUFFERS_ALIGNMENT & (FATFS_BUFFERS_ALIGNMENT - 1U)) != 0U
+#error "FATFS_BUFFERS_ALIGNMENT is not a power of two"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void fatfsRegisterDevice(BYTE pdrv, BaseBlockDevice *bdp);
+  BaseBlockDevice *fatfsGetDevice(BYTE pdrv);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FATFS_DEVICES_H */
+
+/** @} */
@@ -5,20 +5,18 @@
 /* disk I/O modules and attach it to FatFs module with common interface. */
 /*-----------------------------------------------------------------------*/
 
+#include <string.h>
+
 #include "hal.h"
 #include "ffconf.h"
 #include "diskio.h"
-
-#if HAL_USE_MMC_SPI && HAL_USE_SDC
-#error "cannot specify both MMC_SPI and SDC drivers"
-#endif
+#include "fatfs_devices.h"
 
 #if HAL_USE_MMC_SPI
 extern MMCDriver MMCD1;
-#elif HAL_USE_SDC
+#endif
+#if HAL_USE_SDC
 extern SDCDriver SDCD1;
-#else
-#error "MMC_SPI or SDC driver must be specified"
 #endif
 
 #if HAL_USE_RTC
@@ -27,9 +25,124 @@ extern RTCDriver RTCD1;
 
 /*-----------------------------------------------------------------------*/
 /* Correspondence between physical drive number and physical drive.      */
+/* The SDC and MMC drivers, when enabled, are registered by default as   */
+/* the first drives, any BaseBlockDevice can be registered on any drive. */
+
+typedef struct {
+  BaseBlockDevice       *bdp;   /* Block device or NULL */
+  semaphore_t           lock;   /* Serializes the device accesses */
+} drive_t;
+
+static drive_t drives[FATFS_DRIVES];
+static bool drives_ready = false;
+
+#if FATFS_BOUNCE_SECTORS > 0
+ALIGNED_VAR(FATFS_BUFFERS_ALIGNMENT)
+static BYTE bounce[FATFS_DRIVES][FATFS_BOUNCE_SECTORS * _MAX_SS];
+#endif
+
+static void drives_init(void) {
+
+  chSysLock();
+  if (!drives_ready) {
+    unsigned i = 0;
+
+    for (i = 0; i < FATFS_DRIVES; i++) {
+      drives[i].bdp = NULL;
+      chSemObjectInit(&drives[i].lock, 1);
+    }
+    i = 0;
+#if HAL_USE_SDC
+    drives[i++].bdp = (BaseBlockDevice *)&SDCD1;
+#endif
+#if HAL_USE_MMC_SPI
+    if (i < FATFS_DRIVES)
+      drives[i].bdp = (BaseBlockDevice *)&MMCD1;
+#endif
+    (void)i;
+    drives_ready = true;
+  }
+  chSysUnlock();
+}
+
+static drive_t *drive_get(BYTE pdrv) {
+
+  if (pdrv >= FATFS_DRIVES)
+    return NULL;
+  if (!drives_ready)
+    drives_init();
+  if (drives[pdrv].bdp == NULL)
+    return NULL;
+  return &drives[pdrv];
+}
+
+static DSTATUS drive_status(drive_t *dp) {
+  DSTATUS stat = 0;
+
+  /* It is initialized externally, just reads the status.*/
+  chSemWait(&dp->lock);
+  if (blkGetDriverState(dp->bdp) != BLK_READY)
+    stat |= STA_NOINIT;
+  else if (blkIsWriteProtected(dp->bdp))
+    stat |= STA_PROTECT;
+  chSemSignal(&dp->lock);
+  return stat;
+}
+
+#if FATFS_BOUNCE_SECTORS > 0
+static bool is_unaligned(const BYTE *buff) {
+
+  return ((size_t)buff & (FATFS_BUFFERS_ALIGNMENT - 1U)) != 0U;
+}
+
+/* Number of blocks fitting the bounce buffer, zero if the device blocks
+   are larger than the buffer.*/
+static UINT bounce_blocks(BYTE pdrv, const BlockDeviceInfo *bdip) {
+
+  chDbgAssert((bdip->blk_size > 0U) &&
+              (bdip->blk_size <= sizeof bounce[pdrv]),
+              "block size not supported by the bounce buffer");
+
+  if (bdip->blk_size == 0U)
+    return 0;
+  return (UINT)(sizeof bounce[pdrv] / bdip->blk_size);
+}
+#endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Register a Block Device on a Drive                                    */
+
+void fatfsRegisterDevice (
+    BYTE pdrv,              /* Physical drive nmuber (0..) */
+    BaseBlockDevice *bdp    /* Block device or NULL to unregister */
+)
+{
+  chDbgCheck(pdrv < FATFS_DRIVES);
+
+  if (!drives_ready)
+    drives_init();
+
+  /* Waits for operations in progress on the previous device.*/
+  chSemWait(&drives[pdrv].lock);
+  drives[pdrv].bdp = bdp;
+  chSemSignal(&drives[pdrv].lock);
+}
+
 
-#define MMC     0
-#define SDC     0
+
+/*-----------------------------------------------------------------------*/
+/* Return the Block Device of a Drive                                    */
+
+BaseBlockDevice *fatfsGetDevice (
+    BYTE pdrv               /* Physical drive nmuber (0..) */
+)
+{
+  drive_t *dp = drive_get(pdrv);
+
+  return dp == NULL ? NULL : dp->bdp;
+}
 
 
 
@@ -40,30 +153,11 @@ DSTATUS disk_initialize (
     BYTE pdrv         /* Physical drive nmuber (0..) */
 )
 {
-  DSTATUS stat;
+  drive_t *dp = drive_get(pdrv);
 
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&MMCD1))
-      stat |=  STA_PROTECT;
-    return stat;
-#else
-  case SDC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&SDCD1))
-      stat |=  STA_PROTECT;
-    return stat;
-#endif
-  }
-  return STA_NOINIT;
+  if (dp == NULL)
+    return STA_NOINIT;
+  return drive_status(dp);
 }
 
 
@@ -75,30 +169,11 @@ DSTATUS disk_status (
     BYTE pdrv         /* Physical drive nmuber (0..) */
 )
 {
-  DSTATUS stat;
+  drive_t *dp = drive_get(pdrv);
 
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&MMCD1))
-      stat |= STA_PROTECT;
-    return stat;
-#else
-  case SDC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&SDCD1))
-      stat |= STA_PROTECT;
-    return stat;
-#endif
-  }
-  return STA_NOINIT;
+  if (dp == NULL)
+    return STA_NOINIT;
+  return drive_status(dp);
 }
 
 
@@ -113,32 +188,47 @@ DRESULT disk_read (
     UINT count        /* Number of sectors to read (1..255) */
 )
 {
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (mmcStartSequentialRead(&MMCD1, sector))
-      return RES_ERROR;
-    while (count > 0) {
-      if (mmcSequentialRead(&MMCD1, buff))
-        return RES_ERROR;
-      buff += MMCSD_BLOCK_SIZE;
-      count--;
+  drive_t *dp = drive_get(pdrv);
+  DRESULT res = RES_OK;
+
+  if (dp == NULL)
+    return RES_PARERR;
+
+  chSemWait(&dp->lock);
+  if (blkGetDriverState(dp->bdp) != BLK_READY) {
+    res = RES_NOTRDY;
+  }
+#if FATFS_BOUNCE_SECTORS > 0
+  else if (is_unaligned(buff)) {
+    /* Unaligned buffer, multi-sector transfers through the bounce
+       buffer.*/
+    BlockDeviceInfo bdi;
+    UINT max, n;
+
+    if (blkGetInfo(dp->bdp, &bdi))
+      res = RES_ERROR;
+    else if ((max = bounce_blocks(pdrv, &bdi)) == 0)
+      res = RES_PARERR;
+    while ((res == RES_OK) && (count > 0)) {
+      n = max;
+      if (n > count)
+        n = count;
+      if (blkRead(dp->bdp, sector, bounce[pdrv], n)) {
+        res = RES_ERROR;
+        break;
+      }
+      memcpy(buff, bounce[pdrv], n * bdi.blk_size);
+      buff += n * bdi.blk_size;
+      sector += n;
+      count -= n;
     }
-    if (mmcStopSequentialRead(&MMCD1))
-        return RES_ERROR;
-    return RES_OK;
-#else
-  case SDC:
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (sdcRead(&SDCD1, sector, buff, count))
-      return RES_ERROR;
-    return RES_OK;
+  }
 #endif
+  else if (blkRead(dp->bdp, sector, buff, count)) {
+    res = RES_ERROR;
   }
-  return RES_PARERR;
+  chSemSignal(&dp->lock);
+  return res;
 }
 
 
@@ -154,34 +244,50 @@ DRESULT disk_write (
     UINT count        /* Number of sectors to write (1..255) */
 )
 {
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-        return RES_NOTRDY;
-    if (mmcIsWriteProtected(&MMCD1))
-        return RES_WRPRT;
-    if (mmcStartSequentialWrite(&MMCD1, sector))
-        return RES_ERROR;
-    while (count > 0) {
-        if (mmcSequentialWrite(&MMCD1, buff))
-            return RES_ERROR;
-        buff += MMCSD_BLOCK_SIZE;
-        count--;
+  drive_t *dp = drive_get(pdrv);
+  DRESULT res = RES_OK;
+
+  if (dp == NULL)
+    return RES_PARERR;
+
+  chSemWait(&dp->lock);
+  if (blkGetDriverState(dp->bdp) != BLK_READY) {
+    res = RES_NOTRDY;
+  }
+  else if (blkIsWriteProtected(dp->bdp)) {
+    res = RES_WRPRT;
+  }
+#if FATFS_BOUNCE_SECTORS > 0
+  else if (is_unaligned(buff)) {
+    /* Unaligned buffer, multi-sector transfers through the bounce
+       buffer.*/
+    BlockDeviceInfo bdi;
+    UINT max, n;
+
+    if (blkGetInfo(dp->bdp, &bdi))
+      res = RES_ERROR;
+    else if ((max = bounce_blocks(pdrv, &bdi)) == 0)
+      res = RES_PARERR;
+    while ((res == RES_OK) && (count > 0)) {
+      n = max;
+      if (n > count)
+        n = count;
+      memcpy(bounce[pdrv], buff, n * bdi.blk_size);
+      if (blkWrite(dp->bdp, sector, bounce[pdrv], n)) {
+        res = RES_ERROR;
+        break;
+      }
+      buff += n * bdi.blk_size;
+      sector += n;
+      count -= n;
     }
-    if (mmcStopSequentialWrite(&MMCD1))
-        return RES_ERROR;
-    return RES_OK;
-#else
-  case SDC:
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (sdcWrite(&SDCD1, sector, buff, count))
-      return RES_ERROR;
-    return RES_OK;
+  }
 #endif
+  else if (blkWrite(dp->bdp, sector, buff, count)) {
+    res = RES_ERROR;
   }
-  return RES_PARERR;
+  chSemSignal(&dp->lock);
+  return res;
 }
 #endif /* _FS_READONLY */
 
@@ -196,54 +302,70 @@ DRESULT disk_ioctl (
     void *buff        /* Buffer to send/receive control data */
 )
 {
-  (void)buff;
+  drive_t *dp = drive_get(pdrv);
+  BlockDeviceInfo bdi;
+  DRESULT res = RES_PARERR;
 
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    switch (cmd) {
-    case CTRL_SYNC:
-        return RES_OK;
+  if (dp == NULL)
+    return RES_PARERR;
+
+  chSemWait(&dp->lock);
+  if (blkGetDriverState(dp->bdp) != BLK_READY) {
+    chSemSignal(&dp->lock);
+    return RES_NOTRDY;
+  }
+
+  switch (cmd) {
+  case CTRL_SYNC:
+    res = blkSync(dp->bdp) ? RES_ERROR : RES_OK;
+    break;
+  case GET_SECTOR_COUNT:
+    if (blkGetInfo(dp->bdp, &bdi))
+      res = RES_ERROR;
+    else {
+      *((DWORD *)buff) = bdi.blk_num;
+      res = RES_OK;
+    }
+    break;
 #if _MAX_SS > _MIN_SS
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
-#endif
-#if _USE_TRIM
-    case CTRL_TRIM:
-        mmcErase(&MMCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
+  case GET_SECTOR_SIZE:
+    if (blkGetInfo(dp->bdp, &bdi))
+      res = RES_ERROR;
+    else {
+      *((WORD *)buff) = (WORD)bdi.blk_size;
+      res = RES_OK;
+    }
+    break;
 #endif
-    default:
-        return RES_PARERR;
+  case GET_BLOCK_SIZE:
+#if HAL_USE_SDC
+    if (dp->bdp == (BaseBlockDevice *)&SDCD1) {
+      *((DWORD *)buff) = 256; /* 512b blocks in one erase block */
+      res = RES_OK;
     }
-#else
-  case SDC:
-    switch (cmd) {
-    case CTRL_SYNC:
-        return RES_OK;
-    case GET_SECTOR_COUNT:
-        *((DWORD *)buff) = mmcsdGetCardCapacity(&SDCD1);
-        return RES_OK;
-#if _MAX_SS > _MIN_SS
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
 #endif
-    case GET_BLOCK_SIZE:
-        *((DWORD *)buff) = 256; /* 512b blocks in one erase block */
-        return RES_OK;
+    break;
 #if _USE_TRIM
-    case CTRL_TRIM:
-        sdcErase(&SDCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
+  case CTRL_TRIM:
+#if HAL_USE_MMC_SPI
+    if (dp->bdp == (BaseBlockDevice *)&MMCD1) {
+      mmcErase(&MMCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
+      res = RES_OK;
+    }
 #endif
-    default:
-        return RES_PARERR;
+#if HAL_USE_SDC
+    if (dp->bdp == (BaseBlockDevice *)&SDCD1) {
+      sdcErase(&SDCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
+      res = RES_OK;
     }
 #endif
+    break;
+#endif
+  default:
+    break;
   }
-  return RES_PARERR;
+  chSemSignal(&dp->lock);
+  return res;
 }
 
 DWORD get_fattime(void) {
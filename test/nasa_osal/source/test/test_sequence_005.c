@@ -107,7 +107,6 @@ static void test_005_001_execute(void) {
      name, an error is expected.*/
   test_set_step(4);
   {
-#if 0 /* Semaphore name currently not implemented.*/
     int32 err;
 
     err = OS_CountSemCreate(&csid,
@@ -115,7 +114,6 @@ static void test_005_001_execute(void) {
                             0,
                             0);
     test_assert(err == OS_ERR_NAME_TOO_LONG, "name limit not detected");
-#endif
   }
 
   /* [5.1.5] OS_CountSemDelete() is invoked with timer_id set to -1, an
@@ -134,15 +132,13 @@ static void test_005_001_execute(void) {
   test_set_step(6);
   {
     int32 err;
-    uint32 csid1; /*, csid2;*/
+    uint32 csid1, csid2;
 
     err = OS_CountSemCreate(&csid1, "my semaphore", 0, 0);
     test_assert(err == OS_SUCCESS, "semaphore creation failed");
 
-#if 0 /* Semaphore name currently not implemented.*/
     err = OS_CountSemCreate(&csid2, "my semaphore", 0, 0);
     test_assert(err == OS_ERR_NAME_TAKEN, "name conflict not detected");
-#endif
 
     err = OS_CountSemDelete(csid1);
     test_assert(err == OS_SUCCESS, "semaphore deletion failed");
@@ -33,6 +33,9 @@
  * - @subpage test_sequence_010
  * - @subpage test_sequence_011
  * - @subpage test_sequence_012
+ * - @subpage test_sequence_013
+ * - @subpage test_sequence_014
+ * - @subpage test_sequence_015
  * .
  */
 
@@ -83,6 +86,15 @@ const testcase_t * const *test_suite[] = {
   test_sequence_011,
 #endif
   test_sequence_012,
+#if (CH_CFG_USE_WORKQUEUES) || defined(__DOXYGEN__)
+  test_sequence_013,
+#endif
+#if (CH_CFG_USE_CTASKS) || defined(__DOXYGEN__)
+  test_sequence_014,
+#endif
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+  test_sequence_015,
+#endif
   NULL
 };
 
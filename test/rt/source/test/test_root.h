@@ -34,6 +34,9 @@
 #include "test_sequence_010.h"
 #include "test_sequence_011.h"
 #include "test_sequence_012.h"
+#include "test_sequence_013.h"
+#include "test_sequence_014.h"
+#include "test_sequence_015.h"
 
 #if !defined(__DOXYGEN__)
 
@@ -38,6 +38,11 @@
  * - @subpage test_001_002
  * - @subpage test_001_003
  * - @subpage test_001_004
+ * - @subpage test_001_005
+ * - @subpage test_001_006
+ * - @subpage test_001_007
+ * - @subpage test_001_008
+ * - @subpage test_001_009
  * .
  */
 
@@ -62,6 +67,103 @@ static void vtcb(void *p) {
   chSysUnlockFromISR();
 }
 
+/* Test timers and their expiration times.*/
+static virtual_timer_t vt1, vt2;
+static systime_t vttimes[5];
+static unsigned vtcnt;
+
+/* Continuous timer callback, the timer stops itself after five
+   expirations.*/
+static void vtcb2(void *p) {
+
+  (void)p;
+
+  chSysLockFromISR();
+  vttimes[vtcnt++] = chVTGetSystemTimeX();
+  if (vtcnt >= 5U) {
+    chVTDoResetI(&vt1);
+  }
+  chSysUnlockFromISR();
+}
+
+/* One-shot timer callback, records the expiration time.*/
+static void vtcb3(void *p) {
+
+  chSysLockFromISR();
+  *(systime_t *)p = chVTGetSystemTimeX();
+  chSysUnlockFromISR();
+}
+
+#if CH_CFG_USE_SEQLOCKS || defined(__DOXYGEN__)
+/* Object shared between the timer callback and the tester thread, all
+   the fields are expected to be equal in a consistent copy.*/
+typedef struct {
+  uint32_t a, b, c, d;
+} sldata_t;
+
+static SEQLOCK_DECL(sl1);
+static sldata_t sldata;
+static uint32_t slcnt;
+
+/* Continuous timer callback, updates the shared object.*/
+static void vtcb4(void *p) {
+  sldata_t tmp;
+
+  (void)p;
+
+  slcnt++;
+  tmp.a = slcnt;
+  tmp.b = slcnt;
+  tmp.c = slcnt;
+  tmp.d = slcnt;
+  chSysLockFromISR();
+  chSeqWriteI(&sl1, &sldata, &tmp);
+  chSysUnlockFromISR();
+}
+#endif /* CH_CFG_USE_SEQLOCKS */
+
+#if CH_DBG_ENABLE_INTEGRITY_STEPS || defined(__DOXYGEN__)
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+static SEMAPHORE_DECL(isem, 0);
+#endif
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+static MUTEX_DECL(imtx);
+#endif
+
+#if (CH_CFG_USE_SEMAPHORES && CH_CFG_USE_MUTEXES) ||                        \
+    (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE)
+/* Waits on the object selected by the argument then terminates.*/
+static THD_FUNCTION(ithread, p) {
+
+#if CH_CFG_USE_SEMAPHORES
+  if (*(char *)p == 'S') {
+    chSemWait(&isem);
+  }
+#endif
+#if CH_CFG_USE_MUTEXES
+  if (*(char *)p == 'M') {
+    chMtxLock(&imtx);
+    chMtxUnlock(&imtx);
+  }
+#endif
+  test_emit_token(*(char *)p);
+}
+#endif
+
+/* Performs incremental checks until two passes have been completed, so at
+   least one pass is complete, returns true on failure.*/
+static bool integrity_pass(unsigned n) {
+  ucnt_t passes = ch.integrity.passes;
+
+  while ((ucnt_t)(ch.integrity.passes - passes) < (ucnt_t)2) {
+    if (chSysIntegrityStep(n)) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif /* CH_DBG_ENABLE_INTEGRITY_STEPS */
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -266,6 +368,444 @@ static const testcase_t test_001_004 = {
   test_001_004_execute
 };
 
+/**
+ * @page test_001_005 [1.5] Continuous Virtual Timers functionality
+ *
+ * <h2>Description</h2>
+ * A continuous virtual timer is started and its expirations are
+ * recorded, the expirations must not drift from the deadlines computed
+ * from the start time.
+ *
+ * <h2>Test Steps</h2>
+ * - [1.5.1] Starting a continuous timer, it must be still armed after
+ *   two expirations.
+ * - [1.5.2] Waiting for the timer to stop itself after five expirations,
+ *   the expirations must happen on multiples of the period from the
+ *   start time.
+ * - [1.5.3] Restarting the timer then making it one-shot using
+ *   chVTSetReloadIntervalX(), it must expire only once.
+ * .
+ */
+
+static void test_001_005_execute(void) {
+  systime_t period = MS2ST(10);
+  systime_t start;
+
+  /* [1.5.1] Starting a continuous timer, it must be still armed after two
+     expirations.*/
+  test_set_step(1);
+  {
+    vtcnt = 0;
+    start = chVTGetSystemTime();
+    chVTObjectInit(&vt1);
+    chVTSetContinuous(&vt1, period, vtcb2, NULL);
+    test_assert(chVTGetReloadIntervalX(&vt1) == period, "wrong reload interval");
+    chThdSleep(period * 2 + period / 2);
+    test_assert(vtcnt == 2U, "wrong number of expirations");
+    test_assert(chVTIsArmed(&vt1) == true, "timer not armed");
+  }
+
+  /* [1.5.2] Waiting for the timer to stop itself after five expirations,
+     the expirations must happen on multiples of the period from the start
+     time.*/
+  test_set_step(2);
+  {
+    unsigned i;
+
+    chThdSleep(period * 4);
+    test_assert(chVTIsArmed(&vt1) == false, "timer still armed");
+    test_assert(vtcnt == 5U, "wrong number of expirations");
+    for (i = 0; i < 5U; i++) {
+      systime_t deadline = start + (systime_t)(i + 1U) * period;
+      test_assert(chVTIsTimeWithinX(vttimes[i], deadline,
+                                    deadline + ALLOWED_DELAY + 1),
+                  "expiration out of time window");
+    }
+    test_assert(chVTGetOverrunsX(&vt1) == 0, "unexpected overruns");
+  }
+
+  /* [1.5.3] Restarting the timer then making it one-shot using
+     chVTSetReloadIntervalX(), it must expire only once.*/
+  test_set_step(3);
+  {
+    vtcnt = 0;
+    chVTSetContinuous(&vt1, period, vtcb2, NULL);
+    chVTSetReloadIntervalX(&vt1, 0);
+    chThdSleep(period * 3);
+    test_assert(vtcnt == 1U, "wrong number of expirations");
+    test_assert(chVTIsArmed(&vt1) == false, "timer still armed");
+  }
+}
+
+static const testcase_t test_001_005 = {
+  "Continuous Virtual Timers functionality",
+  NULL,
+  NULL,
+  test_001_005_execute
+};
+
+/**
+ * @page test_001_006 [1.6] Virtual Timers slack functionality
+ *
+ * <h2>Description</h2>
+ * Two virtual timers are started, the slack of the first timer covers
+ * the deadline of the second one. Both timers must expire within their
+ * time windows, in tick-less mode the two timers must be served by the
+ * same alarm.
+ *
+ * <h2>Test Steps</h2>
+ * - [1.6.1] Starting a timer with 20mS delay and 20mS slack and a timer
+ *   with 30mS delay and no slack, both timers must expire within their
+ *   time windows.
+ * - [1.6.2] In tick-less mode both timers must have been served by the
+ *   same alarm.
+ * - [1.6.3] Sleeping for 10mS with 10mS slack, the thread must wake up
+ *   within the slack window.
+ * .
+ */
+
+static void test_001_006_execute(void) {
+  systime_t start;
+
+  /* [1.6.1] Starting a timer with 20mS delay and 20mS slack and a timer
+     with 30mS delay and no slack, both timers must expire within their
+     time windows.*/
+  test_set_step(1);
+  {
+    chVTObjectInit(&vt1);
+    chVTObjectInit(&vt2);
+    chSysLock();
+    start = chVTGetSystemTimeX();
+    chVTSetWithSlackI(&vt1, MS2ST(20), MS2ST(20), vtcb3, &vttimes[0]);
+    chVTSetI(&vt2, MS2ST(30), vtcb3, &vttimes[1]);
+    chSysUnlock();
+    chThdSleep(MS2ST(50));
+    test_assert(!chVTIsArmed(&vt1) && !chVTIsArmed(&vt2), "timer still armed");
+    test_assert(chVTIsTimeWithinX(vttimes[0], start + MS2ST(20),
+                                  start + MS2ST(40) + ALLOWED_DELAY + 1),
+                "first expiration out of time window");
+    test_assert(chVTIsTimeWithinX(vttimes[1], start + MS2ST(30),
+                                  start + MS2ST(30) + ALLOWED_DELAY + 1),
+                "second expiration out of time window");
+  }
+
+  /* [1.6.2] In tick-less mode both timers must have been served by the
+     same alarm.*/
+  test_set_step(2);
+  {
+#if CH_CFG_ST_TIMEDELTA > 0
+    test_assert(vttimes[0] == vttimes[1], "timers not served together");
+#endif
+  }
+
+  /* [1.6.3] Sleeping for 10mS with 10mS slack, the thread must wake up
+     within the slack window.*/
+  test_set_step(3);
+  {
+    start = chVTGetSystemTime();
+    chThdSleepWithSlack(MS2ST(10), MS2ST(10));
+    test_assert_time_window(start + MS2ST(10),
+                            start + MS2ST(20) + ALLOWED_DELAY + 1,
+                            "out of time window");
+  }
+}
+
+static const testcase_t test_001_006 = {
+  "Virtual Timers slack functionality",
+  NULL,
+  NULL,
+  test_001_006_execute
+};
+
+#if (CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_001_007 [1.7] Sequence locks functionality
+ *
+ * <h2>Description</h2>
+ * The sequence lock states are tested, a read must be retried if an
+ * update is in progress or if an update happened after the read
+ * started.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEQLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [1.7.1] Starting a read then verifying it, no retry is expected.
+ * - [1.7.2] Starting a read then an update, a retry is expected.
+ * - [1.7.3] Starting a read while the update is in progress, a retry is
+ *   expected even after the update is finished.
+ * - [1.7.4] Writing and reading an object using the typed macros, the
+ *   copy must match the written object.
+ * .
+ */
+
+static void test_001_007_setup(void) {
+  chSeqObjectInit(&sl1);
+}
+
+static void test_001_007_execute(void) {
+  ucnt_t seq;
+
+  /* [1.7.1] Starting a read then verifying it, no retry is expected.*/
+  test_set_step(1);
+  {
+    seq = chSeqReadBeginX(&sl1);
+    test_assert(chSeqReadRetryX(&sl1, seq) == false, "unexpected retry");
+  }
+
+  /* [1.7.2] Starting a read then an update, a retry is expected.*/
+  test_set_step(2);
+  {
+    seq = chSeqReadBeginX(&sl1);
+    chSysLock();
+    chSeqWriteBeginI(&sl1);
+    chSysUnlock();
+    test_assert(chSeqReadRetryX(&sl1, seq) == true, "retry not detected");
+  }
+
+  /* [1.7.3] Starting a read while the update is in progress, a retry is
+     expected even after the update is finished.*/
+  test_set_step(3);
+  {
+    seq = chSeqReadBeginX(&sl1);
+    test_assert(chSeqReadRetryX(&sl1, seq) == true, "retry not detected");
+    chSysLock();
+    chSeqWriteEndI(&sl1);
+    chSysUnlock();
+    test_assert(chSeqReadRetryX(&sl1, seq) == true, "retry not detected");
+  }
+
+  /* [1.7.4] Writing and reading an object using the typed macros, the
+     copy must match the written object.*/
+  test_set_step(4);
+  {
+    sldata_t tmp = {1U, 2U, 3U, 4U};
+    sldata_t copy;
+
+    chSysLock();
+    chSeqWriteI(&sl1, &sldata, &tmp);
+    chSysUnlock();
+    chSeqReadX(&sl1, &sldata, &copy);
+    test_assert((copy.a == 1U) && (copy.b == 2U) &&
+                (copy.c == 3U) && (copy.d == 4U), "wrong copy");
+  }
+}
+
+static const testcase_t test_001_007 = {
+  "Sequence locks functionality",
+  test_001_007_setup,
+  NULL,
+  test_001_007_execute
+};
+#endif /* CH_CFG_USE_SEQLOCKS */
+
+#if (CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_001_008 [1.8] Sequence locks, updates from ISR
+ *
+ * <h2>Description</h2>
+ * A continuous virtual timer updates a shared object from its callback
+ * while the tester thread reads the object without entering a critical
+ * zone. All the copies obtained by the reader must be consistent.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEQLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [1.8.1] Starting a continuous timer updating the shared object.
+ * - [1.8.2] Reading the object field by field for 500mS, interrupts are
+ *   allowed between the field accesses, the consistent copies must have
+ *   all fields equal.
+ * - [1.8.3] Reading the object using chSeqReadX() for 100mS, the copies
+ *   must be consistent and must not go backward.
+ * - [1.8.4] Stopping the timer.
+ * .
+ */
+
+static void test_001_008_setup(void) {
+  chSeqObjectInit(&sl1);
+  slcnt = 0;
+  sldata.a = 0;
+  sldata.b = 0;
+  sldata.c = 0;
+  sldata.d = 0;
+}
+
+static void test_001_008_execute(void) {
+  systime_t start, end;
+  unsigned retries;
+
+  /* [1.8.1] Starting a continuous timer updating the shared object.*/
+  test_set_step(1);
+  {
+    chVTObjectInit(&vt1);
+    chVTSetContinuous(&vt1, MS2ST(2), vtcb4, NULL);
+  }
+
+  /* [1.8.2] Reading the object field by field for 500mS, interrupts are
+     allowed between the field accesses, the consistent copies must have
+     all fields equal.*/
+  test_set_step(2);
+  {
+    const volatile sldata_t *sdp = &sldata;
+    sldata_t copy;
+    ucnt_t seq;
+
+    retries = 0;
+    start = chVTGetSystemTime();
+    end = start + MS2ST(500);
+    while (chVTIsSystemTimeWithin(start, end)) {
+      seq = chSeqReadBeginX(&sl1);
+      copy.a = sdp->a;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+      copy.b = sdp->b;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+      copy.c = sdp->c;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+      copy.d = sdp->d;
+      if (chSeqReadRetryX(&sl1, seq)) {
+        retries++;
+        continue;
+      }
+      test_assert((copy.a == copy.b) && (copy.a == copy.c) &&
+                  (copy.a == copy.d), "torn copy");
+    }
+    #if defined(SIMULATOR)
+    test_assert(retries > 0U, "no retries");
+    #endif
+  }
+
+  /* [1.8.3] Reading the object using chSeqReadX() for 100mS, the copies
+     must be consistent and must not go backward.*/
+  test_set_step(3);
+  {
+    sldata_t copy;
+    uint32_t last = 0;
+
+    start = chVTGetSystemTime();
+    end = start + MS2ST(100);
+    while (chVTIsSystemTimeWithin(start, end)) {
+      chSeqReadX(&sl1, &sldata, &copy);
+      test_assert((copy.a == copy.b) && (copy.a == copy.c) &&
+                  (copy.a == copy.d), "torn copy");
+      test_assert(copy.a >= last, "copy went backward");
+      last = copy.a;
+    #if defined(SIMULATOR)
+      _sim_check_for_interrupts();
+    #endif
+    }
+    test_assert(last > 0U, "no updates");
+  }
+
+  /* [1.8.4] Stopping the timer.*/
+  test_set_step(4);
+  {
+    chVTReset(&vt1);
+  }
+}
+
+static const testcase_t test_001_008 = {
+  "Sequence locks, updates from ISR",
+  test_001_008_setup,
+  NULL,
+  test_001_008_execute
+};
+#endif /* CH_CFG_USE_SEQLOCKS */
+
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS) || defined(__DOXYGEN__)
+/**
+ * @page test_001_009 [1.9] Incremental system integrity
+ *
+ * <h2>Description</h2>
+ * The function @p chSysIntegrityStep() is invoked until complete check
+ * passes have been performed, with threads blocked on kernel objects
+ * and with a corrupted stack canary.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_DBG_ENABLE_INTEGRITY_STEPS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [1.9.1] A pass is performed checking one node at time, the check
+ *   must succeed.
+ * - [1.9.2] Two threads waiting on a semaphore and one thread waiting
+ *   on a mutex owned by the test thread are created, a pass is
+ *   performed and the check must succeed, then the threads are
+ *   released.
+ * - [1.9.3] The stack canary of a lower priority thread is corrupted,
+ *   the check must fail, after restoring the canary the check must
+ *   succeed.
+ * .
+ */
+
+static void test_001_009_execute(void) {
+
+  /* [1.9.1] A pass is performed checking one node at time, the check
+     must succeed.*/
+  test_set_step(1);
+  {
+    test_assert(!integrity_pass(1U), "integrity check failed");
+  }
+
+  /* [1.9.2] Two threads waiting on a semaphore and one thread waiting
+     on a mutex owned by the test thread are created, a pass is
+     performed and the check must succeed, then the threads are
+     released.*/
+  test_set_step(2);
+  {
+    #if CH_CFG_USE_SEMAPHORES && CH_CFG_USE_MUTEXES
+    chMtxLock(&imtx);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()+1, ithread, "S");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX()+1, ithread, "S");
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriorityX()+1, ithread, "M");
+    test_assert(!integrity_pass(8U), "integrity check failed");
+    chSemSignal(&isem);
+    chSemSignal(&isem);
+    chMtxUnlock(&imtx);
+    test_wait_threads();
+    test_assert_sequence("SSM", "invalid sequence");
+    #endif
+  }
+
+  /* [1.9.3] The stack canary of a lower priority thread is corrupted,
+     the check must fail, after restoring the canary the check must
+     succeed.*/
+  test_set_step(3);
+  {
+    #if (CH_DBG_ENABLE_STACK_CHECK == TRUE) || (CH_CFG_USE_DYNAMIC == TRUE)
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()-1, ithread, "C");
+    ((uint8_t *)wa[0])[0] ^= 0xFFU;
+    test_assert(integrity_pass(4U), "corruption not detected");
+    ((uint8_t *)wa[0])[0] ^= 0xFFU;
+    test_assert(!integrity_pass(4U), "integrity check failed");
+    test_wait_threads();
+    test_assert_sequence("C", "invalid sequence");
+    #endif
+  }
+}
+
+static const testcase_t test_001_009 = {
+  "Incremental system integrity",
+  NULL,
+  NULL,
+  test_001_009_execute
+};
+#endif /* CH_DBG_ENABLE_INTEGRITY_STEPS */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -278,5 +818,16 @@ const testcase_t * const test_sequence_001[] = {
   &test_001_002,
   &test_001_003,
   &test_001_004,
+  &test_001_005,
+  &test_001_006,
+#if (CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+  &test_001_007,
+#endif
+#if (CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+  &test_001_008,
+#endif
+#if (CH_DBG_ENABLE_INTEGRITY_STEPS) || defined(__DOXYGEN__)
+  &test_001_009,
+#endif
   NULL
 };
@@ -35,6 +35,7 @@
  * - @subpage test_002_002
  * - @subpage test_002_003
  * - @subpage test_002_004
+ * - @subpage test_002_005
  * .
  */
 
@@ -47,6 +48,34 @@ static THD_FUNCTION(thread, p) {
   test_emit_token(*(char *)p);
 }
 
+#if CH_CFG_USE_REGISTRY
+/* Creates a named thread in the specified working area.*/
+static thread_t *regcreate(unsigned i, const char *name, void *arg) {
+  thread_descriptor_t td = {
+    name,
+    (stkalign_t *)wa[i],
+    (stkalign_t *)((uint8_t *)wa[i] + WA_SIZE),
+    chThdGetPriorityX() - 1,
+    thread,
+    arg
+  };
+
+  return chThdCreate(&td);
+}
+
+/* Finds a thread by name releasing the acquired reference.*/
+static thread_t *regfind(const char *name) {
+  thread_t *tp = chRegFindThreadByName(name);
+
+#if CH_CFG_USE_DYNAMIC
+  if (tp != NULL) {
+    chThdRelease(tp);
+  }
+#endif
+  return tp;
+}
+#endif
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -326,6 +355,80 @@ static const testcase_t test_002_004 = {
 };
 #endif /* CH_CFG_USE_MUTEXES */
 
+#if (CH_CFG_USE_REGISTRY) || defined(__DOXYGEN__)
+/**
+ * @page test_002_005 [2.5] Threads registry lookup by name
+ *
+ * <h2>Description</h2>
+ * The function @p chRegFindThreadByName() is tested while creating,
+ * renaming and terminating threads.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_REGISTRY
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [2.5.1] A name not used by any thread is searched, the lookup must
+ *   fail.
+ * - [2.5.2] Two threads named "A" and "B" are created at lower
+ *   priority, both must be found by name.
+ * - [2.5.3] Thread "A" is renamed "C", the thread must be found under
+ *   the new name only.
+ * - [2.5.4] The threads are allowed to terminate, the names must no
+ *   more be found.
+ * .
+ */
+
+static void test_002_005_execute(void) {
+
+  /* [2.5.1] A name not used by any thread is searched, the lookup must
+     fail.*/
+  test_set_step(1);
+  {
+    test_assert(regfind("none") == NULL, "unexpected thread found");
+  }
+
+  /* [2.5.2] Two threads named "A" and "B" are created at lower
+     priority, both must be found by name.*/
+  test_set_step(2);
+  {
+    threads[0] = regcreate(0, "A", "A");
+    threads[1] = regcreate(1, "B", "B");
+    test_assert(regfind("A") == threads[0], "thread A not found");
+    test_assert(regfind("B") == threads[1], "thread B not found");
+  }
+
+  /* [2.5.3] Thread "A" is renamed "C", the thread must be found under
+     the new name only.*/
+  test_set_step(3);
+  {
+    chRegSetThreadNameX(threads[0], "C");
+    test_assert(regfind("A") == NULL, "old name still found");
+    test_assert(regfind("C") == threads[0], "thread C not found");
+    test_assert(regfind("B") == threads[1], "thread B not found");
+  }
+
+  /* [2.5.4] The threads are allowed to terminate, the names must no
+     more be found.*/
+  test_set_step(4);
+  {
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+    test_assert(regfind("B") == NULL, "terminated thread found");
+    test_assert(regfind("C") == NULL, "terminated thread found");
+  }
+}
+
+static const testcase_t test_002_005 = {
+  "Threads registry lookup by name",
+  NULL,
+  NULL,
+  test_002_005_execute
+};
+#endif /* CH_CFG_USE_REGISTRY */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -339,6 +442,9 @@ const testcase_t * const test_sequence_002[] = {
   &test_002_003,
 #if (CH_CFG_USE_MUTEXES) || defined(__DOXYGEN__)
   &test_002_004,
+#endif
+#if (CH_CFG_USE_REGISTRY) || defined(__DOXYGEN__)
+  &test_002_005,
 #endif
   NULL
 };
@@ -46,6 +46,11 @@
  * - @subpage test_005_007
  * - @subpage test_005_008
  * - @subpage test_005_009
+ * - @subpage test_005_010
+ * - @subpage test_005_011
+ * - @subpage test_005_012
+ * - @subpage test_005_013
+ * - @subpage test_005_014
  * .
  */
 
@@ -227,8 +232,72 @@ static THD_FUNCTION(thread9, p) {
   test_emit_token(*(char *)p);
   chMtxUnlock(&m2);
 }
+
+static THD_FUNCTION(thread10, p) {
+  msg_t msg;
+
+  chMtxLock(&m1);
+#if CH_CFG_USE_CONDVARS_TIMEOUT || defined(__DOXYGEN__)
+  msg = chCondWaitTimeout(&c1, MS2ST(50));
+#else
+  msg = chCondWait(&c1);
+#endif
+  if (msg == MSG_RESET) {
+    test_emit_token(*(char *)p);
+  }
+  if (msg != MSG_TIMEOUT) {
+    chMtxUnlock(&m1);
+  }
+}
 #endif /* CH_CFG_USE_CONDVARS */
 
+#if CH_CFG_USE_RWLOCKS || defined(__DOXYGEN__)
+static RWLOCK_DECL(rw1);
+
+static THD_FUNCTION(thread11R, p) {
+
+  (void) chRWLockReadLock(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockReadUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread11W, p) {
+
+  (void) chRWLockWriteLock(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockWriteUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread12, p) {
+
+  (void) chRWLockReadLock(&rw1);
+  chMtxLock(&m1);
+  test_emit_token(*(char *)p);
+  chMtxUnlock(&m1);
+  chRWLockReadUnlock(&rw1);
+}
+
+static THD_FUNCTION(thread13R, p) {
+
+  if (chRWLockReadLockTimeout(&rw1, MS2ST(50)) == MSG_TIMEOUT) {
+    test_emit_token(*(char *)p);
+  }
+  else {
+    chRWLockReadUnlock(&rw1);
+  }
+}
+
+static THD_FUNCTION(thread13W, p) {
+
+  if (chRWLockWriteLockTimeout(&rw1, MS2ST(50)) == MSG_TIMEOUT) {
+    test_emit_token(*(char *)p);
+  }
+  else {
+    chRWLockWriteUnlock(&rw1);
+  }
+}
+#endif /* CH_CFG_USE_RWLOCKS */
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -1032,6 +1101,480 @@ static const testcase_t test_005_009 = {
 };
 #endif /* CH_CFG_USE_CONDVARS */
 
+#if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
+/**
+ * @page test_005_010 [5.10] Condition Variable wait morphing test
+ *
+ * <h2>Description</h2>
+ * Five threads take a mutex and then enter a conditional variable
+ * queue, the tester thread then broadcasts the conditional variable
+ * while owning the mutex.<br> The test expects the threads to be moved
+ * on the mutex queue without running, to ignore their timeouts while
+ * waiting for the mutex and to reach their goal in decreasing priority
+ * order when the mutex is released.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_CONDVARS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [5.10.1] Starting the five threads with increasing priority, the
+ *   threads will queue on the condition variable.
+ * - [5.10.2] Locking the mutex and broadcasting on the condition
+ *   variable, the threads must be moved on the mutex queue without
+ *   running and the priority of the tester thread must be boosted.
+ * - [5.10.3] Sleeping while owning the mutex, the timeouts of the
+ *   threads expire but must not release them.
+ * - [5.10.4] Unlocking the mutex then waiting for the threads to
+ *   terminate in priority order, the order is tested.
+ * .
+ */
+
+static void test_005_010_setup(void) {
+  chCondObjectInit(&c1);
+  chMtxObjectInit(&m1);
+}
+
+static void test_005_010_execute(void) {
+  tprio_t prio;
+
+  /* [5.10.1] Starting the five threads with increasing priority, the
+     threads will queue on the condition variable.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread10, "E");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+2, thread10, "D");
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio+3, thread10, "C");
+    threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio+4, thread10, "B");
+    threads[4] = chThdCreateStatic(wa[4], WA_SIZE, prio+5, thread10, "A");
+  }
+
+  /* [5.10.2] Locking the mutex and broadcasting on the condition
+     variable, the threads must be moved on the mutex queue without
+     running and the priority of the tester thread must be boosted.*/
+  test_set_step(2);
+  {
+    unsigned i;
+
+    chMtxLock(&m1);
+    chCondBroadcast(&c1);
+    test_assert_sequence("", "unexpected tokens");
+    for (i = 0; i < MAX_THREADS; i++) {
+      test_assert(threads[i]->state == CH_STATE_WTMTX, "not waiting on the mutex");
+    }
+    test_assert(chThdGetPriorityX() == prio + 5, "wrong priority level");
+  }
+
+  /* [5.10.3] Sleeping while owning the mutex, the timeouts of the
+     threads expire but must not release them.*/
+  test_set_step(3);
+  {
+    unsigned i;
+
+    chThdSleepMilliseconds(100);
+    test_assert_sequence("", "unexpected tokens");
+    for (i = 0; i < MAX_THREADS; i++) {
+      test_assert(threads[i]->state == CH_STATE_WTMTX, "not waiting on the mutex");
+    }
+  }
+
+  /* [5.10.4] Unlocking the mutex then waiting for the threads to
+     terminate in priority order, the order is tested.*/
+  test_set_step(4);
+  {
+    chMtxUnlock(&m1);
+    test_wait_threads();
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert_sequence("ABCDE", "invalid sequence");
+  }
+}
+
+static const testcase_t test_005_010 = {
+  "Condition Variable wait morphing test",
+  test_005_010_setup,
+  NULL,
+  test_005_010_execute
+};
+#endif /* CH_CFG_USE_CONDVARS */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_005_011 [5.11] Reader-writer lock, readers and writer preference
+ *
+ * <h2>Description</h2>
+ * The lock is taken in read mode by the tester thread then two readers,
+ * a writer and another reader are started at higher priority.<br> The
+ * test expects the first two readers to share the lock and the last
+ * reader to be queued because a writer is waiting, the queued threads
+ * take the lock in priority order when it is released.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [5.11.1] Taking the lock in read mode then starting two readers,
+ *   the readers must share the lock and complete immediately.
+ * - [5.11.2] Starting a writer and then a reader at higher priority,
+ *   both must be queued, the reader must not join the lock because a
+ *   writer is waiting.
+ * - [5.11.3] Releasing the lock, the queued threads must take the lock
+ *   in priority order.
+ * .
+ */
+
+static void test_005_011_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void test_005_011_execute(void) {
+  tprio_t prio;
+
+  /* [5.11.1] Taking the lock in read mode then starting two readers,
+     the readers must share the lock and complete immediately.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    (void) chRWLockReadLock(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread11R, "A");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread11R, "B");
+    test_assert_sequence("AB", "readers not sharing the lock");
+  }
+
+  /* [5.11.2] Starting a writer and then a reader at higher priority,
+     both must be queued, the reader must not join the lock because a
+     writer is waiting.*/
+  test_set_step(2);
+  {
+    threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio+1, thread11W, "D");
+    threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio+2, thread11R, "C");
+    test_assert_sequence("", "unexpected tokens");
+    test_assert(threads[2]->state == CH_STATE_WTRWLOCK, "writer not waiting");
+    test_assert(threads[3]->state == CH_STATE_WTRWLOCK, "reader not waiting");
+    test_assert(chThdGetPriorityX() == prio + 2, "wrong priority level");
+  }
+
+  /* [5.11.3] Releasing the lock, the queued threads must take the lock
+     in priority order.*/
+  test_set_step(3);
+  {
+    chRWLockReadUnlock(&rw1);
+    test_wait_threads();
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert_sequence("CD", "invalid sequence");
+  }
+}
+
+static const testcase_t test_005_011 = {
+  "Reader-writer lock, readers and writer preference",
+  test_005_011_setup,
+  NULL,
+  test_005_011_execute
+};
+#endif /* CH_CFG_USE_RWLOCKS */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_005_012 [5.12] Reader-writer lock, priority inheritance
+ *
+ * <h2>Description</h2>
+ * The tester thread owns a mutex, a reader takes the lock and then
+ * waits on the mutex, a writer at higher priority is queued on the
+ * lock. The test expects the writer priority to be inherited by the
+ * reader and, through the mutex, by the tester thread.<br> In the
+ * second part the tester thread holds both the lock and the mutex, the
+ * priority inherited through the lock must be retained when the mutex
+ * is released.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [5.12.1] Locking the mutex then starting a reader that takes the
+ *   lock and waits on the mutex.
+ * - [5.12.2] Starting a writer at higher priority, the reader and the
+ *   tester thread must inherit its priority.
+ * - [5.12.3] Unlocking the mutex, the reader completes then the writer
+ *   takes the lock, the priority of the tester thread is returned.
+ * - [5.12.4] Taking the lock in read mode and the mutex then starting a
+ *   writer and a thread waiting on the mutex, the tester thread must
+ *   inherit the highest priority.
+ * - [5.12.5] Unlocking the mutex, the priority inherited from the
+ *   writer must be retained until the lock is released.
+ * .
+ */
+
+static void test_005_012_setup(void) {
+  chRWLockObjectInit(&rw1);
+  chMtxObjectInit(&m1);
+}
+
+static void test_005_012_execute(void) {
+  tprio_t prio;
+
+  /* [5.12.1] Locking the mutex then starting a reader that takes the
+     lock and waits on the mutex.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    chMtxLock(&m1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread12, "B");
+    test_assert(threads[0]->state == CH_STATE_WTMTX, "not waiting on the mutex");
+    test_assert(chThdGetPriorityX() == prio + 1, "wrong priority level");
+  }
+
+  /* [5.12.2] Starting a writer at higher priority, the reader and the
+     tester thread must inherit its priority.*/
+  test_set_step(2);
+  {
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+3, thread11W, "A");
+    test_assert(threads[1]->state == CH_STATE_WTRWLOCK, "not waiting on the lock");
+    test_assert(threads[0]->prio == prio + 3, "reader not boosted");
+    test_assert(chThdGetPriorityX() == prio + 3, "wrong priority level");
+  }
+
+  /* [5.12.3] Unlocking the mutex, the reader completes then the writer
+     takes the lock, the priority of the tester thread is returned.*/
+  test_set_step(3);
+  {
+    chMtxUnlock(&m1);
+    test_wait_threads();
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert_sequence("BA", "invalid sequence");
+  }
+
+  /* [5.12.4] Taking the lock in read mode and the mutex then starting a
+     writer and a thread waiting on the mutex, the tester thread must
+     inherit the highest priority.*/
+  test_set_step(4);
+  {
+    (void) chRWLockReadLock(&rw1);
+    chMtxLock(&m1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+2, thread11W, "D");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+4, thread1, "C");
+    test_assert(chThdGetPriorityX() == prio + 4, "wrong priority level");
+  }
+
+  /* [5.12.5] Unlocking the mutex, the priority inherited from the
+     writer must be retained until the lock is released.*/
+  test_set_step(5);
+  {
+    chMtxUnlock(&m1);
+    test_assert_sequence("C", "invalid sequence");
+    test_assert(chThdGetPriorityX() == prio + 2, "wrong priority level");
+    chRWLockReadUnlock(&rw1);
+    test_wait_threads();
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert_sequence("D", "invalid sequence");
+  }
+}
+
+static const testcase_t test_005_012 = {
+  "Reader-writer lock, priority inheritance",
+  test_005_012_setup,
+  NULL,
+  test_005_012_execute
+};
+#endif /* CH_CFG_USE_RWLOCKS */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_005_013 [5.13] Reader-writer lock, timeouts
+ *
+ * <h2>Description</h2>
+ * Threads waiting on the lock with a timeout are released with
+ * MSG_TIMEOUT if the lock is not taken in time.<br> The test also
+ * expects the readers queued behind a writer to be admitted when the
+ * writer leaves the queue because a timeout.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [5.13.1] Testing the immediate timeout variants on a free lock, the
+ *   lock must be taken in both modes.
+ * - [5.13.2] Taking the lock in write mode then starting a reader with
+ *   timeout, the reader must exit on timeout.
+ * - [5.13.3] Taking the lock in read mode then starting a writer with
+ *   timeout and a reader at higher priority without timeout, the reader
+ *   must be admitted when the writer times out.
+ * .
+ */
+
+static void test_005_013_setup(void) {
+  chRWLockObjectInit(&rw1);
+}
+
+static void test_005_013_execute(void) {
+  tprio_t prio;
+
+  /* [5.13.1] Testing the immediate timeout variants on a free lock, the
+     lock must be taken in both modes.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    test_assert(chRWLockTryWriteLock(&rw1), "lock not taken");
+    chRWLockWriteUnlock(&rw1);
+    chSysLock();
+    test_assert(chRWLockReadLockTimeoutS(&rw1, TIME_IMMEDIATE) == MSG_OK, "lock not taken");
+    test_assert(chRWLockGetReadersI(&rw1) == 1, "wrong readers count");
+    chRWLockReadUnlockS(&rw1);
+    test_assert(!chRWLockIsWriteLockedI(&rw1), "write locked");
+    chSysUnlock();
+  }
+
+  /* [5.13.2] Taking the lock in write mode then starting a reader with
+     timeout, the reader must exit on timeout.*/
+  test_set_step(2);
+  {
+    (void) chRWLockWriteLock(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread13R, "A");
+    test_assert(threads[0]->state == CH_STATE_WTRWLOCK, "not waiting on the lock");
+    chThdSleepMilliseconds(100);
+    test_wait_threads();
+    test_assert_sequence("A", "invalid sequence");
+    chRWLockWriteUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+  }
+
+  /* [5.13.3] Taking the lock in read mode then starting a writer with
+     timeout and a reader at higher priority without timeout, the reader
+     must be admitted when the writer times out.*/
+  test_set_step(3);
+  {
+    (void) chRWLockReadLock(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread13W, "B");
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+2, thread11R, "A");
+    test_assert(threads[1]->state == CH_STATE_WTRWLOCK, "not waiting on the lock");
+    test_assert_sequence("", "unexpected tokens");
+    chThdSleepMilliseconds(100);
+    test_wait_threads();
+    test_assert_sequence("AB", "invalid sequence");
+    chRWLockReadUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert(chRWLockTryWriteLock(&rw1), "lock not free");
+    chRWLockWriteUnlock(&rw1);
+  }
+}
+
+static const testcase_t test_005_013 = {
+  "Reader-writer lock, timeouts",
+  test_005_013_setup,
+  NULL,
+  test_005_013_execute
+};
+#endif /* CH_CFG_USE_RWLOCKS */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_005_014 [5.14] Reader-writer lock, priority return on timeout
+ *
+ * <h2>Description</h2>
+ * A thread waiting on the lock at higher priority exits on timeout, the
+ * test expects the priority inherited by the lock holder to be returned
+ * immediately, without waiting for the lock release.<br> The priority
+ * inherited through other objects must be retained.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [5.14.1] Taking the lock in read mode then starting a writer with
+ *   timeout at higher priority, the tester thread must inherit its
+ *   priority.
+ * - [5.14.2] Waiting for the writer timeout, the priority must be
+ *   returned while the lock is still held.
+ * - [5.14.3] Locking the mutex and starting a thread waiting on it, then
+ *   taking the lock in write mode and starting a reader with timeout at
+ *   higher priority, the tester thread must inherit the reader priority.
+ * - [5.14.4] Waiting for the reader timeout, the priority inherited
+ *   through the mutex must be retained until the mutex is released.
+ * .
+ */
+
+static void test_005_014_setup(void) {
+  chRWLockObjectInit(&rw1);
+  chMtxObjectInit(&m1);
+}
+
+static void test_005_014_execute(void) {
+  tprio_t prio;
+
+  /* [5.14.1] Taking the lock in read mode then starting a writer with
+     timeout at higher priority, the tester thread must inherit its
+     priority.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    (void) chRWLockReadLock(&rw1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+3, thread13W, "A");
+    test_assert(threads[0]->state == CH_STATE_WTRWLOCK, "not waiting on the lock");
+    test_assert(chThdGetPriorityX() == prio + 3, "wrong priority level");
+  }
+
+  /* [5.14.2] Waiting for the writer timeout, the priority must be
+     returned while the lock is still held.*/
+  test_set_step(2);
+  {
+    test_wait_threads();
+    test_assert_sequence("A", "invalid sequence");
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    chRWLockReadUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+  }
+
+  /* [5.14.3] Locking the mutex and starting a thread waiting on it, then
+     taking the lock in write mode and starting a reader with timeout at
+     higher priority, the tester thread must inherit the reader
+     priority.*/
+  test_set_step(3);
+  {
+    chMtxLock(&m1);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread1, "C");
+    (void) chRWLockWriteLock(&rw1);
+    threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+3, thread13R, "B");
+    test_assert(threads[1]->state == CH_STATE_WTRWLOCK, "not waiting on the lock");
+    test_assert(chThdGetPriorityX() == prio + 3, "wrong priority level");
+  }
+
+  /* [5.14.4] Waiting for the reader timeout, the priority inherited
+     through the mutex must be retained until the mutex is released.*/
+  test_set_step(4);
+  {
+    chThdSleepMilliseconds(100);
+    test_assert_sequence("B", "invalid sequence");
+    test_assert(chThdGetPriorityX() == prio + 1, "wrong priority level");
+    chRWLockWriteUnlock(&rw1);
+    test_assert(chThdGetPriorityX() == prio + 1, "wrong priority level");
+    chMtxUnlock(&m1);
+    test_wait_threads();
+    test_assert(chThdGetPriorityX() == prio, "wrong priority level");
+    test_assert_sequence("C", "invalid sequence");
+  }
+}
+
+static const testcase_t test_005_014 = {
+  "Reader-writer lock, priority return on timeout",
+  test_005_014_setup,
+  NULL,
+  test_005_014_execute
+};
+#endif /* CH_CFG_USE_RWLOCKS */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -1062,6 +1605,21 @@ const testcase_t * const test_sequence_005[] = {
 #endif
 #if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
   &test_005_009,
+#endif
+#if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
+  &test_005_010,
+#endif
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &test_005_011,
+#endif
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &test_005_012,
+#endif
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &test_005_013,
+#endif
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &test_005_014,
 #endif
   NULL
 };
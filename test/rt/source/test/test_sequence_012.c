@@ -47,6 +47,10 @@
  * - @subpage test_012_010
  * - @subpage test_012_011
  * - @subpage test_012_012
+ * - @subpage test_012_013
+ * - @subpage test_012_014
+ * - @subpage test_012_015
+ * - @subpage test_012_016
  * .
  */
 
@@ -60,6 +64,9 @@ static semaphore_t sem1;
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
 static mutex_t mtx1;
 #endif
+#if CH_CFG_USE_CONDVARS || defined(__DOXYGEN__)
+static condition_variable_t cnd1;
+#endif
 
 static void tmo(void *param) {(void)param;}
 
@@ -135,6 +142,157 @@ static THD_FUNCTION(bmk_thread8, p) {
   } while(!chThdShouldTerminateX());
 }
 
+#if CH_CFG_USE_CONDVARS
+static THD_FUNCTION(bmk_thread13, p) {
+
+  (void)p;
+  chMtxLock(&mtx1);
+  do {
+    (void) chCondWait(&cnd1);
+  } while (!chThdShouldTerminateX());
+  chMtxUnlock(&mtx1);
+}
+#endif
+
+#if CH_CFG_USE_RWLOCKS
+static bool bmk_rwl;
+static rwlock_t rwl1;
+
+static THD_FUNCTION(bmk_thread14, p) {
+
+  do {
+    if (bmk_rwl) {
+      (void) chRWLockReadLock(&rwl1);
+      chThdSleepMilliseconds(1);
+      chRWLockReadUnlock(&rwl1);
+    }
+    else {
+      chMtxLock(&mtx1);
+      chThdSleepMilliseconds(1);
+      chMtxUnlock(&mtx1);
+    }
+    (*(uint32_t *)p)++;
+  } while (!chThdShouldTerminateX());
+}
+
+static THD_FUNCTION(bmk_thread15, p) {
+
+  (void)p;
+  do {
+    if (bmk_rwl) {
+      (void) chRWLockWriteLock(&rwl1);
+      chThdSleepMilliseconds(1);
+      chRWLockWriteUnlock(&rwl1);
+    }
+    else {
+      chMtxLock(&mtx1);
+      chThdSleepMilliseconds(1);
+      chMtxUnlock(&mtx1);
+    }
+    chThdSleepMilliseconds(10);
+  } while (!chThdShouldTerminateX());
+}
+
+NOINLINE static uint32_t rwl_loop_test(unsigned nr, bool rwl) {
+  uint32_t counts[MAX_THREADS];
+  uint32_t n;
+  unsigned i;
+
+  bmk_rwl = rwl;
+  for (i = 0; i < nr; i++) {
+    counts[i] = 0;
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriorityX()-1, bmk_thread14, &counts[i]);
+  }
+  threads[nr] = chThdCreateStatic(wa[nr], WA_SIZE, chThdGetPriorityX()-1, bmk_thread15, NULL);
+
+  chThdSleepUntil(test_wait_tick() + MS2ST(1000));
+  n = 0;
+  for (i = 0; i < nr; i++) {
+    n += counts[i];
+  }
+
+  test_terminate_threads();
+  test_wait_threads();
+  return n;
+}
+#endif
+
+#if CH_CFG_USE_CTASKS
+static ctask_scheduler_t bmk_cts;
+static ctask_t bmk_ct[5];
+
+static ctstate_t bmk_ctask(ctask_t *ctp) {
+
+  CT_BEGIN(ctp);
+  while (true) {
+    CT_YIELD(ctp);
+    CT_YIELD(ctp);
+    CT_YIELD(ctp);
+    CT_YIELD(ctp);
+    (*(uint32_t *)ctp->arg) += 4;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  CT_END(ctp);
+}
+
+static THD_FUNCTION(bmk_thread16, p) {
+
+  chCTRun((ctask_scheduler_t *)p);
+}
+#endif
+
+#if CH_CFG_USE_REGISTRY
+#include <string.h>
+
+#define BMK_REG_MAX_THREADS     64U
+#define BMK_REG_THREADS                                                     \
+  ((sizeof (test_buffer) / sizeof (thread_t)) < BMK_REG_MAX_THREADS ?       \
+   (sizeof (test_buffer) / sizeof (thread_t)) : BMK_REG_MAX_THREADS)
+
+static char bmk_names[BMK_REG_MAX_THREADS][4];
+
+/* Linear registry scan, same as chRegFindThreadByName() when the names
+   index is disabled.*/
+static thread_t *reg_scan(const char *name) {
+  thread_t *tp = chRegFirstThread();
+
+  do {
+    if (strcmp(chRegGetThreadNameX(tp), name) == 0) {
+      return tp;
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+
+  return NULL;
+}
+
+NOINLINE static uint32_t reg_loop_test(const char *name, bool scan) {
+  systime_t start, end;
+  uint32_t n = 0;
+
+  start = test_wait_tick();
+  end = start + MS2ST(1000);
+  do {
+    thread_t *tp = scan ? reg_scan(name) : chRegFindThreadByName(name);
+#if CH_CFG_USE_DYNAMIC
+    if (tp != NULL) {
+      chThdRelease(tp);
+    }
+#else
+    (void)tp;
+#endif
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (chVTIsSystemTimeWithinX(start, end));
+
+  return n;
+}
+#endif
+
 /****************************************************************************
  * Test cases.
  ****************************************************************************/
@@ -898,6 +1056,7 @@ static const testcase_t test_012_011 = {
  * - [12.12.7] The size of an event source is printed.
  * - [12.12.8] The size of an event listener is printed.
  * - [12.12.9] The size of a mailbox is printed.
+ * - [12.12.10] The size of a cooperative task is printed.
  * .
  */
 
@@ -986,6 +1145,16 @@ static void test_012_012_execute(void) {
     test_println(" bytes");
 #endif
   }
+
+  /* [12.12.10] The size of a cooperative task is printed.*/
+  test_set_step(10);
+  {
+    #if CH_CFG_USE_CTASKS || defined(__DOXYGEN__)
+    test_print("--- CTask : ");
+    test_printn(sizeof(ctask_t));
+    test_println(" bytes");
+    #endif
+  }
 }
 
 static const testcase_t test_012_012 = {
@@ -995,6 +1164,347 @@ static const testcase_t test_012_012 = {
   test_012_012_execute
 };
 
+#if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
+/**
+ * @page test_012_013 [12.13] Condition Variable broadcast performance
+ *
+ * <h2>Description</h2>
+ * A condition variable is broadcast into a continuous loop while
+ * owning its mutex, from two to five threads at higher priority are
+ * waiting on the condition variable and take the mutex in turn before
+ * waiting again.<br> The performance is calculated by measuring the
+ * number of iterations after a second of continuous operations, the
+ * measurement is repeated for each number of waiting threads.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_CONDVARS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [12.13.1] The threads are created then the condition variable is
+ *   broadcast in a one-second time window, the threads are terminated
+ *   and the score is printed. The measurement is repeated with two to
+ *   five threads.
+ * .
+ */
+
+static void test_012_013_setup(void) {
+  chMtxObjectInit(&mtx1);
+  chCondObjectInit(&cnd1);
+}
+
+static void test_012_013_execute(void) {
+
+  /* [12.13.1] The threads are created then the condition variable is
+     broadcast in a one-second time window, the threads are terminated
+     and the score is printed. The measurement is repeated with two to
+     five threads.*/
+  test_set_step(1);
+  {
+    unsigned i, nt;
+
+    for (nt = 2; nt <= MAX_THREADS; nt++) {
+      systime_t start, end;
+      uint32_t n;
+    #if CH_DBG_STATISTICS
+      ucnt_t ctxswc;
+    #endif
+
+      for (i = 0; i < nt; i++) {
+        threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriorityX()+1, bmk_thread13, NULL);
+      }
+
+      n = 0;
+      start = test_wait_tick();
+      end = start + MS2ST(1000);
+    #if CH_DBG_STATISTICS
+      ctxswc = ch.kernel_stats.n_ctxswc;
+    #endif
+      do {
+        chMtxLock(&mtx1);
+        chCondBroadcast(&cnd1);
+        chMtxUnlock(&mtx1);
+        n++;
+    #if defined(SIMULATOR)
+        _sim_check_for_interrupts();
+    #endif
+      } while (chVTIsSystemTimeWithinX(start, end));
+    #if CH_DBG_STATISTICS
+      ctxswc = ch.kernel_stats.n_ctxswc - ctxswc;
+    #endif
+
+      test_terminate_threads();
+      chCondBroadcast(&cnd1);
+      test_wait_threads();
+
+      test_print("--- Threads: ");
+      test_printn(nt);
+      test_print(", score : ");
+      test_printn(n);
+      test_print(" broadcasts/S");
+    #if CH_DBG_STATISTICS
+      test_print(", ");
+      test_printn(ctxswc / n);
+      test_print(" ctxswc/broadcast");
+    #endif
+      test_println("");
+    }
+  }
+}
+
+static const testcase_t test_012_013 = {
+  "Condition Variable broadcast performance",
+  test_012_013_setup,
+  NULL,
+  test_012_013_execute
+};
+#endif /* CH_CFG_USE_CONDVARS */
+
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+/**
+ * @page test_012_014 [12.14] Reader-writer lock read performance
+ *
+ * <h2>Description</h2>
+ * From one to four reader threads and a writer thread take a lock in a
+ * continuous loop, the lock is held for one millisecond in order to
+ * simulate a long operation, the writer takes the lock every 10
+ * milliseconds.<br> The performance is calculated by measuring the
+ * number of read operations after a second of continuous operations,
+ * the measurement is done using a reader-writer lock and then using a
+ * mutex and it is repeated for each number of readers.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_RWLOCKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [12.14.1] The readers and the writer are created and the read
+ *   operations are counted in a one-second time window, once using the
+ *   reader-writer lock and once using a mutex, then the scores are
+ *   printed. The measurement is repeated with one to four readers.
+ * .
+ */
+
+static void test_012_014_setup(void) {
+  chRWLockObjectInit(&rwl1);
+  chMtxObjectInit(&mtx1);
+}
+
+static void test_012_014_execute(void) {
+
+  /* [12.14.1] The readers and the writer are created and the read
+     operations are counted in a one-second time window, once using the
+     reader-writer lock and once using a mutex, then the scores are
+     printed. The measurement is repeated with one to four readers.*/
+  test_set_step(1);
+  {
+    unsigned nr;
+
+    for (nr = 1; nr < MAX_THREADS; nr++) {
+      uint32_t n;
+
+      test_print("--- Readers: ");
+      test_printn(nr);
+      n = rwl_loop_test(nr, true);
+      test_print(", rwlock: ");
+      test_printn(n);
+      n = rwl_loop_test(nr, false);
+      test_print(" reads/S, mutex: ");
+      test_printn(n);
+      test_println(" reads/S");
+    }
+  }
+}
+
+static const testcase_t test_012_014 = {
+  "Reader-writer lock read performance",
+  test_012_014_setup,
+  NULL,
+  test_012_014_execute
+};
+#endif /* CH_CFG_USE_RWLOCKS */
+
+#if (CH_CFG_USE_CTASKS) || defined(__DOXYGEN__)
+/**
+ * @page test_012_015 [12.15] Cooperative tasks voluntary reschedule
+ *
+ * <h2>Description</h2>
+ * Five cooperative tasks are run by a scheduler thread, each task just
+ * increases a variable and yields.<br> The performance is calculated by
+ * measuring the number of iterations after a second of continuous
+ * operations, the score can be compared with the Round-Robin voluntary
+ * reschedule benchmark.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_CTASKS
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [12.15.1] The five tasks are started then the scheduler thread is
+ *   created at lower priority. The tasks start calling @p CT_YIELD()
+ *   continuously.
+ * - [12.15.2] Waiting one second then terminating the scheduler thread.
+ * - [12.15.3] The score is printed.
+ * .
+ */
+
+static void test_012_015_execute(void) {
+  uint32_t n;
+
+  /* [12.15.1] The five tasks are started then the scheduler thread is
+     created at lower priority. The tasks start calling @p CT_YIELD()
+     continuously.*/
+  test_set_step(1);
+  {
+    unsigned i;
+
+    n = 0;
+    chCTObjectInit(&bmk_cts, TIME_INFINITE);
+    for (i = 0; i < 5; i++) {
+      chCTStart(&bmk_cts, &bmk_ct[i], bmk_ctask, (void *)&n);
+    }
+    test_wait_tick();
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()-1, bmk_thread16, (void *)&bmk_cts);
+  }
+
+  /* [12.15.2] Waiting one second then terminating the scheduler
+     thread.*/
+  test_set_step(2);
+  {
+    chThdSleepSeconds(1);
+    test_terminate_threads();
+    chCTKick(&bmk_cts);
+    test_wait_threads();
+  }
+
+  /* [12.15.3] The score is printed.*/
+  test_set_step(3);
+  {
+    test_print("--- Score : ");
+    test_printn(n);
+    test_println(" ctxswc/S");
+  }
+}
+
+static const testcase_t test_012_015 = {
+  "Cooperative tasks voluntary reschedule",
+  NULL,
+  NULL,
+  test_012_015_execute
+};
+#endif /* CH_CFG_USE_CTASKS */
+
+#if (CH_CFG_USE_REGISTRY) || defined(__DOXYGEN__)
+/**
+ * @page test_012_016 [12.16] Registry lookup by name performance
+ *
+ * <h2>Description</h2>
+ * Up to 64 threads named "t00", "t01"... are added to the registry then
+ * threads are looked up by name using @p chRegFindThreadByName() and
+ * using a linear scan of the registry, the linear scan is the lookup
+ * performed when @p CH_CFG_REGISTRY_HASH_SIZE is zero.<br> The
+ * performance is calculated by measuring the number of lookups after a
+ * second of continuous operations, the measurement is done for the
+ * oldest, the middle and the newest thread and for a missing name. With
+ * the names index disabled the two scores are equivalent.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_REGISTRY
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [12.16.1] The thread objects are taken from the test buffer and
+ *   initialized, the threads are never started and only exist in the
+ *   registry.
+ * - [12.16.2] The lookups are counted in a one-second time window, once
+ *   using @p chRegFindThreadByName() and once using a linear scan, then
+ *   the scores are printed. The measurement is repeated for each name.
+ * - [12.16.3] The thread objects are removed from the registry.
+ * .
+ */
+
+static void test_012_016_execute(void) {
+
+  /* [12.16.1] The thread objects are taken from the test buffer and
+     initialized, the threads are never started and only exist in the
+     registry.*/
+  test_set_step(1);
+  {
+    unsigned i;
+    thread_t *tp = (thread_t *)test_buffer;
+
+    for (i = 0; i < BMK_REG_THREADS; i++) {
+      bmk_names[i][0] = 't';
+      bmk_names[i][1] = (char)('0' + (i / 10U));
+      bmk_names[i][2] = (char)('0' + (i % 10U));
+      bmk_names[i][3] = '\0';
+      chSysLock();
+      (void) _thread_init(&tp[i], bmk_names[i], chThdGetPriorityX() - 1);
+      chSysUnlock();
+    }
+  }
+
+  /* [12.16.2] The lookups are counted in a one-second time window, once
+     using @p chRegFindThreadByName() and once using a linear scan, then
+     the scores are printed. The measurement is repeated for each
+     name.*/
+  test_set_step(2);
+  {
+    const char *names[4];
+    unsigned i;
+
+    names[0] = bmk_names[0];
+    names[1] = bmk_names[BMK_REG_THREADS / 2U];
+    names[2] = bmk_names[BMK_REG_THREADS - 1U];
+    names[3] = "none";
+    test_print("--- Threads: ");
+    test_printn((uint32_t)BMK_REG_THREADS);
+    test_println("");
+    for (i = 0; i < 4; i++) {
+      uint32_t n;
+
+      test_print("--- Name: ");
+      test_print(names[i]);
+      n = reg_loop_test(names[i], false);
+      test_print(", lookup: ");
+      test_printn(n);
+      n = reg_loop_test(names[i], true);
+      test_print(" lookups/S, scan: ");
+      test_printn(n);
+      test_println(" lookups/S");
+    }
+  }
+
+  /* [12.16.3] The thread objects are removed from the registry.*/
+  test_set_step(3);
+  {
+    unsigned i;
+    thread_t *tp = (thread_t *)test_buffer;
+
+    chSysLock();
+    for (i = 0; i < BMK_REG_THREADS; i++) {
+      REG_REMOVE(&tp[i]);
+    }
+    chSysUnlock();
+  }
+}
+
+static const testcase_t test_012_016 = {
+  "Registry lookup by name performance",
+  NULL,
+  NULL,
+  test_012_016_execute
+};
+#endif /* CH_CFG_USE_REGISTRY */
+
 /****************************************************************************
  * Exported data.
  ****************************************************************************/
@@ -1027,5 +1537,17 @@ const testcase_t * const test_sequence_012[] = {
   &test_012_011,
 #endif
   &test_012_012,
+#if (CH_CFG_USE_CONDVARS) || defined(__DOXYGEN__)
+  &test_012_013,
+#endif
+#if (CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+  &test_012_014,
+#endif
+#if (CH_CFG_USE_CTASKS) || defined(__DOXYGEN__)
+  &test_012_015,
+#endif
+#if (CH_CFG_USE_REGISTRY) || defined(__DOXYGEN__)
+  &test_012_016,
+#endif
   NULL
 };
@@ -0,0 +1,441 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "ch_test.h"
+#include "test_root.h"
+
+/**
+ * @file    test_sequence_013.c
+ * @brief   Test Sequence 013 code.
+ *
+ * @page test_sequence_013 [13] Work Queues
+ *
+ * File: @ref test_sequence_013.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to work
+ * queues.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_WORKQUEUES
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_013_001
+ * - @subpage test_013_002
+ * - @subpage test_013_003
+ * - @subpage test_013_004
+ * .
+ */
+
+#if (CH_CFG_USE_WORKQUEUES) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+static work_queue_t wq1;
+static work_item_t wi[4];
+static delayed_work_t dw1;
+static virtual_timer_t wqvt;
+static unsigned wqcnt;
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+static semaphore_t sem1;
+#endif
+
+/* Work function emitting a token.*/
+static void wqfunc1(void *p) {
+
+  test_emit_token(*(char *)p);
+}
+
+/* Work function submitting its own item again until three executions
+   happened.*/
+static void wqfunc2(void *p) {
+
+  test_emit_token('A' + (char)wqcnt);
+  if (++wqcnt < 3U) {
+    (void) chWQSubmit(NULL, (work_item_t *)p);
+  }
+}
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/* Work function blocking on a semaphore before emitting a token.*/
+static void wqfunc3(void *p) {
+
+  (void) chSemWait(&sem1);
+  test_emit_token(*(char *)p);
+}
+#endif
+
+/* Timer callback submitting a work item from ISR context.*/
+static void wqvtcb(void *p) {
+
+  chSysLockFromISR();
+  (void) chWQSubmitI(NULL, (work_item_t *)p);
+  chSysUnlockFromISR();
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page test_013_001 [13.1] Work queue, submission and priority order
+ *
+ * <h2>Description</h2>
+ * A worker with priority lower than the tester thread serves a queue,
+ * work items with different priorities are submitted and must be
+ * executed in priority order, items with equal priority in FIFO order.
+ * Pending items cannot be submitted again and can be canceled.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.1.1] Creating a worker with lower priority then submitting four
+ *   items, a second submission of a pending item must fail.
+ * - [13.1.2] Canceling an item, it must be removed from the queue only
+ *   once.
+ * - [13.1.3] Letting the worker run, the items must be executed in
+ *   priority order and the queue must be empty.
+ * .
+ */
+
+static void test_013_001_setup(void) {
+  chWQObjectInit(&wq1);
+}
+
+static void test_013_001_teardown(void) {
+  test_terminate_threads();
+  chWQReset(&wq1);
+  test_wait_threads();
+}
+
+static void test_013_001_execute(void) {
+  tprio_t prio;
+  cnt_t n;
+
+  /* [13.1.1] Creating a worker with lower priority then submitting four
+     items, a second submission of a pending item must fail.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    threads[0] = chWQCreateWorker(&wq1, wa[0], WA_SIZE, prio - 1);
+    chWQItemObjectInit(&wi[0], wqfunc1, "A", 1);
+    chWQItemObjectInit(&wi[1], wqfunc1, "B", 3);
+    chWQItemObjectInit(&wi[2], wqfunc1, "C", 2);
+    chWQItemObjectInit(&wi[3], wqfunc1, "D", 3);
+    test_assert(chWQSubmit(&wq1, &wi[0]), "submission failed");
+    test_assert(chWQSubmit(&wq1, &wi[1]), "submission failed");
+    test_assert(chWQSubmit(&wq1, &wi[2]), "submission failed");
+    test_assert(chWQSubmit(&wq1, &wi[3]), "submission failed");
+    test_assert(!chWQSubmit(&wq1, &wi[0]), "pending item submitted");
+    chSysLock();
+    n = chWQGetDepthI(&wq1);
+    chSysUnlock();
+    test_assert(n == 4, "wrong queue depth");
+  }
+
+  /* [13.1.2] Canceling an item, it must be removed from the queue only
+     once.*/
+  test_set_step(2);
+  {
+    test_assert(chWQCancel(&wi[2]), "not canceled");
+    test_assert(!chWQCancel(&wi[2]), "canceled twice");
+    chSysLock();
+    n = chWQGetDepthI(&wq1);
+    chSysUnlock();
+    test_assert(n == 3, "wrong queue depth");
+  }
+
+  /* [13.1.3] Letting the worker run, the items must be executed in
+     priority order and the queue must be empty.*/
+  test_set_step(3);
+  {
+    chThdSleepMilliseconds(10);
+    test_assert_sequence("BDA", "invalid sequence");
+    chSysLock();
+    n = chWQGetDepthI(&wq1);
+    chSysUnlock();
+    test_assert(n == 0, "queue not empty");
+    test_assert(!chWQCancel(&wi[0]), "item still pending");
+  }
+}
+
+static const testcase_t test_013_001 = {
+  "Work queue, submission and priority order",
+  test_013_001_setup,
+  test_013_001_teardown,
+  test_013_001_execute
+};
+
+/**
+ * @page test_013_002 [13.2] Work queue, delayed work
+ *
+ * <h2>Description</h2>
+ * A delayed work item is submitted to a queue served by a worker with
+ * priority higher than the tester thread, the item must be executed
+ * after the delay. A delayed item canceled before its delay expires
+ * must not be executed.
+ *
+ * <h2>Test Steps</h2>
+ * - [13.2.1] Creating a worker with higher priority then submitting a
+ *   delayed item, a second submission of the pending item must fail.
+ * - [13.2.2] Waiting for half of the delay, the item must not have been
+ *   executed, waiting for the remaining time, the item must have been
+ *   executed.
+ * - [13.2.3] Submitting the item again then canceling it, the item must
+ *   not be executed.
+ * - [13.2.4] Submitting the item with TIME_IMMEDIATE delay, the item
+ *   must be executed immediately.
+ * .
+ */
+
+static void test_013_002_setup(void) {
+  chWQObjectInit(&wq1);
+  chWQDelayedObjectInit(&dw1, wqfunc1, "A", 1);
+}
+
+static void test_013_002_teardown(void) {
+  test_terminate_threads();
+  chWQReset(&wq1);
+  test_wait_threads();
+}
+
+static void test_013_002_execute(void) {
+  tprio_t prio;
+  systime_t start;
+
+  /* [13.2.1] Creating a worker with higher priority then submitting a
+     delayed item, a second submission of the pending item must fail.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    threads[0] = chWQCreateWorker(&wq1, wa[0], WA_SIZE, prio + 1);
+    start = test_wait_tick();
+    test_assert(chWQSubmitDelayed(&wq1, &dw1, MS2ST(50)), "submission failed");
+    test_assert(!chWQSubmitDelayed(&wq1, &dw1, MS2ST(50)), "pending item submitted");
+    test_assert(!chWQSubmit(&wq1, &dw1.item), "pending item submitted");
+  }
+
+  /* [13.2.2] Waiting for half of the delay, the item must not have been
+     executed, waiting for the remaining time, the item must have been
+     executed.*/
+  test_set_step(2);
+  {
+    chThdSleepUntil(start + MS2ST(25));
+    test_assert_sequence("", "executed before delay");
+    chThdSleepUntil(start + MS2ST(75));
+    test_assert_sequence("A", "not executed");
+    test_assert(!chWQCancelDelayed(&dw1), "item still pending");
+  }
+
+  /* [13.2.3] Submitting the item again then canceling it, the item must
+     not be executed.*/
+  test_set_step(3);
+  {
+    test_assert(chWQSubmitDelayed(&wq1, &dw1, MS2ST(50)), "submission failed");
+    test_assert(chWQCancelDelayed(&dw1), "not canceled");
+    test_assert(!chWQCancelDelayed(&dw1), "canceled twice");
+    chThdSleepMilliseconds(75);
+    test_assert_sequence("", "canceled item executed");
+  }
+
+  /* [13.2.4] Submitting the item with TIME_IMMEDIATE delay, the item
+     must be executed immediately.*/
+  test_set_step(4);
+  {
+    test_assert(chWQSubmitDelayed(&wq1, &dw1, TIME_IMMEDIATE), "submission failed");
+    test_assert_sequence("A", "not executed");
+  }
+}
+
+static const testcase_t test_013_002 = {
+  "Work queue, delayed work",
+  test_013_002_setup,
+  test_013_002_teardown,
+  test_013_002_execute
+};
+
+#if (CH_CFG_WORKQ_WORKERS > 0) || defined(__DOXYGEN__)
+/**
+ * @page test_013_003 [13.3] System work queue, submission from ISR
+ *
+ * <h2>Description</h2>
+ * Work items are submitted to the system work queue from a virtual
+ * timer callback and from their own work function.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_WORKQ_WORKERS > 0
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.3.1] Submitting an item from a virtual timer callback, the item
+ *   must be executed.
+ * - [13.3.2] Submitting an item that submits itself again from its own
+ *   function, three executions are expected.
+ * .
+ */
+
+static void test_013_003_execute(void) {
+
+  /* [13.3.1] Submitting an item from a virtual timer callback, the item
+     must be executed.*/
+  test_set_step(1);
+  {
+    chWQItemObjectInit(&wi[0], wqfunc1, "A", 1);
+    chVTObjectInit(&wqvt);
+    chVTSet(&wqvt, MS2ST(10), wqvtcb, &wi[0]);
+    chThdSleepMilliseconds(20);
+    test_assert_sequence("A", "not executed");
+  }
+
+  /* [13.3.2] Submitting an item that submits itself again from its own
+     function, three executions are expected.*/
+  test_set_step(2);
+  {
+    wqcnt = 0;
+    chWQItemObjectInit(&wi[1], wqfunc2, &wi[1], 1);
+    test_assert(chWQSubmit(NULL, &wi[1]), "submission failed");
+    chThdSleepMilliseconds(10);
+    test_assert_sequence("ABC", "invalid sequence");
+  }
+}
+
+static const testcase_t test_013_003 = {
+  "System work queue, submission from ISR",
+  NULL,
+  NULL,
+  test_013_003_execute
+};
+#endif /* CH_CFG_WORKQ_WORKERS > 0 */
+
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page test_013_004 [13.4] Work queue, multiple workers and blocking items
+ *
+ * <h2>Description</h2>
+ * Two workers serve a queue, three items blocking on a semaphore are
+ * submitted. The first two items must be taken by the workers while the
+ * third must remain in the queue until a worker becomes available.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEMAPHORES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [13.4.1] Creating two workers with higher priority then submitting
+ *   three items, the third item must remain in the queue.
+ * - [13.4.2] Signaling the semaphore three times, the items must
+ *   complete in submission order.
+ * - [13.4.3] Checking the queue statistics.
+ * .
+ */
+
+static void test_013_004_setup(void) {
+  chWQObjectInit(&wq1);
+  chSemObjectInit(&sem1, 0);
+}
+
+static void test_013_004_teardown(void) {
+  test_terminate_threads();
+  chSemReset(&sem1, 0);
+  chWQReset(&wq1);
+  test_wait_threads();
+}
+
+static void test_013_004_execute(void) {
+  tprio_t prio;
+  cnt_t n;
+
+  /* [13.4.1] Creating two workers with higher priority then submitting
+     three items, the third item must remain in the queue.*/
+  test_set_step(1);
+  {
+    prio = chThdGetPriorityX();
+    threads[0] = chWQCreateWorker(&wq1, wa[0], WA_SIZE, prio + 1);
+    threads[1] = chWQCreateWorker(&wq1, wa[1], WA_SIZE, prio + 1);
+    chWQItemObjectInit(&wi[0], wqfunc3, "A", 1);
+    chWQItemObjectInit(&wi[1], wqfunc3, "B", 1);
+    chWQItemObjectInit(&wi[2], wqfunc3, "C", 1);
+    test_assert(chWQSubmit(&wq1, &wi[0]), "submission failed");
+    test_assert(chWQSubmit(&wq1, &wi[1]), "submission failed");
+    test_assert(chWQSubmit(&wq1, &wi[2]), "submission failed");
+    chSysLock();
+    n = chWQGetDepthI(&wq1);
+    chSysUnlock();
+    test_assert(n == 1, "wrong queue depth");
+  }
+
+  /* [13.4.2] Signaling the semaphore three times, the items must
+     complete in submission order.*/
+  test_set_step(2);
+  {
+    chSemSignal(&sem1);
+    chSemSignal(&sem1);
+    chSemSignal(&sem1);
+    test_assert_sequence("ABC", "invalid sequence");
+    chSysLock();
+    n = chWQGetDepthI(&wq1);
+    chSysUnlock();
+    test_assert(n == 0, "queue not empty");
+  }
+
+  /* [13.4.3] Checking the queue statistics.*/
+  test_set_step(3);
+  {
+    #if CH_DBG_STATISTICS == TRUE
+    test_assert(wq1.stats.n_submitted == 3U, "wrong submitted counter");
+    test_assert(wq1.stats.n_executed == 3U, "wrong executed counter");
+    test_assert(wq1.stats.max_depth == 1, "wrong maximum depth");
+    test_assert(wq1.stats.latency.n == 3U, "wrong latency measurements");
+    #endif
+  }
+}
+
+static const testcase_t test_013_004 = {
+  "Work queue, multiple workers and blocking items",
+  test_013_004_setup,
+  test_013_004_teardown,
+  test_013_004_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Work Queues.
+ */
+const testcase_t * const test_sequence_013[] = {
+  &test_013_001,
+  &test_013_002,
+#if (CH_CFG_WORKQ_WORKERS > 0) || defined(__DOXYGEN__)
+  &test_013_003,
+#endif
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &test_013_004,
+#endif
+  NULL
+};
+
+#endif /* CH_CFG_USE_WORKQUEUES */
@@ -0,0 +1,542 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "ch_test.h"
+#include "test_root.h"
+
+/**
+ * @file    test_sequence_014.c
+ * @brief   Test Sequence 014 code.
+ *
+ * @page test_sequence_014 [14] Cooperative Tasks
+ *
+ * File: @ref test_sequence_014.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to
+ * cooperative tasks.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_CTASKS
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_014_001
+ * - @subpage test_014_002
+ * - @subpage test_014_003
+ * - @subpage test_014_004
+ * - @subpage test_014_005
+ * .
+ */
+
+#if (CH_CFG_USE_CTASKS) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+/* Task data, the task local variables are not preserved across
+   suspension points.*/
+typedef struct {
+  char                  token;
+  unsigned              n;
+  eventmask_t           events;
+} ctdata_t;
+
+static ctask_scheduler_t cts1;
+static ctask_t ct[3];
+static ctdata_t ctd[3];
+static volatile bool ctflag;
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+static semaphore_t ctsem;
+#endif
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+static msg_t ctmb_buffer[2];
+static mailbox_t ctmb;
+#endif
+
+/* Thread running the tasks scheduler.*/
+static THD_FUNCTION(ctthread, p) {
+
+  chCTRun((ctask_scheduler_t *)p);
+}
+
+/* Emits the task token if the last wait succeeded, 'T' on timeout.*/
+static void ctemit(ctask_t *ctp) {
+
+  if (ctp->msg == MSG_OK) {
+    test_emit_token(((ctdata_t *)ctp->arg)->token);
+  }
+  else {
+    test_emit_token('T');
+  }
+}
+
+/* Task emitting its token and yielding twice.*/
+static ctstate_t ctfunc1(ctask_t *ctp) {
+  ctdata_t *dp = (ctdata_t *)ctp->arg;
+
+  CT_BEGIN(ctp);
+  for (dp->n = 0U; dp->n < 2U; dp->n++) {
+    test_emit_token(dp->token);
+    CT_YIELD(ctp);
+  }
+  CT_END(ctp);
+}
+
+/* Task sleeping for 50mS.*/
+static ctstate_t ctfunc2(ctask_t *ctp) {
+
+  CT_BEGIN(ctp);
+  CT_SLEEP(ctp, MS2ST(50));
+  test_emit_token(((ctdata_t *)ctp->arg)->token);
+  CT_END(ctp);
+}
+
+/* Task waiting for the flag with a 25mS timeout.*/
+static ctstate_t ctfunc3(ctask_t *ctp) {
+
+  CT_BEGIN(ctp);
+  CT_WAIT_UNTIL_TIMEOUT(ctp, ctflag, MS2ST(25));
+  ctemit(ctp);
+  CT_END(ctp);
+}
+
+/* Task waiting for an event with a 50mS timeout.*/
+static ctstate_t ctfunc4(ctask_t *ctp) {
+  ctdata_t *dp = (ctdata_t *)ctp->arg;
+
+  CT_BEGIN(ctp);
+  CT_EVT_WAIT_ANY_TIMEOUT(ctp, EVENT_MASK(0), &dp->events, MS2ST(50));
+  ctemit(ctp);
+  CT_END(ctp);
+}
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/* Task waiting on a semaphore with a 50mS timeout.*/
+static ctstate_t ctfunc5(ctask_t *ctp) {
+
+  CT_BEGIN(ctp);
+  CT_SEM_WAIT_TIMEOUT(ctp, &ctsem, MS2ST(50));
+  ctemit(ctp);
+  CT_END(ctp);
+}
+#endif
+
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+/* Task posting three messages.*/
+static ctstate_t ctfunc6(ctask_t *ctp) {
+  ctdata_t *dp = (ctdata_t *)ctp->arg;
+
+  CT_BEGIN(ctp);
+  for (dp->n = 0U; dp->n < 3U; dp->n++) {
+    CT_MB_POST_TIMEOUT(ctp, &ctmb, (msg_t)('A' + dp->n), TIME_INFINITE);
+  }
+  CT_END(ctp);
+}
+
+/* Task fetching three messages and emitting them as tokens.*/
+static ctstate_t ctfunc7(ctask_t *ctp) {
+  ctdata_t *dp = (ctdata_t *)ctp->arg;
+  msg_t msg;
+
+  CT_BEGIN(ctp);
+  for (dp->n = 0U; dp->n < 3U; dp->n++) {
+    CT_MB_FETCH_TIMEOUT(ctp, &ctmb, &msg, TIME_INFINITE);
+    test_emit_token((char)msg);
+  }
+  CT_END(ctp);
+}
+#endif
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page test_014_001 [14.1] Cooperative tasks, yield and termination
+ *
+ * <h2>Description</h2>
+ * Three tasks emitting a token and yielding twice are started before
+ * the scheduler thread, the tasks must run in round-robin order and
+ * terminate. Two more tasks are then started while the scheduler is
+ * running.
+ *
+ * <h2>Test Steps</h2>
+ * - [14.1.1] Starting three tasks then the scheduler thread, the tasks
+ *   must interleave and terminate.
+ * - [14.1.2] Starting two tasks from a critical zone while the
+ *   scheduler is running, the tasks must interleave and terminate.
+ * .
+ */
+
+static void test_014_001_setup(void) {
+  chCTObjectInit(&cts1, TIME_INFINITE);
+}
+
+static void test_014_001_teardown(void) {
+  test_terminate_threads();
+  chCTKick(&cts1);
+  test_wait_threads();
+}
+
+static void test_014_001_execute(void) {
+
+  /* [14.1.1] Starting three tasks then the scheduler thread, the tasks
+     must interleave and terminate.*/
+  test_set_step(1);
+  {
+    ctd[0].token = 'A';
+    ctd[1].token = 'B';
+    ctd[2].token = 'C';
+    chCTStart(&cts1, &ct[0], ctfunc1, &ctd[0]);
+    chCTStart(&cts1, &ct[1], ctfunc1, &ctd[1]);
+    chCTStart(&cts1, &ct[2], ctfunc1, &ctd[2]);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   ctthread, &cts1);
+    test_assert_sequence("ABCABC", "invalid sequence");
+    test_assert(chCTGetStateX(&ct[0]) == CT_EXITED, "not exited");
+    test_assert(chCTGetStateX(&ct[1]) == CT_EXITED, "not exited");
+    test_assert(chCTGetStateX(&ct[2]) == CT_EXITED, "not exited");
+  }
+
+  /* [14.1.2] Starting two tasks from a critical zone while the
+     scheduler is running, the tasks must interleave and terminate.*/
+  test_set_step(2);
+  {
+    ctd[0].token = 'D';
+    ctd[1].token = 'E';
+    chSysLock();
+    chCTStartI(&cts1, &ct[0], ctfunc1, &ctd[0]);
+    chCTStartI(&cts1, &ct[1], ctfunc1, &ctd[1]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_assert_sequence("DEDE", "invalid sequence");
+    test_assert(chCTGetStateX(&ct[0]) == CT_EXITED, "not exited");
+    test_assert(chCTGetStateX(&ct[1]) == CT_EXITED, "not exited");
+  }
+}
+
+static const testcase_t test_014_001 = {
+  "Cooperative tasks, yield and termination",
+  test_014_001_setup,
+  test_014_001_teardown,
+  test_014_001_execute
+};
+
+/**
+ * @page test_014_002 [14.2] Cooperative tasks, sleep and conditions
+ *
+ * <h2>Description</h2>
+ * A task sleeps for 50mS while a task waits for a condition with a 25mS
+ * timeout, the timeout must expire before the sleep ends. A task
+ * waiting for a condition must proceed when the condition becomes true
+ * within the polling interval.
+ *
+ * <h2>Test Steps</h2>
+ * - [14.2.1] Starting the scheduler thread then a sleeping task and a
+ *   task waiting on a condition.
+ * - [14.2.2] Waiting for 35mS, the condition wait must have timed out,
+ *   waiting for 65mS, the sleep must have ended.
+ * - [14.2.3] Starting the condition task again then making the
+ *   condition true, the task must proceed within the polling interval.
+ * .
+ */
+
+static void test_014_002_setup(void) {
+  chCTObjectInit(&cts1, MS2ST(5));
+  ctflag = false;
+}
+
+static void test_014_002_teardown(void) {
+  test_terminate_threads();
+  chCTKick(&cts1);
+  test_wait_threads();
+}
+
+static void test_014_002_execute(void) {
+  systime_t start;
+
+  /* [14.2.1] Starting the scheduler thread then a sleeping task and a
+     task waiting on a condition.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   ctthread, &cts1);
+    ctd[0].token = 'A';
+    ctd[1].token = 'B';
+    start = test_wait_tick();
+    chCTStart(&cts1, &ct[0], ctfunc2, &ctd[0]);
+    chCTStart(&cts1, &ct[1], ctfunc3, &ctd[1]);
+    test_assert_sequence("", "unexpected tokens");
+  }
+
+  /* [14.2.2] Waiting for 35mS, the condition wait must have timed out,
+     waiting for 65mS, the sleep must have ended.*/
+  test_set_step(2);
+  {
+    chThdSleepUntil(start + MS2ST(35));
+    test_assert_sequence("T", "invalid sequence");
+    chThdSleepUntil(start + MS2ST(65));
+    test_assert_sequence("A", "invalid sequence");
+    test_assert(chCTGetStateX(&ct[0]) == CT_EXITED, "not exited");
+    test_assert(chCTGetStateX(&ct[1]) == CT_EXITED, "not exited");
+  }
+
+  /* [14.2.3] Starting the condition task again then making the
+     condition true, the task must proceed within the polling
+     interval.*/
+  test_set_step(3);
+  {
+    ctd[1].token = 'C';
+    chCTStart(&cts1, &ct[1], ctfunc3, &ctd[1]);
+    ctflag = true;
+    chThdSleepMilliseconds(10);
+    test_assert_sequence("C", "invalid sequence");
+  }
+}
+
+static const testcase_t test_014_002 = {
+  "Cooperative tasks, sleep and conditions",
+  test_014_002_setup,
+  test_014_002_teardown,
+  test_014_002_execute
+};
+
+/**
+ * @page test_014_003 [14.3] Cooperative tasks, events
+ *
+ * <h2>Description</h2>
+ * A task waits for an event signaled to the scheduler thread, polling
+ * is disabled so the event must wake up the scheduler. Events signaled
+ * before a task waits for them must be retained and a wait with no
+ * events must time out.
+ *
+ * <h2>Test Steps</h2>
+ * - [14.3.1] Starting the scheduler thread and a task waiting for an
+ *   event then signaling the event, the task must proceed.
+ * - [14.3.2] Signaling the event then starting the task, the task must
+ *   take the event without waiting.
+ * - [14.3.3] Starting the task without signaling the event, the wait
+ *   must time out.
+ * .
+ */
+
+static void test_014_003_setup(void) {
+  chCTObjectInit(&cts1, TIME_INFINITE);
+}
+
+static void test_014_003_teardown(void) {
+  test_terminate_threads();
+  chCTKick(&cts1);
+  test_wait_threads();
+}
+
+static void test_014_003_execute(void) {
+
+  /* [14.3.1] Starting the scheduler thread and a task waiting for an
+     event then signaling the event, the task must proceed.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   ctthread, &cts1);
+    ctd[0].token = 'A';
+    chCTStart(&cts1, &ct[0], ctfunc4, &ctd[0]);
+    test_assert_sequence("", "unexpected tokens");
+    chEvtSignal(threads[0], EVENT_MASK(0));
+    test_assert_sequence("A", "invalid sequence");
+    test_assert(ctd[0].events == EVENT_MASK(0), "wrong events");
+  }
+
+  /* [14.3.2] Signaling the event then starting the task, the task must
+     take the event without waiting.*/
+  test_set_step(2);
+  {
+    ctd[0].token = 'B';
+    chEvtSignal(threads[0], EVENT_MASK(0));
+    chCTStart(&cts1, &ct[0], ctfunc4, &ctd[0]);
+    test_assert_sequence("B", "invalid sequence");
+  }
+
+  /* [14.3.3] Starting the task without signaling the event, the wait
+     must time out.*/
+  test_set_step(3);
+  {
+    chCTStart(&cts1, &ct[0], ctfunc4, &ctd[0]);
+    chThdSleepMilliseconds(75);
+    test_assert_sequence("T", "invalid sequence");
+  }
+}
+
+static const testcase_t test_014_003 = {
+  "Cooperative tasks, events",
+  test_014_003_setup,
+  test_014_003_teardown,
+  test_014_003_execute
+};
+
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page test_014_004 [14.4] Cooperative tasks, semaphores
+ *
+ * <h2>Description</h2>
+ * A task waits on a semaphore, polling is disabled so the scheduler
+ * must be kicked after signaling the semaphore. A wait on a semaphore
+ * never signaled must time out.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_SEMAPHORES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.4.1] Starting the scheduler thread and a task waiting on the
+ *   semaphore, signaling the semaphore then kicking the scheduler, the
+ *   task must proceed.
+ * - [14.4.2] Starting the task again without signaling the semaphore,
+ *   the wait must time out.
+ * .
+ */
+
+static void test_014_004_setup(void) {
+  chCTObjectInit(&cts1, TIME_INFINITE);
+  chSemObjectInit(&ctsem, 0);
+}
+
+static void test_014_004_teardown(void) {
+  test_terminate_threads();
+  chCTKick(&cts1);
+  test_wait_threads();
+}
+
+static void test_014_004_execute(void) {
+
+  /* [14.4.1] Starting the scheduler thread and a task waiting on the
+     semaphore, signaling the semaphore then kicking the scheduler, the
+     task must proceed.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   ctthread, &cts1);
+    ctd[0].token = 'A';
+    chCTStart(&cts1, &ct[0], ctfunc5, &ctd[0]);
+    chSemSignal(&ctsem);
+    test_assert_sequence("", "unexpected tokens");
+    chCTKick(&cts1);
+    test_assert_sequence("A", "invalid sequence");
+    test_assert_lock(chSemGetCounterI(&ctsem) == 0, "wrong counter");
+  }
+
+  /* [14.4.2] Starting the task again without signaling the semaphore,
+     the wait must time out.*/
+  test_set_step(2);
+  {
+    chCTStart(&cts1, &ct[0], ctfunc5, &ctd[0]);
+    chThdSleepMilliseconds(75);
+    test_assert_sequence("T", "invalid sequence");
+  }
+}
+
+static const testcase_t test_014_004 = {
+  "Cooperative tasks, semaphores",
+  test_014_004_setup,
+  test_014_004_teardown,
+  test_014_004_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+/**
+ * @page test_014_005 [14.5] Cooperative tasks, mailboxes
+ *
+ * <h2>Description</h2>
+ * A task posts three messages into a mailbox with room for two messages
+ * while another task fetches them, both tasks run in the same scheduler
+ * and must wait on each other without blocking the scheduler thread.
+ *
+ * <h2>Conditions</h2>
+ * This test is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_MAILBOXES
+ * .
+ *
+ * <h2>Test Steps</h2>
+ * - [14.5.1] Starting the scheduler thread, the producer task and the
+ *   consumer task, the messages must be received in order.
+ * .
+ */
+
+static void test_014_005_setup(void) {
+  chCTObjectInit(&cts1, MS2ST(1));
+  chMBObjectInit(&ctmb, ctmb_buffer, 2);
+}
+
+static void test_014_005_teardown(void) {
+  test_terminate_threads();
+  chCTKick(&cts1);
+  test_wait_threads();
+}
+
+static void test_014_005_execute(void) {
+
+  /* [14.5.1] Starting the scheduler thread, the producer task and the
+     consumer task, the messages must be received in order.*/
+  test_set_step(1);
+  {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                   ctthread, &cts1);
+    chCTStart(&cts1, &ct[0], ctfunc6, &ctd[0]);
+    chCTStart(&cts1, &ct[1], ctfunc7, &ctd[1]);
+    chThdSleepMilliseconds(10);
+    test_assert_sequence("ABC", "invalid sequence");
+    test_assert(chCTGetStateX(&ct[0]) == CT_EXITED, "not exited");
+    test_assert(chCTGetStateX(&ct[1]) == CT_EXITED, "not exited");
+  }
+}
+
+static const testcase_t test_014_005 = {
+  "Cooperative tasks, mailboxes",
+  test_014_005_setup,
+  test_014_005_teardown,
+  test_014_005_execute
+};
+#endif /* CH_CFG_USE_MAILBOXES */
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   Cooperative Tasks.
+ */
+const testcase_t * const test_sequence_014[] = {
+  &test_014_001,
+  &test_014_002,
+  &test_014_003,
+#if (CH_CFG_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &test_014_004,
+#endif
+#if (CH_CFG_USE_MAILBOXES) || defined(__DOXYGEN__)
+  &test_014_005,
+#endif
+  NULL
+};
+
+#endif /* CH_CFG_USE_CTASKS */
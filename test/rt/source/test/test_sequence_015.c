@@ -0,0 +1,564 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+#include "ch_test.h"
+#include "test_root.h"
+
+/**
+ * @file    test_sequence_015.c
+ * @brief   Test Sequence 015 code.
+ *
+ * @page test_sequence_015 [15] EDF Scheduling
+ *
+ * File: @ref test_sequence_015.c
+ *
+ * <h2>Description</h2>
+ * This sequence tests the ChibiOS/RT functionalities related to the EDF
+ * scheduling class.
+ *
+ * <h2>Conditions</h2>
+ * This sequence is only executed if the following preprocessor condition
+ * evaluates to true:
+ * - CH_CFG_USE_EDF
+ * .
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_015_001
+ * - @subpage test_015_002
+ * - @subpage test_015_003
+ * - @subpage test_015_004
+ * - @subpage test_015_005
+ * .
+ */
+
+#if (CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+
+/****************************************************************************
+ * Shared code.
+ ****************************************************************************/
+
+/* Creates a suspended thread in the specified working area.*/
+static thread_t *edfcreate(unsigned i, tprio_t prio, tfunc_t funcp,
+                           void *arg) {
+  thread_descriptor_t td = {
+    "edf",
+    (stkalign_t *)wa[i],
+    (stkalign_t *)((uint8_t *)wa[i] + WA_SIZE),
+    prio,
+    funcp,
+    arg
+  };
+
+  return chThdCreateSuspendedI(&td);
+}
+
+/* Executes for the specified number of system ticks, only the ticks
+   observed while running are counted.*/
+static void edfconsume(systime_t ticks) {
+  systime_t last = chVTGetSystemTimeX();
+
+  while (ticks > (systime_t)0) {
+    systime_t now = chVTGetSystemTimeX();
+
+    if (now != last) {
+      last = now;
+      ticks--;
+    }
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+}
+
+/* Executes until the specified system time.*/
+static void edfbusy(systime_t end) {
+  systime_t start = chVTGetSystemTimeX();
+
+  while (chVTIsSystemTimeWithinX(start, end)) {
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+}
+
+/* Thread emitting its token.*/
+static THD_FUNCTION(edfthread1, p) {
+
+  test_emit_token(*(char *)p);
+}
+
+/* Periodic thread consuming its budget in each job.*/
+static THD_FUNCTION(edfthread2, p) {
+
+  (void)p;
+  while (!chThdShouldTerminateX()) {
+    edfconsume(chThdGetSelfX()->edf.budget);
+    (void) chEDFWaitNextPeriod();
+  }
+}
+
+/****************************************************************************
+ * Test cases.
+ ****************************************************************************/
+
+/**
+ * @page test_015_001 [15.1] EDF ready list ordering
+ *
+ * <h2>Description</h2>
+ * Three threads with different deadlines are made ready at the same
+ * time, the threads must be executed in deadline order instead of the
+ * FIFO order of equal priority threads.
+ *
+ * <h2>Test Steps</h2>
+ * - [15.1.1] Creating three threads and adding them to the EDF class
+ *   with deadlines of 30mS, 10mS and 20mS then starting them, the
+ *   threads must run in deadline order.
+ * - [15.1.2] Waiting for the threads to terminate, the EDF load must be
+ *   released.
+ * .
+ */
+
+static void test_015_001_execute(void) {
+  tprio_t prio = chThdGetPriorityX() - 1;
+  static const edf_params_t params[3] = {
+    {MS2ST(100), MS2ST(30), MS2ST(1)},
+    {MS2ST(100), MS2ST(10), MS2ST(1)},
+    {MS2ST(100), MS2ST(20), MS2ST(1)}
+  };
+  bool admitted;
+
+  /* [15.1.1] Creating three threads and adding them to the EDF class
+     with deadlines of 30mS, 10mS and 20mS then starting them, the
+     threads must run in deadline order.*/
+  test_set_step(1);
+  {
+    chSysLock();
+    threads[0] = edfcreate(0, prio, edfthread1, "A");
+    threads[1] = edfcreate(1, prio, edfthread1, "B");
+    threads[2] = edfcreate(2, prio, edfthread1, "C");
+    admitted = chEDFEnterI(threads[0], &params[0]) &&
+               chEDFEnterI(threads[1], &params[1]) &&
+               chEDFEnterI(threads[2], &params[2]);
+    (void) chThdStartI(threads[0]);
+    (void) chThdStartI(threads[1]);
+    (void) chThdStartI(threads[2]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_assert(admitted, "not admitted");
+    test_assert_sequence("BCA", "invalid sequence");
+  }
+
+  /* [15.1.2] Waiting for the threads to terminate, the EDF load must be
+     released.*/
+  test_set_step(2);
+  {
+    test_wait_threads();
+    test_assert(chEDFGetLoadX() == (edf_load_t)0, "load not released");
+  }
+}
+
+static const testcase_t test_015_001 = {
+  "EDF ready list ordering",
+  NULL,
+  NULL,
+  test_015_001_execute
+};
+
+/**
+ * @page test_015_002 [15.2] EDF preemption
+ *
+ * <h2>Description</h2>
+ * The test thread enters the EDF class and starts two EDF threads, the
+ * thread with an earlier deadline must preempt the test thread while
+ * the thread with a later deadline must run after the test thread
+ * leaves the class.
+ *
+ * <h2>Test Steps</h2>
+ * - [15.2.1] Adding the test thread to the EDF class with a 50mS
+ *   deadline, the priority must be raised to the EDF level.
+ * - [15.2.2] Starting an EDF thread with a 10mS deadline, the thread
+ *   must preempt the test thread.
+ * - [15.2.3] Starting an EDF thread with a 100mS deadline, the thread
+ *   must not preempt the test thread.
+ * - [15.2.4] Removing the test thread from the EDF class, the priority
+ *   must be restored and the pending EDF thread must run.
+ * .
+ */
+
+static void test_015_002_teardown(void) {
+  if (chEDFIsThreadX(chThdGetSelfX())) {
+    chEDFLeave();
+  }
+}
+
+static void test_015_002_execute(void) {
+  tprio_t prio = chThdGetPriorityX();
+  static const edf_params_t params[3] = {
+    {MS2ST(100), MS2ST(50), MS2ST(1)},
+    {MS2ST(100), MS2ST(10), MS2ST(1)},
+    {MS2ST(200), MS2ST(100), MS2ST(1)}
+  };
+
+  /* [15.2.1] Adding the test thread to the EDF class with a 50mS
+     deadline, the priority must be raised to the EDF level.*/
+  test_set_step(1);
+  {
+    test_assert(chEDFEnter(&params[0]), "not admitted");
+    test_assert(chEDFIsThreadX(chThdGetSelfX()), "not in EDF class");
+    test_assert(chThdGetPriorityX() == CH_CFG_EDF_PRIO, "wrong priority");
+    test_emit_token('A');
+  }
+
+  /* [15.2.2] Starting an EDF thread with a 10mS deadline, the thread
+     must preempt the test thread.*/
+  test_set_step(2);
+  {
+    chSysLock();
+    threads[0] = edfcreate(0, prio - 1, edfthread1, "B");
+    (void) chEDFEnterI(threads[0], &params[1]);
+    (void) chThdStartI(threads[0]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_emit_token('C');
+  }
+
+  /* [15.2.3] Starting an EDF thread with a 100mS deadline, the thread
+     must not preempt the test thread.*/
+  test_set_step(3);
+  {
+    chSysLock();
+    threads[1] = edfcreate(1, prio - 1, edfthread1, "E");
+    (void) chEDFEnterI(threads[1], &params[2]);
+    (void) chThdStartI(threads[1]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_emit_token('D');
+  }
+
+  /* [15.2.4] Removing the test thread from the EDF class, the priority
+     must be restored and the pending EDF thread must run.*/
+  test_set_step(4);
+  {
+    chEDFLeave();
+    test_assert(!chEDFIsThreadX(chThdGetSelfX()), "still in EDF class");
+    test_assert(chThdGetPriorityX() == prio, "wrong priority");
+    test_wait_threads();
+    test_assert_sequence("ABCDE", "invalid sequence");
+    test_assert(chEDFGetLoadX() == (edf_load_t)0, "load not released");
+  }
+}
+
+static const testcase_t test_015_002 = {
+  "EDF preemption",
+  NULL,
+  test_015_002_teardown,
+  test_015_002_execute
+};
+
+/**
+ * @page test_015_003 [15.3] EDF periodic jobs and deadline misses
+ *
+ * <h2>Description</h2>
+ * The test thread enters the EDF class with a 20mS period and a 10mS
+ * deadline. Jobs completed within the deadline must be released
+ * periodically, jobs completed after the deadline must be counted as
+ * misses and overruns of the period must not skip activations.
+ *
+ * <h2>Test Steps</h2>
+ * - [15.3.1] Adding the test thread to the EDF class then completing
+ *   three jobs immediately, the next job must be released after three
+ *   periods.
+ * - [15.3.2] Executing past the deadline of the current job, the miss
+ *   must be detected and the next job must be released on time.
+ * - [15.3.3] Executing past the release time of the next job, the miss
+ *   must be detected and the next job must start immediately with its
+ *   own deadline.
+ * - [15.3.4] Removing the test thread from the EDF class, the load must
+ *   be released.
+ * .
+ */
+
+static void test_015_003_teardown(void) {
+  if (chEDFIsThreadX(chThdGetSelfX())) {
+    chEDFLeave();
+  }
+}
+
+static void test_015_003_execute(void) {
+  thread_t *tp = chThdGetSelfX();
+  ucnt_t misses = chEDFGetMissesX();
+  systime_t start, time;
+  static const edf_params_t params = {MS2ST(20), MS2ST(10), MS2ST(5)};
+  bool missed;
+
+  /* [15.3.1] Adding the test thread to the EDF class then completing
+     three jobs immediately, the next job must be released after three
+     periods.*/
+  test_set_step(1);
+  {
+    start = test_wait_tick();
+    test_assert(chEDFEnter(&params), "not admitted");
+    missed  = chEDFWaitNextPeriod();
+    missed |= chEDFWaitNextPeriod();
+    missed |= chEDFWaitNextPeriod();
+    test_assert(!missed, "unexpected miss");
+    test_assert_time_window(start + MS2ST(60), start + MS2ST(60) + 1,
+                            "out of time window");
+    test_assert(tp->edf.jobs == (ucnt_t)3, "wrong jobs counter");
+    test_assert(tp->edf.misses == (ucnt_t)0, "wrong misses counter");
+  }
+
+  /* [15.3.2] Executing past the deadline of the current job, the miss
+     must be detected and the next job must be released on time.*/
+  test_set_step(2);
+  {
+    start = tp->edf.release;
+    edfbusy(chEDFGetDeadlineX(tp) + 1);
+    test_assert(chEDFWaitNextPeriod(), "miss not detected");
+    test_assert_time_window(start + MS2ST(20), start + MS2ST(20) + 1,
+                            "out of time window");
+    test_assert(tp->edf.misses == (ucnt_t)1, "wrong misses counter");
+    test_assert(chEDFGetMissesX() == misses + (ucnt_t)1,
+                "wrong global misses counter");
+  }
+
+  /* [15.3.3] Executing past the release time of the next job, the miss
+     must be detected and the next job must start immediately with its
+     own deadline.*/
+  test_set_step(3);
+  {
+    start = tp->edf.release;
+    edfbusy(start + MS2ST(25));
+    time = chVTGetSystemTimeX();
+    test_assert(chEDFWaitNextPeriod(), "miss not detected");
+    test_assert_time_window(time, time + 1, "out of time window");
+    test_assert(chEDFGetDeadlineX(tp) == start + MS2ST(30), "wrong deadline");
+    test_assert(!chEDFWaitNextPeriod(), "unexpected miss");
+    test_assert_time_window(start + MS2ST(40), start + MS2ST(40) + 1,
+                            "out of time window");
+    test_assert(tp->edf.jobs == (ucnt_t)6, "wrong jobs counter");
+    test_assert(tp->edf.misses == (ucnt_t)2, "wrong misses counter");
+  }
+
+  /* [15.3.4] Removing the test thread from the EDF class, the load must
+     be released.*/
+  test_set_step(4);
+  {
+    chEDFLeave();
+    test_assert(chEDFGetLoadX() == (edf_load_t)0, "load not released");
+  }
+}
+
+static const testcase_t test_015_003 = {
+  "EDF periodic jobs and deadline misses",
+  NULL,
+  test_015_003_teardown,
+  test_015_003_execute
+};
+
+/**
+ * @page test_015_004 [15.4] EDF admission control
+ *
+ * <h2>Description</h2>
+ * The load of threads and the schedulability of thread sets are
+ * computed, then threads are added to the EDF class until the CPU
+ * capacity is exceeded, the thread exceeding the capacity must be
+ * rejected.
+ *
+ * <h2>Test Steps</h2>
+ * - [15.4.1] Computing the load of threads, the smaller between
+ *   deadline and period must be used.
+ * - [15.4.2] Verifying the schedulability of thread sets, the sets
+ *   within the CPU capacity must be schedulable.
+ * - [15.4.3] Creating two threads with loads of 50% and 60%, the second
+ *   thread must be rejected and must keep its priority.
+ * - [15.4.4] Waiting for the threads to terminate, the rejected thread
+ *   must have run at its own priority and the load must be released.
+ * .
+ */
+
+static void test_015_004_execute(void) {
+  tprio_t prio = chThdGetPriorityX() - 1;
+  static const edf_params_t params[4] = {
+    {MS2ST(40), MS2ST(40), MS2ST(20)},
+    {MS2ST(60), MS2ST(60), MS2ST(9)},
+    {MS2ST(60), MS2ST(30), MS2ST(9)},
+    {MS2ST(60), MS2ST(60), MS2ST(36)}
+  };
+  bool admitted1, admitted2;
+  edf_load_t load;
+
+  /* [15.4.1] Computing the load of threads, the smaller between
+     deadline and period must be used.*/
+  test_set_step(1);
+  {
+    test_assert(chEDFComputeLoadX(&params[0]) == EDF_FULL_LOAD / 2U,
+                "wrong load");
+    test_assert(chEDFComputeLoadX(&params[1]) ==
+                ((EDF_FULL_LOAD * 15U) + 99U) / 100U, "wrong load");
+    test_assert(chEDFComputeLoadX(&params[2]) ==
+                ((EDF_FULL_LOAD * 3U) + 9U) / 10U, "wrong load");
+  }
+
+  /* [15.4.2] Verifying the schedulability of thread sets, the sets
+     within the CPU capacity must be schedulable.*/
+  test_set_step(2);
+  {
+    test_assert(chEDFIsSchedulableX(&params[0], 0U), "not schedulable");
+    test_assert(chEDFIsSchedulableX(&params[0], 2U), "not schedulable");
+    test_assert(chEDFIsSchedulableX(&params[0], 3U), "not schedulable");
+    test_assert(!chEDFIsSchedulableX(&params[1], 3U), "schedulable");
+    test_assert(!chEDFIsSchedulableX(&params[0], 4U), "schedulable");
+  }
+
+  /* [15.4.3] Creating two threads with loads of 50% and 60%, the second
+     thread must be rejected and must keep its priority.*/
+  test_set_step(3);
+  {
+    chSysLock();
+    threads[0] = edfcreate(0, prio, edfthread1, "A");
+    threads[1] = edfcreate(1, prio, edfthread1, "B");
+    admitted1 = chEDFEnterI(threads[0], &params[0]);
+    admitted2 = chEDFEnterI(threads[1], &params[3]);
+    load = chEDFGetLoadX();
+    (void) chThdStartI(threads[0]);
+    (void) chThdStartI(threads[1]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_assert(admitted1, "not admitted");
+    test_assert(!admitted2, "admitted");
+    test_assert(load == EDF_FULL_LOAD / 2U, "wrong load");
+    test_assert_sequence("A", "invalid sequence");
+  }
+
+  /* [15.4.4] Waiting for the threads to terminate, the rejected thread
+     must have run at its own priority and the load must be released.*/
+  test_set_step(4);
+  {
+    test_wait_threads();
+    test_assert_sequence("B", "invalid sequence");
+    test_assert(chEDFGetLoadX() == (edf_load_t)0, "load not released");
+  }
+}
+
+static const testcase_t test_015_004 = {
+  "EDF admission control",
+  NULL,
+  NULL,
+  test_015_004_execute
+};
+
+/**
+ * @page test_015_005 [15.5] EDF schedulability
+ *
+ * <h2>Description</h2>
+ * Two periodic threads with periods of 40mS and 60mS and execution
+ * times of 20mS and 24mS are executed for 600mS, the total load is 90%.
+ * The set is not schedulable by fixed priorities because the response
+ * time of the second thread would be 64mS, no deadline must be missed
+ * under EDF.
+ *
+ * <h2>Test Steps</h2>
+ * - [15.5.1] Verifying the schedulability of the thread set.
+ * - [15.5.2] Creating the two threads and releasing their first job at
+ *   the same time.
+ * - [15.5.3] Waiting until just before the end of the tenth period of
+ *   the second thread, all the jobs released must be completed without
+ *   misses.
+ * - [15.5.4] Terminating the threads, the load must be released.
+ * .
+ */
+
+static void test_015_005_execute(void) {
+  tprio_t prio = chThdGetPriorityX() - 1;
+  ucnt_t misses = chEDFGetMissesX();
+  systime_t start;
+  static const edf_params_t params[2] = {
+    {MS2ST(40), MS2ST(40), MS2ST(20)},
+    {MS2ST(60), MS2ST(60), MS2ST(24)}
+  };
+  bool admitted;
+
+  /* [15.5.1] Verifying the schedulability of the thread set.*/
+  test_set_step(1);
+  {
+    test_assert(chEDFIsSchedulableX(params, 2U), "not schedulable");
+  }
+
+  /* [15.5.2] Creating the two threads and releasing their first job at
+     the same time.*/
+  test_set_step(2);
+  {
+    start = test_wait_tick();
+    chSysLock();
+    threads[0] = edfcreate(0, prio, edfthread2, NULL);
+    threads[1] = edfcreate(1, prio, edfthread2, NULL);
+    admitted = chEDFEnterI(threads[0], &params[0]) &&
+               chEDFEnterI(threads[1], &params[1]);
+    (void) chThdStartI(threads[0]);
+    (void) chThdStartI(threads[1]);
+    chSchRescheduleS();
+    chSysUnlock();
+    test_assert(admitted, "not admitted");
+  }
+
+  /* [15.5.3] Waiting until just before the end of the tenth period of
+     the second thread, all the jobs released must be completed without
+     misses.*/
+  test_set_step(3);
+  {
+    chThdSleepUntil(start + MS2ST(595));
+    test_assert(threads[0]->edf.jobs == (ucnt_t)15, "wrong jobs counter");
+    test_assert(threads[1]->edf.jobs == (ucnt_t)10, "wrong jobs counter");
+    test_assert(threads[0]->edf.misses == (ucnt_t)0, "deadline missed");
+    test_assert(threads[1]->edf.misses == (ucnt_t)0, "deadline missed");
+    test_assert(chEDFGetMissesX() == misses, "deadline missed");
+  }
+
+  /* [15.5.4] Terminating the threads, the load must be released.*/
+  test_set_step(4);
+  {
+    test_terminate_threads();
+    test_wait_threads();
+    test_assert(chEDFGetLoadX() == (edf_load_t)0, "load not released");
+  }
+}
+
+static const testcase_t test_015_005 = {
+  "EDF schedulability",
+  NULL,
+  NULL,
+  test_015_005_execute
+};
+
+/****************************************************************************
+ * Exported data.
+ ****************************************************************************/
+
+/**
+ * @brief   EDF Scheduling.
+ */
+const testcase_t * const test_sequence_015[] = {
+  &test_015_001,
+  &test_015_002,
+  &test_015_003,
+  &test_015_004,
+  &test_015_005,
+  NULL
+};
+
+#endif /* CH_CFG_USE_EDF */
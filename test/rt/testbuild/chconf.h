@@ -168,6 +168,20 @@
 #define CH_CFG_USE_REGISTRY                 TRUE
 #endif
 
+/**
+ * @brief   Threads registry names index size.
+ * @details If greater than zero then the registry also keeps the threads
+ *          in a hash table indexed by name and @p chRegFindThreadByName()
+ *          does not need to scan the whole registry. The value is the
+ *          number of hash buckets and must be a power of two.
+ *
+ * @note    The default is @p 0.
+ * @note    Requires @p CH_CFG_USE_REGISTRY.
+ */
+#if !defined(CH_CFG_REGISTRY_HASH_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_REGISTRY_HASH_SIZE           0
+#endif
+
 /**
  * @brief   Threads synchronization APIs.
  * @details If enabled then the @p chThdWait() function is included in
@@ -179,6 +193,30 @@
 #define CH_CFG_USE_WAITEXIT                 TRUE
 #endif
 
+/**
+ * @brief   EDF scheduling class.
+ * @details If enabled then the threads running at the priority level
+ *          @p CH_CFG_EDF_PRIO can be scheduled by earliest deadline.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_EDF) || defined(__DOXYGEN__)
+#define CH_CFG_USE_EDF                      FALSE
+#endif
+
+/**
+ * @brief   Priority level reserved to the EDF scheduling class.
+ * @details The EDF threads run at this priority level, threads with
+ *          higher priority preempt them and threads with lower priority
+ *          run in the remaining time.
+ *
+ * @note    The default is @p NORMALPRIO + 1.
+ * @note    Requires @p CH_CFG_USE_EDF.
+ */
+#if !defined(CH_CFG_EDF_PRIO) || defined(__DOXYGEN__)
+#define CH_CFG_EDF_PRIO                     (NORMALPRIO + 1)
+#endif
+
 /**
  * @brief   Semaphores APIs.
  * @details If enabled then the Semaphores APIs are included in the kernel.
@@ -248,6 +286,30 @@
 #define CH_CFG_USE_CONDVARS_TIMEOUT         TRUE
 #endif
 
+/**
+ * @brief   Reader-writer locks APIs.
+ * @details If enabled then the reader-writer locks APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_CFG_USE_MUTEXES.
+ */
+#if !defined(CH_CFG_USE_RWLOCKS) || defined(__DOXYGEN__)
+#define CH_CFG_USE_RWLOCKS                  TRUE
+#endif
+
+/**
+ * @brief   Reader-writer locks nesting.
+ * @details Maximum number of reader-writer locks that a thread can hold
+ *          at the same time.
+ *
+ * @note    The default is 2.
+ * @note    Requires @p CH_CFG_USE_RWLOCKS.
+ */
+#if !defined(CH_CFG_RWLOCKS_NESTING) || defined(__DOXYGEN__)
+#define CH_CFG_RWLOCKS_NESTING              2
+#endif
+
 /**
  * @brief   Events Flags APIs.
  * @details If enabled then the event flags APIs are included in the kernel.
@@ -306,6 +368,29 @@
 #define CH_CFG_USE_MAILBOXES                TRUE
 #endif
 
+/**
+ * @brief   Sequence locks APIs.
+ * @details If enabled then the sequence locks APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ */
+#if !defined(CH_CFG_USE_SEQLOCKS) || defined(__DOXYGEN__)
+#define CH_CFG_USE_SEQLOCKS                 TRUE
+#endif
+
+/**
+ * @brief   Sequence locks objects size limit.
+ * @details Maximum size in bytes of the objects copied under a sequence
+ *          lock by @p chSeqReadObjectX() and @p chSeqWriteObjectI().
+ *
+ * @note    The default is 32.
+ * @note    Requires @p CH_CFG_USE_SEQLOCKS.
+ */
+#if !defined(CH_CFG_SEQLOCKS_MAX_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_SEQLOCKS_MAX_SIZE            32
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -355,6 +440,62 @@
 #define CH_CFG_USE_DYNAMIC                  TRUE
 #endif
 
+/**
+ * @brief   Work queues APIs.
+ * @details If enabled then the work queues APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ */
+#if !defined(CH_CFG_USE_WORKQUEUES) || defined(__DOXYGEN__)
+#define CH_CFG_USE_WORKQUEUES               TRUE
+#endif
+
+/**
+ * @brief   Number of workers of the system work queue.
+ * @details The workers are started by @p chSysInit(), zero means that
+ *          there is no system work queue.
+ *
+ * @note    The default is @p 1.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#if !defined(CH_CFG_WORKQ_WORKERS) || defined(__DOXYGEN__)
+#define CH_CFG_WORKQ_WORKERS                1
+#endif
+
+/**
+ * @brief   Stack size of the system work queue workers.
+ *
+ * @note    The default is @p 256.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#if !defined(CH_CFG_WORKQ_WA_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_WORKQ_WA_SIZE                256
+#endif
+
+/**
+ * @brief   Priority of the system work queue workers.
+ *
+ * @note    The default is @p HIGHPRIO-1.
+ * @note    Requires @p CH_CFG_USE_WORKQUEUES.
+ */
+#if !defined(CH_CFG_WORKQ_PRIO) || defined(__DOXYGEN__)
+#define CH_CFG_WORKQ_PRIO                   (HIGHPRIO - 1)
+#endif
+
+/**
+ * @brief   Cooperative tasks APIs.
+ * @details If enabled then the stackless cooperative tasks APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_CFG_USE_EVENTS.
+ * @note    Requires @p CH_CFG_USE_EVENTS_TIMEOUT.
+ */
+#if !defined(CH_CFG_USE_CTASKS) || defined(__DOXYGEN__)
+#define CH_CFG_USE_CTASKS                   TRUE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -465,6 +606,19 @@
 #define CH_DBG_THREADS_PROFILING            TRUE
 #endif
 
+/**
+ * @brief   Debug option, incremental integrity checks.
+ * @details If enabled then the @p chSysIntegrityStep() function is included
+ *          in the kernel, the kernel data structures can be checked a few
+ *          nodes at time from the idle hook or from a low priority thread.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_REGISTRY.
+ */
+#if !defined(CH_DBG_ENABLE_INTEGRITY_STEPS) || defined(__DOXYGEN__)
+#define CH_DBG_ENABLE_INTEGRITY_STEPS       FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -94,12 +94,12 @@ test cfg4 "-DCH_CFG_USE_REGISTRY=FALSE -DCH_CFG_USE_DYNAMIC=FALSE"
 test cfg5 "-DCH_CFG_USE_TM=FALSE"
 test cfg6 "-DCH_CFG_USE_SEMAPHORES=FALSE -DCH_CFG_USE_MAILBOXES=FALSE"
 test cfg7 "-DCH_CFG_USE_SEMAPHORES_PRIORITY=TRUE"
-test cfg8 "-DCH_CFG_USE_MUTEXES=FALSE -DCH_CFG_USE_CONDVARS=FALSE"
+test cfg8 "-DCH_CFG_USE_MUTEXES=FALSE -DCH_CFG_USE_CONDVARS=FALSE -DCH_CFG_USE_RWLOCKS=FALSE"
 test cfg9 "-DCH_CFG_USE_MUTEXES_RECURSIVE=TRUE"
 test cfg10 "-DCH_CFG_USE_CONDVARS=FALSE"
 test cfg11 "-DCH_CFG_USE_CONDVARS_TIMEOUT=FALSE"
-test cfg12 "-DCH_CFG_USE_EVENTS=FALSE"
-test cfg13 "-DCH_CFG_USE_EVENTS_TIMEOUT=FALSE"
+test cfg12 "-DCH_CFG_USE_EVENTS=FALSE -DCH_CFG_USE_CTASKS=FALSE"
+test cfg13 "-DCH_CFG_USE_EVENTS_TIMEOUT=FALSE -DCH_CFG_USE_CTASKS=FALSE"
 test cfg14 "-DCH_CFG_USE_MESSAGES=FALSE"
 test cfg15 "-DCH_CFG_USE_MESSAGES_PRIORITY=TRUE"
 test cfg16 "-DCH_CFG_USE_MAILBOXES=FALSE"
@@ -117,6 +117,14 @@ test cfg26 "-DCH_DBG_TRACE_MASK=CH_DBG_TRACE_MASK_ALL"
 test cfg28 "-DCH_DBG_FILL_THREADS=TRUE"
 test cfg29 "-DCH_DBG_THREADS_PROFILING=FALSE"
 test cfg30 "-DCH_DBG_SYSTEM_STATE_CHECK=TRUE -DCH_DBG_ENABLE_CHECKS=TRUE -DCH_DBG_ENABLE_ASSERTS=TRUE -DCH_DBG_TRACE_MASK=CH_DBG_TRACE_MASK_ALL -DCH_DBG_FILL_THREADS=TRUE"
+test cfg31 "-DCH_CFG_USE_RWLOCKS=FALSE"
+test cfg32 "-DCH_CFG_USE_SEQLOCKS=FALSE"
+test cfg33 "-DCH_CFG_USE_WORKQUEUES=FALSE"
+test cfg34 "-DCH_CFG_WORKQ_WORKERS=0"
+test cfg35 "-DCH_CFG_USE_CTASKS=FALSE"
+test cfg36 "-DCH_CFG_USE_EDF=TRUE"
+test cfg37 "-DCH_CFG_REGISTRY_HASH_SIZE=16"
+test cfg38 "-DCH_DBG_ENABLE_INTEGRITY_STEPS=TRUE"
 
 rm *log.txt 2> /dev/null
 echo
@@ -0,0 +1,338 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "m25q.h"
+#include "m25q_sim.h"
+#include "hal_flash_cache.h"
+
+/*
+ * QSPI clock in MHz used for the bus time estimate, it can be overridden
+ * from the make command line using UDEFS.
+ */
+#if !defined(QSPI_CLOCK_MHZ)
+#define QSPI_CLOCK_MHZ              50U
+#endif
+
+/*
+ * Bus cycles of a quad fast read command excluding the data phase: command,
+ * address and dummy cycles.
+ */
+#define READ_OVERHEAD_CYCLES        (8U + 6U + M25Q_READ_DUMMY_CYCLES)
+
+/*
+ * Cache geometry, 16 lines of 256 bytes plus an 8 lines prefetch buffer.
+ */
+#define LINE_SIZE                   256U
+#define LINES_NUM                   16U
+#define PREFETCH_LINES              8U
+
+/*
+ * Benchmark sizes.
+ */
+#define DEVICE_SIZE                 (1U << 20)
+#define TABLE_OFFSET                (128U * 1024U)
+#define TABLE_SIZE                  (4U * 1024U)
+#define RECORD_SIZE                 16U
+#define RECORD_READS                2000U
+#define SCAN_OFFSET                 (256U * 1024U)
+#define SCAN_SIZE                   (64U * 1024U)
+#define SCAN_READ_SIZE              32U
+
+static uint8_t storage[DEVICE_SIZE];
+static uint8_t buffer[LINE_SIZE];
+static uint8_t reference[LINE_SIZE];
+
+static M25QSimDevice m25qsim;
+
+static const M25QSimConfig m25qsimcfg = {
+  storage,
+  DEVICE_SIZE,
+  M25QSIM_TIME_PAGE_PROGRAM,
+  M25QSIM_TIME_SUBSECTOR_ERASE,
+  M25QSIM_TIME_SECTOR_ERASE,
+  M25QSIM_TIME_BULK_ERASE,
+  M25QSIM_TIME_SUSPEND_LATENCY,
+  M25QSIM_TIME_RESUME_PENALTY
+};
+
+/*
+ * Read commands and read bytes transferred on the bus.
+ */
+static uint32_t read_cmds;
+static uint32_t read_bytes;
+
+static void exchange(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                     size_t n, const uint8_t *txbuf, uint8_t *rxbuf) {
+
+  (void)qspip;
+  if ((cmdp->cfg & QSPI_CFG_CMD_MASK) == M25Q_CMD_FAST_READ) {
+    read_cmds++;
+    read_bytes += (uint32_t)n;
+  }
+  m25qsimExchange(&m25qsim, cmdp, n, txbuf, rxbuf);
+}
+
+static const QSPIConfig qspicfg1 = {
+  NULL,
+  exchange
+};
+
+static M25QDriver m25q;
+
+static const M25QConfig m25qcfg1 = {
+  &QSPID1,
+  &qspicfg1
+};
+
+static FlashCache cache;
+static flashc_line_t lines[LINES_NUM];
+static uint8_t cache_buffer[FLASHC_BUFFER_SIZE(LINES_NUM, LINE_SIZE)];
+static uint8_t prefetch_buffer[FLASHC_BUFFER_SIZE(PREFETCH_LINES,
+                                                 LINE_SIZE)];
+
+static const FlashCacheConfig cachecfg = {
+  (BaseFlash *)&m25q,
+  LINE_SIZE,
+  LINES_NUM,
+  lines,
+  cache_buffer,
+  prefetch_buffer,
+  PREFETCH_LINES
+};
+
+/*
+ * Benchmark results of a reads sequence.
+ */
+typedef struct {
+  uint32_t                  cmds;
+  uint32_t                  bus_ns;
+  uint32_t                  host_ns;
+} bench_t;
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Pseudo-random generator, the same sequence for the direct and the
+ * cached runs.
+ */
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+
+  seed = (seed * 1103515245U) + 12345U;
+  return seed >> 16;
+}
+
+static uint64_t host_ns(void) {
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Reads the records in random order or the scan area sequentially through
+ * the specified flash, the data read is compared with the device content.
+ */
+static void run(BaseFlash *flashp, bool random, bench_t *bp) {
+  uint32_t cmds = read_cmds;
+  uint32_t bytes = read_bytes;
+  flash_offset_t offset;
+  uint64_t start, elapsed = 0U;
+  size_t size;
+  uint32_t i, n;
+  bool ok = true;
+
+  seed = 1U;
+  n    = random ? RECORD_READS : SCAN_SIZE / SCAN_READ_SIZE;
+  size = random ? RECORD_SIZE : SCAN_READ_SIZE;
+  for (i = 0U; i < n; i++) {
+    if (random) {
+      offset = TABLE_OFFSET +
+               ((rnd() % (TABLE_SIZE / RECORD_SIZE)) * RECORD_SIZE);
+    }
+    else {
+      offset = SCAN_OFFSET + (i * SCAN_READ_SIZE);
+    }
+    start = host_ns();
+    if (flashRead(flashp, offset, size, buffer) != FLASH_NO_ERROR) {
+      ok = false;
+    }
+    elapsed += host_ns() - start;
+    if (memcmp(buffer, &storage[offset], size) != 0) {
+      ok = false;
+    }
+  }
+  check(ok, "read error or wrong data");
+
+  cmds  = read_cmds - cmds;
+  bytes = read_bytes - bytes;
+  bp->cmds    = cmds;
+  bp->bus_ns  = (((cmds * READ_OVERHEAD_CYCLES) + (bytes * 2U)) * 1000U) /
+                QSPI_CLOCK_MHZ / n;
+  bp->host_ns = (uint32_t)(elapsed / n);
+}
+
+static void report(const char *name, const bench_t *direct,
+                   const bench_t *cached, uint32_t hits, uint32_t misses) {
+
+  printf("%s\n", name);
+  printf("  direct: %5u read commands, %4u ns bus, %4u ns host per read\n",
+         (unsigned)direct->cmds, (unsigned)direct->bus_ns,
+         (unsigned)direct->host_ns);
+  printf("  cached: %5u read commands, %4u ns bus, %4u ns host per read, "
+         "%.1f%% line hits\n",
+         (unsigned)cached->cmds, (unsigned)cached->bus_ns,
+         (unsigned)cached->host_ns,
+         (100.0 * (double)hits) / (double)(hits + misses));
+}
+
+/*
+ * Random records lookups in a table fitting the cache, after the first
+ * access to each line all the reads are served by the cache.
+ */
+static void test_records(void) {
+  bench_t direct, cached;
+
+  run((BaseFlash *)&m25q, true, &direct);
+  check(direct.cmds == RECORD_READS, "direct reads not one command each");
+
+  cache.hits   = 0U;
+  cache.misses = 0U;
+  run((BaseFlash *)&cache, true, &cached);
+  check(cached.cmds == TABLE_SIZE / LINE_SIZE, "table lines read again");
+  check(cache.misses == TABLE_SIZE / LINE_SIZE, "unexpected misses");
+
+  report("Random records:", &direct, &cached, cache.hits, cache.misses);
+}
+
+/*
+ * Sequential scan, the prefetch buffer is loaded with one command every
+ * PREFETCH_LINES lines.
+ */
+static void test_scan(void) {
+  bench_t direct, cached;
+
+  run((BaseFlash *)&m25q, false, &direct);
+  check(direct.cmds == SCAN_SIZE / SCAN_READ_SIZE,
+        "direct reads not one command each");
+
+  /* The first read is not known to be sequential, its line is cached
+     and the prefetch starts from the following one.*/
+  cache.hits   = 0U;
+  cache.misses = 0U;
+  run((BaseFlash *)&cache, false, &cached);
+  check(cached.cmds == (SCAN_SIZE / (LINE_SIZE * PREFETCH_LINES)) + 1U,
+        "prefetch not used");
+
+  report("Sequential scan:", &direct, &cached, cache.hits, cache.misses);
+}
+
+/*
+ * Programming through the cache invalidates the cached copies, changes
+ * made directly on the device require an explicit invalidation.
+ */
+static void test_coherency(void) {
+  flash_offset_t offset = TABLE_OFFSET + LINE_SIZE;
+  uint32_t i;
+
+  check(flashRead(&cache, offset, RECORD_SIZE, buffer) == FLASH_NO_ERROR,
+        "read error");
+
+  for (i = 0U; i < RECORD_SIZE; i++) {
+    reference[i] = buffer[i] & (uint8_t)0x5A;
+  }
+  check(flashProgram(&cache, offset, RECORD_SIZE, reference) ==
+        FLASH_NO_ERROR, "program error");
+  check((flashRead(&cache, offset, RECORD_SIZE, buffer) == FLASH_NO_ERROR) &&
+        (memcmp(buffer, reference, RECORD_SIZE) == 0),
+        "stale data after a program");
+
+  for (i = 0U; i < RECORD_SIZE; i++) {
+    reference[i] = buffer[i] & (uint8_t)0xA5;
+  }
+  check(flashProgram(&m25q, offset, RECORD_SIZE, reference) ==
+        FLASH_NO_ERROR, "program error");
+  flashcInvalidate(&cache, offset, RECORD_SIZE);
+  check((flashRead(&cache, offset, RECORD_SIZE, buffer) == FLASH_NO_ERROR) &&
+        (memcmp(buffer, reference, RECORD_SIZE) == 0),
+        "stale data after an invalidation");
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  uint32_t i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * Simulated device with a known pattern.
+   */
+  for (i = 0U; i < DEVICE_SIZE; i++) {
+    storage[i] = (uint8_t)((i * 7U) + (i >> 8));
+  }
+  m25qsimObjectInit(&m25qsim);
+  m25qsimStart(&m25qsim, &m25qsimcfg);
+
+  /*
+   * Initializing and starting M25Q driver and the cache over it.
+   */
+  m25qObjectInit(&m25q);
+  m25qStart(&m25q, &m25qcfg1);
+  flashcObjectInit(&cache);
+  flashcStart(&cache, &cachecfg);
+
+  printf("Cache %u lines of %u bytes, prefetch %u lines, QSPI %u MHz\n",
+         (unsigned)LINES_NUM, (unsigned)LINE_SIZE, (unsigned)PREFETCH_LINES,
+         (unsigned)QSPI_CLOCK_MHZ);
+
+  test_records();
+  test_scan();
+  test_coherency();
+
+  check(m25qsim.violations == 0U, "protocol violations");
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,606 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "hal_flash_ram.h"
+#include "mfs.h"
+
+/*
+ * Device geometry, two banks of half the sectors.
+ */
+#define SECTORS             8U
+#define SECTOR_SIZE         4096U
+#define PAGE_SIZE           8U
+
+/*
+ * Records geometry.
+ */
+#define RECORDS             MFS_CFG_MAX_RECORDS
+#define MAX_LEN             120U
+
+/*
+ * Free space starting the background compaction.
+ */
+#define GC_THRESHOLD        4096U
+
+/*
+ * Power losses injected in each test.
+ */
+#define ROUNDS              2000U
+
+/*
+ * Records written by each transaction.
+ */
+#define TX_RECORDS          10U
+#define TX_LEN              8U
+
+/*
+ * Power losses between the transaction records and the commit marker.
+ */
+#define CUTS                200U
+
+static uint8_t storage[SECTORS * SECTOR_SIZE];
+static uint32_t erase_counts[SECTORS];
+
+static RamFlash rf;
+
+static const RamFlashConfig rfcfg = {
+  storage,
+  PAGE_SIZE,
+  SECTORS,
+  SECTOR_SIZE,
+  erase_counts
+};
+
+static MFSDriver mfs;
+static MFSConfig mfscfg = {
+  (BaseFlash *)&rf,
+  0U,
+  SECTORS / 2U,
+  SECTORS / 2U,
+  SECTORS / 2U,
+  0U
+};
+
+/*
+ * Expected content, version and size of each record, zero size if the
+ * record does not exist.
+ */
+static uint32_t versions[RECORDS];
+static uint32_t sizes[RECORDS];
+
+/*
+ * Last client operation, its result is unknown after a power loss.
+ */
+static int op_id;
+static uint32_t op_version, op_size;
+
+/*
+ * Result of the last mount.
+ */
+static mfs_error_t mount_err;
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Repeatable pseudo-random sequence.
+ */
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+
+  seed = (seed * 1103515245U) + 12345U;
+  return seed >> 8;
+}
+
+static void fill(uint8_t *bp, uint32_t id, uint32_t version, uint32_t n) {
+  uint32_t i;
+
+  for (i = 0U; i < n; i++) {
+    bp[i] = (uint8_t)((id * 31U) + (version * 7U) + i);
+  }
+}
+
+static bool record_matches(uint32_t id, uint32_t version, uint32_t n) {
+  uint8_t buf[MAX_LEN], expected[MAX_LEN];
+  uint32_t size = sizeof buf;
+  mfs_error_t err;
+
+  err = mfsReadRecord(&mfs, id, &size, buf);
+  if (n == 0U) {
+    return err == MFS_ERR_NOT_FOUND;
+  }
+  if ((err != MFS_NO_ERROR) || (size != n)) {
+    return false;
+  }
+  fill(expected, id, version, n);
+  return memcmp(buf, expected, n) == 0;
+}
+
+/*
+ * Compares all records with the expected content, the record of the last
+ * operation can have either the old or the new content.
+ */
+static bool verify_all(void) {
+  uint32_t id;
+
+  for (id = 0U; id < RECORDS; id++) {
+    if (record_matches(id, versions[id], sizes[id])) {
+      continue;
+    }
+    if (((int)id != op_id) || !record_matches(id, op_version, op_size)) {
+      return false;
+    }
+    versions[id] = op_version;
+    sizes[id]    = op_size;
+  }
+  return true;
+}
+
+/*
+ * Restarts the flash device and mounts the storage again, the RAM state
+ * of the driver is lost as after a reset.
+ */
+static bool power_cycle(void) {
+
+  rflashStart(&rf, &rfcfg);
+  mfsObjectInit(&mfs);
+  mfsStart(&mfs, &mfscfg);
+  mount_err = mfsMount(&mfs);
+  return !MFS_IS_ERROR(mount_err);
+}
+
+static void format(uint32_t threshold) {
+
+  memset(storage, 0xFF, sizeof storage);
+  memset(versions, 0, sizeof versions);
+  memset(sizes, 0, sizeof sizes);
+  mfscfg.gc_threshold = threshold;
+  check(power_cycle(), "mount failed");
+}
+
+static bool gc_pending(void) {
+  mfs_gc_status_t gs;
+
+  mfsGetCompactionStatus(&mfs, &gs);
+  return (gs.state != MFS_GC_IDLE) ||
+         ((mfscfg.gc_threshold > 0U) && (gs.free < mfscfg.gc_threshold) &&
+          (gs.free + gs.reclaimable >= mfscfg.gc_threshold));
+}
+
+/*
+ * Writes or erases a random record, the expected content is updated only
+ * if the operation succeeds.
+ */
+static mfs_error_t client_op(void) {
+  uint8_t buf[MAX_LEN];
+  mfs_error_t err;
+
+  op_id = (int)(rnd() % RECORDS);
+  if ((sizes[op_id] != 0U) && ((rnd() % 8U) == 0U)) {
+    op_version = 0U;
+    op_size    = 0U;
+    err = mfsEraseRecord(&mfs, (uint32_t)op_id);
+  }
+  else {
+    op_version = versions[op_id] + 1U;
+    op_size    = 1U + (rnd() % MAX_LEN);
+    fill(buf, (uint32_t)op_id, op_version, op_size);
+    err = mfsWriteRecord(&mfs, (uint32_t)op_id, op_size, buf);
+  }
+  if (!MFS_IS_ERROR(err)) {
+    versions[op_id] = op_version;
+    sizes[op_id]    = op_size;
+  }
+  return err;
+}
+
+/*
+ * Power losses at random points of the write traffic, compactions are
+ * performed by the writes when the bank is full.
+ */
+static void test_foreground(void) {
+  unsigned hits[3] = {0U, 0U, 0U};
+  unsigned i;
+
+  printf("Power loss during writes, foreground compaction...\n");
+
+  format(0U);
+  seed = 11U;
+  for (i = 0U; i < ROUNDS; i++) {
+    mfs_error_t err;
+
+    rflashInjectFault(&rf, 1U + (rnd() % 400U));
+    do {
+      err = client_op();
+    } while (!MFS_IS_ERROR(err));
+    check(err == MFS_ERR_FLASH_FAILURE, "unexpected error");
+    hits[mfs.gc_state]++;
+
+    check(power_cycle(), "remount failed");
+    check(verify_all(), "content mismatch after remount");
+  }
+
+  printf("  %u during writes, %u while copying, %u while erasing\n",
+         hits[MFS_GC_IDLE], hits[MFS_GC_COPYING], hits[MFS_GC_ERASING]);
+  check(hits[MFS_GC_COPYING] > 0U, "no power loss while copying");
+  check(hits[MFS_GC_ERASING] > 0U, "no power loss while erasing");
+}
+
+/*
+ * Power losses during the background compaction steps, the records are
+ * rewritten between the steps so the copy has to catch up with them.
+ */
+static void test_background(void) {
+  unsigned hits[3] = {0U, 0U, 0U};
+  unsigned i;
+
+  printf("Power loss during background compaction steps...\n");
+
+  format(GC_THRESHOLD);
+  seed = 12U;
+  for (i = 0U; i < ROUNDS; i++) {
+    uint32_t steps;
+    mfs_error_t err;
+
+    while (!gc_pending()) {
+      check(!MFS_IS_ERROR(client_op()), "write failed");
+    }
+
+    for (steps = rnd() % 48U; (steps > 0U) && gc_pending(); steps--) {
+      check(mfsServeCompaction(&mfs) == MFS_NO_ERROR, "compaction failed");
+      if ((rnd() % 2U) == 0U) {
+        check(!MFS_IS_ERROR(client_op()), "write failed");
+      }
+    }
+
+    /* The next flash operation of the compaction is interrupted, steps
+       not touching the flash go through.*/
+    op_id = -1;
+    rflashInjectFault(&rf, 1U);
+    err = MFS_NO_ERROR;
+    while (!MFS_IS_ERROR(err) && gc_pending()) {
+      err = mfsServeCompaction(&mfs);
+    }
+    rflashInjectFault(&rf, 0U);
+    if (!MFS_IS_ERROR(err)) {
+      continue;
+    }
+    check(err == MFS_ERR_FLASH_FAILURE, "unexpected error");
+    hits[mfs.gc_state]++;
+
+    check(power_cycle(), "remount failed");
+    check(verify_all(), "content mismatch after remount");
+  }
+
+  printf("  %u while copying, %u while erasing\n",
+         hits[MFS_GC_COPYING], hits[MFS_GC_ERASING]);
+  check(hits[MFS_GC_COPYING] > 0U, "no power loss while copying");
+  check(hits[MFS_GC_ERASING] > 0U, "no power loss while erasing");
+}
+
+/*
+ * Staged records are visible only after the commit, a rollback leaves the
+ * storage untouched.
+ */
+static void test_transactions(void) {
+  uint8_t buf[TX_LEN];
+  uint32_t i, programs;
+  mfs_error_t err;
+
+  printf("Transaction commit and rollback...\n");
+
+  format(0U);
+  fill(buf, 1U, 1U, TX_LEN);
+  check(mfsWriteRecord(&mfs, 1U, TX_LEN, buf) == MFS_NO_ERROR,
+        "write failed");
+
+  /* Rollback.*/
+  programs = rf.programs;
+  mfsStartTransaction(&mfs);
+  fill(buf, 1U, 2U, TX_LEN);
+  check(mfsWriteRecord(&mfs, 1U, TX_LEN, buf) == MFS_NO_ERROR,
+        "staged write failed");
+  fill(buf, 2U, 2U, TX_LEN);
+  check(mfsWriteRecord(&mfs, 2U, TX_LEN, buf) == MFS_NO_ERROR,
+        "staged write failed");
+  check(mfsEraseRecord(&mfs, 3U) == MFS_ERR_NOT_FOUND,
+        "erased a missing record");
+  check(mfsEraseRecord(&mfs, 2U) == MFS_NO_ERROR, "staged erase failed");
+  check(mfsEraseRecord(&mfs, 2U) == MFS_ERR_NOT_FOUND,
+        "erased a staged erased record");
+  check(record_matches(1U, 1U, TX_LEN) && record_matches(2U, 0U, 0U),
+        "staged records visible");
+  mfsRollbackTransaction(&mfs);
+  check(rf.programs == programs, "rolled back records programmed");
+  check(record_matches(1U, 1U, TX_LEN) && record_matches(2U, 0U, 0U),
+        "rolled back records visible");
+  check(power_cycle(), "remount failed");
+  check(record_matches(1U, 1U, TX_LEN) && record_matches(2U, 0U, 0U),
+        "rolled back records visible after remount");
+
+  /* Commit.*/
+  mfsStartTransaction(&mfs);
+  fill(buf, 1U, 2U, TX_LEN);
+  check(mfsWriteRecord(&mfs, 1U, TX_LEN, buf) == MFS_NO_ERROR,
+        "staged write failed");
+  fill(buf, 2U, 2U, TX_LEN);
+  check(mfsWriteRecord(&mfs, 2U, TX_LEN, buf) == MFS_NO_ERROR,
+        "staged write failed");
+  check(mfsEraseRecord(&mfs, 1U) == MFS_NO_ERROR, "staged erase failed");
+  check(mfsCommitTransaction(&mfs) == MFS_NO_ERROR, "commit failed");
+  check(record_matches(1U, 0U, 0U) && record_matches(2U, 2U, TX_LEN),
+        "committed records not visible");
+  check(power_cycle(), "remount failed");
+  check(record_matches(1U, 0U, 0U) && record_matches(2U, 2U, TX_LEN),
+        "committed records not visible after remount");
+
+  /* The transaction buffer limits the staged records.*/
+  mfsStartTransaction(&mfs);
+  err = MFS_NO_ERROR;
+  for (i = 0U; (i < RECORDS) && (err == MFS_NO_ERROR); i++) {
+    fill(buf, i, 5U, TX_LEN);
+    err = mfsWriteRecord(&mfs, i, TX_LEN, buf);
+  }
+  check((err == MFS_ERR_OUT_OF_MEM) && (i > TX_RECORDS),
+        "transaction buffer size");
+  mfsRollbackTransaction(&mfs);
+  check(record_matches(0U, 0U, 0U) && record_matches(2U, 2U, TX_LEN),
+        "rolled back records visible");
+}
+
+/*
+ * Writes a transaction of @p TX_RECORDS records with a power loss after
+ * @p ops flash operations, after the remount either all the records or
+ * none of them must be found.
+ */
+static bool commit_power_loss(uint32_t ops, bool *newp) {
+  uint8_t buf[TX_LEN];
+  uint32_t version = versions[0] + 1U;
+  mfs_error_t err;
+  uint32_t id;
+  bool ok = true;
+
+  mfsStartTransaction(&mfs);
+  for (id = 0U; id < TX_RECORDS; id++) {
+    fill(buf, id, version, TX_LEN);
+    ok = ok && (mfsWriteRecord(&mfs, id, TX_LEN, buf) == MFS_NO_ERROR);
+  }
+  rflashInjectFault(&rf, ops);
+  err = mfsCommitTransaction(&mfs);
+  if (!MFS_IS_ERROR(err)) {
+    /* The commit succeeded, the power loss hits the next write.*/
+    err = mfsWriteRecord(&mfs, TX_RECORDS, TX_LEN, buf);
+    if (!MFS_IS_ERROR(err)) {
+      rflashInjectFault(&rf, 0U);
+      for (id = 0U; id < TX_RECORDS; id++) {
+        versions[id] = version;
+      }
+      *newp = true;
+      return ok;
+    }
+  }
+
+  ok = ok && power_cycle();
+  *newp = record_matches(0U, version, TX_LEN);
+  for (id = 0U; id < TX_RECORDS; id++) {
+    if (*newp) {
+      versions[id] = version;
+    }
+    ok = ok && record_matches(id, versions[id],
+                              versions[id] == 0U ? 0U : TX_LEN);
+  }
+  return ok;
+}
+
+/*
+ * Power losses during the commit, compactions performed by the commits
+ * included.
+ */
+static void test_commit_power_loss(void) {
+  unsigned all_old = 0U, all_new = 0U;
+  bool new_found;
+  unsigned i;
+
+  printf("Power loss during transaction commits...\n");
+
+  format(0U);
+
+  /* Batch partially written, then batch written without the marker, the
+     uncommitted batch is skipped by the bank scan.*/
+  check(commit_power_loss(1U, &new_found) && !new_found,
+        "partial batch found");
+  check(commit_power_loss(2U, &new_found) && !new_found,
+        "batch without commit marker found");
+  check(commit_power_loss(3U, &new_found) && new_found,
+        "committed batch not found");
+
+  /* Commits at random points in the bank.*/
+  seed = 5U;
+  for (i = 0U; i < ROUNDS; i++) {
+    check(commit_power_loss(1U + (rnd() % 4U), &new_found),
+          "transaction partially found");
+    if (new_found) {
+      all_new++;
+    }
+    else {
+      all_old++;
+    }
+  }
+  printf("  %u all old, %u all new, never mixed\n", all_old, all_new);
+  check((all_old > 0U) && (all_new > 0U), "outcomes not covered");
+}
+
+/*
+ * Looks for a byte sequence in the whole device.
+ */
+static bool storage_contains(const uint8_t *p, size_t n) {
+  size_t i;
+
+  for (i = 0U; i + n <= sizeof storage; i++) {
+    if (memcmp(&storage[i], p, n) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Stages a new version of the first @p TX_RECORDS records.
+ */
+static void stage_batch(void) {
+  uint8_t buf[TX_LEN];
+  uint32_t id;
+
+  mfsStartTransaction(&mfs);
+  for (id = 0U; id < TX_RECORDS; id++) {
+    fill(buf, id, versions[id] + 1U, TX_LEN);
+    check(mfsWriteRecord(&mfs, id, TX_LEN, buf) == MFS_NO_ERROR,
+          "staged write failed");
+  }
+}
+
+/*
+ * Power losses exactly between the program of the transaction records and
+ * the program of the commit marker, at random positions in the bank. The
+ * cut is alternately clean, the marker area still erased, or in the middle
+ * of the marker program. The whole batch must be in flash without being
+ * visible, the mount must repair the bank dropping the batch and the
+ * storage must stay usable.
+ */
+static void test_commit_cut(void) {
+  uint8_t batch[MFS_CFG_TRANSACTION_SIZE];
+  unsigned clean = 0U, torn = 0U;
+  flash_offset_t offset;
+  mfs_gc_status_t gs;
+  uint32_t size, id, n;
+  unsigned i;
+  bool erased;
+
+  printf("Power loss between transaction records and commit marker...\n");
+
+  format(0U);
+  seed = 9U;
+  op_id = -1;
+  for (i = 0U; i < CUTS; i++) {
+    /* Random traffic moving the batch in the bank, the commit must not
+       need a compaction so the marker is the second flash operation.*/
+    for (n = rnd() % 40U; n > 0U; n--) {
+      check(!MFS_IS_ERROR(client_op()), "write failed");
+    }
+    op_id = -1;
+    stage_batch();
+    mfsGetCompactionStatus(&mfs, &gs);
+    check(gs.free >= mfs.tx_size + sizeof (mfs_data_header_t),
+          "commit needs a compaction");
+
+    /* The records are programmed, the marker program is interrupted.*/
+    size   = mfs.tx_size;
+    offset = mfs.next_offset;
+    memcpy(batch, mfs.tx_buffer, size);
+    rflashInjectFault(&rf, 2U);
+    check(mfsCommitTransaction(&mfs) == MFS_ERR_FLASH_FAILURE,
+          "commit not interrupted");
+    erased = true;
+    for (n = 0U; n < sizeof (mfs_data_header_t); n++) {
+      erased = erased && (storage[offset + size + n] == 0xFFU);
+    }
+    check(!erased, "marker not torn");
+    if ((i % 2U) == 0U) {
+      /* Clean cut, the marker program did not change any bit.*/
+      memset(&storage[offset + size], 0xFF, sizeof (mfs_data_header_t));
+      clean++;
+    }
+    else {
+      torn++;
+    }
+    check(memcmp(&storage[offset], batch, size) == 0,
+          "batch not in flash");
+
+    /* After the remount none of the records is visible and the batch has
+       been dropped by the bank repair.*/
+    check(power_cycle(), "remount failed");
+    check(mount_err == MFS_WARN_REPAIR, "uncommitted batch not repaired");
+    check(verify_all(), "uncommitted records visible");
+    check(!storage_contains(batch, size), "uncommitted batch not dropped");
+
+    /* The same records written again are committed, later writes and
+       mounts are clean.*/
+    stage_batch();
+    check(mfsCommitTransaction(&mfs) == MFS_NO_ERROR, "commit failed");
+    for (id = 0U; id < TX_RECORDS; id++) {
+      versions[id]++;
+      sizes[id] = TX_LEN;
+    }
+    check(!MFS_IS_ERROR(client_op()), "write failed");
+    check(power_cycle(), "remount failed");
+    check(mount_err == MFS_NO_ERROR, "unexpected repair");
+    check(verify_all(), "content mismatch after remount");
+  }
+
+  printf("  %u clean cuts, %u torn markers, batches never visible\n",
+         clean, torn);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  uint32_t min, max, total;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * RAM flash device, the power losses are injected by the device.
+   */
+  rflashObjectInit(&rf);
+
+  test_foreground();
+  test_background();
+  test_transactions();
+  test_commit_power_loss();
+  test_commit_cut();
+
+  rflashGetEraseStats(&rf, &min, &max, &total);
+  printf("%u erases, erase counts min %u, max %u\n",
+         (unsigned)total, (unsigned)min, (unsigned)max);
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
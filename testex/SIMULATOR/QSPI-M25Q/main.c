@@ -0,0 +1,203 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "m25q.h"
+#include "m25q_sim.h"
+
+/*
+ * Simulated device timings in microseconds, they can be overridden from
+ * the make command line using UDEFS.
+ */
+#if !defined(PAGE_PROGRAM_TIME)
+#define PAGE_PROGRAM_TIME           M25QSIM_TIME_PAGE_PROGRAM
+#endif
+#if !defined(SUBSECTOR_ERASE_TIME)
+#define SUBSECTOR_ERASE_TIME        M25QSIM_TIME_SUBSECTOR_ERASE
+#endif
+#if !defined(SECTOR_ERASE_TIME)
+#define SECTOR_ERASE_TIME           M25QSIM_TIME_SECTOR_ERASE
+#endif
+#if !defined(BULK_ERASE_TIME)
+#define BULK_ERASE_TIME             M25QSIM_TIME_BULK_ERASE
+#endif
+
+/*
+ * Benchmark sizes.
+ */
+#define DEVICE_SIZE                 (1U << 20)
+#define PROGRAM_SIZE                (256U * 1024U)
+#define CHUNK_SIZE                  (64U * 1024U)
+#define ERASE_FIRST_SECTOR          8U
+#define ERASE_SECTORS               2U
+
+static uint8_t storage[DEVICE_SIZE];
+static uint8_t pattern[CHUNK_SIZE];
+static uint8_t buffer[CHUNK_SIZE];
+
+static M25QSimDevice m25qsim;
+
+static const M25QSimConfig m25qsimcfg = {
+  storage,
+  DEVICE_SIZE,
+  PAGE_PROGRAM_TIME,
+  SUBSECTOR_ERASE_TIME,
+  SECTOR_ERASE_TIME,
+  BULK_ERASE_TIME,
+  M25QSIM_TIME_SUSPEND_LATENCY,
+  M25QSIM_TIME_RESUME_PENALTY
+};
+
+/*
+ * Status polls performed by the driver.
+ */
+static uint32_t status_reads;
+
+static void exchange(QSPIDriver *qspip, const qspi_command_t *cmdp,
+                     size_t n, const uint8_t *txbuf, uint8_t *rxbuf) {
+  uint32_t cmd = cmdp->cfg & QSPI_CFG_CMD_MASK;
+
+  (void)qspip;
+  if ((cmd == M25Q_CMD_READ_STATUS_REGISTER) ||
+      (cmd == M25Q_CMD_READ_FLAG_STATUS_REGISTER)) {
+    status_reads++;
+  }
+  m25qsimExchange(&m25qsim, cmdp, n, txbuf, rxbuf);
+}
+
+static const QSPIConfig qspicfg1 = {
+  NULL,
+  exchange
+};
+
+static M25QDriver m25q;
+
+static const M25QConfig m25qcfg1 = {
+  &QSPID1,
+  &qspicfg1
+};
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  flash_error_t err;
+  systime_t start;
+  uint32_t ms, i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * Simulated device, blank at start.
+   */
+  memset(storage, 0xFF, sizeof storage);
+  m25qsimObjectInit(&m25qsim);
+  m25qsimStart(&m25qsim, &m25qsimcfg);
+
+  /*
+   * Initializing and starting M25Q driver.
+   */
+  m25qObjectInit(&m25q);
+  m25qStart(&m25q, &m25qcfg1);
+
+  printf("Page program %u us, sector erase %u us\n",
+         (unsigned)PAGE_PROGRAM_TIME, (unsigned)SECTOR_ERASE_TIME);
+
+  for (i = 0U; i < CHUNK_SIZE; i++) {
+    pattern[i] = (uint8_t)((i * 7U) + 3U);
+  }
+
+  /* Program throughput.*/
+  status_reads = 0U;
+  start = chVTGetSystemTimeX();
+  for (i = 0U; i < PROGRAM_SIZE; i += CHUNK_SIZE) {
+    err = flashProgram(&m25q, i, CHUNK_SIZE, pattern);
+    if (err != FLASH_NO_ERROR) {
+      chSysHalt("program error");
+    }
+  }
+  ms = ST2MS(chVTTimeElapsedSinceX(start));
+  if (ms == 0U) {
+    ms = 1U;
+  }
+  printf("Program %ukB: %u ms, %u kB/s, %u status reads\n",
+         (unsigned)(PROGRAM_SIZE / 1024U), (unsigned)ms,
+         (unsigned)((PROGRAM_SIZE / 1024U) * 1000U / ms),
+         (unsigned)status_reads);
+
+  /* Verifying the programmed data.*/
+  for (i = 0U; i < PROGRAM_SIZE; i += CHUNK_SIZE) {
+    err = flashRead(&m25q, i, CHUNK_SIZE, buffer);
+    if ((err != FLASH_NO_ERROR) || (memcmp(buffer, pattern, CHUNK_SIZE) != 0)) {
+      chSysHalt("verify error");
+    }
+  }
+
+  /* Sectors erase time.*/
+  status_reads = 0U;
+  start = chVTGetSystemTimeX();
+  for (i = 0U; i < ERASE_SECTORS; i++) {
+    (void) flashStartEraseSector(&m25q, ERASE_FIRST_SECTOR + i);
+    err = flashWaitErase((BaseFlash *)&m25q);
+    if (err != FLASH_NO_ERROR) {
+      chSysHalt("erase error");
+    }
+  }
+  ms = ST2MS(chVTTimeElapsedSinceX(start));
+  printf("Erase %u sectors: %u ms (device %u ms), %u status reads\n",
+         (unsigned)ERASE_SECTORS, (unsigned)ms,
+         (unsigned)(ERASE_SECTORS * (SECTOR_ERASE_TIME / 1000U)),
+         (unsigned)status_reads);
+
+  /* Read during an erase, the erase is suspended for the duration of the
+     read.*/
+  err = flashStartEraseSector(&m25q, ERASE_FIRST_SECTOR);
+  if (err != FLASH_NO_ERROR) {
+    chSysHalt("erase error");
+  }
+  err = flashRead(&m25q, 3U * CHUNK_SIZE, CHUNK_SIZE, buffer);
+  if ((err != FLASH_NO_ERROR) || (memcmp(buffer, pattern, CHUNK_SIZE) != 0)) {
+    chSysHalt("read during erase error");
+  }
+  err = flashWaitErase((BaseFlash *)&m25q);
+  if (err != FLASH_NO_ERROR) {
+    chSysHalt("erase error");
+  }
+  printf("Read during erase: %u suspends\n", (unsigned)m25q.suspends);
+
+  printf("Driver estimates: program %u us, erase %u us\n",
+         (unsigned)m25q.program_time, (unsigned)m25q.erase_time);
+
+  if (m25qsim.violations > 0U) {
+    printf("FAILED: %u protocol violations\n", (unsigned)m25qsim.violations);
+    return 1;
+  }
+  printf("Done\n");
+  return 0;
+}
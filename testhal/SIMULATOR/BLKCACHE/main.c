@@ -0,0 +1,253 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "ramdisk.h"
+#include "blkcache.h"
+
+/*
+ * Disk geometry.
+ */
+#define BLK_SIZE            64U
+#define BLK_NUM             256U
+
+/*
+ * Cache geometry, transfers larger than half the lines are written through.
+ */
+#define CACHE_LINES         16U
+#define CACHE_TBLOCKS       8U
+#define CACHE_THRESHOLD     (CACHE_LINES / 2U)
+
+static uint8_t disk_storage[BLK_NUM * BLK_SIZE];
+static uint8_t reference[BLK_NUM * BLK_SIZE];
+static uint8_t lines_buffer[BLKC_BUFFER_SIZE(CACHE_LINES, BLK_SIZE)];
+static uint8_t transfer_buffer[BLKC_BUFFER_SIZE(CACHE_TBLOCKS, BLK_SIZE)];
+static uint8_t buffer[BLKC_BUFFER_SIZE(32U, BLK_SIZE)];
+static blkc_line_t lines[CACHE_LINES];
+
+static RamDisk rd;
+static BlockCache bc;
+
+static const RamDiskConfig rdcfg = {
+  disk_storage,
+  BLK_SIZE,
+  BLK_NUM,
+  false
+};
+
+static const BlockCacheConfig bccfg = {
+  (BaseBlockDevice *)&rd,
+  BLK_SIZE,
+  CACHE_LINES,
+  lines,
+  lines_buffer,
+  transfer_buffer,
+  CACHE_TBLOCKS
+};
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Writes a pattern through the cache and records it in the reference image.
+ */
+static bool write_blocks(uint32_t startblk, uint32_t n, uint8_t seed) {
+  size_t i;
+
+  for (i = 0U; i < (size_t)n * BLK_SIZE; i++) {
+    buffer[i] = (uint8_t)(seed + i);
+  }
+  memcpy(reference + ((size_t)startblk * BLK_SIZE), buffer,
+         (size_t)n * BLK_SIZE);
+  return blkWrite(&bc, startblk, buffer, n);
+}
+
+/*
+ * Reads blocks through the cache and compares them with the reference image.
+ */
+static bool read_matches(uint32_t startblk, uint32_t n) {
+
+  if (blkRead(&bc, startblk, buffer, n) != HAL_SUCCESS) {
+    return false;
+  }
+  return memcmp(buffer, reference + ((size_t)startblk * BLK_SIZE),
+                (size_t)n * BLK_SIZE) == 0;
+}
+
+static bool disk_matches(void) {
+
+  return memcmp(disk_storage, reference, sizeof disk_storage) == 0;
+}
+
+/*
+ * Adjacent single block writes stay in the cache and are flushed as a
+ * single multi-block device write.
+ */
+static void test_coalescing(void) {
+  uint32_t i, writes;
+
+  printf("Write-back coalescing...\n");
+
+  writes = rd.writes;
+  for (i = 0U; i < CACHE_TBLOCKS; i++) {
+    check(write_blocks(16U + i, 1U, (uint8_t)i) == HAL_SUCCESS,
+          "cached write failed");
+  }
+  check(rd.writes == writes, "cached writes reached the device");
+  check(read_matches(16U, CACHE_TBLOCKS), "dirty lines read back");
+
+  check(blkSync(&bc) == HAL_SUCCESS, "sync failed");
+  printf("  %u single block writes, %u device writes\n",
+         (unsigned)CACHE_TBLOCKS, (unsigned)(rd.writes - writes));
+  check(rd.writes == writes + 1U, "dirty lines not coalesced");
+  check(disk_matches(), "disk content after sync");
+
+  /* Repeated writes to the same block are absorbed by the cache.*/
+  writes = rd.writes;
+  for (i = 0U; i < 100U; i++) {
+    check(write_blocks(5U, 1U, (uint8_t)i) == HAL_SUCCESS,
+          "cached write failed");
+  }
+  check(blkSync(&bc) == HAL_SUCCESS, "sync failed");
+  printf("  100 rewrites of a block, %u device writes\n",
+         (unsigned)(rd.writes - writes));
+  check(rd.writes == writes + 1U, "rewrites not absorbed");
+  check(disk_matches(), "disk content after sync");
+}
+
+/*
+ * Transfers up to the threshold are cached, larger transfers go straight
+ * to the device and leave the cached copies clean.
+ */
+static void test_write_through(void) {
+  uint32_t writes;
+
+  printf("Write-through threshold (%u blocks)...\n",
+         (unsigned)CACHE_THRESHOLD);
+
+  writes = rd.writes;
+  check(write_blocks(64U, CACHE_THRESHOLD, 0x10U) == HAL_SUCCESS,
+        "write at the threshold failed");
+  check(rd.writes == writes, "transfer at the threshold written through");
+  check(blkSync(&bc) == HAL_SUCCESS, "sync failed");
+  check(rd.writes == writes + 1U, "transfer at the threshold not flushed");
+
+  /* Dirtying a line then overwriting it with a large transfer.*/
+  check(write_blocks(130U, 1U, 0x20U) == HAL_SUCCESS, "cached write failed");
+  writes = rd.writes;
+  check(write_blocks(128U, CACHE_THRESHOLD + 1U, 0x30U) == HAL_SUCCESS,
+        "write above the threshold failed");
+  printf("  %u blocks transfer, %u device writes\n",
+         (unsigned)(CACHE_THRESHOLD + 1U), (unsigned)(rd.writes - writes));
+  check(rd.writes == writes + 1U, "large transfer not written through");
+  check(disk_matches(), "disk content after write-through");
+  check(read_matches(128U, CACHE_THRESHOLD + 1U), "large transfer read back");
+
+  /* The overwritten line is clean, nothing left to flush.*/
+  writes = rd.writes;
+  check(blkSync(&bc) == HAL_SUCCESS, "sync failed");
+  check(rd.writes == writes, "stale dirty line flushed");
+  check(disk_matches(), "disk content after sync");
+}
+
+/*
+ * Random mixed traffic compared against a reference image.
+ */
+static void test_random(void) {
+  unsigned i;
+
+  printf("Random traffic...\n");
+
+  srand(1);
+  for (i = 0U; i < 100000U; i++) {
+    uint32_t startblk = (uint32_t)rand() % BLK_NUM;
+    uint32_t n = 1U + ((uint32_t)rand() % ((rand() % 4) == 0 ? 32U : 3U));
+
+    if (startblk + n > BLK_NUM) {
+      n = BLK_NUM - startblk;
+    }
+    if ((rand() % 2) != 0) {
+      check(write_blocks(startblk, n, (uint8_t)rand()) == HAL_SUCCESS,
+            "write failed");
+    }
+    else {
+      check(read_matches(startblk, n), "read mismatch");
+    }
+    if ((rand() % 1000) == 0) {
+      check(blkSync(&bc) == HAL_SUCCESS, "sync failed");
+      check(disk_matches(), "disk content after sync");
+    }
+  }
+
+  check(blkDisconnect(&bc) == HAL_SUCCESS, "disconnect failed");
+  check(disk_matches(), "disk content after disconnect");
+  printf("  hits %u, misses %u, device reads %u, device writes %u\n",
+         (unsigned)bc.hits, (unsigned)bc.misses,
+         (unsigned)rd.reads, (unsigned)rd.writes);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * Block cache over a RAM disk.
+   */
+  rdObjectInit(&rd);
+  rdStart(&rd, &rdcfg);
+  bcObjectInit(&bc);
+  bcStart(&bc, &bccfg);
+  if (blkConnect(&bc) != HAL_SUCCESS) {
+    printf("FAILED: connect\n");
+    return 1;
+  }
+
+  test_coalescing();
+  test_write_through();
+  test_random();
+
+  bcStop(&bc);
+  rdStop(&rd);
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,412 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "hal_flash_ram.h"
+#include "hal_flash_ftl.h"
+
+/*
+ * Device and blocks geometry.
+ */
+#define SECTORS             32U
+#define SECTOR_SIZE         65536U
+#define BLK_SIZE            512U
+#define PAGES               FTL_SECTOR_PAGES(SECTOR_SIZE, BLK_SIZE)
+#define MAX_BLOCKS          ((SECTORS - FTL_MIN_SPARE_SECTORS) * PAGES)
+
+/*
+ * Overwrites of the whole logical space in each scenario.
+ */
+#define OVERWRITES          20U
+
+/*
+ * Power losses in the power loss scenario.
+ */
+#define POWER_LOSSES        300U
+
+static uint8_t storage[SECTORS * SECTOR_SIZE];
+static uint32_t erase_counts[SECTORS];
+
+static RamFlash rflash;
+
+static const RamFlashConfig rflashcfg = {
+  storage,
+  256U,
+  SECTORS,
+  SECTOR_SIZE,
+  erase_counts
+};
+
+static uint32_t map[MAX_BLOCKS];
+static ftl_sector_t sectors[SECTORS];
+static uint8_t copy_buffer[BLK_SIZE];
+
+static FlashFTL ftl;
+static FlashFTLConfig ftlcfg = {
+  (BaseFlash *)&rflash,
+  BLK_SIZE,
+  MAX_BLOCKS,
+  0U,
+  map,
+  sectors,
+  copy_buffer
+};
+
+/*
+ * Version last written in each block, zero if never written.
+ */
+static uint32_t versions[MAX_BLOCKS];
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Repeatable pseudo-random sequence.
+ */
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+
+  seed = (seed * 1103515245U) + 12345U;
+  return seed >> 8;
+}
+
+static void fill(uint8_t *bp, uint32_t blk, uint32_t version) {
+  uint32_t i;
+
+  for (i = 0U; i < BLK_SIZE; i++) {
+    bp[i] = (uint8_t)((blk * 31U) ^ version ^ i);
+  }
+}
+
+static bool verify_all(void) {
+  uint8_t buf[BLK_SIZE], expected[BLK_SIZE];
+  uint32_t blk;
+
+  for (blk = 0U; blk < ftlcfg.blk_num; blk++) {
+    if (ftlRead(&ftl, blk, buf, 1U) != HAL_SUCCESS) {
+      return false;
+    }
+    fill(expected, blk, versions[blk]);
+    if (memcmp(buf, expected, BLK_SIZE) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Background garbage collection thread, lower priority than the writer.
+ */
+static uint32_t gc_calls, gc_failures;
+static THD_WORKING_AREA(waGC, 1024);
+static THD_FUNCTION(gc_thread, arg) {
+
+  (void)arg;
+  chRegSetThreadName("ftl gc");
+  while (true) {
+    if (ftlServeGarbageCollection(&ftl) != FLASH_NO_ERROR) {
+      gc_failures++;
+    }
+    gc_calls++;
+  }
+}
+
+/*
+ * Writes the whole logical space once then overwrites it @p OVERWRITES
+ * times, with background collection the writer goes idle for a tick when
+ * a collection is pending, as a real application waiting for data would.
+ */
+static void scenario(const char *name, uint32_t blk_num, uint32_t threshold,
+                     bool hot, bool background) {
+  uint32_t host0, pages0, copies0, erases0, min, max, total, worst, i;
+  uint32_t version = 0U;
+  double host, pages;
+  uint8_t buf[BLK_SIZE];
+
+  /* Blank device, the erase counters start from zero.*/
+  memset(storage, 0xFF, sizeof storage);
+  memset(erase_counts, 0, sizeof erase_counts);
+  memset(versions, 0, sizeof versions);
+
+  ftlcfg.blk_num      = blk_num;
+  ftlcfg.gc_threshold = threshold;
+  ftlStart(&ftl, &ftlcfg);
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "connect failed");
+
+  /* Initial fill.*/
+  for (i = 0U; i < blk_num; i++) {
+    versions[i] = ++version;
+    fill(buf, i, version);
+    check(ftlWrite(&ftl, i, buf, 1U) == HAL_SUCCESS, "write failed");
+  }
+
+  host0   = ftl.host_writes;
+  pages0  = ftl.page_writes;
+  copies0 = ftl.gc_copies;
+  erases0 = ftl.erases;
+  worst   = 0U;
+  seed    = 1U;
+  for (i = 0U; i < OVERWRITES * blk_num; i++) {
+    uint32_t blk, ops;
+
+    /* Hot/cold pattern, 80% of the writes go to 20% of the blocks.*/
+    if (hot && ((rnd() % 10U) < 8U)) {
+      blk = rnd() % (blk_num / 5U);
+    }
+    else {
+      blk = rnd() % blk_num;
+    }
+
+    ops = ftl.gc_copies + ftl.erases;
+    versions[blk] = ++version;
+    fill(buf, blk, version);
+    check(ftlWrite(&ftl, blk, buf, 1U) == HAL_SUCCESS, "write failed");
+    ops = (ftl.gc_copies + ftl.erases) - ops;
+    if (ops > worst) {
+      worst = ops;
+    }
+
+    if (background &&
+        (ftl.gc_request || (ftl.gc_victim != FTL_NO_SECTOR))) {
+      chThdSleep(1);
+    }
+  }
+
+  check(verify_all(), "content mismatch");
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "reconnect failed");
+  check(verify_all(), "content mismatch after remount");
+
+  rflashGetEraseStats(&rflash, &min, &max, &total);
+  host  = (double)(ftl.host_writes - host0);
+  pages = (double)(ftl.page_writes - pages0);
+  printf("%s\n", name);
+  printf("  write amplification %.2f, gc_copies/page_writes %.3f\n",
+         pages / host, (double)(ftl.gc_copies - copies0) / pages);
+  printf("  %u erases, %.1f host writes/erase, worst write %u GC operations\n",
+         (unsigned)(ftl.erases - erases0),
+         host / (double)(ftl.erases - erases0), (unsigned)worst);
+  printf("  erase counts min %u, max %u, spread %u, total %u\n",
+         (unsigned)min, (unsigned)max, (unsigned)(max - min), (unsigned)total);
+
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+}
+
+/*
+ * Random writes interrupted by power losses at random points, the torn
+ * program and erase operations affect pseudo-random parts of their area.
+ * After each power loss the background collection must be stopped, the
+ * interrupted write must be fully present or fully absent after the
+ * remount and the other blocks must be unchanged.
+ */
+static void powerloss(void) {
+  uint32_t blk_num = (SECTORS * PAGES * 8U) / 10U;
+  uint32_t version = 0U, mount_erases = 0U, cycle, i;
+  uint8_t buf[BLK_SIZE], expected[BLK_SIZE];
+
+  memset(storage, 0xFF, sizeof storage);
+  memset(erase_counts, 0, sizeof erase_counts);
+  memset(versions, 0, sizeof versions);
+
+  ftlcfg.blk_num      = blk_num;
+  ftlcfg.gc_threshold = 3U;
+  ftlStart(&ftl, &ftlcfg);
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "connect failed");
+  for (i = 0U; i < blk_num; i++) {
+    versions[i] = ++version;
+    fill(buf, i, version);
+    check(ftlWrite(&ftl, i, buf, 1U) == HAL_SUCCESS, "write failed");
+  }
+
+  seed = 7U;
+  for (cycle = 0U; cycle < POWER_LOSSES; cycle++) {
+    uint32_t blk = 0U, calls, erases;
+
+    rflashSetTearSeed(&rflash, cycle + 1U);
+    rflashInjectFault(&rflash, 1U + (rnd() % 400U));
+    while (true) {
+      blk = rnd() % blk_num;
+      fill(buf, blk, version + 1U);
+      if (ftlWrite(&ftl, blk, buf, 1U) != HAL_SUCCESS) {
+        break;
+      }
+      versions[blk] = ++version;
+      if (ftl.gc_request || (ftl.gc_victim != FTL_NO_SECTOR)) {
+        chThdSleep(1);
+      }
+    }
+
+    /* The collection must not retry on the failed device.*/
+    chThdSleep(2);
+    calls = gc_calls;
+    chThdSleep(10);
+    check(gc_calls == calls, "collection retrying on a failed device");
+
+    /* Power cycle.*/
+    check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+    rflashStart(&rflash, &rflashcfg);
+    erases = ftl.erases;
+    check(ftlConnect(&ftl) == HAL_SUCCESS, "connect failed");
+    mount_erases += ftl.erases - erases;
+
+    /* The interrupted write is either complete or not visible.*/
+    check(ftlRead(&ftl, blk, buf, 1U) == HAL_SUCCESS, "read failed");
+    fill(expected, blk, version + 1U);
+    if (memcmp(buf, expected, BLK_SIZE) == 0) {
+      versions[blk] = ++version;
+    }
+    check(verify_all(), "content mismatch after power loss");
+  }
+
+  /* The device must still be fully usable.*/
+  for (i = 0U; i < 2U * blk_num; i++) {
+    uint32_t blk = rnd() % blk_num;
+
+    versions[blk] = ++version;
+    fill(buf, blk, version);
+    check(ftlWrite(&ftl, blk, buf, 1U) == HAL_SUCCESS, "write failed");
+  }
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "reconnect failed");
+  check(verify_all(), "content mismatch after remount");
+
+  printf("Power losses, 80%% full, background GC\n");
+  printf("  %u power losses, %u stopped collections, %u sectors erased at "
+         "mount\n",
+         (unsigned)POWER_LOSSES, (unsigned)gc_failures,
+         (unsigned)mount_erases);
+
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+}
+
+/*
+ * A free sector left not fully erased by an interrupted erase, its header
+ * and first tag are erased but its last page is not, the mount must erase
+ * it again before it is written.
+ */
+static void torn_erase(void) {
+  uint32_t blk_num = (SECTORS * PAGES * 8U) / 10U;
+  uint32_t version = 0U, erases, i;
+  flash_sector_t sector;
+  uint8_t buf[BLK_SIZE];
+
+  memset(storage, 0xFF, sizeof storage);
+  memset(erase_counts, 0, sizeof erase_counts);
+  memset(versions, 0, sizeof versions);
+
+  ftlcfg.blk_num      = blk_num;
+  ftlcfg.gc_threshold = 0U;
+  ftlStart(&ftl, &ftlcfg);
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "connect failed");
+  for (i = 0U; i < blk_num; i++) {
+    versions[i] = ++version;
+    fill(buf, i, version);
+    check(ftlWrite(&ftl, i, buf, 1U) == HAL_SUCCESS, "write failed");
+  }
+  for (sector = 0U; sector < SECTORS; sector++) {
+    if (sectors[sector].state == FTL_SECTOR_FREE) {
+      break;
+    }
+  }
+  check(sector < SECTORS, "no free sector");
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+
+  memset(storage + (sector * SECTOR_SIZE) + ftl.data_offset +
+         ((PAGES - 1U) * BLK_SIZE), 0, BLK_SIZE);
+  erases = ftl.erases;
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "connect failed");
+  check(ftl.erases == erases + 1U, "free sector not erased at mount");
+
+  /* Overwriting enough to use all the sectors.*/
+  seed = 3U;
+  for (i = 0U; i < 2U * blk_num; i++) {
+    uint32_t blk = rnd() % blk_num;
+
+    versions[blk] = ++version;
+    fill(buf, blk, version);
+    check(ftlWrite(&ftl, blk, buf, 1U) == HAL_SUCCESS, "write failed");
+  }
+  check(verify_all(), "content mismatch");
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+  check(ftlConnect(&ftl) == HAL_SUCCESS, "reconnect failed");
+  check(verify_all(), "content mismatch after remount");
+
+  printf("Torn erase of a free sector\n");
+  printf("  sector %u erased again at mount, erase count %u\n",
+         (unsigned)sector, (unsigned)sectors[sector].erase_count);
+
+  check(ftlDisconnect(&ftl) == HAL_SUCCESS, "disconnect failed");
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * RAM flash device and translation layer, the garbage collection thread
+   * serves all the scenarios.
+   */
+  rflashObjectInit(&rflash);
+  rflashStart(&rflash, &rflashcfg);
+  ftlObjectInit(&ftl);
+  chThdCreateStatic(waGC, sizeof(waGC), NORMALPRIO - 1, gc_thread, NULL);
+
+  printf("%u sectors x %u kB, %u bytes blocks, %u pages per sector\n",
+         (unsigned)SECTORS, (unsigned)(SECTOR_SIZE / 1024U),
+         (unsigned)BLK_SIZE, (unsigned)PAGES);
+  printf("In place update: write amplification %u, one erase per write\n\n",
+         (unsigned)(SECTOR_SIZE / BLK_SIZE));
+
+  scenario("Uniform, 93% full, foreground GC",
+           MAX_BLOCKS, 0U, false, false);
+  scenario("Uniform, 80% full, foreground GC",
+           (SECTORS * PAGES * 8U) / 10U, 0U, false, false);
+  scenario("Uniform, 80% full, background GC",
+           (SECTORS * PAGES * 8U) / 10U, 3U, false, true);
+  scenario("Hot/cold 80/20, 80% full, background GC",
+           (SECTORS * PAGES * 8U) / 10U, 3U, true, true);
+  powerloss();
+  torn_erase();
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
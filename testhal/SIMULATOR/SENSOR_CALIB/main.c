@@ -0,0 +1,317 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "hal_sensor_calib.h"
+
+/*
+ * Number of 3-axis samples in the test arrays.
+ */
+#define SAMPLES             4096U
+
+/*
+ * Benchmark repetitions over the whole array.
+ */
+#define BENCH_REPEAT        20000U
+
+/*
+ * Fractional bits of the fixed point output.
+ */
+#define FRAC_BITS           4U
+
+static int32_t raw[SAMPLES * 3U];
+static int32_t fixed[SAMPLES * 3U];
+static float cooked[SAMPLES * 3U];
+
+/*
+ * Per-axis calibration, typical accelerometer sensitivities.
+ */
+static const float sensitivity[3] = {0.061f, 0.122f, 0.244f};
+static const float bias[3] = {1.5f, -2.0f, 0.25f};
+
+/*
+ * Full matrix with small cross-axis terms.
+ */
+static const float matrix[9] = {
+  0.061f,   0.001f,  -0.002f,
+  0.0005f,  0.122f,   0.003f,
+  -0.001f,  0.002f,   0.244f
+};
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Largest difference between the float output and a double reference.
+ */
+static double max_error_float(const float m[], size_t axes, size_t n) {
+  double maxerr = 0.0;
+  size_t i, r, k;
+
+  for (i = 0U; i < n; i++) {
+    for (r = 0U; r < axes; r++) {
+      double e = -(double)bias[r];
+
+      for (k = 0U; k < axes; k++) {
+        e += (double)m[(r * axes) + k] * (double)raw[(i * axes) + k];
+      }
+      e = fabs((double)cooked[(i * axes) + r] - e);
+      if (e > maxerr) {
+        maxerr = e;
+      }
+    }
+  }
+  return maxerr;
+}
+
+/*
+ * Largest difference between the fixed point and the float outputs.
+ */
+static double max_error_fixed(size_t n) {
+  double maxerr = 0.0;
+  size_t i;
+
+  for (i = 0U; i < n; i++) {
+    double e = fabs(((double)fixed[i] / (double)(1U << FRAC_BITS)) -
+                    (double)cooked[i]);
+    if (e > maxerr) {
+      maxerr = e;
+    }
+  }
+  return maxerr;
+}
+
+/*
+ * Array conversion, per-axis and generic axes count.
+ */
+static void test_diagonal(void) {
+  sensor_calib_t sc;
+  float s1 = 2.0f, b1 = 1.0f;
+  float diag[9] = {0.0f};
+  double err;
+  size_t i;
+
+  printf("Per-axis float conversion...\n");
+
+  sensorCalibInit(&sc, 3U, sensitivity, bias);
+  check(sc.diagonal, "per-axis calibration not diagonal");
+  sensorCalibCook(&sc, raw, cooked, SAMPLES);
+  for (i = 0U; i < 3U; i++) {
+    diag[(i * 3U) + i] = sensitivity[i];
+  }
+  err = max_error_float(diag, 3U, SAMPLES);
+  printf("  max error %.6f\n", err);
+  check(err < 1e-3, "per-axis float error");
+
+  /* Single axis, generic path.*/
+  sensorCalibInit(&sc, 1U, &s1, &b1);
+  sensorCalibCook(&sc, raw, cooked, 5U);
+  for (i = 0U; i < 5U; i++) {
+    check(cooked[i] == ((float)raw[i] * 2.0f) - 1.0f, "single axis value");
+  }
+
+  /* A diagonal matrix is detected.*/
+  sensorCalibSetMatrix(&sc, diag, bias);
+  check(sc.diagonal, "diagonal matrix not detected");
+}
+
+/*
+ * Array conversion with a full 3x3 matrix.
+ */
+static void test_matrix(void) {
+  sensor_calib_t sc;
+  double err;
+
+  printf("3x3 matrix float conversion...\n");
+
+  sensorCalibInit(&sc, 3U, sensitivity, bias);
+  sensorCalibSetMatrix(&sc, matrix, bias);
+  check(!sc.diagonal, "full matrix detected as diagonal");
+  sensorCalibCook(&sc, raw, cooked, SAMPLES);
+  err = max_error_float(matrix, 3U, SAMPLES);
+  printf("  max error %.6f\n", err);
+  check(err < 1e-2, "matrix float error");
+}
+
+/*
+ * Fixed point output, per-axis and full matrix, in place conversion.
+ */
+static void test_fixed(void) {
+  /* Coefficients quantization, half LSB on three terms over the full raw
+     range, plus the output rounding.*/
+  const double bound = (1.5 * 32768.0 /
+                        (double)(1UL << SENSOR_CALIB_COEFF_BITS)) +
+                       (1.0 / (double)(1U << FRAC_BITS));
+  sensor_calib_t sc;
+  sensor_calib_fixed_t sf;
+  double err;
+  size_t i;
+
+  printf("Fixed point conversion, Q%u output...\n", (unsigned)FRAC_BITS);
+
+  sensorCalibInit(&sc, 3U, sensitivity, bias);
+  sensorCalibCook(&sc, raw, cooked, SAMPLES);
+  sensorCalibToFixed(&sc, &sf, FRAC_BITS);
+  check(sf.diagonal, "fixed calibration not diagonal");
+  sensorCalibCookFixed(&sf, raw, fixed, SAMPLES);
+  err = max_error_fixed(SAMPLES * 3U);
+  printf("  per-axis max error %.4f (bound %.4f)\n", err, bound);
+  check(err < bound, "per-axis fixed error");
+
+  sensorCalibSetMatrix(&sc, matrix, bias);
+  sensorCalibCook(&sc, raw, cooked, SAMPLES);
+  sensorCalibToFixed(&sc, &sf, FRAC_BITS);
+  check(!sf.diagonal, "fixed calibration diagonal");
+  for (i = 0U; i < SAMPLES * 3U; i++) {
+    fixed[i] = raw[i];
+  }
+  sensorCalibCookFixed(&sf, fixed, fixed, SAMPLES);
+  err = max_error_fixed(SAMPLES * 3U);
+  printf("  3x3 in place max error %.4f (bound %.4f)\n", err, bound);
+  check(err < bound, "matrix fixed error");
+}
+
+/*
+ * Per-sample conversion as done by the drivers read_cooked() functions.
+ */
+static void cook_sample(const float s[], const float b[],
+                        const int32_t r[], float axes[]) {
+  unsigned i;
+
+  for (i = 0U; i < 3U; i++) {
+    axes[i] = (float)r[i] * s[i];
+    axes[i] -= b[i];
+  }
+}
+
+static volatile float float_sink;
+static volatile int32_t fixed_sink;
+
+/*
+ * The benchmark uses the host CPU time, the simulated system time does not
+ * advance while a thread runs without yielding.
+ */
+static void bench_report(const char *name, clock_t start) {
+  double ms = ((double)(clock() - start) * 1000.0) / (double)CLOCKS_PER_SEC;
+
+  printf("  %-26s %.0f ms, %.2f ns/sample\n", name, ms,
+         (ms * 1e6) / ((double)BENCH_REPEAT * (double)SAMPLES));
+}
+
+/*
+ * Throughput of the conversion variants.
+ */
+static void benchmark(void) {
+  sensor_calib_t sc;
+  sensor_calib_fixed_t sf;
+  clock_t start;
+  unsigned k;
+  size_t i;
+
+  printf("Throughput, %u samples x %u...\n",
+         (unsigned)SAMPLES, (unsigned)BENCH_REPEAT);
+
+  start = clock();
+  for (k = 0U; k < BENCH_REPEAT; k++) {
+    for (i = 0U; i < SAMPLES; i++) {
+      cook_sample(sensitivity, bias, &raw[i * 3U], &cooked[i * 3U]);
+    }
+    float_sink = cooked[k % (SAMPLES * 3U)];
+  }
+  bench_report("per-sample, driver style", start);
+
+  sensorCalibInit(&sc, 3U, sensitivity, bias);
+  start = clock();
+  for (k = 0U; k < BENCH_REPEAT; k++) {
+    sensorCalibCook(&sc, raw, cooked, SAMPLES);
+    float_sink = cooked[k % (SAMPLES * 3U)];
+  }
+  bench_report("array, per-axis float", start);
+
+  sensorCalibToFixed(&sc, &sf, FRAC_BITS);
+  start = clock();
+  for (k = 0U; k < BENCH_REPEAT; k++) {
+    sensorCalibCookFixed(&sf, raw, fixed, SAMPLES);
+    fixed_sink = fixed[k % (SAMPLES * 3U)];
+  }
+  bench_report("array, per-axis fixed", start);
+
+  sensorCalibSetMatrix(&sc, matrix, bias);
+  start = clock();
+  for (k = 0U; k < BENCH_REPEAT; k++) {
+    sensorCalibCook(&sc, raw, cooked, SAMPLES);
+    float_sink = cooked[k % (SAMPLES * 3U)];
+  }
+  bench_report("array, 3x3 float", start);
+
+  sensorCalibToFixed(&sc, &sf, FRAC_BITS);
+  start = clock();
+  for (k = 0U; k < BENCH_REPEAT; k++) {
+    sensorCalibCookFixed(&sf, raw, fixed, SAMPLES);
+    fixed_sink = fixed[k % (SAMPLES * 3U)];
+  }
+  bench_report("array, 3x3 fixed", start);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  size_t i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * Raw samples over the full 16 bits range.
+   */
+  srand(1);
+  for (i = 0U; i < SAMPLES * 3U; i++) {
+    raw[i] = (int32_t)(rand() % 65536) - 32768;
+  }
+
+  test_diagonal();
+  test_matrix();
+  test_fixed();
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+
+  benchmark();
+  return 0;
+}
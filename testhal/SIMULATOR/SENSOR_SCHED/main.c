@@ -0,0 +1,323 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "hal_sensor_sim.h"
+#include "hal_sensor_sched.h"
+
+/*
+ * Sampling period of the single read sensors in milliseconds.
+ */
+#define PERIOD              10U
+
+/*
+ * Rounds of the alignment scenarios.
+ */
+#define ROUNDS              20U
+
+/*
+ * Ring buffers sizes, the small one holds less than two rounds of batch
+ * samples.
+ */
+#define BIG_RING_SIZE       128U
+#define SMALL_RING_SIZE     16U
+
+/*
+ * Simulated sensors, one sample per millisecond, the FIFO is only used by
+ * the batch scenario.
+ */
+static const SensorSimConfig simcfg = {
+  3U,
+  1000U,
+  32U,
+  1.0f,
+  NULL
+};
+
+static SensorSim sim1, sim2, sim3;
+
+static sensor_sched_t sched;
+static sensor_sched_entry_t entry1, entry2, entry3;
+static sensor_sample_t ring[BIG_RING_SIZE];
+
+/*
+ * Buses with acquisitions accounting.
+ */
+typedef struct {
+  uint32_t                  acquired;
+  uint32_t                  released;
+  bool                      nested;
+} test_bus_t;
+
+static test_bus_t bus_a, bus_b;
+
+static void bus_acquire(void *arg) {
+  test_bus_t *bp = (test_bus_t *)arg;
+
+  if (bp->acquired != bp->released) {
+    bp->nested = true;
+  }
+  bp->acquired++;
+}
+
+static void bus_release(void *arg) {
+  test_bus_t *bp = (test_bus_t *)arg;
+
+  bp->released++;
+}
+
+static const sensor_sched_bus_t bus_a_desc = {
+  bus_acquire, bus_release, &bus_a
+};
+
+static const sensor_sched_bus_t bus_b_desc = {
+  bus_acquire, bus_release, &bus_b
+};
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Time difference within one tick of the expected value.
+ */
+static bool near(systime_t dt, systime_t expected) {
+
+  return (systime_t)(dt - expected + (systime_t)1) <= (systime_t)2;
+}
+
+/*
+ * Two sensors on a bus due together and a third one, on another bus,
+ * due one millisecond later. With a two milliseconds alignment window
+ * the three sensors are sampled in a single wakeup, without window the
+ * third sensor takes its own wakeups.
+ */
+static void test_alignment(uint32_t window) {
+  sensor_sched_sub_t sub;
+  sensor_sample_t sample;
+  systime_t first = 0, last = 0;
+  uint32_t n = 0U;
+
+  sensorsimStart(&sim1, &simcfg);
+  sensorsimStart(&sim2, &simcfg);
+  sensorsimStart(&sim3, &simcfg);
+  bus_a.acquired = 0U;
+  bus_a.released = 0U;
+  bus_b.acquired = 0U;
+  bus_b.released = 0U;
+
+  sschedObjectInit(&sched, ring, BIG_RING_SIZE, MS2ST(window));
+  sschedSubscribe(&sched, &sub);
+  chThdSleepMilliseconds(1);
+  sschedAddSensor(&sched, &entry1, (BaseSensor *)&sim1, &bus_a_desc,
+                  MS2ST(PERIOD), false);
+  sschedAddSensor(&sched, &entry2, (BaseSensor *)&sim2, &bus_a_desc,
+                  MS2ST(PERIOD), false);
+  chThdSleepMilliseconds(1);
+  sschedAddSensor(&sched, &entry3, (BaseSensor *)&sim3, &bus_b_desc,
+                  MS2ST(PERIOD), false);
+
+  while (entry1.samples < ROUNDS) {
+    sschedServe(&sched);
+  }
+
+  /* The first sensor keeps its phase, no drift and no skipped periods.*/
+  while (sschedGetSampleTimeout(&sub, &sample, TIME_IMMEDIATE) == MSG_OK) {
+    if (sample.source == &entry1) {
+      if (n == 0U) {
+        first = sample.stamp;
+      }
+      last = sample.stamp;
+      n++;
+    }
+  }
+  check(sub.lost == 0U, "unexpected lost samples");
+  check(n == ROUNDS, "samples missing");
+  check(near((systime_t)(last - first), MS2ST(PERIOD) * (ROUNDS - 1U)),
+        "sampling drift");
+  check((entry1.skipped == 0U) && (entry2.skipped == 0U) &&
+        (entry3.skipped == 0U), "unexpected skipped periods");
+  check((entry1.errors == 0U) && (entry2.errors == 0U) &&
+        (entry3.errors == 0U), "unexpected read errors");
+
+  /* One acquisition per bus and round.*/
+  check(!bus_a.nested && !bus_b.nested &&
+        (bus_a.acquired == bus_a.released) &&
+        (bus_b.acquired == bus_b.released), "unbalanced bus acquisitions");
+  check(bus_a.acquired == entry1.samples, "bus shared by due sensors");
+  check(sched.acquisitions == bus_a.acquired + bus_b.acquired,
+        "acquisitions count");
+
+  if (window > 0U) {
+    check(sched.wakeups == entry1.samples, "sensors not aligned");
+    check(entry3.samples == entry1.samples, "aligned sensor rate");
+  }
+  else {
+    /* Only the first round, both already due, is shared.*/
+    check(sched.wakeups == entry1.samples + entry3.samples - 1U,
+          "sensors aligned without window");
+  }
+
+  printf("Window %u ms: %u wakeups, %u bus acquisitions for %u samples\n",
+         (unsigned)window, (unsigned)sched.wakeups,
+         (unsigned)sched.acquisitions,
+         (unsigned)(entry1.samples + entry2.samples + entry3.samples));
+
+  sensorsimStop(&sim1);
+  sensorsimStop(&sim2);
+  sensorsimStop(&sim3);
+}
+
+/*
+ * A late scheduler skips the elapsed periods instead of catching up with
+ * a burst of reads, the sampling keeps its original phase.
+ */
+static void test_late(void) {
+  sensor_sched_sub_t sub;
+  sensor_sample_t sample;
+  systime_t stamps[3];
+  uint32_t n;
+
+  sensorsimStart(&sim1, &simcfg);
+  sschedObjectInit(&sched, ring, BIG_RING_SIZE, (systime_t)0);
+  sschedSubscribe(&sched, &sub);
+  chThdSleepMilliseconds(1);
+  sschedAddSensor(&sched, &entry1, (BaseSensor *)&sim1, NULL,
+                  MS2ST(PERIOD), false);
+
+  sschedServe(&sched);
+  chThdSleepMilliseconds((3U * PERIOD) + (PERIOD / 2U));
+  sschedServe(&sched);
+  check(entry1.samples == 2U, "catch up burst");
+  check(entry1.skipped == 2U, "skipped periods");
+  sschedServe(&sched);
+
+  n = 0U;
+  while ((n < 3U) &&
+         (sschedGetSampleTimeout(&sub, &sample, TIME_IMMEDIATE) == MSG_OK)) {
+    stamps[n++] = sample.stamp;
+  }
+  check(n == 3U, "samples missing");
+  check(near((systime_t)(stamps[2] - stamps[0]), MS2ST(4U * PERIOD)),
+        "phase lost after skipping");
+
+  printf("Late scheduler: %u periods skipped, %u samples\n",
+         (unsigned)entry1.skipped, (unsigned)entry1.samples);
+
+  sensorsimStop(&sim1);
+}
+
+/*
+ * A FIFO sensor drained every 10 ms into a 16 samples ring buffer, the
+ * publication counter wraps during the test. A fast subscriber reads all
+ * the samples after each round, a slow one only at the end.
+ */
+static void test_ring(void) {
+  sensor_sched_sub_t fast, slow;
+  sensor_sample_t sample;
+  uint32_t published, next, n, i;
+  bool ok = true;
+
+  sensorsimStart(&sim1, &simcfg);
+  check(sensorSetFifo(&sim1, 16U) == MSG_OK, "FIFO enable failed");
+  sschedObjectInit(&sched, ring, SMALL_RING_SIZE, (systime_t)0);
+
+  /* Publication counter close to its wrap.*/
+  sched.wr = 0xFFFFFFC0U;
+  sschedSubscribe(&sched, &fast);
+  sschedSubscribe(&sched, &slow);
+  sschedAddSensor(&sched, &entry1, (BaseSensor *)&sim1, NULL,
+                  MS2ST(PERIOD), true);
+
+  next = 0U;
+  n    = 0U;
+  for (i = 0U; i < ROUNDS; i++) {
+    sschedServe(&sched);
+    while (sschedGetSampleTimeout(&fast, &sample, TIME_IMMEDIATE) ==
+           MSG_OK) {
+      if ((n > 0U) && (sample.data[0] != (int32_t)next)) {
+        ok = false;
+      }
+      next = (uint32_t)sample.data[0] + 1U;
+      n++;
+    }
+  }
+  published = sched.wr - 0xFFFFFFC0U;
+  check(sched.wr < SMALL_RING_SIZE * ROUNDS, "counter not wrapped");
+  check(published == entry1.samples, "published samples count");
+  check(sim1.overruns == 0U, "FIFO overruns");
+  check(ok && (fast.lost == 0U) && (n == published),
+        "fast subscriber samples");
+
+  /* The slow subscriber gets the newest samples, in order.*/
+  n = 0U;
+  while (sschedGetSampleTimeout(&slow, &sample, TIME_IMMEDIATE) == MSG_OK) {
+    if (sample.data[0] != (int32_t)(next - SMALL_RING_SIZE + n)) {
+      ok = false;
+    }
+    n++;
+  }
+  check(ok && (n == SMALL_RING_SIZE), "slow subscriber samples");
+  check(slow.lost == published - SMALL_RING_SIZE, "lost samples count");
+  check(sschedGetSampleTimeout(&slow, &sample, TIME_IMMEDIATE) ==
+        MSG_TIMEOUT, "read beyond the published samples");
+
+  printf("Ring buffer of %u samples: %u published, %u lost by the slow "
+         "subscriber\n",
+         (unsigned)SMALL_RING_SIZE, (unsigned)published, (unsigned)slow.lost);
+
+  sensorsimStop(&sim1);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  sensorsimObjectInit(&sim1);
+  sensorsimObjectInit(&sim2);
+  sensorsimObjectInit(&sim3);
+
+  test_alignment(2U);
+  test_alignment(0U);
+  test_late();
+  test_ring();
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
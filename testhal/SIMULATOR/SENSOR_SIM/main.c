@@ -0,0 +1,254 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "hal_sensor_sim.h"
+
+/*
+ * Simulated sensor geometry, one sample per millisecond.
+ */
+#define CHANNELS            3U
+#define PERIOD              1000U
+#define FIFO_DEPTH          32U
+#define WATERMARK           16U
+
+/*
+ * Duration and interval of the periodic batch reads in milliseconds.
+ */
+#define POLL_TIME           400U
+#define POLL_INTERVAL       20U
+
+static SensorSim sensor;
+
+static const SensorSimConfig fifocfg = {
+  CHANNELS,
+  PERIOD,
+  FIFO_DEPTH,
+  0.5f,
+  NULL
+};
+
+static const SensorSimConfig nofifocfg = {
+  CHANNELS,
+  PERIOD,
+  0U,
+  0.5f,
+  NULL
+};
+
+static int32_t axes[FIFO_DEPTH * CHANNELS];
+static systime_t stamps[FIFO_DEPTH];
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*
+ * Reads a batch and checks that the samples are consecutive starting from
+ * the expected sample number, the lost ones excepted, that the time stamps
+ * are one period apart and that the read took the FIFO status read plus,
+ * if not empty, one burst. Returns the number of samples read.
+ */
+static size_t read_batch(size_t n, uint32_t *nextp) {
+  uint32_t transactions = sensor.transactions;
+  uint32_t overruns = sensor.overruns;
+  size_t i, ch, cnt;
+  bool ok = true;
+
+  check(sensorReadRawBatch(&sensor, axes, stamps,
+                           n, &cnt) == MSG_OK, "batch read failed");
+  check(cnt <= n, "too many samples");
+  check(sensor.transactions == transactions + (cnt > 0U ? 2U : 1U),
+        "unexpected bus transactions");
+
+  *nextp += sensor.overruns - overruns;
+  for (i = 0U; i < cnt; i++) {
+    for (ch = 0U; ch < CHANNELS; ch++) {
+      if (axes[(i * CHANNELS) + ch] != (int32_t)(*nextp + i + ch)) {
+        ok = false;
+      }
+    }
+    if ((i > 0U) &&
+        ((systime_t)(stamps[i] - stamps[i - 1U]) != US2ST(PERIOD))) {
+      ok = false;
+    }
+  }
+  check(ok, "samples or time stamps not consecutive");
+  *nextp += (uint32_t)cnt;
+
+  return cnt;
+}
+
+/*
+ * Single sample reads, sensor without FIFO and invalid watermarks.
+ */
+static void test_config(void) {
+  int32_t raw[CHANNELS];
+  float cooked[CHANNELS];
+  size_t ch;
+  bool ok = true;
+
+  sensorsimStart(&sensor, &nofifocfg);
+  check(sensorGetChannelNumber(&sensor) == CHANNELS,
+        "wrong channels number");
+  chThdSleepMilliseconds(5);
+
+  /* The time does not advance in a critical zone, the same sample is
+     read twice.*/
+  chSysLock();
+  check(sensorReadRaw(&sensor, raw) == MSG_OK,
+        "raw read failed");
+  check(sensorReadCooked(&sensor, cooked) == MSG_OK,
+        "cooked read failed");
+  chSysUnlock();
+  for (ch = 0U; ch < CHANNELS; ch++) {
+    if ((raw[ch] != raw[0] + (int32_t)ch) ||
+        (cooked[ch] != (float)raw[ch] * fifocfg.sensitivity)) {
+      ok = false;
+    }
+  }
+  check(ok, "wrong single sample");
+
+  check(sensorSetFifo(&sensor, 1U) == MSG_RESET,
+        "FIFO enabled on a sensor without FIFO");
+  sensorsimStop(&sensor);
+
+  sensorsimStart(&sensor, &fifocfg);
+  check(sensorSetFifo(&sensor, FIFO_DEPTH) == MSG_RESET,
+        "watermark beyond the FIFO depth accepted");
+  sensorsimStop(&sensor);
+}
+
+/*
+ * Batch reads, partial reads, empty reads, overruns and FIFO flush.
+ */
+static void test_batch(void) {
+  uint32_t next, overruns;
+  size_t cnt;
+
+  sensorsimStart(&sensor, &fifocfg);
+  chThdSleepMilliseconds(5);
+  check(sensorSetFifo(&sensor, WATERMARK) == MSG_OK,
+        "FIFO enable failed");
+
+  /* The FIFO starts empty when enabled.*/
+  next = sensor.consumed;
+  chThdSleepMilliseconds(10);
+  cnt = read_batch(FIFO_DEPTH, &next);
+  check((cnt >= 8U) && (cnt <= 12U), "unexpected FIFO level");
+  check((systime_t)(chVTGetSystemTimeX() - stamps[cnt - 1U]) <=
+        US2ST(PERIOD), "newest time stamp not current");
+
+  /* A read continues from the last sample read.*/
+  chThdSleepMilliseconds(10);
+  check(read_batch(4U, &next) == 4U, "partial read");
+  check(read_batch(FIFO_DEPTH, &next) >= 4U, "partial read remainder");
+
+  /* Nothing new, only the FIFO status is read.*/
+  chSysLock();
+  cnt = read_batch(FIFO_DEPTH, &next);
+  chSysUnlock();
+  check(cnt == 0U, "empty FIFO returned samples");
+  check(sensor.overruns == 0U, "unexpected overruns");
+
+  /* The samples not read in time are lost, the newest are kept.*/
+  chThdSleepMilliseconds(60);
+  overruns = sensor.overruns;
+  check(read_batch(FIFO_DEPTH, &next) == FIFO_DEPTH, "FIFO not full");
+  check(sensor.overruns - overruns >= 20U, "overruns not counted");
+
+  /* Disabling and enabling again flushes the FIFO.*/
+  chThdSleepMilliseconds(5);
+  check(sensorSetFifo(&sensor, SENSOR_FIFO_DISABLED) == MSG_OK,
+        "FIFO disable failed");
+  chThdSleepMilliseconds(5);
+  chSysLock();
+  check(sensorSetFifo(&sensor, WATERMARK) == MSG_OK,
+        "FIFO enable failed");
+  next = sensor.consumed;
+  cnt = read_batch(FIFO_DEPTH, &next);
+  chSysUnlock();
+  check(cnt == 0U, "FIFO not flushed");
+
+  sensorsimStop(&sensor);
+}
+
+/*
+ * Bus transactions of periodic batch reads compared to one read per
+ * sample.
+ */
+static void test_transactions(void) {
+  uint32_t next, transactions, samples, i;
+
+  sensorsimStart(&sensor, &fifocfg);
+  check(sensorSetFifo(&sensor, WATERMARK) == MSG_OK,
+        "FIFO enable failed");
+  next         = sensor.consumed;
+  transactions = sensor.transactions;
+  samples      = 0U;
+  for (i = 0U; i < POLL_TIME / POLL_INTERVAL; i++) {
+    chThdSleepMilliseconds(POLL_INTERVAL);
+    samples += (uint32_t)read_batch(FIFO_DEPTH, &next);
+  }
+  transactions = sensor.transactions - transactions;
+  check(sensor.overruns == 0U, "unexpected overruns");
+  check(samples >= (POLL_TIME * 9U) / 10U, "samples missing");
+
+  printf("Batch reads every %u ms: %u samples, %u bus transactions, "
+         "%.1f samples per transaction\n",
+         (unsigned)POLL_INTERVAL, (unsigned)samples, (unsigned)transactions,
+         (double)samples / (double)transactions);
+  printf("Single sample reads: %u bus transactions\n", (unsigned)samples);
+
+  sensorsimStop(&sensor);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  sensorsimObjectInit(&sensor);
+
+  test_config();
+  test_batch();
+  test_transactions();
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
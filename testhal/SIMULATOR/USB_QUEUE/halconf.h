@@ -0,0 +1,33 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    halconf.h
+ * @brief   HAL configuration header.
+ * @details Settings changed by this test, the other settings are the ones
+ *          of the Posix simulator demo.
+ */
+
+#ifndef TEST_HALCONF_H
+#define TEST_HALCONF_H
+
+#define HAL_USE_SERIAL              FALSE
+#define HAL_USE_USB                 TRUE
+#define USB_USE_QUEUES              TRUE
+
+#include "../../../demos/various/RT-Posix-Simulator/halconf.h"
+
+#endif /* TEST_HALCONF_H */
@@ -0,0 +1,322 @@
+/*
+    ChibiOS - Copyright (C) 2006..2016 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+/*
+ * Endpoint and transfers geometry.
+ */
+#define EP_SIZE             64U
+#define XFER_SIZE           256U
+#define IN_XFERS            8U
+#define OUT_XFERS           4U
+
+/*
+ * Packets moved on each endpoint in each simulated frame.
+ */
+#define FRAME_PACKETS       8U
+
+static unsigned failures;
+
+#define check(cond, msg) {                                                  \
+  if (!(cond)) {                                                            \
+    printf("FAILED: %s (line %d)\n", msg, __LINE__);                        \
+    failures++;                                                             \
+  }                                                                         \
+}
+
+/*===========================================================================*/
+/* Simulated host.                                                           */
+/*===========================================================================*/
+
+/*
+ * Data received by the host on the IN endpoint.
+ */
+static uint8_t host_in[IN_XFERS * XFER_SIZE];
+static size_t host_in_cnt;
+
+/*
+ * Packets sent by the host on the OUT endpoint, a short packet or a full
+ * buffer terminates a transfer.
+ */
+static const size_t host_out_packets[] = {
+  64, 64, 10,                       /* 138 bytes, short packet.         */
+  64, 64, 64, 64,                   /* 256 bytes, full buffer.          */
+  30,                               /* 30 bytes, short packet.          */
+  64, 64, 5                         /* 133 bytes, short packet.         */
+};
+static const size_t host_out_sizes[OUT_XFERS] = {138, 256, 30, 133};
+static unsigned host_out_idx;
+static uint8_t host_out_seq;
+
+static void host_in_packet(USBDriver *usbp, usbep_t ep,
+                           const uint8_t *buf, size_t n) {
+
+  (void)usbp;
+  if ((ep == 1U) && (host_in_cnt + n <= sizeof host_in)) {
+    memcpy(host_in + host_in_cnt, buf, n);
+    host_in_cnt += n;
+  }
+}
+
+static bool host_out_packet(USBDriver *usbp, usbep_t ep,
+                            uint8_t *buf, size_t *np) {
+  size_t i;
+
+  (void)usbp;
+  if ((ep != 1U) ||
+      (host_out_idx >= sizeof host_out_packets / sizeof host_out_packets[0])) {
+    return false;
+  }
+  *np = host_out_packets[host_out_idx++];
+  for (i = 0U; i < *np; i++) {
+    buf[i] = host_out_seq++;
+  }
+  return true;
+}
+
+/*===========================================================================*/
+/* Device side.                                                              */
+/*===========================================================================*/
+
+static USBInEndpointState ep1instate;
+static USBOutEndpointState ep1outstate;
+
+static const USBEndpointConfig ep1config = {
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
+  NULL,
+  NULL,
+  EP_SIZE,
+  EP_SIZE,
+  &ep1instate,
+  &ep1outstate
+};
+
+static const USBDescriptor *get_descriptor(USBDriver *usbp,
+                                           uint8_t dtype,
+                                           uint8_t dindex,
+                                           uint16_t lang) {
+
+  (void)usbp;
+  (void)dtype;
+  (void)dindex;
+  (void)lang;
+  return NULL;
+}
+
+static void usb_event(USBDriver *usbp, usbevent_t event) {
+
+  if (event == USB_EVENT_CONFIGURED) {
+    osalSysLockFromISR();
+    usbInitEndpointI(usbp, 1U, &ep1config);
+    osalSysUnlockFromISR();
+  }
+}
+
+static const USBConfig usbcfg = {
+  usb_event,
+  get_descriptor,
+  NULL,
+  NULL,
+  FRAME_PACKETS,
+  host_in_packet,
+  host_out_packet
+};
+
+static const uint8_t set_configuration[8] = {
+  USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_RECIPIENT_DEVICE,
+  USB_REQ_SET_CONFIGURATION,
+  1, 0,                             /* wValue, configuration 1.         */
+  0, 0,                             /* wIndex.                          */
+  0, 0                              /* wLength.                         */
+};
+
+/*
+ * Transfers and their buffers.
+ */
+static uint8_t buffers[IN_XFERS][XFER_SIZE];
+static usbxfer_t xfers[IN_XFERS];
+
+/*
+ * Completion order and the thread waiting for the last completion.
+ */
+static usbxfer_t *completed[IN_XFERS];
+static unsigned completed_cnt, expected_cnt;
+static thread_reference_t waiting;
+
+static void xfer_done(USBDriver *usbp, usbep_t ep, usbxfer_t *xp) {
+
+  (void)usbp;
+  (void)ep;
+  if (completed_cnt < IN_XFERS) {
+    completed[completed_cnt] = xp;
+  }
+  if (++completed_cnt == expected_cnt) {
+    osalSysLockFromISR();
+    osalThreadResumeI(&waiting, MSG_OK);
+    osalSysUnlockFromISR();
+  }
+}
+
+/*
+ * Queues @p n transfers on the endpoint one and waits for all of them.
+ */
+static msg_t run_queue(unsigned n, bool in, uint16_t *framesp) {
+  uint16_t start;
+  unsigned i;
+  msg_t msg;
+
+  completed_cnt = 0U;
+  expected_cnt  = n;
+
+  osalSysLock();
+  start = usbGetFrameNumberX(&USBD1);
+  for (i = 0U; i < n; i++) {
+    if (in) {
+      usbQueueTransmitI(&USBD1, 1U, &xfers[i]);
+    }
+    else {
+      usbQueueReceiveI(&USBD1, 1U, &xfers[i]);
+    }
+  }
+  msg = osalThreadSuspendTimeoutS(&waiting, OSAL_MS2ST(1000));
+  *framesp = (uint16_t)((usbGetFrameNumberX(&USBD1) - start) & 0x7FFU);
+  osalSysUnlock();
+
+  return msg;
+}
+
+/*
+ * IN transfers of different sizes, the host must see them in queue order
+ * and they must complete in the same order.
+ */
+static void test_in_queue(void) {
+  size_t total = 0U;
+  uint16_t frames;
+  unsigned i;
+  size_t j;
+
+  printf("IN queue, %u transfers...\n", (unsigned)IN_XFERS);
+
+  for (i = 0U; i < IN_XFERS; i++) {
+    xfers[i].buf   = buffers[i];
+    xfers[i].n     = 100U + (size_t)i * 20U;
+    xfers[i].cb    = xfer_done;
+    for (j = 0U; j < xfers[i].n; j++) {
+      buffers[i][j] = (uint8_t)((i << 5) + j);
+    }
+  }
+
+  check(run_queue(IN_XFERS, true, &frames) == MSG_OK, "IN timeout");
+  printf("  %u transfers completed in %u frames\n",
+         completed_cnt, (unsigned)frames);
+
+  for (i = 0U; i < IN_XFERS; i++) {
+    check(completed[i] == &xfers[i], "IN completion order");
+    check(xfers[i].size == xfers[i].n, "IN transfer size");
+    check(memcmp(host_in + total, buffers[i], xfers[i].n) == 0,
+          "IN data order");
+    total += xfers[i].n;
+  }
+  check(host_in_cnt == total, "IN total size");
+}
+
+/*
+ * OUT transfers terminated by short packets or by a full buffer, they
+ * must complete in queue order with the size sent by the host.
+ */
+static void test_out_queue(void) {
+  size_t total = 0U;
+  uint16_t frames;
+  unsigned i;
+  size_t j;
+
+  printf("OUT queue, %u transfers...\n", (unsigned)OUT_XFERS);
+
+  for (i = 0U; i < OUT_XFERS; i++) {
+    xfers[i].buf = buffers[i];
+    xfers[i].n   = XFER_SIZE;
+    xfers[i].cb  = xfer_done;
+    memset(buffers[i], 0, XFER_SIZE);
+  }
+
+  check(run_queue(OUT_XFERS, false, &frames) == MSG_OK, "OUT timeout");
+  printf("  %u transfers completed in %u frames\n",
+         completed_cnt, (unsigned)frames);
+
+  for (i = 0U; i < OUT_XFERS; i++) {
+    check(completed[i] == &xfers[i], "OUT completion order");
+    check(xfers[i].size == host_out_sizes[i], "OUT transfer size");
+    for (j = 0U; j < xfers[i].size; j++) {
+      if (buffers[i][j] != (uint8_t)(total + j)) {
+        break;
+      }
+    }
+    check(j == xfers[i].size, "OUT data order");
+    total += xfers[i].size;
+  }
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  unsigned i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * USB driver activation, the simulated host resets the bus and selects
+   * the configuration.
+   */
+  usbStart(&USBD1, &usbcfg);
+  usbConnectBus(&USBD1);
+  usb_lld_sim_reset(&USBD1);
+  chThdSleepMilliseconds(2);
+  usb_lld_sim_setup(&USBD1, set_configuration);
+  for (i = 0U; (USBD1.state != USB_ACTIVE) && (i < 100U); i++) {
+    chThdSleepMilliseconds(1);
+  }
+  if (USBD1.state != USB_ACTIVE) {
+    printf("FAILED: device not configured\n");
+    return 1;
+  }
+
+  test_in_queue();
+  test_out_queue();
+
+  usbStop(&USBD1);
+
+  if (failures > 0U) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}